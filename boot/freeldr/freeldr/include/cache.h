@@ -22,6 +22,7 @@
 
 #define TAG_CACHE_DATA 'DcaC'
 #define TAG_CACHE_BLOCK 'BcaC'
+#define TAG_CACHE_PREFETCH 'PcaC'
 
 ///////////////////////////////////////////////////////////////////////////////////////
 //
@@ -92,3 +93,17 @@ VOID    CacheInvalidateCacheData(VOID);
 BOOLEAN    CacheReadDiskSectors(UCHAR DiskNumber, ULONGLONG StartSector, ULONG SectorCount, PVOID Buffer);
 BOOLEAN    CacheForceDiskSectorsIntoCache(UCHAR DiskNumber, ULONGLONG StartSector, ULONG SectorCount);
 BOOLEAN    CacheReleaseMemory(ULONG MinimumAmountToRelease);
+
+///////////////////////////////////////////////////////////////////////////////////////
+//
+// Boot file prefetch. The device ranges of all the files the loader is about
+// to read are collected first, then read in a few large requests in disk order
+// and kept in memory until the files have been loaded.
+//
+///////////////////////////////////////////////////////////////////////////////////////
+extern    ULONG                CachePrefetchDeviceId;
+
+VOID    CachePrefetchAddRange(ULONGLONG Offset, ULONG Length);
+BOOLEAN    CachePrefetchStart(ULONG DeviceId);
+BOOLEAN    CachePrefetchRead(ULONG DeviceId, ULONGLONG Offset, PVOID Buffer, ULONG Length);
+VOID    CachePrefetchRelease(VOID);
@@ -21,6 +21,20 @@
 
 #define SECTOR_SIZE 512
 
+/* A piece of a file, as a byte range on the device holding the file system */
+typedef struct _FS_EXTENT
+{
+    ULONGLONG Offset;
+    ULONG Length;
+} FS_EXTENT, *PFS_EXTENT;
+
+typedef ARC_STATUS
+(*FS_GET_EXTENTS)(
+    _In_ ULONG FileId,
+    _Out_writes_to_(MaxExtents, *ExtentCount) PFS_EXTENT Extents,
+    _In_ ULONG MaxExtents,
+    _Out_ PULONG ExtentCount);
+
 typedef struct tagDEVVTBL
 {
     ARC_CLOSE Close;
@@ -29,6 +43,7 @@ typedef struct tagDEVVTBL
     ARC_READ Read;
     ARC_SEEK Seek;
     PCWSTR ServiceName;
+    FS_GET_EXTENTS GetExtents; ///< Optional, used to prefetch the file data.
 } DEVVTBL;
 
 #define MAX_FDS 60
@@ -44,6 +59,13 @@ ARC_STATUS ArcRead(ULONG FileId, VOID* Buffer, ULONG N, ULONG* Count);
 ARC_STATUS ArcSeek(ULONG FileId, LARGE_INTEGER* Position, SEEKMODE SeekMode);
 ARC_STATUS ArcGetFileInformation(ULONG FileId, FILEINFORMATION* Information);
 
+ARC_STATUS
+FsGetFileExtents(
+    _In_ ULONG FileId,
+    _Out_writes_to_(MaxExtents, *ExtentCount) PFS_EXTENT Extents,
+    _In_ ULONG MaxExtents,
+    _Out_ PULONG ExtentCount);
+
 VOID  FileSystemError(PCSTR ErrorString);
 
 ARC_STATUS
@@ -0,0 +1,237 @@
+/*
+ * PROJECT:     FreeLoader
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Coalesced reads of the files the loader is about to load
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+/* INCLUDES ******************************************************************/
+
+#include <freeldr.h>
+
+#include <debug.h>
+DBG_DEFAULT_CHANNEL(CACHE);
+
+/* GLOBALS *******************************************************************/
+
+#define PREFETCH_MAX_RANGES 4096
+#define PREFETCH_MAX_GAP    (64 * 1024)         // Holes smaller than this are read through
+#define PREFETCH_MAX_RUN    (4 * 1024 * 1024)   // Largest single buffer
+
+typedef struct _PREFETCH_RANGE
+{
+    ULONGLONG Offset;
+    ULONG Length;
+    PVOID Data;
+} PREFETCH_RANGE, *PPREFETCH_RANGE;
+
+ULONG CachePrefetchDeviceId = INVALID_FILE_ID;
+
+static PPREFETCH_RANGE PrefetchRanges = NULL;
+static ULONG PrefetchRangeCount = 0;
+static SIZE_T PrefetchSize = 0;
+static ULONG PrefetchHits = 0;
+static ULONG PrefetchMisses = 0;
+
+/* FUNCTIONS *****************************************************************/
+
+VOID CachePrefetchAddRange(ULONGLONG Offset, ULONG Length)
+{
+    ULONGLONG End;
+
+    if (CachePrefetchDeviceId != INVALID_FILE_ID || Length == 0)
+        return;
+
+    if (PrefetchRanges == NULL)
+    {
+        PrefetchRanges = FrLdrTempAlloc(PREFETCH_MAX_RANGES * sizeof(PREFETCH_RANGE),
+                                        TAG_CACHE_PREFETCH);
+        if (PrefetchRanges == NULL)
+            return;
+        PrefetchRangeCount = 0;
+    }
+
+    // The prefetch is only a hint, drop what doesn't fit
+    if (PrefetchRangeCount >= PREFETCH_MAX_RANGES)
+        return;
+
+    // Whole sectors, so the device can seek to any part of it
+    End = (Offset + Length + SECTOR_SIZE - 1) & ~(ULONGLONG)(SECTOR_SIZE - 1);
+    Offset &= ~(ULONGLONG)(SECTOR_SIZE - 1);
+
+    PrefetchRanges[PrefetchRangeCount].Offset = Offset;
+    PrefetchRanges[PrefetchRangeCount].Length = (ULONG)(End - Offset);
+    PrefetchRanges[PrefetchRangeCount].Data = NULL;
+    PrefetchRangeCount++;
+}
+
+static VOID CachePrefetchSortRanges(VOID)
+{
+    PREFETCH_RANGE Range;
+    ULONG i, j;
+
+    // Insertion sort: the files mostly come in disk order already
+    for (i = 1; i < PrefetchRangeCount; i++)
+    {
+        Range = PrefetchRanges[i];
+        for (j = i; j > 0 && PrefetchRanges[j - 1].Offset > Range.Offset; j--)
+        {
+            PrefetchRanges[j] = PrefetchRanges[j - 1];
+        }
+        PrefetchRanges[j] = Range;
+    }
+}
+
+static VOID CachePrefetchMergeRanges(VOID)
+{
+    ULONGLONG End, RangeEnd;
+    ULONG i, Count;
+
+    if (PrefetchRangeCount == 0)
+        return;
+
+    Count = 0;
+    for (i = 1; i < PrefetchRangeCount; i++)
+    {
+        End = PrefetchRanges[Count].Offset + PrefetchRanges[Count].Length;
+        RangeEnd = PrefetchRanges[i].Offset + PrefetchRanges[i].Length;
+
+        if (PrefetchRanges[i].Offset <= End + PREFETCH_MAX_GAP &&
+            max(End, RangeEnd) - PrefetchRanges[Count].Offset <= PREFETCH_MAX_RUN)
+        {
+            if (RangeEnd > End)
+                PrefetchRanges[Count].Length = (ULONG)(RangeEnd - PrefetchRanges[Count].Offset);
+        }
+        else
+        {
+            PrefetchRanges[++Count] = PrefetchRanges[i];
+        }
+    }
+
+    PrefetchRangeCount = Count + 1;
+}
+
+BOOLEAN CachePrefetchStart(ULONG DeviceId)
+{
+    PPREFETCH_RANGE Range;
+    LARGE_INTEGER Position;
+    SIZE_T SizeLimit;
+    ULONG RangesAdded, i, Count;
+    ARC_STATUS Status;
+
+    if (PrefetchRanges == NULL || PrefetchRangeCount == 0)
+    {
+        CachePrefetchRelease();
+        return FALSE;
+    }
+
+    RangesAdded = PrefetchRangeCount;
+    CachePrefetchSortRanges();
+    CachePrefetchMergeRanges();
+
+    // Leave enough of the temporary heap to the file systems
+    SizeLimit = TotalPagesInLookupTable / 4 * MM_PAGE_SIZE;
+    SizeLimit = min(SizeLimit, TEMP_HEAP_SIZE / 2);
+
+    PrefetchSize = 0;
+    PrefetchHits = 0;
+    PrefetchMisses = 0;
+
+    for (i = 0; i < PrefetchRangeCount; i++)
+    {
+        Range = &PrefetchRanges[i];
+
+        if (PrefetchSize + Range->Length > SizeLimit)
+            break;
+
+        Range->Data = FrLdrTempAlloc(Range->Length, TAG_CACHE_PREFETCH);
+        if (Range->Data == NULL)
+            break;
+
+        Position.QuadPart = Range->Offset;
+        Status = ArcSeek(DeviceId, &Position, SeekAbsolute);
+        if (Status == ESUCCESS)
+            Status = ArcRead(DeviceId, Range->Data, Range->Length, &Count);
+        if (Status != ESUCCESS || Count != Range->Length)
+        {
+            WARN("Prefetch of 0x%I64x, %lu bytes failed\n", Range->Offset, Range->Length);
+            FrLdrTempFree(Range->Data, TAG_CACHE_PREFETCH);
+            Range->Data = NULL;
+            continue;
+        }
+
+        PrefetchSize += Range->Length;
+    }
+
+    TRACE("Prefetched %lu ranges in %lu reads, %lu bytes\n",
+          RangesAdded, i, (ULONG)PrefetchSize);
+
+    if (PrefetchSize == 0)
+    {
+        CachePrefetchRelease();
+        return FALSE;
+    }
+
+    CachePrefetchDeviceId = DeviceId;
+    return TRUE;
+}
+
+BOOLEAN CachePrefetchRead(ULONG DeviceId, ULONGLONG Offset, PVOID Buffer, ULONG Length)
+{
+    PPREFETCH_RANGE Range;
+    ULONG Low, High, Middle;
+
+    if (DeviceId != CachePrefetchDeviceId)
+        return FALSE;
+
+    // Find the last range starting at or before the offset
+    Low = 0;
+    High = PrefetchRangeCount;
+    while (High - Low > 1)
+    {
+        Middle = (Low + High) / 2;
+        if (PrefetchRanges[Middle].Offset <= Offset)
+            Low = Middle;
+        else
+            High = Middle;
+    }
+
+    Range = &PrefetchRanges[Low];
+    if (Range->Data == NULL ||
+        Offset < Range->Offset ||
+        Offset + Length > Range->Offset + Range->Length)
+    {
+        PrefetchMisses++;
+        return FALSE;
+    }
+
+    RtlCopyMemory(Buffer, (PUCHAR)Range->Data + (ULONG_PTR)(Offset - Range->Offset), Length);
+    PrefetchHits++;
+    return TRUE;
+}
+
+VOID CachePrefetchRelease(VOID)
+{
+    ULONG i;
+
+    if (PrefetchRanges == NULL)
+        return;
+
+    if (CachePrefetchDeviceId != INVALID_FILE_ID)
+    {
+        TRACE("Prefetch: %lu reads served from memory, %lu went to the disk\n",
+              PrefetchHits, PrefetchMisses);
+    }
+
+    for (i = 0; i < PrefetchRangeCount; i++)
+    {
+        if (PrefetchRanges[i].Data != NULL)
+            FrLdrTempFree(PrefetchRanges[i].Data, TAG_CACHE_PREFETCH);
+    }
+
+    FrLdrTempFree(PrefetchRanges, TAG_CACHE_PREFETCH);
+    PrefetchRanges = NULL;
+    PrefetchRangeCount = 0;
+    PrefetchSize = 0;
+    CachePrefetchDeviceId = INVALID_FILE_ID;
+}
@@ -1285,6 +1285,46 @@ ARC_STATUS Ext2Seek(ULONG FileId, LARGE_INTEGER* Position, SEEKMODE SeekMode)
     return ESUCCESS;
 }
 
+ARC_STATUS Ext2GetExtents(ULONG FileId, PFS_EXTENT Extents, ULONG MaxExtents, PULONG ExtentCount)
+{
+    PEXT2_FILE_INFO FileHandle = FsGetDeviceSpecific(FileId);
+    PEXT2_VOLUME_INFO Volume = FileHandle->Volume;
+    ULONGLONG BlockCount, Index, Offset;
+    ULONG BlockNumber;
+
+    *ExtentCount = 0;
+
+    // Only regular files keep their block list
+    if (FileHandle->FileBlockList == NULL)
+        return EINVAL;
+
+    BlockCount = (FileHandle->FileSize + Volume->BlockSizeInBytes - 1) / Volume->BlockSizeInBytes;
+    for (Index = 0; Index < BlockCount; Index++)
+    {
+        // Skip the holes of sparse files
+        BlockNumber = FileHandle->FileBlockList[Index];
+        if (BlockNumber == 0)
+            continue;
+
+        Offset = (ULONGLONG)BlockNumber * Volume->BlockSizeInBytes;
+        if (*ExtentCount > 0 &&
+            Extents[*ExtentCount - 1].Offset + Extents[*ExtentCount - 1].Length == Offset)
+        {
+            Extents[*ExtentCount - 1].Length += Volume->BlockSizeInBytes;
+        }
+        else
+        {
+            if (*ExtentCount >= MaxExtents)
+                return E2BIG;
+            Extents[*ExtentCount].Offset = Offset;
+            Extents[*ExtentCount].Length = Volume->BlockSizeInBytes;
+            (*ExtentCount)++;
+        }
+    }
+
+    return ESUCCESS;
+}
+
 const DEVVTBL Ext2FuncTable =
 {
     Ext2Close,
@@ -1293,6 +1333,7 @@ const DEVVTBL Ext2FuncTable =
     Ext2Read,
     Ext2Seek,
     L"ext2fs",
+    Ext2GetExtents,
 };
 
 const DEVVTBL* Ext2Mount(ULONG DeviceId)
@@ -1540,6 +1540,50 @@ ARC_STATUS FatSeek(ULONG FileId, LARGE_INTEGER* Position, SEEKMODE SeekMode)
     return ESUCCESS;
 }
 
+ARC_STATUS FatGetExtents(ULONG FileId, PFS_EXTENT Extents, ULONG MaxExtents, PULONG ExtentCount)
+{
+    PFAT_FILE_INFO FileHandle = FsGetDeviceSpecific(FileId);
+    PFAT_VOLUME_INFO Volume = FileHandle->Volume;
+    ULONG BytesPerCluster = Volume->SectorsPerCluster * Volume->BytesPerSector;
+    ULONGLONG Offset;
+    ULONGLONG Covered = 0;
+    UINT32 ClusterNumber = FileHandle->StartCluster;
+
+    *ExtentCount = 0;
+
+    /* The FAT12/16 root directory is not in the data area */
+    if (ClusterNumber < 2)
+        return EINVAL;
+
+    /* Directories have no size, take their whole chain */
+    while (!FAT_IS_END_CLUSTER(ClusterNumber) &&
+           ((FileHandle->Attributes & ATTR_DIRECTORY) || Covered < FileHandle->FileSize))
+    {
+        Offset = (((ULONGLONG)ClusterNumber - 2) * Volume->SectorsPerCluster + Volume->DataSectorStart) *
+                 Volume->BytesPerSector;
+
+        if (*ExtentCount > 0 &&
+            Extents[*ExtentCount - 1].Offset + Extents[*ExtentCount - 1].Length == Offset)
+        {
+            Extents[*ExtentCount - 1].Length += BytesPerCluster;
+        }
+        else
+        {
+            if (*ExtentCount >= MaxExtents)
+                return E2BIG;
+            Extents[*ExtentCount].Offset = Offset;
+            Extents[*ExtentCount].Length = BytesPerCluster;
+            (*ExtentCount)++;
+        }
+
+        Covered += BytesPerCluster;
+        if (!FatGetFatEntry(Volume, ClusterNumber, &ClusterNumber))
+            return EIO;
+    }
+
+    return ESUCCESS;
+}
+
 const DEVVTBL FatFuncTable =
 {
     FatClose,
@@ -1548,6 +1592,7 @@ const DEVVTBL FatFuncTable =
     FatRead,
     FatSeek,
     L"fastfat",
+    FatGetExtents,
 };
 
 const DEVVTBL FatXFuncTable =
@@ -1558,6 +1603,7 @@ const DEVVTBL FatXFuncTable =
     FatRead,
     FatSeek,
     L"vfatfs",
+    FatGetExtents,
 };
 
 const DEVVTBL* FatMount(ULONG DeviceId)
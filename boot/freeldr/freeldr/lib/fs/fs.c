@@ -445,10 +445,35 @@ ArcClose(
     return ESUCCESS;
 }
 
+static BOOLEAN
+FsReadPrefetched(ULONG FileId, VOID* Buffer, ULONG N)
+{
+    FILEINFORMATION Information;
+    LARGE_INTEGER Position;
+
+    if (FileData[FileId].FuncTable->GetFileInformation(FileId, &Information) != ESUCCESS)
+        return FALSE;
+
+    if (!CachePrefetchRead(FileId, Information.CurrentAddress.QuadPart, Buffer, N))
+        return FALSE;
+
+    /* Move past the data, as the device read would have done */
+    Position.QuadPart = Information.CurrentAddress.QuadPart + N;
+    return (FileData[FileId].FuncTable->Seek(FileId, &Position, SeekAbsolute) == ESUCCESS);
+}
+
 ARC_STATUS ArcRead(ULONG FileId, VOID* Buffer, ULONG N, ULONG* Count)
 {
     if (!IS_VALID_FILEID(FileId))
         return EBADF;
+
+    /* Serve the device reads of the prefetched files from memory */
+    if (FileId == CachePrefetchDeviceId && FsReadPrefetched(FileId, Buffer, N))
+    {
+        *Count = N;
+        return ESUCCESS;
+    }
+
     return FileData[FileId].FuncTable->Read(FileId, Buffer, N, Count);
 }
 
@@ -466,6 +491,21 @@ ARC_STATUS ArcGetFileInformation(ULONG FileId, FILEINFORMATION* Information)
     return FileData[FileId].FuncTable->GetFileInformation(FileId, Information);
 }
 
+ARC_STATUS
+FsGetFileExtents(
+    _In_ ULONG FileId,
+    _Out_writes_to_(MaxExtents, *ExtentCount) PFS_EXTENT Extents,
+    _In_ ULONG MaxExtents,
+    _Out_ PULONG ExtentCount)
+{
+    *ExtentCount = 0;
+    if (!IS_VALID_FILEID(FileId))
+        return EBADF;
+    if (!FileData[FileId].FuncTable->GetExtents)
+        return EINVAL;
+    return FileData[FileId].FuncTable->GetExtents(FileId, Extents, MaxExtents, ExtentCount);
+}
+
 /* FUNCTIONS ******************************************************************/
 
 VOID FileSystemError(PCSTR ErrorString)
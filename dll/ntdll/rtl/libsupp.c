@@ -137,6 +137,14 @@ RtlLeaveHeapLock(IN OUT PHEAP_LOCK Lock)
     return RtlLeaveCriticalSection(&Lock->CriticalSection);
 }
 
+ULONG
+NTAPI
+RtlpGetHeapAffinityHint(VOID)
+{
+    /* No cheap way to get the current processor here, spread threads instead */
+    return HandleToUlong(NtCurrentTeb()->ClientId.UniqueThread) >> 2;
+}
+
 PVOID
 NTAPI
 RtlpAllocateMemory(UINT Bytes,
@@ -0,0 +1,87 @@
+/*
+ * PROJECT:     ReactOS Win32 Base API
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Batched removal of I/O completion packets
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include "k32_vista.h"
+
+#define NDEBUG
+#include <debug.h>
+
+/* The entries are filled in place by NtRemoveIoCompletionEx */
+C_ASSERT(sizeof(OVERLAPPED_ENTRY) == sizeof(FILE_IO_COMPLETION_INFORMATION));
+C_ASSERT(FIELD_OFFSET(OVERLAPPED_ENTRY, lpCompletionKey) == FIELD_OFFSET(FILE_IO_COMPLETION_INFORMATION, KeyContext));
+C_ASSERT(FIELD_OFFSET(OVERLAPPED_ENTRY, lpOverlapped) == FIELD_OFFSET(FILE_IO_COMPLETION_INFORMATION, ApcContext));
+C_ASSERT(FIELD_OFFSET(OVERLAPPED_ENTRY, Internal) == FIELD_OFFSET(FILE_IO_COMPLETION_INFORMATION, IoStatusBlock.Status));
+C_ASSERT(FIELD_OFFSET(OVERLAPPED_ENTRY, dwNumberOfBytesTransferred) == FIELD_OFFSET(FILE_IO_COMPLETION_INFORMATION, IoStatusBlock.Information));
+
+/*
+ * @implemented
+ */
+BOOL
+WINAPI
+GetQueuedCompletionStatusEx(IN HANDLE CompletionPort,
+                            OUT LPOVERLAPPED_ENTRY lpCompletionPortEntries,
+                            IN ULONG ulCount,
+                            OUT PULONG ulNumEntriesRemoved,
+                            IN DWORD dwMilliseconds,
+                            IN BOOL fAlertable)
+{
+    NTSTATUS Status;
+    LARGE_INTEGER Time;
+    PLARGE_INTEGER TimePtr = NULL;
+
+    /* We need room for at least one entry */
+    if (!lpCompletionPortEntries || !ulCount)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return FALSE;
+    }
+
+    /* Convert the timeout and then call the native API */
+    if (dwMilliseconds != INFINITE)
+    {
+        Time.QuadPart = dwMilliseconds * -10000LL;
+        TimePtr = &Time;
+    }
+
+    Status = NtRemoveIoCompletionEx(CompletionPort,
+                                    (PFILE_IO_COMPLETION_INFORMATION)lpCompletionPortEntries,
+                                    ulCount,
+                                    ulNumEntriesRemoved,
+                                    TimePtr,
+                                    (BOOLEAN)(fAlertable != FALSE));
+    if (!NT_SUCCESS(Status) ||
+        (Status == STATUS_TIMEOUT) ||
+        (Status == STATUS_USER_APC) ||
+        (Status == STATUS_ALERTED))
+    {
+        /* Nothing was removed */
+        *ulNumEntriesRemoved = 0;
+
+        /* Check what kind of error we got */
+        if (Status == STATUS_TIMEOUT)
+        {
+            /* Timeout error is set directly since there's no conversion */
+            SetLastError(WAIT_TIMEOUT);
+        }
+        else if ((Status == STATUS_USER_APC) || (Status == STATUS_ALERTED))
+        {
+            /* An APC ran while we waited */
+            SetLastError(WAIT_IO_COMPLETION);
+        }
+        else
+        {
+            /* Any other error gets converted */
+            BaseSetLastNTError(Status);
+        }
+
+        /* This is a failure case */
+        return FALSE;
+    }
+
+    /* Unlike GetQueuedCompletionStatus, failed packets are returned as entries */
+    return TRUE;
+}
@@ -5971,18 +5971,61 @@ static void init_serial(bool first_time) {
 }
 #endif
 
-#if !defined(__REACTOS__) && (defined(_X86_) || defined(_AMD64_))
+#if defined(_X86_) || defined(_AMD64_)
+#if defined(__REACTOS__) && defined(_X86_)
+// The kernel doesn't keep the XMM registers of kernel code on x86, so the
+// SSE hash functions have to save the floating point state themselves.
+static void calc_sha256_shani_fpu(uint8_t* hash, const void* input, size_t len) {
+    KFLOATING_SAVE float_save;
+
+    if (!NT_SUCCESS(KeSaveFloatingPointState(&float_save))) {
+        calc_sha256_sw(hash, input, len);
+        return;
+    }
+
+    calc_sha256_shani(hash, input, len);
+
+    KeRestoreFloatingPointState(&float_save);
+}
+
+static void blake2b_ssse3_fpu(void* out, size_t outlen, const void* in, size_t inlen) {
+    KFLOATING_SAVE float_save;
+
+    if (!NT_SUCCESS(KeSaveFloatingPointState(&float_save))) {
+        blake2b_sw(out, outlen, in, inlen);
+        return;
+    }
+
+    blake2b_ssse3(out, outlen, in, inlen);
+
+    KeRestoreFloatingPointState(&float_save);
+}
+#endif
+
 static void check_cpu() {
     bool have_sse2 = false, have_sse42 = false, have_avx2 = false;
-    int cpu_info[4];
+    bool have_ssse3 = false, have_sse41 = false, have_sha = false;
+    int cpu_info[4], max_leaf;
+
+    __cpuid(cpu_info, 0);
+    max_leaf = cpu_info[0];
 
     __cpuid(cpu_info, 1);
     have_sse42 = cpu_info[2] & (1 << 20);
+    have_sse41 = cpu_info[2] & (1 << 19);
+    have_ssse3 = cpu_info[2] & (1 << 9);
     have_sse2 = cpu_info[3] & (1 << 26);
 
-    __cpuidex(cpu_info, 7, 0);
-    have_avx2 = cpu_info[1] & (1 << 5);
+    if (max_leaf >= 7) {
+        __cpuidex(cpu_info, 7, 0);
+        have_avx2 = cpu_info[1] & (1 << 5);
+        have_sha = cpu_info[1] & (1 << 29);
+    }
 
+#ifdef __REACTOS__
+    // the upper halves of the YMM registers aren't saved on context switch
+    have_avx2 = false;
+#else
     if (have_avx2) {
         // check Windows has enabled AVX2 - Windows 10 doesn't immediately
 
@@ -6000,13 +6043,44 @@ static void check_cpu() {
         } else
             have_avx2 = false;
     }
+#endif
 
     if (have_sse42) {
         TRACE("SSE4.2 is supported\n");
+#ifdef _AMD64_
+        init_crc32c_interleaved();
+        calc_crc32c = calc_crc32c_interleaved;
+#else
         calc_crc32c = calc_crc32c_hw;
+#endif
     } else
         TRACE("SSE4.2 not supported\n");
 
+    if (have_sha && have_sse41 && have_ssse3) {
+        TRACE("SHA extensions are supported\n");
+#if defined(__REACTOS__) && defined(_X86_)
+        calc_sha256 = calc_sha256_shani_fpu;
+#else
+        calc_sha256 = calc_sha256_shani;
+#endif
+    } else
+        TRACE("SHA extensions are not supported\n");
+
+    if (have_ssse3) {
+        TRACE("SSSE3 is supported\n");
+#if defined(__REACTOS__) && defined(_X86_)
+        blake2b = blake2b_ssse3_fpu;
+#else
+        blake2b = blake2b_ssse3;
+#endif
+    } else
+        TRACE("SSSE3 is not supported\n");
+
+#if defined(__REACTOS__) && defined(_X86_)
+    // xor.S doesn't save the FPU state either
+    have_sse2 = false;
+#endif
+
     if (have_sse2) {
         TRACE("SSE2 is supported\n");
 
@@ -6332,7 +6406,7 @@ NTSTATUS __stdcall DriverEntry(_In_ PDRIVER_OBJECT DriverObject, _In_ PUNICODE_S
 
     TRACE("DriverEntry\n");
 
-#if !defined(__REACTOS__) && (defined(_X86_) || defined(_AMD64_))
+#if defined(_X86_) || defined(_AMD64_)
     check_cpu();
 #endif
 
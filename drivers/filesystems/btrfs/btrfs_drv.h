@@ -65,6 +65,7 @@
 #include <stdbool.h>
 #include "btrfs.h"
 #include "btrfsioctl.h"
+#include "csum.h"
 
 #ifdef __REACTOS__
 C_ASSERT(sizeof(bool) == 1);
@@ -1243,14 +1244,6 @@ void _free_fcb(_Inout_ fcb* fcb, _In_ const char* func);
 // in fastio.c
 void init_fast_io_dispatch(FAST_IO_DISPATCH** fiod);
 
-// in sha256.c
-void calc_sha256(uint8_t* hash, const void* input, size_t len);
-#define SHA256_HASH_SIZE 32
-
-// in blake2b-ref.c
-void blake2b(void *out, size_t outlen, const void* in, size_t inlen);
-#define BLAKE2_HASH_SIZE 32
-
 typedef struct {
     LIST_ENTRY* list;
     LIST_ENTRY* list_size;
@@ -69,3 +69,41 @@ uint32_t __stdcall calc_crc32c_sw(_In_ uint32_t seed, _In_reads_bytes_(msglen) u
     return rem;
 }
 #endif
+
+#ifdef _AMD64_
+uint32_t crc32c_long[4][256];
+uint32_t crc32c_short[4][256];
+
+static void crc32c_zeros(uint32_t table[4][256], uint32_t len) {
+    uint32_t bits[32];
+
+    // the shift is linear, so work it out for each bit and combine
+    for (unsigned int i = 0; i < 32; i++) {
+        uint32_t rem = 1u << i;
+
+        for (uint32_t j = 0; j < len; j++) {
+            rem = crctable[rem & 0xff] ^ (rem >> 8);
+        }
+
+        bits[i] = rem;
+    }
+
+    for (unsigned int k = 0; k < 4; k++) {
+        for (unsigned int v = 0; v < 256; v++) {
+            uint32_t val = 0;
+
+            for (unsigned int i = 0; i < 8; i++) {
+                if (v & (1u << i))
+                    val ^= bits[(k * 8) + i];
+            }
+
+            table[k][v] = val;
+        }
+    }
+}
+
+void init_crc32c_interleaved(void) {
+    crc32c_zeros(crc32c_long, 8192);
+    crc32c_zeros(crc32c_short, 256);
+}
+#endif
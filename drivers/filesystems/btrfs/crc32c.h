@@ -10,6 +10,20 @@ extern "C" {
 uint32_t __stdcall calc_crc32c_hw(uint32_t seed, uint8_t* msg, uint32_t msglen);
 #endif
 
+#ifdef _AMD64_
+uint32_t __stdcall calc_crc32c_interleaved(uint32_t seed, uint8_t* msg, uint32_t msglen);
+
+// tables for moving a CRC past 8192 and 256 zero bytes, filled by init_crc32c_interleaved
+extern uint32_t crc32c_long[4][256];
+extern uint32_t crc32c_short[4][256];
+
+void init_crc32c_interleaved(void);
+
+static __inline uint32_t crc32c_shift(const uint32_t table[4][256], uint32_t crc) {
+    return table[0][crc & 0xff] ^ table[1][(crc >> 8) & 0xff] ^ table[2][(crc >> 16) & 0xff] ^ table[3][crc >> 24];
+}
+#endif
+
 uint32_t __stdcall calc_crc32c_sw(uint32_t seed, uint8_t* msg, uint32_t msglen);
 
 typedef uint32_t (__stdcall *crc_func)(uint32_t seed, uint8_t* msg, uint32_t msglen);
@@ -0,0 +1,312 @@
+/*
+ * PROJECT:     ReactOS Btrfs driver
+ * LICENSE:     LGPL-3.0-or-later (https://spdx.org/licenses/LGPL-3.0-or-later)
+ * PURPOSE:     SSE versions of the checksum functions
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+/* This file is built with the SSSE3, SSE4.1, SSE4.2 and SHA instruction sets enabled,
+ * so nothing in here may be called before check_cpu has found them. Only the XMM
+ * registers are used - the kernel doesn't save the upper halves of the YMM ones. */
+
+#include <stdint.h>
+#include <string.h>
+#include <immintrin.h>
+#include "crc32c.h"
+#include "csum.h"
+
+static const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/* state is kept as ABEF and CDGH, which is what sha256rnds2 works on */
+static void sha256_blocks_shani(__m128i* abef, __m128i* cdgh, const uint8_t* data, size_t blocks) {
+    const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i state0 = *abef, state1 = *cdgh;
+
+    while (blocks > 0) {
+        __m128i save0 = state0, save1 = state1;
+        __m128i w[4], msg;
+        unsigned int i;
+
+        for (i = 0; i < 4; i++) {
+            w[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + (i * 16))), bswap);
+        }
+
+        /* four rounds at a time, expanding the schedule four words ahead */
+        for (i = 0; i < 16; i++) {
+            msg = _mm_add_epi32(w[i & 3], _mm_loadu_si128((const __m128i*)&sha256_k[i * 4]));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+            msg = _mm_shuffle_epi32(msg, 0x0e);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+
+            if (i < 12) {
+                msg = _mm_add_epi32(_mm_sha256msg1_epu32(w[i & 3], w[(i + 1) & 3]),
+                                    _mm_alignr_epi8(w[(i + 3) & 3], w[(i + 2) & 3], 4));
+                w[i & 3] = _mm_sha256msg2_epu32(msg, w[(i + 3) & 3]);
+            }
+        }
+
+        state0 = _mm_add_epi32(state0, save0);
+        state1 = _mm_add_epi32(state1, save1);
+
+        data += 64;
+        blocks--;
+    }
+
+    *abef = state0;
+    *cdgh = state1;
+}
+
+void calc_sha256_shani(uint8_t* hash, const void* input, size_t len) {
+    static const uint32_t init[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+    const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    uint8_t tail[128];
+    size_t full = len / 64, left = len % 64, tail_len;
+    uint64_t bits = (uint64_t)len * 8;
+    __m128i abef, cdgh, tmp;
+    unsigned int i;
+
+    /* ABCD / EFGH -> ABEF / CDGH */
+    tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&init[0]), 0xb1);
+    cdgh = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&init[4]), 0x1b);
+    abef = _mm_alignr_epi8(tmp, cdgh, 8);
+    cdgh = _mm_blend_epi16(cdgh, tmp, 0xf0);
+
+    sha256_blocks_shani(&abef, &cdgh, input, full);
+
+    /* pad with 0x80, zeroes and the big-endian bit length */
+    tail_len = left < 56 ? 64 : 128;
+    memset(tail, 0, tail_len);
+    memcpy(tail, (const uint8_t*)input + (full * 64), left);
+    tail[left] = 0x80;
+
+    for (i = 0; i < 8; i++) {
+        tail[tail_len - 1 - i] = (uint8_t)(bits >> (i * 8));
+    }
+
+    sha256_blocks_shani(&abef, &cdgh, tail, tail_len / 64);
+
+    /* ABEF / CDGH -> ABCD / EFGH, then big-endian out */
+    tmp = _mm_shuffle_epi32(abef, 0x1b);
+    cdgh = _mm_shuffle_epi32(cdgh, 0xb1);
+    abef = _mm_blend_epi16(tmp, cdgh, 0xf0);
+    cdgh = _mm_alignr_epi8(cdgh, tmp, 8);
+
+    abef = _mm_shuffle_epi8(abef, bswap);
+    cdgh = _mm_shuffle_epi8(cdgh, bswap);
+
+    _mm_storeu_si128((__m128i*)hash, abef);
+    _mm_storeu_si128((__m128i*)(hash + 16), cdgh);
+}
+
+static const uint64_t blake2b_iv[8] = {
+    0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+    0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+
+static const uint8_t blake2b_sigma[12][16] = {
+    {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+    { 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 },
+    { 11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4 },
+    {  7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8 },
+    {  9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13 },
+    {  2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9 },
+    { 12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11 },
+    { 13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10 },
+    {  6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5 },
+    { 10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0 },
+    {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+    { 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 }
+};
+
+#define load_pair(m, a, b) _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)&(m)[a]), _mm_loadl_epi64((const __m128i*)&(m)[b]))
+
+#define rotr32(x) _mm_shuffle_epi32((x), _MM_SHUFFLE(2, 3, 0, 1))
+#define rotr24(x) _mm_shuffle_epi8((x), r24)
+#define rotr16(x) _mm_shuffle_epi8((x), r16)
+#define rotr63(x) _mm_xor_si128(_mm_srli_epi64((x), 63), _mm_add_epi64((x), (x)))
+
+/* Two of the four G functions of a half-round, on one half of each row. */
+#define G(a, b, c, d, mx, my) \
+    do { \
+        a = _mm_add_epi64(_mm_add_epi64(a, b), mx); \
+        d = rotr32(_mm_xor_si128(d, a)); \
+        c = _mm_add_epi64(c, d); \
+        b = rotr24(_mm_xor_si128(b, c)); \
+        a = _mm_add_epi64(_mm_add_epi64(a, b), my); \
+        d = rotr16(_mm_xor_si128(d, a)); \
+        c = _mm_add_epi64(c, d); \
+        b = rotr63(_mm_xor_si128(b, c)); \
+    } while (0)
+
+static void blake2b_compress_ssse3(uint64_t h[8], const uint8_t block[128], uint64_t t, uint64_t f) {
+    const __m128i r16 = _mm_setr_epi8(2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9);
+    const __m128i r24 = _mm_setr_epi8(3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10);
+    __m128i row1l, row1h, row2l, row2h, row3l, row3h, row4l, row4h, t0, t1;
+    uint64_t m[16];
+    unsigned int r;
+
+    memcpy(m, block, sizeof(m));
+
+    row1l = _mm_loadu_si128((const __m128i*)&h[0]);
+    row1h = _mm_loadu_si128((const __m128i*)&h[2]);
+    row2l = _mm_loadu_si128((const __m128i*)&h[4]);
+    row2h = _mm_loadu_si128((const __m128i*)&h[6]);
+    row3l = _mm_loadu_si128((const __m128i*)&blake2b_iv[0]);
+    row3h = _mm_loadu_si128((const __m128i*)&blake2b_iv[2]);
+    row4l = _mm_xor_si128(_mm_loadu_si128((const __m128i*)&blake2b_iv[4]), _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)&t), _mm_setzero_si128()));
+    row4h = _mm_xor_si128(_mm_loadu_si128((const __m128i*)&blake2b_iv[6]), _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)&f), _mm_setzero_si128()));
+
+    for (r = 0; r < 12; r++) {
+        const uint8_t* s = blake2b_sigma[r];
+
+        /* columns */
+        G(row1l, row2l, row3l, row4l, load_pair(m, s[0], s[2]), load_pair(m, s[1], s[3]));
+        G(row1h, row2h, row3h, row4h, load_pair(m, s[4], s[6]), load_pair(m, s[5], s[7]));
+
+        /* rotate rows 2 to 4 so the diagonals line up */
+        t0 = _mm_alignr_epi8(row2h, row2l, 8);
+        t1 = _mm_alignr_epi8(row2l, row2h, 8);
+        row2l = t0;
+        row2h = t1;
+
+        t0 = row3l;
+        row3l = row3h;
+        row3h = t0;
+
+        t0 = _mm_alignr_epi8(row4h, row4l, 8);
+        t1 = _mm_alignr_epi8(row4l, row4h, 8);
+        row4l = t1;
+        row4h = t0;
+
+        /* diagonals */
+        G(row1l, row2l, row3l, row4l, load_pair(m, s[8], s[10]), load_pair(m, s[9], s[11]));
+        G(row1h, row2h, row3h, row4h, load_pair(m, s[12], s[14]), load_pair(m, s[13], s[15]));
+
+        /* and back */
+        t0 = _mm_alignr_epi8(row2l, row2h, 8);
+        t1 = _mm_alignr_epi8(row2h, row2l, 8);
+        row2l = t0;
+        row2h = t1;
+
+        t0 = row3l;
+        row3l = row3h;
+        row3h = t0;
+
+        t0 = _mm_alignr_epi8(row4h, row4l, 8);
+        t1 = _mm_alignr_epi8(row4l, row4h, 8);
+        row4l = t0;
+        row4h = t1;
+    }
+
+    _mm_storeu_si128((__m128i*)&h[0], _mm_xor_si128(_mm_loadu_si128((const __m128i*)&h[0]), _mm_xor_si128(row1l, row3l)));
+    _mm_storeu_si128((__m128i*)&h[2], _mm_xor_si128(_mm_loadu_si128((const __m128i*)&h[2]), _mm_xor_si128(row1h, row3h)));
+    _mm_storeu_si128((__m128i*)&h[4], _mm_xor_si128(_mm_loadu_si128((const __m128i*)&h[4]), _mm_xor_si128(row2l, row4l)));
+    _mm_storeu_si128((__m128i*)&h[6], _mm_xor_si128(_mm_loadu_si128((const __m128i*)&h[6]), _mm_xor_si128(row2h, row4h)));
+}
+
+void blake2b_ssse3(void* out, size_t outlen, const void* in, size_t inlen) {
+    const uint8_t* data = in;
+    uint8_t last[128];
+    uint64_t h[8];
+    uint64_t t = 0;
+    unsigned int i;
+
+    /* unkeyed, sequential: digest length, fanout 1, depth 1 */
+    for (i = 0; i < 8; i++) {
+        h[i] = blake2b_iv[i];
+    }
+
+    h[0] ^= 0x01010000 ^ (uint64_t)outlen;
+
+    /* the final block, even if full, is compressed with the last block flag */
+    while (inlen > 128) {
+        t += 128;
+        blake2b_compress_ssse3(h, data, t, 0);
+        data += 128;
+        inlen -= 128;
+    }
+
+    memset(last, 0, sizeof(last));
+    memcpy(last, data, inlen);
+    t += inlen;
+    blake2b_compress_ssse3(h, last, t, ~(uint64_t)0);
+
+    memcpy(out, h, outlen);
+}
+
+#ifdef _AMD64_
+#define CRC32C_LONG 8192
+#define CRC32C_SHORT 256
+
+/* Three independent crc32 instructions are in flight at once, rather than each
+ * one waiting on the last. The three partial CRCs are then combined by shifting
+ * them over the length of the data that followed them, see crc32c.c. */
+uint32_t __stdcall calc_crc32c_interleaved(uint32_t seed, uint8_t* msg, uint32_t msglen) {
+    uint64_t crc0 = seed, crc1, crc2, a, b, c;
+    const uint8_t* end;
+
+    while (msglen >= CRC32C_LONG * 3) {
+        crc1 = crc2 = 0;
+        end = msg + CRC32C_LONG;
+
+        do {
+            memcpy(&a, msg, sizeof(uint64_t));
+            memcpy(&b, msg + CRC32C_LONG, sizeof(uint64_t));
+            memcpy(&c, msg + (CRC32C_LONG * 2), sizeof(uint64_t));
+            crc0 = _mm_crc32_u64(crc0, a);
+            crc1 = _mm_crc32_u64(crc1, b);
+            crc2 = _mm_crc32_u64(crc2, c);
+            msg += sizeof(uint64_t);
+        } while (msg < end);
+
+        crc0 = crc32c_shift(crc32c_long, (uint32_t)crc0) ^ crc1;
+        crc0 = crc32c_shift(crc32c_long, (uint32_t)crc0) ^ crc2;
+        msg += CRC32C_LONG * 2;
+        msglen -= CRC32C_LONG * 3;
+    }
+
+    while (msglen >= CRC32C_SHORT * 3) {
+        crc1 = crc2 = 0;
+        end = msg + CRC32C_SHORT;
+
+        do {
+            memcpy(&a, msg, sizeof(uint64_t));
+            memcpy(&b, msg + CRC32C_SHORT, sizeof(uint64_t));
+            memcpy(&c, msg + (CRC32C_SHORT * 2), sizeof(uint64_t));
+            crc0 = _mm_crc32_u64(crc0, a);
+            crc1 = _mm_crc32_u64(crc1, b);
+            crc2 = _mm_crc32_u64(crc2, c);
+            msg += sizeof(uint64_t);
+        } while (msg < end);
+
+        crc0 = crc32c_shift(crc32c_short, (uint32_t)crc0) ^ crc1;
+        crc0 = crc32c_shift(crc32c_short, (uint32_t)crc0) ^ crc2;
+        msg += CRC32C_SHORT * 2;
+        msglen -= CRC32C_SHORT * 3;
+    }
+
+    while (msglen >= sizeof(uint64_t)) {
+        memcpy(&a, msg, sizeof(uint64_t));
+        crc0 = _mm_crc32_u64(crc0, a);
+        msg += sizeof(uint64_t);
+        msglen -= sizeof(uint64_t);
+    }
+
+    while (msglen > 0) {
+        crc0 = _mm_crc32_u8((uint32_t)crc0, *msg);
+        msg++;
+        msglen--;
+    }
+
+    return (uint32_t)crc0;
+}
+#endif
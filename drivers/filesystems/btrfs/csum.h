@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SHA256_HASH_SIZE 32
+#define BLAKE2_HASH_SIZE 32
+
+typedef void (*sha256_func)(uint8_t* hash, const void* input, size_t len);
+typedef void (*blake2b_func)(void* out, size_t outlen, const void* in, size_t inlen);
+
+// in sha256.c
+void calc_sha256_sw(uint8_t* hash, const void* input, size_t len);
+extern sha256_func calc_sha256;
+
+// in blake2b-ref.c
+void blake2b_sw(void* out, size_t outlen, const void* in, size_t inlen);
+extern blake2b_func blake2b;
+
+// in csum-simd.c - only call these once the CPU is known to support them, and
+// on x86 with the floating point state saved
+#if defined(_X86_) || defined(_AMD64_)
+void calc_sha256_shani(uint8_t* hash, const void* input, size_t len);
+void blake2b_ssse3(void* out, size_t outlen, const void* in, size_t inlen);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -107,6 +107,14 @@ typedef uint64_t ext4_fsblk_t;
 /* Use blocks from reserved pool */
 #define EXT4_MB_USE_RESERVED		0x2000
 
+/*
+ * Allocation of file data blocks, see ext4_mballoc.c
+ */
+ext4_fsblk_t ext4_mb_new_blocks(void *icb, struct inode *inode, ext4_lblk_t lblk,
+				ext4_fsblk_t goal, unsigned long limit,
+				unsigned long *count, int *errp);
+void ext4_discard_preallocations(void *icb, struct inode *inode);
+
 
 #define ext4_sb_info ext3_sb_info
 
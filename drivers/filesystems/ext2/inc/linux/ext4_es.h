@@ -0,0 +1,55 @@
+/*
+ * PROJECT:     Ext2 File System Driver
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Extent status tree, the cache of resolved block mappings of an inode
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#ifndef _LINUX_EXT4_ES_H
+#define _LINUX_EXT4_ES_H
+
+#include <linux/types.h>
+#include <linux/rbtree.h>
+
+/*
+ * Status of the blocks of a cached extent, same values as Linux
+ */
+#define EXTENT_STATUS_WRITTEN       0x0001  /* mapped and initialized */
+#define EXTENT_STATUS_UNWRITTEN     0x0002  /* mapped, reads as zeros */
+#define EXTENT_STATUS_HOLE          0x0008  /* not mapped */
+
+/* An inode caching more extents than this starts over */
+#define EXT4_ES_MAX_EXTENTS         1024
+
+struct extent_status {
+    struct rb_node  rb_node;
+    __u32           es_lblk;        /* first logical block extent covers */
+    __u32           es_len;         /* length of extent in blocks */
+    __u64           es_pblk;        /* first physical block, 0 for holes */
+    __u32           es_status;      /* EXTENT_STATUS_* */
+};
+
+struct ext4_es_tree {
+    struct rb_root          root;
+    struct extent_status   *cache_es;   /* last extent found */
+    __u32                   count;
+    __u32                   seq;        /* bumped when mappings change */
+    KSPIN_LOCK              lock;
+};
+
+struct inode;
+
+int  ext4_init_es(void);
+void ext4_exit_es(void);
+
+void ext4_es_init_tree(struct ext4_es_tree *tree);
+int  ext4_es_lookup_extent(struct inode *inode, __u32 lblk,
+                           struct extent_status *es);
+__u32 ext4_es_seq(struct inode *inode);
+void ext4_es_cache_extent(struct inode *inode, __u32 lblk, __u32 len,
+                          __u64 pblk, __u32 status, __u32 seq);
+void ext4_es_insert_extent(struct inode *inode, __u32 lblk, __u32 len,
+                           __u64 pblk, __u32 status);
+void ext4_es_remove_extent(struct inode *inode, __u32 lblk, __u32 len);
+
+#endif /* _LINUX_EXT4_ES_H */
@@ -81,6 +81,9 @@ struct ext4_ext_path
  * structure for external API
  */
 
+/* Largest logical block number, also used as "no such block" */
+#define EXT_MAX_BLOCKS 0xffffffff
+
 /*
  * EXT_INIT_MAX_LEN is the maximum number of blocks we can have in an
  * initialized extent. This is 2^15 and not (2^16 - 1), since we use the
@@ -4,6 +4,7 @@
 #include <linux/types.h>
 #include <linux/atomic.h>
 #include <linux/rbtree.h>
+#include <linux/ext4_es.h>
 
 //
 // kdev
@@ -98,6 +99,13 @@ struct inode {
 
     __u16               i_extra_isize;      /* extra fields' size */
     __u64               i_file_acl;
+
+    struct ext4_es_tree i_es_tree;          /* cached block mappings */
+
+    /* blocks taken ahead of the next write, see ext4_mballoc.c */
+    __u32               i_pa_lstart;        /* logical block they are for */
+    __u32               i_pa_len;           /* number of blocks left */
+    __u64               i_pa_pstart;        /* first physical block */
 };
 
 //
@@ -276,6 +276,13 @@ Ext2Cleanup (IN PEXT2_IRP_CONTEXT IrpContext)
                     FcbPagingIoResourceAcquired = FALSE;
                 }
             }
+
+            /* give back the blocks taken ahead of writes to come */
+            if (Fcb->OpenHandleCount == 0 && Fcb->Inode->i_pa_len != 0) {
+                ExAcquireResourceExclusiveLite(&Fcb->PagingIoResource, TRUE);
+                ext4_discard_preallocations(IrpContext, Fcb->Inode);
+                ExReleaseResourceLite(&Fcb->PagingIoResource);
+            }
         }
 
         IoRemoveShareAccess(FileObject, &Fcb->ShareAccess);
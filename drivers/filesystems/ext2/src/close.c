@@ -140,6 +140,14 @@ Ext2Close (IN PEXT2_IRP_CONTEXT IrpContext)
             FileObject->FsContext2 = Ccb = NULL;
         }
 
+        /* no writes are left to take the preallocated blocks */
+        if (Fcb->ReferenceCount == 1 && Fcb->Mcb &&
+            Fcb->Inode->i_pa_len != 0) {
+            ExAcquireResourceExclusiveLite(&Fcb->PagingIoResource, TRUE);
+            ext4_discard_preallocations(IrpContext, Fcb->Inode);
+            ExReleaseResourceLite(&Fcb->PagingIoResource);
+        }
+
         /* only deref fcb, Ext2ReleaseFcb might lead deadlock */
         FcbDerefDeferred = TRUE;
         if (IsFlagOn(Fcb->Flags, FCB_DELETE_PENDING) ||
@@ -1025,8 +1025,10 @@ Ext2NewBlock(
     ULONG                   Group = 0;
     ULONG                   Index = 0xFFFFFFFF;
     ULONG                   dwHint = 0;
+    ULONG                   FirstHint = 0;
     ULONG                   Count = 0;
     ULONG                   Length = 0;
+    BOOLEAN                 Fragment = FALSE;
 
     NTSTATUS                Status = STATUS_DISK_FULL;
 
@@ -1045,7 +1047,35 @@ Ext2NewBlock(
         dwHint = (BlockHint - EXT2_FIRST_DATA_BLOCK) % BLOCKS_PER_GROUP;
     }
 
+    /* no group could give more than this in one piece */
+    if (*Number > BLOCKS_PER_GROUP) {
+        *Number = BLOCKS_PER_GROUP;
+    }
+
+    /*
+     * The whole run is searched for in every group, starting with the
+     * hinted one, before settling for less: taking the first free piece
+     * of the hinted group would leave large files scattered in fragments.
+     */
+    FirstHint = dwHint;
     Group = GroupHint;
+    goto Again;
+
+NextGroup:
+
+    dwHint = 0;
+    Group = (Group + 1) % Vcb->sbi.s_groups_count;
+    if (Group == GroupHint) {
+
+        /* all groups were tried */
+        if (Fragment) {
+            goto errorout;
+        }
+
+        /* no group has the whole run: take the longest piece found */
+        Fragment = TRUE;
+        dwHint = FirstHint;
+    }
 
 Again:
 
@@ -1062,6 +1092,12 @@ Again:
         goto errorout;
     }
 
+    /* don't read the bitmap of a group not having enough free blocks */
+    if (ext4_free_blks_count(sb, gd) == 0 ||
+        (!Fragment && ext4_free_blks_count(sb, gd) < *Number)) {
+        goto NextGroup;
+    }
+
     bitmap_blk = ext4_block_bitmap(sb, gd);
 
     if (gd->bg_flags & cpu_to_le16(EXT4_BG_BLOCK_UNINIT)) {
@@ -1094,66 +1130,51 @@ Again:
 	    }
     }
 
-    if (ext4_free_blks_count(sb, gd)) {
-
-        if (Group == Vcb->sbi.s_groups_count - 1) {
+    if (Group == Vcb->sbi.s_groups_count - 1) {
 
-            Length = (ULONG)(TOTAL_BLOCKS % BLOCKS_PER_GROUP);
+        Length = (ULONG)(TOTAL_BLOCKS % BLOCKS_PER_GROUP);
 
-            /* s_blocks_count is integer multiple of s_blocks_per_group */
-            if (Length == 0) {
-                Length = BLOCKS_PER_GROUP;
-            }
-        } else {
+        /* s_blocks_count is integer multiple of s_blocks_per_group */
+        if (Length == 0) {
             Length = BLOCKS_PER_GROUP;
         }
+    } else {
+        Length = BLOCKS_PER_GROUP;
+    }
 
-        /* initialize bitmap buffer */
-        RtlInitializeBitMap(&BlockBitmap, (PULONG)bh->b_data, Length);
+    /* initialize bitmap buffer */
+    RtlInitializeBitMap(&BlockBitmap, (PULONG)bh->b_data, Length);
 
-        /* try to find a clear bit range */
-        Index = RtlFindClearBits(&BlockBitmap, *Number, dwHint);
+    /* try to find a clear bit range, at the hint block if possible */
+    Index = RtlFindClearBits(&BlockBitmap, *Number, dwHint);
 
-        /* We could not get new block in the prefered group */
-        if (Index == 0xFFFFFFFF) {
+    /* We could not get new block in the prefered group */
+    if (Index == 0xFFFFFFFF) {
 
-            /* search clear bits from the hint block */
-            Count = RtlFindNextForwardRunClear(&BlockBitmap, dwHint, &Index);
-            if (dwHint != 0 && Count == 0) {
-                /* search clear bits from the very beginning */
-                Count = RtlFindNextForwardRunClear(&BlockBitmap, 0, &Index);
-            }
+        /* the free blocks of this group are scattered, try the others */
+        if (!Fragment) {
+            goto NextGroup;
+        }
 
-            if (Count == 0) {
+        Count = RtlFindLongestRunClear(&BlockBitmap, &Index);
+        if (Count == 0) {
 
-                RtlZeroMemory(&BlockBitmap, sizeof(RTL_BITMAP));
+            RtlZeroMemory(&BlockBitmap, sizeof(RTL_BITMAP));
 
-                /* no blocks found: set bg_free_blocks_count to 0 */
-                ext4_free_blks_set(sb, gd, 0);
-                Ext2SaveGroup(IrpContext, Vcb, Group);
+            /* no blocks found: set bg_free_blocks_count to 0 */
+            ext4_free_blks_set(sb, gd, 0);
+            Ext2SaveGroup(IrpContext, Vcb, Group);
 
-                /* will try next group */
-                goto Again;
+            /* will try next group */
+            goto NextGroup;
 
-            } else {
+        } else {
 
-                /* we got free blocks */
-                if (Count <= *Number) {
-                    *Number = Count;
-                }
+            /* we got free blocks */
+            if (Count <= *Number) {
+                *Number = Count;
             }
         }
-
-    } else {
-
-        /* try next group */
-        dwHint = 0;
-        Group = (Group + 1) % Vcb->sbi.s_groups_count;
-        if (Group != GroupHint) {
-            goto Again;
-        }
-
-        Index = 0xFFFFFFFF;
     }
 
     if (Index < Length) {
@@ -0,0 +1,343 @@
+/*
+ * PROJECT:     Ext2 File System Driver
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Extent status tree, the cache of resolved block mappings of an inode
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+/*
+ * Every inode keeps the ranges ext4_ext_get_blocks() has resolved in a
+ * red-black tree keyed by logical block, modelled on Linux's extent status
+ * tree. Each entry says whether the range is written, unwritten or a hole,
+ * so the extent tree only has to be walked again for blocks never looked
+ * up before. Entries never overlap: inserting a range first cuts it out of
+ * the entries already there. Entries are dropped when the extent tree
+ * changes underneath them, and an inode holding too many starts over.
+ *
+ * What a lookup found in the extent tree is only cached if the mappings
+ * did not change while it was walking, so a reader racing with a writer
+ * never puts back what the writer just replaced.
+ */
+
+#include <ext2fs.h>
+#include <linux/module.h>
+#include <linux/ext4.h>
+
+static kmem_cache_t *ext4_es_cachep = NULL;
+
+int ext4_init_es(void)
+{
+	ext4_es_cachep = kmem_cache_create("ext4_extent_status",
+					   sizeof(struct extent_status),
+					   0, SLAB_TEMPORARY, NULL);
+	if (ext4_es_cachep == NULL)
+		return -ENOMEM;
+	return 0;
+}
+
+void ext4_exit_es(void)
+{
+	if (ext4_es_cachep) {
+		kmem_cache_destroy(ext4_es_cachep);
+		ext4_es_cachep = NULL;
+	}
+}
+
+void ext4_es_init_tree(struct ext4_es_tree *tree)
+{
+	tree->root.rb_node = NULL;
+	tree->cache_es = NULL;
+	tree->count = 0;
+	tree->seq = 0;
+	KeInitializeSpinLock(&tree->lock);
+}
+
+static inline __u64 ext4_es_end(struct extent_status *es)
+{
+	return (__u64)es->es_lblk + es->es_len;
+}
+
+static inline struct extent_status *ext4_es_next(struct extent_status *es)
+{
+	struct rb_node *node = rb_next(&es->rb_node);
+
+	return node ? rb_entry(node, struct extent_status, rb_node) : NULL;
+}
+
+static inline struct extent_status *ext4_es_prev(struct extent_status *es)
+{
+	struct rb_node *node = rb_prev(&es->rb_node);
+
+	return node ? rb_entry(node, struct extent_status, rb_node) : NULL;
+}
+
+/*
+ * Returns the extent covering lblk, or else the first one after it
+ */
+static struct extent_status *__es_tree_search(struct rb_root *root, __u32 lblk)
+{
+	struct rb_node *node = root->rb_node;
+	struct extent_status *es = NULL;
+
+	while (node) {
+		es = rb_entry(node, struct extent_status, rb_node);
+		if (lblk < es->es_lblk)
+			node = node->rb_left;
+		else if (lblk >= ext4_es_end(es))
+			node = node->rb_right;
+		else
+			return es;
+	}
+
+	if (es && lblk < es->es_lblk)
+		return es;
+
+	if (es && lblk >= ext4_es_end(es))
+		return ext4_es_next(es);
+
+	return NULL;
+}
+
+static struct extent_status *
+ext4_es_alloc_extent(struct ext4_es_tree *tree, __u32 lblk, __u32 len,
+		     __u64 pblk, __u32 status)
+{
+	struct extent_status *es;
+
+	/* Called at DISPATCH_LEVEL, under the tree lock */
+	es = kmem_cache_alloc(ext4_es_cachep, GFP_ATOMIC);
+	if (es == NULL)
+		return NULL;
+
+	es->es_lblk = lblk;
+	es->es_len = len;
+	es->es_pblk = pblk;
+	es->es_status = status;
+	tree->count++;
+
+	return es;
+}
+
+static void ext4_es_free_extent(struct ext4_es_tree *tree, struct extent_status *es)
+{
+	if (tree->cache_es == es)
+		tree->cache_es = NULL;
+	rb_erase(&es->rb_node, &tree->root);
+	tree->count--;
+	kmem_cache_free(ext4_es_cachep, es);
+}
+
+static void __es_link_extent(struct ext4_es_tree *tree, struct extent_status *new)
+{
+	struct rb_node **p = &tree->root.rb_node;
+	struct rb_node *parent = NULL;
+	struct extent_status *es;
+
+	while (*p) {
+		parent = *p;
+		es = rb_entry(parent, struct extent_status, rb_node);
+		if (new->es_lblk < es->es_lblk)
+			p = &(*p)->rb_left;
+		else
+			p = &(*p)->rb_right;
+	}
+
+	rb_link_node(&new->rb_node, parent, p);
+	rb_insert_color(&new->rb_node, &tree->root);
+}
+
+static int ext4_es_can_merge(struct extent_status *es1, struct extent_status *es2)
+{
+	if (es1->es_status != es2->es_status)
+		return 0;
+	if (ext4_es_end(es1) != es2->es_lblk)
+		return 0;
+	if ((__u64)es1->es_len + es2->es_len > EXT_MAX_BLOCKS)
+		return 0;
+	if (es1->es_status != EXTENT_STATUS_HOLE &&
+	    es1->es_pblk + es1->es_len != es2->es_pblk)
+		return 0;
+	return 1;
+}
+
+/*
+ * Links a new extent and merges it with its neighbours when they continue
+ * each other, the range must not be cached already
+ */
+static void __es_insert_extent(struct ext4_es_tree *tree, struct extent_status *new)
+{
+	struct extent_status *es;
+
+	__es_link_extent(tree, new);
+
+	es = ext4_es_prev(new);
+	if (es && ext4_es_can_merge(es, new)) {
+		es->es_len += new->es_len;
+		ext4_es_free_extent(tree, new);
+		new = es;
+	}
+
+	es = ext4_es_next(new);
+	if (es && ext4_es_can_merge(new, es)) {
+		new->es_len += es->es_len;
+		ext4_es_free_extent(tree, es);
+	}
+
+	tree->cache_es = new;
+}
+
+/*
+ * Cuts the blocks from lblk up to end out of the cached extents
+ */
+static void __es_remove_extent(struct ext4_es_tree *tree, __u32 lblk, __u64 end)
+{
+	struct extent_status *es, *tail, *next;
+	__u64 es_end, delta;
+
+	es = __es_tree_search(&tree->root, lblk);
+	if (es == NULL)
+		return;
+
+	if (es->es_lblk < lblk) {
+		es_end = ext4_es_end(es);
+		es->es_len = lblk - es->es_lblk;
+
+		if (es_end > end) {
+			/* The range was inside it, keep what follows as another extent */
+			delta = end - es->es_lblk;
+			tail = ext4_es_alloc_extent(tree, (__u32)end, (__u32)(es_end - end),
+						    es->es_status == EXTENT_STATUS_HOLE ?
+						    0 : es->es_pblk + delta,
+						    es->es_status);
+			if (tail)
+				__es_link_extent(tree, tail);
+			return;
+		}
+
+		es = ext4_es_next(es);
+	}
+
+	while (es && es->es_lblk < end) {
+		es_end = ext4_es_end(es);
+		if (es_end > end) {
+			delta = end - es->es_lblk;
+			if (es->es_status != EXTENT_STATUS_HOLE)
+				es->es_pblk += delta;
+			es->es_lblk = (__u32)end;
+			es->es_len = (__u32)(es_end - end);
+			break;
+		}
+
+		next = ext4_es_next(es);
+		ext4_es_free_extent(tree, es);
+		es = next;
+	}
+}
+
+static void __es_remove_all(struct ext4_es_tree *tree)
+{
+	struct rb_node *node;
+
+	while ((node = rb_first(&tree->root)) != NULL)
+		ext4_es_free_extent(tree, rb_entry(node, struct extent_status, rb_node));
+}
+
+int ext4_es_lookup_extent(struct inode *inode, __u32 lblk, struct extent_status *es)
+{
+	struct ext4_es_tree *tree = &inode->i_es_tree;
+	struct extent_status *found;
+	KIRQL irql;
+
+	KeAcquireSpinLock(&tree->lock, &irql);
+
+	found = tree->cache_es;
+	if (found == NULL || lblk < found->es_lblk || lblk >= ext4_es_end(found)) {
+		found = __es_tree_search(&tree->root, lblk);
+		if (found && lblk < found->es_lblk)
+			found = NULL;
+	}
+
+	if (found) {
+		es->es_lblk = found->es_lblk;
+		es->es_len = found->es_len;
+		es->es_pblk = found->es_pblk;
+		es->es_status = found->es_status;
+		tree->cache_es = found;
+	}
+
+	KeReleaseSpinLock(&tree->lock, irql);
+
+	return found != NULL;
+}
+
+static void __es_insert_range(struct ext4_es_tree *tree, __u32 lblk, __u32 len,
+			      __u64 pblk, __u32 status)
+{
+	struct extent_status *es;
+
+	__es_remove_extent(tree, lblk, (__u64)lblk + len);
+
+	/* There is no shrinker, so bound what a single inode can hold */
+	if (tree->count >= EXT4_ES_MAX_EXTENTS)
+		__es_remove_all(tree);
+
+	es = ext4_es_alloc_extent(tree, lblk, len,
+				  status == EXTENT_STATUS_HOLE ? 0 : pblk, status);
+	if (es)
+		__es_insert_extent(tree, es);
+}
+
+__u32 ext4_es_seq(struct inode *inode)
+{
+	return *(volatile __u32 *)&inode->i_es_tree.seq;
+}
+
+/*
+ * Caches what a lookup found, unless the mappings changed since it got seq
+ */
+void ext4_es_cache_extent(struct inode *inode, __u32 lblk, __u32 len,
+			  __u64 pblk, __u32 status, __u32 seq)
+{
+	struct ext4_es_tree *tree = &inode->i_es_tree;
+	KIRQL irql;
+
+	if (len == 0)
+		return;
+
+	KeAcquireSpinLock(&tree->lock, &irql);
+	if (tree->seq == seq)
+		__es_insert_range(tree, lblk, len, pblk, status);
+	KeReleaseSpinLock(&tree->lock, irql);
+}
+
+/*
+ * Records blocks whose mapping was just changed
+ */
+void ext4_es_insert_extent(struct inode *inode, __u32 lblk, __u32 len,
+			   __u64 pblk, __u32 status)
+{
+	struct ext4_es_tree *tree = &inode->i_es_tree;
+	KIRQL irql;
+
+	if (len == 0)
+		return;
+
+	KeAcquireSpinLock(&tree->lock, &irql);
+	tree->seq++;
+	__es_insert_range(tree, lblk, len, pblk, status);
+	KeReleaseSpinLock(&tree->lock, irql);
+}
+
+void ext4_es_remove_extent(struct inode *inode, __u32 lblk, __u32 len)
+{
+	struct ext4_es_tree *tree = &inode->i_es_tree;
+	KIRQL irql;
+
+	KeAcquireSpinLock(&tree->lock, &irql);
+	tree->seq++;
+	if (lblk == 0 && len == EXT_MAX_BLOCKS)
+		__es_remove_all(tree);
+	else
+		__es_remove_extent(tree, lblk, (__u64)lblk + len);
+	KeReleaseSpinLock(&tree->lock, irql);
+}
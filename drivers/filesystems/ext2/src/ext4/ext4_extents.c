@@ -47,7 +47,9 @@ static inline ext4_fsblk_t ext4_inode_to_goal_block(struct inode *inode)
 {
 	PEXT2_VCB Vcb;
 	Vcb = inode->i_sb->s_priv;
-	return (inode->i_ino - 1) / BLOCKS_PER_GROUP;
+	/* first block of the group holding the inode */
+	return (ext4_fsblk_t)((inode->i_ino - 1) / INODES_PER_GROUP) *
+		BLOCKS_PER_GROUP + EXT2_FIRST_DATA_BLOCK;
 }
 
 static ext4_fsblk_t ext4_new_meta_blocks(void *icb, handle_t *handle, struct inode *inode,
@@ -109,8 +111,6 @@ static inline void ext_debug(char *str, ...)
  * Return the right sibling of a tree node(either leaf or indexes node)
  */
 
-#define EXT_MAX_BLOCKS 0xffffffff
-
 
 static inline int ext4_ext_space_block(struct inode *inode, int check)
 {
@@ -2388,13 +2388,34 @@ int ext4_ext_get_blocks(void *icb, handle_t *handle, struct inode *inode, ext4_f
 {
 	struct ext4_ext_path *path = NULL;
 	struct ext4_extent newex, *ex;
+	struct extent_status es;
 	int goal, err = 0, depth;
 	unsigned long allocated = 0;
 	ext4_fsblk_t next, newblock;
+	__u32 seq;
 
 	clear_buffer_new(bh_result);
 	/*mutex_lock(&ext4_I(inode)->truncate_mutex);*/
 
+	/* blocks looked up before need no walk of the extent tree */
+	if (ext4_es_lookup_extent(inode, (__u32)iblock, &es)) {
+		if (es.es_status == EXTENT_STATUS_WRITTEN) {
+			allocated = es.es_lblk + es.es_len - (__u32)iblock;
+			newblock = es.es_pblk + iblock - es.es_lblk;
+			goto out;
+		}
+		if (!create) {
+			if (es.es_status == EXTENT_STATUS_HOLE)
+				goto out2;
+			allocated = es.es_lblk + es.es_len - (__u32)iblock;
+			newblock = 0;
+			goto out;
+		}
+	}
+
+	/* what the walk finds is only cached if nobody changed it meanwhile */
+	seq = ext4_es_seq(inode);
+
 	/* find extent for this block */
 	path = ext4_find_extent(inode, iblock, NULL, 0);
 	if (IS_ERR(path)) {
@@ -2412,6 +2433,10 @@ int ext4_ext_get_blocks(void *icb, handle_t *handle, struct inode *inode, ext4_f
 	 */
 	BUG_ON(path[depth].p_ext == NULL && depth != 0);
 
+	/* find next allocated block so that we know how many
+	 * blocks we can allocate without ovelapping next extent */
+	next = ext4_ext_next_allocated_block(path);
+
 	if ((ex = path[depth].p_ext)) {
 		ext4_lblk_t ee_block = le32_to_cpu(ex->ee_block);
 		ext4_fsblk_t ee_start = ext4_ext_pblock(ex);
@@ -2432,17 +2457,27 @@ int ext4_ext_get_blocks(void *icb, handle_t *handle, struct inode *inode, ext4_f
 							iblock,
 							allocated,
 							flags);
+					/* the extent got split, whatever its parts are now */
+					ext4_es_remove_extent(inode, ee_block, ee_len);
 					if (err)
 						goto out2;
 
 				} else {
 					newblock = 0;
+					ext4_es_cache_extent(inode, ee_block, ee_len, ee_start,
+							     EXTENT_STATUS_UNWRITTEN, seq);
 				}
 			} else {
 				newblock = iblock - ee_block + ee_start;
+				ext4_es_cache_extent(inode, ee_block, ee_len, ee_start,
+						     EXTENT_STATUS_WRITTEN, seq);
 			}
 			goto out;
 		}
+
+		/* the block is in front of the first extent of the leaf */
+		if (iblock < ee_block)
+			next = ee_block;
 	}
 
 	/*
@@ -2450,12 +2485,11 @@ int ext4_ext_get_blocks(void *icb, handle_t *handle, struct inode *inode, ext4_f
 	 * we couldn't try to create block if create flag is zero
 	 */
 	if (!create) {
+		ext4_es_cache_extent(inode, (__u32)iblock, (__u32)(next - iblock), 0,
+				     EXTENT_STATUS_HOLE, seq);
 		goto out2;
 	}
 
-	/* find next allocated block so that we know how many
-	 * blocks we can allocate without ovelapping next extent */
-	next = ext4_ext_next_allocated_block(path);
 	BUG_ON(next <= iblock);
 	allocated = next - iblock;
 	if (flags & EXT4_GET_BLOCKS_PRE_IO && max_blocks > EXT_UNWRITTEN_MAX_LEN)
@@ -2466,8 +2500,17 @@ int ext4_ext_get_blocks(void *icb, handle_t *handle, struct inode *inode, ext4_f
 	/* allocate new block */
 	goal = ext4_ext_find_goal(inode, path, iblock);
 
-	newblock = ext4_new_meta_blocks(icb, handle, inode, goal, 0,
-			&allocated, &err);
+	/* file data written through the cache gets a window of blocks */
+	if (icb && S_ISREG(inode->i_mode) &&
+	    !(flags & (EXT4_GET_BLOCKS_PRE_IO | EXT4_GET_BLOCKS_NO_NORMALIZE))) {
+		newblock = ext4_mb_new_blocks(icb, inode, iblock, goal,
+				next - iblock, &allocated, &err);
+	} else {
+		/* the new extent could take the logical blocks preallocated */
+		ext4_discard_preallocations(icb, inode);
+		newblock = ext4_new_meta_blocks(icb, handle, inode, goal, 0,
+				&allocated, &err);
+	}
 	if (!newblock)
 		goto out2;
 
@@ -2486,9 +2529,14 @@ int ext4_ext_get_blocks(void *icb, handle_t *handle, struct inode *inode, ext4_f
 		/* free data blocks we just allocated */
 		ext4_free_blocks(icb, handle, inode, NULL, ext4_ext_pblock(&newex),
 				le16_to_cpu(newex.ee_len), get_default_free_blocks_flags(inode));
+		ext4_es_remove_extent(inode, (__u32)iblock, allocated);
 		goto out2;
 	}
 
+	ext4_es_insert_extent(inode, (__u32)iblock, allocated, ext4_ext_pblock(&newex),
+			      ext4_ext_is_unwritten(&newex) ?
+			      EXTENT_STATUS_UNWRITTEN : EXTENT_STATUS_WRITTEN);
+
 	ext4_mark_inode_dirty(icb, handle, inode);
 
 	/* previous routine could use block we allocated */
@@ -2521,6 +2569,8 @@ int ext4_ext_truncate(void *icb, struct inode *inode, unsigned long start)
 {
     int ret = ext4_ext_remove_space(icb, inode, start);
 
+    ext4_es_remove_extent(inode, start, EXT_MAX_BLOCKS - start);
+
 	/* Save modifications on i_blocks field of the inode. */
 	if (!ret)
 		ret = ext4_mark_inode_dirty(icb, NULL, inode);
@@ -0,0 +1,120 @@
+/*
+ * PROJECT:     Ext2 File System Driver
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Allocation of file data blocks with per-inode preallocation
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+/*
+ * A file written sequentially in small pieces would get a small run of
+ * blocks per write, interleaved with those of every other file being
+ * written at the same time. As Linux's mballoc does, the allocation for
+ * file data asks for a window sized after the file instead, and what the
+ * write did not need is kept as the inode's preallocation, which the next
+ * write continuing the file takes its blocks from.
+ *
+ * Preallocated blocks are marked in the bitmap but not mapped into the
+ * file, so they are given back when the last handle is closed, when the
+ * file is truncated and when the volume is flushed. The lazy writer can
+ * still write the file after its last handle is gone, so the close of its
+ * last file object gives them back once more. A write anywhere else in the
+ * file gives them back too, as they then no longer follow it.
+ */
+
+#include <ext2fs.h>
+#include <linux/ext4.h>
+
+/* Smallest and largest window asked for, in bytes */
+#define EXT4_MB_MIN_WINDOW	(64 * 1024)
+#define EXT4_MB_MAX_WINDOW	(8 * 1024 * 1024)
+
+/*
+ * Number of blocks to ask for when count blocks are written at lblk: the
+ * file size rounded up to a power of two, within the limits above
+ */
+static unsigned long ext4_mb_normalize_request(struct inode *inode,
+					       ext4_lblk_t lblk,
+					       unsigned long count)
+{
+	unsigned int bits = inode->i_sb->s_blocksize_bits;
+	__u64 size = ((__u64)lblk + count) << bits;
+	__u64 window = EXT4_MB_MIN_WINDOW;
+
+	if (size < (__u64)inode->i_size)
+		size = inode->i_size;
+
+	while (window < size && window < EXT4_MB_MAX_WINDOW)
+		window <<= 1;
+
+	if ((window >> bits) > count)
+		return (unsigned long)(window >> bits);
+
+	return count;
+}
+
+/*
+ * Allocates up to *count blocks for the file data at lblk, no more than
+ * limit blocks may be taken ahead as the next extent of the file follows
+ */
+ext4_fsblk_t ext4_mb_new_blocks(void *icb, struct inode *inode, ext4_lblk_t lblk,
+				ext4_fsblk_t goal, unsigned long limit,
+				unsigned long *count, int *errp)
+{
+	NTSTATUS status;
+	ULONG block = 0;
+	ULONG wanted;
+	unsigned long used;
+
+	/* the write continues the file where the last one stopped */
+	if (inode->i_pa_len && inode->i_pa_lstart == lblk) {
+		used = min(*count, (unsigned long)inode->i_pa_len);
+		block = (ULONG)inode->i_pa_pstart;
+		inode->i_pa_lstart += used;
+		inode->i_pa_pstart += used;
+		inode->i_pa_len -= used;
+		goto out;
+	}
+
+	ext4_discard_preallocations(icb, inode);
+
+	wanted = ext4_mb_normalize_request(inode, lblk, *count);
+	if (wanted > limit)
+		wanted = limit;
+
+	status = Ext2NewBlock((PEXT2_IRP_CONTEXT)icb,
+			inode->i_sb->s_priv,
+			0, (ULONG)goal,
+			&block,
+			&wanted);
+	if (!NT_SUCCESS(status)) {
+		*errp = Ext2LinuxError(status);
+		return 0;
+	}
+
+	used = min(*count, (unsigned long)wanted);
+	if (wanted > used) {
+		inode->i_pa_lstart = lblk + used;
+		inode->i_pa_pstart = block + used;
+		inode->i_pa_len = wanted - used;
+	}
+
+out:
+	*count = used;
+
+	/* only the blocks mapped into the file are accounted to it */
+	inode->i_blocks += used * (inode->i_sb->s_blocksize >> 9);
+	return block;
+}
+
+/*
+ * Gives back the blocks taken ahead of writes to the inode
+ */
+void ext4_discard_preallocations(void *icb, struct inode *inode)
+{
+	if (inode->i_pa_len == 0)
+		return;
+
+	Ext2FreeBlock((PEXT2_IRP_CONTEXT)icb, inode->i_sb->s_priv,
+		      (ULONG)inode->i_pa_pstart, inode->i_pa_len);
+	inode->i_pa_len = 0;
+}
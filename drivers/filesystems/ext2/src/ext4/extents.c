@@ -219,6 +219,9 @@ Ext2TruncateExtent(
     /* calculate blocks to be freed */
     Extra = End - Wanted;
 
+    /* blocks taken ahead of writes past the new end are useless now */
+    ext4_discard_preallocations(IrpContext, &Mcb->Inode);
+
     err = ext4_ext_truncate(IrpContext, &Mcb->Inode, Wanted);
     if (err == 0) {
         if (!Ext2RemoveBlockExtent(Vcb, Mcb, Wanted, Extra)) {
@@ -137,6 +137,13 @@ Ext2FlushFiles(
         ExAcquireResourceExclusiveLite(
             &Fcb->MainResource, TRUE);
         Ext2FlushFile(IrpContext, Fcb, NULL);
+
+        /* don't leave preallocated blocks marked in the bitmaps on disk */
+        if (Fcb->Inode->i_pa_len != 0) {
+            ExAcquireResourceExclusiveLite(&Fcb->PagingIoResource, TRUE);
+            ext4_discard_preallocations(IrpContext, Fcb->Inode);
+            ExReleaseResourceLite(&Fcb->PagingIoResource);
+        }
         ExReleaseResourceLite(&Fcb->MainResource);
     }
 
@@ -1010,6 +1010,12 @@ ext2_init_linux()
         goto errorout;
     }
 
+    rc = ext4_init_es();
+    if (rc != 0) {
+        ext2_destroy_bh();
+        goto errorout;
+    }
+
 errorout:
 
     return rc;
@@ -1018,5 +1024,6 @@ errorout:
 void
 ext2_destroy_linux()
 {
+    ext4_exit_es();
     ext2_destroy_bh();
 }
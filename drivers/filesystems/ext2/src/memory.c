@@ -1458,6 +1458,7 @@ Ext2AllocateMcb (
 
     Mcb->Inode.i_priv = (PVOID)Mcb;
     Mcb->Inode.i_sb = &Vcb->sb;
+    ext4_es_init_tree(&Mcb->Inode.i_es_tree);
 
     /* initialize Mcb names */
     if (FileName) {
@@ -1568,6 +1569,10 @@ Ext2FreeMcb (IN PEXT2_VCB Vcb, IN PEXT2_MCB Mcb)
     }
     FsRtlUninitializeLargeMcb(&(Mcb->MetaExts));
     ClearLongFlag(Mcb->Flags, MCB_ZONE_INITED);
+    ext4_es_remove_extent(&Mcb->Inode, 0, EXT_MAX_BLOCKS);
+
+    /* preallocated blocks are given back by the last close */
+    ASSERT(Mcb->Inode.i_pa_len == 0);
 
     if (Mcb->ShortName.Buffer) {
         DEC_MEM_COUNT(PS_MCB_NAME, Mcb->ShortName.Buffer,
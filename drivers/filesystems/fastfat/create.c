@@ -5148,6 +5148,12 @@ Return Value:
                             TRUE,
                             NULL );
 
+        FatInsertDirentIndex( ParentDcb,
+                              DirentByteOffset,
+                              ShortDirentByteOffset,
+                              ShortDirent,
+                              CreateLfn ? UnicodeName : NULL );
+
         //
         //  If the dirent crossed pages, we have to do some real gross stuff.
         //
@@ -5950,6 +5956,12 @@ Return Value:
                             TRUE,
                             (HaveTunneledInformation ? &TunneledCreationTime : NULL) );
 
+        FatInsertDirentIndex( ParentDcb,
+                              DirentByteOffset,
+                              ShortDirentByteOffset,
+                              ShortDirent,
+                              CreateLfn ? RealUnicodeName : NULL );
+
         //
         //  If the dirent crossed pages, we have to do some real gross stuff.
         //
@@ -146,6 +146,16 @@ if ((VBO) >= (DCB)->Header.AllocationSize.LowPart) {              \
     *(DIRENT) = (PVOID)((PUCHAR)*(DIRENT) + ((VBO) % PAGE_SIZE)); \
 }
 
+//
+//  Directories at least this large get a name index on their first lookup,
+//  smaller ones are cheap enough to walk.  The index gets one hash bucket
+//  for every four dirents the directory can hold, within these bounds.
+//
+
+#define FAT_DIRENT_INDEX_THRESHOLD       (32 * 1024)
+#define FAT_DIRENT_INDEX_MIN_BUCKETS     (256)
+#define FAT_DIRENT_INDEX_MAX_BUCKETS     (16384)
+
 //
 //  Internal support routines
 //
@@ -155,6 +165,49 @@ FatComputeLfnChecksum (
     PDIRENT Dirent
     );
 
+ULONG
+FatHashShortName (
+    IN PUCHAR ShortName
+    );
+
+ULONG
+FatHashLongName (
+    IN PUNICODE_STRING LongName
+    );
+
+BOOLEAN
+FatAddDirentIndexEntry (
+    IN PDIRENT_INDEX Index,
+    IN VBO LfnOffset,
+    IN VBO DirentOffset,
+    IN ULONG ShortHash,
+    IN BOOLEAN HasLfn,
+    IN ULONG LongHash
+    );
+
+VOID
+FatRemoveDirentIndex (
+    IN PDCB Dcb,
+    IN VBO FirstOffset,
+    IN VBO LastOffset
+    );
+
+_Requires_lock_held_(_Global_critical_region_)
+VOID
+FatBuildDirentIndex (
+    IN PIRP_CONTEXT IrpContext,
+    IN PDCB Dcb
+    );
+
+_Requires_lock_held_(_Global_critical_region_)
+VBO
+FatLookupDirentIndex (
+    IN PIRP_CONTEXT IrpContext,
+    IN PDCB Dcb,
+    IN PCCB Ccb,
+    IN BOOLEAN LongNames
+    );
+
 _Requires_lock_held_(_Global_critical_region_)
 VOID
 FatRescanDirectory (
@@ -172,19 +225,27 @@ FatDefragDirectory (
 
 
 #ifdef ALLOC_PRAGMA
+#pragma alloc_text(PAGE, FatAddDirentIndexEntry)
+#pragma alloc_text(PAGE, FatBuildDirentIndex)
 #pragma alloc_text(PAGE, FatComputeLfnChecksum)
 #pragma alloc_text(PAGE, FatConstructDirent)
 #pragma alloc_text(PAGE, FatConstructLabelDirent)
 #pragma alloc_text(PAGE, FatCreateNewDirent)
 #pragma alloc_text(PAGE, FatDefragDirectory)
 #pragma alloc_text(PAGE, FatDeleteDirent)
+#pragma alloc_text(PAGE, FatFreeDirentIndex)
 #pragma alloc_text(PAGE, FatGetDirentFromFcbOrDcb)
+#pragma alloc_text(PAGE, FatHashLongName)
+#pragma alloc_text(PAGE, FatHashShortName)
 #pragma alloc_text(PAGE, FatInitializeDirectoryDirent)
+#pragma alloc_text(PAGE, FatInsertDirentIndex)
 #pragma alloc_text(PAGE, FatIsDirectoryEmpty)
 #pragma alloc_text(PAGE, FatLfnDirentExists)
 #pragma alloc_text(PAGE, FatLocateDirent)
 #pragma alloc_text(PAGE, FatLocateSimpleOemDirent)
 #pragma alloc_text(PAGE, FatLocateVolumeLabel)
+#pragma alloc_text(PAGE, FatLookupDirentIndex)
+#pragma alloc_text(PAGE, FatRemoveDirentIndex)
 #pragma alloc_text(PAGE, FatRescanDirectory)
 #pragma alloc_text(PAGE, FatSetFileSizeInDirent)
 #pragma alloc_text(PAGE, FatSetFileSizeInDirentNoRaise)
@@ -958,6 +1019,14 @@ Return Value:
                       FcbOrDcb->LfnOffsetWithinDirectory / sizeof(DIRENT),
                       DirentsToDelete );
 
+        //
+        //  And the name is gone from the index.
+        //
+
+        FatRemoveDirentIndex( FcbOrDcb->ParentDcb,
+                              FcbOrDcb->LfnOffsetWithinDirectory,
+                              FcbOrDcb->DirentOffsetWithinDirectory );
+
         //
         //  Now, if the caller specified a DeleteContext, use it.
         //
@@ -1199,6 +1268,25 @@ Return Value:
     UpcasedLfn.MaximumLength = sizeof( LocalLfnBuffer);
     UpcasedLfn.Buffer = LocalLfnBuffer;
 
+    //
+    //  If this is a search for a constant name from the start of the
+    //  directory, the name index (if the directory is large enough to have
+    //  one) can tell us where the first dirent that could match is.  The
+    //  index is only maintained under the exclusive vcb, so that is what
+    //  we must hold to trust it.
+    //
+
+    if ((OffsetToStartSearchFrom == 0) &&
+        !Ccb->ContainsWildCards &&
+        !FlagOn( Ccb->Flags, CCB_FLAG_MATCH_ALL | CCB_FLAG_MATCH_VOLUME_ID ) &&
+        ExIsResourceAcquiredExclusiveLite( &ParentDirectory->Vcb->Resource )) {
+
+        OffsetToStartSearchFrom = FatLookupDirentIndex( IrpContext,
+                                                        ParentDirectory,
+                                                        Ccb,
+                                                        (BOOLEAN)(FatData.ChicagoMode &&
+                                                                  ARGUMENT_PRESENT( LongFileName )) );
+    }
 
     //
     //  If we were given a non-NULL Bcb, compute the new Dirent address
@@ -2914,6 +3002,635 @@ Return Value:
 }
 
 
+VOID
+FatInsertDirentIndex (
+    IN PDCB Dcb,
+    IN VBO LfnOffset,
+    IN VBO DirentOffset,
+    IN PDIRENT Dirent,
+    IN PUNICODE_STRING Lfn OPTIONAL
+    )
+
+/*++
+
+Routine Description:
+
+    This routine enters a freshly constructed dirent in the name index of
+    its directory, if the directory has one.  Whatever the index had for
+    the dirents being reused is dropped first.
+
+    It never fails: if we cannot get the pool for the entry the index is
+    thrown away, since an index missing a name would make lookups miss it.
+
+Arguments:
+
+    Dcb - Supplies the directory the dirent is in.
+
+    LfnOffset - Supplies the offset of the first dirent of the Lfn, or of
+        the dirent itself if there is no Lfn.
+
+    DirentOffset - Supplies the offset of the short dirent.
+
+    Dirent - Supplies the short dirent, its name already filled in.
+
+    Lfn - If specified, supplies the long name written with the dirent.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+    PDIRENT_INDEX Index = Dcb->Specific.Dcb.DirentIndex;
+    BOOLEAN HasLfn;
+
+    PAGED_CODE();
+
+    if (Index == NULL) {
+
+        return;
+    }
+
+    NT_ASSERT( ExIsResourceAcquiredExclusiveLite( &Dcb->Vcb->Resource ));
+
+    FatRemoveDirentIndex( Dcb, LfnOffset, DirentOffset );
+
+    HasLfn = ARGUMENT_PRESENT( Lfn ) && (Lfn->Length != 0);
+
+    if (!FatAddDirentIndexEntry( Index,
+                                 LfnOffset,
+                                 DirentOffset,
+                                 FatHashShortName( &Dirent->FileName[0] ),
+                                 HasLfn,
+                                 HasLfn ? FatHashLongName( Lfn ) : 0 )) {
+
+        FatFreeDirentIndex( Dcb );
+    }
+}
+
+
+VOID
+FatFreeDirentIndex (
+    IN PDCB Dcb
+    )
+
+/*++
+
+Routine Description:
+
+    This routine frees the name index of a directory, if it has one.
+
+Arguments:
+
+    Dcb - Supplies the directory.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+    PDIRENT_INDEX Index = Dcb->Specific.Dcb.DirentIndex;
+    PDIRENT_INDEX_ENTRY Entry;
+    ULONG Bucket;
+
+    PAGED_CODE();
+
+    if (Index == NULL) {
+
+        return;
+    }
+
+    Dcb->Specific.Dcb.DirentIndex = NULL;
+
+    //
+    //  Every entry is on exactly one offset chain.
+    //
+
+    for (Bucket = 0; Bucket < Index->BucketCount; Bucket += 1) {
+
+        while ((Entry = Index->OffsetBuckets[Bucket]) != NULL) {
+
+            Index->OffsetBuckets[Bucket] = Entry->NextOffset;
+            ExFreePoolWithTag( Entry, TAG_DIRENT_INDEX );
+        }
+    }
+
+    ExFreePoolWithTag( Index, TAG_DIRENT_INDEX );
+}
+
+
+//
+//  Internal support routine
+//
+
+ULONG
+FatHashShortName (
+    IN PUCHAR ShortName
+    )
+
+/*++
+
+Routine Description:
+
+    This routine hashes the 11 bytes of a short name exactly as they are
+    stored in the dirent, which is also how FatLocateDirent compares them.
+
+Arguments:
+
+    ShortName - Supplies the 8.3 name.
+
+Return Value:
+
+    The hash.
+
+--*/
+
+{
+    ULONG Hash = 0x811c9dc5;
+    ULONG i;
+
+    PAGED_CODE();
+
+    for (i = 0; i < 11; i++) {
+
+        Hash = (Hash ^ ShortName[i]) * 0x01000193;
+    }
+
+    return Hash;
+}
+
+
+//
+//  Internal support routine
+//
+
+ULONG
+FatHashLongName (
+    IN PUNICODE_STRING LongName
+    )
+
+/*++
+
+Routine Description:
+
+    This routine hashes a long name in upcased form, so that it hashes the
+    same whichever way the name is cased.  Names FsRtlAreNamesEqual finds
+    equal always hash alike.
+
+Arguments:
+
+    LongName - Supplies the name.
+
+Return Value:
+
+    The hash.
+
+--*/
+
+{
+    ULONG Hash = 0x811c9dc5;
+    ULONG i;
+
+    PAGED_CODE();
+
+    for (i = 0; i < LongName->Length / sizeof(WCHAR); i++) {
+
+        Hash = (Hash ^ RtlUpcaseUnicodeChar( LongName->Buffer[i] )) * 0x01000193;
+    }
+
+    return Hash;
+}
+
+
+//
+//  Internal support routine
+//
+
+BOOLEAN
+FatAddDirentIndexEntry (
+    IN PDIRENT_INDEX Index,
+    IN VBO LfnOffset,
+    IN VBO DirentOffset,
+    IN ULONG ShortHash,
+    IN BOOLEAN HasLfn,
+    IN ULONG LongHash
+    )
+
+/*++
+
+Routine Description:
+
+    This routine allocates an index entry and chains it on the hash tables.
+
+Arguments:
+
+    Index - Supplies the index.
+
+    LfnOffset, DirentOffset - Supply where the named dirent lives.
+
+    ShortHash, HasLfn, LongHash - Supply the hashes of its names.
+
+Return Value:
+
+    FALSE if we could not get the pool for it, TRUE otherwise.
+
+--*/
+
+{
+    PDIRENT_INDEX_ENTRY Entry;
+    ULONG Mask = Index->BucketCount - 1;
+
+    PAGED_CODE();
+
+    Entry = ExAllocatePoolWithTag( PagedPool,
+                                   sizeof(DIRENT_INDEX_ENTRY),
+                                   TAG_DIRENT_INDEX );
+
+    if (Entry == NULL) {
+
+        return FALSE;
+    }
+
+    Entry->LfnOffset = LfnOffset;
+    Entry->DirentOffset = DirentOffset;
+    Entry->ShortHash = ShortHash;
+    Entry->LongHash = LongHash;
+    Entry->HasLfn = HasLfn;
+
+    Entry->NextShort = Index->ShortBuckets[ShortHash & Mask];
+    Index->ShortBuckets[ShortHash & Mask] = Entry;
+
+    if (HasLfn) {
+
+        Entry->NextLong = Index->LongBuckets[LongHash & Mask];
+        Index->LongBuckets[LongHash & Mask] = Entry;
+
+    } else {
+
+        Entry->NextLong = NULL;
+    }
+
+    Entry->NextOffset = Index->OffsetBuckets[(DirentOffset / sizeof(DIRENT)) & Mask];
+    Index->OffsetBuckets[(DirentOffset / sizeof(DIRENT)) & Mask] = Entry;
+
+    Index->EntryCount += 1;
+
+    return TRUE;
+}
+
+
+//
+//  Internal support routine
+//
+
+VOID
+FatRemoveDirentIndex (
+    IN PDCB Dcb,
+    IN VBO FirstOffset,
+    IN VBO LastOffset
+    )
+
+/*++
+
+Routine Description:
+
+    This routine drops from the name index of a directory every name whose
+    short dirent lies in the given range.
+
+Arguments:
+
+    Dcb - Supplies the directory.
+
+    FirstOffset - Supplies the offset of the first dirent of the range.
+
+    LastOffset - Supplies the offset of the last dirent of the range.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+    PDIRENT_INDEX Index = Dcb->Specific.Dcb.DirentIndex;
+    PDIRENT_INDEX_ENTRY Entry;
+    PDIRENT_INDEX_ENTRY *Link;
+    PDIRENT_INDEX_ENTRY *OtherLink;
+    ULONG Mask;
+    VBO Offset;
+
+    PAGED_CODE();
+
+    if (Index == NULL) {
+
+        return;
+    }
+
+    Mask = Index->BucketCount - 1;
+
+    for (Offset = FirstOffset; Offset <= LastOffset; Offset += sizeof(DIRENT)) {
+
+        Link = &Index->OffsetBuckets[(Offset / sizeof(DIRENT)) & Mask];
+
+        while ((Entry = *Link) != NULL) {
+
+            if (Entry->DirentOffset != Offset) {
+
+                Link = &Entry->NextOffset;
+                continue;
+            }
+
+            *Link = Entry->NextOffset;
+
+            //
+            //  Unchain it from the name tables as well.
+            //
+
+            for (OtherLink = &Index->ShortBuckets[Entry->ShortHash & Mask];
+                 *OtherLink != Entry;
+                 OtherLink = &(*OtherLink)->NextShort) {
+
+                NOTHING;
+            }
+
+            *OtherLink = Entry->NextShort;
+
+            if (Entry->HasLfn) {
+
+                for (OtherLink = &Index->LongBuckets[Entry->LongHash & Mask];
+                     *OtherLink != Entry;
+                     OtherLink = &(*OtherLink)->NextLong) {
+
+                    NOTHING;
+                }
+
+                *OtherLink = Entry->NextLong;
+            }
+
+            Index->EntryCount -= 1;
+            ExFreePoolWithTag( Entry, TAG_DIRENT_INDEX );
+        }
+    }
+}
+
+
+//
+//  Internal support routine
+//
+
+_Requires_lock_held_(_Global_critical_region_)
+VOID
+FatBuildDirentIndex (
+    IN PIRP_CONTEXT IrpContext,
+    IN PDCB Dcb
+    )
+
+/*++
+
+Routine Description:
+
+    This routine builds the name index of a directory by walking all of its
+    dirents once.  If the walk fails or we run out of pool, the directory
+    is simply left without an index.
+
+Arguments:
+
+    Dcb - Supplies the directory, its vcb held exclusive.
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+    PDIRENT_INDEX Index;
+    ULONG BucketCount;
+    ULONG Dirents;
+
+    CCB Ccb;
+    PDIRENT Dirent = NULL;
+    PBCB Bcb = NULL;
+    VBO ByteOffset = 0;
+    VBO QueryOffset = 0;
+    BOOLEAN Built = FALSE;
+
+    UNICODE_STRING Lfn;
+    WCHAR LocalLfnBuffer[32];
+
+    PAGED_CODE();
+
+    DebugTrace(+1, Dbg, "FatBuildDirentIndex\n", 0);
+    DebugTrace( 0, Dbg, "  Dcb = %p\n", Dcb);
+
+    //
+    //  Size the tables on what the directory can hold right now.  A full
+    //  FAT directory has 65536 dirents, so the largest table never averages
+    //  more than four entries a chain.
+    //
+
+    Dirents = Dcb->Header.AllocationSize.LowPart / sizeof(DIRENT);
+
+    for (BucketCount = FAT_DIRENT_INDEX_MIN_BUCKETS;
+         (BucketCount < Dirents / 4) && (BucketCount < FAT_DIRENT_INDEX_MAX_BUCKETS);
+         BucketCount <<= 1) {
+
+        NOTHING;
+    }
+
+    Index = ExAllocatePoolWithTag( PagedPool,
+                                   sizeof(DIRENT_INDEX) + 3 * BucketCount * sizeof(PDIRENT_INDEX_ENTRY),
+                                   TAG_DIRENT_INDEX );
+
+    if (Index == NULL) {
+
+        DebugTrace(-1, Dbg, "FatBuildDirentIndex -> no pool\n", 0);
+        return;
+    }
+
+    RtlZeroMemory( Index, sizeof(DIRENT_INDEX) + 3 * BucketCount * sizeof(PDIRENT_INDEX_ENTRY) );
+
+    Index->BucketCount = BucketCount;
+    Index->ShortBuckets = (PDIRENT_INDEX_ENTRY *)(Index + 1);
+    Index->LongBuckets = Index->ShortBuckets + BucketCount;
+    Index->OffsetBuckets = Index->LongBuckets + BucketCount;
+
+    Dcb->Specific.Dcb.DirentIndex = Index;
+
+    RtlZeroMemory( &Ccb, sizeof(CCB) );
+    Ccb.Flags = CCB_FLAG_MATCH_ALL;
+
+    Lfn.Length = 0;
+    Lfn.MaximumLength = sizeof(LocalLfnBuffer);
+    Lfn.Buffer = LocalLfnBuffer;
+
+    _SEH2_TRY {
+
+        while (TRUE) {
+
+            FatLocateDirent( IrpContext,
+                             Dcb,
+                             &Ccb,
+                             QueryOffset,
+                             NULL,
+                             &Dirent,
+                             &Bcb,
+                             &ByteOffset,
+                             NULL,
+                             &Lfn,
+                             NULL );
+
+            if (Dirent == NULL) {
+
+                Built = TRUE;
+                break;
+            }
+
+            //
+            //  A search that starts right after the previous named dirent
+            //  sees this Lfn exactly as a walk from the start of the
+            //  directory would, so that is where we say it begins.
+            //
+
+            if (!FatAddDirentIndexEntry( Index,
+                                         (Lfn.Length != 0) ? QueryOffset : ByteOffset,
+                                         ByteOffset,
+                                         FatHashShortName( &Dirent->FileName[0] ),
+                                         (BOOLEAN)(Lfn.Length != 0),
+                                         (Lfn.Length != 0) ? FatHashLongName( &Lfn ) : 0 )) {
+
+                break;
+            }
+
+            QueryOffset = ByteOffset + sizeof(DIRENT);
+        }
+
+    } _SEH2_FINALLY {
+
+        FatUnpinBcb( IrpContext, Bcb );
+
+        FatFreeStringBuffer( &Lfn );
+
+        if (!Built) {
+
+            FatFreeDirentIndex( Dcb );
+        }
+    } _SEH2_END;
+
+    DebugTrace(-1, Dbg, "FatBuildDirentIndex -> %08lx entries\n", Built ? Index->EntryCount : 0);
+}
+
+
+//
+//  Internal support routine
+//
+
+_Requires_lock_held_(_Global_critical_region_)
+VBO
+FatLookupDirentIndex (
+    IN PIRP_CONTEXT IrpContext,
+    IN PDCB Dcb,
+    IN PCCB Ccb,
+    IN BOOLEAN LongNames
+    )
+
+/*++
+
+Routine Description:
+
+    This routine uses the name index of a directory to find where a search
+    for the constant name in the Ccb has to start, building the index first
+    if the directory is large enough to want one.
+
+Arguments:
+
+    Dcb - Supplies the directory, its vcb held exclusive.
+
+    Ccb - Supplies the constant name being looked for.
+
+    LongNames - Tells whether the search will also compare long names.
+
+Return Value:
+
+    The offset of the first dirent that could match, the end of the
+    directory if none can, or zero if there is no index to go by.
+
+--*/
+
+{
+    PDIRENT_INDEX Index;
+    PDIRENT_INDEX_ENTRY Entry;
+    VBO StartOffset;
+    ULONG Hash;
+
+    PAGED_CODE();
+
+    //
+    //  Without a name to go by there is nothing to look up.
+    //
+
+    if (FlagOn( Ccb->Flags, CCB_FLAG_SKIP_SHORT_NAME_COMPARE ) &&
+        (!LongNames || (Ccb->UnicodeQueryTemplate.Length == 0))) {
+
+        return 0;
+    }
+
+    if (Dcb->Specific.Dcb.DirentIndex == NULL) {
+
+        if ((Dcb->Header.AllocationSize.QuadPart == FCB_LOOKUP_ALLOCATIONSIZE_HINT) ||
+            (Dcb->Header.AllocationSize.LowPart < FAT_DIRENT_INDEX_THRESHOLD)) {
+
+            return 0;
+        }
+
+        FatBuildDirentIndex( IrpContext, Dcb );
+
+        if (Dcb->Specific.Dcb.DirentIndex == NULL) {
+
+            return 0;
+        }
+    }
+
+    Index = Dcb->Specific.Dcb.DirentIndex;
+    StartOffset = Dcb->Header.AllocationSize.LowPart;
+
+    if (!FlagOn( Ccb->Flags, CCB_FLAG_SKIP_SHORT_NAME_COMPARE )) {
+
+        Hash = FatHashShortName( &Ccb->OemQueryTemplate.Constant[0] );
+
+        for (Entry = Index->ShortBuckets[Hash & (Index->BucketCount - 1)];
+             Entry != NULL;
+             Entry = Entry->NextShort) {
+
+            if ((Entry->ShortHash == Hash) && (Entry->LfnOffset < StartOffset)) {
+
+                StartOffset = Entry->LfnOffset;
+            }
+        }
+    }
+
+    if (LongNames && (Ccb->UnicodeQueryTemplate.Length != 0)) {
+
+        Hash = FatHashLongName( &Ccb->UnicodeQueryTemplate );
+
+        for (Entry = Index->LongBuckets[Hash & (Index->BucketCount - 1)];
+             Entry != NULL;
+             Entry = Entry->NextLong) {
+
+            if ((Entry->LongHash == Hash) && (Entry->LfnOffset < StartOffset)) {
+
+                StartOffset = Entry->LfnOffset;
+            }
+        }
+    }
+
+    return StartOffset;
+}
+
+
 
 #if 0 // It turns out Win95 is still creating short names without a ~
 
@@ -3365,6 +4082,13 @@ Return Value:
 
     NT_ASSERT( FatVcbAcquiredExclusive(IrpContext, Dcb->Vcb) );
 
+    //
+    //  Everything is about to move, so drop the name index.  It will be
+    //  rebuilt on the next lookup that wants it.
+    //
+
+    FatFreeDirentIndex( Dcb );
+
     //
     //  We will only attempt this on directories less than 0x40000 bytes
     //  long (by default on DOS the root directory is only 0x2000 long).
@@ -1116,6 +1116,12 @@ Return Value:
                                     TRUE,
                                     NULL );
 
+                FatInsertDirentIndex( Vcb->EaFcb->ParentDcb,
+                                      Vcb->EaFcb->DirentOffsetWithinDirectory,
+                                      Vcb->EaFcb->DirentOffsetWithinDirectory,
+                                      *EaDirent,
+                                      NULL );
+
                 (*EaDirent)->FileSize = AllocationSize;
 
                 //
@@ -718,6 +718,20 @@ FatDeleteDirent (
     IN BOOLEAN DeleteEa
     );
 
+VOID
+FatInsertDirentIndex (
+    IN PDCB Dcb,
+    IN VBO LfnOffset,
+    IN VBO DirentOffset,
+    IN PDIRENT Dirent,
+    IN PUNICODE_STRING Lfn OPTIONAL
+    );
+
+VOID
+FatFreeDirentIndex (
+    IN PDCB Dcb
+    );
+
 
 _Requires_lock_held_(_Global_critical_region_)
 VOID
@@ -712,6 +712,57 @@ typedef struct _FILE_NAME_NODE {
 } FILE_NAME_NODE;
 typedef FILE_NAME_NODE *PFILE_NAME_NODE;
 
+//
+//  Large directories get an in-memory index of the names they contain so
+//  that FatLocateDirent does not have to walk every dirent looking for a
+//  name that is not in the splay trees.  Each entry describes one named
+//  dirent, and is chained on three hash tables: by short name, by upcased
+//  long name, and by the offset of its short dirent for deletion.
+//
+//  The index only narrows where a search starts, the name is still compared
+//  against the dirent on disk, so an entry that hashes alike or is stale is
+//  harmless.  A named dirent missing from the index is not, so every path
+//  writing a name must update it or the index must be thrown away.
+//
+
+typedef struct _DIRENT_INDEX_ENTRY {
+
+    struct _DIRENT_INDEX_ENTRY *NextShort;
+    struct _DIRENT_INDEX_ENTRY *NextLong;
+    struct _DIRENT_INDEX_ENTRY *NextOffset;
+
+    //
+    //  LfnOffset is where a search has to start to see the whole Lfn, it
+    //  is the same as DirentOffset if there is no Lfn.
+    //
+
+    VBO LfnOffset;
+    VBO DirentOffset;
+
+    ULONG ShortHash;
+    ULONG LongHash;
+    BOOLEAN HasLfn;
+
+} DIRENT_INDEX_ENTRY;
+typedef DIRENT_INDEX_ENTRY *PDIRENT_INDEX_ENTRY;
+
+typedef struct _DIRENT_INDEX {
+
+    //
+    //  BucketCount is a power of two.  The bucket arrays follow this
+    //  header in the same allocation.
+    //
+
+    ULONG BucketCount;
+    ULONG EntryCount;
+
+    PDIRENT_INDEX_ENTRY *ShortBuckets;
+    PDIRENT_INDEX_ENTRY *LongBuckets;
+    PDIRENT_INDEX_ENTRY *OffsetBuckets;
+
+} DIRENT_INDEX;
+typedef DIRENT_INDEX *PDIRENT_INDEX;
+
 //
 //  This structure contains fields which must be in non-paged pool.
 //
@@ -1047,6 +1098,14 @@ typedef struct _FCB {
 
             RTL_BITMAP FreeDirentBitmap;
 
+            //
+            //  The name index of a large directory, built on the first
+            //  lookup that needs it and only used with the vcb held
+            //  exclusive.  NULL if there is none.
+            //
+
+            PDIRENT_INDEX DirentIndex;
+
             //
             //  Since the FCB specific part of this union is larger, use
             //  the slack here for an initial bitmap buffer.  Currently
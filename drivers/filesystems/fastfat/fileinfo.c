@@ -3658,6 +3658,12 @@ Return Value:
                                 FALSE,
                                 (HaveTunneledInformation ? &TunneledCreationTime : NULL) );
 
+            FatInsertDirentIndex( TargetDcb,
+                                  NewOffset,
+                                  ShortDirentOffset,
+                                  ShortDirent,
+                                  CreateLfn ? &NewNameCopy : NULL );
+
             if (HaveTunneledInformation) {
 
                 //
@@ -2025,6 +2025,12 @@ Return Value:
             ExFreePool(Fcb->Specific.Dcb.FreeDirentBitmap.Buffer);
         }
 
+        //
+        //  And the name index, if the directory was large enough for one.
+        //
+
+        FatFreeDirentIndex( Fcb );
+
 #if (NTDDI_VERSION >= NTDDI_WIN8)
         //
         //  Uninitialize the oplock.
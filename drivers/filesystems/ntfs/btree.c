@@ -511,7 +511,6 @@ CreateBTreeNodeFromIndexNode(PDEVICE_EXTENSION Vcb,
     PB_TREE_KEY CurrentKey;
     NTSTATUS Status;
     ULONGLONG IndexNodeOffset;
-    ULONG BytesRead;
 
     if (IndexAllocationAttributeCtx == NULL)
     {
@@ -557,22 +556,17 @@ CreateBTreeNodeFromIndexNode(PDEVICE_EXTENSION Vcb,
 
     // TODO: Confirm index bitmap has this node marked as in-use
 
-    // Read the node
-    BytesRead = ReadAttribute(Vcb,
-                              IndexAllocationAttributeCtx,
-                              IndexNodeOffset,
-                              (PCHAR)NodeBuffer,
-                              IndexBufferSize);
-
-    ASSERT(BytesRead == IndexBufferSize);
-    NT_ASSERT(NodeBuffer->Ntfs.Type == NRH_INDX_TYPE);
-    NT_ASSERT(NodeBuffer->VCN == *VCN);
-
-    // Apply the fixup array to the node buffer
-    Status = FixupUpdateSequenceArray(Vcb, &NodeBuffer->Ntfs);
+    // Read the node and apply its fixup array
+    Status = ReadIndexBuffer(Vcb,
+                             IndexAllocationAttributeCtx,
+                             IndexNodeOffset,
+                             NodeBuffer,
+                             IndexBufferSize);
+    NT_ASSERT(!NT_SUCCESS(Status) || NodeBuffer->Ntfs.Type == NRH_INDX_TYPE);
+    NT_ASSERT(!NT_SUCCESS(Status) || NodeBuffer->VCN == *VCN);
     if (!NT_SUCCESS(Status))
     {
-        DPRINT1("ERROR: Couldn't apply fixup array to index node buffer!\n");
+        DPRINT1("ERROR: Couldn't read index node buffer!\n");
         ExFreePoolWithTag(NodeBuffer, TAG_NTFS);
         ExFreePoolWithTag(CurrentKey, TAG_NTFS);
         ExFreePoolWithTag(NewNode, TAG_NTFS);
@@ -0,0 +1,369 @@
+/*
+ * PROJECT:     ReactOS NTFS filesystem driver
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Cache of fixed-up file records and index buffers
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+/*
+ * Every path lookup reads the file record of each directory on the way and
+ * the index buffers below its index root, then applies the fixups. This keeps
+ * the fixed-up copies of the most recently used ones, per volume, so that the
+ * next lookup of the same path does not touch the disk.
+ *
+ * Entries are reference counted: the cache holds one reference while an entry
+ * is linked, and readers take one while they copy the data out, without the
+ * lock held. Writers replace or drop entries, they never modify them in place.
+ * Every write also bumps the cache generation, so that a reader which missed
+ * before the write does not insert what it read from the disk afterwards.
+ */
+
+/* INCLUDES *****************************************************************/
+
+#include "ntfs.h"
+
+#define NDEBUG
+#include <debug.h>
+
+/* FUNCTIONS ****************************************************************/
+
+static
+ULONG
+NtfsRecordCacheHash(ULONGLONG MftIndex,
+                    ULONGLONG Offset)
+{
+    ULONGLONG Key = MftIndex ^ (Offset * 0x9E3779B97F4A7C15ULL);
+
+    return (ULONG)(Key ^ (Key >> 32)) % NTFS_RECORD_CACHE_BUCKETS;
+}
+
+static
+VOID
+NtfsDereferenceCachedRecord(PNTFS_CACHED_RECORD Entry)
+{
+    if (InterlockedDecrement(&Entry->RefCount) == 0)
+    {
+        ASSERT(!Entry->Linked);
+        ExFreePoolWithTag(Entry, TAG_REC_CACHE);
+    }
+}
+
+/* Must be called with the cache lock held, the caller drops the reference */
+static
+VOID
+NtfsUnlinkCachedRecord(PNTFS_RECORD_CACHE Cache,
+                       PNTFS_CACHED_RECORD Entry)
+{
+    ASSERT(Entry->Linked);
+
+    RemoveEntryList(&Entry->HashEntry);
+    RemoveEntryList(&Entry->LruEntry);
+    Entry->Linked = FALSE;
+
+    if (Entry->Offset == NTFS_CACHE_FILE_RECORD)
+        Cache->RecordCount--;
+    else
+        Cache->IndexCount--;
+}
+
+static
+PNTFS_CACHED_RECORD
+NtfsFindCachedRecord(PNTFS_RECORD_CACHE Cache,
+                     ULONGLONG MftIndex,
+                     ULONGLONG Offset)
+{
+    PLIST_ENTRY Bucket, ListEntry;
+    PNTFS_CACHED_RECORD Entry;
+
+    Bucket = &Cache->Buckets[NtfsRecordCacheHash(MftIndex, Offset)];
+    for (ListEntry = Bucket->Flink; ListEntry != Bucket; ListEntry = ListEntry->Flink)
+    {
+        Entry = CONTAINING_RECORD(ListEntry, NTFS_CACHED_RECORD, HashEntry);
+        if (Entry->MftIndex == MftIndex && Entry->Offset == Offset)
+            return Entry;
+    }
+
+    return NULL;
+}
+
+VOID
+NtfsInitializeRecordCache(PDEVICE_EXTENSION Vcb)
+{
+    PNTFS_RECORD_CACHE Cache = &Vcb->RecordCache;
+    ULONG i;
+
+    RtlZeroMemory(Cache, sizeof(NTFS_RECORD_CACHE));
+    KeInitializeSpinLock(&Cache->Lock);
+    for (i = 0; i < NTFS_RECORD_CACHE_BUCKETS; i++)
+        InitializeListHead(&Cache->Buckets[i]);
+    InitializeListHead(&Cache->RecordLru);
+    InitializeListHead(&Cache->IndexLru);
+}
+
+VOID
+NtfsPurgeRecordCache(PDEVICE_EXTENSION Vcb)
+{
+    PNTFS_RECORD_CACHE Cache = &Vcb->RecordCache;
+    PNTFS_CACHED_RECORD Entry;
+    LIST_ENTRY FreeList;
+    KIRQL OldIrql;
+    ULONG i;
+
+    DPRINT("NtfsPurgeRecordCache(%p): %lu hits, %lu misses\n", Vcb, Cache->Hits, Cache->Misses);
+
+    InitializeListHead(&FreeList);
+
+    KeAcquireSpinLock(&Cache->Lock, &OldIrql);
+    Cache->Generation++;
+    for (i = 0; i < NTFS_RECORD_CACHE_BUCKETS; i++)
+    {
+        while (!IsListEmpty(&Cache->Buckets[i]))
+        {
+            Entry = CONTAINING_RECORD(Cache->Buckets[i].Flink, NTFS_CACHED_RECORD, HashEntry);
+            NtfsUnlinkCachedRecord(Cache, Entry);
+            InsertTailList(&FreeList, &Entry->LruEntry);
+        }
+    }
+    KeReleaseSpinLock(&Cache->Lock, OldIrql);
+
+    while (!IsListEmpty(&FreeList))
+    {
+        Entry = CONTAINING_RECORD(RemoveHeadList(&FreeList), NTFS_CACHED_RECORD, LruEntry);
+        NtfsDereferenceCachedRecord(Entry);
+    }
+}
+
+/**
+* @name NtfsLookupCachedRecord
+* @implemented
+*
+* Copies a cached file record or index buffer to the caller's buffer.
+*
+* @param Vcb
+* Pointer to the DEVICE_EXTENSION of the volume.
+*
+* @param MftIndex
+* Index in the master file table of the file record, or of the record holding
+* the index allocation attribute.
+*
+* @param Offset
+* NTFS_CACHE_FILE_RECORD for a file record, otherwise the offset of the index
+* buffer in the index allocation.
+*
+* @param Buffer
+* Receives the fixed-up record.
+*
+* @param Length
+* Size of the record.
+*
+* @param Generation
+* Receives the cache generation on a miss, to be given to NtfsInsertCachedRecord().
+*
+* @return
+* TRUE if the record was found in the cache, FALSE otherwise.
+*
+*/
+BOOLEAN
+NtfsLookupCachedRecord(PDEVICE_EXTENSION Vcb,
+                       ULONGLONG MftIndex,
+                       ULONGLONG Offset,
+                       PVOID Buffer,
+                       ULONG Length,
+                       PULONG Generation)
+{
+    PNTFS_RECORD_CACHE Cache = &Vcb->RecordCache;
+    PNTFS_CACHED_RECORD Entry;
+    KIRQL OldIrql;
+
+    KeAcquireSpinLock(&Cache->Lock, &OldIrql);
+    Entry = NtfsFindCachedRecord(Cache, MftIndex, Offset);
+    if (Entry == NULL || Entry->Length != Length)
+    {
+        Cache->Misses++;
+        *Generation = Cache->Generation;
+        KeReleaseSpinLock(&Cache->Lock, OldIrql);
+        return FALSE;
+    }
+
+    /* Move it to the back of its LRU list and keep it alive while we copy it */
+    RemoveEntryList(&Entry->LruEntry);
+    if (Offset == NTFS_CACHE_FILE_RECORD)
+        InsertTailList(&Cache->RecordLru, &Entry->LruEntry);
+    else
+        InsertTailList(&Cache->IndexLru, &Entry->LruEntry);
+    InterlockedIncrement(&Entry->RefCount);
+    Cache->Hits++;
+    KeReleaseSpinLock(&Cache->Lock, OldIrql);
+
+    RtlCopyMemory(Buffer, Entry->Data, Length);
+    NtfsDereferenceCachedRecord(Entry);
+
+    return TRUE;
+}
+
+/**
+* @name NtfsInsertCachedRecord
+* @implemented
+*
+* Adds a file record or an index buffer read from the disk to the cache, or
+* replaces the cached copy with one that was just written.
+*
+* @param Generation
+* Pointer to the generation returned by NtfsLookupCachedRecord() for a record
+* read from the disk, NULL for a record that was just written. A record read
+* before a write that happened since the lookup is not inserted.
+*
+* @remarks
+* Failing to allocate an entry is not an error, the record is just not cached.
+* Any existing entry for the same record is dropped in that case.
+*
+*/
+VOID
+NtfsInsertCachedRecord(PDEVICE_EXTENSION Vcb,
+                       ULONGLONG MftIndex,
+                       ULONGLONG Offset,
+                       PVOID Buffer,
+                       ULONG Length,
+                       PULONG Generation)
+{
+    PNTFS_RECORD_CACHE Cache = &Vcb->RecordCache;
+    PNTFS_CACHED_RECORD Entry, OldEntry, Victim = NULL;
+    PLIST_ENTRY Lru;
+    PULONG Count;
+    ULONG Limit;
+    KIRQL OldIrql;
+
+    Entry = ExAllocatePoolWithTag(NonPagedPool,
+                                  FIELD_OFFSET(NTFS_CACHED_RECORD, Data[Length]),
+                                  TAG_REC_CACHE);
+    if (Entry != NULL)
+    {
+        Entry->MftIndex = MftIndex;
+        Entry->Offset = Offset;
+        Entry->Length = Length;
+        Entry->RefCount = 1;
+        Entry->Linked = TRUE;
+        RtlCopyMemory(Entry->Data, Buffer, Length);
+    }
+
+    if (Offset == NTFS_CACHE_FILE_RECORD)
+    {
+        Lru = &Cache->RecordLru;
+        Count = &Cache->RecordCount;
+        Limit = NTFS_CACHED_FILE_RECORDS;
+    }
+    else
+    {
+        Lru = &Cache->IndexLru;
+        Count = &Cache->IndexCount;
+        Limit = NTFS_CACHED_INDEX_BUFFERS;
+    }
+
+    KeAcquireSpinLock(&Cache->Lock, &OldIrql);
+
+    /* Someone wrote to the volume since this was read from the disk */
+    if (Generation != NULL && *Generation != Cache->Generation)
+    {
+        KeReleaseSpinLock(&Cache->Lock, OldIrql);
+        if (Entry != NULL)
+            ExFreePoolWithTag(Entry, TAG_REC_CACHE);
+        return;
+    }
+
+    if (Generation == NULL)
+        Cache->Generation++;
+
+    OldEntry = NtfsFindCachedRecord(Cache, MftIndex, Offset);
+    if (OldEntry != NULL)
+    {
+        NtfsUnlinkCachedRecord(Cache, OldEntry);
+    }
+    else if (Entry != NULL && *Count >= Limit)
+    {
+        /* Make room by dropping the least recently used one */
+        Victim = CONTAINING_RECORD(Lru->Flink, NTFS_CACHED_RECORD, LruEntry);
+        NtfsUnlinkCachedRecord(Cache, Victim);
+    }
+
+    if (Entry != NULL)
+    {
+        InsertHeadList(&Cache->Buckets[NtfsRecordCacheHash(MftIndex, Offset)], &Entry->HashEntry);
+        InsertTailList(Lru, &Entry->LruEntry);
+        (*Count)++;
+    }
+
+    KeReleaseSpinLock(&Cache->Lock, OldIrql);
+
+    if (OldEntry != NULL)
+        NtfsDereferenceCachedRecord(OldEntry);
+    if (Victim != NULL)
+        NtfsDereferenceCachedRecord(Victim);
+}
+
+/**
+* @name NtfsInvalidateCachedRecords
+* @implemented
+*
+* Drops a cached file record, and the cached index buffers of the index
+* allocation it holds.
+*
+* @param Vcb
+* Pointer to the DEVICE_EXTENSION of the volume.
+*
+* @param MftIndex
+* Index in the master file table of the file record.
+*
+* @param FileRecord
+* TRUE to drop the file record itself too, FALSE to only drop the index buffers.
+*
+*/
+VOID
+NtfsInvalidateCachedRecords(PDEVICE_EXTENSION Vcb,
+                            ULONGLONG MftIndex,
+                            BOOLEAN FileRecord)
+{
+    PNTFS_RECORD_CACHE Cache = &Vcb->RecordCache;
+    PNTFS_CACHED_RECORD Entry;
+    PLIST_ENTRY ListEntry;
+    LIST_ENTRY FreeList;
+    KIRQL OldIrql;
+
+    InitializeListHead(&FreeList);
+
+    KeAcquireSpinLock(&Cache->Lock, &OldIrql);
+    Cache->Generation++;
+
+    if (FileRecord)
+    {
+        Entry = NtfsFindCachedRecord(Cache, MftIndex, NTFS_CACHE_FILE_RECORD);
+        if (Entry != NULL)
+        {
+            NtfsUnlinkCachedRecord(Cache, Entry);
+            InsertTailList(&FreeList, &Entry->LruEntry);
+        }
+    }
+
+    /* Index buffers are hashed by offset too, walk the whole (short) list */
+    ListEntry = Cache->IndexLru.Flink;
+    while (ListEntry != &Cache->IndexLru)
+    {
+        Entry = CONTAINING_RECORD(ListEntry, NTFS_CACHED_RECORD, LruEntry);
+        ListEntry = ListEntry->Flink;
+
+        if (Entry->MftIndex == MftIndex)
+        {
+            NtfsUnlinkCachedRecord(Cache, Entry);
+            InsertTailList(&FreeList, &Entry->LruEntry);
+        }
+    }
+
+    KeReleaseSpinLock(&Cache->Lock, OldIrql);
+
+    while (!IsListEmpty(&FreeList))
+    {
+        Entry = CONTAINING_RECORD(RemoveHeadList(&FreeList), NTFS_CACHED_RECORD, LruEntry);
+        NtfsDereferenceCachedRecord(Entry);
+    }
+}
+
+/* EOF */
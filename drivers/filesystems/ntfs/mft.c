@@ -1624,6 +1624,10 @@ Cleanup:
     if (Context->pRecord->IsNonResident)
         ExFreePoolWithTag(TempBuffer, TAG_NTFS);
 
+    // drop the cached copies of the index buffers we may have overwritten
+    if (Context->pRecord->Type == AttributeIndexAllocation)
+        NtfsInvalidateCachedRecords(Vcb, Context->FileMFTIndex, FALSE);
+
     return Status;
 }
 
@@ -1633,9 +1637,15 @@ ReadFileRecord(PDEVICE_EXTENSION Vcb,
                PFILE_RECORD_HEADER file)
 {
     ULONGLONG BytesRead;
+    ULONG Generation;
+    NTSTATUS Status;
 
     DPRINT("ReadFileRecord(%p, %I64x, %p)\n", Vcb, index, file);
 
+    /* Path lookups read the same directory records over and over */
+    if (NtfsLookupCachedRecord(Vcb, index, NTFS_CACHE_FILE_RECORD, file, Vcb->NtfsInfo.BytesPerFileRecord, &Generation))
+        return STATUS_SUCCESS;
+
     BytesRead = ReadAttribute(Vcb, Vcb->MFTContext, index * Vcb->NtfsInfo.BytesPerFileRecord, (PCHAR)file, Vcb->NtfsInfo.BytesPerFileRecord);
     if (BytesRead != Vcb->NtfsInfo.BytesPerFileRecord)
     {
@@ -1645,7 +1655,68 @@ ReadFileRecord(PDEVICE_EXTENSION Vcb,
 
     /* Apply update sequence array fixups. */
     DPRINT("Sequence number: %u\n", file->SequenceNumber);
-    return FixupUpdateSequenceArray(Vcb, &file->Ntfs);
+    Status = FixupUpdateSequenceArray(Vcb, &file->Ntfs);
+    if (NT_SUCCESS(Status))
+        NtfsInsertCachedRecord(Vcb, index, NTFS_CACHE_FILE_RECORD, file, Vcb->NtfsInfo.BytesPerFileRecord, &Generation);
+
+    return Status;
+}
+
+/**
+* @name ReadIndexBuffer
+* @implemented
+*
+* Reads an index buffer from an index allocation and applies its fixups,
+* going through the record cache.
+*
+* @param Vcb
+* Pointer to the DEVICE_EXTENSION of the volume.
+*
+* @param IndexAllocationContext
+* Pointer to the context of the index allocation attribute.
+*
+* @param Offset
+* Offset of the index buffer in the index allocation.
+*
+* @param IndexBuffer
+* Receives the fixed-up index buffer.
+*
+* @param IndexBlockSize
+* Size of an index buffer.
+*
+* @return
+* STATUS_SUCCESS on success, STATUS_PARTIAL_COPY if the index buffer couldn't
+* be read, or an error from FixupUpdateSequenceArray().
+*
+*/
+NTSTATUS
+ReadIndexBuffer(PDEVICE_EXTENSION Vcb,
+                PNTFS_ATTR_CONTEXT IndexAllocationContext,
+                ULONGLONG Offset,
+                PINDEX_BUFFER IndexBuffer,
+                ULONG IndexBlockSize)
+{
+    ULONG BytesRead;
+    ULONG Generation;
+    NTSTATUS Status;
+
+    DPRINT("ReadIndexBuffer(%p, %p, %I64u, %p, %lu)\n", Vcb, IndexAllocationContext, Offset, IndexBuffer, IndexBlockSize);
+
+    if (NtfsLookupCachedRecord(Vcb, IndexAllocationContext->FileMFTIndex, Offset, IndexBuffer, IndexBlockSize, &Generation))
+        return STATUS_SUCCESS;
+
+    BytesRead = ReadAttribute(Vcb, IndexAllocationContext, Offset, (PCHAR)IndexBuffer, IndexBlockSize);
+    if (BytesRead != IndexBlockSize)
+    {
+        DPRINT1("ReadIndexBuffer failed: %lu read, %lu expected\n", BytesRead, IndexBlockSize);
+        return STATUS_PARTIAL_COPY;
+    }
+
+    Status = FixupUpdateSequenceArray(Vcb, &IndexBuffer->Ntfs);
+    if (NT_SUCCESS(Status))
+        NtfsInsertCachedRecord(Vcb, IndexAllocationContext->FileMFTIndex, Offset, IndexBuffer, IndexBlockSize, &Generation);
+
+    return Status;
 }
 
 
@@ -1848,8 +1919,7 @@ UpdateIndexEntryFileNameSize(PDEVICE_EXTENSION Vcb,
     Status = STATUS_OBJECT_PATH_NOT_FOUND;
     for (RecordOffset = 0; RecordOffset < IndexAllocationSize; RecordOffset += IndexBlockSize)
     {
-        ReadAttribute(Vcb, IndexAllocationCtx, RecordOffset, IndexRecord, IndexBlockSize);
-        Status = FixupUpdateSequenceArray(Vcb, &((PFILE_RECORD_HEADER)IndexRecord)->Ntfs);
+        Status = ReadIndexBuffer(Vcb, IndexAllocationCtx, RecordOffset, (PINDEX_BUFFER)IndexRecord, IndexBlockSize);
         if (!NT_SUCCESS(Status))
         {
             break;
@@ -1957,6 +2027,11 @@ UpdateFileRecord(PDEVICE_EXTENSION Vcb,
     // remove the fixup array (so the file record pointer can still be used)
     FixupUpdateSequenceArray(Vcb, &FileRecord->Ntfs);
 
+    // the index allocation may have moved or been resized, and the cached copy of the record is stale
+    NtfsInvalidateCachedRecords(Vcb, MftIndex, !NT_SUCCESS(Status));
+    if (NT_SUCCESS(Status))
+        NtfsInsertCachedRecord(Vcb, MftIndex, NTFS_CACHE_FILE_RECORD, FileRecord, Vcb->NtfsInfo.BytesPerFileRecord, NULL);
+
     return Status;
 }
 
@@ -2851,7 +2926,6 @@ BrowseSubNodeIndexEntries(PNTFS_VCB Vcb,
 {
     PINDEX_BUFFER IndexRecord;
     ULONGLONG Offset;
-    ULONG BytesRead;
     PINDEX_ENTRY_ATTRIBUTE FirstEntry;
     PINDEX_ENTRY_ATTRIBUTE LastEntry;
     PINDEX_ENTRY_ATTRIBUTE IndexEntry;
@@ -2894,27 +2968,18 @@ BrowseSubNodeIndexEntries(PNTFS_VCB Vcb,
     // Calculate offset of index record
     Offset = VCN * Vcb->NtfsInfo.BytesPerCluster;
 
-    // Read the index record
-    BytesRead = ReadAttribute(Vcb, IndexAllocationContext, Offset, (PCHAR)IndexRecord, IndexBlockSize);
-    if (BytesRead != IndexBlockSize)
+    // Read the index record and apply its fixup array
+    Status = ReadIndexBuffer(Vcb, IndexAllocationContext, Offset, IndexRecord, IndexBlockSize);
+    if (!NT_SUCCESS(Status))
     {
-        DPRINT1("Unable to read index record!\n");
         ExFreePoolWithTag(IndexRecord, TAG_NTFS);
-        return STATUS_UNSUCCESSFUL;
+        DPRINT1("Unable to read index record!\n");
+        return Status == STATUS_PARTIAL_COPY ? STATUS_UNSUCCESSFUL : Status;
     }
 
     // Assert that we're dealing with an index record here
     ASSERT(IndexRecord->Ntfs.Type == NRH_INDX_TYPE);
 
-    // Apply the fixup array to the index record
-    Status = FixupUpdateSequenceArray(Vcb, &((PFILE_RECORD_HEADER)IndexRecord)->Ntfs);
-    if (!NT_SUCCESS(Status))
-    {
-        ExFreePoolWithTag(IndexRecord, TAG_NTFS);
-        DPRINT1("Failed to apply fixup array!\n");
-        return Status;
-    }
-
     ASSERT(IndexRecord->Header.AllocatedSize + FIELD_OFFSET(INDEX_BUFFER, Header) == IndexBlockSize);
     FirstEntry = (PINDEX_ENTRY_ATTRIBUTE)((ULONG_PTR)&IndexRecord->Header + IndexRecord->Header.FirstEntryOffset);
     LastEntry = (PINDEX_ENTRY_ATTRIBUTE)((ULONG_PTR)&IndexRecord->Header + IndexRecord->Header.TotalSizeOfEntries);
@@ -15,6 +15,7 @@
 #define TAG_IRP_CTXT 'iftN'
 #define TAG_ATT_CTXT 'aftN'
 #define TAG_FILE_REC 'rftN'
+#define TAG_REC_CACHE 'eftN'
 
 #define ROUND_UP(N, S) ((((N) + (S) - 1) / (S)) * (S))
 #define ROUND_DOWN(N, S) ((N) - ((N) % (S)))
@@ -96,6 +97,38 @@ typedef struct
     ULONG Size;
 } NTFSIDENTIFIER, *PNTFSIDENTIFIER;
 
+#define NTFS_RECORD_CACHE_BUCKETS   64
+#define NTFS_CACHED_FILE_RECORDS    256
+#define NTFS_CACHED_INDEX_BUFFERS   64
+
+/* Offset of a cached file record, index buffers use their offset in the allocation */
+#define NTFS_CACHE_FILE_RECORD      ((ULONGLONG)-1)
+
+typedef struct _NTFS_CACHED_RECORD
+{
+    LIST_ENTRY HashEntry;
+    LIST_ENTRY LruEntry;
+    ULONGLONG MftIndex;
+    ULONGLONG Offset;
+    LONG RefCount;
+    BOOLEAN Linked;
+    ULONG Length;
+    UCHAR Data[ANYSIZE_ARRAY];
+} NTFS_CACHED_RECORD, *PNTFS_CACHED_RECORD;
+
+typedef struct _NTFS_RECORD_CACHE
+{
+    KSPIN_LOCK Lock;
+    LIST_ENTRY Buckets[NTFS_RECORD_CACHE_BUCKETS];
+    LIST_ENTRY RecordLru;
+    LIST_ENTRY IndexLru;
+    ULONG RecordCount;
+    ULONG IndexCount;
+    ULONG Generation;
+    ULONG Hits;
+    ULONG Misses;
+} NTFS_RECORD_CACHE, *PNTFS_RECORD_CACHE;
+
 typedef struct
 {
     NTFSIDENTIFIER Identifier;
@@ -117,6 +150,7 @@ typedef struct
     NTFS_INFO NtfsInfo;
 
     NPAGED_LOOKASIDE_LIST FileRecLookasideList;
+    NTFS_RECORD_CACHE RecordCache;
 
     ULONG MftDataOffset;
     ULONG Flags;
@@ -832,6 +866,36 @@ UpdateIndexNode(PDEVICE_EXTENSION DeviceExt,
                 PNTFS_ATTR_CONTEXT IndexAllocationContext,
                 ULONG IndexAllocationOffset);
 
+/* cache.c */
+
+VOID
+NtfsInitializeRecordCache(PDEVICE_EXTENSION Vcb);
+
+VOID
+NtfsPurgeRecordCache(PDEVICE_EXTENSION Vcb);
+
+BOOLEAN
+NtfsLookupCachedRecord(PDEVICE_EXTENSION Vcb,
+                       ULONGLONG MftIndex,
+                       ULONGLONG Offset,
+                       PVOID Buffer,
+                       ULONG Length,
+                       PULONG Generation);
+
+VOID
+NtfsInsertCachedRecord(PDEVICE_EXTENSION Vcb,
+                       ULONGLONG MftIndex,
+                       ULONGLONG Offset,
+                       PVOID Buffer,
+                       ULONG Length,
+                       PULONG Generation);
+
+VOID
+NtfsInvalidateCachedRecords(PDEVICE_EXTENSION Vcb,
+                            ULONGLONG MftIndex,
+                            BOOLEAN FileRecord);
+
+
 /* close.c */
 
 NTSTATUS
@@ -1118,6 +1182,13 @@ ReadFileRecord(PDEVICE_EXTENSION Vcb,
                ULONGLONG index,
                PFILE_RECORD_HEADER file);
 
+NTSTATUS
+ReadIndexBuffer(PDEVICE_EXTENSION Vcb,
+                PNTFS_ATTR_CONTEXT IndexAllocationContext,
+                ULONGLONG Offset,
+                PINDEX_BUFFER IndexBuffer,
+                ULONG IndexBlockSize);
+
 NTSTATUS
 UpdateIndexEntryFileNameSize(PDEVICE_EXTENSION Vcb,
                              PFILE_RECORD_HEADER MftRecord,
@@ -0,0 +1,298 @@
+/*
+ * PROJECT:     ReactOS API tests
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Tests for GetQueuedCompletionStatusEx and completion notification modes
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include "precomp.h"
+
+#ifndef FILE_SKIP_COMPLETION_PORT_ON_SUCCESS
+#define FILE_SKIP_COMPLETION_PORT_ON_SUCCESS 0x1
+#define FILE_SKIP_SET_EVENT_ON_HANDLE        0x2
+#endif
+
+#define BATCH_SIZE      64
+#define BENCH_PACKETS   200000
+#define BENCH_ROUND     1024
+
+typedef
+BOOL
+WINAPI
+FN_GetQueuedCompletionStatusEx(
+    _In_ HANDLE CompletionPort,
+    _Out_writes_to_(ulCount, *ulNumEntriesRemoved) LPOVERLAPPED_ENTRY lpCompletionPortEntries,
+    _In_ ULONG ulCount,
+    _Out_ PULONG ulNumEntriesRemoved,
+    _In_ DWORD dwMilliseconds,
+    _In_ BOOL fAlertable);
+
+typedef
+BOOL
+WINAPI
+FN_SetFileCompletionNotificationModes(
+    _In_ HANDLE FileHandle,
+    _In_ UCHAR Flags);
+
+static FN_GetQueuedCompletionStatusEx *pGetQueuedCompletionStatusEx;
+static FN_SetFileCompletionNotificationModes *pSetFileCompletionNotificationModes;
+static BOOL ApcCalled;
+
+static
+VOID
+CALLBACK
+ApcRoutine(ULONG_PTR Parameter)
+{
+    ApcCalled = TRUE;
+}
+
+static
+VOID
+TestBasic(VOID)
+{
+    OVERLAPPED_ENTRY Entries[BATCH_SIZE];
+    ULONG Removed, i;
+    HANDLE Port;
+    BOOL Ret;
+
+    Port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 0);
+    ok(Port != NULL, "CreateIoCompletionPort failed with %lu\n", GetLastError());
+    if (!Port)
+        return;
+
+    /* No room for anything */
+    SetLastError(0xdeadbeef);
+    Ret = pGetQueuedCompletionStatusEx(Port, Entries, 0, &Removed, 0, FALSE);
+    ok(Ret == FALSE, "Ret = %d\n", Ret);
+    ok_err(ERROR_INVALID_PARAMETER);
+
+    /* Nothing queued */
+    Removed = 0xdeadbeef;
+    SetLastError(0xdeadbeef);
+    Ret = pGetQueuedCompletionStatusEx(Port, Entries, BATCH_SIZE, &Removed, 0, FALSE);
+    ok(Ret == FALSE, "Ret = %d\n", Ret);
+    ok_err(WAIT_TIMEOUT);
+    ok(Removed == 0, "Removed = %lu\n", Removed);
+
+    /* More packets than the batch holds */
+    for (i = 0; i < BATCH_SIZE + 10; i++)
+    {
+        Ret = PostQueuedCompletionStatus(Port, i, 0x1000 + i, (LPOVERLAPPED)(ULONG_PTR)(0x2000 + i));
+        ok(Ret, "PostQueuedCompletionStatus failed with %lu\n", GetLastError());
+    }
+
+    Ret = pGetQueuedCompletionStatusEx(Port, Entries, BATCH_SIZE, &Removed, 0, FALSE);
+    ok(Ret == TRUE, "Ret = %d\n", Ret);
+    ok(Removed == BATCH_SIZE, "Removed = %lu\n", Removed);
+    for (i = 0; i < Removed; i++)
+    {
+        ok(Entries[i].lpCompletionKey == 0x1000 + i, "Entry %lu: key %Ix\n", i, Entries[i].lpCompletionKey);
+        ok(Entries[i].lpOverlapped == (LPOVERLAPPED)(ULONG_PTR)(0x2000 + i),
+           "Entry %lu: overlapped %p\n", i, Entries[i].lpOverlapped);
+        ok(Entries[i].dwNumberOfBytesTransferred == i,
+           "Entry %lu: %lu bytes\n", i, Entries[i].dwNumberOfBytesTransferred);
+        ok(Entries[i].Internal == STATUS_SUCCESS, "Entry %lu: status %Ix\n", i, Entries[i].Internal);
+    }
+
+    /* The rest */
+    Ret = pGetQueuedCompletionStatusEx(Port, Entries, BATCH_SIZE, &Removed, 0, FALSE);
+    ok(Ret == TRUE, "Ret = %d\n", Ret);
+    ok(Removed == 10, "Removed = %lu\n", Removed);
+    ok(Entries[0].lpCompletionKey == 0x1000 + BATCH_SIZE, "Key %Ix\n", Entries[0].lpCompletionKey);
+
+    /* An alertable wait is broken by an APC */
+    ApcCalled = FALSE;
+    Ret = QueueUserAPC(ApcRoutine, GetCurrentThread(), 0);
+    ok(Ret, "QueueUserAPC failed with %lu\n", GetLastError());
+    Removed = 0xdeadbeef;
+    SetLastError(0xdeadbeef);
+    Ret = pGetQueuedCompletionStatusEx(Port, Entries, BATCH_SIZE, &Removed, 5000, TRUE);
+    ok(Ret == FALSE, "Ret = %d\n", Ret);
+    ok_err(WAIT_IO_COMPLETION);
+    ok(Removed == 0, "Removed = %lu\n", Removed);
+    ok(ApcCalled, "APC was not called\n");
+
+    CloseHandle(Port);
+}
+
+static
+VOID
+TestSkipOnSuccess(BOOL Skip)
+{
+    WCHAR TempPath[MAX_PATH], FileName[MAX_PATH];
+    OVERLAPPED Overlapped, *Result;
+    ULONG_PTR Key;
+    DWORD Written, Transferred;
+    CHAR Buffer[512] = "Completion";
+    HANDLE File, Port;
+    BOOL Ret;
+
+    GetTempPathW(_countof(TempPath), TempPath);
+    GetTempFileNameW(TempPath, L"ioc", 0, FileName);
+    File = CreateFileW(FileName,
+                       GENERIC_READ | GENERIC_WRITE,
+                       0,
+                       NULL,
+                       CREATE_ALWAYS,
+                       FILE_FLAG_OVERLAPPED | FILE_FLAG_DELETE_ON_CLOSE,
+                       NULL);
+    ok(File != INVALID_HANDLE_VALUE, "CreateFileW failed with %lu\n", GetLastError());
+    if (File == INVALID_HANDLE_VALUE)
+        return;
+
+    Port = CreateIoCompletionPort(File, NULL, 0x1234, 0);
+    ok(Port != NULL, "CreateIoCompletionPort failed with %lu\n", GetLastError());
+    if (!Port)
+    {
+        CloseHandle(File);
+        return;
+    }
+
+    if (Skip)
+    {
+        Ret = pSetFileCompletionNotificationModes(File, FILE_SKIP_COMPLETION_PORT_ON_SUCCESS |
+                                                        FILE_SKIP_SET_EVENT_ON_HANDLE);
+        ok(Ret, "SetFileCompletionNotificationModes failed with %lu\n", GetLastError());
+
+        /* Unknown modes are refused */
+        SetLastError(0xdeadbeef);
+        Ret = pSetFileCompletionNotificationModes(File, 0x80);
+        ok(Ret == FALSE, "Ret = %d\n", Ret);
+        ok_err(ERROR_INVALID_PARAMETER);
+    }
+
+    ZeroMemory(&Overlapped, sizeof(Overlapped));
+    Ret = WriteFile(File, Buffer, sizeof(Buffer), &Written, &Overlapped);
+    if (Ret)
+    {
+        /* Finished right away, the port only hears about it if we didn't ask to skip it */
+        Result = NULL;
+        Ret = GetQueuedCompletionStatus(Port, &Transferred, &Key, &Result, 0);
+        if (Skip)
+        {
+            ok(Ret == FALSE && Result == NULL, "Got a packet for a synchronous success\n");
+            ok_err(WAIT_TIMEOUT);
+        }
+        else
+        {
+            ok(Ret == TRUE, "No packet for a synchronous success, error %lu\n", GetLastError());
+            ok(Result == &Overlapped, "Result = %p\n", Result);
+            ok(Key == 0x1234, "Key = %Ix\n", Key);
+            ok(Transferred == sizeof(Buffer), "Transferred = %lu\n", Transferred);
+        }
+    }
+    else
+    {
+        /* Pending requests always get a packet */
+        ok_err(ERROR_IO_PENDING);
+        Result = NULL;
+        Ret = GetQueuedCompletionStatus(Port, &Transferred, &Key, &Result, 5000);
+        ok(Ret == TRUE, "No packet for a pending request, error %lu\n", GetLastError());
+        ok(Result == &Overlapped, "Result = %p\n", Result);
+    }
+
+    CloseHandle(Port);
+    CloseHandle(File);
+}
+
+static
+VOID
+Benchmark(VOID)
+{
+    OVERLAPPED_ENTRY Entries[BATCH_SIZE];
+    LARGE_INTEGER Frequency, Start, End;
+    ULONG Removed, Posted, Received, i;
+    LPOVERLAPPED Overlapped;
+    DWORD Transferred;
+    ULONG_PTR Key;
+    double Single, Batched;
+    HANDLE Port;
+
+    Port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 0);
+    if (!Port)
+    {
+        skip("CreateIoCompletionPort failed with %lu\n", GetLastError());
+        return;
+    }
+    QueryPerformanceFrequency(&Frequency);
+
+    /* One packet per call */
+    Received = 0;
+    QueryPerformanceCounter(&Start);
+    for (Posted = 0; Posted < BENCH_PACKETS; Posted += BENCH_ROUND)
+    {
+        for (i = 0; i < BENCH_ROUND; i++)
+            PostQueuedCompletionStatus(Port, i, i, NULL);
+        for (i = 0; i < BENCH_ROUND; i++)
+        {
+            if (GetQueuedCompletionStatus(Port, &Transferred, &Key, &Overlapped, 0))
+                Received++;
+        }
+    }
+    QueryPerformanceCounter(&End);
+    ok(Received == Posted, "Received %lu of %lu packets\n", Received, Posted);
+    Single = (double)(End.QuadPart - Start.QuadPart) / Frequency.QuadPart;
+
+    /* Up to BATCH_SIZE packets per call */
+    Received = 0;
+    QueryPerformanceCounter(&Start);
+    for (Posted = 0; Posted < BENCH_PACKETS; Posted += BENCH_ROUND)
+    {
+        for (i = 0; i < BENCH_ROUND; i++)
+            PostQueuedCompletionStatus(Port, i, i, NULL);
+        for (i = 0; i < BENCH_ROUND; i += Removed)
+        {
+            if (!pGetQueuedCompletionStatusEx(Port, Entries, BATCH_SIZE, &Removed, 0, FALSE))
+                break;
+            Received += Removed;
+        }
+    }
+    QueryPerformanceCounter(&End);
+    ok(Received == Posted, "Received %lu of %lu packets\n", Received, Posted);
+    Batched = (double)(End.QuadPart - Start.QuadPart) / Frequency.QuadPart;
+
+    if (Single > 0 && Batched > 0)
+    {
+        trace("GetQueuedCompletionStatus:   %.0f completions per second\n", Posted / Single);
+        trace("GetQueuedCompletionStatusEx: %.0f completions per second (%u per call)\n",
+              Posted / Batched, BATCH_SIZE);
+    }
+
+    CloseHandle(Port);
+}
+
+START_TEST(GetQueuedCompletionStatusEx)
+{
+    HMODULE hKernel32;
+
+    hKernel32 = GetModuleHandleW(L"kernel32.dll");
+    pSetFileCompletionNotificationModes =
+        (FN_SetFileCompletionNotificationModes*)GetProcAddress(hKernel32, "SetFileCompletionNotificationModes");
+    pGetQueuedCompletionStatusEx =
+        (FN_GetQueuedCompletionStatusEx*)GetProcAddress(hKernel32, "GetQueuedCompletionStatusEx");
+    if (!pGetQueuedCompletionStatusEx)
+    {
+        /* NT5 builds of ReactOS provide it from kernel32_vista */
+        hKernel32 = LoadLibraryW(L"kernel32_vista.dll");
+        if (hKernel32)
+        {
+            pGetQueuedCompletionStatusEx =
+                (FN_GetQueuedCompletionStatusEx*)GetProcAddress(hKernel32, "GetQueuedCompletionStatusEx");
+        }
+    }
+
+    TestSkipOnSuccess(FALSE);
+    if (pSetFileCompletionNotificationModes)
+        TestSkipOnSuccess(TRUE);
+    else
+        skip("SetFileCompletionNotificationModes not found\n");
+
+    if (!pGetQueuedCompletionStatusEx)
+    {
+        skip("GetQueuedCompletionStatusEx not found\n");
+        return;
+    }
+
+    TestBasic();
+    Benchmark();
+}
@@ -0,0 +1,328 @@
+/*
+ * PROJECT:     ReactOS API tests
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Test for the per-processor work queues of the thread pool
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include "precomp.h"
+
+static NTSTATUS (NTAPI *pTpAllocPool)(PTP_POOL *, PVOID);
+static VOID (NTAPI *pTpReleasePool)(PTP_POOL);
+static VOID (NTAPI *pTpSetPoolMaxThreads)(PTP_POOL, DWORD);
+static BOOL (NTAPI *pTpSetPoolMinThreads)(PTP_POOL, DWORD);
+static NTSTATUS (NTAPI *pTpSimpleTryPost)(PTP_SIMPLE_CALLBACK, PVOID, PTP_CALLBACK_ENVIRON);
+static NTSTATUS (NTAPI *pTpQueryPoolStatistics)(PTP_POOL, PTP_POOL_STATISTICS);
+
+static HANDLE StartedEvent;
+static HANDLE GateEvent;
+static HANDLE DoneEvent;
+static LONG Remaining;
+
+static
+VOID
+NTAPI
+BlockingCallback(
+    _Inout_ PTP_CALLBACK_INSTANCE Instance,
+    _Inout_opt_ PVOID Context)
+{
+    SetEvent(StartedEvent);
+    WaitForSingleObject(GateEvent, INFINITE);
+    if (InterlockedDecrement(&Remaining) == 0)
+        SetEvent(DoneEvent);
+}
+
+static
+VOID
+NTAPI
+CountingCallback(
+    _Inout_ PTP_CALLBACK_INSTANCE Instance,
+    _Inout_opt_ PVOID Context)
+{
+    if (InterlockedDecrement(&Remaining) == 0)
+        SetEvent(DoneEvent);
+}
+
+static
+VOID
+TestAffinityHint(VOID)
+{
+    TP_CALLBACK_ENVIRON Environment;
+
+    RtlZeroMemory(&Environment, sizeof(Environment));
+    TpSetCallbackAffinityHint(&Environment, 0);
+    ok_hex(Environment.u.s.Private, 1);
+    ok_hex(TP_CALLBACK_AFFINITY_FROM_PRIVATE(Environment.u.s.Private), 0);
+    ok_hex(Environment.u.s.LongFunction, 0);
+    ok_hex(Environment.u.s.Persistent, 0);
+
+    TpSetCallbackAffinityHint(&Environment, 5);
+    ok_hex(Environment.u.s.Private, 6);
+    ok_hex(TP_CALLBACK_AFFINITY_FROM_PRIVATE(Environment.u.s.Private), 5);
+}
+
+static
+VOID
+TestWorkQueues(VOID)
+{
+    NTSTATUS Status;
+    PTP_POOL Pool;
+    TP_CALLBACK_ENVIRON Environment;
+    TP_POOL_STATISTICS Statistics;
+    SYSTEM_INFO SystemInfo;
+    ULONG Queues, Pending, Queue, i;
+
+    GetSystemInfo(&SystemInfo);
+
+    Status = pTpAllocPool(&Pool, NULL);
+    ok_hex(Status, STATUS_SUCCESS);
+    if (!NT_SUCCESS(Status))
+        return;
+
+    /* One worker, so that everything posted while it is blocked stays queued */
+    pTpSetPoolMaxThreads(Pool, 1);
+    ok(pTpSetPoolMinThreads(Pool, 1) == TRUE, "TpSetPoolMinThreads failed\n");
+
+    Status = pTpQueryPoolStatistics(Pool, &Statistics);
+    ok_hex(Status, STATUS_SUCCESS);
+    Queues = Statistics.NumberOfQueues;
+    ok(Queues == min(SystemInfo.dwNumberOfProcessors, 16),
+       "%lu queues for %lu processors\n", Queues, SystemInfo.dwNumberOfProcessors);
+    ok_hex(Statistics.QueueDepth, 0);
+    ok_hex(Statistics.Steals, 0);
+    if (Queues == 0)
+        Queues = 1;
+
+    /* The blocking callback, eight on the first queue and one on each other */
+    Remaining = 1 + 8 + Queues - 1;
+    RtlZeroMemory(&Environment, sizeof(Environment));
+    Environment.Version = 1;
+    Environment.Pool = Pool;
+
+    Status = pTpSimpleTryPost(BlockingCallback, NULL, &Environment);
+    ok_hex(Status, STATUS_SUCCESS);
+    ok_hex(WaitForSingleObject(StartedEvent, 5000), WAIT_OBJECT_0);
+
+    TpSetCallbackAffinityHint(&Environment, 0);
+    for (i = 0; i < 8; i++)
+    {
+        Status = pTpSimpleTryPost(CountingCallback, NULL, &Environment);
+        ok_hex(Status, STATUS_SUCCESS);
+    }
+
+    Status = pTpQueryPoolStatistics(Pool, &Statistics);
+    ok_hex(Status, STATUS_SUCCESS);
+    ok_hex(Statistics.QueueDepth, 8);
+    ok_hex(Statistics.MaxQueueDepth, 8);
+    ok_hex(Statistics.Workers, 1);
+
+    for (Queue = 1; Queue < Queues; Queue++)
+    {
+        TpSetCallbackAffinityHint(&Environment, Queue);
+        Status = pTpSimpleTryPost(CountingCallback, NULL, &Environment);
+        ok_hex(Status, STATUS_SUCCESS);
+    }
+
+    /* Each hint picked its own queue, the deepest one still holds eight */
+    Status = pTpQueryPoolStatistics(Pool, &Statistics);
+    ok_hex(Status, STATUS_SUCCESS);
+    Pending = 8 + Queues - 1;
+    ok_hex(Statistics.QueueDepth, Pending);
+    ok_hex(Statistics.MaxQueueDepth, 8);
+    ok(Statistics.BusyWorkers >= Pending, "%lu busy for %lu pending\n", Statistics.BusyWorkers, Pending);
+
+    SetEvent(GateEvent);
+    ok_hex(WaitForSingleObject(DoneEvent, 5000), WAIT_OBJECT_0);
+    ok_hex(Remaining, 0);
+
+    /* The only worker has a single home queue, it had to steal the rest */
+    Status = pTpQueryPoolStatistics(Pool, &Statistics);
+    ok_hex(Status, STATUS_SUCCESS);
+    ok_hex(Statistics.QueueDepth, 0);
+    ok_hex(Statistics.MaxQueueDepth, 0);
+    ok(Statistics.Steals >= Queues - 1, "%lu steals for %lu queues\n", Statistics.Steals, Queues);
+    if (Queues == 1)
+        ok_hex(Statistics.Steals, 0);
+
+    pTpReleasePool(Pool);
+}
+
+/* Throughput benchmark: many small work items from one submitter per queue */
+#define THROUGHPUT_ITEMS            200000
+#define THROUGHPUT_MAX_SUBMITTERS   16
+
+typedef struct _SUBMITTER
+{
+    HANDLE StartEvent;
+    TP_CALLBACK_ENVIRON Environment;
+    ULONG Items;
+    ULONG Failures;
+} SUBMITTER, *PSUBMITTER;
+
+static
+DWORD
+WINAPI
+SubmitterThread(
+    _In_ PVOID Parameter)
+{
+    PSUBMITTER Submitter = Parameter;
+    ULONG i;
+
+    WaitForSingleObject(Submitter->StartEvent, INFINITE);
+    for (i = 0; i < Submitter->Items; i++)
+    {
+        if (!NT_SUCCESS(pTpSimpleTryPost(CountingCallback, NULL, &Submitter->Environment)))
+            Submitter->Failures++;
+    }
+
+    return 0;
+}
+
+static
+VOID
+MeasureThroughput(
+    _In_ BOOLEAN Spread)
+{
+    NTSTATUS Status;
+    PTP_POOL Pool;
+    TP_POOL_STATISTICS Statistics;
+    SUBMITTER Submitters[THROUGHPUT_MAX_SUBMITTERS];
+    HANDLE Threads[THROUGHPUT_MAX_SUBMITTERS];
+    HANDLE StartEvent;
+    LARGE_INTEGER Start, End, Frequency;
+    ULONG Count, Items, Failures = 0, i;
+    ULONGLONG Microseconds;
+
+    Status = pTpAllocPool(&Pool, NULL);
+    ok_hex(Status, STATUS_SUCCESS);
+    if (!NT_SUCCESS(Status))
+        return;
+
+    Status = pTpQueryPoolStatistics(Pool, &Statistics);
+    ok_hex(Status, STATUS_SUCCESS);
+    Count = max(min(Statistics.NumberOfQueues, THROUGHPUT_MAX_SUBMITTERS), 1);
+
+    pTpSetPoolMaxThreads(Pool, Count);
+    ok(pTpSetPoolMinThreads(Pool, Count) == TRUE, "TpSetPoolMinThreads failed\n");
+
+    StartEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    ok(StartEvent != NULL, "CreateEventW failed\n");
+    if (!StartEvent)
+    {
+        pTpReleasePool(Pool);
+        return;
+    }
+
+    /* Either each submitter feeds its own queue, or all of them the first */
+    for (i = 0; i < Count; i++)
+    {
+        RtlZeroMemory(&Submitters[i], sizeof(Submitters[i]));
+        Submitters[i].StartEvent = StartEvent;
+        Submitters[i].Items = THROUGHPUT_ITEMS / Count;
+        if (i == 0)
+            Submitters[i].Items += THROUGHPUT_ITEMS % Count;
+        Submitters[i].Environment.Version = 1;
+        Submitters[i].Environment.Pool = Pool;
+        TpSetCallbackAffinityHint(&Submitters[i].Environment, Spread ? i : 0);
+
+        Threads[i] = CreateThread(NULL, 0, SubmitterThread, &Submitters[i], 0, NULL);
+        ok(Threads[i] != NULL, "CreateThread failed\n");
+        if (!Threads[i])
+        {
+            /* Go on with the submitters already started */
+            Count = i;
+            break;
+        }
+    }
+
+    Items = 0;
+    for (i = 0; i < Count; i++)
+        Items += Submitters[i].Items;
+    Remaining = Items;
+    if (Count == 0)
+    {
+        CloseHandle(StartEvent);
+        pTpReleasePool(Pool);
+        return;
+    }
+
+    QueryPerformanceFrequency(&Frequency);
+    QueryPerformanceCounter(&Start);
+    SetEvent(StartEvent);
+
+    ok_hex(WaitForMultipleObjects(Count, Threads, TRUE, 60000), WAIT_OBJECT_0);
+    ok_hex(WaitForSingleObject(DoneEvent, 60000), WAIT_OBJECT_0);
+    QueryPerformanceCounter(&End);
+
+    for (i = 0; i < Count; i++)
+    {
+        Failures += Submitters[i].Failures;
+        CloseHandle(Threads[i]);
+    }
+    ok_hex(Failures, 0);
+    ok_hex(Remaining, 0);
+
+    Status = pTpQueryPoolStatistics(Pool, &Statistics);
+    ok_hex(Status, STATUS_SUCCESS);
+    ok_hex(Statistics.QueueDepth, 0);
+
+    Microseconds = (ULONGLONG)(End.QuadPart - Start.QuadPart) * 1000000 / Frequency.QuadPart;
+    if (Microseconds == 0)
+        Microseconds = 1;
+    trace("%s: %lu submitters, %I64u items per second, %lu steals, %lu wakeups\n",
+          Spread ? "One queue per submitter" : "Single queue",
+          Count,
+          (ULONGLONG)Items * 1000000 / Microseconds,
+          Statistics.Steals,
+          Statistics.Wakeups);
+
+    CloseHandle(StartEvent);
+    pTpReleasePool(Pool);
+}
+
+START_TEST(TpWorkQueues)
+{
+    HMODULE hNtdll = GetModuleHandleW(L"ntdll.dll");
+    NTSTATUS Status;
+    TP_POOL_STATISTICS Statistics;
+
+    pTpAllocPool = (PVOID)GetProcAddress(hNtdll, "TpAllocPool");
+    pTpReleasePool = (PVOID)GetProcAddress(hNtdll, "TpReleasePool");
+    pTpSetPoolMaxThreads = (PVOID)GetProcAddress(hNtdll, "TpSetPoolMaxThreads");
+    pTpSetPoolMinThreads = (PVOID)GetProcAddress(hNtdll, "TpSetPoolMinThreads");
+    pTpSimpleTryPost = (PVOID)GetProcAddress(hNtdll, "TpSimpleTryPost");
+    pTpQueryPoolStatistics = (PVOID)GetProcAddress(hNtdll, "TpQueryPoolStatistics");
+    if (!pTpAllocPool || !pTpReleasePool || !pTpSetPoolMaxThreads ||
+        !pTpSetPoolMinThreads || !pTpSimpleTryPost || !pTpQueryPoolStatistics)
+    {
+        skip("Thread pool extensions not available\n");
+        return;
+    }
+
+    TestAffinityHint();
+
+    Status = pTpQueryPoolStatistics(NULL, NULL);
+    ok_hex(Status, STATUS_INVALID_PARAMETER);
+
+    /* The default pool reports its state too, if it exists yet */
+    Status = pTpQueryPoolStatistics(NULL, &Statistics);
+    ok_hex(Status, STATUS_SUCCESS);
+
+    StartedEvent = CreateEventW(NULL, FALSE, FALSE, NULL);
+    GateEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    DoneEvent = CreateEventW(NULL, FALSE, FALSE, NULL);
+    ok(StartedEvent && GateEvent && DoneEvent, "CreateEventW failed\n");
+    if (!StartedEvent || !GateEvent || !DoneEvent)
+        return;
+
+    TestWorkQueues();
+
+    /* Everything on one queue, as the single list scheduler did, against
+     * the per-processor queues with stealing */
+    MeasureThroughput(FALSE);
+    MeasureThroughput(TRUE);
+
+    CloseHandle(StartedEvent);
+    CloseHandle(GateEvent);
+    CloseHandle(DoneEvent);
+}
@@ -103,6 +103,7 @@ extern void func_RtlxUnicodeStringToAnsiSize(void);
 extern void func_RtlxUnicodeStringToOemSize(void);
 extern void func_StackOverflow(void);
 extern void func_TimerResolution(void);
+extern void func_TpWorkQueues(void);
 extern void func_UserModeException(void);
 
 const struct test winetest_testlist[] =
@@ -205,6 +206,7 @@ const struct test winetest_testlist[] =
     { "RtlValidateUnicodeString",       func_RtlValidateUnicodeString },
     { "StackOverflow",                  func_StackOverflow },
     { "TimerResolution",                func_TimerResolution },
+    { "TpWorkQueues",                   func_TpWorkQueues },
     { "UserModeException",              func_UserModeException },
 #ifdef _M_IX86
     { "RtlUnwind",                      func_RtlUnwind },
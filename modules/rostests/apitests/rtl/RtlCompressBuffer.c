@@ -0,0 +1,206 @@
+/*
+ * PROJECT:     ReactOS api tests
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Test for the LZNT1, XPRESS and XPRESS Huffman compression formats
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include <rtltests.h>
+
+#define TEST_SIZE   (0x10000 * 2)
+
+static
+VOID
+FillTestData(PUCHAR Buffer, ULONG Size)
+{
+    static const CHAR Text[] = "ReactOS compresses XPRESS streams. ";
+    ULONG Seed = 0x1234;
+    ULONG i;
+
+    for (i = 0; i < Size; i++)
+    {
+        /* Mostly text, with a sprinkle of noise */
+        if ((i % 97) == 0)
+            Buffer[i] = (UCHAR)RtlRandom(&Seed);
+        else
+            Buffer[i] = Text[i % (sizeof(Text) - 1)];
+    }
+}
+
+static
+VOID
+TestFormat(USHORT Format, PUCHAR Data, PUCHAR Compressed, PUCHAR Decompressed)
+{
+    static const ULONG Sizes[] = { 0, 1, 3, 4096, 0x10000, 0x10001, TEST_SIZE };
+    ULONG WorkSpaceSize, FragmentSize, CompressedSize, FinalSize, i;
+    PVOID WorkSpace;
+    NTSTATUS Status;
+
+    WorkSpaceSize = FragmentSize = 0xdeadbeef;
+    Status = RtlGetCompressionWorkSpaceSize(Format, &WorkSpaceSize, &FragmentSize);
+    ok_eq_hex(Status, STATUS_SUCCESS);
+    ok(WorkSpaceSize != 0 && WorkSpaceSize != 0xdeadbeef, "Got workspace size %lu\n", WorkSpaceSize);
+    ok_eq_ulong(FragmentSize, 0UL);
+
+    WorkSpace = RtlAllocateHeap(RtlGetProcessHeap(), 0, WorkSpaceSize);
+    ok(WorkSpace != NULL, "Allocation of %lu bytes failed\n", WorkSpaceSize);
+    if (!WorkSpace)
+        return;
+
+    for (i = 0; i < RTL_NUMBER_OF(Sizes); i++)
+    {
+        CompressedSize = 0xdeadbeef;
+        Status = RtlCompressBuffer(Format, Data, Sizes[i], Compressed, TEST_SIZE * 2,
+                                   4096, &CompressedSize, WorkSpace);
+        ok(Status == STATUS_SUCCESS, "Format 0x%x, size %lu: status 0x%lx\n", Format, Sizes[i], Status);
+        if (!NT_SUCCESS(Status))
+            continue;
+
+        if (Sizes[i] == TEST_SIZE)
+        {
+            ok(CompressedSize < Sizes[i] / 4, "Format 0x%x: %lu bytes compressed to %lu\n",
+               Format, Sizes[i], CompressedSize);
+        }
+
+        /* The output must stop exactly where the data does */
+        RtlFillMemory(Decompressed, TEST_SIZE + 1, 0xCC);
+        FinalSize = 0xdeadbeef;
+        Status = RtlDecompressBuffer(Format, Decompressed, TEST_SIZE + 1,
+                                     Compressed, CompressedSize, &FinalSize);
+        ok(Status == STATUS_SUCCESS, "Format 0x%x, size %lu: status 0x%lx\n", Format, Sizes[i], Status);
+        ok(FinalSize == Sizes[i], "Format 0x%x: got %lu bytes, expected %lu\n", Format, FinalSize, Sizes[i]);
+        ok(RtlCompareMemory(Decompressed, Data, Sizes[i]) == Sizes[i],
+           "Format 0x%x, size %lu: data mismatch\n", Format, Sizes[i]);
+        ok(Decompressed[Sizes[i]] == 0xCC, "Format 0x%x, size %lu: wrote too much\n", Format, Sizes[i]);
+
+        /* Partial decompression is no error */
+        if (Sizes[i] > 10)
+        {
+            FinalSize = 0xdeadbeef;
+            Status = RtlDecompressBuffer(Format, Decompressed, 10,
+                                         Compressed, CompressedSize, &FinalSize);
+            ok_eq_hex(Status, STATUS_SUCCESS);
+            ok_eq_ulong(FinalSize, 10UL);
+        }
+    }
+
+    /* Not enough room for the output */
+    Status = RtlCompressBuffer(Format, Data, TEST_SIZE, Compressed, 64,
+                               4096, &CompressedSize, WorkSpace);
+    ok_eq_hex(Status, STATUS_BUFFER_TOO_SMALL);
+
+    /* Truncated input must not pass for the full data */
+    Status = RtlCompressBuffer(Format, Data, 4096, Compressed, TEST_SIZE * 2,
+                               4096, &CompressedSize, WorkSpace);
+    ok_eq_hex(Status, STATUS_SUCCESS);
+    FinalSize = 0;
+    Status = RtlDecompressBuffer(Format, Decompressed, TEST_SIZE,
+                                 Compressed, CompressedSize / 2, &FinalSize);
+    ok(Status == STATUS_BAD_COMPRESSION_BUFFER || FinalSize < 4096,
+       "Format 0x%x: status 0x%lx, %lu bytes\n", Format, Status, FinalSize);
+
+    /* No random access into these streams */
+    Status = RtlDecompressFragment(Format, Decompressed, TEST_SIZE, Compressed,
+                                   CompressedSize, 16, &FinalSize, WorkSpace);
+    ok_eq_hex(Status, STATUS_UNSUPPORTED_COMPRESSION);
+
+    RtlFreeHeap(RtlGetProcessHeap(), 0, WorkSpace);
+}
+
+static
+VOID
+TestLznt1(USHORT Format, PUCHAR Data, PUCHAR Compressed, PUCHAR Decompressed)
+{
+    ULONG InfoBuffer[FIELD_OFFSET(COMPRESSED_DATA_INFO, CompressedChunkSizes) / sizeof(ULONG) + 16];
+    PCOMPRESSED_DATA_INFO Info = (PCOMPRESSED_DATA_INFO)InfoBuffer;
+    ULONG WorkSpaceSize, FragmentSize, CompressedSize, FinalSize, Total, i;
+    PVOID WorkSpace;
+    NTSTATUS Status;
+
+    Status = RtlGetCompressionWorkSpaceSize(Format, &WorkSpaceSize, &FragmentSize);
+    ok_eq_hex(Status, STATUS_SUCCESS);
+    ok_eq_ulong(FragmentSize, 0x1000UL);
+
+    WorkSpace = RtlAllocateHeap(RtlGetProcessHeap(), 0, WorkSpaceSize);
+    ok(WorkSpace != NULL, "Allocation of %lu bytes failed\n", WorkSpaceSize);
+    if (!WorkSpace)
+        return;
+
+    /* Text must actually shrink, not just be stored in chunks */
+    Status = RtlCompressBuffer(Format, Data, TEST_SIZE, Compressed, TEST_SIZE * 2,
+                               4096, &CompressedSize, WorkSpace);
+    ok_eq_hex(Status, STATUS_SUCCESS);
+    ok(CompressedSize < TEST_SIZE / 4, "Format 0x%x: compressed to %lu\n", Format, CompressedSize);
+
+    RtlFillMemory(Decompressed, TEST_SIZE + 1, 0xCC);
+    Status = RtlDecompressBuffer(Format, Decompressed, TEST_SIZE + 1,
+                                 Compressed, CompressedSize, &FinalSize);
+    ok_eq_hex(Status, STATUS_SUCCESS);
+    ok_eq_ulong(FinalSize, (ULONG)TEST_SIZE);
+    ok(RtlCompareMemory(Decompressed, Data, TEST_SIZE) == TEST_SIZE, "Format 0x%x: data mismatch\n", Format);
+
+    /* Every chunk is independent, so any of them can be reached directly */
+    Status = RtlDecompressFragment(Format, Decompressed, 100, Compressed, CompressedSize,
+                                   0x3010, &FinalSize, WorkSpace);
+    ok_eq_hex(Status, STATUS_SUCCESS);
+    ok_eq_ulong(FinalSize, 100UL);
+    ok(RtlCompareMemory(Decompressed, Data + 0x3010, 100) == 100, "Format 0x%x: fragment mismatch\n", Format);
+
+    /* One 64K compression unit of 4K chunks, the third of which is zero */
+    RtlZeroMemory(Data + 0x2000, 0x1000);
+    RtlZeroMemory(Info, sizeof(InfoBuffer));
+    Info->CompressionFormatAndEngine = Format;
+    Info->CompressionUnitShift = 16;
+    Info->ChunkShift = 12;
+    Status = RtlCompressChunks(Data, 0x10000, Compressed, 0x10000, Info, sizeof(InfoBuffer), WorkSpace);
+    ok_eq_hex(Status, STATUS_SUCCESS);
+    ok_eq_uint(Info->NumberOfChunks, 16);
+    ok_eq_ulong(Info->CompressedChunkSizes[2], 0UL);
+
+    for (i = 0, Total = 0; i < Info->NumberOfChunks; i++)
+        Total += Info->CompressedChunkSizes[i];
+    ok(Total < 0x10000 / 4, "Format 0x%x: chunks compressed to %lu\n", Format, Total);
+
+    RtlFillMemory(Decompressed, 0x10000, 0xCC);
+    Status = RtlDecompressChunks(Decompressed, 0x10000, Compressed, Total, NULL, 0, Info);
+    ok_eq_hex(Status, STATUS_SUCCESS);
+    ok(RtlCompareMemory(Decompressed, Data, 0x10000) == 0x10000, "Format 0x%x: chunk data mismatch\n", Format);
+
+    /* Random data is stored as is */
+    for (i = 0, FinalSize = 0x5678; i < 0x1000; i++)
+        Data[i] = (UCHAR)RtlRandom(&FinalSize);
+    Status = RtlCompressChunks(Data, 0x1000, Compressed, 0x10000, Info, sizeof(InfoBuffer), WorkSpace);
+    ok_eq_hex(Status, STATUS_SUCCESS);
+    ok_eq_uint(Info->NumberOfChunks, 1);
+    ok_eq_ulong(Info->CompressedChunkSizes[0], 0x1000UL);
+
+    /* Leave the shared test data as it was */
+    FillTestData(Data, TEST_SIZE);
+
+    RtlFreeHeap(RtlGetProcessHeap(), 0, WorkSpace);
+}
+
+START_TEST(RtlCompressBuffer)
+{
+    PUCHAR Data, Compressed, Decompressed;
+
+    Data = RtlAllocateHeap(RtlGetProcessHeap(), 0, TEST_SIZE);
+    Compressed = RtlAllocateHeap(RtlGetProcessHeap(), 0, TEST_SIZE * 2);
+    Decompressed = RtlAllocateHeap(RtlGetProcessHeap(), 0, TEST_SIZE + 1);
+    ok(Data && Compressed && Decompressed, "Allocation failed\n");
+    if (!Data || !Compressed || !Decompressed)
+        return;
+
+    FillTestData(Data, TEST_SIZE);
+
+    TestLznt1(COMPRESSION_FORMAT_LZNT1, Data, Compressed, Decompressed);
+    TestLznt1(COMPRESSION_FORMAT_LZNT1 | COMPRESSION_ENGINE_MAXIMUM, Data, Compressed, Decompressed);
+    TestFormat(COMPRESSION_FORMAT_XPRESS, Data, Compressed, Decompressed);
+    TestFormat(COMPRESSION_FORMAT_XPRESS | COMPRESSION_ENGINE_MAXIMUM, Data, Compressed, Decompressed);
+    TestFormat(COMPRESSION_FORMAT_XPRESS_HUFF, Data, Compressed, Decompressed);
+    TestFormat(COMPRESSION_FORMAT_XPRESS_HUFF | COMPRESSION_ENGINE_MAXIMUM, Data, Compressed, Decompressed);
+
+    RtlFreeHeap(RtlGetProcessHeap(), 0, Data);
+    RtlFreeHeap(RtlGetProcessHeap(), 0, Compressed);
+    RtlFreeHeap(RtlGetProcessHeap(), 0, Decompressed);
+}
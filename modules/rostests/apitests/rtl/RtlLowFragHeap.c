@@ -0,0 +1,295 @@
+/*
+ * PROJECT:     ReactOS api tests
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Test and benchmark for the Low Fragmentation Heap front end
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include <rtltests.h>
+
+#define BENCH_THREADS       4
+#define BENCH_SLOTS         256
+#define BENCH_ITERATIONS    200000
+
+typedef struct _BENCH_CONTEXT
+{
+    HANDLE Heap;
+    HANDLE StartEvent;
+    ULONG Seed;
+    ULONG Failures;
+} BENCH_CONTEXT, *PBENCH_CONTEXT;
+
+static
+ULONG
+QueryFrontEnd(HANDLE Heap)
+{
+    ULONG FrontEnd = 0xdeadbeef;
+    SIZE_T ReturnLength = 0;
+    NTSTATUS Status;
+
+    Status = RtlQueryHeapInformation(Heap,
+                                     HeapCompatibilityInformation,
+                                     &FrontEnd,
+                                     sizeof(FrontEnd),
+                                     &ReturnLength);
+    ok_eq_hex(Status, STATUS_SUCCESS);
+    ok_eq_size(ReturnLength, sizeof(ULONG));
+    return FrontEnd;
+}
+
+static
+NTSTATUS
+EnableFrontEnd(HANDLE Heap)
+{
+    ULONG FrontEnd = 2;
+
+    return RtlSetHeapInformation(Heap,
+                                 HeapCompatibilityInformation,
+                                 &FrontEnd,
+                                 sizeof(FrontEnd));
+}
+
+static
+VOID
+TestSmallBlocks(HANDLE Heap)
+{
+    PUCHAR Blocks[257];
+    PUCHAR NewBlock;
+    SIZE_T Size;
+    ULONG i;
+
+    for (Size = 1; Size <= 256; Size++)
+    {
+        Blocks[Size] = RtlAllocateHeap(Heap, HEAP_ZERO_MEMORY, Size);
+        ok(Blocks[Size] != NULL, "Allocation of %Iu bytes failed\n", Size);
+        if (!Blocks[Size])
+            continue;
+
+        ok(((ULONG_PTR)Blocks[Size] & (sizeof(PVOID) * 2 - 1)) == 0,
+           "Block %p of %Iu bytes is misaligned\n", Blocks[Size], Size);
+        ok_eq_size(RtlSizeHeap(Heap, 0, Blocks[Size]), Size);
+        ok(RtlValidateHeap(Heap, 0, Blocks[Size]) == TRUE,
+           "Block %p of %Iu bytes is not valid\n", Blocks[Size], Size);
+
+        for (i = 0; i < Size; i++)
+        {
+            if (Blocks[Size][i] != 0)
+                break;
+        }
+        ok(i == Size, "Block of %Iu bytes not zeroed at %lu\n", Size, i);
+
+        RtlFillMemory(Blocks[Size], Size, (UCHAR)Size);
+    }
+
+    /* Nobody trampled on anybody */
+    for (Size = 1; Size <= 256; Size++)
+    {
+        if (!Blocks[Size])
+            continue;
+
+        for (i = 0; i < Size; i++)
+        {
+            if (Blocks[Size][i] != (UCHAR)Size)
+                break;
+        }
+        ok(i == Size, "Block of %Iu bytes corrupted at %lu\n", Size, i);
+    }
+
+    /* Grow and shrink, contents must follow */
+    for (Size = 1; Size <= 256; Size++)
+    {
+        if (!Blocks[Size])
+            continue;
+
+        NewBlock = RtlReAllocateHeap(Heap, HEAP_ZERO_MEMORY, Blocks[Size], Size * 3);
+        ok(NewBlock != NULL, "Reallocation of %Iu bytes failed\n", Size);
+        if (!NewBlock)
+            continue;
+
+        ok_eq_size(RtlSizeHeap(Heap, 0, NewBlock), Size * 3);
+        ok(NewBlock[0] == (UCHAR)Size && NewBlock[Size - 1] == (UCHAR)Size,
+           "Reallocated block of %Iu bytes lost its contents\n", Size);
+        ok(NewBlock[Size] == 0 && NewBlock[Size * 3 - 1] == 0,
+           "Reallocated block of %Iu bytes not zeroed\n", Size);
+
+        Blocks[Size] = RtlReAllocateHeap(Heap, 0, NewBlock, Size);
+        ok(Blocks[Size] != NULL, "Shrinking to %Iu bytes failed\n", Size);
+        if (!Blocks[Size])
+            continue;
+
+        ok_eq_size(RtlSizeHeap(Heap, 0, Blocks[Size]), Size);
+        ok(Blocks[Size][Size - 1] == (UCHAR)Size,
+           "Shrunk block of %Iu bytes lost its contents\n", Size);
+    }
+
+    for (Size = 1; Size <= 256; Size++)
+    {
+        if (Blocks[Size])
+            ok(RtlFreeHeap(Heap, 0, Blocks[Size]) == TRUE, "Freeing %Iu bytes failed\n", Size);
+    }
+
+    ok(RtlValidateHeap(Heap, 0, NULL) == TRUE, "Heap is corrupted\n");
+}
+
+static
+DWORD
+WINAPI
+BenchThread(PVOID Parameter)
+{
+    PBENCH_CONTEXT Context = Parameter;
+    PVOID Slots[BENCH_SLOTS] = { NULL };
+    ULONG Seed = Context->Seed;
+    ULONG i, Slot;
+    SIZE_T Size;
+
+    WaitForSingleObject(Context->StartEvent, INFINITE);
+
+    for (i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        /* 16 to 256 bytes, the typical small object range */
+        Slot = RtlRandom(&Seed) % BENCH_SLOTS;
+        Size = 16 + (RtlRandom(&Seed) % 241);
+
+        if (Slots[Slot])
+            RtlFreeHeap(Context->Heap, 0, Slots[Slot]);
+
+        Slots[Slot] = RtlAllocateHeap(Context->Heap, 0, Size);
+        if (!Slots[Slot])
+            Context->Failures++;
+        else
+            *(PUCHAR)Slots[Slot] = (UCHAR)i;
+    }
+
+    for (Slot = 0; Slot < BENCH_SLOTS; Slot++)
+    {
+        if (Slots[Slot])
+            RtlFreeHeap(Context->Heap, 0, Slots[Slot]);
+    }
+
+    return 0;
+}
+
+static
+ULONGLONG
+RunBenchmark(HANDLE Heap)
+{
+    BENCH_CONTEXT Contexts[BENCH_THREADS];
+    HANDLE Threads[BENCH_THREADS];
+    LARGE_INTEGER Frequency, Start, End;
+    ULONG i;
+
+    QueryPerformanceFrequency(&Frequency);
+
+    Contexts[0].StartEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    ok(Contexts[0].StartEvent != NULL, "CreateEventW failed with %lu\n", GetLastError());
+    if (!Contexts[0].StartEvent)
+        return 0;
+
+    for (i = 0; i < BENCH_THREADS; i++)
+    {
+        Contexts[i].Heap = Heap;
+        Contexts[i].StartEvent = Contexts[0].StartEvent;
+        Contexts[i].Seed = 0x1234 + i;
+        Contexts[i].Failures = 0;
+        Threads[i] = CreateThread(NULL, 0, BenchThread, &Contexts[i], 0, NULL);
+        ok(Threads[i] != NULL, "CreateThread failed with %lu\n", GetLastError());
+        if (!Threads[i])
+            return 0;
+    }
+
+    QueryPerformanceCounter(&Start);
+    SetEvent(Contexts[0].StartEvent);
+    WaitForMultipleObjects(BENCH_THREADS, Threads, TRUE, INFINITE);
+    QueryPerformanceCounter(&End);
+
+    for (i = 0; i < BENCH_THREADS; i++)
+    {
+        ok(Contexts[i].Failures == 0, "Thread %lu had %lu failed allocations\n", i, Contexts[i].Failures);
+        CloseHandle(Threads[i]);
+    }
+    CloseHandle(Contexts[0].StartEvent);
+
+    /* Return the amount of alloc/free pairs per second */
+    if (End.QuadPart == Start.QuadPart)
+        End.QuadPart++;
+    return (ULONGLONG)BENCH_THREADS * BENCH_ITERATIONS * Frequency.QuadPart /
+           (End.QuadPart - Start.QuadPart);
+}
+
+START_TEST(RtlLowFragHeap)
+{
+    ULONGLONG BackEndRate, FrontEndRate;
+    PUCHAR EarlyBlock;
+    HANDLE Heap;
+    NTSTATUS Status;
+
+    /* Serialization is required */
+    Heap = RtlCreateHeap(HEAP_GROWABLE | HEAP_NO_SERIALIZE, NULL, 0, 0, NULL, NULL);
+    ok(Heap != NULL, "RtlCreateHeap failed\n");
+    if (Heap)
+    {
+        Status = EnableFrontEnd(Heap);
+        ok(!NT_SUCCESS(Status), "LFH enabled on a non-serialized heap\n");
+        ok_eq_ulong(QueryFrontEnd(Heap), 0UL);
+        RtlDestroyHeap(Heap);
+    }
+
+    /* Back end only */
+    Heap = RtlCreateHeap(HEAP_GROWABLE, NULL, 0, 0, NULL, NULL);
+    ok(Heap != NULL, "RtlCreateHeap failed\n");
+    if (!Heap)
+        return;
+
+    ok_eq_ulong(QueryFrontEnd(Heap), 0UL);
+    TestSmallBlocks(Heap);
+    BackEndRate = RunBenchmark(Heap);
+    RtlDestroyHeap(Heap);
+
+    /* Same thing, with the front end */
+    Heap = RtlCreateHeap(HEAP_GROWABLE, NULL, 0, 0, NULL, NULL);
+    ok(Heap != NULL, "RtlCreateHeap failed\n");
+    if (!Heap)
+        return;
+
+    /* Blocks allocated before the switch must keep working */
+    EarlyBlock = RtlAllocateHeap(Heap, 0, 32);
+    ok(EarlyBlock != NULL, "Allocation failed\n");
+
+    Status = EnableFrontEnd(Heap);
+    ok_eq_hex(Status, STATUS_SUCCESS);
+    ok_eq_ulong(QueryFrontEnd(Heap), 2UL);
+
+    if (EarlyBlock)
+    {
+        RtlFillMemory(EarlyBlock, 32, 0x55);
+        EarlyBlock = RtlReAllocateHeap(Heap, 0, EarlyBlock, 64);
+        ok(EarlyBlock != NULL, "Reallocation failed\n");
+        if (EarlyBlock)
+        {
+            ok(EarlyBlock[31] == 0x55, "Reallocated block lost its contents\n");
+            ok(RtlFreeHeap(Heap, 0, EarlyBlock) == TRUE, "Freeing failed\n");
+        }
+    }
+
+    /* Enabling it twice is fine */
+    Status = EnableFrontEnd(Heap);
+    ok_eq_hex(Status, STATUS_SUCCESS);
+
+    /* Front end blocks validate while in use, and not once freed */
+    EarlyBlock = RtlAllocateHeap(Heap, 0, 24);
+    ok(EarlyBlock != NULL, "Allocation failed\n");
+    if (EarlyBlock)
+    {
+        ok(RtlValidateHeap(Heap, 0, EarlyBlock) == TRUE, "LFH block %p is not valid\n", EarlyBlock);
+        ok(RtlFreeHeap(Heap, 0, EarlyBlock) == TRUE, "Freeing failed\n");
+        ok(RtlValidateHeap(Heap, 0, EarlyBlock) == FALSE, "Freed LFH block %p is valid\n", EarlyBlock);
+    }
+
+    TestSmallBlocks(Heap);
+    FrontEndRate = RunBenchmark(Heap);
+    ok(RtlValidateHeap(Heap, 0, NULL) == TRUE, "Heap is corrupted\n");
+    RtlDestroyHeap(Heap);
+
+    trace("%u threads, 16-256 byte blocks: back end %I64u, LFH %I64u alloc/free per second\n",
+          BENCH_THREADS, BackEndRate, FrontEndRate);
+}
@@ -4,12 +4,16 @@
 #include <apitest.h>
 
 extern void func_RtlCaptureContext(void);
+extern void func_RtlCompressBuffer(void);
 extern void func_RtlIntSafe(void);
+extern void func_RtlLowFragHeap(void);
 extern void func_RtlUnwind(void);
 
 const struct test winetest_testlist[] =
 {
+    { "RtlCompressBuffer",        func_RtlCompressBuffer },
     { "RtlIntSafe",               func_RtlIntSafe },
+    { "RtlLowFragHeap",           func_RtlLowFragHeap },
 
 #ifdef _M_IX86
     { "RtlUnwind",                func_RtlUnwind },
@@ -6,15 +6,18 @@
 
 #include <kmt_test.h>
 
+KMT_TESTFUNC Test_CcFileCacheBench;
 KMT_TESTFUNC Test_CmSecurity;
 KMT_TESTFUNC Test_Example;
 KMT_TESTFUNC Test_ExCallback;
 KMT_TESTFUNC Test_ExDoubleList;
 KMT_TESTFUNC Test_ExFastMutex;
+KMT_TESTFUNC Test_ExHandleChurn;
 KMT_TESTFUNC Test_ExHardError;
 KMT_TESTFUNC Test_ExHardErrorInteractive;
 KMT_TESTFUNC Test_ExInterlocked;
 KMT_TESTFUNC Test_ExPools;
+KMT_TESTFUNC Test_ExPoolStress;
 KMT_TESTFUNC Test_ExResource;
 KMT_TESTFUNC Test_ExSequencedList;
 KMT_TESTFUNC Test_ExSingleList;
@@ -29,10 +32,13 @@ KMT_TESTFUNC Test_FsRtlTunnel;
 KMT_TESTFUNC Test_HalSystemInfo;
 KMT_TESTFUNC Test_IoCreateFile;
 KMT_TESTFUNC Test_IoDeviceInterface;
+KMT_TESTFUNC Test_IoDirectoryWalk;
 KMT_TESTFUNC Test_IoEvent;
+KMT_TESTFUNC Test_IoFileThroughput;
 KMT_TESTFUNC Test_IoFilesystem;
 KMT_TESTFUNC Test_IoInterrupt;
 KMT_TESTFUNC Test_IoIrp;
+KMT_TESTFUNC Test_IoLargeDirectory;
 KMT_TESTFUNC Test_IoMdl;
 KMT_TESTFUNC Test_IoVolume;
 KMT_TESTFUNC Test_KdSystemDebugControl;
@@ -47,6 +53,7 @@ KMT_TESTFUNC Test_KeMutex;
 KMT_TESTFUNC Test_KeProcessor;
 KMT_TESTFUNC Test_KeSpinLock;
 KMT_TESTFUNC Test_KeTimer;
+KMT_TESTFUNC Test_KeTimerWheel;
 KMT_TESTFUNC Test_KernelType;
 KMT_TESTFUNC Test_MmMdl;
 KMT_TESTFUNC Test_MmSection;
@@ -90,14 +97,17 @@ KMT_TESTFUNC Test_ZwWaitForMultipleObjects;
 
 const KMT_TEST TestList[] =
 {
+    { "-CcFileCacheBench",                  Test_CcFileCacheBench },
     { "CmSecurity",                         Test_CmSecurity },
     { "ExCallback",                         Test_ExCallback },
     { "ExDoubleList",                       Test_ExDoubleList },
     { "ExFastMutex",                        Test_ExFastMutex },
+    { "-ExHandleChurn",                     Test_ExHandleChurn },
     { "ExHardError",                        Test_ExHardError },
     { "-ExHardErrorInteractive",            Test_ExHardErrorInteractive },
     { "ExInterlocked",                      Test_ExInterlocked },
     { "ExPools",                            Test_ExPools },
+    { "-ExPoolStress",                      Test_ExPoolStress },
     { "ExResource",                         Test_ExResource },
     { "ExSequencedList",                    Test_ExSequencedList },
     { "ExSingleList",                       Test_ExSingleList },
@@ -113,10 +123,13 @@ const KMT_TEST TestList[] =
     { "HalSystemInfo",                      Test_HalSystemInfo },
     { "IoCreateFile",                       Test_IoCreateFile },
     { "IoDeviceInterface",                  Test_IoDeviceInterface },
+    { "-IoDirectoryWalk",                   Test_IoDirectoryWalk },
     { "IoEvent",                            Test_IoEvent },
+    { "-IoFileThroughput",                  Test_IoFileThroughput },
     { "IoFilesystem",                       Test_IoFilesystem },
     { "IoInterrupt",                        Test_IoInterrupt },
     { "IoIrp",                              Test_IoIrp },
+    { "-IoLargeDirectory",                  Test_IoLargeDirectory },
     { "IoMdl",                              Test_IoMdl },
     { "IoVolume",                           Test_IoVolume },
     { "KdSystemDebugControl",               Test_KdSystemDebugControl },
@@ -131,6 +144,7 @@ const KMT_TEST TestList[] =
     { "-KeProcessor",                       Test_KeProcessor },
     { "KeSpinLock",                         Test_KeSpinLock },
     { "KeTimer",                            Test_KeTimer },
+    { "-KeTimerWheel",                      Test_KeTimerWheel },
     { "-KernelType",                        Test_KernelType },
     { "MmMdl",                              Test_MmMdl },
     { "MmSection",                          Test_MmSection },
@@ -0,0 +1,187 @@
+/*
+ * PROJECT:     ReactOS kernel-mode tests
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Kernel-Mode Test Suite file cache read throughput
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+/*
+ * Writes a file larger than the space the cache manager maps its views in,
+ * then reads it back through the cache, sequentially and at random offsets,
+ * and reports the throughput. Every block carries its number, so the reads
+ * are checked too.
+ */
+
+#include <kmt_test.h>
+
+#define NDEBUG
+#include <debug.h>
+
+#define TAG_CACHEBENCH      'bcCT'
+#define BENCH_BLOCK_SIZE    (64 * 1024)
+#define BENCH_WRITE_SIZE    (1024 * 1024)
+
+/* Twice the system view space */
+#ifdef _WIN64
+#define BENCH_FILE_SIZE     (1024 * 1024 * 1024)
+#else
+#define BENCH_FILE_SIZE     (64 * 1024 * 1024)
+#endif
+
+#define BENCH_BLOCKS        (BENCH_FILE_SIZE / BENCH_BLOCK_SIZE)
+
+static UNICODE_STRING BenchFileName = RTL_CONSTANT_STRING(L"\\SystemRoot\\kmtest-ccbench.tmp");
+
+static
+VOID
+FillBlock(
+    _Out_writes_bytes_(BENCH_BLOCK_SIZE) PULONG Buffer,
+    _In_ ULONG Block)
+{
+    ULONG i;
+
+    for (i = 0; i < BENCH_BLOCK_SIZE / sizeof(ULONG); i++)
+        Buffer[i] = Block ^ (i << 16);
+}
+
+static
+BOOLEAN
+CheckBlock(
+    _In_reads_bytes_(BENCH_BLOCK_SIZE) PULONG Buffer,
+    _In_ ULONG Block)
+{
+    ULONG i;
+
+    for (i = 0; i < BENCH_BLOCK_SIZE / sizeof(ULONG); i += PAGE_SIZE / sizeof(ULONG))
+    {
+        if (Buffer[i] != (Block ^ (i << 16)))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+static
+BOOLEAN
+WriteBenchFile(
+    _In_ HANDLE FileHandle,
+    _Out_writes_bytes_(BENCH_WRITE_SIZE) PUCHAR Buffer)
+{
+    NTSTATUS Status;
+    IO_STATUS_BLOCK IoStatusBlock;
+    LARGE_INTEGER Offset;
+    ULONG Block, i;
+
+    for (Block = 0; Block < BENCH_BLOCKS; Block += BENCH_WRITE_SIZE / BENCH_BLOCK_SIZE)
+    {
+        for (i = 0; i < BENCH_WRITE_SIZE / BENCH_BLOCK_SIZE; i++)
+            FillBlock((PULONG)(Buffer + i * BENCH_BLOCK_SIZE), Block + i);
+
+        Offset.QuadPart = (LONGLONG)Block * BENCH_BLOCK_SIZE;
+        Status = ZwWriteFile(FileHandle, NULL, NULL, NULL, &IoStatusBlock,
+                             Buffer, BENCH_WRITE_SIZE, &Offset, NULL);
+        if (!NT_SUCCESS(Status))
+        {
+            ok_eq_hex(Status, STATUS_SUCCESS);
+            return FALSE;
+        }
+    }
+
+    /* Start the reads with nothing dirty */
+    Status = ZwFlushBuffersFile(FileHandle, &IoStatusBlock);
+    ok_eq_hex(Status, STATUS_SUCCESS);
+    return TRUE;
+}
+
+static
+ULONGLONG
+ReadBenchFile(
+    _In_ HANDLE FileHandle,
+    _Out_writes_bytes_(BENCH_BLOCK_SIZE) PUCHAR Buffer,
+    _In_ BOOLEAN Random,
+    _In_ PCSTR Name)
+{
+    NTSTATUS Status;
+    IO_STATUS_BLOCK IoStatusBlock;
+    LARGE_INTEGER Offset, Start, End, Frequency;
+    ULONG Seed = 0x12345678;
+    ULONG Errors = 0;
+    ULONG Block, i;
+    ULONGLONG Milliseconds, Throughput;
+
+    Start = KeQueryPerformanceCounter(&Frequency);
+    for (i = 0; i < BENCH_BLOCKS; i++)
+    {
+        Block = Random ? RtlRandomEx(&Seed) % BENCH_BLOCKS : i;
+
+        Offset.QuadPart = (LONGLONG)Block * BENCH_BLOCK_SIZE;
+        Status = ZwReadFile(FileHandle, NULL, NULL, NULL, &IoStatusBlock,
+                            Buffer, BENCH_BLOCK_SIZE, &Offset, NULL);
+        if (!NT_SUCCESS(Status) ||
+            IoStatusBlock.Information != BENCH_BLOCK_SIZE ||
+            !CheckBlock((PULONG)Buffer, Block))
+        {
+            Errors++;
+        }
+    }
+    End = KeQueryPerformanceCounter(NULL);
+
+    ok(Errors == 0, "%s: %lu bad blocks\n", Name, Errors);
+
+    Milliseconds = (ULONGLONG)(End.QuadPart - Start.QuadPart) * 1000 / Frequency.QuadPart;
+    if (Milliseconds == 0)
+        Milliseconds = 1;
+    Throughput = (ULONGLONG)BENCH_FILE_SIZE / 1024 * 1000 / Milliseconds / 1024;
+
+    trace("%s: %lu MB in %I64u ms, %I64u MB/s\n",
+          Name, BENCH_FILE_SIZE / (1024 * 1024), Milliseconds, Throughput);
+    return Throughput;
+}
+
+START_TEST(CcFileCacheBench)
+{
+    NTSTATUS Status;
+    OBJECT_ATTRIBUTES ObjectAttributes;
+    IO_STATUS_BLOCK IoStatusBlock;
+    LARGE_INTEGER AllocationSize;
+    HANDLE FileHandle;
+    PUCHAR Buffer;
+
+    Buffer = ExAllocatePoolWithTag(PagedPool, BENCH_WRITE_SIZE, TAG_CACHEBENCH);
+    if (skip(Buffer != NULL, "Out of memory\n"))
+        return;
+
+    InitializeObjectAttributes(&ObjectAttributes,
+                               &BenchFileName,
+                               OBJ_KERNEL_HANDLE | OBJ_CASE_INSENSITIVE,
+                               NULL,
+                               NULL);
+    AllocationSize.QuadPart = BENCH_FILE_SIZE;
+    Status = ZwCreateFile(&FileHandle,
+                          GENERIC_READ | GENERIC_WRITE | SYNCHRONIZE,
+                          &ObjectAttributes,
+                          &IoStatusBlock,
+                          &AllocationSize,
+                          FILE_ATTRIBUTE_NORMAL,
+                          0,
+                          FILE_SUPERSEDE,
+                          FILE_NON_DIRECTORY_FILE | FILE_SYNCHRONOUS_IO_NONALERT | FILE_DELETE_ON_CLOSE,
+                          NULL,
+                          0);
+    ok_eq_hex(Status, STATUS_SUCCESS);
+    if (skip(NT_SUCCESS(Status), "Cannot create %wZ\n", &BenchFileName))
+    {
+        ExFreePoolWithTag(Buffer, TAG_CACHEBENCH);
+        return;
+    }
+
+    if (WriteBenchFile(FileHandle, Buffer))
+    {
+        /* The second sequential pass shows what the first one left behind */
+        ReadBenchFile(FileHandle, Buffer, FALSE, "Sequential");
+        ReadBenchFile(FileHandle, Buffer, FALSE, "Sequential again");
+        ReadBenchFile(FileHandle, Buffer, TRUE, "Random");
+    }
+
+    ZwClose(FileHandle);
+    ExFreePoolWithTag(Buffer, TAG_CACHEBENCH);
+}
@@ -0,0 +1,177 @@
+/*
+ * PROJECT:     ReactOS kernel-mode tests
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Kernel-Mode Test Suite handle creation and closing throughput
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include <kmt_test.h>
+
+#define NDEBUG
+#include <debug.h>
+
+#define TAG_HANDLECHURN     'chHT'
+#define CHURN_BATCH         64
+#define CHURN_SECONDS       2
+
+typedef struct _CHURN_CONTEXT
+{
+    PKTHREAD Thread;
+    PKEVENT StartEvent;
+    PVOID Object;
+    ULONG Number;
+    ULONG Failures;
+    ULONG Mismatches;
+    ULONGLONG Handles;
+    ULONGLONG Ticks;
+} CHURN_CONTEXT, *PCHURN_CONTEXT;
+
+static
+VOID
+NTAPI
+ChurnThread(
+    _In_ PVOID Context)
+{
+    PCHURN_CONTEXT Churn = Context;
+    HANDLE Handles[CHURN_BATCH];
+    LARGE_INTEGER Start, Now, Frequency;
+    LONGLONG Duration;
+    NTSTATUS Status;
+    PVOID Object;
+    ULONG i;
+
+    KeSetSystemAffinityThread((KAFFINITY)1 << Churn->Number);
+    KeWaitForSingleObject(Churn->StartEvent, Executive, KernelMode, FALSE, NULL);
+
+    Start = KeQueryPerformanceCounter(&Frequency);
+    Duration = Frequency.QuadPart * CHURN_SECONDS;
+    do
+    {
+        /* Open a batch of handles to the same event */
+        for (i = 0; i < CHURN_BATCH; i++)
+        {
+            Status = ObOpenObjectByPointer(Churn->Object,
+                                           OBJ_KERNEL_HANDLE,
+                                           NULL,
+                                           EVENT_ALL_ACCESS,
+                                           *ExEventObjectType,
+                                           KernelMode,
+                                           &Handles[i]);
+            if (!NT_SUCCESS(Status))
+            {
+                Churn->Failures++;
+                Handles[i] = NULL;
+            }
+        }
+
+        /* Check one of them still leads to our object */
+        if (Handles[CHURN_BATCH / 2])
+        {
+            Status = ObReferenceObjectByHandle(Handles[CHURN_BATCH / 2],
+                                               EVENT_ALL_ACCESS,
+                                               *ExEventObjectType,
+                                               KernelMode,
+                                               &Object,
+                                               NULL);
+            if (!NT_SUCCESS(Status) || Object != Churn->Object)
+                Churn->Mismatches++;
+            if (NT_SUCCESS(Status))
+                ObDereferenceObject(Object);
+        }
+
+        /* Close them in a different order than opened */
+        for (i = 0; i < CHURN_BATCH; i++)
+        {
+            HANDLE Handle = Handles[(i * 7) % CHURN_BATCH];
+            if (Handle)
+                ObCloseHandle(Handle, KernelMode);
+        }
+
+        Churn->Handles += CHURN_BATCH;
+        Now = KeQueryPerformanceCounter(NULL);
+    } while (Now.QuadPart - Start.QuadPart < Duration);
+    Churn->Ticks = (ULONGLONG)(Now.QuadPart - Start.QuadPart) * 1000 / Frequency.QuadPart;
+
+    KeRevertToUserAffinityThread();
+}
+
+START_TEST(ExHandleChurn)
+{
+    NTSTATUS Status;
+    OBJECT_ATTRIBUTES ObjectAttributes;
+    HANDLE EventHandle;
+    PVOID Event;
+    KAFFINITY Active;
+    PCHURN_CONTEXT Contexts;
+    KEVENT StartEvent;
+    ULONG Count = 0, Number, i;
+    ULONGLONG Total = 0;
+
+    /* All the threads open handles to this one */
+    InitializeObjectAttributes(&ObjectAttributes, NULL, OBJ_KERNEL_HANDLE, NULL, NULL);
+    Status = ZwCreateEvent(&EventHandle, EVENT_ALL_ACCESS, &ObjectAttributes, NotificationEvent, FALSE);
+    ok_eq_hex(Status, STATUS_SUCCESS);
+    if (skip(NT_SUCCESS(Status), "No event\n"))
+        return;
+
+    Status = ObReferenceObjectByHandle(EventHandle, EVENT_ALL_ACCESS, *ExEventObjectType, KernelMode, &Event, NULL);
+    ok_eq_hex(Status, STATUS_SUCCESS);
+    ObCloseHandle(EventHandle, KernelMode);
+    if (skip(NT_SUCCESS(Status), "No event object\n"))
+        return;
+
+    Active = KeQueryActiveProcessors();
+    Contexts = ExAllocatePoolWithTag(NonPagedPool,
+                                     sizeof(CHURN_CONTEXT) * sizeof(KAFFINITY) * 8,
+                                     TAG_HANDLECHURN);
+    if (skip(Contexts != NULL, "Out of memory\n"))
+    {
+        ObDereferenceObject(Event);
+        return;
+    }
+    RtlZeroMemory(Contexts, sizeof(CHURN_CONTEXT) * sizeof(KAFFINITY) * 8);
+
+    KeInitializeEvent(&StartEvent, NotificationEvent, FALSE);
+
+    /* One thread on each processor */
+    for (Number = 0; Number < sizeof(KAFFINITY) * 8; Number++)
+    {
+        if (!(Active & ((KAFFINITY)1 << Number)))
+            continue;
+
+        Contexts[Count].Number = Number;
+        Contexts[Count].StartEvent = &StartEvent;
+        Contexts[Count].Object = Event;
+        Contexts[Count].Thread = KmtStartThread(ChurnThread, &Contexts[Count]);
+        if (Contexts[Count].Thread)
+            Count++;
+    }
+    ok(Count != 0, "No thread started\n");
+
+    KeSetEvent(&StartEvent, IO_NO_INCREMENT, FALSE);
+    for (i = 0; i < Count; i++)
+        KmtFinishThread(Contexts[i].Thread, NULL);
+
+    /* Report the throughput of each processor */
+    for (i = 0; i < Count; i++)
+    {
+        ok_eq_ulong(Contexts[i].Failures, 0UL);
+        ok_eq_ulong(Contexts[i].Mismatches, 0UL);
+        ok(Contexts[i].Handles != 0, "CPU %lu did not create handles\n", Contexts[i].Number);
+        if (Contexts[i].Ticks == 0)
+            continue;
+
+        trace("CPU %lu: %I64u handles opened and closed per second\n",
+              Contexts[i].Number,
+              Contexts[i].Handles * 1000 / Contexts[i].Ticks);
+        Total += Contexts[i].Handles * 1000 / Contexts[i].Ticks;
+    }
+    if (Count)
+    {
+        trace("%lu processors: %I64u handles per second, %I64u per processor\n",
+              Count, Total, Total / Count);
+    }
+
+    ExFreePoolWithTag(Contexts, TAG_HANDLECHURN);
+    ObDereferenceObject(Event);
+}
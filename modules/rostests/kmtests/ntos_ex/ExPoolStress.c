@@ -0,0 +1,164 @@
+/*
+ * PROJECT:     ReactOS kernel-mode tests
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Kernel-Mode Test Suite nonpaged pool throughput on all processors
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include <kmt_test.h>
+
+#define NDEBUG
+#include <debug.h>
+
+#define TAG_POOLSTRESS      'sspT'
+#define STRESS_BATCH        16
+#define STRESS_HANDOFF      64
+#define STRESS_SECONDS      2
+
+typedef struct _STRESS_CONTEXT
+{
+    PKTHREAD Thread;
+    PKEVENT StartEvent;
+    ULONG Number;
+    ULONG Failures;
+    ULONGLONG Allocations;
+    ULONGLONG Ticks;
+    PVOID Handoff[STRESS_HANDOFF];
+} STRESS_CONTEXT, *PSTRESS_CONTEXT;
+
+/* Small sizes, the ones served by the lookaside lists and the pool pages */
+static const SIZE_T StressSizes[STRESS_BATCH] =
+{
+    8, 24, 40, 64, 100, 128, 200, 256, 16, 32, 48, 96, 160, 300, 480, 1000
+};
+
+static
+VOID
+NTAPI
+StressThread(
+    _In_ PVOID Context)
+{
+    PSTRESS_CONTEXT Stress = Context;
+    PVOID Blocks[STRESS_BATCH];
+    LARGE_INTEGER Start, Now, Frequency;
+    LONGLONG Duration;
+    ULONG i;
+
+    KeSetSystemAffinityThread((KAFFINITY)1 << Stress->Number);
+    KeWaitForSingleObject(Stress->StartEvent, Executive, KernelMode, FALSE, NULL);
+
+    Start = KeQueryPerformanceCounter(&Frequency);
+    Duration = Frequency.QuadPart * STRESS_SECONDS;
+    do
+    {
+        for (i = 0; i < STRESS_BATCH; i++)
+        {
+            Blocks[i] = ExAllocatePoolWithTag(NonPagedPool, StressSizes[i], TAG_POOLSTRESS);
+            if (!Blocks[i])
+            {
+                Stress->Failures++;
+                continue;
+            }
+            RtlFillMemory(Blocks[i], StressSizes[i], (UCHAR)Stress->Number);
+        }
+
+        /* Free in a different order than allocated */
+        for (i = 0; i < STRESS_BATCH; i++)
+        {
+            PVOID Block = Blocks[(i * 7) % STRESS_BATCH];
+            if (Block)
+                ExFreePoolWithTag(Block, TAG_POOLSTRESS);
+        }
+
+        Stress->Allocations += STRESS_BATCH;
+        Now = KeQueryPerformanceCounter(NULL);
+    } while (Now.QuadPart - Start.QuadPart < Duration);
+    Stress->Ticks = (ULONGLONG)(Now.QuadPart - Start.QuadPart) * 1000 / Frequency.QuadPart;
+
+    /* Leave some blocks behind for another processor to free */
+    for (i = 0; i < STRESS_HANDOFF; i++)
+    {
+        Stress->Handoff[i] = ExAllocatePoolWithTag(NonPagedPool,
+                                                   StressSizes[i % STRESS_BATCH],
+                                                   TAG_POOLSTRESS);
+        if (Stress->Handoff[i])
+            RtlFillMemory(Stress->Handoff[i], StressSizes[i % STRESS_BATCH], 0x55);
+    }
+
+    KeRevertToUserAffinityThread();
+}
+
+START_TEST(ExPoolStress)
+{
+    KAFFINITY Active;
+    PSTRESS_CONTEXT Contexts;
+    KEVENT StartEvent;
+    ULONG Count = 0, Number, i, j;
+    ULONGLONG Total = 0;
+
+    Active = KeQueryActiveProcessors();
+    Contexts = ExAllocatePoolWithTag(NonPagedPool,
+                                     sizeof(STRESS_CONTEXT) * sizeof(KAFFINITY) * 8,
+                                     TAG_POOLSTRESS);
+    if (skip(Contexts != NULL, "Out of memory\n"))
+        return;
+    RtlZeroMemory(Contexts, sizeof(STRESS_CONTEXT) * sizeof(KAFFINITY) * 8);
+
+    KeInitializeEvent(&StartEvent, NotificationEvent, FALSE);
+
+    /* One thread on each processor */
+    for (Number = 0; Number < sizeof(KAFFINITY) * 8; Number++)
+    {
+        if (!(Active & ((KAFFINITY)1 << Number)))
+            continue;
+
+        Contexts[Count].Number = Number;
+        Contexts[Count].StartEvent = &StartEvent;
+        Contexts[Count].Thread = KmtStartThread(StressThread, &Contexts[Count]);
+        if (Contexts[Count].Thread)
+            Count++;
+    }
+    ok(Count != 0, "No thread started\n");
+
+    KeSetEvent(&StartEvent, IO_NO_INCREMENT, FALSE);
+    for (i = 0; i < Count; i++)
+        KmtFinishThread(Contexts[i].Thread, NULL);
+
+    /* Free the blocks from the first processor, most of them came from another one */
+    KeSetSystemAffinityThread((KAFFINITY)1 << Contexts[0].Number);
+    for (i = 0; i < Count; i++)
+    {
+        for (j = 0; j < STRESS_HANDOFF; j++)
+        {
+            ok(Contexts[i].Handoff[j] != NULL, "CPU %lu: handoff block %lu is NULL\n",
+               Contexts[i].Number, j);
+            if (!Contexts[i].Handoff[j])
+                continue;
+            ok_eq_ulong(KmtGetPoolTag(Contexts[i].Handoff[j]), TAG_POOLSTRESS);
+            ok_eq_uint(KmtGetPoolType(Contexts[i].Handoff[j]), NonPagedPool + 1);
+            ExFreePoolWithTag(Contexts[i].Handoff[j], TAG_POOLSTRESS);
+        }
+    }
+    KeRevertToUserAffinityThread();
+
+    /* Report the throughput of each processor */
+    for (i = 0; i < Count; i++)
+    {
+        ok_eq_ulong(Contexts[i].Failures, 0UL);
+        ok(Contexts[i].Allocations != 0, "CPU %lu did not allocate\n", Contexts[i].Number);
+        if (Contexts[i].Ticks == 0)
+            continue;
+
+        trace("CPU %lu: %I64u allocations per second\n",
+              Contexts[i].Number,
+              Contexts[i].Allocations * 1000 / Contexts[i].Ticks);
+        Total += Contexts[i].Allocations * 1000 / Contexts[i].Ticks;
+    }
+    if (Count)
+    {
+        trace("%lu processors: %I64u allocations per second, %I64u per processor\n",
+              Count, Total, Total / Count);
+    }
+
+    ExFreePoolWithTag(Contexts, TAG_POOLSTRESS);
+}
@@ -0,0 +1,277 @@
+/*
+ * PROJECT:     ReactOS kernel-mode tests
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Kernel-Mode Test Suite directory traversal and path lookup throughput
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+/*
+ * Walks a directory tree on an NTFS volume a few times, opening every
+ * directory and file by its full path, and reports how many opens per
+ * second each pass manages. The first pass is cold, the next ones show what
+ * the driver kept in its file record and index buffer caches. The tree is
+ * the one below the DirectoryWalkRoot value of the Kmtest service key, for
+ * instance \??\N:\ on a large NTFS test volume, or the system root if it
+ * is not set. The test is skipped when that tree is not on NTFS.
+ */
+
+#include <kmt_test.h>
+
+#define NDEBUG
+#include <debug.h>
+
+#define TAG_DIRWALK         'wDoI'
+#define WALK_MAX_DEPTH      8
+#define WALK_PATH_LENGTH    512
+#define WALK_BUFFER_SIZE    4096
+#define WALK_PASSES         3
+
+typedef struct _WALK_CONTEXT
+{
+    UNICODE_STRING Path;
+    ULONG Directories;
+    ULONG Files;
+    ULONG Failures;
+} WALK_CONTEXT, *PWALK_CONTEXT;
+
+static UNICODE_STRING WalkRoot;
+static BOOLEAN WalkRootAllocated;
+
+static
+NTSTATUS
+OpenPath(
+    _In_ PUNICODE_STRING Path,
+    _In_ BOOLEAN Directory,
+    _Out_ PHANDLE Handle)
+{
+    OBJECT_ATTRIBUTES ObjectAttributes;
+    IO_STATUS_BLOCK IoStatusBlock;
+
+    InitializeObjectAttributes(&ObjectAttributes,
+                               Path,
+                               OBJ_KERNEL_HANDLE | OBJ_CASE_INSENSITIVE,
+                               NULL,
+                               NULL);
+    return ZwOpenFile(Handle,
+                      (Directory ? FILE_LIST_DIRECTORY : FILE_READ_ATTRIBUTES) | SYNCHRONIZE,
+                      &ObjectAttributes,
+                      &IoStatusBlock,
+                      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                      (Directory ? FILE_DIRECTORY_FILE : 0) | FILE_SYNCHRONOUS_IO_NONALERT);
+}
+
+static
+VOID
+WalkDirectory(
+    _Inout_ PWALK_CONTEXT Walk,
+    _In_ ULONG Depth)
+{
+    NTSTATUS Status;
+    IO_STATUS_BLOCK IoStatusBlock;
+    HANDLE DirectoryHandle, FileHandle;
+    PFILE_DIRECTORY_INFORMATION Buffer, Entry;
+    UNICODE_STRING Name;
+    USHORT PathLength = Walk->Path.Length;
+    BOOLEAN Restart = TRUE;
+
+    Status = OpenPath(&Walk->Path, TRUE, &DirectoryHandle);
+    if (!NT_SUCCESS(Status))
+    {
+        Walk->Failures++;
+        return;
+    }
+    Walk->Directories++;
+
+    Buffer = ExAllocatePoolWithTag(PagedPool, WALK_BUFFER_SIZE, TAG_DIRWALK);
+    if (Buffer == NULL)
+    {
+        Walk->Failures++;
+        ZwClose(DirectoryHandle);
+        return;
+    }
+
+    for (;;)
+    {
+        Status = ZwQueryDirectoryFile(DirectoryHandle,
+                                      NULL,
+                                      NULL,
+                                      NULL,
+                                      &IoStatusBlock,
+                                      Buffer,
+                                      WALK_BUFFER_SIZE,
+                                      FileDirectoryInformation,
+                                      FALSE,
+                                      NULL,
+                                      Restart);
+        if (!NT_SUCCESS(Status))
+            break;
+        Restart = FALSE;
+
+        for (Entry = Buffer; ; Entry = (PVOID)((ULONG_PTR)Entry + Entry->NextEntryOffset))
+        {
+            Name.Buffer = Entry->FileName;
+            Name.Length = Name.MaximumLength = (USHORT)Entry->FileNameLength;
+
+            /* Skip . and .. */
+            if (Name.Buffer[0] == L'.' &&
+                (Name.Length == sizeof(WCHAR) ||
+                 (Name.Length == 2 * sizeof(WCHAR) && Name.Buffer[1] == L'.')))
+            {
+                goto Next;
+            }
+
+            Walk->Path.Length = PathLength;
+            if (!NT_SUCCESS(RtlAppendUnicodeToString(&Walk->Path, L"\\")) ||
+                !NT_SUCCESS(RtlAppendUnicodeStringToString(&Walk->Path, &Name)))
+            {
+                goto Next;
+            }
+
+            /* Every open looks up each component of the full path again */
+            if (Entry->FileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            {
+                if (Depth < WALK_MAX_DEPTH)
+                    WalkDirectory(Walk, Depth + 1);
+            }
+            else
+            {
+                Status = OpenPath(&Walk->Path, FALSE, &FileHandle);
+                if (NT_SUCCESS(Status))
+                {
+                    Walk->Files++;
+                    ZwClose(FileHandle);
+                }
+                else
+                {
+                    Walk->Failures++;
+                }
+            }
+
+Next:
+            if (Entry->NextEntryOffset == 0)
+                break;
+        }
+    }
+
+    Walk->Path.Length = PathLength;
+    ExFreePoolWithTag(Buffer, TAG_DIRWALK);
+    ZwClose(DirectoryHandle);
+}
+
+static
+VOID
+GetWalkRoot(VOID)
+{
+    static UNICODE_STRING DefaultRoot = RTL_CONSTANT_STRING(L"\\SystemRoot");
+    RTL_QUERY_REGISTRY_TABLE QueryTable[2];
+    NTSTATUS Status;
+
+    RtlInitEmptyUnicodeString(&WalkRoot, NULL, 0);
+    RtlZeroMemory(QueryTable, sizeof(QueryTable));
+    QueryTable[0].Flags = RTL_QUERY_REGISTRY_DIRECT | RTL_QUERY_REGISTRY_REQUIRED;
+    QueryTable[0].Name = L"DirectoryWalkRoot";
+    QueryTable[0].EntryContext = &WalkRoot;
+    Status = RtlQueryRegistryValues(RTL_REGISTRY_ABSOLUTE,
+                                    L"\\Registry\\Machine\\SYSTEM\\CurrentControlSet\\Services\\Kmtest",
+                                    QueryTable,
+                                    NULL,
+                                    NULL);
+    WalkRootAllocated = (WalkRoot.Buffer != NULL);
+    if (!NT_SUCCESS(Status) || WalkRoot.Length == 0)
+    {
+        if (WalkRootAllocated)
+            RtlFreeUnicodeString(&WalkRoot);
+        WalkRootAllocated = FALSE;
+        WalkRoot = DefaultRoot;
+    }
+}
+
+static
+BOOLEAN
+IsWalkRootOnNtfs(VOID)
+{
+    NTSTATUS Status;
+    IO_STATUS_BLOCK IoStatusBlock;
+    HANDLE Handle;
+    UCHAR Buffer[sizeof(FILE_FS_ATTRIBUTE_INFORMATION) + 32 * sizeof(WCHAR)];
+    PFILE_FS_ATTRIBUTE_INFORMATION Attributes = (PVOID)Buffer;
+    UNICODE_STRING Name;
+    static UNICODE_STRING Ntfs = RTL_CONSTANT_STRING(L"NTFS");
+    BOOLEAN IsNtfs = FALSE;
+
+    Status = OpenPath(&WalkRoot, TRUE, &Handle);
+    ok_eq_hex(Status, STATUS_SUCCESS);
+    if (!NT_SUCCESS(Status))
+        return FALSE;
+
+    Status = ZwQueryVolumeInformationFile(Handle,
+                                          &IoStatusBlock,
+                                          Attributes,
+                                          sizeof(Buffer),
+                                          FileFsAttributeInformation);
+    if (NT_SUCCESS(Status))
+    {
+        Name.Buffer = Attributes->FileSystemName;
+        Name.Length = Name.MaximumLength = (USHORT)Attributes->FileSystemNameLength;
+        trace("Walking %wZ on %wZ\n", &WalkRoot, &Name);
+        IsNtfs = RtlEqualUnicodeString(&Name, &Ntfs, FALSE);
+    }
+
+    ZwClose(Handle);
+    return IsNtfs;
+}
+
+START_TEST(IoDirectoryWalk)
+{
+    WALK_CONTEXT Walk;
+    LARGE_INTEGER Start, End, Frequency;
+    ULONGLONG Milliseconds;
+    ULONG Directories = 0, Files = 0, Pass;
+
+    GetWalkRoot();
+    if (skip(IsWalkRootOnNtfs(), "%wZ is not on an NTFS volume\n", &WalkRoot))
+        goto Cleanup;
+
+    RtlZeroMemory(&Walk, sizeof(Walk));
+    Walk.Path.MaximumLength = WALK_PATH_LENGTH * sizeof(WCHAR);
+    Walk.Path.Buffer = ExAllocatePoolWithTag(PagedPool, Walk.Path.MaximumLength, TAG_DIRWALK);
+    if (skip(Walk.Path.Buffer != NULL, "Out of memory\n"))
+        goto Cleanup;
+
+    for (Pass = 0; Pass < WALK_PASSES; Pass++)
+    {
+        Walk.Directories = 0;
+        Walk.Files = 0;
+        Walk.Failures = 0;
+        RtlCopyUnicodeString(&Walk.Path, &WalkRoot);
+
+        Start = KeQueryPerformanceCounter(&Frequency);
+        WalkDirectory(&Walk, 0);
+        End = KeQueryPerformanceCounter(NULL);
+
+        Milliseconds = (ULONGLONG)(End.QuadPart - Start.QuadPart) * 1000 / Frequency.QuadPart;
+        if (Milliseconds == 0)
+            Milliseconds = 1;
+
+        trace("Pass %lu: %lu directories, %lu files, %lu failures in %I64u ms, %I64u opens per second\n",
+              Pass, Walk.Directories, Walk.Files, Walk.Failures, Milliseconds,
+              (ULONGLONG)(Walk.Directories + Walk.Files) * 1000 / Milliseconds);
+
+        ok(Walk.Files != 0, "Pass %lu found no file\n", Pass);
+
+        /* Caching must not change what the walk sees */
+        if (Pass != 0)
+        {
+            ok_eq_ulong(Walk.Directories, Directories);
+            ok_eq_ulong(Walk.Files, Files);
+        }
+        Directories = Walk.Directories;
+        Files = Walk.Files;
+    }
+
+    ExFreePoolWithTag(Walk.Path.Buffer, TAG_DIRWALK);
+
+Cleanup:
+    if (WalkRootAllocated)
+        RtlFreeUnicodeString(&WalkRoot);
+}
@@ -0,0 +1,254 @@
+/*
+ * PROJECT:     ReactOS kernel-mode tests
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Kernel-Mode Test Suite file write and read throughput
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+/*
+ * Writes two files at the same time in small chunks, the way two downloads
+ * or a log and a database do, and reports how fast the writes go and in
+ * how many extents each file ended up. Then it reads one of them back with
+ * caching disabled, in order and at random, which shows what the layout
+ * and the block lookups cost. An allocator handing out blocks one write at
+ * a time leaves both files in a fragment per chunk. Run it with the system
+ * root on a volume formatted with the file system to measure, an ext4
+ * image made with mkfs.ext4 for the ext2 driver.
+ */
+
+#include <kmt_test.h>
+
+#define NDEBUG
+#include <debug.h>
+
+#define THROUGHPUT_FILE_SIZE    (16 * 1024 * 1024)
+#define THROUGHPUT_CHUNK        (64 * 1024)
+#define THROUGHPUT_READ         4096
+#define THROUGHPUT_RANDOM_READS 2000
+
+static UNICODE_STRING FileNames[] =
+{
+    RTL_CONSTANT_STRING(L"\\SystemRoot\\Temp\\KmtestThroughput1.bin"),
+    RTL_CONSTANT_STRING(L"\\SystemRoot\\Temp\\KmtestThroughput2.bin"),
+};
+
+static
+NTSTATUS
+OpenFile(
+    _In_ PUNICODE_STRING Name,
+    _In_ BOOLEAN Create,
+    _Out_ PHANDLE Handle)
+{
+    OBJECT_ATTRIBUTES ObjectAttributes;
+    IO_STATUS_BLOCK IoStatusBlock;
+
+    InitializeObjectAttributes(&ObjectAttributes,
+                               Name,
+                               OBJ_KERNEL_HANDLE | OBJ_CASE_INSENSITIVE,
+                               NULL,
+                               NULL);
+    return ZwCreateFile(Handle,
+                        (Create ? GENERIC_WRITE : GENERIC_READ) | DELETE | SYNCHRONIZE,
+                        &ObjectAttributes,
+                        &IoStatusBlock,
+                        NULL,
+                        FILE_ATTRIBUTE_NORMAL,
+                        FILE_SHARE_READ | FILE_SHARE_DELETE,
+                        Create ? FILE_SUPERSEDE : FILE_OPEN,
+                        FILE_NON_DIRECTORY_FILE | FILE_SYNCHRONOUS_IO_NONALERT |
+                        (Create ? FILE_WRITE_THROUGH : FILE_NO_INTERMEDIATE_BUFFERING),
+                        NULL,
+                        0);
+}
+
+static
+ULONG
+CountExtents(
+    _In_ HANDLE Handle)
+{
+    NTSTATUS Status;
+    IO_STATUS_BLOCK IoStatusBlock;
+    STARTING_VCN_INPUT_BUFFER StartingVcn;
+    struct
+    {
+        RETRIEVAL_POINTERS_BUFFER Header;
+        LARGE_INTEGER More[63 * 2];
+    } Pointers;
+    ULONG Extents = 0;
+
+    StartingVcn.StartingVcn.QuadPart = 0;
+    do
+    {
+        Status = ZwFsControlFile(Handle,
+                                 NULL,
+                                 NULL,
+                                 NULL,
+                                 &IoStatusBlock,
+                                 FSCTL_GET_RETRIEVAL_POINTERS,
+                                 &StartingVcn,
+                                 sizeof(StartingVcn),
+                                 &Pointers,
+                                 sizeof(Pointers));
+        if (!NT_SUCCESS(Status) || Pointers.Header.ExtentCount == 0)
+            break;
+
+        Extents += Pointers.Header.ExtentCount;
+        StartingVcn.StartingVcn =
+            Pointers.Header.Extents[Pointers.Header.ExtentCount - 1].NextVcn;
+    } while (Status == STATUS_BUFFER_OVERFLOW);
+
+    if (!NT_SUCCESS(Status) && Status != STATUS_END_OF_FILE)
+        trace("FSCTL_GET_RETRIEVAL_POINTERS failed with 0x%lx\n", Status);
+
+    return Extents;
+}
+
+static
+ULONGLONG
+KiloBytesPerSecond(
+    _In_ ULONGLONG Bytes,
+    _In_ LARGE_INTEGER Start,
+    _In_ LARGE_INTEGER End,
+    _In_ LARGE_INTEGER Frequency)
+{
+    ULONGLONG Microseconds;
+
+    Microseconds = (ULONGLONG)(End.QuadPart - Start.QuadPart) * 1000000 / Frequency.QuadPart;
+    if (Microseconds == 0)
+        Microseconds = 1;
+    return Bytes * 1000000 / 1024 / Microseconds;
+}
+
+START_TEST(IoFileThroughput)
+{
+    NTSTATUS Status;
+    IO_STATUS_BLOCK IoStatusBlock;
+    FILE_DISPOSITION_INFORMATION Disposition;
+    HANDLE Handles[RTL_NUMBER_OF(FileNames)] = { NULL };
+    LARGE_INTEGER Start, End, Frequency, Offset;
+    PUCHAR Buffer;
+    ULONG Seed = 0x5eed7e57;
+    ULONG Failures = 0, i, j;
+
+    Buffer = ExAllocatePoolWithTag(NonPagedPool, THROUGHPUT_CHUNK, 'TFmK');
+    if (skip(Buffer != NULL, "Out of memory\n"))
+        return;
+    RtlFillMemory(Buffer, THROUGHPUT_CHUNK, 0x5a);
+
+    for (j = 0; j < RTL_NUMBER_OF(FileNames); j++)
+    {
+        Status = OpenFile(&FileNames[j], TRUE, &Handles[j]);
+        ok_eq_hex(Status, STATUS_SUCCESS);
+        if (skip(NT_SUCCESS(Status), "Cannot create %wZ\n", &FileNames[j]))
+            goto Cleanup;
+    }
+
+    /* Both files grow at the same time, one chunk each in turn, written through */
+    Start = KeQueryPerformanceCounter(&Frequency);
+    for (i = 0; i < THROUGHPUT_FILE_SIZE / THROUGHPUT_CHUNK; i++)
+    {
+        for (j = 0; j < RTL_NUMBER_OF(Handles); j++)
+        {
+            Status = ZwWriteFile(Handles[j],
+                                 NULL,
+                                 NULL,
+                                 NULL,
+                                 &IoStatusBlock,
+                                 Buffer,
+                                 THROUGHPUT_CHUNK,
+                                 NULL,
+                                 NULL);
+            if (!NT_SUCCESS(Status))
+                Failures++;
+        }
+    }
+    End = KeQueryPerformanceCounter(NULL);
+    ok_eq_ulong(Failures, 0UL);
+
+    trace("Interleaved writes of %lu bytes: %I64u KB per second\n",
+          (ULONG)(THROUGHPUT_FILE_SIZE * RTL_NUMBER_OF(Handles)),
+          KiloBytesPerSecond((ULONGLONG)THROUGHPUT_FILE_SIZE * RTL_NUMBER_OF(Handles),
+                             Start, End, Frequency));
+
+    for (j = 0; j < RTL_NUMBER_OF(Handles); j++)
+    {
+        trace("%wZ: %lu extents\n", &FileNames[j], CountExtents(Handles[j]));
+        ZwClose(Handles[j]);
+        Handles[j] = NULL;
+    }
+
+    Status = OpenFile(&FileNames[0], FALSE, &Handles[0]);
+    ok_eq_hex(Status, STATUS_SUCCESS);
+    if (skip(NT_SUCCESS(Status), "Cannot open %wZ\n", &FileNames[0]))
+        goto Cleanup;
+
+    /* Non-cached reads in order */
+    Failures = 0;
+    Start = KeQueryPerformanceCounter(&Frequency);
+    for (i = 0; i < THROUGHPUT_FILE_SIZE / THROUGHPUT_CHUNK; i++)
+    {
+        Offset.QuadPart = (LONGLONG)i * THROUGHPUT_CHUNK;
+        Status = ZwReadFile(Handles[0],
+                            NULL,
+                            NULL,
+                            NULL,
+                            &IoStatusBlock,
+                            Buffer,
+                            THROUGHPUT_CHUNK,
+                            &Offset,
+                            NULL);
+        if (!NT_SUCCESS(Status))
+            Failures++;
+    }
+    End = KeQueryPerformanceCounter(NULL);
+    ok_eq_ulong(Failures, 0UL);
+    trace("Sequential reads: %I64u KB per second\n",
+          KiloBytesPerSecond(THROUGHPUT_FILE_SIZE, Start, End, Frequency));
+
+    /* And small ones at random, which each need their block looked up */
+    Start = KeQueryPerformanceCounter(&Frequency);
+    for (i = 0; i < THROUGHPUT_RANDOM_READS; i++)
+    {
+        Offset.QuadPart = (LONGLONG)(RtlRandomEx(&Seed) % (THROUGHPUT_FILE_SIZE / THROUGHPUT_READ)) *
+                          THROUGHPUT_READ;
+        Status = ZwReadFile(Handles[0],
+                            NULL,
+                            NULL,
+                            NULL,
+                            &IoStatusBlock,
+                            Buffer,
+                            THROUGHPUT_READ,
+                            &Offset,
+                            NULL);
+        if (!NT_SUCCESS(Status))
+            Failures++;
+    }
+    End = KeQueryPerformanceCounter(NULL);
+    ok_eq_ulong(Failures, 0UL);
+    trace("%lu random reads of %lu bytes: %I64u KB per second\n",
+          (ULONG)THROUGHPUT_RANDOM_READS, (ULONG)THROUGHPUT_READ,
+          KiloBytesPerSecond((ULONGLONG)THROUGHPUT_RANDOM_READS * THROUGHPUT_READ,
+                             Start, End, Frequency));
+
+Cleanup:
+    for (j = 0; j < RTL_NUMBER_OF(FileNames); j++)
+    {
+        if (Handles[j] == NULL)
+        {
+            Status = OpenFile(&FileNames[j], FALSE, &Handles[j]);
+            if (!NT_SUCCESS(Status))
+                continue;
+        }
+
+        Disposition.DeleteFile = TRUE;
+        Status = ZwSetInformationFile(Handles[j],
+                                      &IoStatusBlock,
+                                      &Disposition,
+                                      sizeof(Disposition),
+                                      FileDispositionInformation);
+        ok_eq_hex(Status, STATUS_SUCCESS);
+        ZwClose(Handles[j]);
+    }
+
+    ExFreePoolWithTag(Buffer, 'TFmK');
+}
@@ -0,0 +1,323 @@
+/*
+ * PROJECT:     ReactOS kernel-mode tests
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Kernel-Mode Test Suite create and open throughput in a large directory
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+/*
+ * Fills one directory with many files with long names, the way a camera or
+ * a logger does, and reports how fast the creates go as it grows, then how
+ * fast the files open again by name and how fast names that are not there
+ * are looked up. Without a name index each create or miss walks the whole
+ * directory, so the create rate falls as the directory fills. It measures
+ * the name index of fastfat, so it runs only with the system root on a FAT
+ * volume and is skipped otherwise.
+ */
+
+#include <kmt_test.h>
+#include <ntstrsafe.h>
+
+#define NDEBUG
+#include <debug.h>
+
+#define LARGEDIR_FILES      20000
+#define LARGEDIR_BATCH      5000
+#define LARGEDIR_MISSES     2000
+#define LARGEDIR_NAME_CHARS 64
+#define LARGEDIR_BUFFER_SIZE 4096
+#define TAG_LARGEDIR        'DLoI'
+
+static UNICODE_STRING ParentName = RTL_CONSTANT_STRING(L"\\SystemRoot\\Temp");
+static UNICODE_STRING DirectoryName = RTL_CONSTANT_STRING(L"\\SystemRoot\\Temp\\KmtestLargeDirectory");
+
+static
+BOOLEAN
+IsFatVolume(VOID)
+{
+    NTSTATUS Status;
+    OBJECT_ATTRIBUTES ObjectAttributes;
+    IO_STATUS_BLOCK IoStatusBlock;
+    HANDLE Handle;
+    UCHAR Buffer[sizeof(FILE_FS_ATTRIBUTE_INFORMATION) + 32 * sizeof(WCHAR)];
+    PFILE_FS_ATTRIBUTE_INFORMATION Attributes = (PVOID)Buffer;
+    UNICODE_STRING Name;
+    static UNICODE_STRING Fat = RTL_CONSTANT_STRING(L"FAT");
+    static UNICODE_STRING Fat32 = RTL_CONSTANT_STRING(L"FAT32");
+    BOOLEAN IsFat = FALSE;
+
+    InitializeObjectAttributes(&ObjectAttributes,
+                               &ParentName,
+                               OBJ_KERNEL_HANDLE | OBJ_CASE_INSENSITIVE,
+                               NULL,
+                               NULL);
+    Status = ZwOpenFile(&Handle,
+                        FILE_LIST_DIRECTORY | SYNCHRONIZE,
+                        &ObjectAttributes,
+                        &IoStatusBlock,
+                        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                        FILE_DIRECTORY_FILE | FILE_SYNCHRONOUS_IO_NONALERT);
+    ok_eq_hex(Status, STATUS_SUCCESS);
+    if (!NT_SUCCESS(Status))
+        return FALSE;
+
+    Status = ZwQueryVolumeInformationFile(Handle,
+                                          &IoStatusBlock,
+                                          Attributes,
+                                          sizeof(Buffer),
+                                          FileFsAttributeInformation);
+    if (NT_SUCCESS(Status))
+    {
+        Name.Buffer = Attributes->FileSystemName;
+        Name.Length = Name.MaximumLength = (USHORT)Attributes->FileSystemNameLength;
+        trace("%wZ is on %wZ\n", &ParentName, &Name);
+        IsFat = RtlEqualUnicodeString(&Name, &Fat, FALSE) ||
+                RtlEqualUnicodeString(&Name, &Fat32, FALSE);
+    }
+
+    ZwClose(Handle);
+    return IsFat;
+}
+
+/* Deletes everything in the directory, also what a failed run left there */
+static
+ULONG
+EmptyDirectory(
+    _In_ HANDLE DirectoryHandle)
+{
+    NTSTATUS Status;
+    OBJECT_ATTRIBUTES ObjectAttributes;
+    IO_STATUS_BLOCK IoStatusBlock;
+    PFILE_DIRECTORY_INFORMATION Buffer, Entry;
+    UNICODE_STRING Name;
+    HANDLE Handle;
+    ULONG Deleted, Failures = 0;
+
+    Buffer = ExAllocatePoolWithTag(PagedPool, LARGEDIR_BUFFER_SIZE, TAG_LARGEDIR);
+    if (Buffer == NULL)
+        return 1;
+
+    do
+    {
+        /* Start over each time, the deletes change what follows */
+        Deleted = 0;
+        Status = ZwQueryDirectoryFile(DirectoryHandle,
+                                      NULL,
+                                      NULL,
+                                      NULL,
+                                      &IoStatusBlock,
+                                      Buffer,
+                                      LARGEDIR_BUFFER_SIZE,
+                                      FileDirectoryInformation,
+                                      FALSE,
+                                      NULL,
+                                      TRUE);
+        if (!NT_SUCCESS(Status))
+            break;
+
+        for (Entry = Buffer; ; Entry = (PVOID)((ULONG_PTR)Entry + Entry->NextEntryOffset))
+        {
+            Name.Buffer = Entry->FileName;
+            Name.Length = Name.MaximumLength = (USHORT)Entry->FileNameLength;
+
+            /* Skip . and .. */
+            if (!(Name.Buffer[0] == L'.' &&
+                  (Name.Length == sizeof(WCHAR) ||
+                   (Name.Length == 2 * sizeof(WCHAR) && Name.Buffer[1] == L'.'))))
+            {
+                InitializeObjectAttributes(&ObjectAttributes,
+                                           &Name,
+                                           OBJ_KERNEL_HANDLE | OBJ_CASE_INSENSITIVE,
+                                           DirectoryHandle,
+                                           NULL);
+                Status = ZwOpenFile(&Handle,
+                                    DELETE | SYNCHRONIZE,
+                                    &ObjectAttributes,
+                                    &IoStatusBlock,
+                                    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                    FILE_NON_DIRECTORY_FILE | FILE_SYNCHRONOUS_IO_NONALERT |
+                                    FILE_DELETE_ON_CLOSE);
+                if (NT_SUCCESS(Status))
+                {
+                    ZwClose(Handle);
+                    Deleted++;
+                }
+                else
+                {
+                    Failures++;
+                }
+            }
+
+            if (Entry->NextEntryOffset == 0)
+                break;
+        }
+    } while (Deleted != 0);
+
+    ExFreePoolWithTag(Buffer, TAG_LARGEDIR);
+    return Failures;
+}
+
+static
+NTSTATUS
+OpenInDirectory(
+    _In_ HANDLE DirectoryHandle,
+    _In_ ULONG Number,
+    _In_ BOOLEAN Create,
+    _In_ BOOLEAN Delete)
+{
+    NTSTATUS Status;
+    OBJECT_ATTRIBUTES ObjectAttributes;
+    IO_STATUS_BLOCK IoStatusBlock;
+    UNICODE_STRING Name;
+    WCHAR NameBuffer[LARGEDIR_NAME_CHARS];
+    HANDLE Handle;
+
+    RtlInitEmptyUnicodeString(&Name, NameBuffer, sizeof(NameBuffer));
+    Status = RtlUnicodeStringPrintf(&Name, L"Capture %06lu from the large directory test.jpg", Number);
+    if (!NT_SUCCESS(Status))
+        return Status;
+
+    InitializeObjectAttributes(&ObjectAttributes,
+                               &Name,
+                               OBJ_KERNEL_HANDLE | OBJ_CASE_INSENSITIVE,
+                               DirectoryHandle,
+                               NULL);
+    Status = ZwCreateFile(&Handle,
+                          (Delete ? DELETE : FILE_READ_ATTRIBUTES) | SYNCHRONIZE,
+                          &ObjectAttributes,
+                          &IoStatusBlock,
+                          NULL,
+                          FILE_ATTRIBUTE_NORMAL,
+                          FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                          Create ? FILE_CREATE : FILE_OPEN,
+                          FILE_NON_DIRECTORY_FILE | FILE_SYNCHRONOUS_IO_NONALERT |
+                          (Delete ? FILE_DELETE_ON_CLOSE : 0),
+                          NULL,
+                          0);
+    if (NT_SUCCESS(Status))
+        ZwClose(Handle);
+    return Status;
+}
+
+static
+ULONGLONG
+PerSecond(
+    _In_ ULONG Count,
+    _In_ LARGE_INTEGER Start,
+    _In_ LARGE_INTEGER End,
+    _In_ LARGE_INTEGER Frequency)
+{
+    ULONGLONG Microseconds;
+
+    Microseconds = (ULONGLONG)(End.QuadPart - Start.QuadPart) * 1000000 / Frequency.QuadPart;
+    if (Microseconds == 0)
+        Microseconds = 1;
+    return (ULONGLONG)Count * 1000000 / Microseconds;
+}
+
+START_TEST(IoLargeDirectory)
+{
+    NTSTATUS Status;
+    OBJECT_ATTRIBUTES ObjectAttributes;
+    IO_STATUS_BLOCK IoStatusBlock;
+    FILE_DISPOSITION_INFORMATION Disposition;
+    HANDLE DirectoryHandle;
+    LARGE_INTEGER Start, End, Frequency;
+    ULONG Seed = 0x1a26e0d1;
+    ULONG Created = 0, Failures = 0, Found = 0, i;
+
+    if (skip(IsFatVolume(), "%wZ is not on a FAT volume\n", &ParentName))
+        return;
+
+    InitializeObjectAttributes(&ObjectAttributes,
+                               &DirectoryName,
+                               OBJ_KERNEL_HANDLE | OBJ_CASE_INSENSITIVE,
+                               NULL,
+                               NULL);
+    Status = ZwCreateFile(&DirectoryHandle,
+                          FILE_LIST_DIRECTORY | DELETE | SYNCHRONIZE,
+                          &ObjectAttributes,
+                          &IoStatusBlock,
+                          NULL,
+                          FILE_ATTRIBUTE_NORMAL,
+                          FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                          FILE_OPEN_IF,
+                          FILE_DIRECTORY_FILE | FILE_SYNCHRONOUS_IO_NONALERT,
+                          NULL,
+                          0);
+    ok_eq_hex(Status, STATUS_SUCCESS);
+    if (skip(NT_SUCCESS(Status), "Cannot create %wZ\n", &DirectoryName))
+        return;
+
+    /* Start from an empty directory even if an earlier run died half way */
+    if (skip(EmptyDirectory(DirectoryHandle) == 0, "Cannot empty %wZ\n", &DirectoryName))
+        goto Cleanup;
+
+    /* Every create has to make sure the name is not there yet */
+    while (Created < LARGEDIR_FILES)
+    {
+        Start = KeQueryPerformanceCounter(&Frequency);
+        for (i = 0; i < LARGEDIR_BATCH; i++)
+        {
+            Status = OpenInDirectory(DirectoryHandle, Created + i, TRUE, FALSE);
+            if (!NT_SUCCESS(Status))
+                Failures++;
+        }
+        End = KeQueryPerformanceCounter(NULL);
+        Created += LARGEDIR_BATCH;
+
+        trace("Files %lu to %lu: %I64u creates per second\n",
+              Created - LARGEDIR_BATCH, Created,
+              PerSecond(LARGEDIR_BATCH, Start, End, Frequency));
+    }
+    ok_eq_ulong(Failures, 0UL);
+
+    /* Open them all again in random order */
+    Start = KeQueryPerformanceCounter(&Frequency);
+    for (i = 0; i < LARGEDIR_FILES; i++)
+    {
+        Status = OpenInDirectory(DirectoryHandle, RtlRandomEx(&Seed) % LARGEDIR_FILES, FALSE, FALSE);
+        if (NT_SUCCESS(Status))
+            Found++;
+    }
+    End = KeQueryPerformanceCounter(NULL);
+    trace("%lu opens: %I64u per second\n",
+          (ULONG)LARGEDIR_FILES, PerSecond(LARGEDIR_FILES, Start, End, Frequency));
+    ok_eq_ulong(Found, (ULONG)LARGEDIR_FILES);
+
+    /* And look up names that are not there */
+    Found = 0;
+    Start = KeQueryPerformanceCounter(&Frequency);
+    for (i = 0; i < LARGEDIR_MISSES; i++)
+    {
+        Status = OpenInDirectory(DirectoryHandle, LARGEDIR_FILES + i, FALSE, FALSE);
+        if (Status != STATUS_OBJECT_NAME_NOT_FOUND)
+            Found++;
+    }
+    End = KeQueryPerformanceCounter(NULL);
+    trace("%lu misses: %I64u per second\n",
+          (ULONG)LARGEDIR_MISSES, PerSecond(LARGEDIR_MISSES, Start, End, Frequency));
+    ok_eq_ulong(Found, 0UL);
+
+    /* Delete them by name, which also shows deletes keep the names findable */
+    Failures = 0;
+    for (i = 0; i < LARGEDIR_FILES; i++)
+    {
+        Status = OpenInDirectory(DirectoryHandle, i, FALSE, TRUE);
+        if (!NT_SUCCESS(Status))
+            Failures++;
+    }
+    ok_eq_ulong(Failures, 0UL);
+
+Cleanup:
+    ok_eq_ulong(EmptyDirectory(DirectoryHandle), 0UL);
+
+    Disposition.DeleteFile = TRUE;
+    Status = ZwSetInformationFile(DirectoryHandle,
+                                  &IoStatusBlock,
+                                  &Disposition,
+                                  sizeof(Disposition),
+                                  FileDispositionInformation);
+    ok_eq_hex(Status, STATUS_SUCCESS);
+    ZwClose(DirectoryHandle);
+}
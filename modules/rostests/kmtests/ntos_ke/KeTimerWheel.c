@@ -0,0 +1,232 @@
+/*
+ * PROJECT:     ReactOS kernel-mode tests
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Kernel-Mode Test Suite timer arming, expiration and coalescing
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+/*
+ * Arms a large number of timers, most of them far in the future, and reports
+ * what arming them costs and how much time the clock interrupt and the timer
+ * expiration DPC take from a spinning thread while they are pending. The near
+ * ones must all fire and the far ones must all still be there to cancel.
+ */
+
+#include <kmt_test.h>
+
+#define NDEBUG
+#include <debug.h>
+
+#define TAG_TIMERWHEEL      'wTTK'
+#define WHEEL_TIMERS        100000
+#define WHEEL_SHORT_EVERY   10
+#define WHEEL_COALESCED     64
+#define WHEEL_SPIN_SECONDS  1
+
+/* Relative due times, in 100ns units */
+#define MS(x)               ((LONGLONG)(x) * -10000)
+#define SECONDS(x)          MS((LONGLONG)(x) * 1000)
+
+static
+BOOLEAN
+(NTAPI
+*pKeSetCoalescableTimer)(
+    _Inout_ PKTIMER Timer,
+    _In_ LARGE_INTEGER DueTime,
+    _In_ ULONG Period,
+    _In_ ULONG TolerableDelay,
+    _In_opt_ PKDPC Dpc);
+
+static volatile LONG ShortExpired;
+
+static
+VOID
+NTAPI
+ShortTimerDpc(
+    _In_ PKDPC Dpc,
+    _In_opt_ PVOID DeferredContext,
+    _In_opt_ PVOID SystemArgument1,
+    _In_opt_ PVOID SystemArgument2)
+{
+    InterlockedIncrement(&ShortExpired);
+}
+
+/* Returns the time, in microseconds, the thread lost to interrupts and DPCs */
+static
+ULONGLONG
+MeasureStolenTime(VOID)
+{
+    LARGE_INTEGER Start, Last, Now, Frequency;
+    LONGLONG Threshold, Stolen = 0;
+    KPRIORITY OldPriority;
+
+    KeSetSystemAffinityThread(1);
+    OldPriority = KeSetPriorityThread(KeGetCurrentThread(), LOW_REALTIME_PRIORITY);
+
+    /* Anything longer than two microseconds between two reads was not us */
+    Start = KeQueryPerformanceCounter(&Frequency);
+    Threshold = Frequency.QuadPart / 500000 + 1;
+    Last = Start;
+    do
+    {
+        Now = KeQueryPerformanceCounter(NULL);
+        if (Now.QuadPart - Last.QuadPart > Threshold)
+            Stolen += Now.QuadPart - Last.QuadPart;
+        Last = Now;
+    } while (Now.QuadPart - Start.QuadPart < Frequency.QuadPart * WHEEL_SPIN_SECONDS);
+
+    KeSetPriorityThread(KeGetCurrentThread(), OldPriority);
+    KeRevertToUserAffinityThread();
+
+    return (ULONGLONG)Stolen * 1000000 / Frequency.QuadPart;
+}
+
+static
+VOID
+TestCoalescing(VOID)
+{
+    PKTIMER Timers;
+    LARGE_INTEGER DueTime;
+    ULONGLONG Distinct[WHEEL_COALESCED];
+    ULONGLONG Requested;
+    ULONG Count, Late, Pass, i, j;
+
+    Timers = ExAllocatePoolWithTag(NonPagedPool, sizeof(KTIMER) * WHEEL_COALESCED, TAG_TIMERWHEEL);
+    if (skip(Timers != NULL, "Out of memory\n"))
+        return;
+
+    /* Plain timers first, for comparison */
+    for (Pass = 0; Pass < 2; Pass++)
+    {
+        Count = 0;
+        Late = 0;
+
+        /* Spread the due times over 100ms, then allow 250ms of delay */
+        for (i = 0; i < WHEEL_COALESCED; i++)
+        {
+            KeInitializeTimer(&Timers[i]);
+            DueTime.QuadPart = SECONDS(60) + MS(i * 100 / WHEEL_COALESCED);
+            Requested = KeQueryInterruptTime() - DueTime.QuadPart;
+            if (Pass)
+                pKeSetCoalescableTimer(&Timers[i], DueTime, 0, 250, NULL);
+            else
+                KeSetTimer(&Timers[i], DueTime, NULL);
+
+            if (Timers[i].DueTime.QuadPart < Requested ||
+                Timers[i].DueTime.QuadPart > Requested + 250 * 10000 + KeQueryTimeIncrement())
+            {
+                Late++;
+            }
+
+            for (j = 0; j < Count; j++)
+            {
+                if (Distinct[j] == Timers[i].DueTime.QuadPart)
+                    break;
+            }
+            if (j == Count)
+                Distinct[Count++] = Timers[i].DueTime.QuadPart;
+        }
+
+        for (i = 0; i < WHEEL_COALESCED; i++)
+            KeCancelTimer(&Timers[i]);
+
+        trace("%s: %lu timers expire at %lu distinct times\n",
+              Pass ? "KeSetCoalescableTimer" : "KeSetTimer",
+              (ULONG)WHEEL_COALESCED, Count);
+        ok(Late == 0, "%lu timers due outside their window\n", Late);
+        if (Pass)
+            ok(Count <= 2, "%lu distinct due times\n", Count);
+    }
+
+    ExFreePoolWithTag(Timers, TAG_TIMERWHEEL);
+}
+
+START_TEST(KeTimerWheel)
+{
+    PKTIMER Timers;
+    PKDPC Dpcs;
+    KTIMER FarTimer;
+    LARGE_INTEGER DueTime, Start, End, Frequency, Interval;
+    ULONG Seed = 0x5eed1234;
+    ULONG ShortCount = 0, Failures = 0, i;
+    ULONGLONG Baseline, Loaded, Lateness;
+
+    pKeSetCoalescableTimer = KmtGetSystemRoutineAddress(L"KeSetCoalescableTimer");
+    if (skip(pKeSetCoalescableTimer != NULL, "KeSetCoalescableTimer unavailable\n"))
+        return;
+
+    TestCoalescing();
+
+    Timers = ExAllocatePoolWithTag(NonPagedPool, sizeof(KTIMER) * WHEEL_TIMERS, TAG_TIMERWHEEL);
+    Dpcs = ExAllocatePoolWithTag(NonPagedPool,
+                                 sizeof(KDPC) * (WHEEL_TIMERS / WHEEL_SHORT_EVERY),
+                                 TAG_TIMERWHEEL);
+    if (skip(Timers != NULL && Dpcs != NULL, "Out of memory\n"))
+    {
+        if (Timers) ExFreePoolWithTag(Timers, TAG_TIMERWHEEL);
+        if (Dpcs) ExFreePoolWithTag(Dpcs, TAG_TIMERWHEEL);
+        return;
+    }
+
+    Baseline = MeasureStolenTime();
+
+    /* One in ten within two seconds, the rest between 30s and 30min */
+    ShortExpired = 0;
+    Start = KeQueryPerformanceCounter(&Frequency);
+    for (i = 0; i < WHEEL_TIMERS; i++)
+    {
+        KeInitializeTimer(&Timers[i]);
+        if (i % WHEEL_SHORT_EVERY == 0)
+        {
+            KeInitializeDpc(&Dpcs[ShortCount], ShortTimerDpc, NULL);
+            DueTime.QuadPart = MS(RtlRandomEx(&Seed) % 2000 + 1);
+            KeSetTimer(&Timers[i], DueTime, &Dpcs[ShortCount]);
+            ShortCount++;
+        }
+        else
+        {
+            DueTime.QuadPart = MS(RtlRandomEx(&Seed) % (1770 * 1000)) + SECONDS(30);
+            KeSetTimer(&Timers[i], DueTime, NULL);
+        }
+    }
+    End = KeQueryPerformanceCounter(NULL);
+    trace("Armed %lu timers, %I64u ns per timer\n",
+          (ULONG)WHEEL_TIMERS,
+          (ULONGLONG)(End.QuadPart - Start.QuadPart) * 1000000000 / Frequency.QuadPart / WHEEL_TIMERS);
+
+    Loaded = MeasureStolenTime();
+    trace("Interrupts and DPCs took %I64u us per second idle, %I64u us with %lu timers pending\n",
+          Baseline, Loaded, (ULONG)WHEEL_TIMERS);
+
+    /* All the near ones are due by now, or will be shortly */
+    Interval.QuadPart = MS(2500);
+    KeDelayExecutionThread(KernelMode, FALSE, &Interval);
+    ok_eq_long(ShortExpired, (LONG)ShortCount);
+
+    /* A timer beyond the table's reach must come back from the wheel on time */
+    KeInitializeTimer(&FarTimer);
+    DueTime.QuadPart = SECONDS(20);
+    Start.QuadPart = KeQueryInterruptTime();
+    KeSetTimer(&FarTimer, DueTime, NULL);
+    KeWaitForSingleObject(&FarTimer, Executive, KernelMode, FALSE, NULL);
+    End.QuadPart = KeQueryInterruptTime();
+    Lateness = (ULONGLONG)(End.QuadPart - Start.QuadPart + DueTime.QuadPart) / 10000;
+    ok(End.QuadPart - Start.QuadPart >= -DueTime.QuadPart, "Timer fired early\n");
+    ok(Lateness < 100, "Timer fired %I64u ms late\n", Lateness);
+
+    /* The far ones must all still be pending */
+    for (i = 0; i < WHEEL_TIMERS; i++)
+    {
+        if (i % WHEEL_SHORT_EVERY == 0)
+            continue;
+        if (!KeCancelTimer(&Timers[i]))
+            Failures++;
+    }
+    ok_eq_ulong(Failures, 0UL);
+
+    /* Make sure no DPC is still queued before freeing them */
+    KeFlushQueuedDpcs();
+
+    ExFreePoolWithTag(Dpcs, TAG_TIMERWHEEL);
+    ExFreePoolWithTag(Timers, TAG_TIMERWHEEL);
+}
@@ -0,0 +1,338 @@
+/*
+ * PROJECT:     ReactOS API Tests
+ * LICENSE:     LGPL-3.0-or-later (https://spdx.org/licenses/LGPL-3.0-or-later)
+ * PURPOSE:     Unit Tests for the btrfs checksum functions
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+/* INCLUDES *******************************************************************/
+
+#include <apitest.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#define WIN32_NO_STATUS
+#include <windef.h>
+#include <winbase.h>
+#include <intrin.h>
+
+#include <crc32c.h>
+#include <csum.h>
+#include <xxhash.h>
+
+/* GLOBALS ********************************************************************/
+
+#define SECTOR_SIZE     4096
+#define SPEED_SECTORS   16384
+#define RANDOM_BUFFER   65536
+#define RANDOM_RUNS     2000
+
+typedef struct _HASH_VECTOR
+{
+    const char* Message;
+    uint8_t Sha256[SHA256_HASH_SIZE];
+    uint8_t Blake2b[BLAKE2_HASH_SIZE];
+    uint32_t Crc32c;
+    uint64_t Xxh64;
+} HASH_VECTOR;
+
+static const HASH_VECTOR Vectors[] =
+{
+    {
+        "",
+        { 0xe3, 0xb0, 0xc4, 0x42, 0x98, 0xfc, 0x1c, 0x14, 0x9a, 0xfb, 0xf4, 0xc8, 0x99, 0x6f, 0xb9, 0x24,
+          0x27, 0xae, 0x41, 0xe4, 0x64, 0x9b, 0x93, 0x4c, 0xa4, 0x95, 0x99, 0x1b, 0x78, 0x52, 0xb8, 0x55 },
+        { 0x0e, 0x57, 0x51, 0xc0, 0x26, 0xe5, 0x43, 0xb2, 0xe8, 0xab, 0x2e, 0xb0, 0x60, 0x99, 0xda, 0xa1,
+          0xd1, 0xe5, 0xdf, 0x47, 0x77, 0x8f, 0x77, 0x87, 0xfa, 0xab, 0x45, 0xcd, 0xf1, 0x2f, 0xe3, 0xa8 },
+        0x00000000,
+        0xef46db3751d8e999ULL
+    },
+    {
+        "abc",
+        { 0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+          0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad },
+        { 0xbd, 0xdd, 0x81, 0x3c, 0x63, 0x42, 0x39, 0x72, 0x31, 0x71, 0xef, 0x3f, 0xee, 0x98, 0x57, 0x9b,
+          0x94, 0x96, 0x4e, 0x3b, 0xb1, 0xcb, 0x3e, 0x42, 0x72, 0x62, 0xc8, 0xc0, 0x68, 0xd5, 0x23, 0x19 },
+        0x364b3fb7,
+        0x44bc2cf5ad770999ULL
+    },
+    {
+        "123456789",
+        { 0x15, 0xe2, 0xb0, 0xd3, 0xc3, 0x38, 0x91, 0xeb, 0xb0, 0xf1, 0xef, 0x60, 0x9e, 0xc4, 0x19, 0x42,
+          0x0c, 0x20, 0xe3, 0x20, 0xce, 0x94, 0xc6, 0x5f, 0xbc, 0x8c, 0x33, 0x12, 0x44, 0x8e, 0xb2, 0x25 },
+        { 0x16, 0xe0, 0xbf, 0x1f, 0x85, 0x59, 0x4a, 0x11, 0xe7, 0x50, 0x30, 0x98, 0x1c, 0x0b, 0x67, 0x03,
+          0x70, 0xb3, 0xad, 0x83, 0xa4, 0x3f, 0x49, 0xae, 0x58, 0xa2, 0xfd, 0x6f, 0x65, 0x13, 0xcd, 0xe9 },
+        0xe3069283,
+        0x8cb841db40e6ae83ULL
+    },
+    {
+        "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+        { 0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8, 0xe5, 0xc0, 0x26, 0x93, 0x0c, 0x3e, 0x60, 0x39,
+          0xa3, 0x3c, 0xe4, 0x59, 0x64, 0xff, 0x21, 0x67, 0xf6, 0xec, 0xed, 0xd4, 0x19, 0xdb, 0x06, 0xc1 },
+        { 0x5f, 0x7a, 0x93, 0xda, 0x9c, 0x56, 0x21, 0x58, 0x3f, 0x22, 0xe4, 0x9e, 0x8e, 0x91, 0xa4, 0x0c,
+          0xbb, 0xa3, 0x75, 0x36, 0x62, 0x22, 0x35, 0xa3, 0x80, 0xf4, 0x34, 0xb9, 0xf6, 0x8e, 0x49, 0xc4 },
+        0x071325f5,
+        0xf06103773e8585dfULL
+    }
+};
+
+static BOOLEAN HaveSse42, HaveSsse3, HaveShani;
+
+/* FUNCTIONS ******************************************************************/
+
+static
+VOID
+DetectCpu(VOID)
+{
+#if defined(_X86_) || defined(_AMD64_)
+    int CpuInfo[4], MaxLeaf;
+    BOOLEAN HaveSse41;
+
+    __cpuid(CpuInfo, 0);
+    MaxLeaf = CpuInfo[0];
+
+    __cpuid(CpuInfo, 1);
+    HaveSse42 = !!(CpuInfo[2] & (1 << 20));
+    HaveSse41 = !!(CpuInfo[2] & (1 << 19));
+    HaveSsse3 = !!(CpuInfo[2] & (1 << 9));
+
+    if (MaxLeaf >= 7)
+    {
+        __cpuidex(CpuInfo, 7, 0);
+        HaveShani = (CpuInfo[1] & (1 << 29)) && HaveSse41 && HaveSsse3;
+    }
+
+#ifdef _AMD64_
+    if (HaveSse42)
+        init_crc32c_interleaved();
+#endif
+#endif
+}
+
+static
+uint32_t
+Crc32c(
+    _In_ crc_func Func,
+    _In_ const char* Message)
+{
+    return ~Func(0xffffffff, (uint8_t*)Message, (uint32_t)strlen(Message));
+}
+
+static
+VOID
+TestVector(
+    _In_ const HASH_VECTOR* Vector)
+{
+    uint8_t Hash[SHA256_HASH_SIZE];
+    size_t Length = strlen(Vector->Message);
+
+    calc_sha256_sw(Hash, Vector->Message, Length);
+    ok(!memcmp(Hash, Vector->Sha256, sizeof(Hash)), "Wrong SHA-256 for '%s'\n", Vector->Message);
+
+    blake2b_sw(Hash, BLAKE2_HASH_SIZE, Vector->Message, Length);
+    ok(!memcmp(Hash, Vector->Blake2b, sizeof(Hash)), "Wrong BLAKE2b for '%s'\n", Vector->Message);
+
+    ok_eq_hex(Crc32c(calc_crc32c_sw, Vector->Message), Vector->Crc32c);
+    ok(XXH64(Vector->Message, Length, 0) == Vector->Xxh64, "Wrong XXH64 for '%s'\n", Vector->Message);
+
+#if defined(_X86_) || defined(_AMD64_)
+    if (HaveShani)
+    {
+        calc_sha256_shani(Hash, Vector->Message, Length);
+        ok(!memcmp(Hash, Vector->Sha256, sizeof(Hash)), "Wrong SHA-NI SHA-256 for '%s'\n", Vector->Message);
+    }
+
+    if (HaveSsse3)
+    {
+        blake2b_ssse3(Hash, BLAKE2_HASH_SIZE, Vector->Message, Length);
+        ok(!memcmp(Hash, Vector->Blake2b, sizeof(Hash)), "Wrong SSSE3 BLAKE2b for '%s'\n", Vector->Message);
+    }
+
+    if (HaveSse42)
+    {
+        ok_eq_hex(Crc32c(calc_crc32c_hw, Vector->Message), Vector->Crc32c);
+#ifdef _AMD64_
+        ok_eq_hex(Crc32c(calc_crc32c_interleaved, Vector->Message), Vector->Crc32c);
+#endif
+    }
+#endif
+}
+
+#if defined(_X86_) || defined(_AMD64_)
+/* The SIMD versions must agree with the reference ones on any length and alignment,
+ * in particular around the block sizes and the crc32c interleave strides */
+static
+VOID
+TestRandom(VOID)
+{
+    uint8_t Expected[SHA256_HASH_SIZE], Hash[SHA256_HASH_SIZE];
+    uint8_t* Buffer;
+    ULONG Run, Mismatches = 0;
+    size_t Offset, Length;
+    uint32_t Seed;
+
+    Buffer = malloc(RANDOM_BUFFER);
+    if (!Buffer)
+    {
+        skip("Out of memory\n");
+        return;
+    }
+
+    srand(0x1a26e0d1);
+    for (Offset = 0; Offset < RANDOM_BUFFER; Offset++)
+        Buffer[Offset] = (uint8_t)rand();
+
+    for (Run = 0; Run < RANDOM_RUNS; Run++)
+    {
+        Offset = rand() % 16;
+        Length = (Run < RANDOM_RUNS / 2) ? (size_t)(rand() % 1024) : ((size_t)rand() * 2) % (RANDOM_BUFFER - 16);
+
+        if (HaveShani)
+        {
+            calc_sha256_sw(Expected, Buffer + Offset, Length);
+            calc_sha256_shani(Hash, Buffer + Offset, Length);
+            if (memcmp(Hash, Expected, sizeof(Hash)))
+                Mismatches++;
+        }
+
+        if (HaveSsse3)
+        {
+            blake2b_sw(Expected, BLAKE2_HASH_SIZE, Buffer + Offset, Length);
+            blake2b_ssse3(Hash, BLAKE2_HASH_SIZE, Buffer + Offset, Length);
+            if (memcmp(Hash, Expected, sizeof(Hash)))
+                Mismatches++;
+        }
+
+        if (HaveSse42)
+        {
+            Seed = (uint32_t)rand();
+            if (calc_crc32c_hw(Seed, Buffer + Offset, (uint32_t)Length) != calc_crc32c_sw(Seed, Buffer + Offset, (uint32_t)Length))
+                Mismatches++;
+#ifdef _AMD64_
+            if (calc_crc32c_interleaved(Seed, Buffer + Offset, (uint32_t)Length) != calc_crc32c_sw(Seed, Buffer + Offset, (uint32_t)Length))
+                Mismatches++;
+#endif
+        }
+    }
+
+    ok_eq_ulong(Mismatches, 0UL);
+    free(Buffer);
+}
+#endif
+
+START_TEST(Checksums)
+{
+    ULONG i;
+
+    DetectCpu();
+    trace("SSE4.2 %u, SSSE3 %u, SHA %u\n", HaveSse42, HaveSsse3, HaveShani);
+
+    for (i = 0; i < ARRAYSIZE(Vectors); i++)
+        TestVector(&Vectors[i]);
+
+#if defined(_X86_) || defined(_AMD64_)
+    TestRandom();
+#endif
+}
+
+/* SPEED TESTS ****************************************************************/
+
+typedef enum _CSUM_KIND
+{
+    CsumCrc32c,
+    CsumXxh64,
+    CsumSha256,
+    CsumBlake2b
+} CSUM_KIND;
+
+static
+VOID
+TraceSpeed(
+    _In_ const char* Name,
+    _In_ CSUM_KIND Kind,
+    _In_ PVOID Func,
+    _In_ uint8_t* Buffer)
+{
+    LARGE_INTEGER Start, End, Frequency;
+    uint8_t Hash[SHA256_HASH_SIZE];
+    ULONGLONG Microseconds;
+    ULONG i;
+
+    QueryPerformanceFrequency(&Frequency);
+    QueryPerformanceCounter(&Start);
+
+    /* Sector by sector, the way calcthread.c does it */
+    for (i = 0; i < SPEED_SECTORS; i++)
+    {
+        uint8_t* Sector = Buffer + (i % 16) * SECTOR_SIZE;
+
+        switch (Kind)
+        {
+            case CsumCrc32c:
+                *(uint32_t*)Hash = ~((crc_func)Func)(0xffffffff, Sector, SECTOR_SIZE);
+                break;
+
+            case CsumXxh64:
+                *(uint64_t*)Hash = XXH64(Sector, SECTOR_SIZE, 0);
+                break;
+
+            case CsumSha256:
+                ((sha256_func)Func)(Hash, Sector, SECTOR_SIZE);
+                break;
+
+            case CsumBlake2b:
+                ((blake2b_func)Func)(Hash, BLAKE2_HASH_SIZE, Sector, SECTOR_SIZE);
+                break;
+        }
+    }
+
+    QueryPerformanceCounter(&End);
+
+    Microseconds = (ULONGLONG)(End.QuadPart - Start.QuadPart) * 1000000 / Frequency.QuadPart;
+    if (Microseconds == 0)
+        Microseconds = 1;
+
+    trace("%-18s %I64u MB/s\n", Name, (ULONGLONG)SPEED_SECTORS * SECTOR_SIZE / Microseconds);
+}
+
+START_TEST(ChecksumSpeed)
+{
+    uint8_t* Buffer;
+    ULONG i;
+
+    DetectCpu();
+
+    Buffer = malloc(16 * SECTOR_SIZE);
+    if (!Buffer)
+    {
+        skip("Out of memory\n");
+        return;
+    }
+
+    for (i = 0; i < 16 * SECTOR_SIZE; i++)
+        Buffer[i] = (uint8_t)(i * 31 + (i >> 8));
+
+    TraceSpeed("crc32c", CsumCrc32c, calc_crc32c_sw, Buffer);
+    TraceSpeed("xxhash", CsumXxh64, NULL, Buffer);
+    TraceSpeed("sha256", CsumSha256, calc_sha256_sw, Buffer);
+    TraceSpeed("blake2b", CsumBlake2b, blake2b_sw, Buffer);
+
+#if defined(_X86_) || defined(_AMD64_)
+    if (HaveSse42)
+    {
+        TraceSpeed("crc32c sse4.2", CsumCrc32c, calc_crc32c_hw, Buffer);
+#ifdef _AMD64_
+        TraceSpeed("crc32c interleaved", CsumCrc32c, calc_crc32c_interleaved, Buffer);
+#endif
+    }
+
+    if (HaveShani)
+        TraceSpeed("sha256 sha-ni", CsumSha256, calc_sha256_shani, Buffer);
+
+    if (HaveSsse3)
+        TraceSpeed("blake2b ssse3", CsumBlake2b, blake2b_ssse3, Buffer);
+#endif
+
+    free(Buffer);
+}
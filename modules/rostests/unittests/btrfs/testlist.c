@@ -0,0 +1,19 @@
+/*
+ * PROJECT:     ReactOS API Tests
+ * LICENSE:     LGPL-3.0-or-later (https://spdx.org/licenses/LGPL-3.0-or-later)
+ * PURPOSE:     Test list for the btrfs checksum functions
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#define STANDALONE
+#include <apitest.h>
+
+extern void func_Checksums(void);
+extern void func_ChecksumSpeed(void);
+
+const struct test winetest_testlist[] =
+{
+    { "Checksums", func_Checksums },
+    { "ChecksumSpeed", func_ChecksumSpeed },
+    { 0, 0 }
+};
@@ -326,8 +326,7 @@ CcpAllocateCacheSections(PFILE_OBJECT FileObject,
 
     DPRINT("Allocating Cache Section\n");
 
-    i = RtlFindClearBitsAndSet(CcCacheBitmap, 1, CcCacheClockHand);
-    CcCacheClockHand = (i + 1) % CACHE_NUM_SECTIONS;
+    i = RtlFindClearBitsAndSetNextFit(CcCacheBitmap, 1, &CcCacheClockHand);
 
     if (i != INVALID_CACHE)
     {
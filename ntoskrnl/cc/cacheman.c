@@ -149,8 +149,282 @@ CcRemapBcb (
     return 0;
 }
 
+static
+UCHAR
+CcpClassifyRead(
+    _In_ PCC_READ_AHEAD_STREAM Stream,
+    _In_ LONGLONG FileOffset,
+    _In_ ULONG Length,
+    _In_ ULONG Granularity)
 /*
- * @unimplemented
+ * FUNCTION: Tells how a read relates to the last read of a stream
+ * RETURNS: The pattern the two reads make, ReadAheadPatternNone if the
+ *          read does not belong to the stream
+ */
+{
+    LONGLONG Delta = FileOffset - Stream->FileOffset;
+
+    /* Starts where the last one stopped, give or take the granularity */
+    if (Delta >= 0 &&
+        FileOffset <= (LONGLONG)ROUND_UP(Stream->BeyondLastByte, Granularity))
+    {
+        return ReadAheadPatternSequential;
+    }
+
+    /* Ends where the last one started */
+    if (Delta < 0 &&
+        FileOffset + Length >= (LONGLONG)ROUND_DOWN(Stream->FileOffset, Granularity))
+    {
+        return ReadAheadPatternBackward;
+    }
+
+    /* Too far away to be the same reader */
+    if (Delta > CC_READ_AHEAD_MAX_STRIDE || Delta < -CC_READ_AHEAD_MAX_STRIDE)
+    {
+        return ReadAheadPatternNone;
+    }
+
+    return (Delta > 0) ? ReadAheadPatternStrided : ReadAheadPatternBackward;
+}
+
+static
+BOOLEAN
+CcpFollowsPattern(
+    _In_ PCC_READ_AHEAD_STREAM Stream,
+    _In_ UCHAR Pattern,
+    _In_ LONGLONG FileOffset)
+{
+    if (Stream->LastUse == 0 || Pattern != Stream->Pattern)
+        return FALSE;
+
+    /* Strides have to repeat, contiguous reads may have any length */
+    if (Pattern == ReadAheadPatternStrided)
+        return (FileOffset - Stream->FileOffset) == Stream->Stride;
+
+    return TRUE;
+}
+
+static
+PCC_READ_AHEAD_STREAM
+CcpMatchReadAheadStream(
+    _Inout_ PROS_PRIVATE_CACHE_MAP PrivateMap,
+    _In_ PFILE_OBJECT FileObject,
+    _In_ LONGLONG FileOffset,
+    _In_ ULONG Length,
+    _In_ ULONG Granularity)
+/*
+ * FUNCTION: Finds the stream a read belongs to and updates its pattern,
+ *           its window and the hit statistics of the file
+ */
+{
+    PROS_SHARED_CACHE_MAP SharedCacheMap = FileObject->SectionObjectPointer->SharedCacheMap;
+    PCC_READ_AHEAD_STREAM Stream, Candidate = NULL, Oldest = NULL;
+    UCHAR Pattern, CandidatePattern = ReadAheadPatternNone;
+    ULONG i;
+
+    /* First a stream whose pattern goes on, then any stream close enough */
+    for (i = 0; i < CC_READ_AHEAD_STREAMS; i++)
+    {
+        Stream = &PrivateMap->Streams[i];
+
+        if (Stream->LastUse == 0)
+        {
+            Oldest = Stream;
+            continue;
+        }
+        if (Oldest == NULL || (Oldest->LastUse != 0 && Stream->LastUse < Oldest->LastUse))
+        {
+            Oldest = Stream;
+        }
+
+        Pattern = CcpClassifyRead(Stream, FileOffset, Length, Granularity);
+        if (Pattern == ReadAheadPatternNone)
+            continue;
+
+        if (CcpFollowsPattern(Stream, Pattern, FileOffset))
+        {
+            /* Did read ahead get there first? */
+            if (FileOffset >= Stream->ReadAheadStart &&
+                FileOffset + Length <= Stream->ReadAheadEnd)
+            {
+                InterlockedIncrement((PLONG)&SharedCacheMap->ReadAheadHits);
+                Stream->Window = min(Stream->Window * 2, CC_READ_AHEAD_MAX_WINDOW);
+            }
+
+            if (Stream->Confidence < MAXUCHAR)
+                Stream->Confidence++;
+            goto Update;
+        }
+
+        if (Candidate == NULL)
+        {
+            Candidate = Stream;
+            CandidatePattern = Pattern;
+        }
+    }
+
+    if (Candidate != NULL)
+    {
+        /* The reader changed its pattern, what we read ahead was wasted */
+        Stream = Candidate;
+        if (Stream->Confidence > 1)
+        {
+            InterlockedIncrement((PLONG)&SharedCacheMap->ReadAheadMisses);
+        }
+
+        Stream->Pattern = CandidatePattern;
+        Stream->Stride = FileOffset - Stream->FileOffset;
+        Stream->Confidence = 1;
+        Stream->Window = max(Stream->Window / 2, CC_READ_AHEAD_MIN_WINDOW);
+        Stream->ReadAheadStart = Stream->ReadAheadEnd = FileOffset;
+        goto Update;
+    }
+
+    /* A new reader, recycle the oldest stream */
+    Stream = Oldest;
+    RtlZeroMemory(Stream, sizeof(*Stream));
+    Stream->Window = CC_READ_AHEAD_MIN_WINDOW;
+    Stream->ReadAheadStart = Stream->ReadAheadEnd = FileOffset;
+
+    /* Files opened for sequential access don't have to prove it */
+    if (BooleanFlagOn(FileObject->Flags, FO_SEQUENTIAL_ONLY))
+    {
+        Stream->Pattern = ReadAheadPatternSequential;
+        Stream->Confidence = 1;
+        Stream->Window = 2 * CC_READ_AHEAD_MIN_WINDOW;
+    }
+
+Update:
+    Stream->FileOffset = FileOffset;
+    Stream->BeyondLastByte = FileOffset + Length;
+    Stream->LastUse = ++PrivateMap->StreamClock;
+    return Stream;
+}
+
+static
+BOOLEAN
+CcpQueueReadAheadRange(
+    _Inout_ PROS_PRIVATE_CACHE_MAP PrivateMap,
+    _In_ LONGLONG FileOffset,
+    _In_ LONGLONG Length)
+{
+    PCC_READ_AHEAD_RANGE Range;
+
+    if (Length <= 0)
+        return FALSE;
+
+    /* Cluster it with the previous range if they touch */
+    if (PrivateMap->RangeCount != 0)
+    {
+        Range = &PrivateMap->Ranges[PrivateMap->RangeCount - 1];
+        if (FileOffset >= Range->FileOffset &&
+            FileOffset <= Range->FileOffset + Range->Length + CC_READ_AHEAD_CLUSTER_GAP &&
+            FileOffset + Length - Range->FileOffset <= CC_READ_AHEAD_MAX_WINDOW)
+        {
+            Range->Length = (ULONG)max(Range->Length, FileOffset + Length - Range->FileOffset);
+            return TRUE;
+        }
+    }
+
+    if (PrivateMap->RangeCount == CC_READ_AHEAD_RANGES)
+        return FALSE;
+
+    Range = &PrivateMap->Ranges[PrivateMap->RangeCount++];
+    Range->FileOffset = FileOffset;
+    Range->Length = (ULONG)Length;
+
+    /* Keep the NT fields meaningful */
+    PrivateMap->PrivateCacheMap.ReadAheadOffset[1].QuadPart = FileOffset;
+    PrivateMap->PrivateCacheMap.ReadAheadLength[1] = (ULONG)Length;
+    return TRUE;
+}
+
+static
+BOOLEAN
+CcpPlanReadAhead(
+    _Inout_ PROS_PRIVATE_CACHE_MAP PrivateMap,
+    _Inout_ PCC_READ_AHEAD_STREAM Stream,
+    _In_ ULONG Granularity)
+/*
+ * FUNCTION: Queues what the stream will want next, once less than half a
+ *           window is left ahead of the reader
+ * RETURNS: TRUE if something was queued
+ */
+{
+    LONGLONG Start, End, Chunk, Length;
+    BOOLEAN Queued = FALSE;
+    ULONG Count, i;
+
+    switch (Stream->Pattern)
+    {
+        case ReadAheadPatternSequential:
+            if (Stream->ReadAheadEnd - Stream->BeyondLastByte >= Stream->Window / 2)
+                break;
+
+            Start = max(Stream->ReadAheadEnd, Stream->BeyondLastByte);
+            End = ROUND_UP(Stream->BeyondLastByte + Stream->Window, Granularity);
+            Queued = CcpQueueReadAheadRange(PrivateMap, Start, End - Start);
+            if (Queued)
+            {
+                if (Stream->ReadAheadStart == Stream->ReadAheadEnd)
+                    Stream->ReadAheadStart = Start;
+                Stream->ReadAheadEnd = End;
+            }
+            break;
+
+        case ReadAheadPatternBackward:
+            if (Stream->ReadAheadStart <= 0 ||
+                Stream->FileOffset - Stream->ReadAheadStart >= Stream->Window / 2)
+            {
+                break;
+            }
+
+            End = min(Stream->ReadAheadStart, Stream->FileOffset);
+            Start = ROUND_DOWN(max(Stream->FileOffset - (LONGLONG)Stream->Window, 0), Granularity);
+            Queued = CcpQueueReadAheadRange(PrivateMap, Start, End - Start);
+            if (Queued)
+            {
+                if (Stream->ReadAheadStart == Stream->ReadAheadEnd)
+                    Stream->ReadAheadEnd = Stream->BeyondLastByte;
+                Stream->ReadAheadStart = Start;
+            }
+            break;
+
+        case ReadAheadPatternStrided:
+            /* As many strides as the window holds */
+            Length = ROUND_UP(Stream->BeyondLastByte - Stream->FileOffset, Granularity);
+            Count = (ULONG)min(max(Stream->Window / Length, 1), CC_READ_AHEAD_RANGES);
+            if (Stream->ReadAheadEnd - Stream->BeyondLastByte >= (Stream->Stride * Count) / 2)
+                break;
+
+            for (i = 1; i <= Count; i++)
+            {
+                Chunk = Stream->FileOffset + i * Stream->Stride;
+                if (Chunk < Stream->ReadAheadEnd)
+                    continue;
+
+                /* Small gaps are read too, one bigger read beats several small ones */
+                Start = ROUND_DOWN(Chunk, Granularity);
+                End = ROUND_UP(Chunk + (Stream->BeyondLastByte - Stream->FileOffset), Granularity);
+                if (!CcpQueueReadAheadRange(PrivateMap, Start, End - Start))
+                    break;
+
+                if (Stream->ReadAheadStart == Stream->ReadAheadEnd)
+                    Stream->ReadAheadStart = Chunk;
+                Stream->ReadAheadEnd = Chunk + Length;
+                Queued = TRUE;
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    return Queued;
+}
+
+/*
+ * @implemented
  */
 VOID
 NTAPI
@@ -161,61 +435,41 @@ CcScheduleReadAhead (
 	)
 {
     KIRQL OldIrql;
-    LARGE_INTEGER NewOffset;
+    ULONG Granularity;
     PROS_SHARED_CACHE_MAP SharedCacheMap;
     PPRIVATE_CACHE_MAP PrivateCacheMap;
+    PROS_PRIVATE_CACHE_MAP RosPrivateMap;
+    PCC_READ_AHEAD_STREAM Stream;
 
     SharedCacheMap = FileObject->SectionObjectPointer->SharedCacheMap;
     PrivateCacheMap = FileObject->PrivateCacheMap;
 
     /* If file isn't cached, or if read ahead is disabled, this is no op */
     if (SharedCacheMap == NULL || PrivateCacheMap == NULL ||
-        BooleanFlagOn(SharedCacheMap->Flags, READAHEAD_DISABLED))
+        BooleanFlagOn(SharedCacheMap->Flags, READAHEAD_DISABLED) ||
+        Length == 0)
     {
         return;
     }
 
-    /* Round read length with read ahead mask */
-    Length = ROUND_UP(Length, PrivateCacheMap->ReadAheadMask + 1);
-    /* Compute the offset we'll reach */
-    NewOffset.QuadPart = FileOffset->QuadPart + Length;
+    RosPrivateMap = CONTAINING_RECORD(PrivateCacheMap, ROS_PRIVATE_CACHE_MAP, PrivateCacheMap);
+    Granularity = PrivateCacheMap->ReadAheadMask + 1;
 
     /* Lock read ahead spin lock */
     KeAcquireSpinLock(&PrivateCacheMap->ReadAheadSpinLock, &OldIrql);
-    /* Easy case: the file is sequentially read */
-    if (BooleanFlagOn(FileObject->Flags, FO_SEQUENTIAL_ONLY))
-    {
-        /* If we went backward, this is no go! */
-        if (NewOffset.QuadPart < PrivateCacheMap->ReadAheadOffset[1].QuadPart)
-        {
-            KeReleaseSpinLock(&PrivateCacheMap->ReadAheadSpinLock, OldIrql);
-            return;
-        }
 
-        /* FIXME: hackish, but will do the job for now */
-        PrivateCacheMap->ReadAheadOffset[1].QuadPart = NewOffset.QuadPart;
-        PrivateCacheMap->ReadAheadLength[1] = Length;
-    }
-    /* Other cases: try to find some logic in that mess... */
-    else
+    /* Update read history in private cache map */
+    PrivateCacheMap->FileOffset1.QuadPart = PrivateCacheMap->FileOffset2.QuadPart;
+    PrivateCacheMap->BeyondLastByte1.QuadPart = PrivateCacheMap->BeyondLastByte2.QuadPart;
+    PrivateCacheMap->FileOffset2.QuadPart = FileOffset->QuadPart;
+    PrivateCacheMap->BeyondLastByte2.QuadPart = FileOffset->QuadPart + Length;
+
+    /* Find out who is reading and how, then what it will want next */
+    Stream = CcpMatchReadAheadStream(RosPrivateMap, FileObject, FileOffset->QuadPart, Length, Granularity);
+    if (!CcpPlanReadAhead(RosPrivateMap, Stream, Granularity))
     {
-        /* Let's check if we always read the same way (like going down in the file)
-         * and pretend it's enough for now
-         */
-        if (PrivateCacheMap->FileOffset2.QuadPart >= PrivateCacheMap->FileOffset1.QuadPart &&
-            FileOffset->QuadPart >= PrivateCacheMap->FileOffset2.QuadPart)
-        {
-            /* FIXME: hackish, but will do the job for now */
-            PrivateCacheMap->ReadAheadOffset[1].QuadPart = NewOffset.QuadPart;
-            PrivateCacheMap->ReadAheadLength[1] = Length;
-        }
-        else
-        {
-            /* FIXME: handle the other cases */
-            KeReleaseSpinLock(&PrivateCacheMap->ReadAheadSpinLock, OldIrql);
-            UNIMPLEMENTED_ONCE;
-            return;
-        }
+        KeReleaseSpinLock(&PrivateCacheMap->ReadAheadSpinLock, OldIrql);
+        return;
     }
 
     /* If read ahead isn't active yet */
@@ -246,12 +500,13 @@ CcScheduleReadAhead (
             return;
         }
 
-        /* Fail path: lock again, and revert read ahead active */
+        /* Fail path: lock again, forget the ranges, and revert read ahead active */
         KeAcquireSpinLock(&PrivateCacheMap->ReadAheadSpinLock, &OldIrql);
+        RosPrivateMap->RangeCount = 0;
         InterlockedAnd((volatile long *)&PrivateCacheMap->UlongFlags, ~PRIVATE_CACHE_MAP_READ_AHEAD_ACTIVE);
     }
 
-    /* Done (fail) */
+    /* Done, the active read ahead will pick the new ranges up */
     KeReleaseSpinLock(&PrivateCacheMap->ReadAheadSpinLock, OldIrql);
 }
 
@@ -39,9 +39,17 @@ ULONG CcFastReadResourceMiss;
 /* Counters:
  * - Amount of pages flushed to the disk
  * - Number of flush operations
+ * - Number of ranges read ahead
+ * - Number of writes deferred till dirty pages went below threshold
+ * - Number of writes delayed for writing too much
+ * - Time spent in such delays (ms)
  */
 ULONG CcDataPages = 0;
 ULONG CcDataFlushes = 0;
+ULONG CcReadAheadIos = 0;
+ULONG CcThrottleWaits = 0;
+ULONG CcThrottleDelays = 0;
+ULONG CcThrottleDelayTime = 0;
 
 /* FUNCTIONS *****************************************************************/
 
@@ -126,22 +134,23 @@ CcPostDeferredWrites(VOID)
     }
 }
 
-VOID
-CcPerformReadAhead(
-    IN PFILE_OBJECT FileObject)
+static
+ULONG
+CcpTakeReadAheadRanges(
+    _In_ PFILE_OBJECT FileObject,
+    _Out_writes_(CC_READ_AHEAD_RANGES) PCC_READ_AHEAD_RANGE Ranges,
+    _In_ BOOLEAN Discard)
+/*
+ * FUNCTION: Takes the ranges queued for read ahead. When there are none
+ *           left, read ahead is marked as unactive under the same lock, so
+ *           that the next CcScheduleReadAhead posts a new work item.
+ * RETURNS: The number of ranges taken
+ */
 {
-    NTSTATUS Status;
-    LONGLONG CurrentOffset;
     KIRQL OldIrql;
-    PROS_SHARED_CACHE_MAP SharedCacheMap;
-    PROS_VACB Vacb;
-    ULONG PartialLength;
-    ULONG Length;
+    ULONG Count = 0;
     PPRIVATE_CACHE_MAP PrivateCacheMap;
-    BOOLEAN Locked;
-    BOOLEAN Success;
-
-    SharedCacheMap = FileObject->SectionObjectPointer->SharedCacheMap;
+    PROS_PRIVATE_CACHE_MAP RosPrivateMap;
 
     /* Critical:
      * PrivateCacheMap might disappear in-between if the handle
@@ -152,65 +161,77 @@ CcPerformReadAhead(
     OldIrql = KeAcquireQueuedSpinLock(LockQueueMasterLock);
     PrivateCacheMap = FileObject->PrivateCacheMap;
     /* If the handle was closed since the read ahead was scheduled, just quit */
-    if (PrivateCacheMap == NULL)
-    {
-        KeReleaseQueuedSpinLock(LockQueueMasterLock, OldIrql);
-        ObDereferenceObject(FileObject);
-        return;
-    }
-    /* Otherwise, extract read offset and length and release private map */
-    else
+    if (PrivateCacheMap != NULL)
     {
+        RosPrivateMap = CONTAINING_RECORD(PrivateCacheMap, ROS_PRIVATE_CACHE_MAP, PrivateCacheMap);
+
         KeAcquireSpinLockAtDpcLevel(&PrivateCacheMap->ReadAheadSpinLock);
-        CurrentOffset = PrivateCacheMap->ReadAheadOffset[1].QuadPart;
-        Length = PrivateCacheMap->ReadAheadLength[1];
+        if (!Discard)
+        {
+            Count = RosPrivateMap->RangeCount;
+            RtlCopyMemory(Ranges, RosPrivateMap->Ranges, Count * sizeof(CC_READ_AHEAD_RANGE));
+        }
+        RosPrivateMap->RangeCount = 0;
+
+        if (Count == 0)
+        {
+            /* Mark read ahead as unactive */
+            InterlockedAnd((volatile long *)&PrivateCacheMap->UlongFlags, ~PRIVATE_CACHE_MAP_READ_AHEAD_ACTIVE);
+        }
         KeReleaseSpinLockFromDpcLevel(&PrivateCacheMap->ReadAheadSpinLock);
     }
     KeReleaseQueuedSpinLock(LockQueueMasterLock, OldIrql);
 
-    /* Time to go! */
-    DPRINT("Doing ReadAhead for %p\n", FileObject);
-    /* Lock the file, first */
-    if (!SharedCacheMap->Callbacks->AcquireForReadAhead(SharedCacheMap->LazyWriteContext, FALSE))
-    {
-        Locked = FALSE;
-        goto Clear;
-    }
+    return Count;
+}
 
-    /* Remember it's locked */
-    Locked = TRUE;
+static
+BOOLEAN
+CcpReadAheadRange(
+    _In_ PROS_SHARED_CACHE_MAP SharedCacheMap,
+    _In_ LONGLONG CurrentOffset,
+    _In_ ULONG Length)
+{
+    NTSTATUS Status;
+    PROS_VACB Vacb;
+    ULONG VacbOffset;
+    ULONG PartialLength;
+    BOOLEAN Success;
 
     /* Don't read past the end of the file */
     if (CurrentOffset >= SharedCacheMap->FileSize.QuadPart)
     {
-        goto Clear;
+        return TRUE;
     }
     if (CurrentOffset + Length > SharedCacheMap->FileSize.QuadPart)
     {
-        Length = SharedCacheMap->FileSize.QuadPart - CurrentOffset;
+        Length = (ULONG)(SharedCacheMap->FileSize.QuadPart - CurrentOffset);
     }
 
-    /* Next of the algorithm will lock like CcCopyData with the slight
+    InterlockedIncrement((PLONG)&CcReadAheadIos);
+    InterlockedIncrement((PLONG)&SharedCacheMap->ReadAheadIos);
+    InterlockedExchangeAdd((PLONG)&SharedCacheMap->ReadAheadPages, BYTES_TO_PAGES(Length));
+
+    /* The rest of the algorithm will look like CcCopyData with the slight
      * difference that we don't copy data back to an user-backed buffer
-     * We just bring data into Cc
+     * We just bring data into Cc, one paging read per view
      */
-    PartialLength = CurrentOffset % VACB_MAPPING_GRANULARITY;
-    if (PartialLength != 0)
+    while (Length > 0)
     {
-        PartialLength = min(Length, VACB_MAPPING_GRANULARITY - PartialLength);
+        VacbOffset = CurrentOffset % VACB_MAPPING_GRANULARITY;
+        PartialLength = min(Length, VACB_MAPPING_GRANULARITY - VacbOffset);
         Status = CcRosRequestVacb(SharedCacheMap,
-                                  ROUND_DOWN(CurrentOffset, VACB_MAPPING_GRANULARITY),
+                                  CurrentOffset - VacbOffset,
                                   &Vacb);
         if (!NT_SUCCESS(Status))
         {
             DPRINT1("Failed to request VACB: %lx!\n", Status);
-            goto Clear;
+            return FALSE;
         }
 
         _SEH2_TRY
         {
-            Success = CcRosEnsureVacbResident(Vacb, TRUE, FALSE,
-                    CurrentOffset % VACB_MAPPING_GRANULARITY, PartialLength);
+            Success = CcRosEnsureVacbResident(Vacb, TRUE, FALSE, VacbOffset, PartialLength);
         }
         _SEH2_EXCEPT(EXCEPTION_EXECUTE_HANDLER)
         {
@@ -218,78 +239,127 @@ CcPerformReadAhead(
         }
         _SEH2_END
 
+        CcRosReleaseVacb(SharedCacheMap, Vacb, FALSE, FALSE);
+
         if (!Success)
         {
-            CcRosReleaseVacb(SharedCacheMap, Vacb, FALSE, FALSE);
-            DPRINT1("Failed to read data: %lx!\n", Status);
-            goto Clear;
+            DPRINT1("Failed to read data at %I64x!\n", CurrentOffset);
+            return FALSE;
         }
 
-        CcRosReleaseVacb(SharedCacheMap, Vacb, FALSE, FALSE);
-
         Length -= PartialLength;
         CurrentOffset += PartialLength;
     }
 
-    while (Length > 0)
-    {
-        ASSERT(CurrentOffset % VACB_MAPPING_GRANULARITY == 0);
-        PartialLength = min(VACB_MAPPING_GRANULARITY, Length);
-        Status = CcRosRequestVacb(SharedCacheMap,
-                                  CurrentOffset,
-                                  &Vacb);
-        if (!NT_SUCCESS(Status))
-        {
-            DPRINT1("Failed to request VACB: %lx!\n", Status);
-            goto Clear;
-        }
+    return TRUE;
+}
 
-        _SEH2_TRY
+VOID
+CcPerformReadAhead(
+    IN PFILE_OBJECT FileObject)
+{
+    PROS_SHARED_CACHE_MAP SharedCacheMap;
+    CC_READ_AHEAD_RANGE Ranges[CC_READ_AHEAD_RANGES];
+    ULONG Count, i;
+
+    SharedCacheMap = FileObject->SectionObjectPointer->SharedCacheMap;
+
+    Count = CcpTakeReadAheadRanges(FileObject, Ranges, FALSE);
+    if (Count != 0)
+    {
+        /* Time to go! */
+        DPRINT("Doing ReadAhead for %p\n", FileObject);
+        /* Lock the file, first */
+        if (!SharedCacheMap->Callbacks->AcquireForReadAhead(SharedCacheMap->LazyWriteContext, FALSE))
         {
-            Success = CcRosEnsureVacbResident(Vacb, TRUE, FALSE, 0, PartialLength);
+            /* Busy, the reader will ask again */
+            CcpTakeReadAheadRanges(FileObject, Ranges, TRUE);
         }
-        _SEH2_EXCEPT(EXCEPTION_EXECUTE_HANDLER)
+        else
         {
-            Success = FALSE;
-        }
-        _SEH2_END
+            /* Keep going while the readers queue more */
+            do
+            {
+                for (i = 0; i < Count; i++)
+                {
+                    CcpReadAheadRange(SharedCacheMap, Ranges[i].FileOffset, Ranges[i].Length);
+                }
 
-        if (!Success)
-        {
-            CcRosReleaseVacb(SharedCacheMap, Vacb, FALSE, FALSE);
-            DPRINT1("Failed to read data: %lx!\n", Status);
-            goto Clear;
+                Count = CcpTakeReadAheadRanges(FileObject, Ranges, FALSE);
+            } while (Count != 0);
+
+            SharedCacheMap->Callbacks->ReleaseFromReadAhead(SharedCacheMap->LazyWriteContext);
         }
+    }
 
-        CcRosReleaseVacb(SharedCacheMap, Vacb, FALSE, FALSE);
+    /* And drop our extra reference (See: CcScheduleReadAhead) */
+    ObDereferenceObject(FileObject);
+}
 
-        Length -= PartialLength;
-        CurrentOffset += PartialLength;
+static
+VOID
+CcpThrottleHeavyWriter(
+    _In_ PFILE_OBJECT FileObject,
+    _In_ ULONG Pages)
+/*
+ * FUNCTION: Slows down the writers owning a large share of the dirty pages
+ *           once these get past three quarters of the threshold. The delay
+ *           grows with both that share and how close the threshold is, so
+ *           that light writers are not hit by the heavy ones
+ */
+{
+    KIRQL OldIrql;
+    ULONG Start, Range, DirtyPages, FileDirtyPages, Delay;
+    LARGE_INTEGER Interval;
+    PROS_SHARED_CACHE_MAP SharedCacheMap;
+
+    /* Below three quarters of the threshold, nobody is slowed down */
+    Range = CcDirtyPageThreshold / 4;
+    Start = CcDirtyPageThreshold - Range;
+    if (Range == 0 || CcTotalDirtyPages + Pages <= Start)
+    {
+        return;
     }
 
-Clear:
-    /* See previous comment about private cache map */
+    /* How much of the dirty pages is this file's? */
+    FileDirtyPages = 0;
     OldIrql = KeAcquireQueuedSpinLock(LockQueueMasterLock);
-    PrivateCacheMap = FileObject->PrivateCacheMap;
-    if (PrivateCacheMap != NULL)
+    DirtyPages = CcTotalDirtyPages;
+    if (FileObject->SectionObjectPointer != NULL &&
+        FileObject->SectionObjectPointer->SharedCacheMap != NULL)
     {
-        /* Mark read ahead as unactive */
-        KeAcquireSpinLockAtDpcLevel(&PrivateCacheMap->ReadAheadSpinLock);
-        InterlockedAnd((volatile long *)&PrivateCacheMap->UlongFlags, ~PRIVATE_CACHE_MAP_READ_AHEAD_ACTIVE);
-        KeReleaseSpinLockFromDpcLevel(&PrivateCacheMap->ReadAheadSpinLock);
+        SharedCacheMap = FileObject->SectionObjectPointer->SharedCacheMap;
+        FileDirtyPages = SharedCacheMap->DirtyPages;
+    }
+
+    /* The lazy writer has to catch up */
+    if (!LazyWriter.ScanActive)
+    {
+        CcScheduleLazyWriteScan(TRUE);
     }
     KeReleaseQueuedSpinLock(LockQueueMasterLock, OldIrql);
 
-    /* If file was locked, release it */
-    if (Locked)
+    /* Light writers go through */
+    if (DirtyPages + Pages <= Start ||
+        FileDirtyPages < DirtyPages / CC_THROTTLE_HEAVY_SHARE)
     {
-        SharedCacheMap->Callbacks->ReleaseFromReadAhead(SharedCacheMap->LazyWriteContext);
+        return;
     }
 
-    /* And drop our extra reference (See: CcScheduleReadAhead) */
-    ObDereferenceObject(FileObject);
+    DirtyPages = min(DirtyPages + Pages, CcDirtyPageThreshold);
+    Delay = (ULONG)(((ULONGLONG)CC_THROTTLE_MAX_DELAY * (DirtyPages - Start) / Range) *
+                    min(FileDirtyPages, DirtyPages) / DirtyPages);
+    if (Delay == 0)
+    {
+        return;
+    }
 
-    return;
+    InterlockedIncrement((PLONG)&CcThrottleDelays);
+    InterlockedExchangeAdd((PLONG)&CcThrottleDelayTime, Delay);
+
+    DPRINT("Delaying write for %p: %lu ms (%lu/%lu dirty pages)\n", FileObject, Delay, FileDirtyPages, DirtyPages);
+    Interval.QuadPart = (LONGLONG)Delay * -10000;
+    KeDelayExecutionThread(KernelMode, FALSE, &Interval);
 }
 
 /*
@@ -389,6 +459,12 @@ CcCanIWrite (
          (MmModifiedPageListHead.Total < 1000 && MmAvailablePages > MmThrottleBottom)) &&
         !PerFileDefer)
     {
+        /* Past the throttle point, heavy writers make room for the others */
+        if (Wait && TryContext == FirstTry)
+        {
+            CcpThrottleHeavyWriter(FileObject, Pages);
+        }
+
         return TRUE;
     }
 
@@ -412,6 +488,7 @@ CcCanIWrite (
 
     /* Initialize our wait event */
     KeInitializeEvent(&WaitEvent, NotificationEvent, FALSE);
+    InterlockedIncrement((PLONG)&CcThrottleWaits);
 
     /* And prepare a dummy context */
     Context.NodeTypeCode = NODE_TYPE_DEFERRED_WRITE;
@@ -559,28 +636,13 @@ CcCopyRead (
     IoStatus->Status = STATUS_SUCCESS;
     IoStatus->Information = ReadLength;
 
-#if 0
-    /* If that was a successful sync read operation, let's handle read ahead */
-    if (Length == 0 && Wait)
+    /* Let read ahead follow the reader, unless it told us its accesses are random.
+     * This also keeps the read history of the private cache map up to date.
+     */
+    if (ReadLength != 0 && !BooleanFlagOn(FileObject->Flags, FO_RANDOM_ACCESS))
     {
-        PPRIVATE_CACHE_MAP PrivateCacheMap = FileObject->PrivateCacheMap;
-
-        /* If file isn't random access and next read may get us cross VACB boundary,
-         * schedule next read
-         */
-        if (!BooleanFlagOn(FileObject->Flags, FO_RANDOM_ACCESS) &&
-            (CurrentOffset - 1) / VACB_MAPPING_GRANULARITY != (CurrentOffset + ReadLength - 1) / VACB_MAPPING_GRANULARITY)
-        {
-            CcScheduleReadAhead(FileObject, FileOffset, ReadLength);
-        }
-
-        /* And update read history in private cache map */
-        PrivateCacheMap->FileOffset1.QuadPart = PrivateCacheMap->FileOffset2.QuadPart;
-        PrivateCacheMap->BeyondLastByte1.QuadPart = PrivateCacheMap->BeyondLastByte2.QuadPart;
-        PrivateCacheMap->FileOffset2.QuadPart = FileOffset->QuadPart;
-        PrivateCacheMap->BeyondLastByte2.QuadPart = FileOffset->QuadPart + ReadLength;
+        CcScheduleReadAhead(FileObject, FileOffset, ReadLength);
     }
-#endif
 
     return TRUE;
 }
@@ -108,7 +108,7 @@ NTAPI
 CcIsThereDirtyData (
     IN PVPB Vpb)
 {
-    PROS_VACB Vacb;
+    PROS_SHARED_CACHE_MAP SharedCacheMap;
     PLIST_ENTRY Entry;
     KIRQL oldIrql;
     /* Assume no dirty data */
@@ -118,12 +118,12 @@ CcIsThereDirtyData (
 
     oldIrql = KeAcquireQueuedSpinLock(LockQueueMasterLock);
 
-    /* Browse dirty VACBs */
-    for (Entry = DirtyVacbListHead.Flink; Entry != &DirtyVacbListHead; Entry = Entry->Flink)
+    /* Browse the files with dirty VACBs */
+    for (Entry = CcDirtySharedCacheMapList.Flink; Entry != &CcDirtySharedCacheMapList; Entry = Entry->Flink)
     {
-        Vacb = CONTAINING_RECORD(Entry, ROS_VACB, DirtyVacbListEntry);
+        SharedCacheMap = CONTAINING_RECORD(Entry, ROS_SHARED_CACHE_MAP, SharedCacheMapLinks);
         /* Look for these associated with our volume */
-        if (Vacb->SharedCacheMap->FileObject->Vpb != Vpb)
+        if (SharedCacheMap->FileObject->Vpb != Vpb)
         {
             continue;
         }
@@ -131,13 +131,13 @@ CcIsThereDirtyData (
         /* From now on, we are associated with our VPB */
 
         /* Temporary files are not counted as dirty */
-        if (BooleanFlagOn(Vacb->SharedCacheMap->FileObject->Flags, FO_TEMPORARY_FILE))
+        if (BooleanFlagOn(SharedCacheMap->FileObject->Flags, FO_TEMPORARY_FILE))
         {
             continue;
         }
 
         /* A single dirty VACB is enough to have dirty data */
-        if (Vacb->Dirty)
+        if (!IsListEmpty(&SharedCacheMap->DirtyVacbListHead))
         {
             Dirty = TRUE;
             break;
@@ -255,8 +255,7 @@ CcPurgeCacheSection (
 
         /* This VACB is in range, so unlink it and mark for free */
         ASSERT(Refs == 1 || Vacb->Dirty);
-        RemoveEntryList(&Vacb->VacbLruListEntry);
-        InitializeListHead(&Vacb->VacbLruListEntry);
+        CcRosRemoveVacbFromLru(Vacb);
         if (Vacb->Dirty)
         {
             CcRosUnmarkDirtyVacb(Vacb, FALSE);
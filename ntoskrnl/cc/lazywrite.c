@@ -16,9 +16,20 @@
 /* Counters:
  * - Amount of pages flushed by lazy writer
  * - Number of times lazy writer ran
+ * - Pages per second flushed by lazy writer since its previous scan
  */
 ULONG CcLazyWritePages = 0;
 ULONG CcLazyWriteIos = 0;
+ULONG CcLazyWriteFlushRate = 0;
+
+/* State of the previous lazy writer scan:
+ * - When it ran
+ * - Dirty pages it saw
+ * - Pages flushed by lazy writer at that time
+ */
+static LARGE_INTEGER CcLastScanTime;
+static ULONG CcLastScanDirtyPages = 0;
+static ULONG CcLastScanWritePages = 0;
 
 /* Internal vars (MS):
  * - Lazy writer status structure
@@ -114,20 +125,20 @@ CcScanDpc(
 }
 
 VOID
-CcWriteBehind(VOID)
+CcWriteBehind(
+    IN ULONG Target)
 {
-    ULONG Target, Count;
+    ULONG Count;
 
-    Target = CcTotalDirtyPages / 8;
     if (Target != 0)
     {
-        /* Flush! */
+        /* Flush! Files being written by another worker are skipped */
         DPRINT("Lazy writer starting (%d)\n", Target);
         CcRosFlushDirtyPages(Target, &Count, FALSE, TRUE);
 
-        /* And update stats */
-        CcLazyWritePages += Count;
-        ++CcLazyWriteIos;
+        /* And update stats, other workers may be doing the same */
+        InterlockedExchangeAdd((PLONG)&CcLazyWritePages, Count);
+        InterlockedIncrement((PLONG)&CcLazyWriteIos);
         DPRINT("Lazy writer done (%d)\n", Count);
     }
 
@@ -142,10 +153,62 @@ CcWriteBehind(VOID)
     }
 }
 
+static
+ULONG
+CcComputeWriteBehindTarget(
+    IN ULONG DirtyPages)
+/*
+ * FUNCTION: Computes how many pages the lazy writer has to flush during this
+ *           scan so that it keeps up with the rate pages are being dirtied,
+ *           and brings the dirty pages back under half the threshold if
+ *           they went above it
+ * RETURNS: The number of pages to flush
+ */
+{
+    LARGE_INTEGER CurrentTime;
+    ULONGLONG Elapsed;
+    ULONG Written, Dirtied, Target, Background;
+
+    KeQuerySystemTime(&CurrentTime);
+
+    /* What was flushed and dirtied since the previous scan */
+    Written = CcLazyWritePages - CcLastScanWritePages;
+    Dirtied = 0;
+    if (DirtyPages + Written > CcLastScanDirtyPages)
+    {
+        Dirtied = DirtyPages + Written - CcLastScanDirtyPages;
+    }
+
+    /* Update the flush rate, in pages per second */
+    Elapsed = (CurrentTime.QuadPart - CcLastScanTime.QuadPart) / (10 * 1000);
+    if (CcLastScanTime.QuadPart != 0 && Elapsed != 0)
+    {
+        CcLazyWriteFlushRate = (ULONG)(((ULONGLONG)Written * 1000) / Elapsed);
+    }
+
+    CcLastScanTime = CurrentTime;
+    CcLastScanDirtyPages = DirtyPages;
+    CcLastScanWritePages = CcLazyWritePages;
+
+    /* Age the dirty pages by one-eighth at least, and keep up with writers */
+    Target = max(DirtyPages / 8, Dirtied);
+
+    /* Above half the threshold, also eat half the excess so that
+     * writers don't reach the point where they get throttled
+     */
+    Background = CcDirtyPageThreshold / 2;
+    if (DirtyPages > Background)
+    {
+        Target += (DirtyPages - Background) / 2;
+    }
+
+    return min(Target, DirtyPages);
+}
+
 VOID
 CcLazyWriteScan(VOID)
 {
-    ULONG Target;
+    ULONG Target, Workers, Share;
     KIRQL OldIrql;
     PLIST_ENTRY ListEntry;
     LIST_ENTRY ToPost;
@@ -164,21 +227,40 @@ CcLazyWriteScan(VOID)
         }
         LazyWriter.OtherWork = FALSE;
     }
+
+    Target = CcComputeWriteBehindTarget(CcTotalDirtyPages);
+
+    /* One worker per dirty file at most, a file is never written by two
+     * workers at once. Also don't bother splitting small targets.
+     */
+    Workers = 0;
+    for (ListEntry = CcDirtySharedCacheMapList.Flink;
+         ListEntry != &CcDirtySharedCacheMapList && Workers < CcNumberWorkerThreads;
+         ListEntry = ListEntry->Flink)
+    {
+        Workers++;
+    }
+    Workers = min(Workers, Target / CC_WRITE_BEHIND_MIN_PAGES);
+    Workers = max(Workers, 1);
     KeReleaseQueuedSpinLock(LockQueueMasterLock, OldIrql);
 
-    /* Our target is one-eighth of the dirty pages */
-    Target = CcTotalDirtyPages / 8;
-    if (Target != 0)
+    /* There is stuff to flush, schedule parallel write-behind operations */
+    while (Target != 0)
     {
-        /* There is stuff to flush, schedule a write-behind operation */
+        Share = Target / Workers;
+        Target -= Share;
+        Workers--;
 
         /* Allocate a work item */
         WorkItem = ExAllocateFromNPagedLookasideList(&CcTwilightLookasideList);
-        if (WorkItem != NULL)
+        if (WorkItem == NULL)
         {
-            WorkItem->Function = WriteBehind;
-            CcPostWorkQueue(WorkItem, &CcRegularWorkQueue);
+            break;
         }
+
+        WorkItem->Function = WriteBehind;
+        WorkItem->Parameters.Flush.Pages = Share;
+        CcPostWorkQueue(WorkItem, &CcRegularWorkQueue);
     }
 
     /* Post items that were due for end of run */
@@ -200,9 +282,17 @@ CcLazyWriteScan(VOID)
     }
     else
     {
-        /* We're no longer active */
         OldIrql = KeAcquireQueuedSpinLock(LockQueueMasterLock);
-        LazyWriter.ScanActive = FALSE;
+        /* Keep the pace while there are dirty pages */
+        if (CcTotalDirtyPages != 0)
+        {
+            CcScheduleLazyWriteScan(FALSE);
+        }
+        /* Otherwise, we're no longer active */
+        else
+        {
+            LazyWriter.ScanActive = FALSE;
+        }
         KeReleaseQueuedSpinLock(LockQueueMasterLock, OldIrql);
     }
 }
@@ -318,7 +408,7 @@ CcWorkerThread(
 
             case WriteBehind:
                 PsGetCurrentThread()->MemoryMaker = 1;
-                CcWriteBehind();
+                CcWriteBehind(WorkItem->Parameters.Flush.Pages);
                 PsGetCurrentThread()->MemoryMaker = 0;
                 WritePerformed = TRUE;
                 break;
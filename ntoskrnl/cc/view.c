@@ -38,8 +38,23 @@
 
 /* GLOBALS *******************************************************************/
 
-LIST_ENTRY DirtyVacbListHead;
-static LIST_ENTRY VacbLruListHead;
+/*
+ * VACBs are spread over several LRU lists, each with its own lock, so that
+ * mapping views on different processors does not contend on one list.
+ * Each list is scanned like a clock: a hit only sets Referenced, and the
+ * trimmer gives referenced views a second chance by moving them to the tail.
+ */
+#define CC_VACB_LRU_LISTS 8
+
+typedef struct _CC_VACB_LRU
+{
+    KSPIN_LOCK Lock;
+    LIST_ENTRY ListHead;
+    ULONG Count;
+} DECLSPEC_CACHEALIGN CC_VACB_LRU, *PCC_VACB_LRU;
+
+static CC_VACB_LRU CcVacbLru[CC_VACB_LRU_LISTS];
+static ULONG CcVacbLruHand;
 
 NPAGED_LOOKASIDE_LIST iBcbLookasideList;
 static NPAGED_LOOKASIDE_LIST SharedCacheMapLookasideList;
@@ -51,12 +66,14 @@ static NPAGED_LOOKASIDE_LIST VacbLookasideList;
  * - List for deferred writes
  * - Spinlock when dealing with the deferred list
  * - List for "clean" shared cache maps
+ * - List for shared cache maps with dirty VACBs
  */
 ULONG CcDirtyPageThreshold = 0;
 ULONG CcTotalDirtyPages = 0;
 LIST_ENTRY CcDeferredWrites;
 KSPIN_LOCK CcDeferredWriteSpinLock;
 LIST_ENTRY CcCleanSharedCacheMapList;
+LIST_ENTRY CcDirtySharedCacheMapList;
 
 #if DBG
 ULONG CcRosVacbIncRefCount_(PROS_VACB vacb, PCSTR file, INT line)
@@ -226,8 +243,7 @@ CcRosDeleteFileCache (
     {
         PROS_VACB Vacb = CONTAINING_RECORD(current_entry, ROS_VACB, CacheMapVacbListEntry);
 
-        RemoveEntryList(&Vacb->VacbLruListEntry);
-        InitializeListHead(&Vacb->VacbLruListEntry);
+        CcRosRemoveVacbFromLru(Vacb);
 
         if (Vacb->Dirty)
         {
@@ -323,58 +339,58 @@ CcRosFlushDirtyPages (
     KeEnterCriticalRegion();
     OldIrql = KeAcquireQueuedSpinLock(LockQueueMasterLock);
 
-    current_entry = DirtyVacbListHead.Flink;
-    if (current_entry == &DirtyVacbListHead)
+    current_entry = CcDirtySharedCacheMapList.Flink;
+    if (current_entry == &CcDirtySharedCacheMapList)
     {
         DPRINT("No Dirty pages\n");
     }
 
-    while (((current_entry != &DirtyVacbListHead) && (Target > 0)) || FlushAll)
+    while (((current_entry != &CcDirtySharedCacheMapList) && (Target > 0)) || FlushAll)
     {
         PROS_SHARED_CACHE_MAP SharedCacheMap;
         PROS_VACB current;
         BOOLEAN Locked;
 
-        if (current_entry == &DirtyVacbListHead)
+        if (current_entry == &CcDirtySharedCacheMapList)
         {
             ASSERT(FlushAll);
-            if (IsListEmpty(&DirtyVacbListHead))
+            if (IsListEmpty(&CcDirtySharedCacheMapList))
                 break;
-            current_entry = DirtyVacbListHead.Flink;
+            current_entry = CcDirtySharedCacheMapList.Flink;
         }
 
-        current = CONTAINING_RECORD(current_entry,
-                                    ROS_VACB,
-                                    DirtyVacbListEntry);
+        SharedCacheMap = CONTAINING_RECORD(current_entry,
+                                           ROS_SHARED_CACHE_MAP,
+                                           SharedCacheMapLinks);
         current_entry = current_entry->Flink;
 
-        CcRosVacbIncRefCount(current);
-
-        SharedCacheMap = current->SharedCacheMap;
-
         /* When performing lazy write, don't handle temporary files */
         if (CalledFromLazy && BooleanFlagOn(SharedCacheMap->FileObject->Flags, FO_TEMPORARY_FILE))
         {
-            CcRosVacbDecRefCount(current);
             continue;
         }
 
         /* Don't attempt to lazy write the files that asked not to */
         if (CalledFromLazy && BooleanFlagOn(SharedCacheMap->Flags, WRITEBEHIND_DISABLED))
         {
-            CcRosVacbDecRefCount(current);
             continue;
         }
 
-        ASSERT(current->Dirty);
-
         /* Do not lazy-write the same file concurrently. Fastfat ASSERTS on that */
         if (SharedCacheMap->Flags & SHARED_CACHE_MAP_IN_LAZYWRITE)
         {
-            CcRosVacbDecRefCount(current);
             continue;
         }
 
+        /* Take the oldest dirty VACB of this file */
+        ASSERT(!IsListEmpty(&SharedCacheMap->DirtyVacbListHead));
+        current = CONTAINING_RECORD(SharedCacheMap->DirtyVacbListHead.Flink,
+                                    ROS_VACB,
+                                    DirtyVacbListEntry);
+        ASSERT(current->Dirty);
+
+        CcRosVacbIncRefCount(current);
+
         SharedCacheMap->Flags |= SHARED_CACHE_MAP_IN_LAZYWRITE;
 
         /* Keep a ref on the shared cache map */
@@ -391,8 +407,17 @@ CcRosFlushDirtyPages (
             OldIrql = KeAcquireQueuedSpinLock(LockQueueMasterLock);
             SharedCacheMap->Flags &= ~SHARED_CACHE_MAP_IN_LAZYWRITE;
 
+            /* Go on with the next file, our place is lost if this one went clean */
+            if (IsListEmpty(&SharedCacheMap->DirtyVacbListHead))
+                current_entry = CcDirtySharedCacheMapList.Flink;
+            else
+                current_entry = SharedCacheMap->SharedCacheMapLinks.Flink;
+
             if (--SharedCacheMap->OpenCount == 0)
+            {
                 CcRosDeleteFileCache(SharedCacheMap->FileObject, SharedCacheMap, &OldIrql);
+                current_entry = CcDirtySharedCacheMapList.Flink;
+            }
 
             continue;
         }
@@ -411,6 +436,13 @@ CcRosFlushDirtyPages (
 
         SharedCacheMap->Flags &= ~SHARED_CACHE_MAP_IN_LAZYWRITE;
 
+        /* Still dirty, let the other files have their turn first */
+        if (!IsListEmpty(&SharedCacheMap->DirtyVacbListHead))
+        {
+            RemoveEntryList(&SharedCacheMap->SharedCacheMapLinks);
+            InsertTailList(&CcDirtySharedCacheMapList, &SharedCacheMap->SharedCacheMapLinks);
+        }
+
         if (--SharedCacheMap->OpenCount == 0)
             CcRosDeleteFileCache(SharedCacheMap->FileObject, SharedCacheMap, &OldIrql);
 
@@ -442,7 +474,7 @@ CcRosFlushDirtyPages (
             }
         }
 
-        current_entry = DirtyVacbListHead.Flink;
+        current_entry = CcDirtySharedCacheMapList.Flink;
     }
 
     KeReleaseQueuedSpinLock(LockQueueMasterLock, OldIrql);
@@ -452,6 +484,114 @@ CcRosFlushDirtyPages (
     return STATUS_SUCCESS;
 }
 
+VOID
+CcRosRemoveVacbFromLru(
+    _In_ PROS_VACB Vacb)
+/*
+ * FUNCTION: Unlinks a VACB from its LRU list
+ * NOTE: The caller holds the lock of the VACB's shared cache map
+ */
+{
+    PCC_VACB_LRU Lru = &CcVacbLru[Vacb->LruList];
+
+    KeAcquireSpinLockAtDpcLevel(&Lru->Lock);
+    if (!IsListEmpty(&Vacb->VacbLruListEntry))
+    {
+        RemoveEntryList(&Vacb->VacbLruListEntry);
+        InitializeListHead(&Vacb->VacbLruListEntry);
+        Lru->Count--;
+    }
+    KeReleaseSpinLockFromDpcLevel(&Lru->Lock);
+}
+
+static
+ULONG
+CcRosEvictVacbs(
+    _In_ ULONG Target,
+    _Inout_ PLIST_ENTRY FreeList)
+/*
+ * FUNCTION: Runs the clock over the LRU lists and unlinks unused VACBs.
+ * ARGUMENTS:
+ *       Target - The number of VACBs to evict.
+ *       FreeList - Receives the evicted VACBs, linked through
+ *                  CacheMapVacbListEntry. The caller frees them.
+ * RETURNS: The number of VACBs put on FreeList.
+ */
+{
+    ULONG Evicted = 0;
+    ULONG i;
+    KIRQL OldIrql;
+
+    for (i = 0; (i < CC_VACB_LRU_LISTS) && (Evicted < Target); i++)
+    {
+        PCC_VACB_LRU Lru;
+        PLIST_ENTRY current_entry;
+        ULONG Visited, Budget;
+
+        /* Don't always start with the same list */
+        Lru = &CcVacbLru[(ULONG)InterlockedIncrement((PLONG)&CcVacbLruHand) % CC_VACB_LRU_LISTS];
+
+        KeAcquireSpinLock(&Lru->Lock, &OldIrql);
+
+        /* Go around twice, the first pass may only clear the referenced bits */
+        Budget = 2 * Lru->Count;
+        current_entry = Lru->ListHead.Flink;
+        for (Visited = 0;
+             (Visited < Budget) && (current_entry != &Lru->ListHead) && (Evicted < Target);
+             Visited++)
+        {
+            PROS_SHARED_CACHE_MAP SharedCacheMap;
+            PROS_VACB current;
+            ULONG Refs;
+
+            current = CONTAINING_RECORD(current_entry,
+                                        ROS_VACB,
+                                        VacbLruListEntry);
+            SharedCacheMap = current->SharedCacheMap;
+            current_entry = current_entry->Flink;
+
+            /* Used since we last came by, give it a second chance */
+            if (current->Referenced)
+            {
+                current->Referenced = FALSE;
+                RemoveEntryList(&current->VacbLruListEntry);
+                InsertTailList(&Lru->ListHead, &current->VacbLruListEntry);
+
+                /* It was the last one, come back to it */
+                if (current_entry == &Lru->ListHead)
+                    current_entry = &current->VacbLruListEntry;
+                continue;
+            }
+
+            /* The map lock comes before ours, don't wait for it */
+            if (!KeTryToAcquireSpinLockAtDpcLevel(&SharedCacheMap->CacheMapLock))
+                continue;
+
+            /* Only deal with unused VACB, we will free them */
+            Refs = CcRosVacbGetRefCount(current);
+            if (Refs < 2)
+            {
+                ASSERT(!current->Dirty);
+                ASSERT(!current->MappedCount);
+                ASSERT(Refs == 1);
+
+                RemoveEntryList(&current->CacheMapVacbListEntry);
+                RemoveEntryList(&current->VacbLruListEntry);
+                InitializeListHead(&current->VacbLruListEntry);
+                Lru->Count--;
+                InsertHeadList(FreeList, &current->CacheMapVacbListEntry);
+                Evicted++;
+            }
+
+            KeReleaseSpinLockFromDpcLevel(&SharedCacheMap->CacheMapLock);
+        }
+
+        KeReleaseSpinLock(&Lru->Lock, OldIrql);
+    }
+
+    return Evicted;
+}
+
 VOID
 CcRosTrimCache(
     _In_ ULONG Target,
@@ -467,7 +607,7 @@ CcRosTrimCache(
     PLIST_ENTRY current_entry;
     PROS_VACB current;
     ULONG PagesFreed;
-    KIRQL oldIrql;
+    ULONG Evicted;
     LIST_ENTRY FreeList;
     BOOLEAN FlushedPages = FALSE;
 
@@ -478,79 +618,15 @@ CcRosTrimCache(
     *NrFreed = 0;
 
 retry:
-    oldIrql = KeAcquireQueuedSpinLock(LockQueueMasterLock);
-
-    current_entry = VacbLruListHead.Flink;
-    while (current_entry != &VacbLruListHead)
-    {
-        ULONG Refs;
+    /* Views are freed whole */
+    Evicted = CcRosEvictVacbs((Target + (VACB_MAPPING_GRANULARITY / PAGE_SIZE) - 1) /
+                              (VACB_MAPPING_GRANULARITY / PAGE_SIZE),
+                              &FreeList);
 
-        current = CONTAINING_RECORD(current_entry,
-                                    ROS_VACB,
-                                    VacbLruListEntry);
-
-        KeAcquireSpinLockAtDpcLevel(&current->SharedCacheMap->CacheMapLock);
-
-        /* Reference the VACB */
-        CcRosVacbIncRefCount(current);
-
-        /* Check if it's mapped and not dirty */
-        if (InterlockedCompareExchange((PLONG)&current->MappedCount, 0, 0) > 0 && !current->Dirty)
-        {
-            /* This code is never executed. It is left for reference only. */
-#if 1
-            DPRINT1("MmPageOutPhysicalAddress unexpectedly called\n");
-            ASSERT(FALSE);
-#else
-            ULONG i;
-            PFN_NUMBER Page;
-
-            /* We have to break these locks to call MmPageOutPhysicalAddress */
-            KeReleaseSpinLockFromDpcLevel(&current->SharedCacheMap->CacheMapLock);
-            KeReleaseQueuedSpinLock(LockQueueMasterLock, oldIrql);
-
-            /* Page out the VACB */
-            for (i = 0; i < VACB_MAPPING_GRANULARITY / PAGE_SIZE; i++)
-            {
-                Page = (PFN_NUMBER)(MmGetPhysicalAddress((PUCHAR)current->BaseAddress + (i * PAGE_SIZE)).QuadPart >> PAGE_SHIFT);
-
-                MmPageOutPhysicalAddress(Page);
-            }
-
-            /* Reacquire the locks */
-            oldIrql = KeAcquireQueuedSpinLock(LockQueueMasterLock);
-            KeAcquireSpinLockAtDpcLevel(&current->SharedCacheMap->CacheMapLock);
-#endif
-        }
-
-        /* Only keep iterating though the loop while the lock is held */
-        current_entry = current_entry->Flink;
-
-        /* Dereference the VACB */
-        Refs = CcRosVacbDecRefCount(current);
-
-        /* Check if we can free this entry now */
-        if (Refs < 2)
-        {
-            ASSERT(!current->Dirty);
-            ASSERT(!current->MappedCount);
-            ASSERT(Refs == 1);
-
-            RemoveEntryList(&current->CacheMapVacbListEntry);
-            RemoveEntryList(&current->VacbLruListEntry);
-            InitializeListHead(&current->VacbLruListEntry);
-            InsertHeadList(&FreeList, &current->CacheMapVacbListEntry);
-
-            /* Calculate how many pages we freed for Mm */
-            PagesFreed = min(VACB_MAPPING_GRANULARITY / PAGE_SIZE, Target);
-            Target -= PagesFreed;
-            (*NrFreed) += PagesFreed;
-        }
-
-        KeReleaseSpinLockFromDpcLevel(&current->SharedCacheMap->CacheMapLock);
-    }
-
-    KeReleaseQueuedSpinLock(LockQueueMasterLock, oldIrql);
+    /* Calculate how many pages we freed for Mm */
+    PagesFreed = min(Evicted * (VACB_MAPPING_GRANULARITY / PAGE_SIZE), Target);
+    Target -= PagesFreed;
+    (*NrFreed) += PagesFreed;
 
     /* Try flushing pages if we haven't met our target */
     if ((Target > 0) && !FlushedPages)
@@ -633,8 +709,7 @@ CcRosLookupVacb (
     DPRINT("CcRosLookupVacb(SharedCacheMap 0x%p, FileOffset %I64u)\n",
            SharedCacheMap, FileOffset);
 
-    oldIrql = KeAcquireQueuedSpinLock(LockQueueMasterLock);
-    KeAcquireSpinLockAtDpcLevel(&SharedCacheMap->CacheMapLock);
+    KeAcquireSpinLock(&SharedCacheMap->CacheMapLock, &oldIrql);
 
     current_entry = SharedCacheMap->CacheMapVacbListHead.Flink;
     while (current_entry != &SharedCacheMap->CacheMapVacbListHead)
@@ -647,8 +722,7 @@ CcRosLookupVacb (
                            FileOffset))
         {
             CcRosVacbIncRefCount(current);
-            KeReleaseSpinLockFromDpcLevel(&SharedCacheMap->CacheMapLock);
-            KeReleaseQueuedSpinLock(LockQueueMasterLock, oldIrql);
+            KeReleaseSpinLock(&SharedCacheMap->CacheMapLock, oldIrql);
             return current;
         }
         if (current->FileOffset.QuadPart > FileOffset)
@@ -656,8 +730,7 @@ CcRosLookupVacb (
         current_entry = current_entry->Flink;
     }
 
-    KeReleaseSpinLockFromDpcLevel(&SharedCacheMap->CacheMapLock);
-    KeReleaseQueuedSpinLock(LockQueueMasterLock, oldIrql);
+    KeReleaseSpinLock(&SharedCacheMap->CacheMapLock, oldIrql);
 
     return NULL;
 }
@@ -676,15 +749,21 @@ CcRosMarkDirtyVacb (
 
     ASSERT(!Vacb->Dirty);
 
-    InsertTailList(&DirtyVacbListHead, &Vacb->DirtyVacbListEntry);
+    /* First dirty VACB of this file, move it to the dirty maps */
+    if (IsListEmpty(&SharedCacheMap->DirtyVacbListHead))
+    {
+        RemoveEntryList(&SharedCacheMap->SharedCacheMapLinks);
+        InsertTailList(&CcDirtySharedCacheMapList, &SharedCacheMap->SharedCacheMapLinks);
+    }
+
+    InsertTailList(&SharedCacheMap->DirtyVacbListHead, &Vacb->DirtyVacbListEntry);
     /* FIXME: There is no reason to account for the whole VACB. */
     CcTotalDirtyPages += VACB_MAPPING_GRANULARITY / PAGE_SIZE;
     Vacb->SharedCacheMap->DirtyPages += VACB_MAPPING_GRANULARITY / PAGE_SIZE;
     CcRosVacbIncRefCount(Vacb);
 
-    /* Move to the tail of the LRU list */
-    RemoveEntryList(&Vacb->VacbLruListEntry);
-    InsertTailList(&VacbLruListHead, &Vacb->VacbLruListEntry);
+    /* Writing to it counts as a use */
+    Vacb->Referenced = TRUE;
 
     Vacb->Dirty = TRUE;
 
@@ -724,6 +803,13 @@ CcRosUnmarkDirtyVacb (
     CcTotalDirtyPages -= VACB_MAPPING_GRANULARITY / PAGE_SIZE;
     Vacb->SharedCacheMap->DirtyPages -= VACB_MAPPING_GRANULARITY / PAGE_SIZE;
 
+    /* That was the last one, the file is clean again */
+    if (IsListEmpty(&SharedCacheMap->DirtyVacbListHead))
+    {
+        RemoveEntryList(&SharedCacheMap->SharedCacheMapLinks);
+        InsertTailList(&CcCleanSharedCacheMapList, &SharedCacheMap->SharedCacheMapLinks);
+    }
+
     CcRosVacbDecRefCount(Vacb);
 
     if (LockViews)
@@ -737,55 +823,23 @@ BOOLEAN
 CcRosFreeOneUnusedVacb(
     VOID)
 {
-    KIRQL oldIrql;
-    PLIST_ENTRY current_entry;
-    PROS_VACB to_free = NULL;
-
-    oldIrql = KeAcquireQueuedSpinLock(LockQueueMasterLock);
-
-    /* Browse all the available VACB */
-    current_entry = VacbLruListHead.Flink;
-    while ((current_entry != &VacbLruListHead) && (to_free == NULL))
-    {
-        ULONG Refs;
-        PROS_VACB current;
-
-        current = CONTAINING_RECORD(current_entry,
-                                    ROS_VACB,
-                                    VacbLruListEntry);
-
-        KeAcquireSpinLockAtDpcLevel(&current->SharedCacheMap->CacheMapLock);
-
-        /* Only deal with unused VACB, we will free them */
-        Refs = CcRosVacbGetRefCount(current);
-        if (Refs < 2)
-        {
-            ASSERT(!current->Dirty);
-            ASSERT(!current->MappedCount);
-            ASSERT(Refs == 1);
-
-            /* Reset it, this is the one we want to free */
-            RemoveEntryList(&current->CacheMapVacbListEntry);
-            InitializeListHead(&current->CacheMapVacbListEntry);
-            RemoveEntryList(&current->VacbLruListEntry);
-            InitializeListHead(&current->VacbLruListEntry);
-
-            to_free = current;
-        }
-
-        KeReleaseSpinLockFromDpcLevel(&current->SharedCacheMap->CacheMapLock);
-
-        current_entry = current_entry->Flink;
-    }
+    LIST_ENTRY FreeList;
+    PROS_VACB to_free;
 
-    KeReleaseQueuedSpinLock(LockQueueMasterLock, oldIrql);
+    InitializeListHead(&FreeList);
 
-    /* And now, free the VACB that we found, if any. */
-    if (to_free == NULL)
+    /* Let the clock pick one */
+    if (CcRosEvictVacbs(1, &FreeList) == 0)
     {
         return FALSE;
     }
 
+    to_free = CONTAINING_RECORD(RemoveHeadList(&FreeList),
+                                ROS_VACB,
+                                CacheMapVacbListEntry);
+    InitializeListHead(&to_free->CacheMapVacbListEntry);
+    ASSERT(IsListEmpty(&FreeList));
+
     /* This must be its last ref */
     NT_VERIFY(CcRosVacbDecRefCount(to_free) == 0);
 
@@ -802,6 +856,7 @@ CcRosCreateVacb (
     PROS_VACB current;
     PROS_VACB previous;
     PLIST_ENTRY current_entry;
+    PCC_VACB_LRU Lru;
     NTSTATUS Status;
     KIRQL oldIrql;
     ULONG Refs;
@@ -819,6 +874,9 @@ CcRosCreateVacb (
     current->BaseAddress = NULL;
     current->Dirty = FALSE;
     current->PageOut = FALSE;
+    /* Not referenced until it is used again, so that a single scan goes first */
+    current->Referenced = FALSE;
+    current->LruList = (UCHAR)(KeGetCurrentProcessorNumber() % CC_VACB_LRU_LISTS);
     current->FileOffset.QuadPart = ROUND_DOWN(FileOffset, VACB_MAPPING_GRANULARITY);
     current->SharedCacheMap = SharedCacheMap;
     current->MappedCount = 0;
@@ -857,15 +915,13 @@ CcRosCreateVacb (
     }
 #endif
 
-    oldIrql = KeAcquireQueuedSpinLock(LockQueueMasterLock);
-
     *Vacb = current;
     /* There is window between the call to CcRosLookupVacb
      * and CcRosCreateVacb. We must check if a VACB for the
      * file offset exist. If there is a VACB, we release
      * our newly created VACB and return the existing one.
      */
-    KeAcquireSpinLockAtDpcLevel(&SharedCacheMap->CacheMapLock);
+    KeAcquireSpinLock(&SharedCacheMap->CacheMapLock, &oldIrql);
     current_entry = SharedCacheMap->CacheMapVacbListHead.Flink;
     previous = NULL;
     while (current_entry != &SharedCacheMap->CacheMapVacbListHead)
@@ -878,7 +934,8 @@ CcRosCreateVacb (
                            FileOffset))
         {
             CcRosVacbIncRefCount(current);
-            KeReleaseSpinLockFromDpcLevel(&SharedCacheMap->CacheMapLock);
+            current->Referenced = TRUE;
+            KeReleaseSpinLock(&SharedCacheMap->CacheMapLock, oldIrql);
 #if DBG
             if (SharedCacheMap->Trace)
             {
@@ -888,7 +945,6 @@ CcRosCreateVacb (
                         current);
             }
 #endif
-            KeReleaseQueuedSpinLock(LockQueueMasterLock, oldIrql);
 
             Refs = CcRosVacbDecRefCount(*Vacb);
             ASSERT(Refs == 0);
@@ -916,13 +972,17 @@ CcRosCreateVacb (
     {
         InsertHeadList(&SharedCacheMap->CacheMapVacbListHead, &current->CacheMapVacbListEntry);
     }
-    KeReleaseSpinLockFromDpcLevel(&SharedCacheMap->CacheMapLock);
-    InsertTailList(&VacbLruListHead, &current->VacbLruListEntry);
 
-    /* Reference it to allow release */
+    Lru = &CcVacbLru[current->LruList];
+    KeAcquireSpinLockAtDpcLevel(&Lru->Lock);
+    InsertTailList(&Lru->ListHead, &current->VacbLruListEntry);
+    Lru->Count++;
+    KeReleaseSpinLockFromDpcLevel(&Lru->Lock);
+
+    /* Reference it to allow release, before the trimmer can see it unused */
     CcRosVacbIncRefCount(current);
 
-    KeReleaseQueuedSpinLock(LockQueueMasterLock, oldIrql);
+    KeReleaseSpinLock(&SharedCacheMap->CacheMapLock, oldIrql);
 
     return Status;
 }
@@ -982,7 +1042,6 @@ CcRosGetVacb (
     PROS_VACB current;
     NTSTATUS Status;
     ULONG Refs;
-    KIRQL OldIrql;
 
     ASSERT(SharedCacheMap);
 
@@ -1003,17 +1062,14 @@ CcRosGetVacb (
             return Status;
         }
     }
+    else
+    {
+        /* A hit, the clock will spare it next time around. No lock needed for that */
+        current->Referenced = TRUE;
+    }
 
     Refs = CcRosVacbGetRefCount(current);
 
-    OldIrql = KeAcquireQueuedSpinLock(LockQueueMasterLock);
-
-    /* Move to the tail of the LRU list */
-    RemoveEntryList(&current->VacbLruListEntry);
-    InsertTailList(&VacbLruListHead, &current->VacbLruListEntry);
-
-    KeReleaseQueuedSpinLock(LockQueueMasterLock, OldIrql);
-
     /*
      * Return the VACB to the caller.
      */
@@ -1259,7 +1315,7 @@ CcRosReleaseFileCache (
             KeReleaseSpinLockFromDpcLevel(&SharedCacheMap->CacheMapLock);
 
             /* And free it. */
-            if (PrivateMap != &SharedCacheMap->PrivateCacheMap)
+            if (PrivateMap != &SharedCacheMap->PrivateCacheMap.PrivateCacheMap)
             {
                 ExFreePoolWithTag(PrivateMap, TAG_PRIVATE_CACHE_MAP);
             }
@@ -1325,6 +1381,7 @@ CcRosInitializeFileCache (
         InitializeListHead(&SharedCacheMap->PrivateList);
         KeInitializeSpinLock(&SharedCacheMap->CacheMapLock);
         InitializeListHead(&SharedCacheMap->CacheMapVacbListHead);
+        InitializeListHead(&SharedCacheMap->DirtyVacbListHead);
         InitializeListHead(&SharedCacheMap->BcbList);
         KeInitializeGuardedMutex(&SharedCacheMap->FlushCacheLock);
 
@@ -1364,13 +1421,13 @@ CcRosInitializeFileCache (
         PPRIVATE_CACHE_MAP PrivateMap;
 
         /* Allocate the private cache map for this handle */
-        if (SharedCacheMap->PrivateCacheMap.NodeTypeCode != 0)
+        if (SharedCacheMap->PrivateCacheMap.PrivateCacheMap.NodeTypeCode != 0)
         {
-            PrivateMap = ExAllocatePoolWithTag(NonPagedPool, sizeof(PRIVATE_CACHE_MAP), TAG_PRIVATE_CACHE_MAP);
+            PrivateMap = ExAllocatePoolWithTag(NonPagedPool, sizeof(ROS_PRIVATE_CACHE_MAP), TAG_PRIVATE_CACHE_MAP);
         }
         else
         {
-            PrivateMap = &SharedCacheMap->PrivateCacheMap;
+            PrivateMap = &SharedCacheMap->PrivateCacheMap.PrivateCacheMap;
         }
 
         if (PrivateMap == NULL)
@@ -1390,7 +1447,7 @@ CcRosInitializeFileCache (
         }
 
         /* Initialize it */
-        RtlZeroMemory(PrivateMap, sizeof(PRIVATE_CACHE_MAP));
+        RtlZeroMemory(PrivateMap, sizeof(ROS_PRIVATE_CACHE_MAP));
         PrivateMap->NodeTypeCode = NODE_TYPE_PRIVATE_MAP;
         PrivateMap->ReadAheadMask = PAGE_SIZE - 1;
         PrivateMap->FileObject = FileObject;
@@ -1476,12 +1533,19 @@ NTAPI
 CcInitView (
     VOID)
 {
+    ULONG i;
+
     DPRINT("CcInitView()\n");
 
-    InitializeListHead(&DirtyVacbListHead);
-    InitializeListHead(&VacbLruListHead);
+    for (i = 0; i < CC_VACB_LRU_LISTS; i++)
+    {
+        KeInitializeSpinLock(&CcVacbLru[i].Lock);
+        InitializeListHead(&CcVacbLru[i].ListHead);
+        CcVacbLru[i].Count = 0;
+    }
     InitializeListHead(&CcDeferredWrites);
     InitializeListHead(&CcCleanSharedCacheMapList);
+    InitializeListHead(&CcDirtySharedCacheMapList);
     KeInitializeSpinLock(&CcDeferredWriteSpinLock);
     ExInitializeNPagedLookasideList(&iBcbLookasideList,
                                     NULL,
@@ -1516,56 +1580,61 @@ BOOLEAN
 ExpKdbgExtFileCache(ULONG Argc, PCHAR Argv[])
 {
     PLIST_ENTRY ListEntry;
+    PLIST_ENTRY Lists[] = { &CcDirtySharedCacheMapList, &CcCleanSharedCacheMapList };
+    ULONG i;
     UNICODE_STRING NoName = RTL_CONSTANT_STRING(L"No name for File");
 
     KdbpPrint("  Usage Summary (in kb)\n");
     KdbpPrint("Shared\t\tMapped\tDirty\tName\n");
     /* No need to lock the spin lock here, we're in DBG */
-    for (ListEntry = CcCleanSharedCacheMapList.Flink;
-         ListEntry != &CcCleanSharedCacheMapList;
-         ListEntry = ListEntry->Flink)
+    for (i = 0; i < RTL_NUMBER_OF(Lists); i++)
     {
-        PLIST_ENTRY Vacbs;
-        ULONG Mapped = 0, Dirty = 0;
-        PROS_SHARED_CACHE_MAP SharedCacheMap;
-        PUNICODE_STRING FileName;
-        PWSTR Extra = L"";
+        for (ListEntry = Lists[i]->Flink;
+             ListEntry != Lists[i];
+             ListEntry = ListEntry->Flink)
+        {
+            PLIST_ENTRY Vacbs;
+            ULONG Mapped = 0, Dirty = 0;
+            PROS_SHARED_CACHE_MAP SharedCacheMap;
+            PUNICODE_STRING FileName;
+            PWSTR Extra = L"";
 
-        SharedCacheMap = CONTAINING_RECORD(ListEntry, ROS_SHARED_CACHE_MAP, SharedCacheMapLinks);
+            SharedCacheMap = CONTAINING_RECORD(ListEntry, ROS_SHARED_CACHE_MAP, SharedCacheMapLinks);
 
-        /* Dirty size */
-        Dirty = (SharedCacheMap->DirtyPages * PAGE_SIZE) / 1024;
+            /* Dirty size */
+            Dirty = (SharedCacheMap->DirtyPages * PAGE_SIZE) / 1024;
 
-        /* First, count for all the associated VACB */
-        for (Vacbs = SharedCacheMap->CacheMapVacbListHead.Flink;
-             Vacbs != &SharedCacheMap->CacheMapVacbListHead;
-             Vacbs = Vacbs->Flink)
-        {
-            Mapped += VACB_MAPPING_GRANULARITY / 1024;
-        }
+            /* First, count for all the associated VACB */
+            for (Vacbs = SharedCacheMap->CacheMapVacbListHead.Flink;
+                 Vacbs != &SharedCacheMap->CacheMapVacbListHead;
+                 Vacbs = Vacbs->Flink)
+            {
+                Mapped += VACB_MAPPING_GRANULARITY / 1024;
+            }
 
-        /* Setup name */
-        if (SharedCacheMap->FileObject != NULL &&
-            SharedCacheMap->FileObject->FileName.Length != 0)
-        {
-            FileName = &SharedCacheMap->FileObject->FileName;
-        }
-        else if (SharedCacheMap->FileObject != NULL &&
-                 SharedCacheMap->FileObject->FsContext != NULL &&
-                 ((PFSRTL_COMMON_FCB_HEADER)(SharedCacheMap->FileObject->FsContext))->NodeTypeCode == 0x0502 &&
-                 ((PFSRTL_COMMON_FCB_HEADER)(SharedCacheMap->FileObject->FsContext))->NodeByteSize == 0x1F8 &&
-                 ((PUNICODE_STRING)(((PUCHAR)SharedCacheMap->FileObject->FsContext) + 0x100))->Length != 0)
-        {
-            FileName = (PUNICODE_STRING)(((PUCHAR)SharedCacheMap->FileObject->FsContext) + 0x100);
-            Extra = L" (FastFAT)";
-        }
-        else
-        {
-            FileName = &NoName;
-        }
+            /* Setup name */
+            if (SharedCacheMap->FileObject != NULL &&
+                SharedCacheMap->FileObject->FileName.Length != 0)
+            {
+                FileName = &SharedCacheMap->FileObject->FileName;
+            }
+            else if (SharedCacheMap->FileObject != NULL &&
+                     SharedCacheMap->FileObject->FsContext != NULL &&
+                     ((PFSRTL_COMMON_FCB_HEADER)(SharedCacheMap->FileObject->FsContext))->NodeTypeCode == 0x0502 &&
+                     ((PFSRTL_COMMON_FCB_HEADER)(SharedCacheMap->FileObject->FsContext))->NodeByteSize == 0x1F8 &&
+                     ((PUNICODE_STRING)(((PUCHAR)SharedCacheMap->FileObject->FsContext) + 0x100))->Length != 0)
+            {
+                FileName = (PUNICODE_STRING)(((PUCHAR)SharedCacheMap->FileObject->FsContext) + 0x100);
+                Extra = L" (FastFAT)";
+            }
+            else
+            {
+                FileName = &NoName;
+            }
 
-        /* And print */
-        KdbpPrint("%p\t%d\t%d\t%wZ%S\n", SharedCacheMap, Mapped, Dirty, FileName, Extra);
+            /* And print */
+            KdbpPrint("%p\t%d\t%d\t%wZ%S\n", SharedCacheMap, Mapped, Dirty, FileName, Extra);
+        }
     }
 
     return TRUE;
@@ -1586,6 +1655,10 @@ ExpKdbgExtDefWrites(ULONG Argc, PCHAR Argv[])
               (MmThrottleBottom * PAGE_SIZE) / 1024);
     KdbpPrint("MmModifiedPageListHead.Total:\t%lu (%lu Kb)\n", MmModifiedPageListHead.Total,
               (MmModifiedPageListHead.Total * PAGE_SIZE) / 1024);
+    KdbpPrint("CcLazyWriteFlushRate:\t%lu (%lu Kb/s)\n", CcLazyWriteFlushRate,
+              (CcLazyWriteFlushRate * PAGE_SIZE) / 1024);
+    KdbpPrint("CcThrottleWaits:\t%lu\n", CcThrottleWaits);
+    KdbpPrint("CcThrottleDelays:\t%lu (%lu ms)\n", CcThrottleDelays, CcThrottleDelayTime);
 
     if (CcTotalDirtyPages >= CcDirtyPageThreshold)
     {
@@ -1603,6 +1676,59 @@ ExpKdbgExtDefWrites(ULONG Argc, PCHAR Argv[])
     return TRUE;
 }
 
+BOOLEAN
+ExpKdbgExtReadAhead(ULONG Argc, PCHAR Argv[])
+{
+    PLIST_ENTRY ListEntry;
+    PLIST_ENTRY Lists[] = { &CcDirtySharedCacheMapList, &CcCleanSharedCacheMapList };
+    ULONG i;
+    UNICODE_STRING NoName = RTL_CONSTANT_STRING(L"No name for File");
+
+    KdbpPrint("CcReadAheadIos:\t%lu\n", CcReadAheadIos);
+    KdbpPrint("Shared\t\tIos\tKb\tHits\tMisses\tName\n");
+    /* No need to lock the spin lock here, we're in DBG */
+    for (i = 0; i < RTL_NUMBER_OF(Lists); i++)
+    {
+        for (ListEntry = Lists[i]->Flink;
+             ListEntry != Lists[i];
+             ListEntry = ListEntry->Flink)
+        {
+            PROS_SHARED_CACHE_MAP SharedCacheMap;
+            PUNICODE_STRING FileName;
+
+            SharedCacheMap = CONTAINING_RECORD(ListEntry, ROS_SHARED_CACHE_MAP, SharedCacheMapLinks);
+
+            /* Only the files that were read ahead */
+            if (SharedCacheMap->ReadAheadIos == 0 &&
+                SharedCacheMap->ReadAheadHits == 0 &&
+                SharedCacheMap->ReadAheadMisses == 0)
+            {
+                continue;
+            }
+
+            if (SharedCacheMap->FileObject != NULL &&
+                SharedCacheMap->FileObject->FileName.Length != 0)
+            {
+                FileName = &SharedCacheMap->FileObject->FileName;
+            }
+            else
+            {
+                FileName = &NoName;
+            }
+
+            KdbpPrint("%p\t%lu\t%lu\t%lu\t%lu\t%wZ\n",
+                      SharedCacheMap,
+                      SharedCacheMap->ReadAheadIos,
+                      (SharedCacheMap->ReadAheadPages * PAGE_SIZE) / 1024,
+                      SharedCacheMap->ReadAheadHits,
+                      SharedCacheMap->ReadAheadMisses,
+                      FileName);
+        }
+    }
+
+    return TRUE;
+}
+
 #endif // DBG && defined(KDBG)
 
 /* EOF */
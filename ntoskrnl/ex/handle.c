@@ -18,6 +18,7 @@
 LIST_ENTRY HandleTableListHead;
 EX_PUSH_LOCK HandleTableListLock;
 #define SizeOfHandle(x) (sizeof(HANDLE) * (x))
+#define SizeOfHandleTable(x) FIELD_OFFSET(EX_HANDLE_TABLE, Caches[(x)])
 #define INDEX_TO_HANDLE_VALUE(x) ((x) << HANDLE_TAG_BITS)
 
 /* PRIVATE FUNCTIONS *********************************************************/
@@ -51,14 +52,18 @@ ExpLookupHandleTableEntry(IN PHANDLE_TABLE HandleTable,
     /* Clear the tag bits */
     Handle.TagBits = 0;
 
-    /* Check if the handle is in the allocated range */
-    if (Handle.Value >= HandleTable->NextHandleNeedingPool)
+    /* Check if the handle is in the allocated range.
+     * No lock is needed: tables only grow, and a new level is published
+     * before NextHandleNeedingPool covers it, so read them in that order.
+     */
+    if (Handle.Value >= *(volatile ULONG *)&HandleTable->NextHandleNeedingPool)
     {
         return NULL;
     }
+    KeMemoryBarrierWithoutFence();
 
     /* Get the table code */
-    TableBase = HandleTable->TableCode;
+    TableBase = *(volatile ULONG_PTR *)&HandleTable->TableCode;
 
     /* Extract the table level and actual table base */
     TableLevel = (ULONG)(TableBase & 3);
@@ -73,14 +78,14 @@ ExpLookupHandleTableEntry(IN PHANDLE_TABLE HandleTable,
         case 2:
 
             /* Get the mid level pointer array */
-            PointerArray = PointerArray[Handle.HighIndex];
+            PointerArray = ((PVOID volatile *)PointerArray)[Handle.HighIndex];
             ASSERT(PointerArray != NULL);
 
             /* Fall through */
         case 1:
 
             /* Get the handle array */
-            HandleArray = PointerArray[Handle.MidIndex];
+            HandleArray = ((PVOID volatile *)PointerArray)[Handle.MidIndex];
             ASSERT(HandleArray != NULL);
 
             /* Fall through */
@@ -203,6 +208,7 @@ ExpFreeHandleTable(IN PHANDLE_TABLE HandleTable)
 {
     PEPROCESS Process = HandleTable->QuotaProcess;
     ULONG i, j;
+    SIZE_T Size;
     ULONG_PTR TableCode = HandleTable->TableCode;
     ULONG_PTR TableBase = TableCode & ~3;
     ULONG TableLevel = (ULONG)(TableCode & 3);
@@ -266,38 +272,72 @@ ExpFreeHandleTable(IN PHANDLE_TABLE HandleTable)
     }
 
     /* Free the actual table and check if we need to release quota */
+    Size = SizeOfHandleTable(CONTAINING_RECORD(HandleTable, EX_HANDLE_TABLE, HandleTable)->CacheCount);
     ExFreePoolWithTag(HandleTable, TAG_OBJECT_TABLE);
     if (Process)
     {
         /* Release the quota it was taking up */
-        PsReturnProcessPagedPoolQuota(Process, sizeof(HANDLE_TABLE));
+        PsReturnProcessPagedPoolQuota(Process, Size);
     }
 }
 
-VOID
+PEX_HANDLE_CACHE
 NTAPI
-ExpFreeHandleTableEntry(IN PHANDLE_TABLE HandleTable,
-                        IN EXHANDLE Handle,
-                        IN PHANDLE_TABLE_ENTRY HandleTableEntry)
+ExpAcquireHandleCache(IN PHANDLE_TABLE HandleTable)
 {
-    ULONG OldValue, *Free;
-    ULONG LockIndex;
-    PAGED_CODE();
+    PEX_HANDLE_TABLE Table;
+    PEX_HANDLE_CACHE Cache;
 
-    /* Sanity checks */
-    ASSERT(HandleTableEntry->Object == NULL);
-    ASSERT(HandleTableEntry == ExpLookupHandleTableEntry(HandleTable, Handle));
+    /* Handles of strict FIFO tables are reused in order, don't cache them */
+    if (HandleTable->StrictFIFO) return NULL;
 
-    /* Decrement the handle count */
-    InterlockedDecrement(&HandleTable->HandleCount);
+    /* Get the cache of this processor */
+    Table = CONTAINING_RECORD(HandleTable, EX_HANDLE_TABLE, HandleTable);
+    Cache = &Table->Caches[KeGetCurrentProcessorNumber() % Table->CacheCount];
 
-    /* Mark the handle as free */
-    Handle.TagBits = 0;
+    /* We may be preempted while using it, so whoever comes next
+     * on this processor will just go to the table instead
+     */
+    if (InterlockedCompareExchange(&Cache->Busy, 1, 0) != 0) return NULL;
+    return Cache;
+}
+
+VOID
+NTAPI
+ExpReleaseHandleCache(IN PEX_HANDLE_CACHE Cache)
+{
+    /* Let others use it again */
+    InterlockedExchange(&Cache->Busy, 0);
+}
+
+VOID
+NTAPI
+ExpPushFreeHandles(IN PHANDLE_TABLE HandleTable,
+                   IN PULONG Handles,
+                   IN ULONG Count)
+{
+    ULONG OldValue, *Free;
+    ULONG LockIndex, i;
+    EXHANDLE Handle;
+    PHANDLE_TABLE_ENTRY Last;
+
+    /* Chain the handles together */
+    Handle.GenericHandleOverlay = NULL;
+    Handle.Value = Handles[0];
+    Last = ExpLookupHandleTableEntry(HandleTable, Handle);
+    for (i = 1; i < Count; i++)
+    {
+        Handle.Value = Handles[i];
+        Last->NextFreeTableEntry = Handles[i];
+        Last = ExpLookupHandleTableEntry(HandleTable, Handle);
+        ASSERT(Last->Object == NULL);
+    }
 
     /* Check if we're FIFO */
     if (!HandleTable->StrictFIFO)
     {
         /* Select a lock index */
+        Handle.Value = Handles[0];
         LockIndex = Handle.Index % 4;
 
         /* Select which entry to use */
@@ -315,8 +355,8 @@ ExpFreeHandleTableEntry(IN PHANDLE_TABLE HandleTable,
     {
         /* Get the current value and write */
         OldValue = *Free;
-        HandleTableEntry->NextFreeTableEntry = OldValue;
-        if (InterlockedCompareExchange((PLONG)Free, Handle.AsULONG, OldValue) == OldValue)
+        Last->NextFreeTableEntry = OldValue;
+        if (InterlockedCompareExchange((PLONG)Free, Handles[0], OldValue) == OldValue)
         {
             /* Break out, we're done. Make sure the handle value makes sense */
             ASSERT((OldValue & FREE_HANDLE_MASK) <
@@ -326,37 +366,87 @@ ExpFreeHandleTableEntry(IN PHANDLE_TABLE HandleTable,
     }
 }
 
+VOID
+NTAPI
+ExpFreeHandleTableEntry(IN PHANDLE_TABLE HandleTable,
+                        IN EXHANDLE Handle,
+                        IN PHANDLE_TABLE_ENTRY HandleTableEntry)
+{
+    PEX_HANDLE_CACHE Cache;
+    ULONG Value;
+    PAGED_CODE();
+
+    /* Sanity checks */
+    ASSERT(HandleTableEntry->Object == NULL);
+    ASSERT(HandleTableEntry == ExpLookupHandleTableEntry(HandleTable, Handle));
+
+    /* Decrement the handle count */
+    InterlockedDecrement(&HandleTable->HandleCount);
+
+    /* Mark the handle as free */
+    Handle.TagBits = 0;
+    Value = Handle.AsULONG;
+
+    /* Keep it on this processor, for the next handle it creates */
+    Cache = ExpAcquireHandleCache(HandleTable);
+    if (Cache)
+    {
+        /* If the cache is full, give its older half back to the table at once */
+        if (Cache->Count == EX_HANDLE_CACHE_SIZE)
+        {
+            ExpPushFreeHandles(HandleTable, Cache->Handles, EX_HANDLE_CACHE_BATCH);
+            RtlMoveMemory(Cache->Handles,
+                          &Cache->Handles[EX_HANDLE_CACHE_BATCH],
+                          (EX_HANDLE_CACHE_SIZE - EX_HANDLE_CACHE_BATCH) * sizeof(ULONG));
+            Cache->Count -= EX_HANDLE_CACHE_BATCH;
+        }
+
+        Cache->Handles[Cache->Count++] = Value;
+        ExpReleaseHandleCache(Cache);
+        return;
+    }
+
+    /* Otherwise, it goes straight back to the table */
+    ExpPushFreeHandles(HandleTable, &Value, 1);
+}
+
 PHANDLE_TABLE
 NTAPI
 ExpAllocateHandleTable(IN PEPROCESS Process OPTIONAL,
                        IN BOOLEAN NewTable)
 {
+    PEX_HANDLE_TABLE Table;
     PHANDLE_TABLE HandleTable;
     PHANDLE_TABLE_ENTRY HandleTableTable, HandleEntry;
-    ULONG i;
+    ULONG i, CacheCount;
+    SIZE_T Size;
     NTSTATUS Status;
     PAGED_CODE();
 
-    /* Allocate the table */
-    HandleTable = ExAllocatePoolWithTag(PagedPool,
-                                        sizeof(HANDLE_TABLE),
-                                        TAG_OBJECT_TABLE);
-    if (!HandleTable) return NULL;
+    /* Allocate the table, with a free handle cache for each processor.
+     * The system tables are created before the other processors start.
+     */
+    CacheCount = Process ? KeNumberProcessors : MAXIMUM_PROCESSORS;
+    Size = SizeOfHandleTable(CacheCount);
+    Table = ExAllocatePoolWithTag(PagedPool, Size, TAG_OBJECT_TABLE);
+    if (!Table) return NULL;
 
     /* Check if we have a process */
     if (Process)
     {
         /* Charge quota */
-        Status = PsChargeProcessPagedPoolQuota(Process, sizeof(HANDLE_TABLE));
+        Status = PsChargeProcessPagedPoolQuota(Process, Size);
         if (!NT_SUCCESS(Status))
         {
-            ExFreePoolWithTag(HandleTable, TAG_OBJECT_TABLE);
+            ExFreePoolWithTag(Table, TAG_OBJECT_TABLE);
             return NULL;
         }
     }
 
     /* Clear the table */
-    RtlZeroMemory(HandleTable, sizeof(HANDLE_TABLE));
+    RtlZeroMemory(Table, Size);
+    Table->CacheCount = CacheCount;
+    HandleTable = &Table->HandleTable;
 
     /* Now allocate the first level structures */
     HandleTableTable = ExpAllocateTablePagedPoolNoZero(Process, PAGE_SIZE);
@@ -368,7 +458,7 @@ ExpAllocateHandleTable(IN PEPROCESS Process OPTIONAL,
         /* Return the quota it was taking up */
         if (Process)
         {
-            PsReturnProcessPagedPoolQuota(Process, sizeof(HANDLE_TABLE));
+            PsReturnProcessPagedPoolQuota(Process, Size);
         }
 
         return NULL;
@@ -678,16 +768,20 @@ ExpMoveFreeHandles(IN PHANDLE_TABLE HandleTable)
     return LastFree;
 }
 
-PHANDLE_TABLE_ENTRY
+ULONG
 NTAPI
-ExpAllocateHandleTableEntry(IN PHANDLE_TABLE HandleTable,
-                            OUT PEXHANDLE NewHandle)
+ExpPopFreeHandles(IN PHANDLE_TABLE HandleTable,
+                  OUT PULONG Handles,
+                  IN ULONG Count)
 {
     ULONG OldValue, NewValue, NewValue1;
     PHANDLE_TABLE_ENTRY Entry;
     EXHANDLE Handle, OldHandle;
     BOOLEAN Result;
-    ULONG i;
+    ULONG i, Popped;
+
+    /* Start with a clean handle */
+    Handle.GenericHandleOverlay = NULL;
 
     /* Start allocation loop */
     for (;;)
@@ -735,8 +829,7 @@ ExpAllocateHandleTableEntry(IN PHANDLE_TABLE HandleTable,
                 if (!OldValue)
                 {
                     /* We're still the only thread around, so fail */
-                    NewHandle->GenericHandleOverlay = NULL;
-                    return NULL;
+                    return 0;
                 }
             }
         }
@@ -762,8 +855,19 @@ ExpAllocateHandleTableEntry(IN PHANDLE_TABLE HandleTable,
             continue;
         }
 
-        /* Now get the next value and do the compare */
+        /* Now get the next value, walking as far as we were asked to.
+         * The entries after the first one can't go away while the first
+         * one is still at the head of the list, so the compare covers them.
+         */
+        Handles[0] = OldValue & FREE_HANDLE_MASK;
         NewValue = *(volatile ULONG*)&Entry->NextFreeTableEntry;
+        for (Popped = 1; Popped < Count && NewValue; Popped++)
+        {
+            Handles[Popped] = NewValue;
+            Handle.Value = NewValue;
+            Entry = ExpLookupHandleTableEntry(HandleTable, Handle);
+            NewValue = *(volatile ULONG*)&Entry->NextFreeTableEntry;
+        }
         NewValue1 = InterlockedCompareExchange((PLONG) &HandleTable->FirstFree,
                                                NewValue,
                                                OldValue);
@@ -788,6 +892,55 @@ ExpAllocateHandleTableEntry(IN PHANDLE_TABLE HandleTable,
         }
     }
 
+    /* Return how many handles we took */
+    return Popped;
+}
+
+PHANDLE_TABLE_ENTRY
+NTAPI
+ExpAllocateHandleTableEntry(IN PHANDLE_TABLE HandleTable,
+                            OUT PEXHANDLE NewHandle)
+{
+    PEX_HANDLE_CACHE Cache;
+    PHANDLE_TABLE_ENTRY Entry;
+    EXHANDLE Handle;
+    ULONG Value = 0;
+
+    /* Use the free handles of this processor, refill them in one go if needed */
+    KeEnterCriticalRegion();
+    Cache = ExpAcquireHandleCache(HandleTable);
+    if (Cache)
+    {
+        if (!Cache->Count)
+        {
+            Cache->Count = ExpPopFreeHandles(HandleTable,
+                                             Cache->Handles,
+                                             EX_HANDLE_CACHE_BATCH);
+        }
+
+        /* Last in, first out, it was the latest one in use */
+        if (Cache->Count) Value = Cache->Handles[--Cache->Count];
+        ExpReleaseHandleCache(Cache);
+    }
+    else
+    {
+        /* Go to the table directly */
+        if (!ExpPopFreeHandles(HandleTable, &Value, 1)) Value = 0;
+    }
+    KeLeaveCriticalRegion();
+
+    /* Fail if the table is full */
+    if (!Value)
+    {
+        NewHandle->GenericHandleOverlay = NULL;
+        return NULL;
+    }
+
+    /* Lookup the entry for this handle */
+    Handle.GenericHandleOverlay = NULL;
+    Handle.Value = Value;
+    Entry = ExpLookupHandleTableEntry(HandleTable, Handle);
+
     /* Increase the number of handles */
     InterlockedIncrement(&HandleTable->HandleCount);
 
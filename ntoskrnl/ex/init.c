@@ -1566,6 +1566,12 @@ Phase1InitializationDiscard(IN PVOID Context)
     /* Initialize all processors */
     if (!HalAllProcessorsStarted()) KeBugCheck(HAL1_INITIALIZATION_FAILED);
 
+#ifdef CONFIG_SMP
+    /* Now that every processor is known, give each of them its own pool lists */
+    ExInitializeProcessorPools();
+    ExpInitProcessorLookasideLists();
+#endif
+
 #ifdef CONFIG_SMP
     /* HACK: We should use RtlFindMessage and not only fallback to this */
     MpString = "MultiProcessor Kernel\r\n";
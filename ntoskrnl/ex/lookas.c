@@ -23,6 +23,10 @@ LIST_ENTRY ExPoolLookasideListHead;
 GENERAL_LOOKASIDE ExpSmallNPagedPoolLookasideLists[NUMBER_POOL_LOOKASIDE_LISTS];
 GENERAL_LOOKASIDE ExpSmallPagedPoolLookasideLists[NUMBER_POOL_LOOKASIDE_LISTS];
 
+/* Depth tuning, done once per second by the balance set manager */
+#define EXP_MINIMUM_DEPTH               4
+#define EXP_MINIMUM_ALLOCATION_RATE     25
+
 /* PRIVATE FUNCTIONS *********************************************************/
 
 CODE_SEG("INIT")
@@ -65,9 +69,9 @@ ExInitPoolLookasidePointers(VOID)
     /* Loop for all pool lists */
     for (i = 0; i < NUMBER_POOL_LOOKASIDE_LISTS; i++)
     {
-        /* Initialize the non-paged list */
+        /* Initialize the non-paged list, unless another CPU already uses it */
         Entry = &ExpSmallNPagedPoolLookasideLists[i];
-        InitializeSListHead(&Entry->ListHead);
+        if (Prcb->Number == 0) InitializeSListHead(&Entry->ListHead);
 
         /* Bind to PRCB */
         Prcb->PPNPagedLookasideList[i].P = Entry;
@@ -75,7 +79,7 @@ ExInitPoolLookasidePointers(VOID)
 
         /* Initialize the paged list */
         Entry = &ExpSmallPagedPoolLookasideLists[i];
-        InitializeSListHead(&Entry->ListHead);
+        if (Prcb->Number == 0) InitializeSListHead(&Entry->ListHead);
 
         /* Bind to PRCB */
         Prcb->PPPagedLookasideList[i].P = Entry;
@@ -83,6 +87,55 @@ ExInitPoolLookasidePointers(VOID)
     }
 }
 
+CODE_SEG("INIT")
+VOID
+NTAPI
+ExpInitProcessorLookasideLists(VOID)
+{
+    ULONG i, Number;
+    PKPRCB Prcb;
+    PGENERAL_LOOKASIDE Entry;
+
+    /* Loop for all processors */
+    for (Number = 0; Number < (ULONG)KeNumberProcessors; Number++)
+    {
+        /* Allocate the non-paged and paged lists for this processor */
+        Prcb = KiProcessorBlock[Number];
+        Entry = ExAllocatePoolWithTag(NonPagedPool,
+                                      2 * NUMBER_POOL_LOOKASIDE_LISTS *
+                                      sizeof(GENERAL_LOOKASIDE),
+                                      'looP');
+        if (!Entry)
+        {
+            /* Keep using the global lists only */
+            DPRINT1("No per-processor lookaside lists for CPU %lu\n", Number);
+            continue;
+        }
+
+        /* Loop for all pool lists */
+        for (i = 0; i < NUMBER_POOL_LOOKASIDE_LISTS; i++)
+        {
+            /* Initialize the non-paged list and make it the first choice */
+            ExInitializeSystemLookasideList(Entry,
+                                            NonPagedPool,
+                                            (i + 1) * 8,
+                                            'looP',
+                                            256,
+                                            &ExPoolLookasideListHead);
+            Prcb->PPNPagedLookasideList[i].P = Entry++;
+
+            /* Same for the paged list */
+            ExInitializeSystemLookasideList(Entry,
+                                            PagedPool,
+                                            (i + 1) * 8,
+                                            'looP',
+                                            256,
+                                            &ExPoolLookasideListHead);
+            Prcb->PPPagedLookasideList[i].P = Entry++;
+        }
+    }
+}
+
 CODE_SEG("INIT")
 VOID
 NTAPI
@@ -119,6 +172,100 @@ ExpInitLookasideLists(VOID)
     }
 }
 
+static
+VOID
+ExpComputeLookasideDepth(IN PGENERAL_LOOKASIDE Lookaside,
+                         IN BOOLEAN UsesMisses)
+{
+    ULONG Allocates, Misses, MissRatio, Depth, Target;
+
+    /* Get the activity since the last scan */
+    Allocates = Lookaside->TotalAllocates - Lookaside->LastTotalAllocates;
+    if (UsesMisses)
+    {
+        /* This list counts misses */
+        Misses = Lookaside->AllocateMisses - Lookaside->LastAllocateMisses;
+        Lookaside->LastAllocateMisses = Lookaside->AllocateMisses;
+    }
+    else
+    {
+        /* This list counts hits, the rest are misses */
+        Misses = Allocates -
+                 (Lookaside->AllocateHits - Lookaside->LastAllocateHits);
+        Lookaside->LastAllocateHits = Lookaside->AllocateHits;
+    }
+    Lookaside->LastTotalAllocates = Lookaside->TotalAllocates;
+
+    /* Don't trust the counters if they went backwards (they are not locked) */
+    if (Misses > Allocates) Misses = Allocates;
+
+    Depth = Lookaside->Depth;
+    if (Allocates < EXP_MINIMUM_ALLOCATION_RATE)
+    {
+        /* The list is barely used, give its memory back to the pool */
+        Depth = (Depth > EXP_MINIMUM_DEPTH + 10) ? Depth - 10 : EXP_MINIMUM_DEPTH;
+    }
+    else
+    {
+        /* Get the miss ratio, in tenths of a percent */
+        MissRatio = (ULONG)(((ULONGLONG)Misses * 1000) / Allocates);
+        if (MissRatio < 5)
+        {
+            /* Almost everything hits, the list is deep enough */
+            if (Depth > EXP_MINIMUM_DEPTH) Depth--;
+        }
+        else
+        {
+            /* Grow towards the maximum, faster the more we miss */
+            Target = ((Lookaside->MaximumDepth - Depth) * MissRatio) / 2000 + 5;
+            Depth = min(Depth + Target, Lookaside->MaximumDepth);
+        }
+    }
+
+    /* Never go below the minimum nor above the maximum */
+    Depth = max(Depth, EXP_MINIMUM_DEPTH);
+    Lookaside->Depth = (USHORT)min(Depth, Lookaside->MaximumDepth);
+}
+
+static
+VOID
+ExpScanLookasideList(IN PLIST_ENTRY ListHead,
+                     IN BOOLEAN UsesMisses)
+{
+    PLIST_ENTRY ListEntry;
+    PGENERAL_LOOKASIDE Lookaside;
+
+    /* Loop for all lists on this head */
+    for (ListEntry = ListHead->Flink;
+         ListEntry != ListHead;
+         ListEntry = ListEntry->Flink)
+    {
+        /* Adjust its depth */
+        Lookaside = CONTAINING_RECORD(ListEntry, GENERAL_LOOKASIDE, ListEntry);
+        ExpComputeLookasideDepth(Lookaside, UsesMisses);
+    }
+}
+
+VOID
+NTAPI
+ExAdjustLookasideDepth(VOID)
+{
+    KIRQL OldIrql;
+
+    /* The pool and system lists never go away, no lock is needed */
+    ExpScanLookasideList(&ExPoolLookasideListHead, FALSE);
+    ExpScanLookasideList(&ExSystemLookasideListHead, TRUE);
+
+    /* Driver lists can be deleted, scan them under their lock */
+    KeAcquireSpinLock(&ExpNonPagedLookasideListLock, &OldIrql);
+    ExpScanLookasideList(&ExpNonPagedLookasideListHead, TRUE);
+    KeReleaseSpinLock(&ExpNonPagedLookasideListLock, OldIrql);
+
+    KeAcquireSpinLock(&ExpPagedLookasideListLock, &OldIrql);
+    ExpScanLookasideList(&ExpPagedLookasideListHead, TRUE);
+    KeReleaseSpinLock(&ExpPagedLookasideListLock, OldIrql);
+}
+
 /* PUBLIC FUNCTIONS **********************************************************/
 
 /*
@@ -730,7 +730,15 @@ QSI_DEF(SystemPerformanceInformation)
     Spi->CopyOnWriteCount = 0; /* FIXME */
     Spi->TransitionCount = 0; /* FIXME */
     Spi->CacheTransitionCount = 0; /* FIXME */
-    Spi->DemandZeroCount = 0; /* FIXME */
+    Spi->DemandZeroCount = 0;
+    for (i = 0; i < KeNumberProcessors; i ++)
+    {
+        Prcb = KiProcessorBlock[i];
+        if (Prcb)
+        {
+            Spi->DemandZeroCount += Prcb->MmDemandZeroCount;
+        }
+    }
     Spi->PageReadCount = 0; /* FIXME */
     Spi->PageReadIoCount = 0; /* FIXME */
     Spi->CacheReadCount = 0; /* FIXME */
@@ -796,7 +804,7 @@ QSI_DEF(SystemPerformanceInformation)
     Spi->CcMdlReadWait = 0; /* FIXME */
     Spi->CcMdlReadNoWaitMiss = 0; /* FIXME */
     Spi->CcMdlReadWaitMiss = 0; /* FIXME */
-    Spi->CcReadAheadIos = 0; /* FIXME */
+    Spi->CcReadAheadIos = CcReadAheadIos;
     Spi->CcLazyWriteIos = CcLazyWriteIos;
     Spi->CcLazyWritePages = CcLazyWritePages;
     Spi->CcDataFlushes = CcDataFlushes;
@@ -2817,6 +2825,32 @@ QSI_DEF(SystemFirmwareTableInformation)
     return Status;
 }
 
+/* Class 80 - Page list information */
+QSI_DEF(SystemMemoryListInformation)
+{
+    SYSTEM_MEMORY_LIST_INFORMATION_EX Information;
+
+    *ReqSize = sizeof(SYSTEM_MEMORY_LIST_INFORMATION);
+
+    /* Check user buffer's size */
+    if (Size < sizeof(SYSTEM_MEMORY_LIST_INFORMATION))
+    {
+        return STATUS_INFO_LENGTH_MISMATCH;
+    }
+
+    /* Snapshot the lists first, the user buffer cannot be touched under the PFN lock */
+    MmQueryMemoryListInformation(&Information);
+
+    /* Add the zeroed page counters if the caller asked for them */
+    if (Size >= sizeof(SYSTEM_MEMORY_LIST_INFORMATION_EX))
+    {
+        *ReqSize = sizeof(SYSTEM_MEMORY_LIST_INFORMATION_EX);
+    }
+
+    RtlCopyMemory(Buffer, &Information, *ReqSize);
+    return STATUS_SUCCESS;
+}
+
 /* Query/Set Calls Table */
 typedef
 struct _QSSI_CALLS
@@ -2916,9 +2950,14 @@ CallQS[] =
     SI_XX(SystemWow64SharedInformation), /* FIXME: not implemented */
     SI_XX(SystemRegisterFirmwareTableInformationHandler), /* FIXME: not implemented */
     SI_QX(SystemFirmwareTableInformation),
+    SI_XX(SystemModuleInformationEx), /* FIXME: not implemented */
+    SI_XX(SystemVerifierTriageInformation), /* FIXME: not implemented */
+    SI_XX(SystemSuperfetchInformation), /* FIXME: not implemented */
+    SI_QX(SystemMemoryListInformation),
 };
 
 C_ASSERT(SystemBasicInformation == 0);
+C_ASSERT(RTL_NUMBER_OF(CallQS) == SystemMemoryListInformation + 1);
 #define MIN_SYSTEM_INFO_CLASS (SystemBasicInformation)
 #define MAX_SYSTEM_INFO_CLASS RTL_NUMBER_OF(CallQS)
 
@@ -40,7 +40,8 @@
 // Global Cc Data
 //
 extern ULONG CcRosTraceLevel;
-extern LIST_ENTRY DirtyVacbListHead;
+extern LIST_ENTRY CcCleanSharedCacheMapList;
+extern LIST_ENTRY CcDirtySharedCacheMapList;
 extern ULONG CcDirtyPageThreshold;
 extern ULONG CcTotalDirtyPages;
 extern LIST_ENTRY CcDeferredWrites;
@@ -65,6 +66,11 @@ extern ULONG CcPinReadNoWait;
 extern ULONG CcPinMappedDataCount;
 extern ULONG CcDataPages;
 extern ULONG CcDataFlushes;
+extern ULONG CcReadAheadIos;
+extern ULONG CcLazyWriteFlushRate;
+extern ULONG CcThrottleWaits;
+extern ULONG CcThrottleDelays;
+extern ULONG CcThrottleDelayTime;
 
 typedef struct _PF_SCENARIO_ID
 {
@@ -167,6 +173,66 @@ typedef struct _PFSN_PREFETCHER_GLOBALS
     LONG ActivePrefetches;
 } PFSN_PREFETCHER_GLOBALS, *PPFSN_PREFETCHER_GLOBALS;
 
+//
+// Write behind tuning
+//
+#define CC_WRITE_BEHIND_MIN_PAGES                       (VACB_MAPPING_GRANULARITY / PAGE_SIZE)
+#define CC_THROTTLE_HEAVY_SHARE                         4
+#define CC_THROTTLE_MAX_DELAY                           100
+
+//
+// Read ahead tuning
+//
+#define CC_READ_AHEAD_STREAMS                           4
+#define CC_READ_AHEAD_RANGES                            8
+#define CC_READ_AHEAD_MIN_WINDOW                        (64 * 1024)
+#define CC_READ_AHEAD_MAX_WINDOW                        (4 * VACB_MAPPING_GRANULARITY)
+#define CC_READ_AHEAD_MAX_STRIDE                        (4 * VACB_MAPPING_GRANULARITY)
+#define CC_READ_AHEAD_CLUSTER_GAP                       (64 * 1024)
+
+typedef enum _CC_READ_AHEAD_PATTERN
+{
+    ReadAheadPatternNone,
+    ReadAheadPatternSequential,
+    ReadAheadPatternStrided,
+    ReadAheadPatternBackward,
+} CC_READ_AHEAD_PATTERN;
+
+typedef struct _CC_READ_AHEAD_STREAM
+{
+    /* Last read of the stream */
+    LONGLONG FileOffset;
+    LONGLONG BeyondLastByte;
+    /* Distance between the starts of the last two reads */
+    LONGLONG Stride;
+    /* What read ahead already brought in for this stream */
+    LONGLONG ReadAheadStart;
+    LONGLONG ReadAheadEnd;
+    ULONG Window;
+    /* Age, the oldest stream is recycled. 0 if unused */
+    ULONG LastUse;
+    UCHAR Pattern;
+    UCHAR Confidence;
+} CC_READ_AHEAD_STREAM, *PCC_READ_AHEAD_STREAM;
+
+typedef struct _CC_READ_AHEAD_RANGE
+{
+    LONGLONG FileOffset;
+    ULONG Length;
+} CC_READ_AHEAD_RANGE, *PCC_READ_AHEAD_RANGE;
+
+typedef struct _ROS_PRIVATE_CACHE_MAP
+{
+    PRIVATE_CACHE_MAP PrivateCacheMap;
+
+    /* ROS specific, protected by the read ahead spin lock */
+    CC_READ_AHEAD_STREAM Streams[CC_READ_AHEAD_STREAMS];
+    ULONG StreamClock;
+    /* Ranges waiting for the read ahead worker */
+    ULONG RangeCount;
+    CC_READ_AHEAD_RANGE Ranges[CC_READ_AHEAD_RANGES];
+} ROS_PRIVATE_CACHE_MAP, *PROS_PRIVATE_CACHE_MAP;
+
 typedef struct _ROS_SHARED_CACHE_MAP
 {
     CSHORT NodeTypeCode;
@@ -187,13 +253,20 @@ typedef struct _ROS_SHARED_CACHE_MAP
     LIST_ENTRY PrivateList;
     ULONG DirtyPageThreshold;
     KSPIN_LOCK BcbSpinLock;
-    PRIVATE_CACHE_MAP PrivateCacheMap;
+    ROS_PRIVATE_CACHE_MAP PrivateCacheMap;
 
     /* ROS specific */
     LIST_ENTRY CacheMapVacbListHead;
+    /* Dirty VACBs of this map, oldest first. The map is on CcDirtySharedCacheMapList while this is not empty */
+    LIST_ENTRY DirtyVacbListHead;
     BOOLEAN PinAccess;
     KSPIN_LOCK CacheMapLock;
     KGUARDED_MUTEX FlushCacheLock;
+    /* Read ahead statistics */
+    ULONG ReadAheadIos;
+    ULONG ReadAheadPages;
+    ULONG ReadAheadHits;
+    ULONG ReadAheadMisses;
 #if DBG
     BOOLEAN Trace; /* enable extra trace output for this cache map and it's VACBs */
 #endif
@@ -212,12 +285,16 @@ typedef struct _ROS_VACB
     BOOLEAN Dirty;
     /* Page out in progress */
     BOOLEAN PageOut;
+    /* Used since the clock hand last passed it, gives the view a second chance */
+    BOOLEAN Referenced;
+    /* Which of the LRU lists holds this VACB */
+    UCHAR LruList;
     ULONG MappedCount;
     /* Entry in the list of VACBs for this shared cache map. */
     LIST_ENTRY CacheMapVacbListEntry;
-    /* Entry in the list of VACBs which are dirty. */
+    /* Entry in the list of dirty VACBs of the shared cache map. */
     LIST_ENTRY DirtyVacbListEntry;
-    /* Entry in the list of VACBs. */
+    /* Entry in one of the LRU lists of VACBs. */
     LIST_ENTRY VacbLruListEntry;
     /* Offset in the file which this view maps. */
     LARGE_INTEGER FileOffset;
@@ -267,6 +344,10 @@ typedef struct _WORK_QUEUE_ENTRY
             KEVENT *Event;
         } Event;
         struct
+        {
+            unsigned long Pages;
+        } Flush;
+        struct
         {
             unsigned long Reason;
         } Notification;
@@ -514,3 +595,7 @@ CcRosVacbDecRefCount(
 BOOLEAN
 CcRosFreeOneUnusedVacb(
     VOID);
+
+VOID
+CcRosRemoveVacbFromLru(
+    _In_ PROS_VACB Vacb);
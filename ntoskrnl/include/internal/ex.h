@@ -163,6 +163,30 @@ typedef struct _HARDERROR_USER_PARAMETERS
 #define MAX_MID_INDEX       (MID_LEVEL_ENTRIES * LOW_LEVEL_ENTRIES)
 #define MAX_HIGH_INDEX      (MID_LEVEL_ENTRIES * MID_LEVEL_ENTRIES * LOW_LEVEL_ENTRIES)
 
+//
+// Free handles kept by each processor, and how many move at once
+// between such a cache and the handle table
+//
+#define EX_HANDLE_CACHE_SIZE    14
+#define EX_HANDLE_CACHE_BATCH   (EX_HANDLE_CACHE_SIZE / 2)
+
+typedef struct _EX_HANDLE_CACHE
+{
+    volatile LONG Busy;
+    ULONG Count;
+    ULONG Handles[EX_HANDLE_CACHE_SIZE];
+} EX_HANDLE_CACHE, *PEX_HANDLE_CACHE;
+
+//
+// Handle table with its per-processor free handle caches
+//
+typedef struct _EX_HANDLE_TABLE
+{
+    HANDLE_TABLE HandleTable;
+    ULONG CacheCount;
+    EX_HANDLE_CACHE Caches[ANYSIZE_ARRAY];
+} EX_HANDLE_TABLE, *PEX_HANDLE_TABLE;
+
 #define ExpChangeRundown(x, y, z)   (ULONG_PTR)InterlockedCompareExchangePointer(&(x)->Ptr, (PVOID)(y), (PVOID)(z))
 #define ExpChangePushlock(x, y, z)  InterlockedCompareExchangePointer((PVOID*)(x), (PVOID)(y), (PVOID)(z))
 #define ExpSetRundown(x, y)         InterlockedExchangePointer(&(x)->Ptr, (PVOID)(y))
@@ -319,6 +343,20 @@ VOID
 NTAPI
 ExInitPoolLookasidePointers(VOID);
 
+CODE_SEG("INIT")
+VOID
+NTAPI
+ExpInitProcessorLookasideLists(VOID);
+
+CODE_SEG("INIT")
+VOID
+NTAPI
+ExInitializeProcessorPools(VOID);
+
+VOID
+NTAPI
+ExAdjustLookasideDepth(VOID);
+
 /* Callback Functions ********************************************************/
 
 VOID
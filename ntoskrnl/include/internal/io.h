@@ -90,6 +90,11 @@
 //
 #define IOP_MAX_REPARSE_TRAVERSAL 0x20
 
+//
+// Max completion packets removed by a single NtRemoveIoCompletionEx call
+//
+#define IOP_MAXIMUM_COMPLETION_BATCH 64
+
 //
 // Private flags for IoCreateFile / IoParseDevice
 //
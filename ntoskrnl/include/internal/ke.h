@@ -68,6 +68,15 @@ typedef struct _KI_SAMPLE_MAP
 
 #define MAX_TIMER_DPCS                      16
 
+/*
+ * Timers due after the next revolution of the timer table wait in a wheel
+ * with a slot per revolution, and those due after the next group of slots
+ * in a second one with a slot per group.
+ */
+#define TIMER_WHEEL_LEVELS                  2
+#define TIMER_WHEEL_SLOTS                   64
+#define TIMER_WHEEL_SHIFT                   6
+
 typedef struct _DPC_QUEUE_ENTRY
 {
     PKDPC Dpc;
@@ -129,6 +138,9 @@ extern LIST_ENTRY KeBugcheckCallbackListHead, KeBugcheckReasonCallbackListHead;
 extern KSPIN_LOCK BugCheckCallbackLock;
 extern KDPC KiTimerExpireDpc;
 extern KTIMER_TABLE_ENTRY KiTimerTableListHead[TIMER_TABLE_SIZE];
+extern LIST_ENTRY KiTimerWheel[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS][LOCK_QUEUE_TIMER_TABLE_LOCKS];
+extern ULONG KiTimerWheelRevolution;
+extern ULARGE_INTEGER KiTimerWheelCascadeTime;
 extern FAST_MUTEX KiGenericCallDpcMutex;
 extern LIST_ENTRY KiProfileListHead, KiProfileSourceListHead;
 extern KSPIN_LOCK KiProfileLock;
@@ -281,6 +293,25 @@ KiInsertTimerTable(
     IN ULONG Hand
 );
 
+CODE_SEG("INIT")
+VOID
+NTAPI
+KiInitializeTimerWheel(
+    VOID
+);
+
+VOID
+FASTCALL
+KiCascadeTimerWheel(
+    IN ULONGLONG InterruptTime
+);
+
+ULONG
+FASTCALL
+KiComputeIdleTicks(
+    IN ULONG MaximumTicks
+);
+
 VOID
 FASTCALL
 KiTimerListExpire(
@@ -721,6 +752,29 @@ VOID
 FASTCALL
 KiActivateWaiterQueue(IN PKQUEUE Queue);
 
+#if (NTDDI_VERSION < NTDDI_VISTA)
+/* Vista export, our headers only declare it for NT6 */
+ULONG
+NTAPI
+KeRemoveQueueEx(IN PKQUEUE Queue,
+                IN KPROCESSOR_MODE WaitMode,
+                IN BOOLEAN Alertable,
+                IN PLARGE_INTEGER Timeout OPTIONAL,
+                OUT PLIST_ENTRY *EntryArray,
+                IN ULONG Count);
+#endif
+
+#if (NTDDI_VERSION < NTDDI_WIN7)
+/* Windows 7 export, our headers only declare it for NT6.1 */
+BOOLEAN
+NTAPI
+KeSetCoalescableTimer(IN OUT PKTIMER Timer,
+                      IN LARGE_INTEGER DueTime,
+                      IN ULONG Period,
+                      IN ULONG TolerableDelay,
+                      IN PKDPC Dpc OPTIONAL);
+#endif
+
 ULONG
 NTAPI
 KeQueryRuntimeProcess(IN PKPROCESS Process,
@@ -825,6 +879,13 @@ FASTCALL
 KeZeroPages(IN PVOID Address,
             IN ULONG Size);
 
+#if defined(_M_IX86) || defined(_M_AMD64)
+VOID
+FASTCALL
+KeZeroPagesNonTemporal(IN PVOID Address,
+                       IN ULONG Size);
+#endif
+
 BOOLEAN
 FASTCALL
 KeInvalidAccessAllowed(IN PVOID TrapInformation OPTIONAL);
@@ -954,6 +954,7 @@ KiComputeDueTime(IN PKTIMER Timer,
                  OUT PULONG Hand)
 {
     LARGE_INTEGER InterruptTime, SystemTime, DifferenceTime;
+    ULONGLONG Window;
 
     /* Convert to relative time if needed */
     Timer->Header.Absolute = FALSE;
@@ -987,6 +988,14 @@ KiComputeDueTime(IN PKTIMER Timer,
     /* Recalculate due time */
     Timer->DueTime.QuadPart = InterruptTime.QuadPart - DueTime.QuadPart;
 
+    /* Let coalescable timers expire at the end of their window of ticks */
+    if (Timer->Header.Coalescable)
+    {
+        Window = (ULONGLONG)KeMaximumIncrement << Timer->Header.EncodedTolerableDelay;
+        Timer->DueTime.QuadPart += Window - 1;
+        Timer->DueTime.QuadPart -= Timer->DueTime.QuadPart % Window;
+    }
+
     /* Get the handle */
     *Hand = KiComputeTimerTableIndex(Timer->DueTime.QuadPart);
     Timer->Header.Hand = (UCHAR)*Hand;
@@ -1099,6 +1099,12 @@ MmZeroPageThread(
     VOID
 );
 
+VOID
+NTAPI
+MmQueryMemoryListInformation(
+    OUT PSYSTEM_MEMORY_LIST_INFORMATION_EX Information
+);
+
 /* hypermap.c *****************************************************************/
 PVOID
 NTAPI
@@ -1114,8 +1120,10 @@ MiUnmapPageInHyperSpace(IN PEPROCESS Process,
 
 PVOID
 NTAPI
-MiMapPagesInZeroSpace(IN PMMPFN Pfn1,
-                      IN PFN_NUMBER NumberOfPages);
+MiMapPagesInZeroSpace(IN PMMPTE ZeroingPte,
+                      IN PMMPFN Pfn1,
+                      IN PFN_NUMBER NumberOfPages,
+                      IN BOOLEAN Cached);
 
 VOID
 NTAPI
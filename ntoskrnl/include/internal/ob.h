@@ -154,6 +154,44 @@ typedef union
     ULARGE_INTEGER Alignment;
 } ALIGNEDNAME;
 
+//
+// Names recently looked up in vain in a directory
+//
+#define OBP_NEGATIVE_ENTRIES                            4
+#define OBP_NEGATIVE_NAME_LENGTH                        32
+typedef struct _OBP_NEGATIVE_ENTRY
+{
+    ULONG HashValue;
+    USHORT Length;
+    BOOLEAN CaseInsensitive;
+    WCHAR Name[OBP_NEGATIVE_NAME_LENGTH];
+} OBP_NEGATIVE_ENTRY, *POBP_NEGATIVE_ENTRY;
+
+//
+// Directory Object with its negative lookup cache
+//
+typedef struct _OBP_DIRECTORY
+{
+    OBJECT_DIRECTORY Directory;
+    ULONG NegativeNext;
+    OBP_NEGATIVE_ENTRY NegativeEntries[OBP_NEGATIVE_ENTRIES];
+} OBP_DIRECTORY, *POBP_DIRECTORY;
+
+//
+// Directories resolved from the root by a previous lookup
+//
+#define OBP_PREFIX_ENTRIES                              8
+#define OBP_PREFIX_NAME_LENGTH                          64
+typedef struct _OBP_PREFIX_ENTRY
+{
+    POBJECT_DIRECTORY Directory;
+    LONG Generation;
+    ULONG LastUse;
+    USHORT Length;
+    BOOLEAN CaseInsensitive;
+    WCHAR Name[OBP_PREFIX_NAME_LENGTH];
+} OBP_PREFIX_ENTRY, *POBP_PREFIX_ENTRY;
+
 //
 // Private Temporary Buffer for Lookup Routines
 //
@@ -209,6 +247,26 @@ ObpLookupEntryDirectory(
     IN POBP_LOOKUP_CONTEXT Context
 );
 
+//
+// Namespace Lookup Cache Functions
+//
+POBJECT_DIRECTORY
+NTAPI
+ObpLookupPrefixCache(
+    IN PUNICODE_STRING ObjectName,
+    IN ULONG Attributes,
+    OUT PUNICODE_STRING RemainingName
+);
+
+VOID
+NTAPI
+ObpInsertPrefixCache(
+    IN PUNICODE_STRING Prefix,
+    IN ULONG Attributes,
+    IN POBJECT_DIRECTORY Directory,
+    IN LONG Generation
+);
+
 //
 // Symbolic Link Functions
 //
@@ -652,6 +710,9 @@ extern ULONG ObpObjectSecurityMode;
 extern ULONG ObpProtectionMode;
 extern ULONG ObpLUIDDeviceMapsDisabled;
 extern ULONG ObpLUIDDeviceMapsEnabled;
+extern volatile LONG ObpNamespaceGeneration;
+extern ULONG ObpNegativeCacheHits, ObpNegativeCacheMisses;
+extern ULONG ObpPrefixCacheHits, ObpPrefixCacheMisses;
 
 //
 // Inlined Functions
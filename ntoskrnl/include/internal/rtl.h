@@ -39,4 +39,12 @@ ULONG
 NTAPI
 RtlRosGetAppcompatVersion(VOID);
 
+ULONG
+NTAPI
+RtlFindClearBitsAndSetNextFit(
+    _In_ PRTL_BITMAP BitMapHeader,
+    _In_ ULONG NumberToFind,
+    _Inout_ PULONG NextFitIndex
+);
+
 /* EOF */
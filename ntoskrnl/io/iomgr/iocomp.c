@@ -137,6 +137,48 @@ IopDeleteIoCompletion(PVOID ObjectBody)
     }
 }
 
+static
+VOID
+IopGetCompletionPacketInformation(IN PLIST_ENTRY ListEntry,
+                                  OUT PFILE_IO_COMPLETION_INFORMATION Information)
+{
+    PIOP_MINI_COMPLETION_PACKET Packet;
+    PIRP Irp;
+
+    /* Get the Packet Data */
+    Packet = CONTAINING_RECORD(ListEntry,
+                               IOP_MINI_COMPLETION_PACKET,
+                               ListEntry);
+
+    /* Check if this is piggybacked on an IRP */
+    if (Packet->PacketType == IopCompletionPacketIrp)
+    {
+        /* Get the IRP */
+        Irp = CONTAINING_RECORD(ListEntry,
+                                IRP,
+                                Tail.Overlay.ListEntry);
+
+        /* Save values */
+        Information->KeyContext = Irp->Tail.CompletionKey;
+        Information->ApcContext = Irp->Overlay.AsynchronousParameters.UserApcContext;
+        Information->IoStatusBlock = Irp->IoStatus;
+
+        /* Free the IRP */
+        IoFreeIrp(Irp);
+    }
+    else
+    {
+        /* Save values */
+        Information->KeyContext = Packet->KeyContext;
+        Information->ApcContext = Packet->ApcContext;
+        Information->IoStatusBlock.Status = Packet->IoStatus;
+        Information->IoStatusBlock.Information = Packet->IoStatusInformation;
+
+        /* Free the packet */
+        IopFreeMiniPacket(Packet);
+    }
+}
+
 /* PUBLIC FUNCTIONS **********************************************************/
 
 /*
@@ -450,13 +492,10 @@ NtRemoveIoCompletion(IN HANDLE IoCompletionHandle,
 {
     LARGE_INTEGER SafeTimeout;
     PKQUEUE Queue;
-    PIOP_MINI_COMPLETION_PACKET Packet;
     PLIST_ENTRY ListEntry;
     KPROCESSOR_MODE PreviousMode = ExGetPreviousMode();
     NTSTATUS Status;
-    PIRP Irp;
-    PVOID Apc, Key;
-    IO_STATUS_BLOCK IoStatus;
+    FILE_IO_COMPLETION_INFORMATION Information;
     PAGED_CODE();
 
     /* Check if the call was from user mode */
@@ -507,46 +546,16 @@ NtRemoveIoCompletion(IN HANDLE IoCompletionHandle,
         }
         else
         {
-            /* Get the Packet Data */
-            Packet = CONTAINING_RECORD(ListEntry,
-                                       IOP_MINI_COMPLETION_PACKET,
-                                       ListEntry);
-
-            /* Check if this is piggybacked on an IRP */
-            if (Packet->PacketType == IopCompletionPacketIrp)
-            {
-                /* Get the IRP */
-                Irp = CONTAINING_RECORD(ListEntry,
-                                        IRP,
-                                        Tail.Overlay.ListEntry);
-
-                /* Save values */
-                Key = Irp->Tail.CompletionKey;
-                Apc = Irp->Overlay.AsynchronousParameters.UserApcContext;
-                IoStatus = Irp->IoStatus;
-
-                /* Free the IRP */
-                IoFreeIrp(Irp);
-            }
-            else
-            {
-                /* Save values */
-                Key = Packet->KeyContext;
-                Apc = Packet->ApcContext;
-                IoStatus.Status = Packet->IoStatus;
-                IoStatus.Information = Packet->IoStatusInformation;
-
-                /* Free the packet */
-                IopFreeMiniPacket(Packet);
-            }
+            /* Get the packet data and free it */
+            IopGetCompletionPacketInformation(ListEntry, &Information);
 
             /* Enter SEH to write back the values */
             _SEH2_TRY
             {
                 /* Write the values to caller */
-                *ApcContext = Apc;
-                *KeyContext = Key;
-                *IoStatusBlock = IoStatus;
+                *ApcContext = Information.ApcContext;
+                *KeyContext = Information.KeyContext;
+                *IoStatusBlock = Information.IoStatusBlock;
             }
             _SEH2_EXCEPT(ExSystemExceptionFilter())
             {
@@ -564,6 +573,125 @@ NtRemoveIoCompletion(IN HANDLE IoCompletionHandle,
     return Status;
 }
 
+NTSTATUS
+NTAPI
+NtRemoveIoCompletionEx(IN HANDLE IoCompletionHandle,
+                       OUT PFILE_IO_COMPLETION_INFORMATION IoCompletionInformation,
+                       IN ULONG Count,
+                       OUT PULONG NumEntriesRemoved,
+                       IN PLARGE_INTEGER Timeout OPTIONAL,
+                       IN BOOLEAN Alertable)
+{
+    LARGE_INTEGER SafeTimeout;
+    PKQUEUE Queue;
+    PLIST_ENTRY Entries[IOP_MAXIMUM_COMPLETION_BATCH];
+    KPROCESSOR_MODE PreviousMode = ExGetPreviousMode();
+    NTSTATUS Status;
+    FILE_IO_COMPLETION_INFORMATION Information;
+    ULONG Removed, i;
+    PAGED_CODE();
+
+    /* We need room for at least one packet */
+    if (!Count) return STATUS_INVALID_PARAMETER;
+
+    /* Check if the call was from user mode */
+    if (PreviousMode != KernelMode)
+    {
+        /* Protect probes in SEH */
+        _SEH2_TRY
+        {
+            /* Probe the output array, making sure its size doesn't overflow */
+            if (Count > MAXULONG / sizeof(FILE_IO_COMPLETION_INFORMATION))
+            {
+                ExRaiseStatus(STATUS_INVALID_PARAMETER);
+            }
+            ProbeForWrite(IoCompletionInformation,
+                          Count * sizeof(FILE_IO_COMPLETION_INFORMATION),
+                          sizeof(PVOID));
+
+            /* Probe the count */
+            ProbeForWriteUlong(NumEntriesRemoved);
+            if (Timeout)
+            {
+                /* Probe and capture the timeout */
+                SafeTimeout = ProbeForReadLargeInteger(Timeout);
+                Timeout = &SafeTimeout;
+            }
+        }
+        _SEH2_EXCEPT(EXCEPTION_EXECUTE_HANDLER)
+        {
+            /* Return the exception code */
+            _SEH2_YIELD(return _SEH2_GetExceptionCode());
+        }
+        _SEH2_END;
+    }
+
+    /* Don't take more than we can hold, the caller will come back for the rest */
+    Count = min(Count, IOP_MAXIMUM_COMPLETION_BATCH);
+
+    /* Open the Object */
+    Status = ObReferenceObjectByHandle(IoCompletionHandle,
+                                       IO_COMPLETION_MODIFY_STATE,
+                                       IoCompletionType,
+                                       PreviousMode,
+                                       (PVOID*)&Queue,
+                                       NULL);
+    if (!NT_SUCCESS(Status)) return Status;
+
+    /* Wait for the first packet, then take all the queued ones we can hold */
+    Removed = KeRemoveQueueEx(Queue, PreviousMode, Alertable, Timeout, Entries, Count);
+
+    /* If we got a timeout, an alert or a user APC back, return the status */
+    if ((Removed == 1) &&
+        (((NTSTATUS)(ULONG_PTR)Entries[0] == STATUS_TIMEOUT) ||
+         ((NTSTATUS)(ULONG_PTR)Entries[0] == STATUS_USER_APC) ||
+         ((NTSTATUS)(ULONG_PTR)Entries[0] == STATUS_ALERTED)))
+    {
+        /* Set this as the status */
+        Status = (NTSTATUS)(ULONG_PTR)Entries[0];
+        Removed = 0;
+    }
+
+    /* Loop the packets */
+    for (i = 0; i < Removed; i++)
+    {
+        /* Get the packet data and free it */
+        IopGetCompletionPacketInformation(Entries[i], &Information);
+
+        /* Stop writing once the caller's buffer went bad, but free everything */
+        if (!NT_SUCCESS(Status)) continue;
+
+        /* Enter SEH to write back the values */
+        _SEH2_TRY
+        {
+            /* Write the values to caller */
+            IoCompletionInformation[i] = Information;
+        }
+        _SEH2_EXCEPT(ExSystemExceptionFilter())
+        {
+            /* Get the exception code */
+            Status = _SEH2_GetExceptionCode();
+        }
+        _SEH2_END;
+    }
+
+    /* Enter SEH to write back the count */
+    _SEH2_TRY
+    {
+        *NumEntriesRemoved = Removed;
+    }
+    _SEH2_EXCEPT(ExSystemExceptionFilter())
+    {
+        /* Get the exception code */
+        Status = _SEH2_GetExceptionCode();
+    }
+    _SEH2_END;
+
+    /* Dereference the Object and return */
+    ObDereferenceObject(Queue);
+    return Status;
+}
+
 NTSTATUS
 NTAPI
 NtSetIoCompletion(IN HANDLE IoCompletionPortHandle,
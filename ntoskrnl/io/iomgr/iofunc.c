@@ -428,7 +428,9 @@ IopDeviceFsIoControl(IN HANDLE DeviceHandle,
                 _SEH2_END;
 
                 /* Backup our complete context in case it exists */
-                if (FileObject->CompletionContext)
+                if ((FileObject->CompletionContext) &&
+                    !((FileObject->Flags & FO_SKIP_COMPLETION_PORT) &&
+                      NT_SUCCESS(KernelIosb.Status)))
                 {
                     CompletionInfo = *(FileObject->CompletionContext);
                 }
@@ -436,7 +438,8 @@ IopDeviceFsIoControl(IN HANDLE DeviceHandle,
                 /* If we had an event, signal it */
                 if (Event)
                 {
-                    KeSetEvent(EventObject, IO_NO_INCREMENT, FALSE);
+                    if (!(FileObject->Flags & FO_SKIP_SET_FAST_IO))
+                        KeSetEvent(EventObject, IO_NO_INCREMENT, FALSE);
                     ObDereferenceObject(EventObject);
                 }
 
@@ -1889,12 +1892,15 @@ NtLockFile(IN HANDLE FileHandle,
             /* If we had an event, signal it */
             if (EventHandle)
             {
-                KeSetEvent(Event, IO_NO_INCREMENT, FALSE);
+                if (!(FileObject->Flags & FO_SKIP_SET_FAST_IO))
+                    KeSetEvent(Event, IO_NO_INCREMENT, FALSE);
                 ObDereferenceObject(Event);
             }
 
             /* Set completion if required */
-            if (FileObject->CompletionContext != NULL && ApcContext != NULL)
+            if (FileObject->CompletionContext != NULL && ApcContext != NULL &&
+                !((FileObject->Flags & FO_SKIP_COMPLETION_PORT) &&
+                  NT_SUCCESS(KernelIosb.Status)))
             {
                 if (!NT_SUCCESS(IoSetIoCompletion(FileObject->CompletionContext->Port,
                                                   FileObject->CompletionContext->Key,
@@ -3375,6 +3381,39 @@ NtSetInformationFile(IN HANDLE FileHandle,
         Irp->IoStatus.Status = Status;
         Irp->IoStatus.Information = 0;
     }
+    else if (FileInformationClass == FileIoCompletionNotificationInformation)
+    {
+        PFILE_IO_COMPLETION_NOTIFICATION_INFORMATION NotificationInfo;
+        ULONG Flags = 0;
+
+        /* Check the modes, they can only be added, never removed */
+        NotificationInfo = Irp->AssociatedIrp.SystemBuffer;
+        if (NotificationInfo->Flags & ~(FILE_SKIP_COMPLETION_PORT_ON_SUCCESS |
+                                        FILE_SKIP_SET_EVENT_ON_HANDLE |
+                                        FILE_SKIP_SET_USER_EVENT_ON_FAST_IO))
+        {
+            /* Fail */
+            Status = STATUS_INVALID_PARAMETER;
+        }
+        else
+        {
+            /* Convert them to file object flags */
+            if (NotificationInfo->Flags & FILE_SKIP_COMPLETION_PORT_ON_SUCCESS)
+                Flags |= FO_SKIP_COMPLETION_PORT;
+            if (NotificationInfo->Flags & FILE_SKIP_SET_EVENT_ON_HANDLE)
+                Flags |= FO_SKIP_SET_EVENT;
+            if (NotificationInfo->Flags & FILE_SKIP_SET_USER_EVENT_ON_FAST_IO)
+                Flags |= FO_SKIP_SET_FAST_IO;
+
+            /* Other threads may be updating the flags too */
+            InterlockedOr((PLONG)&FileObject->Flags, Flags);
+            Status = STATUS_SUCCESS;
+        }
+
+        /* Set the IRP Status */
+        Irp->IoStatus.Status = Status;
+        Irp->IoStatus.Information = 0;
+    }
     else if (FileInformationClass == FileRenameInformation ||
              FileInformationClass == FileLinkInformation ||
              FileInformationClass == FileMoveClusterInformation)
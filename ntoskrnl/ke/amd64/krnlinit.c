@@ -264,6 +264,9 @@ KiInitializeKernel(IN PKPROCESS InitProcess,
         KiTimerTableListHead[i].Time.LowPart = 0;
     }
 
+    /* And the wheel of the timers due later */
+    KiInitializeTimerWheel();
+
     /* Initialize the Swap event and all swap lists */
     KeInitializeEvent(&KiSwapEvent, SynchronizationEvent, FALSE);
     InitializeListHead(&KiProcessInSwapListHead);
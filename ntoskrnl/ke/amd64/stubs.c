@@ -122,12 +122,27 @@ KiIdleLoop(VOID)
             KiRetireDpcList(Prcb);
         }
 
+#ifdef CONFIG_SMP
+        /* Look for work on the other processors before going to sleep */
+        if (!Prcb->NextThread)
+        {
+            _enable();
+            KiIdleSchedule(Prcb);
+            _disable();
+        }
+#endif
+
         /* Check if a new thread is scheduled for execution */
         if (Prcb->NextThread)
         {
             /* Enable interrupts */
             _enable();
 
+#ifdef CONFIG_SMP
+            /* Other processors schedule threads here too */
+            KiAcquirePrcbLock(Prcb);
+#endif
+
             /* Capture current thread data */
             OldThread = Prcb->CurrentThread;
             NewThread = Prcb->NextThread;
@@ -139,6 +154,10 @@ KiIdleLoop(VOID)
             /* The thread is now running */
             NewThread->State = Running;
 
+#ifdef CONFIG_SMP
+            KiReleasePrcbLock(Prcb);
+#endif
+
 #ifdef CONFIG_SMP
             /* Do the swap at SYNCH_LEVEL */
             KfRaiseIrql(SYNCH_LEVEL);
@@ -37,7 +37,7 @@ KeSetSystemTime(IN PLARGE_INTEGER NewTime,
     PKTIMER Timer;
     PKSPIN_LOCK_QUEUE LockQueue;
     LIST_ENTRY TempList, TempList2;
-    ULONG Hand, i;
+    ULONG Hand, Level, Slot, i;
 
     /* Sanity checks */
     ASSERT((NewTime->HighPart & 0xF0000000) == 0);
@@ -106,6 +106,34 @@ KeSetSystemTime(IN PLARGE_INTEGER NewTime,
         KiReleaseTimerLock(LockQueue);
     }
 
+    /* Do the same with the timers waiting in the wheel */
+    for (i = 0; i < LOCK_QUEUE_TIMER_TABLE_LOCKS; i++)
+    {
+        LockQueue = KiAcquireTimerLock(i << LOCK_QUEUE_TIMER_LOCK_SHIFT);
+        for (Level = 0; Level < TIMER_WHEEL_LEVELS; Level++)
+        {
+            for (Slot = 0; Slot < TIMER_WHEEL_SLOTS; Slot++)
+            {
+                ListHead = &KiTimerWheel[Level][Slot][i];
+                NextEntry = ListHead->Flink;
+                while (NextEntry != ListHead)
+                {
+                    /* Get the timer */
+                    Timer = CONTAINING_RECORD(NextEntry, KTIMER, TimerListEntry);
+                    NextEntry = NextEntry->Flink;
+
+                    /* Move the absolute ones to our temporary list */
+                    if (Timer->Header.Absolute)
+                    {
+                        KiRemoveEntryTimer(Timer);
+                        InsertTailList(&TempList, &Timer->TimerListEntry);
+                    }
+                }
+            }
+        }
+        KiReleaseTimerLock(LockQueue);
+    }
+
     /* Setup a temporary list of expired timers */
     InitializeListHead(&TempList2);
 
@@ -125,6 +125,12 @@ KiTimerExpiration(IN PKDPC Dpc,
     /* Lock the Database and Raise IRQL */
     OldIrql = KiAcquireDispatcherLock();
 
+    /* Bring the timers of the next revolution down from the wheel */
+    if (InterruptTime.QuadPart >= KiTimerWheelCascadeTime.QuadPart)
+    {
+        KiCascadeTimerWheel(InterruptTime.QuadPart);
+    }
+
     /* Start expiration loop */
     do
     {
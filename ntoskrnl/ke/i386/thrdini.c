@@ -283,12 +283,27 @@ KiIdleLoop(VOID)
             KiRetireDpcList(Prcb);
         }
 
+#ifdef CONFIG_SMP
+        /* Look for work on the other processors before going to sleep */
+        if (!Prcb->NextThread)
+        {
+            _enable();
+            KiIdleSchedule(Prcb);
+            _disable();
+        }
+#endif
+
         /* Check if a new thread is scheduled for execution */
         if (Prcb->NextThread)
         {
             /* Enable interrupts */
             _enable();
 
+#ifdef CONFIG_SMP
+            /* Other processors schedule threads here too */
+            KiAcquirePrcbLock(Prcb);
+#endif
+
             /* Capture current thread data */
             OldThread = Prcb->CurrentThread;
             NewThread = Prcb->NextThread;
@@ -300,6 +315,10 @@ KiIdleLoop(VOID)
             /* The thread is now running */
             NewThread->State = Running;
 
+#ifdef CONFIG_SMP
+            KiReleasePrcbLock(Prcb);
+#endif
+
 #ifdef CONFIG_SMP
             /* Do the swap at SYNCH_LEVEL */
             KfRaiseIrql(SYNCH_LEVEL);
@@ -390,6 +409,9 @@ KiSwapContextExit(IN PKTHREAD OldThread,
                      0);
     }
 
+    /* We are off the old stack, so the old thread can run elsewhere now */
+    OldThread->SwapBusy = FALSE;
+
     /* Kernel APCs may be pending */
     if (NewThread->ApcState.KernelApcPending)
     {
@@ -437,12 +459,33 @@ KiSwapContextEntry(IN PKSWITCHFRAME SwitchFrame,
     /* Get the old thread and set its kernel stack */
     OldThread->KernelStack = SwitchFrame;
 
-    /* Set swapbusy to false for the new thread */
-    NewThread->SwapBusy = FALSE;
+#ifdef CONFIG_SMP
+    /* The new thread may still be switching away on another processor */
+    while (NewThread->SwapBusy)
+    {
+        YieldProcessor();
+        KeMemoryBarrierWithoutFence();
+    }
+#endif
 
     /* ISRs can change FPU state, so disable interrupts while checking */
     _disable();
 
+#ifdef CONFIG_SMP
+    /* The old thread may run on another processor next, so its FPU state
+     * cannot stay behind in this one */
+    if (OldThread->NpxState == NPX_STATE_LOADED)
+    {
+        Cr0 = __readcr0();
+        if (Cr0 & (CR0_MP | CR0_EM | CR0_TS))
+            __writecr0(Cr0 & ~(CR0_MP | CR0_EM | CR0_TS));
+
+        Ke386SaveFpuState(KiGetThreadNpxArea(OldThread));
+        OldThread->NpxState = NPX_STATE_NOT_LOADED;
+        Pcr->PrcbData.NpxThread = NULL;
+    }
+#endif
+
     /* Get current and new CR0 and check if they've changed */
     Cr0 = __readcr0();
     NewCr0 = NewThread->NpxState |
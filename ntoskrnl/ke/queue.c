@@ -230,14 +230,15 @@ KeReadStateQueue(IN PKQUEUE Queue)
     return Queue->Header.SignalState;
 }
 
-/*
- * @implemented
- */
+static
 PLIST_ENTRY
-NTAPI
-KeRemoveQueue(IN PKQUEUE Queue,
+KiRemoveQueue(IN PKQUEUE Queue,
               IN KPROCESSOR_MODE WaitMode,
-              IN PLARGE_INTEGER Timeout OPTIONAL)
+              IN BOOLEAN Alertable,
+              IN PLARGE_INTEGER Timeout OPTIONAL,
+              OUT PLIST_ENTRY *EntryArray OPTIONAL,
+              IN ULONG Count,
+              OUT PULONG Removed)
 {
     PLIST_ENTRY QueueEntry;
     LONG_PTR Status;
@@ -267,6 +268,7 @@ KeRemoveQueue(IN PKQUEUE Queue,
         KxQueueThreadWait();
         KiAcquireDispatcherLockAtSynchLevel();
     }
+    Thread->Alertable = Alertable;
 
     /*
      * This is needed so that we can set the new queue right here,
@@ -327,6 +329,21 @@ KeRemoveQueue(IN PKQUEUE Queue,
             /* Remove the Entry */
             RemoveEntryList(QueueEntry);
             QueueEntry->Flink = NULL;
+            *Removed = 1;
+
+            /*
+             * Take whatever else is queued for a batch while we still hold
+             * the lock. This doesn't change the number of running threads,
+             * the caller handles all the entries itself.
+             */
+            while ((*Removed < Count) &&
+                   !IsListEmpty(&Queue->EntryListHead))
+            {
+                Queue->Header.SignalState--;
+                EntryArray[*Removed] = RemoveHeadList(&Queue->EntryListHead);
+                EntryArray[*Removed]->Flink = NULL;
+                (*Removed)++;
+            }
 
             /* Nothing to wait on */
             break;
@@ -344,12 +361,12 @@ KeRemoveQueue(IN PKQUEUE Queue,
             }
             else
             {
-                /* Fail if there's a User APC Pending */
-                if ((WaitMode != KernelMode) &&
-                    (Thread->ApcState.UserApcPending))
+                /* Fail if we were alerted or there's a User APC Pending */
+                Status = KiCheckAlertability(Thread, Alertable, WaitMode);
+                if (Status != STATUS_WAIT_0)
                 {
                     /* Return the status and increase the pending threads */
-                    QueueEntry = (PLIST_ENTRY)STATUS_USER_APC;
+                    QueueEntry = (PLIST_ENTRY)Status;
                     Queue->CurrentCount++;
                     break;
                 }
@@ -420,6 +437,7 @@ KeRemoveQueue(IN PKQUEUE Queue,
             Thread->WaitIrql = KeRaiseIrqlToSynchLevel();
             KxQueueThreadWait();
             KiAcquireDispatcherLockAtSynchLevel();
+            Thread->Alertable = Alertable;
             Queue->CurrentCount--;
         }
     }
@@ -430,6 +448,53 @@ KeRemoveQueue(IN PKQUEUE Queue,
     return QueueEntry;
 }
 
+/*
+ * @implemented
+ */
+PLIST_ENTRY
+NTAPI
+KeRemoveQueue(IN PKQUEUE Queue,
+              IN KPROCESSOR_MODE WaitMode,
+              IN PLARGE_INTEGER Timeout OPTIONAL)
+{
+    ULONG Removed;
+
+    /* Wait for a single entry */
+    return KiRemoveQueue(Queue, WaitMode, FALSE, Timeout, NULL, 1, &Removed);
+}
+
+/*
+ * @implemented
+ */
+ULONG
+NTAPI
+KeRemoveQueueEx(IN PKQUEUE Queue,
+                IN KPROCESSOR_MODE WaitMode,
+                IN BOOLEAN Alertable,
+                IN PLARGE_INTEGER Timeout OPTIONAL,
+                OUT PLIST_ENTRY *EntryArray,
+                IN ULONG Count)
+{
+    ULONG Removed = 1;
+    ASSERT_QUEUE(Queue);
+    ASSERT(Count != 0);
+
+    /*
+     * Wait for the first entry like KeRemoveQueue does. If one was already
+     * queued, the rest of the batch is taken under the same lock. A thread
+     * that had to wait gets the one entry it was woken for, and a timeout or
+     * an APC is returned as the only entry.
+     */
+    EntryArray[0] = KiRemoveQueue(Queue,
+                                  WaitMode,
+                                  Alertable,
+                                  Timeout,
+                                  EntryArray,
+                                  Count,
+                                  &Removed);
+    return Removed;
+}
+
 /*
  * @implemented
  */
@@ -15,9 +15,13 @@
 #ifdef _WIN64
 # define InterlockedOrSetMember(Destination, SetMember) \
     InterlockedOr64((PLONG64)Destination, SetMember);
+# define InterlockedClearSetMember(Destination, SetMember) \
+    InterlockedAnd64((PLONG64)Destination, ~(LONG64)(SetMember));
 #else
 # define InterlockedOrSetMember(Destination, SetMember) \
     InterlockedOr((PLONG)Destination, SetMember);
+# define InterlockedClearSetMember(Destination, SetMember) \
+    InterlockedAnd((PLONG)Destination, ~(LONG)(SetMember));
 #endif
 
 /* GLOBALS *******************************************************************/
@@ -27,12 +31,174 @@ KAFFINITY KiIdleSMTSummary;
 
 /* FUNCTIONS *****************************************************************/
 
+#ifdef CONFIG_SMP
+static
+VOID
+KiAcquireTwoPrcbLocks(IN PKPRCB FirstPrcb,
+                      IN PKPRCB SecondPrcb)
+{
+    /* Always lock the lower numbered processor first to avoid deadlocks */
+    if (FirstPrcb->Number < SecondPrcb->Number)
+    {
+        KiAcquirePrcbLock(FirstPrcb);
+        KiAcquirePrcbLock(SecondPrcb);
+    }
+    else
+    {
+        KiAcquirePrcbLock(SecondPrcb);
+        KiAcquirePrcbLock(FirstPrcb);
+    }
+}
+
+static
+PKTHREAD
+KiStealReadyThread(IN PKPRCB SourcePrcb,
+                   IN PKPRCB Prcb)
+{
+    PLIST_ENTRY ListHead, ListEntry;
+    PKTHREAD Thread;
+    ULONG Summary;
+    ULONG Priority;
+
+    /* Loop the ready lists of the other processor, highest priority first */
+    Summary = SourcePrcb->ReadySummary;
+    while (Summary)
+    {
+        BitScanReverse(&Priority, Summary);
+        Summary ^= PRIORITY_MASK(Priority);
+
+        ListHead = &SourcePrcb->DispatcherReadyListHead[Priority];
+        for (ListEntry = ListHead->Flink;
+             ListEntry != ListHead;
+             ListEntry = ListEntry->Flink)
+        {
+            /* Take the first thread that is allowed to run here */
+            Thread = CONTAINING_RECORD(ListEntry, KTHREAD, WaitListEntry);
+            if (Thread->Affinity & Prcb->SetMember)
+            {
+                ASSERT(Thread->State == Ready);
+                ASSERT(Thread->NextProcessor == SourcePrcb->Number);
+
+                /* Remove it from the list */
+                if (RemoveEntryList(&Thread->WaitListEntry))
+                {
+                    /* The list is empty now, reset the ready summary */
+                    SourcePrcb->ReadySummary ^= PRIORITY_MASK(Priority);
+                }
+
+                return Thread;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static
+ULONG
+KiSelectThreadProcessor(IN PKTHREAD Thread)
+{
+    KAFFINITY Affinity, IdleSet;
+    ULONG Processor;
+
+    /* Only look at processors that are actually running */
+    Affinity = Thread->Affinity & KeActiveProcessors;
+    ASSERT(Affinity != 0);
+
+    /* Prefer an idle processor: the ideal one, the last one, then any */
+    IdleSet = KiIdleSummary & Affinity;
+    if (IdleSet)
+    {
+        if (IdleSet & AFFINITY_MASK(Thread->IdealProcessor))
+            return Thread->IdealProcessor;
+
+        if (IdleSet & AFFINITY_MASK(Thread->NextProcessor))
+            return Thread->NextProcessor;
+
+        BitScanForwardAffinity(&Processor, IdleSet);
+        return Processor;
+    }
+
+    /* Otherwise go to the ideal processor, which spreads the threads of a
+     * process, or to the last one, where its data might still be cached */
+    if (Affinity & AFFINITY_MASK(Thread->IdealProcessor))
+        return Thread->IdealProcessor;
+
+    if (Affinity & AFFINITY_MASK(Thread->NextProcessor))
+        return Thread->NextProcessor;
+
+    BitScanForwardAffinity(&Processor, Affinity);
+    return Processor;
+}
+#endif
+
 PKTHREAD
 FASTCALL
 KiIdleSchedule(IN PKPRCB Prcb)
 {
-    /* FIXME: TODO */
-    ASSERTMSG("SMP: Not yet implemented\n", FALSE);
+#ifdef CONFIG_SMP
+    PKPRCB SourcePrcb;
+    PKTHREAD Thread = NULL;
+    ULONG Number, i;
+
+    /* Called by the idle loop without a thread to run, so start with the
+     * threads that are ready here but did not preempt the idle thread */
+    if (Prcb->ReadySummary)
+    {
+        KiAcquirePrcbLock(Prcb);
+        if (!Prcb->NextThread)
+        {
+            Thread = KiSelectReadyThread(0, Prcb);
+            if (Thread)
+            {
+                InterlockedClearSetMember(&KiIdleSummary, Prcb->SetMember);
+                Prcb->IdleSchedule = FALSE;
+                Thread->State = Standby;
+                Prcb->NextThread = Thread;
+            }
+        }
+        KiReleasePrcbLock(Prcb);
+        if (Thread) return Thread;
+    }
+
+    /* Then pull work from busy processors, starting with the next one so
+     * that idle processors do not all go after the same one */
+    for (i = 1; i < (ULONG)KeNumberProcessors; i++)
+    {
+        Number = (Prcb->Number + i) % KeNumberProcessors;
+        SourcePrcb = KiProcessorBlock[Number];
+
+        /* Peek without the lock first, this is just a hint */
+        if (!(SourcePrcb) || !(SourcePrcb->ReadySummary)) continue;
+
+        KiAcquireTwoPrcbLocks(Prcb, SourcePrcb);
+
+        /* Something might have been scheduled here in the meantime */
+        if (!Prcb->NextThread)
+        {
+            Thread = KiStealReadyThread(SourcePrcb, Prcb);
+            if (Thread)
+            {
+                InterlockedClearSetMember(&KiIdleSummary, Prcb->SetMember);
+                Prcb->IdleSchedule = FALSE;
+                Thread->NextProcessor = Prcb->Number;
+                Thread->State = Standby;
+                Prcb->NextThread = Thread;
+            }
+        }
+        else
+        {
+            /* Stop looking */
+            Thread = Prcb->NextThread;
+        }
+
+        KiReleasePrcbLock(SourcePrcb);
+        KiReleasePrcbLock(Prcb);
+        if (Thread) return Thread;
+    }
+#endif
+
+    /* Nothing to run */
     return NULL;
 }
 
@@ -228,21 +394,32 @@ KiDeferredReadyThread(IN PKTHREAD Thread)
     OldPriority = Thread->Priority;
     Thread->Preempted = FALSE;
 
-    /* Queue the thread on CPU 0 and get the PRCB and lock it */
-    Thread->NextProcessor = 0;
-    Prcb = KiProcessorBlock[0];
+#ifdef CONFIG_SMP
+    /* Pick the processor to run the thread on */
+    Processor = KiSelectThreadProcessor(Thread);
+#endif
+
+    /* Get the PRCB and lock it */
+    Prcb = KiProcessorBlock[Processor];
     KiAcquirePrcbLock(Prcb);
 
-    /* Check if we have an idle summary */
-    if (KiIdleSummary)
+    /* Check if the processor is idle */
+    if (KiIdleSummary & Prcb->SetMember)
     {
-        /* Clear it and set this thread as the next one */
-        KiIdleSummary = 0;
+        /* It is not anymore, set this thread as the next one */
+        InterlockedClearSetMember(&KiIdleSummary, Prcb->SetMember);
+        Thread->NextProcessor = (UCHAR)Processor;
         Thread->State = Standby;
         Prcb->NextThread = Thread;
 
-        /* Unlock the PRCB and return */
+        /* Unlock the PRCB */
         KiReleasePrcbLock(Prcb);
+
+        /* Wake it up if it is another CPU */
+        if (KeGetCurrentProcessorNumber() != Processor)
+        {
+            KiIpiSend(AFFINITY_MASK(Processor), IPI_DPC);
+        }
         return;
     }
 
@@ -336,12 +513,11 @@ KiSelectNextThread(IN PKPRCB Prcb)
         /* Didn't find any, get the current idle thread */
         Thread = Prcb->IdleThread;
 
-        /* Enable idle scheduling */
+        /* Enable idle scheduling, the idle loop will look for work on the
+         * other processors. KiIdleSMTSummary is not maintained as we do not
+         * treat SMT siblings differently yet. */
         InterlockedOrSetMember(&KiIdleSummary, Prcb->SetMember);
         Prcb->IdleSchedule = TRUE;
-
-        /* FIXME: SMT support */
-        ASSERTMSG("SMP: Not yet implemented\n", FALSE);
     }
 
     /* Sanity checks and return the thread */
@@ -385,8 +561,9 @@ KiSwapThread(IN PKTHREAD CurrentThread,
         }
         else
         {
-            /* Set the idle summary */
+            /* Set the idle summary and let the idle loop look for work */
             InterlockedOrSetMember(&KiIdleSummary, Prcb->SetMember);
+            Prcb->IdleSchedule = TRUE;
 
             /* Schedule the idle thread */
             NextThread = Prcb->IdleThread;
@@ -15,12 +15,178 @@
 /* GLOBALS *******************************************************************/
 
 KTIMER_TABLE_ENTRY KiTimerTableListHead[TIMER_TABLE_SIZE];
+LIST_ENTRY KiTimerWheel[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS][LOCK_QUEUE_TIMER_TABLE_LOCKS];
+ULONG KiTimerWheelRevolution;
+ULARGE_INTEGER KiTimerWheelCascadeTime;
 LARGE_INTEGER KiTimeIncrementReciprocal;
 UCHAR KiTimeIncrementShiftCount;
 BOOLEAN KiEnableTimerWatchdog = FALSE;
 
 /* PRIVATE FUNCTIONS *********************************************************/
 
+CODE_SEG("INIT")
+VOID
+NTAPI
+KiInitializeTimerWheel(VOID)
+{
+    ULONG Level, Slot, i;
+
+    /* Loop the wheel slots of every timer lock */
+    for (Level = 0; Level < TIMER_WHEEL_LEVELS; Level++)
+    {
+        for (Slot = 0; Slot < TIMER_WHEEL_SLOTS; Slot++)
+        {
+            for (i = 0; i < LOCK_QUEUE_TIMER_TABLE_LOCKS; i++)
+            {
+                InitializeListHead(&KiTimerWheel[Level][Slot][i]);
+            }
+        }
+    }
+
+    /* Cascade on the first clock tick, which sets up the real time */
+    KiTimerWheelRevolution = 0;
+    KiTimerWheelCascadeTime.QuadPart = 0;
+}
+
+static
+BOOLEAN
+KiInsertTimerWheel(IN PKTIMER Timer,
+                   IN ULONG Hand)
+{
+    ULONGLONG Revolution, Current;
+    ULONG Level, Slot;
+
+    /* Get the table revolution the timer is due in */
+    Revolution = Timer->DueTime.QuadPart / KeMaximumIncrement / TIMER_TABLE_SIZE;
+    Current = KiTimerWheelRevolution;
+
+    /* The table itself keeps the timers of this and the next revolution */
+    if (Revolution <= Current + 1) return FALSE;
+
+    /* Check if it is due in the group of revolutions being cascaded */
+    if ((Revolution >> TIMER_WHEEL_SHIFT) <= ((Current + 1) >> TIMER_WHEEL_SHIFT))
+    {
+        /* Wait in the slot of its revolution */
+        Level = 0;
+        Slot = (ULONG)Revolution & (TIMER_WHEEL_SLOTS - 1);
+    }
+    else
+    {
+        /* Wait in the slot of its group, far ones go around more than once */
+        Level = 1;
+        Slot = (ULONG)(Revolution >> TIMER_WHEEL_SHIFT) & (TIMER_WHEEL_SLOTS - 1);
+    }
+
+    /* Each timer lock has its own slots, so the hand's lock protects them */
+    Hand = (Hand >> LOCK_QUEUE_TIMER_LOCK_SHIFT) & (LOCK_QUEUE_TIMER_TABLE_LOCKS - 1);
+    InsertTailList(&KiTimerWheel[Level][Slot][Hand], &Timer->TimerListEntry);
+    return TRUE;
+}
+
+static
+VOID
+KiSpreadTimerWheelSlot(IN PLIST_ENTRY SlotListHead)
+{
+    LIST_ENTRY ListHead;
+    PKTIMER Timer;
+
+    /* Take the whole slot, some of its timers may go back into it */
+    if (IsListEmpty(SlotListHead)) return;
+    ListHead.Flink = SlotListHead->Flink;
+    ListHead.Blink = SlotListHead->Blink;
+    ListHead.Flink->Blink = &ListHead;
+    ListHead.Blink->Flink = &ListHead;
+    InitializeListHead(SlotListHead);
+
+    /* Insert every timer again at its due time */
+    while (!IsListEmpty(&ListHead))
+    {
+        Timer = CONTAINING_RECORD(RemoveHeadList(&ListHead), KTIMER, TimerListEntry);
+
+        /*
+         * Timers are cascaded a revolution before they are due, so this can
+         * only find an expired one if the expiration DPC was that late. The
+         * clock will still see it when it gets to its table entry.
+         */
+        KiInsertTimerTable(Timer, KiComputeTimerTableIndex(Timer->DueTime.QuadPart));
+    }
+}
+
+VOID
+FASTCALL
+KiCascadeTimerWheel(IN ULONGLONG InterruptTime)
+{
+    ULONG Revolution, Target, Slot, i;
+    PKSPIN_LOCK_QUEUE LockQueue;
+    ULARGE_INTEGER CascadeTime;
+
+    /* Loop the revolutions we have moved into */
+    Target = (ULONG)(InterruptTime / KeMaximumIncrement / TIMER_TABLE_SIZE);
+    while (KiTimerWheelRevolution != Target)
+    {
+        /* Publish the new revolution first, inserts under a lock will use it */
+        Revolution = KiTimerWheelRevolution + 1;
+        KiTimerWheelRevolution = Revolution;
+
+        for (i = 0; i < LOCK_QUEUE_TIMER_TABLE_LOCKS; i++)
+        {
+            LockQueue = KiAcquireTimerLock(i << LOCK_QUEUE_TIMER_LOCK_SHIFT);
+
+            /* Spread the next group when we get to its first revolution */
+            if (!((Revolution + 1) & (TIMER_WHEEL_SLOTS - 1)))
+            {
+                Slot = ((Revolution + 1) >> TIMER_WHEEL_SHIFT) & (TIMER_WHEEL_SLOTS - 1);
+                KiSpreadTimerWheelSlot(&KiTimerWheel[1][Slot][i]);
+            }
+
+            /* Bring the timers of the next revolution into the table */
+            Slot = (Revolution + 1) & (TIMER_WHEEL_SLOTS - 1);
+            KiSpreadTimerWheelSlot(&KiTimerWheel[0][Slot][i]);
+
+            KiReleaseTimerLock(LockQueue);
+        }
+    }
+
+    /* Check again when the next revolution starts */
+    CascadeTime.QuadPart = ((ULONGLONG)KiTimerWheelRevolution + 1) *
+                           TIMER_TABLE_SIZE * KeMaximumIncrement;
+    _disable();
+    KiTimerWheelCascadeTime = CascadeTime;
+    _enable();
+}
+
+/*
+ * Tickless idle hook: returns how many clock ticks from now, up to
+ * MaximumTicks, have neither a timer to expire nor a wheel cascade, so an
+ * idle processor could stop its clock for that long. Nothing calls it yet,
+ * as the HAL cannot stop the clock interrupt.
+ */
+ULONG
+FASTCALL
+KiComputeIdleTicks(IN ULONG MaximumTicks)
+{
+    ULONGLONG InterruptTime, TickTime;
+    ULONG Hand, Ticks;
+
+    /* Start from the tick the clock will check next */
+    InterruptTime = KeQueryInterruptTime();
+    Hand = KeTickCount.LowPart;
+
+    /* Count the ticks that have neither timers to expire nor a cascade */
+    for (Ticks = 0; Ticks < MaximumTicks; Ticks++)
+    {
+        TickTime = InterruptTime + (ULONGLONG)(Ticks + 1) * KeMaximumIncrement;
+        Hand = (Hand + 1) & (TIMER_TABLE_SIZE - 1);
+        if ((KiTimerTableListHead[Hand].Time.QuadPart <= TickTime) ||
+            (KiTimerWheelCascadeTime.QuadPart <= TickTime))
+        {
+            break;
+        }
+    }
+
+    return Ticks;
+}
+
 BOOLEAN
 FASTCALL
 KiInsertTreeTimer(IN PKTIMER Timer,
@@ -76,6 +242,9 @@ KiInsertTimerTable(IN PKTIMER Timer,
     /* Sanity check */
     ASSERT(Hand == KiComputeTimerTableIndex(DueTime));
 
+    /* Keep timers due after the next revolution out of the table */
+    if (KiInsertTimerWheel(Timer, Hand)) return FALSE;
+
     /* Loop the timer list backwards */
     ListHead = &KiTimerTableListHead[Hand].Entry;
     NextEntry = ListHead->Blink;
@@ -295,15 +464,31 @@ KeSetTimerEx(IN OUT PKTIMER Timer,
              IN LARGE_INTEGER DueTime,
              IN LONG Period,
              IN PKDPC Dpc OPTIONAL)
+{
+    /* Call the coalescing function without any tolerance */
+    return KeSetCoalescableTimer(Timer, DueTime, Period, 0, Dpc);
+}
+
+/*
+ * @implemented
+ */
+BOOLEAN
+NTAPI
+KeSetCoalescableTimer(IN OUT PKTIMER Timer,
+                      IN LARGE_INTEGER DueTime,
+                      IN ULONG Period,
+                      IN ULONG TolerableDelay,
+                      IN PKDPC Dpc OPTIONAL)
 {
     KIRQL OldIrql;
     BOOLEAN Inserted;
     ULONG Hand = 0;
+    ULONG Ticks, Shift;
     BOOLEAN RequestInterrupt = FALSE;
     ASSERT_TIMER(Timer);
     ASSERT(KeGetCurrentIrql() <= DISPATCH_LEVEL);
-    DPRINT("KeSetTimerEx(): Timer %p, DueTime %I64d, Period %d, Dpc %p\n",
-           Timer, DueTime.QuadPart, Period, Dpc);
+    DPRINT("KeSetCoalescableTimer(): Timer %p, DueTime %I64d, Period %lu, Delay %lu, Dpc %p\n",
+           Timer, DueTime.QuadPart, Period, TolerableDelay, Dpc);
 
     /* Lock the Database and Raise IRQL */
     OldIrql = KiAcquireDispatcherLock();
@@ -315,6 +500,18 @@ KeSetTimerEx(IN OUT PKTIMER Timer,
     /* Set Default Timer Data */
     Timer->Dpc = Dpc;
     Timer->Period = Period;
+
+    /* Use the largest power of two clock ticks the caller can wait for */
+    Timer->Header.Coalescable = FALSE;
+    Timer->Header.EncodedTolerableDelay = 0;
+    Ticks = (ULONG)(UInt32x32To64(TolerableDelay, 10000) / KeMaximumIncrement);
+    if (Ticks)
+    {
+        BitScanReverse(&Shift, Ticks);
+        Timer->Header.Coalescable = TRUE;
+        Timer->Header.EncodedTolerableDelay = Shift;
+    }
+
     if (!KiComputeDueTime(Timer, DueTime, &Hand))
     {
         /* Signal the timer */
@@ -339,4 +536,3 @@ KeSetTimerEx(IN OUT PKTIMER Timer,
     /* Return old state */
     return Inserted;
 }
-
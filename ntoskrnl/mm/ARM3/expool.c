@@ -39,7 +39,9 @@ typedef struct _POOL_DPC_CONTEXT
 } POOL_DPC_CONTEXT, *PPOOL_DPC_CONTEXT;
 
 ULONG ExpNumberOfPagedPools;
+ULONG ExpNumberOfNonPagedPools = 1;
 POOL_DESCRIPTOR NonPagedPoolDescriptor;
+PPOOL_DESCRIPTOR ExpNonPagedPoolDescriptor[EXP_MAXIMUM_POOL_NODES];
 PPOOL_DESCRIPTOR ExpPagedPoolDescriptor[16 + 1];
 PPOOL_DESCRIPTOR PoolVector[2];
 PKGUARDED_MUTEX ExpPagedPoolMutex;
@@ -211,8 +213,10 @@ ExpCheckPoolHeader(IN PPOOL_HEADER Entry)
                          (ULONG_PTR)Entry);
         }
 
-        /* This block should also indicate that it's as large as we think it is */
-        if (PreviousEntry->BlockSize != Entry->PreviousSize)
+        /* This block should also indicate that it's as large as we think it is,
+           and belong to the same pool descriptor since it is on the same page */
+        if ((PreviousEntry->BlockSize != Entry->PreviousSize) ||
+            (PreviousEntry->PoolIndex != Entry->PoolIndex))
         {
             /* Otherwise, someone corrupted one of the sizes */
             DPRINT1("PreviousEntry BlockSize %lu, tag %.4s. Entry PreviousSize %lu, tag %.4s\n",
@@ -1214,6 +1218,7 @@ InitializePool(IN POOL_TYPE PoolType,
         // Initialize the nonpaged pool descriptor
         //
         PoolVector[NonPagedPool] = &NonPagedPoolDescriptor;
+        ExpNonPagedPoolDescriptor[0] = &NonPagedPoolDescriptor;
         ExInitializePoolDescriptor(PoolVector[NonPagedPool],
                                    NonPagedPool,
                                    0,
@@ -1268,15 +1273,72 @@ InitializePool(IN POOL_TYPE PoolType,
     }
 }
 
+CODE_SEG("INIT")
+VOID
+NTAPI
+ExInitializeProcessorPools(VOID)
+{
+    PPOOL_DESCRIPTOR Descriptor;
+    PKSPIN_LOCK PoolLock;
+    ULONG i;
+
+    //
+    // The boot processor keeps the well-known descriptor. Give every other
+    // processor its own nonpaged pool descriptor, followed by its own lock,
+    // so that small allocations on different processors do not contend.
+    //
+    for (i = 1; i < min(KeNumberProcessors, EXP_MAXIMUM_POOL_NODES); i++)
+    {
+        Descriptor = ExAllocatePoolWithTag(NonPagedPool,
+                                           sizeof(POOL_DESCRIPTOR) +
+                                           sizeof(KSPIN_LOCK),
+                                           'looP');
+        if (!Descriptor)
+        {
+            //
+            // Not fatal, the remaining processors keep using the first one
+            //
+            DPRINT1("No nonpaged pool descriptor for processor %lu\n", i);
+            break;
+        }
+
+        PoolLock = (PKSPIN_LOCK)(Descriptor + 1);
+        KeInitializeSpinLock(PoolLock);
+        ExInitializePoolDescriptor(Descriptor,
+                                   NonPagedPool,
+                                   i,
+                                   NonPagedPoolDescriptor.Threshold,
+                                   PoolLock);
+
+        //
+        // Publish it. Blocks remember the index of the descriptor they were
+        // carved from, so the count must cover it before anyone uses it.
+        //
+        ExpNumberOfNonPagedPools = i + 1;
+        ExpNonPagedPoolDescriptor[i] = Descriptor;
+    }
+}
+
 FORCEINLINE
 KIRQL
 ExLockPool(IN PPOOL_DESCRIPTOR Descriptor)
 {
+    KIRQL OldIrql;
+
     //
     // Check if this is nonpaged pool
     //
     if ((Descriptor->PoolType & BASE_POOL_TYPE_MASK) == NonPagedPool)
     {
+        //
+        // Per-processor descriptors have their own lock
+        //
+        if (Descriptor->LockAddress)
+        {
+            KeAcquireSpinLock(Descriptor->LockAddress, &OldIrql);
+            return OldIrql;
+        }
+
         //
         // Use the queued spin lock
         //
@@ -1302,6 +1364,15 @@ ExUnlockPool(IN PPOOL_DESCRIPTOR Descriptor,
     //
     if ((Descriptor->PoolType & BASE_POOL_TYPE_MASK) == NonPagedPool)
     {
+        //
+        // Per-processor descriptors have their own lock
+        //
+        if (Descriptor->LockAddress)
+        {
+            KeReleaseSpinLock(Descriptor->LockAddress, OldIrql);
+            return;
+        }
+
         //
         // Use the queued spin lock
         //
@@ -1807,18 +1878,15 @@ ExQueryPoolUsage(OUT PULONG PagedPoolPages,
     // If the system has more than one non-paged pool, copy the other descriptor
     // totals as well
     //
-#if 0
-    if (ExpNumberOfNonPagedPools > 1)
+    for (i = 1; i < ExpNumberOfNonPagedPools; i++)
     {
-        for (i = 0; i < ExpNumberOfNonPagedPools; i++)
-        {
-            PoolDesc = ExpNonPagedPoolDescriptor[i];
-            *NonPagedPoolPages += PoolDesc->TotalPages + PoolDesc->TotalBigPages;
-            *NonPagedPoolAllocs += PoolDesc->RunningAllocs;
-            *NonPagedPoolFrees += PoolDesc->RunningDeAllocs;
-        }
+        PoolDesc = ExpNonPagedPoolDescriptor[i];
+        if (!PoolDesc) continue;
+
+        *NonPagedPoolPages += PoolDesc->TotalPages + PoolDesc->TotalBigPages;
+        *NonPagedPoolAllocs += PoolDesc->RunningAllocs;
+        *NonPagedPoolFrees += PoolDesc->RunningDeAllocs;
     }
-#endif
 
     //
     // Get the amount of hits in the system lookaside lists
@@ -2131,6 +2199,18 @@ ExAllocatePoolWithTag(IN POOL_TYPE PoolType,
         }
     }
 
+    //
+    // Small nonpaged allocations come from this processor's descriptor, if it
+    // has one. It does not matter if we get moved to another processor now,
+    // every descriptor has its own lock.
+    //
+    if ((PoolType == NonPagedPool) &&
+        (Prcb->Number < EXP_MAXIMUM_POOL_NODES) &&
+        (ExpNonPagedPoolDescriptor[Prcb->Number] != NULL))
+    {
+        PoolDesc = ExpNonPagedPoolDescriptor[Prcb->Number];
+    }
+
     //
     // Loop in the free lists looking for a block if this size. Start with the
     // list optimized for this kind of size lookup
@@ -2195,6 +2275,7 @@ ExAllocatePoolWithTag(IN POOL_TYPE PoolType,
                     //
                     FragmentEntry = POOL_BLOCK(Entry, i);
                     FragmentEntry->BlockSize = Entry->BlockSize - i;
+                    FragmentEntry->PoolIndex = PoolDesc->PoolIndex;
 
                     //
                     // And make it point back to us
@@ -2239,6 +2320,7 @@ ExAllocatePoolWithTag(IN POOL_TYPE PoolType,
                     //
                     Entry = POOL_NEXT_BLOCK(Entry);
                     Entry->PreviousSize = FragmentEntry->BlockSize;
+                    Entry->PoolIndex = PoolDesc->PoolIndex;
 
                     //
                     // And now let's go to the entry after that one and check if
@@ -2387,6 +2469,7 @@ ExAllocatePoolWithTag(IN POOL_TYPE PoolType,
     //
     Entry->Ulong1 = 0;
     Entry->BlockSize = i;
+    Entry->PoolIndex = PoolDesc->PoolIndex;
     Entry->PoolType = OriginalType + 1;
 
     //
@@ -2399,6 +2482,7 @@ ExAllocatePoolWithTag(IN POOL_TYPE PoolType,
     FragmentEntry = POOL_BLOCK(Entry, i);
     FragmentEntry->Ulong1 = 0;
     FragmentEntry->BlockSize = BlockSize;
+    FragmentEntry->PoolIndex = PoolDesc->PoolIndex;
     FragmentEntry->PreviousSize = i;
 
     //
@@ -2673,6 +2757,23 @@ ExFreePoolWithTag(IN PVOID P,
     PoolType = (Entry->PoolType - 1) & BASE_POOL_TYPE_MASK;
     PoolDesc = PoolVector[PoolType];
 
+    //
+    // Nonpaged blocks go back to the descriptor they were carved from
+    //
+    if (PoolType == NonPagedPool)
+    {
+        if ((Entry->PoolIndex >= ExpNumberOfNonPagedPools) ||
+            (ExpNonPagedPoolDescriptor[Entry->PoolIndex] == NULL))
+        {
+            KeBugCheckEx(BAD_POOL_HEADER,
+                         POOL_SIZE_OR_INDEX_MISMATCH,
+                         (ULONG_PTR)Entry,
+                         __LINE__,
+                         Entry->PoolIndex);
+        }
+        PoolDesc = ExpNonPagedPoolDescriptor[Entry->PoolIndex];
+    }
+
     //
     // Make sure that the IRQL makes sense
     //
@@ -108,8 +108,10 @@ MiUnmapPageInHyperSpace(IN PEPROCESS Process,
 
 PVOID
 NTAPI
-MiMapPagesInZeroSpace(IN PMMPFN Pfn1,
-                      IN PFN_NUMBER NumberOfPages)
+MiMapPagesInZeroSpace(IN PMMPTE ZeroingPte,
+                      IN PMMPFN Pfn1,
+                      IN PFN_NUMBER NumberOfPages,
+                      IN BOOLEAN Cached)
 {
     MMPTE TempPte;
     PMMPTE PointerPte;
@@ -123,9 +125,10 @@ MiMapPagesInZeroSpace(IN PMMPFN Pfn1,
     ASSERT(NumberOfPages <= MI_ZERO_PTES);
 
     //
-    // Pick the first zeroing PTE
+    // Pick the first zeroing PTE. Every zeroing thread has its own range and
+    // only runs on one processor, so flushing the local TB is enough.
     //
-    PointerPte = MiFirstReservedZeroingPte;
+    PointerPte = ZeroingPte;
 
     //
     // Now get the first free PTE
@@ -150,9 +153,15 @@ MiMapPagesInZeroSpace(IN PMMPFN Pfn1,
     PointerPte += (Offset + 1);
     TempPte = ValidKernelPte;
 
-    /* Disable cache. Write through */
-    MI_PAGE_DISABLE_CACHE(&TempPte);
-    MI_PAGE_WRITE_THROUGH(&TempPte);
+    /*
+     * Disable cache and write through, unless the caller zeroes the pages
+     * with non-temporal stores which do not go through the cache anyway.
+     */
+    if (!Cached)
+    {
+        MI_PAGE_DISABLE_CACHE(&TempPte);
+        MI_PAGE_WRITE_THROUGH(&TempPte);
+    }
 
     /* Make sure the list isn't empty and loop it */
     ASSERT(Pfn1 != (PVOID)LIST_HEAD);
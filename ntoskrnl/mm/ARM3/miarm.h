@@ -397,8 +397,16 @@ typedef struct _POOL_TRACKER_BIG_PAGES
     PVOID QuotaObject;
 } POOL_TRACKER_BIG_PAGES, *PPOOL_TRACKER_BIG_PAGES;
 
+//
+// Nonpaged pool descriptors, one per processor. The index is kept in the
+// PoolIndex field of the pool header.
+//
+#define EXP_MAXIMUM_POOL_NODES MAXIMUM_PROCESSORS
+
 extern ULONG ExpNumberOfPagedPools;
+extern ULONG ExpNumberOfNonPagedPools;
 extern POOL_DESCRIPTOR NonPagedPoolDescriptor;
+extern PPOOL_DESCRIPTOR ExpNonPagedPoolDescriptor[EXP_MAXIMUM_POOL_NODES];
 extern PPOOL_DESCRIPTOR ExpPagedPoolDescriptor[16 + 1];
 extern PPOOL_TRACKER_TABLE PoolTrackTable;
 
@@ -646,6 +654,8 @@ extern PFN_NUMBER MmSystemPageDirectory[PPE_PER_PAGE];
 extern PMMPTE MmSharedUserDataPte;
 extern LIST_ENTRY MmProcessList;
 extern KEVENT MmZeroingPageEvent;
+extern SIZE_T MmZeroedPageHits;
+extern SIZE_T MmZeroedPageMisses;
 extern ULONG MmSystemPageColor;
 extern ULONG MmProcessColorSeed;
 extern PMMWSL MmWorkingSetList;
@@ -2413,6 +2423,9 @@ PFN_NUMBER
 MiRemoveZeroPageSafe(IN ULONG Color)
 {
     if (MmFreePagesByColor[ZeroedPageList][Color].Flink != LIST_HEAD) return MiRemoveZeroPage(Color);
+
+    /* The caller takes any page and zeroes it itself */
+    MmZeroedPageMisses++;
     return 0;
 }
 
@@ -38,6 +38,13 @@ ULONG MmSystemPageColor;
 ULONG MmTransitionSharedPages;
 ULONG MmTotalPagesForPagingFile;
 
+/* Zero page requests served from the zeroed list, and those zeroed inline */
+SIZE_T MmZeroedPageHits;
+SIZE_T MmZeroedPageMisses;
+
+/* Wake the zeroing threads when fewer zeroed pages than this are left */
+#define MI_ZEROED_PAGES_LOW 256
+
 MMPFNLIST MmZeroedPageListHead = {0, ZeroedPageList, LIST_HEAD, LIST_HEAD};
 MMPFNLIST MmFreePageListHead = {0, FreePageList, LIST_HEAD, LIST_HEAD};
 MMPFNLIST MmStandbyPageListHead = {0, StandbyPageList, LIST_HEAD, LIST_HEAD};
@@ -594,7 +601,23 @@ MiRemoveZeroPage(IN ULONG Color)
     ASSERT(Pfn1 == MI_PFN_ELEMENT(PageIndex));
 
     /* Zero it, if needed */
-    if (Zero) MiZeroPhysicalPage(PageIndex);
+    if (Zero)
+    {
+        MmZeroedPageMisses++;
+        MiZeroPhysicalPage(PageIndex);
+    }
+    else
+    {
+        MmZeroedPageHits++;
+    }
+
+    /* Refill the zeroed list before it runs dry */
+    if ((MmZeroedPageListHead.Total < MI_ZEROED_PAGES_LOW) &&
+        (MmFreePageListHead.Total != 0) &&
+        !KeReadStateEvent(&MmZeroingPageEvent))
+    {
+        KeSetEvent(&MmZeroingPageEvent, IO_NO_INCREMENT, FALSE);
+    }
 
     /* Sanity checks */
     ASSERT(Pfn1->u3.e2.ReferenceCount == 0);
@@ -700,8 +723,8 @@ MiInsertPageInFreeList(IN PFN_NUMBER PageFrameIndex)
     /* And increase the count in the colored list */
     ColorTable->Count++;
 
-    /* Notify zero page thread if enough pages are on the free list now */
-    if (ListHead->Total >= 8)
+    /* Notify zero page threads if enough pages are on the free list now */
+    if ((ListHead->Total >= 8) && !KeReadStateEvent(&MmZeroingPageEvent))
     {
         /* Set the event */
         KeSetEvent(&MmZeroingPageEvent, IO_NO_INCREMENT, FALSE);
@@ -1335,4 +1358,33 @@ MiInitializePfnForOtherProcess(IN PFN_NUMBER PageFrameIndex,
     }
 }
 
+VOID
+NTAPI
+MmQueryMemoryListInformation(OUT PSYSTEM_MEMORY_LIST_INFORMATION_EX Information)
+{
+    KIRQL OldIrql;
+    ULONG i;
+
+    RtlZeroMemory(Information, sizeof(*Information));
+
+    /* Take a consistent snapshot of the page lists */
+    OldIrql = MiAcquirePfnLock();
+
+    Information->MemoryLists.ZeroPageCount = MmZeroedPageListHead.Total;
+    Information->MemoryLists.FreePageCount = MmFreePageListHead.Total;
+    Information->MemoryLists.ModifiedPageCount = MmModifiedPageListHead.Total;
+    Information->MemoryLists.ModifiedNoWritePageCount = MmModifiedNoWritePageListHead.Total;
+    Information->MemoryLists.BadPageCount = MmBadPageListHead.Total;
+    for (i = 0; i < RTL_NUMBER_OF(MmStandbyPageListByPriority); i++)
+    {
+        Information->MemoryLists.PageCountByPriority[i] = MmStandbyPageListByPriority[i].Total;
+    }
+    Information->MemoryLists.ModifiedPageCountPageFile = MmModifiedPageListByColor[0].Total;
+
+    Information->ZeroedPageHits = MmZeroedPageHits;
+    Information->ZeroedPageMisses = MmZeroedPageMisses;
+
+    MiReleasePfnLock(OldIrql);
+}
+
 /* EOF */
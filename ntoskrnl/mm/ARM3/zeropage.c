@@ -19,6 +19,20 @@
 
 KEVENT MmZeroingPageEvent;
 
+/* Zeroing threads, one per processor up to this many */
+#define MI_MAX_ZEROING_THREADS 16
+
+typedef
+VOID
+(FASTCALL *PMI_ZERO_PAGES_ROUTINE)(
+    IN PVOID Address,
+    IN ULONG Size
+);
+
+static ULONG MiZeroingThreadCount;
+static PMI_ZERO_PAGES_ROUTINE MiZeroPagesRoutine = KeZeroPages;
+static BOOLEAN MiZeroPagesCached;
+
 /* PRIVATE FUNCTIONS **********************************************************/
 
 VOID
@@ -31,23 +45,112 @@ NTAPI
 MiFreeInitializationCode(IN PVOID StartVa,
 IN PVOID EndVa);
 
+static
 VOID
-NTAPI
-MmZeroPageThread(VOID)
+MiSelectZeroPagesRoutine(VOID)
+{
+#if defined(_M_IX86) || defined(_M_AMD64)
+    /*
+     * Freed pages are rarely touched again soon, zero them with non-temporal
+     * stores so that they do not evict the working set of the other threads.
+     * These bypass the cache, so the zeroing PTEs can be cached mappings.
+     */
+    if (KeFeatureBits & KF_XMMI64)
+    {
+        MiZeroPagesRoutine = KeZeroPagesNonTemporal;
+        MiZeroPagesCached = TRUE;
+    }
+#endif
+
+    DPRINT("Zeroing pages with %s stores\n", MiZeroPagesCached ? "non-temporal" : "uncached");
+}
+
+static
+ULONG
+MiRemoveFreePagesForZeroing(IN OUT PULONG Color,
+                            OUT PMMPFN *FirstPfn)
+{
+    ULONG PageCount = 0, Scanned;
+    PMMPFN Pfn1 = (PMMPFN)LIST_HEAD;
+    PMMPFN Pfn2;
+    PFN_NUMBER PageIndex, FreePage;
+
+    MI_ASSERT_PFN_LOCK_HELD();
+
+    while ((PageCount < MI_ZERO_PTES) && MmFreePageListHead.Total)
+    {
+        /*
+         * Take the pages round-robin from the colored lists, so that every
+         * color gets zeroed pages and the threads mostly work on different
+         * colors.
+         */
+        for (Scanned = 0; Scanned < MmSecondaryColors; Scanned++)
+        {
+            if (MmFreePagesByColor[FreePageList][*Color].Flink != LIST_HEAD)
+                break;
+
+            *Color = (*Color + 1) & MmSecondaryColorMask;
+        }
+
+        /* The colored lists hold every free page */
+        if (Scanned == MmSecondaryColors)
+        {
+            KeBugCheckEx(PFN_LIST_CORRUPT,
+                         0x8F,
+                         MmFreePageListHead.Total,
+                         MmFreePageListHead.Flink,
+                         0);
+        }
+
+        PageIndex = MmFreePagesByColor[FreePageList][*Color].Flink;
+        MI_SET_USAGE(MI_USAGE_ZERO_LOOP);
+        MI_SET_PROCESS2("Kernel 0 Loop");
+        FreePage = MiRemoveAnyPage(*Color);
+
+        /* The first free page of the color should also be the one removed */
+        if (FreePage != PageIndex)
+        {
+            KeBugCheckEx(PFN_LIST_CORRUPT,
+                        0x8F,
+                        FreePage,
+                        PageIndex,
+                        0);
+        }
+
+        Pfn2 = MiGetPfnEntry(PageIndex);
+        Pfn2->u1.Flink = (PFN_NUMBER)Pfn1;
+        Pfn1 = Pfn2;
+        PageCount++;
+
+        *Color = (*Color + 1) & MmSecondaryColorMask;
+    }
+
+    *FirstPfn = Pfn1;
+    return PageCount;
+}
+
+static
+VOID
+MiZeroFreePages(IN ULONG Number,
+                IN PMMPTE ZeroingPte)
 {
     PKTHREAD Thread = KeGetCurrentThread();
-    PVOID StartAddress, EndAddress;
     PVOID WaitObjects[2];
+    ULONG Color;
 
-    /* Get the discardable sections to free them */
-    MiFindInitializationCode(&StartAddress, &EndAddress);
-    if (StartAddress) MiFreeInitializationCode(StartAddress, EndAddress);
-    DPRINT("Free pages: %lx\n", MmAvailablePages);
+    /*
+     * Stay on our own processor, the zeroing PTEs of this thread are only
+     * flushed from the local TB.
+     */
+    KeSetSystemAffinityThread(AFFINITY_MASK(Number));
 
     /* Set our priority to 0 */
     Thread->BasePriority = 0;
     KeSetPriorityThread(Thread, 0);
 
+    /* Start on our own share of the colors */
+    Color = (Number * MmSecondaryColors / MiZeroingThreadCount) & MmSecondaryColorMask;
+
     /* Setup the wait objects */
     WaitObjects[0] = &MmZeroingPageEvent;
 //    WaitObjects[1] = &PoSystemIdleTimer; FIXME: Implement idle timer
@@ -68,50 +171,27 @@ MmZeroPageThread(VOID)
 
         while (TRUE)
         {
-            ULONG PageCount = 0;
-            PMMPFN Pfn1 = (PMMPFN)LIST_HEAD;
+            ULONG PageCount;
+            PMMPFN Pfn1;
             PVOID ZeroAddress;
-            PFN_NUMBER PageIndex, FreePage;
-
-            while (PageCount < MI_ZERO_PTES)
-            {
-                PMMPFN Pfn2;
-
-                if (!MmFreePageListHead.Total)
-                    break;
-
-                PageIndex = MmFreePageListHead.Flink;
-                ASSERT(PageIndex != LIST_HEAD);
-                MI_SET_USAGE(MI_USAGE_ZERO_LOOP);
-                MI_SET_PROCESS2("Kernel 0 Loop");
-                FreePage = MiRemoveAnyPage(MI_GET_PAGE_COLOR(PageIndex));
-
-                /* The first global free page should also be the first on its own list */
-                if (FreePage != PageIndex)
-                {
-                    KeBugCheckEx(PFN_LIST_CORRUPT,
-                                0x8F,
-                                FreePage,
-                                PageIndex,
-                                0);
-                }
-
-                Pfn2 = MiGetPfnEntry(PageIndex);
-                Pfn2->u1.Flink = (PFN_NUMBER)Pfn1;
-                Pfn1 = Pfn2;
-                PageCount++;
-            }
-            MiReleasePfnLock(OldIrql);
+            PFN_NUMBER PageIndex;
 
+            PageCount = MiRemoveFreePagesForZeroing(&Color, &Pfn1);
             if (PageCount == 0)
             {
+                /* Nothing left, all the threads go back to sleep */
                 KeClearEvent(&MmZeroingPageEvent);
+                MiReleasePfnLock(OldIrql);
                 break;
             }
+            MiReleasePfnLock(OldIrql);
 
-            ZeroAddress = MiMapPagesInZeroSpace(Pfn1, PageCount);
+            ZeroAddress = MiMapPagesInZeroSpace(ZeroingPte,
+                                                Pfn1,
+                                                PageCount,
+                                                MiZeroPagesCached);
             ASSERT(ZeroAddress);
-            KeZeroPages(ZeroAddress, PageCount * PAGE_SIZE);
+            MiZeroPagesRoutine(ZeroAddress, PageCount * PAGE_SIZE);
             MiUnmapPagesInZeroSpace(ZeroAddress, PageCount);
 
             OldIrql = MiAcquirePfnLock();
@@ -126,4 +206,67 @@ MmZeroPageThread(VOID)
     }
 }
 
+static
+VOID
+NTAPI
+MiZeroingThreadStartup(IN PVOID StartContext)
+{
+    ULONG Number = PtrToUlong(StartContext);
+    PMMPTE ZeroingPte;
+
+    /* Reserve our own zeroing PTEs, with the counter set to maximum */
+    ZeroingPte = MiReserveSystemPtes(MI_ZERO_PTES + 1, SystemPteSpace);
+    if (!ZeroingPte)
+    {
+        DPRINT1("No PTEs for zeroing thread %lu\n", Number);
+        PsTerminateSystemThread(STATUS_INSUFFICIENT_RESOURCES);
+    }
+    RtlZeroMemory(ZeroingPte, (MI_ZERO_PTES + 1) * sizeof(MMPTE));
+    ZeroingPte->u.Hard.PageFrameNumber = MI_ZERO_PTES;
+
+    MiZeroFreePages(Number, ZeroingPte);
+}
+
+VOID
+NTAPI
+MmZeroPageThread(VOID)
+{
+    PVOID StartAddress, EndAddress;
+    OBJECT_ATTRIBUTES ObjectAttributes;
+    HANDLE ThreadHandle;
+    NTSTATUS Status;
+    ULONG i;
+
+    /* Get the discardable sections to free them */
+    MiFindInitializationCode(&StartAddress, &EndAddress);
+    if (StartAddress) MiFreeInitializationCode(StartAddress, EndAddress);
+    DPRINT("Free pages: %lx\n", MmAvailablePages);
+
+    MiSelectZeroPagesRoutine();
+
+    /* Zero pages on every processor, this thread takes care of the first one */
+    MiZeroingThreadCount = min(KeNumberProcessors, MI_MAX_ZEROING_THREADS);
+    InitializeObjectAttributes(&ObjectAttributes, NULL, OBJ_KERNEL_HANDLE, NULL, NULL);
+    for (i = 1; i < MiZeroingThreadCount; i++)
+    {
+        Status = PsCreateSystemThread(&ThreadHandle,
+                                      THREAD_ALL_ACCESS,
+                                      &ObjectAttributes,
+                                      NULL,
+                                      NULL,
+                                      MiZeroingThreadStartup,
+                                      UlongToPtr(i));
+        if (!NT_SUCCESS(Status))
+        {
+            DPRINT1("Failed to create zeroing thread %lu: 0x%lx\n", i, Status);
+            continue;
+        }
+
+        ZwClose(ThreadHandle);
+    }
+
+    /* The boot time zeroing PTEs are ours */
+    MiZeroFreePages(0, MiFirstReservedZeroingPte);
+}
+
 /* EOF */
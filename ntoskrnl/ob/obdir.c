@@ -18,9 +18,86 @@
 #include <debug.h>
 
 POBJECT_TYPE ObpDirectoryObjectType = NULL;
+ULONG ObpNegativeCacheHits, ObpNegativeCacheMisses;
 
 /* PRIVATE FUNCTIONS ******************************************************/
 
+static
+BOOLEAN
+ObpIsNegativeEntry(IN POBP_DIRECTORY Directory,
+                   IN PUNICODE_STRING Name,
+                   IN ULONG HashValue,
+                   IN BOOLEAN CaseInsensitive)
+{
+    POBP_NEGATIVE_ENTRY Entry;
+    UNICODE_STRING MissingName;
+    ULONG i;
+
+    /* Loop the names which were not found last time */
+    for (i = 0; i < OBP_NEGATIVE_ENTRIES; i++)
+    {
+        Entry = &Directory->NegativeEntries[i];
+        if (!(Entry->Length) ||
+            (Entry->HashValue != HashValue) ||
+            (Entry->Length != Name->Length))
+        {
+            continue;
+        }
+
+        /* A case-sensitive miss says nothing about the other cases */
+        if ((CaseInsensitive) && !(Entry->CaseInsensitive)) continue;
+
+        /* Compare the way the name was looked up */
+        MissingName.Buffer = Entry->Name;
+        MissingName.Length = MissingName.MaximumLength = Entry->Length;
+        if (RtlEqualUnicodeString(Name, &MissingName, Entry->CaseInsensitive))
+        {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+static
+VOID
+ObpInsertNegativeEntry(IN POBP_DIRECTORY Directory,
+                       IN PUNICODE_STRING Name,
+                       IN ULONG HashValue,
+                       IN BOOLEAN CaseInsensitive)
+{
+    POBP_NEGATIVE_ENTRY Entry;
+
+    /* Only remember short names */
+    if (Name->Length > sizeof(Entry->Name)) return;
+
+    /* Replace the oldest entry */
+    Entry = &Directory->NegativeEntries[Directory->NegativeNext];
+    Directory->NegativeNext = (Directory->NegativeNext + 1) % OBP_NEGATIVE_ENTRIES;
+
+    Entry->HashValue = HashValue;
+    Entry->Length = Name->Length;
+    Entry->CaseInsensitive = CaseInsensitive;
+    RtlCopyMemory(Entry->Name, Name->Buffer, Name->Length);
+}
+
+static
+VOID
+ObpFlushNegativeEntries(IN POBP_DIRECTORY Directory,
+                        IN ULONG HashValue)
+{
+    ULONG i;
+
+    /* Forget every miss the new name may match */
+    for (i = 0; i < OBP_NEGATIVE_ENTRIES; i++)
+    {
+        if (Directory->NegativeEntries[i].HashValue == HashValue)
+        {
+            Directory->NegativeEntries[i].Length = 0;
+        }
+    }
+}
+
 /*++
 * @name ObpInsertEntryDirectory
 *
@@ -89,6 +166,16 @@ ObpInsertEntryDirectory(IN POBJECT_DIRECTORY Parent,
 
     /* Associate the Directory */
     HeaderNameInfo->Directory = Parent;
+
+    /* The name is no longer missing from this directory */
+    ObpFlushNegativeEntries((POBP_DIRECTORY)Parent, Context->HashValue);
+
+    /* Invalidate the cached paths if they may go through this object */
+    if ((ObjectHeader->Type == ObpDirectoryObjectType) ||
+        (ObjectHeader->Type == ObpSymbolicLinkObjectType))
+    {
+        InterlockedIncrement(&ObpNamespaceGeneration);
+    }
     return TRUE;
 }
 
@@ -162,6 +249,7 @@ ObpLookupEntryDirectory(IN POBJECT_DIRECTORY Directory,
                         IN POBP_LOOKUP_CONTEXT Context)
 {
     BOOLEAN CaseInsensitive = FALSE;
+    BOOLEAN KnownMissing;
     POBJECT_HEADER_NAME_INFO HeaderNameInfo;
     POBJECT_HEADER ObjectHeader;
     ULONG HashValue;
@@ -227,8 +315,16 @@ DoItAgain:
         ObpAcquireDirectoryLockShared(Directory, Context);
     }
 
+    /* Don't scan the bucket for a name which recently wasn't there */
+    CurrentEntry = NULL;
+    KnownMissing = ObpIsNegativeEntry((POBP_DIRECTORY)Directory,
+                                      Name,
+                                      HashValue,
+                                      CaseInsensitive);
+    if (KnownMissing) InterlockedIncrement((PLONG)&ObpNegativeCacheHits);
+
     /* Start looping */
-    while ((CurrentEntry = *AllocatedEntry))
+    while (!(KnownMissing) && (CurrentEntry = *AllocatedEntry))
     {
         /* Do the hashes match? */
         if (CurrentEntry->HashValue == HashValue)
@@ -282,10 +378,23 @@ DoItAgain:
         /* Check if the directory was locked */
         if (!Context->DirectoryLocked)
         {
+            /* Remember the miss if we are the only ones in the directory */
+            if (!(KnownMissing) &&
+                (ExConvertPushLockSharedToExclusive(&Directory->Lock)))
+            {
+                ObpInsertNegativeEntry((POBP_DIRECTORY)Directory,
+                                       Name,
+                                       HashValue,
+                                       CaseInsensitive);
+            }
+
             /* Release the lock */
             ObpReleaseDirectoryLock(Directory, Context);
         }
 
+        /* Count the bucket scans which did not find the name */
+        if (!KnownMissing) InterlockedIncrement((PLONG)&ObpNegativeCacheMisses);
+
         /* Check if we should scan the shadow directory */
         if ((SearchShadow) && (Directory->DeviceMap))
         {
@@ -355,6 +464,16 @@ ObpDeleteEntryDirectory(POBP_LOOKUP_CONTEXT Context)
     AllocatedEntry = &Directory->HashBuckets[Context->HashIndex];
     CurrentEntry = *AllocatedEntry;
 
+    /*
+     * Removing a name can't make a remembered miss wrong, but the cached
+     * paths may go through this object.
+     */
+    if ((OBJECT_TO_OBJECT_HEADER(CurrentEntry->Object)->Type == ObpDirectoryObjectType) ||
+        (OBJECT_TO_OBJECT_HEADER(CurrentEntry->Object)->Type == ObpSymbolicLinkObjectType))
+    {
+        InterlockedIncrement(&ObpNamespaceGeneration);
+    }
+
     /* Unlink the Entry */
     *AllocatedEntry = CurrentEntry->ChainLink;
     CurrentEntry->ChainLink = NULL;
@@ -794,14 +913,14 @@ NtCreateDirectoryObject(OUT PHANDLE DirectoryHandle,
                             ObjectAttributes,
                             PreviousMode,
                             NULL,
-                            sizeof(OBJECT_DIRECTORY),
+                            sizeof(OBP_DIRECTORY),
                             0,
                             0,
                             (PVOID*)&Directory);
     if (!NT_SUCCESS(Status)) return Status;
 
     /* Setup the object */
-    RtlZeroMemory(Directory, sizeof(OBJECT_DIRECTORY));
+    RtlZeroMemory(Directory, sizeof(OBP_DIRECTORY));
     ExInitializePushLock(&Directory->Lock);
     Directory->SessionId = -1;
 
@@ -32,6 +32,13 @@ UNICODE_STRING ObpDosDevicesShortName =
 WCHAR ObpUnsecureGlobalNamesBuffer[128] = {0};
 ULONG ObpUnsecureGlobalNamesLength = sizeof(ObpUnsecureGlobalNamesBuffer);
 
+/* Directories resolved by previous lookups, valid for one namespace generation */
+OBP_PREFIX_ENTRY ObpPrefixCache[OBP_PREFIX_ENTRIES];
+EX_PUSH_LOCK ObpPrefixCacheLock;
+ULONG ObpPrefixCacheTick;
+volatile LONG ObpNamespaceGeneration;
+ULONG ObpPrefixCacheHits, ObpPrefixCacheMisses;
+
 /* PRIVATE FUNCTIONS *********************************************************/
 
 CODE_SEG("INIT")
@@ -441,6 +448,156 @@ ObpIsUnsecureName(IN PUNICODE_STRING ObjectName,
     return Unsecure;
 }
 
+POBJECT_DIRECTORY
+NTAPI
+ObpLookupPrefixCache(IN PUNICODE_STRING ObjectName,
+                     IN ULONG Attributes,
+                     OUT PUNICODE_STRING RemainingName)
+{
+    BOOLEAN CaseInsensitive = BooleanFlagOn(Attributes, OBJ_CASE_INSENSITIVE);
+    POBP_PREFIX_ENTRY Entry, BestEntry = NULL;
+    POBJECT_DIRECTORY Directory = NULL;
+    UNICODE_STRING Prefix, CachedPrefix;
+    USHORT PrefixLength = 0;
+    LONG Generation;
+    ULONG i;
+    PAGED_CODE();
+
+    /* Entries from an older namespace are useless */
+    Generation = ObpNamespaceGeneration;
+
+    KeEnterCriticalRegion();
+    ExAcquirePushLockShared(&ObpPrefixCacheLock);
+
+    /* Look for the longest directory path the name starts with */
+    for (i = 0; i < OBP_PREFIX_ENTRIES; i++)
+    {
+        Entry = &ObpPrefixCache[i];
+        if (!(Entry->Directory) ||
+            (Entry->Generation != Generation) ||
+            (Entry->CaseInsensitive != CaseInsensitive) ||
+            ((BestEntry) && (Entry->Length <= BestEntry->Length)))
+        {
+            continue;
+        }
+
+        /* The prefix must be followed by a separator and something else */
+        if ((Entry->Length + sizeof(WCHAR) >= ObjectName->Length) ||
+            (ObjectName->Buffer[Entry->Length / sizeof(WCHAR)] != OBJ_NAME_PATH_SEPARATOR))
+        {
+            continue;
+        }
+
+        Prefix.Buffer = ObjectName->Buffer;
+        Prefix.Length = Prefix.MaximumLength = Entry->Length;
+        CachedPrefix.Buffer = Entry->Name;
+        CachedPrefix.Length = CachedPrefix.MaximumLength = Entry->Length;
+        if (RtlEqualUnicodeString(&Prefix, &CachedPrefix, CaseInsensitive))
+        {
+            BestEntry = Entry;
+        }
+    }
+
+    /* Reference the directory before anyone can replace the entry */
+    if (BestEntry)
+    {
+        Directory = BestEntry->Directory;
+        PrefixLength = BestEntry->Length;
+        ObReferenceObject(Directory);
+        BestEntry->LastUse = ++ObpPrefixCacheTick;
+    }
+
+    ExReleasePushLockShared(&ObpPrefixCacheLock);
+    KeLeaveCriticalRegion();
+
+    if (!Directory)
+    {
+        InterlockedIncrement((PLONG)&ObpPrefixCacheMisses);
+        return NULL;
+    }
+
+    /* Return what is left to look up from there */
+    InterlockedIncrement((PLONG)&ObpPrefixCacheHits);
+    *RemainingName = *ObjectName;
+    RemainingName->Buffer += PrefixLength / sizeof(WCHAR);
+    RemainingName->Length -= PrefixLength;
+    RemainingName->MaximumLength -= PrefixLength;
+    return Directory;
+}
+
+VOID
+NTAPI
+ObpInsertPrefixCache(IN PUNICODE_STRING Prefix,
+                     IN ULONG Attributes,
+                     IN POBJECT_DIRECTORY Directory,
+                     IN LONG Generation)
+{
+    BOOLEAN CaseInsensitive = BooleanFlagOn(Attributes, OBJ_CASE_INSENSITIVE);
+    POBJECT_DIRECTORY StaleDirectories[OBP_PREFIX_ENTRIES];
+    POBP_PREFIX_ENTRY Entry, FreeEntry = NULL;
+    ULONG StaleCount = 0;
+    ULONG i;
+    PAGED_CODE();
+
+    /* Only short paths fit, and only if nothing changed while walking them */
+    if ((Prefix->Length > sizeof(Entry->Name)) ||
+        (Generation != ObpNamespaceGeneration))
+    {
+        return;
+    }
+
+    KeEnterCriticalRegion();
+    ExAcquirePushLockExclusive(&ObpPrefixCacheLock);
+
+    for (i = 0; i < OBP_PREFIX_ENTRIES; i++)
+    {
+        Entry = &ObpPrefixCache[i];
+
+        /* Drop the entries of older namespaces */
+        if ((Entry->Directory) && (Entry->Generation != Generation))
+        {
+            StaleDirectories[StaleCount++] = Entry->Directory;
+            Entry->Directory = NULL;
+        }
+
+        /* Someone else may have cached this path already */
+        if ((Entry->Directory == Directory) &&
+            (Entry->CaseInsensitive == CaseInsensitive) &&
+            (Entry->Length == Prefix->Length))
+        {
+            FreeEntry = NULL;
+            break;
+        }
+
+        /* Otherwise use a free entry, or the least recently used one */
+        if (!(FreeEntry) ||
+            ((FreeEntry->Directory) &&
+             (!(Entry->Directory) || (Entry->LastUse < FreeEntry->LastUse))))
+        {
+            FreeEntry = Entry;
+        }
+    }
+
+    if (FreeEntry)
+    {
+        if (FreeEntry->Directory) StaleDirectories[StaleCount++] = FreeEntry->Directory;
+
+        ObReferenceObject(Directory);
+        FreeEntry->Directory = Directory;
+        FreeEntry->Generation = Generation;
+        FreeEntry->LastUse = ++ObpPrefixCacheTick;
+        FreeEntry->Length = Prefix->Length;
+        FreeEntry->CaseInsensitive = CaseInsensitive;
+        RtlCopyMemory(FreeEntry->Name, Prefix->Buffer, Prefix->Length);
+    }
+
+    ExReleasePushLockExclusive(&ObpPrefixCacheLock);
+    KeLeaveCriticalRegion();
+
+    /* Release the directories we don't cache anymore */
+    for (i = 0; i < StaleCount; i++) ObDereferenceObject(StaleDirectories[i]);
+}
+
 NTSTATUS
 NTAPI
 ObpLookupObjectName(IN HANDLE RootHandle OPTIONAL,
@@ -469,7 +626,9 @@ ObpLookupObjectName(IN HANDLE RootHandle OPTIONAL,
     POBJECT_HEADER_NAME_INFO ObjectNameInfo;
     ULONG MaxReparse = 30;
     PDEVICE_MAP DeviceMap = NULL;
-    UNICODE_STRING LocalName;
+    UNICODE_STRING LocalName, Prefix;
+    BOOLEAN CachePrefix = FALSE, PrefixDescended = FALSE;
+    LONG PrefixGeneration = 0;
     PAGED_CODE();
     OBTRACE(OB_NAMESPACE_DEBUG,
             "%s - Finding Object: %wZ. Expecting: %p\n",
@@ -678,6 +837,8 @@ ObpLookupObjectName(IN HANDLE RootHandle OPTIONAL,
         {
 ParseFromRoot:
             LocalName = *ObjectName;
+            CachePrefix = FALSE;
+            PrefixDescended = FALSE;
 
             /* Deference the device map if we already have one */
             if (DeviceMap != NULL)
@@ -740,6 +901,22 @@ ParseFromRoot:
                     }
                 }
             }
+
+            /*
+             * Skip the directories a previous lookup already went through,
+             * unless each of them has to be checked for traverse access.
+             */
+            if (!(Directory) &&
+                ((AccessCheckMode == KernelMode) ||
+                 (AccessState->Flags & TOKEN_HAS_TRAVERSE_PRIVILEGE)))
+            {
+                CachePrefix = TRUE;
+                PrefixGeneration = ObpNamespaceGeneration;
+
+                /* Keep the directory referenced until we leave it */
+                Directory = ObpLookupPrefixCache(ObjectName, Attributes, &LocalName);
+                ReferencedParentDirectory = Directory;
+            }
         }
     }
 
@@ -852,6 +1029,22 @@ ParseFromRoot:
                                              Attributes,
                                              InsertObject ? FALSE : TRUE,
                                              LookupContext);
+
+            /* Remember the way to the last directory of the name */
+            if ((CachePrefix) &&
+                (PrefixDescended) &&
+                (!(RemainingName.Length) ||
+                 !(Object) ||
+                 (OBJECT_TO_OBJECT_HEADER(Object)->Type != ObpDirectoryObjectType)))
+            {
+                Prefix.Buffer = ObjectName->Buffer;
+                Prefix.Length = (USHORT)((ComponentName.Buffer - 1 - ObjectName->Buffer) *
+                                         sizeof(WCHAR));
+                Prefix.MaximumLength = Prefix.Length;
+                ObpInsertPrefixCache(&Prefix, Attributes, Directory, PrefixGeneration);
+                CachePrefix = FALSE;
+            }
+
             if (!Object)
             {
                 /* We didn't find it... do we still have a path? */
@@ -1143,6 +1336,9 @@ ReparseObject:
                         ParentDirectory = Directory;
                         Directory = Object;
                         ReferencedDirectory = NULL;
+
+                        /* This directory can now be cached for the name */
+                        PrefixDescended = TRUE;
                     }
                     else
                     {
@@ -1414,4 +1610,43 @@ ObQueryNameString(IN PVOID Object,
     return Status;
 }
 
+#if DBG && defined(KDBG)
+
+#include <kdbg/kdb.h>
+
+BOOLEAN
+ObpKdbgExtObCache(ULONG Argc, PCHAR Argv[])
+{
+    POBP_PREFIX_ENTRY Entry;
+    UNICODE_STRING Prefix;
+    ULONG i;
+
+    KdbpPrint("Negative entries:\t%lu hits\t%lu misses\n",
+              ObpNegativeCacheHits, ObpNegativeCacheMisses);
+    KdbpPrint("Prefixes:\t\t%lu hits\t%lu misses\n",
+              ObpPrefixCacheHits, ObpPrefixCacheMisses);
+    KdbpPrint("Namespace generation:\t%ld\n", ObpNamespaceGeneration);
+
+    KdbpPrint("Directory\tGeneration\tLastUse\tPrefix\n");
+    /* No need to lock the push lock here, we're in DBG */
+    for (i = 0; i < OBP_PREFIX_ENTRIES; i++)
+    {
+        Entry = &ObpPrefixCache[i];
+        if (!Entry->Directory) continue;
+
+        Prefix.Buffer = Entry->Name;
+        Prefix.Length = Prefix.MaximumLength = Entry->Length;
+        KdbpPrint("%p\t%ld%s\t%lu\t%wZ\n",
+                  Entry->Directory,
+                  Entry->Generation,
+                  Entry->Generation != ObpNamespaceGeneration ? " (stale)" : "",
+                  Entry->LastUse,
+                  &Prefix);
+    }
+
+    return TRUE;
+}
+
+#endif // DBG && KDBG
+
 /* EOF */
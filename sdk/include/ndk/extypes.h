@@ -1562,6 +1562,16 @@ typedef struct _SYSTEM_MEMORY_LIST_INFORMATION
     SIZE_T ModifiedPageCountPageFile;
 } SYSTEM_MEMORY_LIST_INFORMATION, *PSYSTEM_MEMORY_LIST_INFORMATION;
 
+//
+// Class 80, ReactOS extension returned when the buffer is large enough
+//
+typedef struct _SYSTEM_MEMORY_LIST_INFORMATION_EX
+{
+    SYSTEM_MEMORY_LIST_INFORMATION MemoryLists;
+    SIZE_T ZeroedPageHits;
+    SIZE_T ZeroedPageMisses;
+} SYSTEM_MEMORY_LIST_INFORMATION_EX, *PSYSTEM_MEMORY_LIST_INFORMATION_EX;
+
 //
 // Firmware variable attributes
 //
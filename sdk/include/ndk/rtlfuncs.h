@@ -3295,6 +3295,49 @@ RtlDecompressBuffer(
     _Out_ PULONG FinalUncompressedSize
 );
 
+_IRQL_requires_max_(APC_LEVEL)
+NTSYSAPI
+NTSTATUS
+NTAPI
+RtlDecompressFragment(
+    _In_ USHORT CompressionFormat,
+    _Out_writes_bytes_to_(UncompressedFragmentSize, *FinalUncompressedSize) PUCHAR UncompressedFragment,
+    _In_ ULONG UncompressedFragmentSize,
+    _In_reads_bytes_(CompressedBufferSize) PUCHAR CompressedBuffer,
+    _In_ ULONG CompressedBufferSize,
+    _In_range_(<, CompressedBufferSize) ULONG FragmentOffset,
+    _Out_ PULONG FinalUncompressedSize,
+    _In_ PVOID WorkSpace
+);
+
+_IRQL_requires_max_(APC_LEVEL)
+NTSYSAPI
+NTSTATUS
+NTAPI
+RtlCompressChunks(
+    _In_reads_bytes_(UncompressedBufferSize) PUCHAR UncompressedBuffer,
+    _In_ ULONG UncompressedBufferSize,
+    _Out_writes_bytes_(CompressedBufferSize) PUCHAR CompressedBuffer,
+    _In_ ULONG CompressedBufferSize,
+    _Inout_updates_bytes_(CompressedDataInfoLength) PCOMPRESSED_DATA_INFO CompressedDataInfo,
+    _In_ ULONG CompressedDataInfoLength,
+    _In_ PVOID WorkSpace
+);
+
+_IRQL_requires_max_(APC_LEVEL)
+NTSYSAPI
+NTSTATUS
+NTAPI
+RtlDecompressChunks(
+    _Out_writes_bytes_(UncompressedBufferSize) PUCHAR UncompressedBuffer,
+    _In_ ULONG UncompressedBufferSize,
+    _In_reads_bytes_(CompressedBufferSize) PUCHAR CompressedBuffer,
+    _In_ ULONG CompressedBufferSize,
+    _In_reads_bytes_(CompressedTailSize) PUCHAR CompressedTail,
+    _In_ ULONG CompressedTailSize,
+    _In_ PCOMPRESSED_DATA_INFO CompressedDataInfo
+);
+
 NTSYSAPI
 NTSTATUS
 NTAPI
@@ -5145,6 +5188,31 @@ RtlTryAcquireSRWLockExclusive(PRTL_SRWLOCK SRWLock);
 
 #endif /* Win7 or Reactos Ntdll build */
 
+//
+// Thread Pool Extensions
+//
+#if (_WIN32_WINNT >= _WIN32_WINNT_VISTA) || (DLL_EXPORT_VERSION >= _WIN32_WINNT_VISTA)
+NTSYSAPI
+NTSTATUS
+NTAPI
+TpQueryPoolStatistics(
+    _In_opt_ PTP_POOL Pool,
+    _Out_ PTP_POOL_STATISTICS Statistics);
+#endif
+
+//
+// Asks for the callbacks of the environment to be queued on the work queue
+// of the given processor. Workers of other processors may still steal them.
+//
+FORCEINLINE
+VOID
+TpSetCallbackAffinityHint(
+    _Inout_ PTP_CALLBACK_ENVIRON CallbackEnviron,
+    _In_ ULONG Processor)
+{
+    CallbackEnviron->u.s.Private = TP_CALLBACK_AFFINITY_TO_PRIVATE(Processor);
+}
+
 #endif // NTOS_MODE_USER
 
 NTSYSAPI
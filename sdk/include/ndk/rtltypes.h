@@ -2034,6 +2034,32 @@ struct _RTL_MEMORY_STREAM
     HANDLE ProcessHandle;
 };
 
+//
+// Thread Pool Extensions
+//
+
+//
+// The affinity hint lives in the private flag bits of the callback
+// environment, biased by one so that zero means no hint
+//
+#define TP_CALLBACK_AFFINITY_TO_PRIVATE(Processor)  (((Processor) + 1) & 0x3FFFFFFF)
+#define TP_CALLBACK_AFFINITY_FROM_PRIVATE(Private)  ((Private) - 1)
+
+//
+// Scheduler counters of a thread pool, see TpQueryPoolStatistics
+//
+typedef struct _TP_POOL_STATISTICS
+{
+    ULONG NumberOfQueues;
+    ULONG QueueDepth;
+    ULONG MaxQueueDepth;
+    ULONG Workers;
+    ULONG IdleWorkers;
+    ULONG BusyWorkers;
+    ULONG Steals;
+    ULONG Wakeups;
+} TP_POOL_STATISTICS, *PTP_POOL_STATISTICS;
+
 #endif /* NTOS_MODE_USER */
 
 #ifdef __cplusplus
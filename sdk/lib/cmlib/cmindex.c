@@ -689,6 +689,10 @@ CmpFindSubKeyByName(IN PHHIVE Hive,
     HCELL_INDEX SubKey, CellToRelease;
     ULONG Found;
 
+    /* Keys with many subkeys are looked up in the cache, if enabled */
+    if (CmpFindSubKeyInCache(Hive, Parent, SearchName, &SubKey))
+        return SubKey;
+
     /* Loop each storage type */
     for (i = 0; i < Hive->StorageTypeCount; i++)
     {
@@ -1472,6 +1476,7 @@ CmpAddSubKey(IN PHHIVE Hive,
     UNICODE_STRING Name;
     HCELL_INDEX IndexCell = HCELL_NIL, CellToRelease = HCELL_NIL, LeafCell;
     PHCELL_INDEX RootPointer = NULL;
+    PCM_SUBKEY_INDEX SubKeyIndex;
     ULONG Type, i;
     BOOLEAN IsCompressed;
     PAGED_CODE();
@@ -1531,6 +1536,9 @@ CmpAddSubKey(IN PHHIVE Hive,
         ASSERT(FALSE);
     }
 
+    /* Take its lookup index out of the cache while the lists change */
+    SubKeyIndex = CmpDetachSubKeyIndex(Hive, KeyNode);
+
     /* Find out the type of the cell, and check if this is the first subkey */
     Type = HvGetCellType(Child);
     if (!KeyNode->SubKeyCounts[Type])
@@ -1679,6 +1687,16 @@ CmpAddSubKey(IN PHHIVE Hive,
         KeyNode->SubKeyLists[Type] = LeafCell;
     }
 
+    /* Add the new subkey to the lookup index, if any */
+    if (SubKeyIndex)
+    {
+        CmpAttachSubKeyIndex(Hive,
+                             SubKeyIndex,
+                             KeyNode,
+                             Child,
+                             CmpComputeHashKey(0, &Name, FALSE));
+    }
+
     /* If the name was compressed, free our copy */
     if (IsCompressed) Hive->Free(Name.Buffer, 0);
 
@@ -1761,6 +1779,9 @@ CmpRemoveSubKey(IN PHHIVE Hive,
     ASSERT(HvIsCellDirty(Hive, ParentKey));
     HvReleaseCell(Hive, ParentKey);
 
+    /* Its lookup index would go stale */
+    CmpInvalidateSubKeyIndex(Hive, Node);
+
     /* Get the storage type and make sure it's not empty */
     Storage = HvGetCellType(TargetKey);
     ASSERT(Node->SubKeyCounts[Storage] != 0);
@@ -309,6 +309,35 @@ typedef struct _CM_USE_COUNT_LOG
     CM_USE_COUNT_LOG_ENTRY Log[32];
 } CM_USE_COUNT_LOG, *PCM_USE_COUNT_LOG;
 
+//
+// Subkey Lookup Cache
+//
+#define CM_SUBKEY_INDEX_MIN_KEYS    64  // Fewer subkeys are searched in the leaves
+#define CM_SUBKEY_INDEX_MAX         256 // Indexed keys per hive
+#define CM_SUBKEY_INDEX_BUCKETS     64
+
+typedef struct _CM_SUBKEY_INDEX_ENTRY
+{
+    HCELL_INDEX Cell;
+    ULONG HashKey;
+} CM_SUBKEY_INDEX_ENTRY, *PCM_SUBKEY_INDEX_ENTRY;
+
+typedef struct _CM_SUBKEY_INDEX
+{
+    struct _CM_SUBKEY_INDEX *Next;
+    HCELL_INDEX SubKeyLists[HTYPE_COUNT];   // Lists of the key when indexed
+    ULONG SubKeyCounts[HTYPE_COUNT];
+    ULONG Count;
+    ULONG Size;                             // Power of two
+    CM_SUBKEY_INDEX_ENTRY Table[ANYSIZE_ARRAY];
+} CM_SUBKEY_INDEX, *PCM_SUBKEY_INDEX;
+
+typedef struct _CM_SUBKEY_INDEX_CACHE
+{
+    ULONG Count;
+    PCM_SUBKEY_INDEX Buckets[CM_SUBKEY_INDEX_BUCKETS];
+} CM_SUBKEY_INDEX_CACHE, *PCM_SUBKEY_INDEX_CACHE;
+
 //
 // Configuration Manager Hive Structure
 //
@@ -724,6 +753,56 @@ CmpMarkIndexDirty(
     HCELL_INDEX TargetKey
 );
 
+LONG
+NTAPI
+CmpDoCompareKeyName(
+    IN PHHIVE Hive,
+    IN PCUNICODE_STRING SearchName,
+    IN HCELL_INDEX Cell
+);
+
+//
+// Subkey Lookup Cache Routines
+//
+BOOLEAN
+NTAPI
+CmpInitializeSubKeyIndex(
+    _Inout_ PHHIVE Hive);
+
+VOID
+NTAPI
+CmpDestroySubKeyIndex(
+    _Inout_ PHHIVE Hive);
+
+BOOLEAN
+NTAPI
+CmpFindSubKeyInCache(
+    _In_ PHHIVE Hive,
+    _In_ PCM_KEY_NODE Parent,
+    _In_ PCUNICODE_STRING SearchName,
+    _Out_ PHCELL_INDEX SubKey);
+
+PCM_SUBKEY_INDEX
+NTAPI
+CmpDetachSubKeyIndex(
+    _In_ PHHIVE Hive,
+    _In_ PCM_KEY_NODE Parent);
+
+VOID
+NTAPI
+CmpAttachSubKeyIndex(
+    _In_ PHHIVE Hive,
+    _In_opt_ PCM_SUBKEY_INDEX Index,
+    _In_ PCM_KEY_NODE Parent,
+    _In_ HCELL_INDEX Child,
+    _In_ ULONG HashKey);
+
+VOID
+NTAPI
+CmpInvalidateSubKeyIndex(
+    _In_ PHHIVE Hive,
+    _In_ PCM_KEY_NODE Parent);
+
 
 //
 // Name Functions
@@ -0,0 +1,548 @@
+/*
+ * PROJECT:     ReactOS Kernel
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Configuration Manager Library - Subkey Lookup Cache
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+/*
+ * Finding a subkey by name does a binary search over the leaves of the
+ * parent, and every name compare on the way maps a key node. For keys
+ * with many subkeys (CLSID, Enum and so on) the lookup cache keeps an
+ * in-memory hash table of the subkey name hashes instead, built from the
+ * leaves the first time the key is searched. A lookup then only maps the
+ * key nodes whose hash matches the searched name.
+ *
+ * An index remembers the subkey lists and counts of its key and is only
+ * used while they did not change. CmpAddSubKey() adds the new subkey to
+ * the index of its parent and CmpRemoveSubKey() throws the index away.
+ *
+ * The cache is not synchronized. The owner of the hive enables it only
+ * when lookups and changes to the hive are serialized.
+ */
+
+#include "cmlib.h"
+#define NDEBUG
+#include <debug.h>
+
+/* PRIVATE FUNCTIONS **********************************************************/
+
+static
+ULONG
+CmpGetSubKeyIndexBucket(
+    _In_ PCM_KEY_NODE Parent)
+{
+    return (Parent->SubKeyLists[Stable] ^
+            (Parent->SubKeyLists[Volatile] >> 3)) % CM_SUBKEY_INDEX_BUCKETS;
+}
+
+static
+BOOLEAN
+CmpIsSubKeyIndexOf(
+    _In_ PCM_SUBKEY_INDEX Index,
+    _In_ PCM_KEY_NODE Parent)
+{
+    ULONG i;
+
+    for (i = 0; i < HTYPE_COUNT; i++)
+    {
+        if (Index->SubKeyLists[i] != Parent->SubKeyLists[i] ||
+            Index->SubKeyCounts[i] != Parent->SubKeyCounts[i])
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+static
+ULONG
+CmpGetSubKeyIndexSlot(
+    _In_ PCM_SUBKEY_INDEX Index,
+    _In_ ULONG HashKey)
+{
+    /* The name hashes are poorly mixed in their low bits */
+    HashKey ^= HashKey >> 15;
+    HashKey *= 0x2C1B3C6D;
+    HashKey ^= HashKey >> 12;
+
+    return HashKey & (Index->Size - 1);
+}
+
+static
+PCM_SUBKEY_INDEX
+CmpAllocateSubKeyIndex(
+    _In_ PHHIVE Hive,
+    _In_ ULONG Count)
+{
+    PCM_SUBKEY_INDEX Index;
+    ULONG Size, i;
+
+    /* Keep the table at most half full */
+    for (Size = 2 * CM_SUBKEY_INDEX_MIN_KEYS; Size < 2 * Count; Size *= 2);
+
+    Index = Hive->Allocate(FIELD_OFFSET(CM_SUBKEY_INDEX, Table[Size]), TRUE, TAG_CM);
+    if (!Index) return NULL;
+
+    Index->Next = NULL;
+    Index->Count = 0;
+    Index->Size = Size;
+    for (i = 0; i < Size; i++)
+        Index->Table[i].Cell = HCELL_NIL;
+
+    return Index;
+}
+
+static
+VOID
+CmpInsertInSubKeyIndex(
+    _Inout_ PCM_SUBKEY_INDEX Index,
+    _In_ HCELL_INDEX Cell,
+    _In_ ULONG HashKey)
+{
+    ULONG Slot;
+
+    ASSERT(2 * Index->Count < Index->Size);
+
+    Slot = CmpGetSubKeyIndexSlot(Index, HashKey);
+    while (Index->Table[Slot].Cell != HCELL_NIL)
+        Slot = (Slot + 1) & (Index->Size - 1);
+
+    Index->Table[Slot].Cell = Cell;
+    Index->Table[Slot].HashKey = HashKey;
+    Index->Count++;
+}
+
+static
+VOID
+CmpLinkSubKeyIndex(
+    _In_ PHHIVE Hive,
+    _In_ PCM_SUBKEY_INDEX Index,
+    _In_ PCM_KEY_NODE Parent)
+{
+    PCM_SUBKEY_INDEX_CACHE Cache = Hive->SubKeyIndexCache;
+    PCM_SUBKEY_INDEX Next;
+    ULONG Bucket, i;
+
+    /* Start over when too many keys are indexed */
+    if (Cache->Count >= CM_SUBKEY_INDEX_MAX)
+    {
+        for (i = 0; i < CM_SUBKEY_INDEX_BUCKETS; i++)
+        {
+            while (Cache->Buckets[i])
+            {
+                Next = Cache->Buckets[i]->Next;
+                Hive->Free(Cache->Buckets[i], 0);
+                Cache->Buckets[i] = Next;
+            }
+        }
+        Cache->Count = 0;
+    }
+
+    for (i = 0; i < HTYPE_COUNT; i++)
+    {
+        Index->SubKeyLists[i] = Parent->SubKeyLists[i];
+        Index->SubKeyCounts[i] = Parent->SubKeyCounts[i];
+    }
+
+    Bucket = CmpGetSubKeyIndexBucket(Parent);
+    Index->Next = Cache->Buckets[Bucket];
+    Cache->Buckets[Bucket] = Index;
+    Cache->Count++;
+}
+
+static
+BOOLEAN
+CmpComputeKeyNodeHash(
+    _In_ PHHIVE Hive,
+    _In_ HCELL_INDEX Cell,
+    _Out_ PULONG HashKey)
+{
+    PCM_KEY_NODE Node;
+    UNICODE_STRING Name;
+    PUCHAR CompressedName;
+    ULONG Hash = 0, i;
+
+    Node = (PCM_KEY_NODE)HvGetCell(Hive, Cell);
+    if (!Node) return FALSE;
+
+    if (Node->Flags & KEY_COMP_NAME)
+    {
+        /* Same as CmpComputeHashKey() on the expanded name */
+        CompressedName = (PUCHAR)Node->Name;
+        for (i = 0; i < Node->NameLength; i++)
+            Hash = Hash * 37 + RtlUpcaseUnicodeChar(CompressedName[i]);
+    }
+    else
+    {
+        Name.Buffer = Node->Name;
+        Name.Length = Node->NameLength;
+        Name.MaximumLength = Name.Length;
+        Hash = CmpComputeHashKey(0, &Name, FALSE);
+    }
+
+    HvReleaseCell(Hive, Cell);
+    *HashKey = Hash;
+    return TRUE;
+}
+
+static
+BOOLEAN
+CmpAddLeafToSubKeyIndex(
+    _In_ PHHIVE Hive,
+    _Inout_ PCM_SUBKEY_INDEX Index,
+    _In_ PCM_KEY_INDEX Leaf)
+{
+    PCM_KEY_FAST_INDEX FastIndex = (PCM_KEY_FAST_INDEX)Leaf;
+    HCELL_INDEX Cell;
+    ULONG HashKey, i;
+
+    ASSERT((Leaf->Signature == CM_KEY_INDEX_LEAF) ||
+           (Leaf->Signature == CM_KEY_FAST_LEAF) ||
+           (Leaf->Signature == CM_KEY_HASH_LEAF));
+
+    for (i = 0; i < Leaf->Count; i++)
+    {
+        if (Leaf->Signature == CM_KEY_HASH_LEAF)
+        {
+            /* Hash leaves already have it */
+            Cell = FastIndex->List[i].Cell;
+            HashKey = FastIndex->List[i].HashKey;
+        }
+        else
+        {
+            if (Leaf->Signature == CM_KEY_FAST_LEAF)
+                Cell = FastIndex->List[i].Cell;
+            else
+                Cell = Leaf->List[i];
+
+            if (!CmpComputeKeyNodeHash(Hive, Cell, &HashKey))
+                return FALSE;
+        }
+
+        /* Do not trust the counts of a damaged hive */
+        if (2 * (Index->Count + 1) > Index->Size)
+            return FALSE;
+
+        CmpInsertInSubKeyIndex(Index, Cell, HashKey);
+    }
+
+    return TRUE;
+}
+
+static
+PCM_SUBKEY_INDEX
+CmpBuildSubKeyIndex(
+    _In_ PHHIVE Hive,
+    _In_ PCM_KEY_NODE Parent)
+{
+    PCM_SUBKEY_INDEX Index;
+    PCM_KEY_INDEX Root, Leaf;
+    HCELL_INDEX LeafCell;
+    ULONG Count = 0, i, j;
+    BOOLEAN Success = TRUE;
+
+    for (i = 0; i < Hive->StorageTypeCount; i++)
+        Count += Parent->SubKeyCounts[i];
+
+    /* Small keys are fast enough as they are */
+    if (Count < CM_SUBKEY_INDEX_MIN_KEYS) return NULL;
+
+    Index = CmpAllocateSubKeyIndex(Hive, Count);
+    if (!Index) return NULL;
+
+    for (i = 0; Success && i < Hive->StorageTypeCount; i++)
+    {
+        if (!Parent->SubKeyCounts[i]) continue;
+
+        Root = (PCM_KEY_INDEX)HvGetCell(Hive, Parent->SubKeyLists[i]);
+        if (!Root)
+        {
+            Success = FALSE;
+            break;
+        }
+
+        if (Root->Signature == CM_KEY_INDEX_ROOT)
+        {
+            for (j = 0; Success && j < Root->Count; j++)
+            {
+                LeafCell = Root->List[j];
+                Leaf = (PCM_KEY_INDEX)HvGetCell(Hive, LeafCell);
+                if (!Leaf)
+                {
+                    Success = FALSE;
+                    break;
+                }
+
+                Success = CmpAddLeafToSubKeyIndex(Hive, Index, Leaf);
+                HvReleaseCell(Hive, LeafCell);
+            }
+        }
+        else
+        {
+            Success = CmpAddLeafToSubKeyIndex(Hive, Index, Root);
+        }
+
+        HvReleaseCell(Hive, Parent->SubKeyLists[i]);
+    }
+
+    if (!Success)
+    {
+        DPRINT1("Cannot index the subkeys of a key with %lu subkeys\n", Count);
+        Hive->Free(Index, 0);
+        return NULL;
+    }
+
+    CmpLinkSubKeyIndex(Hive, Index, Parent);
+    return Index;
+}
+
+/* PUBLIC FUNCTIONS ***********************************************************/
+
+/**
+ * @brief
+ * Enables the subkey lookup cache of a hive.
+ *
+ * @param[in,out] Hive
+ * The hive. Lookups and changes to it must be serialized by the caller.
+ *
+ * @return
+ * TRUE if the cache is enabled, FALSE if there is not enough memory.
+ */
+BOOLEAN
+NTAPI
+CmpInitializeSubKeyIndex(
+    _Inout_ PHHIVE Hive)
+{
+    PCM_SUBKEY_INDEX_CACHE Cache;
+
+    if (Hive->SubKeyIndexCache) return TRUE;
+
+    Cache = Hive->Allocate(sizeof(*Cache), TRUE, TAG_CM);
+    if (!Cache) return FALSE;
+
+    RtlZeroMemory(Cache, sizeof(*Cache));
+    Hive->SubKeyIndexCache = Cache;
+    return TRUE;
+}
+
+/**
+ * @brief
+ * Disables the subkey lookup cache of a hive and frees all its indexes.
+ */
+VOID
+NTAPI
+CmpDestroySubKeyIndex(
+    _Inout_ PHHIVE Hive)
+{
+    PCM_SUBKEY_INDEX_CACHE Cache = Hive->SubKeyIndexCache;
+    PCM_SUBKEY_INDEX Index;
+    ULONG i;
+
+    if (!Cache) return;
+
+    for (i = 0; i < CM_SUBKEY_INDEX_BUCKETS; i++)
+    {
+        while (Cache->Buckets[i])
+        {
+            Index = Cache->Buckets[i];
+            Cache->Buckets[i] = Index->Next;
+            Hive->Free(Index, 0);
+        }
+    }
+
+    Hive->SubKeyIndexCache = NULL;
+    Hive->Free(Cache, 0);
+}
+
+/**
+ * @brief
+ * Looks up a subkey by name in the index of its parent, building the
+ * index first if needed.
+ *
+ * @param[in] Hive
+ * The hive of the parent key.
+ *
+ * @param[in] Parent
+ * The parent key node.
+ *
+ * @param[in] SearchName
+ * The name of the subkey.
+ *
+ * @param[out] SubKey
+ * The subkey cell, or HCELL_NIL if there is no such subkey.
+ *
+ * @return
+ * TRUE if the index answered the lookup, FALSE if the caller must search
+ * the leaves of the parent itself.
+ */
+BOOLEAN
+NTAPI
+CmpFindSubKeyInCache(
+    _In_ PHHIVE Hive,
+    _In_ PCM_KEY_NODE Parent,
+    _In_ PCUNICODE_STRING SearchName,
+    _Out_ PHCELL_INDEX SubKey)
+{
+    PCM_SUBKEY_INDEX Index;
+    PCM_SUBKEY_INDEX_ENTRY Entry;
+    ULONG HashKey, Slot;
+    LONG Result;
+
+    *SubKey = HCELL_NIL;
+
+    if (!Hive->SubKeyIndexCache) return FALSE;
+
+    for (Index = Hive->SubKeyIndexCache->Buckets[CmpGetSubKeyIndexBucket(Parent)];
+         Index != NULL;
+         Index = Index->Next)
+    {
+        if (CmpIsSubKeyIndexOf(Index, Parent)) break;
+    }
+
+    if (!Index)
+    {
+        Index = CmpBuildSubKeyIndex(Hive, Parent);
+        if (!Index) return FALSE;
+    }
+
+    HashKey = CmpComputeHashKey(0, SearchName, FALSE);
+
+    for (Slot = CmpGetSubKeyIndexSlot(Index, HashKey);
+         Index->Table[Slot].Cell != HCELL_NIL;
+         Slot = (Slot + 1) & (Index->Size - 1))
+    {
+        Entry = &Index->Table[Slot];
+        if (Entry->HashKey != HashKey) continue;
+
+        Result = CmpDoCompareKeyName(Hive, SearchName, Entry->Cell);
+        if (Result == 2) return TRUE;
+        if (Result == 0)
+        {
+            *SubKey = Entry->Cell;
+            return TRUE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief
+ * Takes the index of a key out of the cache before a subkey is added.
+ *
+ * @return
+ * The index to give to CmpAttachSubKeyIndex() once the subkey is added,
+ * or NULL if the key is not indexed.
+ */
+PCM_SUBKEY_INDEX
+NTAPI
+CmpDetachSubKeyIndex(
+    _In_ PHHIVE Hive,
+    _In_ PCM_KEY_NODE Parent)
+{
+    PCM_SUBKEY_INDEX_CACHE Cache = Hive->SubKeyIndexCache;
+    PCM_SUBKEY_INDEX *Link;
+    PCM_SUBKEY_INDEX Index;
+
+    if (!Cache) return NULL;
+
+    for (Link = &Cache->Buckets[CmpGetSubKeyIndexBucket(Parent)];
+         *Link != NULL;
+         Link = &(*Link)->Next)
+    {
+        Index = *Link;
+        if (CmpIsSubKeyIndexOf(Index, Parent))
+        {
+            *Link = Index->Next;
+            Cache->Count--;
+            return Index;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief
+ * Adds a new subkey to an index taken out by CmpDetachSubKeyIndex() and
+ * puts it back in the cache, with the new subkey lists of the key.
+ *
+ * @param[in] Index
+ * The detached index, if any.
+ *
+ * @param[in] Parent
+ * The parent key node, with the subkey already added.
+ *
+ * @param[in] Child
+ * The new subkey cell.
+ *
+ * @param[in] HashKey
+ * The hash of the name of the new subkey.
+ */
+VOID
+NTAPI
+CmpAttachSubKeyIndex(
+    _In_ PHHIVE Hive,
+    _In_opt_ PCM_SUBKEY_INDEX Index,
+    _In_ PCM_KEY_NODE Parent,
+    _In_ HCELL_INDEX Child,
+    _In_ ULONG HashKey)
+{
+    PCM_SUBKEY_INDEX NewIndex;
+    ULONG i;
+
+    if (!Index) return;
+
+    /* The cache may have been disabled in between */
+    if (!Hive->SubKeyIndexCache)
+    {
+        Hive->Free(Index, 0);
+        return;
+    }
+
+    if (2 * (Index->Count + 1) > Index->Size)
+    {
+        NewIndex = CmpAllocateSubKeyIndex(Hive, Index->Count + 1);
+        if (!NewIndex)
+        {
+            Hive->Free(Index, 0);
+            return;
+        }
+
+        for (i = 0; i < Index->Size; i++)
+        {
+            if (Index->Table[i].Cell != HCELL_NIL)
+            {
+                CmpInsertInSubKeyIndex(NewIndex,
+                                       Index->Table[i].Cell,
+                                       Index->Table[i].HashKey);
+            }
+        }
+
+        Hive->Free(Index, 0);
+        Index = NewIndex;
+    }
+
+    CmpInsertInSubKeyIndex(Index, Child, HashKey);
+    CmpLinkSubKeyIndex(Hive, Index, Parent);
+}
+
+/**
+ * @brief
+ * Frees the index of a key, if it has one.
+ */
+VOID
+NTAPI
+CmpInvalidateSubKeyIndex(
+    _In_ PHHIVE Hive,
+    _In_ PCM_KEY_NODE Parent)
+{
+    PCM_SUBKEY_INDEX Index;
+
+    Index = CmpDetachSubKeyIndex(Hive, Parent);
+    if (Index) Hive->Free(Index, 0);
+}
+
+/* EOF */
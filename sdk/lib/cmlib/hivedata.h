@@ -355,6 +355,9 @@ typedef struct _HHIVE
     ULONG StorageTypeCount;
     ULONG Version;
     DUAL Storage[HTYPE_COUNT];
+
+    /* ReactOS-specific: in-memory subkey lookup cache, see cmlookup.c */
+    struct _CM_SUBKEY_INDEX_CACHE *SubKeyIndexCache;
 } HHIVE, *PHHIVE;
 
 #define IsFreeCell(Cell)    ((Cell)->Size >= 0)
@@ -1512,6 +1512,8 @@ CMAPI
 HvFree(
     _In_ PHHIVE RegistryHive)
 {
+    CmpDestroySubKeyIndex(RegistryHive);
+
     if (!RegistryHive->ReadOnly)
     {
         /* Release hive bitmap */
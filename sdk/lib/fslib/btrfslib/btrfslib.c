@@ -41,6 +41,7 @@
 #include "btrfs.h"
 #include "btrfsioctl.h"
 #include "crc32c.h"
+#include "csum.h"
 #include "xxhash.h"
 #else
 #include <stringapiset.h>
@@ -48,6 +49,7 @@
 #include "../btrfs.h"
 #include "../btrfsioctl.h"
 #include "../crc32c.h"
+#include "../csum.h"
 #include "../xxhash.h"
 
 #if defined(_X86_) || defined(_AMD64_)
@@ -64,12 +66,6 @@
 #define free(ptr)       RtlFreeHeap(RtlGetProcessHeap(), 0, (ptr))
 #endif
 
-#define SHA256_HASH_SIZE 32
-void calc_sha256(uint8_t* hash, const void* input, size_t len);
-
-#define BLAKE2_HASH_SIZE 32
-void blake2b(void *out, size_t outlen, const void* in, size_t inlen);
-
 #ifndef __REACTOS__
 #define FSCTL_LOCK_VOLUME               CTL_CODE(FILE_DEVICE_FILE_SYSTEM,  6, METHOD_BUFFERED, FILE_ANY_ACCESS)
 #define FSCTL_UNLOCK_VOLUME             CTL_CODE(FILE_DEVICE_FILE_SYSTEM,  7, METHOD_BUFFERED, FILE_ANY_ACCESS)
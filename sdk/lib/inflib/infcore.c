@@ -132,6 +132,7 @@ InfpFreeSection (PINFCACHESECTION Section)
       Section->FirstLine = InfpFreeLine (Section->FirstLine);
     }
   Section->LastLine = NULL;
+  Section->FoundLine = NULL;
 
   FREE (Section);
 
@@ -293,12 +294,17 @@ InfpFindLineById(PINFCACHESECTION Section, UINT Id)
 {
     PINFCACHELINE Line;
 
-    for (Line = Section->FirstLine;
-         Line != NULL;
-         Line = Line->Next)
+    /* Lines are looked up one after the other, and their ids grow
+     * along the list, so continue from the last line found */
+    Line = Section->FoundLine;
+    if (Line == NULL || Line->Id > Id)
+        Line = Section->FirstLine;
+
+    for (; Line != NULL; Line = Line->Next)
     {
         if (Line->Id == Id)
         {
+            Section->FoundLine = Line;
             return Line;
         }
     }
@@ -48,6 +48,7 @@ typedef struct _INFCACHESECTION
 
   PINFCACHELINE FirstLine;
   PINFCACHELINE LastLine;
+  PINFCACHELINE FoundLine;  /* Last line found by its id */
   UINT Id;
 
   LONG LineCount;
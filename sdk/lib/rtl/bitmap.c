@@ -18,6 +18,10 @@
 #undef ASSERT
 #define ASSERT(...)
 
+#ifdef _M_AMD64
+#include <emmintrin.h>
+#endif
+
 #ifdef USE_RTL_BITMAP64
 #define _BITCOUNT 64
 #define MAXINDEX 0xFFFFFFFFFFFFFFFF
@@ -50,6 +54,7 @@ typedef ULONG64 BITMAP_BUFFER, *PBITMAP_BUFFER;
 #define RtlFindClearBits RtlFindClearBits64
 #define RtlFindSetBits RtlFindSetBits64
 #define RtlFindClearBitsAndSet RtlFindClearBitsAndSet64
+#define RtlFindClearBitsAndSetNextFit RtlFindClearBitsAndSetNextFit64
 #define RtlFindSetBitsAndClear RtlFindSetBitsAndClear64
 #define RtlFindNextForwardRunClear RtlFindNextForwardRunClear64
 #define RtlFindNextForwardRunSet RtlFindNextForwardRunSet64
@@ -94,6 +99,74 @@ BitCountTable[256] =
 
 /* PRIVATE FUNCTIONS ********************************************************/
 
+/*
+ * Returns the first word in [Buffer, MaxBuffer) that is not equal to Pattern,
+ * or MaxBuffer. Pattern must be all zeros or all ones. On amd64 the XMM
+ * registers are available in kernel mode, so long stretches are compared
+ * 64 bytes at a time.
+ */
+static __inline
+PBITMAP_BUFFER
+RtlpSkipWords(
+    _In_ PBITMAP_BUFFER Buffer,
+    _In_ PBITMAP_BUFFER MaxBuffer,
+    _In_ BITMAP_BUFFER Pattern)
+{
+#ifdef _M_AMD64
+    __m128i Compare, Equal;
+    PBITMAP_BUFFER MaxBlock;
+
+    /* Get to a 16 byte boundary first */
+    while (Buffer < MaxBuffer && ((ULONG_PTR)Buffer & 15))
+    {
+        if (*Buffer != Pattern)
+            return Buffer;
+        Buffer++;
+    }
+
+    if (MaxBuffer - Buffer >= 64 / sizeof(BITMAP_BUFFER))
+    {
+        Compare = _mm_set1_epi32((int)Pattern);
+        MaxBlock = MaxBuffer - 64 / sizeof(BITMAP_BUFFER);
+
+        while (Buffer <= MaxBlock)
+        {
+            Equal = _mm_and_si128(
+                _mm_and_si128(_mm_cmpeq_epi32(_mm_load_si128((__m128i*)Buffer), Compare),
+                              _mm_cmpeq_epi32(_mm_load_si128((__m128i*)Buffer + 1), Compare)),
+                _mm_and_si128(_mm_cmpeq_epi32(_mm_load_si128((__m128i*)Buffer + 2), Compare),
+                              _mm_cmpeq_epi32(_mm_load_si128((__m128i*)Buffer + 3), Compare)));
+
+            /* Let the word loop below find the exact position */
+            if (_mm_movemask_epi8(Equal) != 0xFFFF)
+                break;
+
+            Buffer += 64 / sizeof(BITMAP_BUFFER);
+        }
+    }
+#endif
+
+    while (Buffer < MaxBuffer && *Buffer == Pattern)
+    {
+        Buffer++;
+    }
+
+    return Buffer;
+}
+
+/* Counts the set bits of a word without a lookup table */
+static __inline
+BITMAP_INDEX
+RtlpCountSetBits(
+    _In_ BITMAP_BUFFER Value)
+{
+    Value = Value - ((Value >> 1) & (BITMAP_BUFFER)0x5555555555555555ULL);
+    Value = (Value & (BITMAP_BUFFER)0x3333333333333333ULL) +
+            ((Value >> 2) & (BITMAP_BUFFER)0x3333333333333333ULL);
+    Value = (Value + (Value >> 4)) & (BITMAP_BUFFER)0x0F0F0F0F0F0F0F0FULL;
+    return (BITMAP_INDEX)((Value * (BITMAP_BUFFER)0x0101010101010101ULL) >> (_BITCOUNT - 8));
+}
+
 static __inline
 BITMAP_INDEX
 RtlpGetLengthOfRunClear(
@@ -121,9 +194,11 @@ RtlpGetLengthOfRunClear(
     Value = *Buffer++ >> BitPos << BitPos;
 
     /* Skip all clear ULONGs */
-    while (Value == 0 && Buffer < MaxBuffer)
+    if (Value == 0)
     {
-        Value = *Buffer++;
+        Buffer = RtlpSkipWords(Buffer, MaxBuffer, 0);
+        if (Buffer < MaxBuffer)
+            Value = *Buffer++;
     }
 
     /* Did we reach the end? */
@@ -175,9 +250,11 @@ RtlpGetLengthOfRunSet(
     InvValue = ~(*Buffer++) >> BitPos << BitPos;
 
     /* Skip all set ULONGs */
-    while (InvValue == 0 && Buffer < MaxBuffer)
+    if (InvValue == 0)
     {
-        InvValue = ~(*Buffer++);
+        Buffer = RtlpSkipWords(Buffer, MaxBuffer, MAXINDEX);
+        if (Buffer < MaxBuffer)
+            InvValue = ~(*Buffer++);
     }
 
     /* Did we reach the end? */
@@ -203,6 +280,123 @@ RtlpGetLengthOfRunSet(
 }
 
 
+/*
+ * Returns the first index at or after StartingIndex where a run of Length bits
+ * fits below EndingIndex, or MAXINDEX. A run is made of the bits that are set
+ * in (Buffer ^ Invert), so Invert is MAXINDEX for clear runs and 0 for set
+ * runs. Runs inside a word are found by and-ing the word with shifted copies
+ * of itself, only runs crossing a word boundary are carried over.
+ */
+static
+BITMAP_INDEX
+RtlpFindRun(
+    _In_ PRTL_BITMAP BitMapHeader,
+    _In_ BITMAP_INDEX StartingIndex,
+    _In_ BITMAP_INDEX EndingIndex,
+    _In_ BITMAP_INDEX Length,
+    _In_ BITMAP_BUFFER Invert)
+{
+    BITMAP_INDEX Index, RunStart = 0, RunLength = 0, Bits, Shift, BitPos;
+    BITMAP_BUFFER Value, Mask, Starts;
+    PBITMAP_BUFFER Buffer, LastBuffer, NextBuffer;
+
+    ASSERT(EndingIndex <= BitMapHeader->SizeOfBitMap);
+    if (StartingIndex >= EndingIndex || EndingIndex - StartingIndex < Length)
+        return MAXINDEX;
+
+    /* Calculate positions, never read past the word holding the last bit */
+    Buffer = BitMapHeader->Buffer + StartingIndex / _BITCOUNT;
+    LastBuffer = BitMapHeader->Buffer + (EndingIndex - 1) / _BITCOUNT;
+    Index = StartingIndex & ~(BITMAP_INDEX)(_BITCOUNT - 1);
+
+    /* Bits before the start don't belong to any run */
+    Mask = MAXINDEX << (StartingIndex & (_BITCOUNT - 1));
+
+    while (TRUE)
+    {
+        Value = (*Buffer ^ Invert) & Mask;
+
+        /* Neither do bits at or past the end */
+        if (Buffer == LastBuffer && (EndingIndex & (_BITCOUNT - 1)))
+            Value &= ~(MAXINDEX << (EndingIndex & (_BITCOUNT - 1)));
+
+        if (Value == MAXINDEX)
+        {
+            /* The whole word extends the current run */
+            if (!RunLength)
+                RunStart = Index;
+            RunLength += _BITCOUNT;
+            if (RunLength >= Length)
+                return RunStart;
+
+            /* Skip over the full words the run still needs */
+            if (Buffer != LastBuffer)
+            {
+                NextBuffer = Buffer + 1 + (Length - RunLength) / _BITCOUNT;
+                NextBuffer = RtlpSkipWords(Buffer + 1, min(NextBuffer, LastBuffer), ~Invert);
+                RunLength += (BITMAP_INDEX)(NextBuffer - Buffer - 1) * _BITCOUNT;
+                Index += (BITMAP_INDEX)(NextBuffer - Buffer - 1) * _BITCOUNT;
+                Buffer = NextBuffer - 1;
+                if (RunLength >= Length)
+                    return RunStart;
+            }
+        }
+        else if (Value == 0)
+        {
+            /* No run here, skip the following words without one as well */
+            RunLength = 0;
+            if (Buffer != LastBuffer)
+            {
+                NextBuffer = RtlpSkipWords(Buffer + 1, LastBuffer, Invert);
+                Index += (BITMAP_INDEX)(NextBuffer - Buffer - 1) * _BITCOUNT;
+                Buffer = NextBuffer - 1;
+            }
+        }
+        else
+        {
+            /* Does the run from the previous word end here with enough bits? */
+            if (RunLength)
+            {
+                BitScanForward(&BitPos, ~Value);
+                if (RunLength + BitPos >= Length)
+                    return RunStart;
+            }
+
+            /* Look for a run inside the word */
+            if (Length < _BITCOUNT)
+            {
+                Starts = Value;
+                for (Bits = 1; Bits < Length; Bits += Shift)
+                {
+                    Shift = min(Bits, Length - Bits);
+                    Starts &= Starts >> Shift;
+                }
+
+                if (Starts)
+                {
+                    BitScanForward(&BitPos, Starts);
+                    return Index + BitPos;
+                }
+            }
+
+            /* Remember the run reaching into the next word */
+            BitScanReverse(&BitPos, ~Value);
+            RunLength = (_BITCOUNT - 1) - BitPos;
+            RunStart = Index + BitPos + 1;
+        }
+
+        if (Buffer == LastBuffer)
+            break;
+
+        Buffer++;
+        Index += _BITCOUNT;
+        Mask = MAXINDEX;
+    }
+
+    return MAXINDEX;
+}
+
+
 /* PUBLIC FUNCTIONS **********************************************************/
 
 #ifndef USE_RTL_BITMAP64
@@ -474,22 +668,24 @@ NTAPI
 RtlNumberOfSetBits(
     _In_ PRTL_BITMAP BitMapHeader)
 {
-    PUCHAR Byte, MaxByte;
+    PBITMAP_BUFFER Buffer, MaxBuffer;
     BITMAP_INDEX BitCount = 0;
-    ULONG Shift;
+    ULONG Bits;
 
-    Byte = (PUCHAR)BitMapHeader->Buffer;
-    MaxByte = Byte + BitMapHeader->SizeOfBitMap / 8;
+    Buffer = BitMapHeader->Buffer;
+    MaxBuffer = Buffer + BitMapHeader->SizeOfBitMap / _BITCOUNT;
 
-    while (Byte < MaxByte)
+    /* Count whole words at once */
+    while (Buffer < MaxBuffer)
     {
-        BitCount += BitCountTable[*Byte++];
+        BitCount += RtlpCountSetBits(*Buffer++);
     }
 
-    if (BitMapHeader->SizeOfBitMap & 7)
+    /* Only count the valid bits of the last word */
+    Bits = BitMapHeader->SizeOfBitMap & (_BITCOUNT - 1);
+    if (Bits)
     {
-        Shift = 8 - (BitMapHeader->SizeOfBitMap & 7);
-        BitCount += BitCountTable[((*Byte) << Shift) & 0xFF];
+        BitCount += RtlpCountSetBits(*Buffer & ~(MAXINDEX << Bits));
     }
 
     return BitCount;
@@ -511,7 +707,7 @@ RtlFindClearBits(
     _In_ BITMAP_INDEX NumberToFind,
     _In_ BITMAP_INDEX HintIndex)
 {
-    BITMAP_INDEX CurrentBit, Margin, CurrentLength;
+    BITMAP_INDEX Index;
 
     /* Check for valid parameters */
     if (!BitMapHeader || NumberToFind > BitMapHeader->SizeOfBitMap)
@@ -529,47 +725,25 @@ RtlFindClearBits(
         return HintIndex & ~7;
     }
 
-    /* First margin is end of bitmap */
-    Margin = BitMapHeader->SizeOfBitMap;
-
-retry:
-    /* Start with hint index, length is 0 */
-    CurrentBit = HintIndex;
-
-    /* Loop until something is found or the end is reached */
-    while (CurrentBit + NumberToFind < Margin)
-    {
-        /* Search for the next clear run, by skipping a set run */
-        CurrentBit += RtlpGetLengthOfRunSet(BitMapHeader,
-                                            CurrentBit,
-                                            MAXINDEX);
-
-        /* Get length of the clear bit run */
-        CurrentLength = RtlpGetLengthOfRunClear(BitMapHeader,
-                                                CurrentBit,
-                                                NumberToFind);
-
-        /* Is this long enough? */
-        if (CurrentLength >= NumberToFind)
-        {
-            /* It is */
-            return CurrentBit;
-        }
-
-        CurrentBit += CurrentLength;
-    }
+    /* Search from the hint to the end of the bitmap */
+    Index = RtlpFindRun(BitMapHeader,
+                        HintIndex,
+                        BitMapHeader->SizeOfBitMap,
+                        NumberToFind,
+                        MAXINDEX);
 
     /* Did we start at a hint? */
-    if (HintIndex)
+    if (Index == MAXINDEX && HintIndex)
     {
-        /* Retry at the start */
-        Margin = min(HintIndex + NumberToFind, BitMapHeader->SizeOfBitMap);
-        HintIndex = 0;
-        goto retry;
+        /* Retry at the start, with the runs that begin before the hint */
+        Index = RtlpFindRun(BitMapHeader,
+                            0,
+                            min(HintIndex + NumberToFind - 1, BitMapHeader->SizeOfBitMap),
+                            NumberToFind,
+                            MAXINDEX);
     }
 
-    /* Nothing found */
-    return MAXINDEX;
+    return Index;
 }
 
 BITMAP_INDEX
@@ -579,7 +753,7 @@ RtlFindSetBits(
     _In_ BITMAP_INDEX NumberToFind,
     _In_ BITMAP_INDEX HintIndex)
 {
-    BITMAP_INDEX CurrentBit, Margin, CurrentLength;
+    BITMAP_INDEX Index;
 
     /* Check for valid parameters */
     if (!BitMapHeader || NumberToFind > BitMapHeader->SizeOfBitMap)
@@ -597,47 +771,25 @@ RtlFindSetBits(
         return HintIndex & ~7;
     }
 
-    /* First margin is end of bitmap */
-    Margin = BitMapHeader->SizeOfBitMap;
-
-retry:
-    /* Start with hint index, length is 0 */
-    CurrentBit = HintIndex;
-
-    /* Loop until something is found or the end is reached */
-    while (CurrentBit + NumberToFind <= Margin)
-    {
-        /* Search for the next set run, by skipping a clear run */
-        CurrentBit += RtlpGetLengthOfRunClear(BitMapHeader,
-                                              CurrentBit,
-                                              MAXINDEX);
-
-        /* Get length of the set bit run */
-        CurrentLength = RtlpGetLengthOfRunSet(BitMapHeader,
-                                              CurrentBit,
-                                              NumberToFind);
-
-        /* Is this long enough? */
-        if (CurrentLength >= NumberToFind)
-        {
-            /* It is */
-            return CurrentBit;
-        }
-
-        CurrentBit += CurrentLength;
-    }
+    /* Search from the hint to the end of the bitmap */
+    Index = RtlpFindRun(BitMapHeader,
+                        HintIndex,
+                        BitMapHeader->SizeOfBitMap,
+                        NumberToFind,
+                        0);
 
     /* Did we start at a hint? */
-    if (HintIndex)
+    if (Index == MAXINDEX && HintIndex)
     {
-        /* Retry at the start */
-        Margin = min(HintIndex + NumberToFind, BitMapHeader->SizeOfBitMap);
-        HintIndex = 0;
-        goto retry;
+        /* Retry at the start, with the runs that begin before the hint */
+        Index = RtlpFindRun(BitMapHeader,
+                            0,
+                            min(HintIndex + NumberToFind - 1, BitMapHeader->SizeOfBitMap),
+                            NumberToFind,
+                            0);
     }
 
-    /* Nothing found */
-    return MAXINDEX;
+    return Index;
 }
 
 BITMAP_INDEX
@@ -663,6 +815,36 @@ RtlFindClearBitsAndSet(
     return Position;
 }
 
+/*
+ * Next fit allocation: the search starts where the previous one ended and
+ * the cursor is moved past the bits that were found, so callers handing out
+ * many small ranges don't rescan the allocated start of the bitmap each time.
+ */
+BITMAP_INDEX
+NTAPI
+RtlFindClearBitsAndSetNextFit(
+    _In_ PRTL_BITMAP BitMapHeader,
+    _In_ BITMAP_INDEX NumberToFind,
+    _Inout_ PBITMAP_INDEX NextFitIndex)
+{
+    BITMAP_INDEX Position;
+
+    /* Try to find clear bits, starting at the cursor */
+    Position = RtlFindClearBitsAndSet(BitMapHeader, NumberToFind, *NextFitIndex);
+
+    /* Did we get something? */
+    if (Position != MAXINDEX)
+    {
+        /* Yes, continue behind it next time */
+        *NextFitIndex = Position + NumberToFind;
+        if (*NextFitIndex >= BitMapHeader->SizeOfBitMap)
+            *NextFitIndex = 0;
+    }
+
+    /* Return what we found */
+    return Position;
+}
+
 BITMAP_INDEX
 NTAPI
 RtlFindSetBitsAndClear(
@@ -873,7 +1055,7 @@ RtlFindClearRuns(
             for (Run = 0; Run < SizeOfRunArray; Run++)
             {
                 /*Is this the new smallest run? */
-                if (NumberOfBits < RunArray[SmallestRun].NumberOfBits)
+                if (RunArray[Run].NumberOfBits < RunArray[SmallestRun].NumberOfBits)
                 {
                     /* Set it as new smallest run */
                     SmallestRun = Run;
@@ -882,7 +1064,7 @@ RtlFindClearRuns(
         }
 
         /* Advance bits */
-        FromIndex += NumberOfBits;
+        FromIndex = StartingIndex + NumberOfBits;
     }
 
     return Run;
@@ -915,7 +1097,7 @@ RtlFindLongestRunClear(
         }
 
         /* Advance bits */
-        FromIndex += NumberOfBits;
+        FromIndex = Index + NumberOfBits;
     }
 
     return MaxNumberOfBits;
@@ -948,7 +1130,7 @@ RtlFindLongestRunSet(
         }
 
         /* Advance bits */
-        FromIndex += NumberOfBits;
+        FromIndex = Index + NumberOfBits;
     }
 
     return MaxNumberOfBits;
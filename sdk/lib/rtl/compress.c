@@ -10,7 +10,7 @@
 
 /* INCLUDES *****************************************************************/
 
-#include <rtl.h>
+#include "compress.h"
 
 #define NDEBUG
 #include <debug.h>
@@ -25,6 +25,90 @@
 
 /* FUNCTIONS ****************************************************************/
 
+VOID
+NTAPI
+RtlpLzInitializeMatchFinder(OUT PRTLP_LZ_MATCH_FINDER Finder,
+                            IN PUCHAR Buffer,
+                            IN PVOID WorkSpace,
+                            IN ULONG HashBits,
+                            IN ULONG WindowBits,
+                            IN ULONG MaxOffset,
+                            IN ULONG MaxChain,
+                            IN ULONG NiceLength)
+{
+    /* The chain only stores 16-bit distances within the window */
+    ASSERT(MaxOffset <= MAXUSHORT);
+    ASSERT(MaxOffset <= (1UL << WindowBits));
+
+    Finder->Buffer = Buffer;
+    Finder->Head = WorkSpace;
+    Finder->Chain = (PUSHORT)(Finder->Head + (1UL << HashBits));
+    Finder->HashShift = 32 - HashBits;
+    Finder->ChainMask = (1UL << WindowBits) - 1;
+    Finder->MaxOffset = MaxOffset;
+    Finder->MaxChain = MaxChain;
+    Finder->NiceLength = NiceLength;
+
+    /* Only the heads need clearing, the chain is written before it is read */
+    RtlZeroMemory(Finder->Head, sizeof(ULONG) << HashBits);
+}
+
+/* Must be called before Position itself is inserted */
+ULONG
+NTAPI
+RtlpLzFindMatch(IN PRTLP_LZ_MATCH_FINDER Finder,
+                IN ULONG Position,
+                IN ULONG MaxLength,
+                OUT PULONG Offset)
+{
+    PUCHAR Current = Finder->Buffer + Position;
+    PUCHAR Candidate;
+    ULONG Head, Distance, Step, Length;
+    ULONG BestLength = RTLP_LZ_MIN_MATCH - 1;
+    ULONG ChainLeft = Finder->MaxChain;
+
+    if (MaxLength < RTLP_LZ_MIN_MATCH)
+        return 0;
+
+    Head = Finder->Head[RtlpLzHash(Finder, Position)];
+    if (!Head)
+        return 0;
+
+    Distance = Position - (Head - 1);
+    while (Distance <= Finder->MaxOffset && ChainLeft--)
+    {
+        Candidate = Current - Distance;
+
+        /* Check the byte that would make this one better first */
+        if (Candidate[BestLength] == Current[BestLength] &&
+            Candidate[0] == Current[0] &&
+            Candidate[1] == Current[1])
+        {
+            for (Length = 2; Length < MaxLength; Length++)
+            {
+                if (Candidate[Length] != Current[Length])
+                    break;
+            }
+
+            if (Length > BestLength)
+            {
+                BestLength = Length;
+                *Offset = Distance;
+                if (Length >= Finder->NiceLength || Length == MaxLength)
+                    break;
+            }
+        }
+
+        Step = Finder->Chain[(Position - Distance) & Finder->ChainMask];
+        if (!Step)
+            break;
+        Distance += Step;
+    }
+
+    return (BestLength >= RTLP_LZ_MIN_MATCH) ? BestLength : 0;
+}
+
+
 /* Based on Wine Staging */
 
 /* decompress a single LZNT1 chunk */
@@ -216,35 +300,198 @@ out:
 }
 
 
-static NTSTATUS
-RtlpCompressBufferLZNT1(UCHAR *src, ULONG src_size, UCHAR *dst, ULONG dst_size,
-                        ULONG chunk_size, ULONG *final_size, UCHAR *workspace)
+/*
+ * LZNT1 chunks hold up to 4K of data and are compressed independently, so
+ * the match finder starts over for every chunk. The split between the offset
+ * and the length of a back reference depends on the position inside the
+ * chunk: the offset gets just enough bits to reach the chunk start.
+ */
+#define LZNT1_CHUNK_SIZE        0x1000
+#define LZNT1_HASH_BITS         12
+#define LZNT1_WINDOW_BITS       12
+
+#define LZNT1_STANDARD_CHAIN    8
+#define LZNT1_STANDARD_NICE     32
+#define LZNT1_MAXIMUM_CHAIN     256
+#define LZNT1_MAXIMUM_NICE      LZNT1_CHUNK_SIZE
+
+#define LZNT1_WORKSPACE_SIZE    RTLP_LZ_WORKSPACE_SIZE(LZNT1_HASH_BITS, LZNT1_WINDOW_BITS)
+
+static
+ULONG
+RtlpLznt1DisplacementBits(IN ULONG Position)
+{
+    ULONG Bits = 4;
+
+    while (Bits < 12 && Position > (1UL << Bits))
+        Bits++;
+
+    return Bits;
+}
+
+static
+ULONG
+RtlpLznt1MaxLength(IN ULONG Position, IN ULONG Size)
 {
-        UCHAR *src_cur = src, *src_end = src + src_size;
-        UCHAR *dst_cur = dst, *dst_end = dst + dst_size;
-        ULONG block_size;
+    ULONG MaxLength = (1UL << (16 - RtlpLznt1DisplacementBits(Position))) + 2;
 
-        while (src_cur < src_end)
+    return min(MaxLength, Size - Position);
+}
+
+/*
+ * Compresses one chunk into Output. Returns the size of the chunk data, or 0
+ * if it would not fit into OutputSize bytes.
+ */
+static
+ULONG
+RtlpCompressChunkLZNT1(IN PRTLP_LZ_MATCH_FINDER Finder,
+                       IN PUCHAR Chunk,
+                       IN ULONG ChunkSize,
+                       OUT PUCHAR Output,
+                       IN ULONG OutputSize,
+                       IN BOOLEAN Lazy)
+{
+    ULONG Position = 0, Inserted = 0, OutPos = 0, FlagPos = 0, FlagBit = 8;
+    ULONG Length, Offset, NextLength, NextOffset, Bits;
+    USHORT Code;
+
+    Finder->Buffer = Chunk;
+    RtlZeroMemory(Finder->Head, sizeof(ULONG) << LZNT1_HASH_BITS);
+
+    while (Position < ChunkSize)
+    {
+        /* Every position before the search point must be in the chains */
+        while (Inserted < Position && Inserted + RTLP_LZ_MIN_MATCH <= ChunkSize)
+            RtlpLzInsert(Finder, Inserted++);
+
+        Length = RtlpLzFindMatch(Finder, Position, RtlpLznt1MaxLength(Position, ChunkSize), &Offset);
+
+        /* Defer the match while the next position offers a longer one */
+        while (Lazy && Length && Length < Finder->NiceLength &&
+               Position + 1 + RTLP_LZ_MIN_MATCH <= ChunkSize)
         {
-            /* determine size of current chunk */
-            block_size = min(0x1000, src_end - src_cur);
-            if (dst_cur + sizeof(WORD) + block_size > dst_end)
-                return STATUS_BUFFER_TOO_SMALL;
+            RtlpLzInsert(Finder, Position);
+            Inserted = Position + 1;
 
-            /* write (uncompressed) chunk header */
-            *(WORD *)dst_cur = 0x3000 | (block_size - 1);
-            dst_cur += sizeof(WORD);
+            NextLength = RtlpLzFindMatch(Finder, Position + 1,
+                                         RtlpLznt1MaxLength(Position + 1, ChunkSize), &NextOffset);
+            if (NextLength <= Length)
+                break;
 
-            /* write chunk content */
-            memcpy(dst_cur, src_cur, block_size);
-            dst_cur += block_size;
-            src_cur += block_size;
+            /* Emit the current byte as a literal */
+            if (FlagBit == 8)
+            {
+                if (OutPos >= OutputSize)
+                    return 0;
+                FlagPos = OutPos++;
+                Output[FlagPos] = 0;
+                FlagBit = 0;
+            }
+            if (OutPos >= OutputSize)
+                return 0;
+            Output[OutPos++] = Chunk[Position++];
+            FlagBit++;
+
+            Length = NextLength;
+            Offset = NextOffset;
+        }
+
+        if (FlagBit == 8)
+        {
+            if (OutPos >= OutputSize)
+                return 0;
+            FlagPos = OutPos++;
+            Output[FlagPos] = 0;
+            FlagBit = 0;
+        }
+
+        if (Length)
+        {
+            if (OutPos + sizeof(USHORT) > OutputSize)
+                return 0;
+
+            Bits = RtlpLznt1DisplacementBits(Position);
+            Code = (USHORT)(((Offset - 1) << (16 - Bits)) | (Length - RTLP_LZ_MIN_MATCH));
+            Output[OutPos++] = (UCHAR)Code;
+            Output[OutPos++] = (UCHAR)(Code >> 8);
+            Output[FlagPos] |= (UCHAR)(1 << FlagBit);
+            Position += Length;
+        }
+        else
+        {
+            if (OutPos >= OutputSize)
+                return 0;
+            Output[OutPos++] = Chunk[Position++];
+        }
+        FlagBit++;
+    }
+
+    return OutPos;
+}
+
+static NTSTATUS
+RtlpCompressBufferLZNT1(USHORT Engine,
+                        PUCHAR UncompressedBuffer,
+                        ULONG UncompressedBufferSize,
+                        PUCHAR CompressedBuffer,
+                        ULONG CompressedBufferSize,
+                        PULONG FinalCompressedSize,
+                        PVOID WorkSpace)
+{
+    RTLP_LZ_MATCH_FINDER Finder;
+    PUCHAR Input = UncompressedBuffer;
+    PUCHAR InputEnd = UncompressedBuffer + UncompressedBufferSize;
+    PUCHAR Output = CompressedBuffer;
+    PUCHAR OutputEnd = CompressedBuffer + CompressedBufferSize;
+    ULONG BlockSize, Room, Size, Header;
+    BOOLEAN Lazy = (Engine == COMPRESSION_ENGINE_MAXIMUM);
+
+    if (!WorkSpace)
+        return STATUS_INVALID_PARAMETER;
+
+    RtlpLzInitializeMatchFinder(&Finder,
+                                UncompressedBuffer,
+                                WorkSpace,
+                                LZNT1_HASH_BITS,
+                                LZNT1_WINDOW_BITS,
+                                LZNT1_CHUNK_SIZE,
+                                Lazy ? LZNT1_MAXIMUM_CHAIN : LZNT1_STANDARD_CHAIN,
+                                Lazy ? LZNT1_MAXIMUM_NICE : LZNT1_STANDARD_NICE);
+
+    while (Input < InputEnd)
+    {
+        BlockSize = min(LZNT1_CHUNK_SIZE, (ULONG)(InputEnd - Input));
+        if (OutputEnd - Output < (LONG_PTR)sizeof(USHORT))
+            return STATUS_BUFFER_TOO_SMALL;
+
+        /* Only keep the compressed form if it is smaller than the data */
+        Room = min((ULONG)(OutputEnd - Output) - sizeof(USHORT), BlockSize - 1);
+        Size = RtlpCompressChunkLZNT1(&Finder, Input, BlockSize,
+                                      Output + sizeof(USHORT), Room, Lazy);
+        if (Size)
+        {
+            Header = 0xB000 | (Size - 1);
         }
+        else
+        {
+            Size = BlockSize;
+            if ((ULONG)(OutputEnd - Output) - sizeof(USHORT) < Size)
+                return STATUS_BUFFER_TOO_SMALL;
 
-        if (final_size)
-            *final_size = dst_cur - dst;
+            Header = 0x3000 | (Size - 1);
+            RtlCopyMemory(Output + sizeof(USHORT), Input, Size);
+        }
 
-        return STATUS_SUCCESS;
+        Output[0] = (UCHAR)Header;
+        Output[1] = (UCHAR)(Header >> 8);
+        Output += sizeof(USHORT) + Size;
+        Input += BlockSize;
+    }
+
+    if (FinalCompressedSize)
+        *FinalCompressedSize = (ULONG)(Output - CompressedBuffer);
+
+    return STATUS_SUCCESS;
 }
 
 
@@ -255,14 +502,14 @@ RtlpWorkSpaceSizeLZNT1(USHORT Engine,
 {
    if (Engine == COMPRESSION_ENGINE_STANDARD)
    {
-      *BufferAndWorkSpaceSize = 0x8010;
-      *FragmentWorkSpaceSize = 0x1000;
+      *BufferAndWorkSpaceSize = LZNT1_WORKSPACE_SIZE;
+      *FragmentWorkSpaceSize = LZNT1_CHUNK_SIZE;
       return(STATUS_SUCCESS);
    }
    else if (Engine == COMPRESSION_ENGINE_MAXIMUM)
    {
-      *BufferAndWorkSpaceSize = 0x10;
-      *FragmentWorkSpaceSize = 0x1000;
+      *BufferAndWorkSpaceSize = LZNT1_WORKSPACE_SIZE;
+      *FragmentWorkSpaceSize = LZNT1_CHUNK_SIZE;
       return(STATUS_SUCCESS);
    }
 
@@ -284,27 +531,63 @@ RtlCompressBuffer(IN USHORT CompressionFormatAndEngine,
                   IN PVOID WorkSpace)
 {
    USHORT Format = CompressionFormatAndEngine & COMPRESSION_FORMAT_MASK;
-   /* USHORT Engine = CompressionFormatAndEngine & COMPRESSION_ENGINE_MASK; */
+   USHORT Engine = CompressionFormatAndEngine & COMPRESSION_ENGINE_MASK;
 
    if ((Format == COMPRESSION_FORMAT_NONE) ||
          (Format == COMPRESSION_FORMAT_DEFAULT))
       return(STATUS_INVALID_PARAMETER);
 
    if (Format == COMPRESSION_FORMAT_LZNT1)
-      return(RtlpCompressBufferLZNT1(UncompressedBuffer,
+      return(RtlpCompressBufferLZNT1(Engine,
+                                     UncompressedBuffer,
                                      UncompressedBufferSize,
                                      CompressedBuffer,
                                      CompressedBufferSize,
-                                     UncompressedChunkSize,
                                      FinalCompressedSize,
                                      WorkSpace));
 
+   if (Format == COMPRESSION_FORMAT_XPRESS)
+      return(RtlpCompressBufferXpress(Engine,
+                                      UncompressedBuffer,
+                                      UncompressedBufferSize,
+                                      CompressedBuffer,
+                                      CompressedBufferSize,
+                                      FinalCompressedSize,
+                                      WorkSpace));
+
+   if (Format == COMPRESSION_FORMAT_XPRESS_HUFF)
+      return(RtlpCompressBufferXpressHuff(Engine,
+                                          UncompressedBuffer,
+                                          UncompressedBufferSize,
+                                          CompressedBuffer,
+                                          CompressedBufferSize,
+                                          FinalCompressedSize,
+                                          WorkSpace));
+
    return(STATUS_UNSUPPORTED_COMPRESSION);
 }
 
 
 /*
- * @unimplemented
+ * Chunks are compressed independently of each other, so callers can hand
+ * separate chunks to separate workers and describe the result with one
+ * COMPRESSED_DATA_INFO. A chunk of zeros takes no space and a chunk that does
+ * not shrink is stored as is.
+ */
+static BOOLEAN
+RtlpIsBufferZero(PUCHAR Buffer, ULONG Size)
+{
+    while (Size--)
+    {
+        if (*Buffer++)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/*
+ * @implemented
  */
 NTSTATUS NTAPI
 RtlCompressChunks(IN PUCHAR UncompressedBuffer,
@@ -315,12 +598,66 @@ RtlCompressChunks(IN PUCHAR UncompressedBuffer,
                   IN ULONG CompressedDataInfoLength,
                   IN PVOID WorkSpace)
 {
-    UNIMPLEMENTED;
-    return STATUS_NOT_IMPLEMENTED;
+    ULONG ChunkSize, ChunkCount, BlockSize, Room, Size, i;
+    PUCHAR Output = CompressedBuffer;
+    NTSTATUS Status;
+
+    if (CompressedDataInfo->ChunkShift < 9 || CompressedDataInfo->ChunkShift > 16)
+        return STATUS_INVALID_PARAMETER;
+
+    ChunkSize = 1UL << CompressedDataInfo->ChunkShift;
+    ChunkCount = (UncompressedBufferSize + ChunkSize - 1) >> CompressedDataInfo->ChunkShift;
+    if (ChunkCount > MAXUSHORT ||
+        CompressedDataInfoLength < FIELD_OFFSET(COMPRESSED_DATA_INFO, CompressedChunkSizes) +
+                                   ChunkCount * sizeof(ULONG))
+    {
+        return STATUS_BUFFER_TOO_SMALL;
+    }
+
+    for (i = 0; i < ChunkCount; i++)
+    {
+        BlockSize = min(ChunkSize, UncompressedBufferSize - (i << CompressedDataInfo->ChunkShift));
+        Room = CompressedBufferSize - (ULONG)(Output - CompressedBuffer);
+
+        if (RtlpIsBufferZero(UncompressedBuffer, BlockSize))
+        {
+            Size = 0;
+        }
+        else
+        {
+            Status = RtlCompressBuffer(CompressedDataInfo->CompressionFormatAndEngine,
+                                       UncompressedBuffer,
+                                       BlockSize,
+                                       Output,
+                                       min(Room, BlockSize),
+                                       ChunkSize,
+                                       &Size,
+                                       WorkSpace);
+            if (Status != STATUS_BUFFER_TOO_SMALL && !NT_SUCCESS(Status))
+                return Status;
+
+            /* A chunk as large as its data is stored uncompressed */
+            if (!NT_SUCCESS(Status) || Size >= BlockSize)
+            {
+                if (Room < BlockSize)
+                    return STATUS_BUFFER_TOO_SMALL;
+
+                RtlCopyMemory(Output, UncompressedBuffer, BlockSize);
+                Size = BlockSize;
+            }
+        }
+
+        CompressedDataInfo->CompressedChunkSizes[i] = Size;
+        Output += Size;
+        UncompressedBuffer += BlockSize;
+    }
+
+    CompressedDataInfo->NumberOfChunks = (USHORT)ChunkCount;
+    return STATUS_SUCCESS;
 }
 
 /*
- * @unimplemented
+ * @implemented
  */
 NTSTATUS NTAPI
 RtlDecompressChunks(OUT PUCHAR UncompressedBuffer,
@@ -331,8 +668,63 @@ RtlDecompressChunks(OUT PUCHAR UncompressedBuffer,
                     IN ULONG CompressedTailSize,
                     IN PCOMPRESSED_DATA_INFO CompressedDataInfo)
 {
-    UNIMPLEMENTED;
-    return STATUS_NOT_IMPLEMENTED;
+    ULONG ChunkSize, BlockSize, Size, FinalSize, i;
+    NTSTATUS Status;
+
+    if (CompressedDataInfo->ChunkShift < 9 || CompressedDataInfo->ChunkShift > 16)
+        return STATUS_INVALID_PARAMETER;
+
+    ChunkSize = 1UL << CompressedDataInfo->ChunkShift;
+
+    for (i = 0; i < CompressedDataInfo->NumberOfChunks && UncompressedBufferSize; i++)
+    {
+        BlockSize = min(ChunkSize, UncompressedBufferSize);
+        Size = CompressedDataInfo->CompressedChunkSizes[i];
+
+        /* Once the buffer is used up, the data goes on in the tail */
+        if (Size > CompressedBufferSize)
+        {
+            if (CompressedBufferSize)
+                return STATUS_BAD_COMPRESSION_BUFFER;
+
+            CompressedBuffer = CompressedTail;
+            CompressedBufferSize = CompressedTailSize;
+            CompressedTailSize = 0;
+            if (Size > CompressedBufferSize)
+                return STATUS_BAD_COMPRESSION_BUFFER;
+        }
+
+        if (Size == 0)
+        {
+            RtlZeroMemory(UncompressedBuffer, BlockSize);
+        }
+        else if (Size == BlockSize)
+        {
+            RtlCopyMemory(UncompressedBuffer, CompressedBuffer, BlockSize);
+        }
+        else
+        {
+            Status = RtlDecompressBuffer(CompressedDataInfo->CompressionFormatAndEngine,
+                                         UncompressedBuffer,
+                                         BlockSize,
+                                         CompressedBuffer,
+                                         Size,
+                                         &FinalSize);
+            if (!NT_SUCCESS(Status))
+                return Status;
+
+            /* Short chunks end in zeros */
+            if (FinalSize < BlockSize)
+                RtlZeroMemory(UncompressedBuffer + FinalSize, BlockSize - FinalSize);
+        }
+
+        CompressedBuffer += Size;
+        CompressedBufferSize -= Size;
+        UncompressedBuffer += BlockSize;
+        UncompressedBufferSize -= BlockSize;
+    }
+
+    return STATUS_SUCCESS;
 }
 
 /*
@@ -357,6 +749,19 @@ RtlDecompressFragment(IN USHORT format,
             return lznt1_decompress(uncompressed, uncompressed_size, compressed,
                                     compressed_size, offset, final_size, workspace);
 
+        /* These streams have no independent chunks to seek to */
+        case COMPRESSION_FORMAT_XPRESS:
+            if (offset)
+                return STATUS_UNSUPPORTED_COMPRESSION;
+            return RtlpDecompressBufferXpress(uncompressed, uncompressed_size, compressed,
+                                              compressed_size, final_size);
+
+        case COMPRESSION_FORMAT_XPRESS_HUFF:
+            if (offset)
+                return STATUS_UNSUPPORTED_COMPRESSION;
+            return RtlpDecompressBufferXpressHuff(uncompressed, uncompressed_size, compressed,
+                                                  compressed_size, final_size);
+
         case COMPRESSION_FORMAT_NONE:
         case COMPRESSION_FORMAT_DEFAULT:
             return STATUS_INVALID_PARAMETER;
@@ -417,6 +822,13 @@ RtlGetCompressionWorkSpaceSize(IN USHORT CompressionFormatAndEngine,
                                     CompressBufferAndWorkSpaceSize,
                                     CompressFragmentWorkSpaceSize));
 
+   if ((Format == COMPRESSION_FORMAT_XPRESS) ||
+         (Format == COMPRESSION_FORMAT_XPRESS_HUFF))
+      return(RtlpWorkSpaceSizeXpress(Format,
+                                     Engine,
+                                     CompressBufferAndWorkSpaceSize,
+                                     CompressFragmentWorkSpaceSize));
+
    return(STATUS_UNSUPPORTED_COMPRESSION);
 }
 
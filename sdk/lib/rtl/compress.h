@@ -0,0 +1,233 @@
+/*
+ * PROJECT:     ReactOS Runtime Library
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Internal definitions shared by the compression engines
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#pragma once
+
+#ifdef RTL_COMPRESS_HOST
+    #include <typedefs.h>
+    #include <stdio.h>
+    #include <string.h>
+
+    #define FORCEINLINE static __inline
+
+    #ifndef min
+    #define min(a, b)  (((a) < (b)) ? (a) : (b))
+    #endif
+
+    // Definitions copied from <ntstatus.h>
+    // We only want to include host headers, so we define them manually
+    #define STATUS_SUCCESS                   ((NTSTATUS)0x00000000)
+    #define STATUS_BUFFER_ALL_ZEROS          ((NTSTATUS)0x00000117)
+    #define STATUS_NOT_IMPLEMENTED           ((NTSTATUS)0xC0000002)
+    #define STATUS_ACCESS_VIOLATION          ((NTSTATUS)0xC0000005)
+    #define STATUS_INVALID_PARAMETER         ((NTSTATUS)0xC000000D)
+    #define STATUS_BUFFER_TOO_SMALL          ((NTSTATUS)0xC0000023)
+    #define STATUS_NOT_SUPPORTED             ((NTSTATUS)0xC00000BB)
+    #define STATUS_BAD_COMPRESSION_BUFFER    ((NTSTATUS)0xC0000242)
+    #define STATUS_UNSUPPORTED_COMPRESSION   ((NTSTATUS)0xC000025F)
+
+    // Definitions copied from <ntifs.h>
+    #define COMPRESSION_FORMAT_NONE          (0x0000)
+    #define COMPRESSION_FORMAT_DEFAULT       (0x0001)
+    #define COMPRESSION_FORMAT_LZNT1         (0x0002)
+    #define COMPRESSION_FORMAT_XPRESS        (0x0003)
+    #define COMPRESSION_FORMAT_XPRESS_HUFF   (0x0004)
+    #define COMPRESSION_ENGINE_STANDARD      (0x0000)
+    #define COMPRESSION_ENGINE_MAXIMUM       (0x0100)
+    #define COMPRESSION_ENGINE_HIBER         (0x0200)
+
+    typedef struct _COMPRESSED_DATA_INFO
+    {
+        USHORT CompressionFormatAndEngine;
+        UCHAR CompressionUnitShift;
+        UCHAR ChunkShift;
+        UCHAR ClusterShift;
+        UCHAR Reserved;
+        USHORT NumberOfChunks;
+        ULONG CompressedChunkSizes[ANYSIZE_ARRAY];
+    } COMPRESSED_DATA_INFO, *PCOMPRESSED_DATA_INFO;
+
+    NTSTATUS NTAPI
+    RtlCompressBuffer(
+        IN USHORT CompressionFormatAndEngine,
+        IN PUCHAR UncompressedBuffer,
+        IN ULONG UncompressedBufferSize,
+        OUT PUCHAR CompressedBuffer,
+        IN ULONG CompressedBufferSize,
+        IN ULONG UncompressedChunkSize,
+        OUT PULONG FinalCompressedSize,
+        IN PVOID WorkSpace);
+
+    NTSTATUS NTAPI
+    RtlDecompressBuffer(
+        IN USHORT CompressionFormat,
+        OUT PUCHAR UncompressedBuffer,
+        IN ULONG UncompressedBufferSize,
+        IN PUCHAR CompressedBuffer,
+        IN ULONG CompressedBufferSize,
+        OUT PULONG FinalUncompressedSize);
+
+    NTSTATUS NTAPI
+    RtlDecompressFragment(
+        IN USHORT format,
+        OUT PUCHAR uncompressed,
+        IN ULONG uncompressed_size,
+        IN PUCHAR compressed,
+        IN ULONG compressed_size,
+        IN ULONG offset,
+        OUT PULONG final_size,
+        IN PVOID workspace);
+
+    NTSTATUS NTAPI
+    RtlCompressChunks(
+        IN PUCHAR UncompressedBuffer,
+        IN ULONG UncompressedBufferSize,
+        OUT PUCHAR CompressedBuffer,
+        IN ULONG CompressedBufferSize,
+        IN OUT PCOMPRESSED_DATA_INFO CompressedDataInfo,
+        IN ULONG CompressedDataInfoLength,
+        IN PVOID WorkSpace);
+
+    NTSTATUS NTAPI
+    RtlDecompressChunks(
+        OUT PUCHAR UncompressedBuffer,
+        IN ULONG UncompressedBufferSize,
+        IN PUCHAR CompressedBuffer,
+        IN ULONG CompressedBufferSize,
+        IN PUCHAR CompressedTail,
+        IN ULONG CompressedTailSize,
+        IN PCOMPRESSED_DATA_INFO CompressedDataInfo);
+
+    NTSTATUS NTAPI
+    RtlGetCompressionWorkSpaceSize(
+        IN USHORT CompressionFormatAndEngine,
+        OUT PULONG CompressBufferAndWorkSpaceSize,
+        OUT PULONG CompressFragmentWorkSpaceSize);
+#else
+    #include <rtl.h>
+#endif
+
+/*
+ * Hash chain match finder. The caller provides the memory, the heads are
+ * positions + 1 (0 is an empty bucket) and the chain stores, for every
+ * position of the sliding window, the distance back to the previous position
+ * with the same hash (0 ends the chain).
+ */
+#define RTLP_LZ_MIN_MATCH   3
+
+typedef struct _RTLP_LZ_MATCH_FINDER
+{
+    PUCHAR Buffer;
+    PULONG Head;
+    PUSHORT Chain;
+    ULONG HashShift;
+    ULONG ChainMask;
+    ULONG MaxOffset;
+    ULONG MaxChain;
+    ULONG NiceLength;
+} RTLP_LZ_MATCH_FINDER, *PRTLP_LZ_MATCH_FINDER;
+
+#define RTLP_LZ_WORKSPACE_SIZE(HashBits, WindowBits) \
+    ((sizeof(ULONG) << (HashBits)) + (sizeof(USHORT) << (WindowBits)))
+
+FORCEINLINE
+ULONG
+RtlpLzHash(
+    IN PRTLP_LZ_MATCH_FINDER Finder,
+    IN ULONG Position)
+{
+    PUCHAR Data = Finder->Buffer + Position;
+
+    return ((Data[0] | (Data[1] << 8) | (Data[2] << 16)) * 0x9E3779B1) >> Finder->HashShift;
+}
+
+VOID
+NTAPI
+RtlpLzInitializeMatchFinder(
+    OUT PRTLP_LZ_MATCH_FINDER Finder,
+    IN PUCHAR Buffer,
+    IN PVOID WorkSpace,
+    IN ULONG HashBits,
+    IN ULONG WindowBits,
+    IN ULONG MaxOffset,
+    IN ULONG MaxChain,
+    IN ULONG NiceLength);
+
+ULONG
+NTAPI
+RtlpLzFindMatch(
+    IN PRTLP_LZ_MATCH_FINDER Finder,
+    IN ULONG Position,
+    IN ULONG MaxLength,
+    OUT PULONG Offset);
+
+/* Needs RTLP_LZ_MIN_MATCH readable bytes at Position */
+FORCEINLINE
+VOID
+RtlpLzInsert(
+    IN PRTLP_LZ_MATCH_FINDER Finder,
+    IN ULONG Position)
+{
+    ULONG Hash = RtlpLzHash(Finder, Position);
+    ULONG Previous = Finder->Head[Hash];
+    ULONG Distance = 0;
+
+    if (Previous && (Position - (Previous - 1)) <= Finder->MaxOffset)
+        Distance = Position - (Previous - 1);
+
+    Finder->Chain[Position & Finder->ChainMask] = (USHORT)Distance;
+    Finder->Head[Hash] = Position + 1;
+}
+
+/* xpress.c */
+NTSTATUS
+NTAPI
+RtlpCompressBufferXpress(
+    IN USHORT Engine,
+    IN PUCHAR UncompressedBuffer,
+    IN ULONG UncompressedBufferSize,
+    OUT PUCHAR CompressedBuffer,
+    IN ULONG CompressedBufferSize,
+    OUT PULONG FinalCompressedSize,
+    IN PVOID WorkSpace);
+
+NTSTATUS
+NTAPI
+RtlpDecompressBufferXpress(
+    OUT PUCHAR UncompressedBuffer,
+    IN ULONG UncompressedBufferSize,
+    IN PUCHAR CompressedBuffer,
+    IN ULONG CompressedBufferSize,
+    OUT PULONG FinalUncompressedSize);
+
+NTSTATUS
+NTAPI
+RtlpCompressBufferXpressHuff(
+    IN USHORT Engine,
+    IN PUCHAR UncompressedBuffer,
+    IN ULONG UncompressedBufferSize,
+    OUT PUCHAR CompressedBuffer,
+    IN ULONG CompressedBufferSize,
+    OUT PULONG FinalCompressedSize,
+    IN PVOID WorkSpace);
+
+NTSTATUS
+NTAPI
+RtlpDecompressBufferXpressHuff(
+    OUT PUCHAR UncompressedBuffer,
+    IN ULONG UncompressedBufferSize,
+    IN PUCHAR CompressedBuffer,
+    IN ULONG CompressedBufferSize,
+    OUT PULONG FinalUncompressedSize);
+
+NTSTATUS
+NTAPI
+RtlpWorkSpaceSizeXpress(
+    IN USHORT Format,
+    IN USHORT Engine,
+    OUT PULONG BufferAndWorkSpaceSize,
+    OUT PULONG FragmentWorkSpaceSize);
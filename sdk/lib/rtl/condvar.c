@@ -14,6 +14,7 @@
 /* INCLUDES ******************************************************************/
 
 #include <rtl_vista.h>
+#include "srw.h"
 
 #define NDEBUG
 #include <debug.h>
@@ -32,6 +33,8 @@ typedef struct _COND_VAR_WAIT_ENTRY
     LIST_ENTRY ListEntry;
     PVOID WaitKey;
     BOOLEAN ListRemovalHandled;
+    /* Links the entries a waker has taken off the list */
+    struct _COND_VAR_WAIT_ENTRY *NextWake;
 } COND_VAR_WAIT_ENTRY, * PCOND_VAR_WAIT_ENTRY;
 
 #define CONTAINING_COND_VAR_WAIT_ENTRY(address, field) \
@@ -39,7 +42,7 @@ typedef struct _COND_VAR_WAIT_ENTRY
 
 /* GLOBALS *******************************************************************/
 
-static HANDLE CondVarKeyedEventHandle = NULL;
+HANDLE CondVarKeyedEventHandle = NULL;
 
 /* INTERNAL FUNCTIONS ********************************************************/
 
@@ -110,7 +113,7 @@ InternalLockCondVar(IN OUT PRTL_CONDITION_VARIABLE ConditionVariable,
                clear or we're asked to abort. */
             YieldProcessor();
 
-            if ((AbortIfLocked != NULL) && *AbortIfLocked)
+            if ((AbortIfLocked != NULL) && *(volatile BOOLEAN *)AbortIfLocked)
             {
                 /* The caller wants us to abort in this case. */
                 return NULL;
@@ -265,7 +268,8 @@ InternalWake(IN OUT PRTL_CONDITION_VARIABLE ConditionVariable,
     PCOND_VAR_WAIT_ENTRY CONST HeadEntry = InternalLockCondVar(ConditionVariable, NULL, NULL);
     PCOND_VAR_WAIT_ENTRY Entry;
     PCOND_VAR_WAIT_ENTRY NextEntry;
-    LARGE_INTEGER Timeout;
+    PCOND_VAR_WAIT_ENTRY WakeList;
+    PCOND_VAR_WAIT_ENTRY *WakeListTail;
     PCOND_VAR_WAIT_ENTRY RemoveOnUnlockEntry;
 
     ASSERT(CondVarKeyedEventHandle != NULL);
@@ -277,18 +281,17 @@ InternalWake(IN OUT PRTL_CONDITION_VARIABLE ConditionVariable,
         return;
     }
 
-    Timeout.QuadPart = 0;
+    WakeList = NULL;
+    WakeListTail = &WakeList;
     RemoveOnUnlockEntry = NULL;
 
-    /* Release sleeping threads. We will iterate from the last entry on
-       the list to the first. Note that the loop condition is always
-       true for the initial test. */
+    /* Take the threads to wake off the list. We will iterate from the
+       last entry on the list to the first. Note that the loop condition
+       is always true for the initial test. */
     for (Entry = CONTAINING_COND_VAR_WAIT_ENTRY(HeadEntry->ListEntry.Blink, ListEntry);
          Entry != NULL;
          Entry = NextEntry)
     {
-        NTSTATUS Status;
-
         if (HeadEntry == Entry)
         {
             /* After the current entry we've iterated through the
@@ -297,27 +300,14 @@ InternalWake(IN OUT PRTL_CONDITION_VARIABLE ConditionVariable,
         }
         else
         {
-            /* Store away the next reference right now, since we may
-               not touch Entry anymore at the end of the block. */
             NextEntry = CONTAINING_COND_VAR_WAIT_ENTRY(Entry->ListEntry.Blink, ListEntry);
         }
 
-        /* Wake the thread associated with this event. We will
-           immediately return if we failed (zero timeout). */
-        Status = NtReleaseKeyedEvent(CondVarKeyedEventHandle,
-                                     &Entry->WaitKey,
-                                     FALSE,
-                                     &Timeout);
+        /* Queue the entry for the release below */
+        Entry->NextWake = NULL;
+        *WakeListTail = Entry;
+        WakeListTail = &Entry->NextWake;
 
-        if (!NT_SUCCESS(Status))
-        {
-            /* We failed to wake a thread. We'll keep trying. */
-            ASSERT(STATUS_INVALID_HANDLE != Status);
-            continue;
-        }
-
-        /* We've woken a thread and will make sure this thread
-           is removed from the list. */
         if (HeadEntry == Entry)
         {
             /* This is the list head. We can't remove it as easily as
@@ -330,23 +320,37 @@ InternalWake(IN OUT PRTL_CONDITION_VARIABLE ConditionVariable,
             /* We can remove the entry right away. */
             RemoveEntryList(&Entry->ListEntry);
 
-            /* Now tell the woken thread that removal from the list was
-               already taken care of here so that this thread can resume
-               its normal operation more quickly. We may not touch
-               Entry after signaling this, since it may lie in invalid
-               memory from there on. */
+            /* Now tell the thread that removal from the list was
+               already taken care of here. From now on it won't return
+               before it got the release below, even if it timed out. */
             *InternalGetListRemovalHandledFlag(Entry) = TRUE;
         }
 
         if (!ReleaseAll)
         {
-            /* We've successfully woken one thread as the caller
-               demanded. */
+            /* We've picked one thread as the caller demanded. */
             break;
         }
     }
 
     InternalUnlockCondVar(ConditionVariable, RemoveOnUnlockEntry);
+
+    /* Now wake the threads we picked. This blocks until the thread
+       actually waits, so a thread that is still on its way to sleep
+       can't miss the wake. Store away the next reference first, since
+       we may not touch Entry anymore once it was released. */
+    for (Entry = WakeList; Entry != NULL; Entry = NextEntry)
+    {
+        NTSTATUS Status;
+
+        NextEntry = Entry->NextWake;
+
+        Status = NtReleaseKeyedEvent(CondVarKeyedEventHandle,
+                                     &Entry->WaitKey,
+                                     FALSE,
+                                     NULL);
+        ASSERT(NT_SUCCESS(Status));
+    }
 }
 
 VOID
@@ -375,6 +379,7 @@ InternalSleep(IN OUT PRTL_CONDITION_VARIABLE ConditionVariable,
        held again on return. */
 
     COND_VAR_WAIT_ENTRY OwnEntry;
+    BOOLEAN RemovedSelf = FALSE;
     NTSTATUS Status;
 
     ASSERT(CondVarKeyedEventHandle != NULL);
@@ -423,12 +428,24 @@ InternalSleep(IN OUT PRTL_CONDITION_VARIABLE ConditionVariable,
         {
             /* Unlock and potentially remove OwnEntry. Self-removal is
                usually only necessary when a timeout occurred. */
+            RemovedSelf = !OwnEntry.ListRemovalHandled;
             InternalUnlockCondVar(ConditionVariable,
-                                  !OwnEntry.ListRemovalHandled ?
-                                  &OwnEntry : NULL);
+                                  RemovedSelf ? &OwnEntry : NULL);
         }
     }
 
+    if (!RemovedSelf && Status == STATUS_TIMEOUT)
+    {
+        /* A waker took us off the list just as we timed out, and is
+           now about to release us. Take that release, or the waker
+           would block forever. We were woken after all. */
+        Status = NtWaitForKeyedEvent(CondVarKeyedEventHandle,
+                                     &OwnEntry.WaitKey,
+                                     FALSE,
+                                     NULL);
+        ASSERT(NT_SUCCESS(Status));
+    }
+
 #ifdef _DEBUG
     /* Clear OwnEntry to aid in detecting bugs. */
     RtlZeroMemory(&OwnEntry, sizeof(OwnEntry));
@@ -1792,6 +1792,10 @@ RtlDestroyHeap(HANDLE HeapPtr) /* [in] Handle of heap */
         RtlpRemoveHeapFromProcessList(Heap);
     }
 
+    /* Tear down the front end, its memory goes away with the segments */
+    if (Heap->FrontEndHeapType == HEAP_FRONT_LOWFRAGHEAP)
+        RtlpDestroyLowFragHeap(Heap);
+
     /* Delete the heap lock */
     if (!(Heap->Flags & HEAP_NO_SERIALIZE))
     {
@@ -2125,6 +2129,17 @@ RtlAllocateHeap(IN PVOID HeapPtr,
 
     Index = AllocationSize >> HEAP_ENTRY_SHIFT;
 
+    /* Small blocks without extra stuff are served by the front end, if any */
+    if ((Heap->FrontEndHeapType == HEAP_FRONT_LOWFRAGHEAP) &&
+        (Index < HEAP_LFH_BUCKETS) &&
+        !(EntryFlags & HEAP_ENTRY_EXTRA_PRESENT))
+    {
+        PVOID Block = RtlpLowFragHeapAllocate(Heap, Flags, Size, Index, EntryFlags);
+        if (Block) return Block;
+
+        /* Fall back to the back end */
+    }
+
     /* Acquire the lock if necessary */
     if (!(Flags & HEAP_NO_SERIALIZE))
     {
@@ -2317,7 +2332,8 @@ BOOLEAN NTAPI RtlFreeHeap(
         /* Check this entry, fail if it's invalid */
         if (!(HeapEntry->Flags & HEAP_ENTRY_BUSY) ||
             (((ULONG_PTR)Ptr & 0x7) != 0) ||
-            (HeapEntry->SegmentOffset >= HEAP_SEGMENTS))
+            ((HeapEntry->SegmentOffset >= HEAP_SEGMENTS) &&
+             !RtlpIsLowFragHeapEntry(Heap, HeapEntry)))
         {
             /* This is an invalid block */
             DPRINT1("HEAP: Trying to free an invalid address %p!\n", Ptr);
@@ -2334,6 +2350,10 @@ BOOLEAN NTAPI RtlFreeHeap(
     }
     _SEH2_END;
 
+    /* Front end blocks go back to their subsegment */
+    if (RtlpIsLowFragHeapEntry(Heap, HeapEntry))
+        return RtlpLowFragHeapFree(Heap, HeapEntry);
+
     /* Lock if necessary */
     if (!(Flags & HEAP_NO_SERIALIZE))
     {
@@ -2725,6 +2745,10 @@ RtlReAllocateHeap(HANDLE HeapPtr,
         return NULL;
     }
 
+    /* Front end blocks are resized by the front end */
+    if (RtlpIsLowFragHeapEntry(Heap, (PHEAP_ENTRY)Ptr - 1))
+        return RtlpLowFragHeapReAllocate(Heap, Flags, Ptr, Size);
+
     /* Calculate allocation size and index */
     if (Size)
         AllocationSize = Size;
@@ -3298,6 +3322,10 @@ RtlpValidateHeapEntry(
     if ((ULONG_PTR)HeapEntry & (HEAP_ENTRY_SIZE - 1)) goto invalid_entry;
     if (!(HeapEntry->Flags & HEAP_ENTRY_BUSY)) goto invalid_entry;
 
+    /* Front end blocks are not in Segments[], they live in a subsegment */
+    if (RtlpIsLowFragHeapEntry(Heap, HeapEntry))
+        return RtlpValidateLowFragHeapEntry(Heap, HeapEntry);
+
     BigAllocation = HeapEntry->Flags & HEAP_ENTRY_VIRTUAL_ALLOC;
     Segment = Heap->Segments[HeapEntry->SegmentOffset];
 
@@ -4080,13 +4108,16 @@ RtlSetHeapInformation(IN HANDLE HeapHandle OPTIONAL,
         }
 
         /* Check for a special magic value for enabling LFH */
-        if (*(PULONG)HeapInformation != 2)
+        if (*(PULONG)HeapInformation != HEAP_FRONT_LOWFRAGHEAP)
         {
             return STATUS_UNSUCCESSFUL;
         }
 
-        DPRINT1("RtlSetHeapInformation() needs to enable LFH\n");
-        return STATUS_SUCCESS;
+        /* LFH is per heap */
+        if (!HeapHandle)
+            return STATUS_INVALID_PARAMETER;
+
+        return RtlpActivateLowFragHeap((PHEAP)HeapHandle);
     }
 
     return STATUS_SUCCESS;
@@ -273,6 +273,69 @@ typedef struct _HEAP_SEGMENT
     HEAP_SEGMENT_MEMBERS;
 } HEAP_SEGMENT, *PHEAP_SEGMENT;
 
+/* Low fragmentation heap front end */
+#define HEAP_FRONT_LOWFRAGHEAP          2
+#define HEAP_LFH_BUCKETS                128
+#define HEAP_LFH_MAX_AFFINITY_SLOTS     16
+#define HEAP_LFH_SEGMENT_OFFSET         0xFF
+#define HEAP_LFH_SUBSEGMENT_SIZE        (16 * 1024)
+#define HEAP_LFH_MIN_BLOCKS             16
+#define HEAP_LFH_SUBSEGMENT_SIGNATURE   0x5346484C // 'LHFS'
+
+struct _HEAP_LFH_AFFINITY_SLOT;
+
+typedef struct _HEAP_LFH_SUBSEGMENT
+{
+    LIST_ENTRY ListEntry;
+    struct _HEAP_LFH_AFFINITY_SLOT *Slot;
+    ULONG Signature;
+    USHORT BlockUnits;
+    USHORT BlockCount;
+    USHORT FreeCount;
+    USHORT UnusedIndex;
+    PHEAP_ENTRY FreeList;
+} HEAP_LFH_SUBSEGMENT, *PHEAP_LFH_SUBSEGMENT;
+
+/*
+ * Offset of the first block in a subsegment. Like back end blocks, front end
+ * user data is only aligned on HEAP_ENTRY_SIZE: 16 bytes on 64-bit, 8 on x86,
+ * where the subsegment itself is an 8-byte aligned back end block.
+ */
+#define HEAP_LFH_BLOCKS_OFFSET \
+    (ROUND_UP(sizeof(HEAP_LFH_SUBSEGMENT) + HEAP_ENTRY_SIZE, 16) - HEAP_ENTRY_SIZE)
+
+typedef struct _HEAP_LFH_BUCKET
+{
+    PHEAP_LFH_SUBSEGMENT ActiveSubsegment;
+    LIST_ENTRY PartialSubsegments;
+} HEAP_LFH_BUCKET, *PHEAP_LFH_BUCKET;
+
+typedef struct _HEAP_LFH_AFFINITY_SLOT
+{
+    PHEAP_LOCK LockVariable;
+    ULONG Allocations;
+    ULONG Frees;
+    ULONG SubsegmentsCreated;
+    ULONG SubsegmentsReleased;
+    HEAP_LFH_BUCKET Buckets[HEAP_LFH_BUCKETS];
+    HEAP_LOCK Lock;
+} HEAP_LFH_AFFINITY_SLOT, *PHEAP_LFH_AFFINITY_SLOT;
+
+typedef struct _HEAP_LFH
+{
+    struct _HEAP *Heap;
+    ULONG SlotMask;
+    ULONG SlotCount;
+    HEAP_LFH_AFFINITY_SLOT Slots[ANYSIZE_ARRAY];
+} HEAP_LFH, *PHEAP_LFH;
+
+FORCEINLINE BOOLEAN
+RtlpIsLowFragHeapEntry(PHEAP Heap, PHEAP_ENTRY HeapEntry)
+{
+    return (Heap->FrontEndHeap != NULL) &&
+           (HeapEntry->SegmentOffset == HEAP_LFH_SEGMENT_OFFSET);
+}
+
 typedef struct _HEAP_UCR_DESCRIPTOR
 {
     LIST_ENTRY ListEntry;
@@ -338,6 +401,34 @@ RtlpValidateHeapEntry(PHEAP Heap, PHEAP_ENTRY HeapEntry);
 BOOLEAN NTAPI
 RtlpValidateHeapHeaders(PHEAP Heap, BOOLEAN Recalculate);
 
+/* heaplfh.c */
+NTSTATUS NTAPI
+RtlpActivateLowFragHeap(PHEAP Heap);
+
+VOID NTAPI
+RtlpDestroyLowFragHeap(PHEAP Heap);
+
+PVOID NTAPI
+RtlpLowFragHeapAllocate(PHEAP Heap,
+                        ULONG Flags,
+                        SIZE_T Size,
+                        SIZE_T Index,
+                        UCHAR EntryFlags);
+
+BOOLEAN NTAPI
+RtlpLowFragHeapFree(PHEAP Heap,
+                    PHEAP_ENTRY HeapEntry);
+
+BOOLEAN NTAPI
+RtlpValidateLowFragHeapEntry(PHEAP Heap,
+                             PHEAP_ENTRY HeapEntry);
+
+PVOID NTAPI
+RtlpLowFragHeapReAllocate(PHEAP Heap,
+                          ULONG Flags,
+                          PVOID Ptr,
+                          SIZE_T Size);
+
 /* heapdbg.c */
 NTSYSAPI
 HANDLE NTAPI
@@ -0,0 +1,534 @@
+/*
+ * PROJECT:     ReactOS Runtime Library
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Low Fragmentation Heap front end
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+/*
+ * The front end serves small blocks (less than HEAP_LFH_BUCKETS heap units,
+ * header included) out of subsegments, which are themselves ordinary busy
+ * blocks allocated from the back end. Every size class (bucket) holds one
+ * block size only, so there is no splitting nor coalescing.
+ *
+ * To keep threads off each other's toes, the front end is split into
+ * affinity slots, each with its own lock and its own set of buckets.
+ * A thread picks its slot from RtlpGetHeapAffinityHint() and moves to
+ * another one if its slot is busy. Freed blocks always go back to the
+ * subsegment, and therefore the slot, they were carved from.
+ *
+ * Block headers are laid out like back end ones, so that RtlSizeHeap
+ * keeps working, except for:
+ *  - SegmentOffset, which is HEAP_LFH_SEGMENT_OFFSET;
+ *  - PreviousSize, which is the index of the block in its subsegment.
+ */
+
+/* INCLUDES *****************************************************************/
+
+#include <rtl.h>
+#include <heap.h>
+
+#define NDEBUG
+#include <debug.h>
+
+/* FUNCTIONS *****************************************************************/
+
+FORCEINLINE
+PHEAP_ENTRY
+RtlpLfhGetBlock(PHEAP_LFH_SUBSEGMENT Subsegment,
+                ULONG BlockIndex)
+{
+    return (PHEAP_ENTRY)((PUCHAR)Subsegment +
+                         HEAP_LFH_BLOCKS_OFFSET +
+                         ((SIZE_T)BlockIndex * Subsegment->BlockUnits << HEAP_ENTRY_SHIFT));
+}
+
+FORCEINLINE
+PHEAP_LFH_SUBSEGMENT
+RtlpLfhGetSubsegment(PHEAP_ENTRY HeapEntry)
+{
+    return (PHEAP_LFH_SUBSEGMENT)((PUCHAR)HeapEntry -
+                                  HEAP_LFH_BLOCKS_OFFSET -
+                                  ((SIZE_T)HeapEntry->PreviousSize * HeapEntry->Size << HEAP_ENTRY_SHIFT));
+}
+
+static
+PHEAP_LFH_SUBSEGMENT
+RtlpLfhCreateSubsegment(PHEAP Heap,
+                        SIZE_T Index)
+{
+    PHEAP_LFH_SUBSEGMENT Subsegment;
+    SIZE_T BlockSize = Index << HEAP_ENTRY_SHIFT;
+    SIZE_T BlockCount;
+
+    /* Aim at a fixed subsegment size, but keep a minimum amount of blocks */
+    BlockCount = HEAP_LFH_SUBSEGMENT_SIZE / BlockSize;
+    if (BlockCount < HEAP_LFH_MIN_BLOCKS)
+        BlockCount = HEAP_LFH_MIN_BLOCKS;
+
+    /* Subsegments are far bigger than any bucket, so this goes to the back end */
+    Subsegment = RtlAllocateHeap(Heap,
+                                 0,
+                                 HEAP_LFH_BLOCKS_OFFSET + BlockCount * BlockSize);
+    if (!Subsegment)
+        return NULL;
+
+    Subsegment->Slot = NULL;
+    Subsegment->Signature = HEAP_LFH_SUBSEGMENT_SIGNATURE;
+    Subsegment->BlockUnits = (USHORT)Index;
+    Subsegment->BlockCount = (USHORT)BlockCount;
+    Subsegment->FreeCount = (USHORT)BlockCount;
+    Subsegment->UnusedIndex = 0;
+    Subsegment->FreeList = NULL;
+
+    return Subsegment;
+}
+
+static
+PHEAP_ENTRY
+RtlpLfhPopBlock(PHEAP_LFH_SUBSEGMENT Subsegment)
+{
+    PHEAP_ENTRY Block;
+
+    ASSERT(Subsegment->FreeCount != 0);
+    Subsegment->FreeCount--;
+
+    /* Recycle freed blocks first, so that untouched pages stay untouched */
+    Block = Subsegment->FreeList;
+    if (Block)
+    {
+        Subsegment->FreeList = *(PHEAP_ENTRY*)(Block + 1);
+        return Block;
+    }
+
+    /* Carve a new one out of the never used tail of the subsegment */
+    ASSERT(Subsegment->UnusedIndex < Subsegment->BlockCount);
+    Block = RtlpLfhGetBlock(Subsegment, Subsegment->UnusedIndex);
+    Block->Size = Subsegment->BlockUnits;
+    Block->PreviousSize = Subsegment->UnusedIndex;
+    Block->SegmentOffset = HEAP_LFH_SEGMENT_OFFSET;
+    Subsegment->UnusedIndex++;
+
+    return Block;
+}
+
+static
+PHEAP_LFH_AFFINITY_SLOT
+RtlpLfhAcquireSlot(PHEAP_LFH Lfh)
+{
+    PHEAP_LFH_AFFINITY_SLOT Slot;
+    ULONG Hint, i;
+
+    Hint = RtlpGetHeapAffinityHint();
+
+    /* Take our own slot if it is free, otherwise move on to a neighbour */
+    for (i = 0; i < Lfh->SlotCount; i++)
+    {
+        Slot = &Lfh->Slots[(Hint + i) & Lfh->SlotMask];
+        if (RtlTryEnterHeapLock(Slot->LockVariable, TRUE))
+            return Slot;
+    }
+
+    /* Everybody is busy, queue up on our own slot */
+    Slot = &Lfh->Slots[Hint & Lfh->SlotMask];
+    RtlEnterHeapLock(Slot->LockVariable, TRUE);
+    return Slot;
+}
+
+PVOID NTAPI
+RtlpLowFragHeapAllocate(PHEAP Heap,
+                        ULONG Flags,
+                        SIZE_T Size,
+                        SIZE_T Index,
+                        UCHAR EntryFlags)
+{
+    PHEAP_LFH Lfh = Heap->FrontEndHeap;
+    PHEAP_LFH_AFFINITY_SLOT Slot;
+    PHEAP_LFH_BUCKET Bucket;
+    PHEAP_LFH_SUBSEGMENT Subsegment, NewSubsegment = NULL;
+    PHEAP_ENTRY Block;
+
+    ASSERT(Index < HEAP_LFH_BUCKETS);
+
+    Slot = RtlpLfhAcquireSlot(Lfh);
+    Bucket = &Slot->Buckets[Index];
+
+    for (;;)
+    {
+        Subsegment = Bucket->ActiveSubsegment;
+        if (Subsegment && Subsegment->FreeCount)
+            break;
+
+        /* The active subsegment is full, switch to a partially used one */
+        if (!IsListEmpty(&Bucket->PartialSubsegments))
+        {
+            Subsegment = CONTAINING_RECORD(RemoveHeadList(&Bucket->PartialSubsegments),
+                                           HEAP_LFH_SUBSEGMENT,
+                                           ListEntry);
+            Bucket->ActiveSubsegment = Subsegment;
+            break;
+        }
+
+        /* We created one while the lock was dropped, use it */
+        if (NewSubsegment)
+        {
+            NewSubsegment->Slot = Slot;
+            Slot->SubsegmentsCreated++;
+            Subsegment = NewSubsegment;
+            NewSubsegment = NULL;
+            Bucket->ActiveSubsegment = Subsegment;
+            break;
+        }
+
+        /* Don't hold the slot while the back end is busy getting us memory */
+        RtlLeaveHeapLock(Slot->LockVariable);
+        NewSubsegment = RtlpLfhCreateSubsegment(Heap, Index);
+        if (!NewSubsegment)
+            return NULL;
+
+        RtlEnterHeapLock(Slot->LockVariable, TRUE);
+    }
+
+    /* Somebody else refilled the bucket meanwhile, keep ours for later */
+    if (NewSubsegment)
+    {
+        NewSubsegment->Slot = Slot;
+        Slot->SubsegmentsCreated++;
+        InsertTailList(&Bucket->PartialSubsegments, &NewSubsegment->ListEntry);
+    }
+
+    Block = RtlpLfhPopBlock(Subsegment);
+    Block->Flags = EntryFlags;
+    Block->SmallTagIndex = 0;
+    Block->UnusedBytes = (UCHAR)((Index << HEAP_ENTRY_SHIFT) - Size);
+    Slot->Allocations++;
+
+    RtlLeaveHeapLock(Slot->LockVariable);
+
+    /* Zero memory if that was requested */
+    if (Flags & HEAP_ZERO_MEMORY)
+        RtlZeroMemory(Block + 1, Size);
+
+    return Block + 1;
+}
+
+BOOLEAN NTAPI
+RtlpLowFragHeapFree(PHEAP Heap,
+                    PHEAP_ENTRY HeapEntry)
+{
+    PHEAP_LFH_SUBSEGMENT Subsegment;
+    PHEAP_LFH_AFFINITY_SLOT Slot;
+    PHEAP_LFH_BUCKET Bucket;
+    BOOLEAN Release = FALSE;
+
+    Subsegment = RtlpLfhGetSubsegment(HeapEntry);
+
+    /* Make sure the header really points into one of our subsegments */
+    _SEH2_TRY
+    {
+        if ((Subsegment->Signature != HEAP_LFH_SUBSEGMENT_SIGNATURE) ||
+            (Subsegment->BlockUnits != HeapEntry->Size) ||
+            (HeapEntry->PreviousSize >= Subsegment->UnusedIndex))
+        {
+            DPRINT1("HEAP: Trying to free an invalid LFH block %p!\n", HeapEntry + 1);
+            RtlSetLastWin32ErrorAndNtStatusFromNtStatus(STATUS_INVALID_PARAMETER);
+            _SEH2_YIELD(return FALSE);
+        }
+    }
+    _SEH2_EXCEPT(EXCEPTION_EXECUTE_HANDLER)
+    {
+        DPRINT1("HEAP: Trying to free an invalid LFH block %p!\n", HeapEntry + 1);
+        RtlSetLastWin32ErrorAndNtStatusFromNtStatus(STATUS_INVALID_PARAMETER);
+        _SEH2_YIELD(return FALSE);
+    }
+    _SEH2_END;
+
+    Slot = Subsegment->Slot;
+    Bucket = &Slot->Buckets[Subsegment->BlockUnits];
+
+    RtlEnterHeapLock(Slot->LockVariable, TRUE);
+
+    /* Catch double frees racing with each other */
+    if (!(HeapEntry->Flags & HEAP_ENTRY_BUSY))
+    {
+        RtlLeaveHeapLock(Slot->LockVariable);
+        DPRINT1("HEAP: Trying to free an already free LFH block %p!\n", HeapEntry + 1);
+        RtlSetLastWin32ErrorAndNtStatusFromNtStatus(STATUS_INVALID_PARAMETER);
+        return FALSE;
+    }
+
+    HeapEntry->Flags = 0;
+    *(PHEAP_ENTRY*)(HeapEntry + 1) = Subsegment->FreeList;
+    Subsegment->FreeList = HeapEntry;
+    Subsegment->FreeCount++;
+    Slot->Frees++;
+
+    /* The active subsegment is always kept, others move between lists */
+    if (Subsegment != Bucket->ActiveSubsegment)
+    {
+        ASSERT(Subsegment->BlockCount > 1);
+
+        if (Subsegment->FreeCount == Subsegment->BlockCount)
+        {
+            /* Completely unused, give it back to the back end */
+            RemoveEntryList(&Subsegment->ListEntry);
+            Slot->SubsegmentsReleased++;
+            Release = TRUE;
+        }
+        else if (Subsegment->FreeCount == 1)
+        {
+            /* It was full so far, make it available again */
+            InsertTailList(&Bucket->PartialSubsegments, &Subsegment->ListEntry);
+        }
+    }
+
+    RtlLeaveHeapLock(Slot->LockVariable);
+
+    if (Release)
+    {
+        Subsegment->Signature = 0;
+        RtlFreeHeap(Heap, 0, Subsegment);
+    }
+
+    return TRUE;
+}
+
+BOOLEAN NTAPI
+RtlpValidateLowFragHeapEntry(PHEAP Heap,
+                             PHEAP_ENTRY HeapEntry)
+{
+    PHEAP_LFH Lfh = Heap->FrontEndHeap;
+    PHEAP_LFH_SUBSEGMENT Subsegment;
+    PHEAP_ENTRY SubsegmentEntry;
+    SIZE_T BlockEnd;
+    BOOLEAN Valid = FALSE;
+
+    Subsegment = RtlpLfhGetSubsegment(HeapEntry);
+    SubsegmentEntry = (PHEAP_ENTRY)Subsegment - 1;
+
+    _SEH2_TRY
+    {
+        /* The subsegment must be one of ours, owned by a slot of this heap */
+        if ((Subsegment->Signature != HEAP_LFH_SUBSEGMENT_SIGNATURE) ||
+            (Subsegment->BlockUnits != HeapEntry->Size) ||
+            (HeapEntry->PreviousSize >= Subsegment->UnusedIndex) ||
+            (Subsegment->UnusedIndex > Subsegment->BlockCount) ||
+            (Subsegment->Slot < &Lfh->Slots[0]) ||
+            (Subsegment->Slot >= &Lfh->Slots[Lfh->SlotCount]))
+        {
+            _SEH2_LEAVE;
+        }
+
+        /* And a valid back end block holding the whole block */
+        BlockEnd = HEAP_LFH_BLOCKS_OFFSET +
+                   ((SIZE_T)(HeapEntry->PreviousSize + 1) * Subsegment->BlockUnits << HEAP_ENTRY_SHIFT);
+        if (RtlpIsLowFragHeapEntry(Heap, SubsegmentEntry) ||
+            !RtlpValidateHeapEntry(Heap, SubsegmentEntry) ||
+            (BlockEnd > ((SIZE_T)SubsegmentEntry->Size << HEAP_ENTRY_SHIFT) - sizeof(HEAP_ENTRY)))
+        {
+            _SEH2_LEAVE;
+        }
+
+        Valid = TRUE;
+    }
+    _SEH2_EXCEPT(EXCEPTION_EXECUTE_HANDLER)
+    {
+        Valid = FALSE;
+    }
+    _SEH2_END;
+
+    if (!Valid)
+        DPRINT1("HEAP: Invalid LFH block %p in heap %p\n", HeapEntry, Heap);
+
+    return Valid;
+}
+
+PVOID NTAPI
+RtlpLowFragHeapReAllocate(PHEAP Heap,
+                          ULONG Flags,
+                          PVOID Ptr,
+                          SIZE_T Size)
+{
+    PHEAP_ENTRY InUseEntry = (PHEAP_ENTRY)Ptr - 1;
+    SIZE_T AllocationSize, OldSize;
+    PVOID NewBaseAddress;
+    EXCEPTION_RECORD ExceptionRecord;
+
+    if (!(InUseEntry->Flags & HEAP_ENTRY_BUSY))
+    {
+        RtlSetLastWin32ErrorAndNtStatusFromNtStatus(STATUS_INVALID_PARAMETER);
+        return NULL;
+    }
+
+    OldSize = (InUseEntry->Size << HEAP_ENTRY_SHIFT) - InUseEntry->UnusedBytes;
+
+    /* Stay in place as long as the block is big enough and not too big */
+    AllocationSize = (InUseEntry->Size << HEAP_ENTRY_SHIFT);
+    if ((Size + sizeof(HEAP_ENTRY) <= AllocationSize) &&
+        (AllocationSize - Size <= MAXUCHAR))
+    {
+        InUseEntry->UnusedBytes = (UCHAR)(AllocationSize - Size);
+
+        /* Zero out the additional space if required */
+        if ((Size > OldSize) && (Flags & HEAP_ZERO_MEMORY))
+            RtlZeroMemory((PCHAR)Ptr + OldSize, Size - OldSize);
+
+        return Ptr;
+    }
+
+    if (Flags & HEAP_REALLOC_IN_PLACE_ONLY)
+    {
+        DPRINT1("Realloc in place failed, but it was the only option\n");
+
+        if (Flags & HEAP_GENERATE_EXCEPTIONS)
+        {
+            ExceptionRecord.ExceptionCode = STATUS_NO_MEMORY;
+            ExceptionRecord.ExceptionRecord = NULL;
+            ExceptionRecord.NumberParameters = 1;
+            ExceptionRecord.ExceptionFlags = 0;
+            ExceptionRecord.ExceptionInformation[0] = Size;
+
+            RtlRaiseException(&ExceptionRecord);
+        }
+
+        return NULL;
+    }
+
+    /* Move it somewhere else, front end or back end */
+    NewBaseAddress = RtlAllocateHeap(Heap, Flags & ~HEAP_ZERO_MEMORY, Size);
+    if (!NewBaseAddress)
+        return NULL;
+
+    RtlMoveMemory(NewBaseAddress, Ptr, min(Size, OldSize));
+
+    /* Zero remaining part if required */
+    if ((Size > OldSize) && (Flags & HEAP_ZERO_MEMORY))
+        RtlZeroMemory((PCHAR)NewBaseAddress + OldSize, Size - OldSize);
+
+    RtlpLowFragHeapFree(Heap, InUseEntry);
+
+    return NewBaseAddress;
+}
+
+NTSTATUS NTAPI
+RtlpActivateLowFragHeap(PHEAP Heap)
+{
+    SYSTEM_BASIC_INFORMATION SystemInformation;
+    PHEAP_LFH_AFFINITY_SLOT Slot;
+    PHEAP_LFH Lfh;
+    ULONG SlotCount, i, j;
+    NTSTATUS Status;
+
+    /* Nothing to do if it's already there */
+    if (Heap->FrontEndHeapType == HEAP_FRONT_LOWFRAGHEAP)
+        return STATUS_SUCCESS;
+
+    /* The front end needs locking, and would hide blocks from the debugging helpers */
+    if ((Heap->Flags & HEAP_NO_SERIALIZE) ||
+        (Heap->ForceFlags & (HEAP_FLAG_PAGE_ALLOCS |
+                             HEAP_TAIL_CHECKING_ENABLED |
+                             HEAP_FREE_CHECKING_ENABLED)) ||
+        RtlpHeapIsSpecial(Heap->Flags))
+    {
+        DPRINT1("HEAP: Cannot enable LFH on heap %p (flags %lx)\n", Heap, Heap->Flags);
+        return STATUS_UNSUCCESSFUL;
+    }
+
+    Status = ZwQuerySystemInformation(SystemBasicInformation,
+                                      &SystemInformation,
+                                      sizeof(SystemInformation),
+                                      NULL);
+    if (!NT_SUCCESS(Status))
+        return Status;
+
+    /* One slot per processor, rounded up to a power of two */
+    SlotCount = 1;
+    while ((SlotCount < (ULONG)SystemInformation.NumberOfProcessors) &&
+           (SlotCount < HEAP_LFH_MAX_AFFINITY_SLOTS))
+    {
+        SlotCount <<= 1;
+    }
+
+    Lfh = RtlAllocateHeap(Heap,
+                          HEAP_ZERO_MEMORY,
+                          FIELD_OFFSET(HEAP_LFH, Slots[SlotCount]));
+    if (!Lfh)
+        return STATUS_NO_MEMORY;
+
+    Lfh->Heap = Heap;
+    Lfh->SlotCount = SlotCount;
+    Lfh->SlotMask = SlotCount - 1;
+
+    for (i = 0; i < SlotCount; i++)
+    {
+        Slot = &Lfh->Slots[i];
+
+        /* In user mode, the lock lives in the slot itself */
+        if (RtlpGetMode() == UserMode)
+            Slot->LockVariable = &Slot->Lock;
+
+        Status = RtlInitializeHeapLock(&Slot->LockVariable);
+        if (!NT_SUCCESS(Status))
+        {
+            while (i--)
+                RtlDeleteHeapLock(Lfh->Slots[i].LockVariable);
+
+            RtlFreeHeap(Heap, 0, Lfh);
+            return Status;
+        }
+
+        for (j = 0; j < HEAP_LFH_BUCKETS; j++)
+            InitializeListHead(&Slot->Buckets[j].PartialSubsegments);
+    }
+
+    RtlEnterHeapLock(Heap->LockVariable, TRUE);
+
+    /* Somebody beat us to it */
+    if (Heap->FrontEndHeap)
+    {
+        RtlLeaveHeapLock(Heap->LockVariable);
+
+        for (i = 0; i < SlotCount; i++)
+            RtlDeleteHeapLock(Lfh->Slots[i].LockVariable);
+
+        RtlFreeHeap(Heap, 0, Lfh);
+        return STATUS_SUCCESS;
+    }
+
+    /* Publish the front end before advertising it */
+    InterlockedExchangePointer(&Heap->FrontEndHeap, Lfh);
+    Heap->FrontEndHeapType = HEAP_FRONT_LOWFRAGHEAP;
+
+    RtlLeaveHeapLock(Heap->LockVariable);
+
+    DPRINT("HEAP: Enabled LFH on heap %p with %lu slots\n", Heap, SlotCount);
+    return STATUS_SUCCESS;
+}
+
+VOID NTAPI
+RtlpDestroyLowFragHeap(PHEAP Heap)
+{
+    PHEAP_LFH Lfh = Heap->FrontEndHeap;
+    ULONG i;
+
+    if (!Lfh)
+        return;
+
+    /* Subsegments live in the heap segments and go away with them */
+    for (i = 0; i < Lfh->SlotCount; i++)
+    {
+        DPRINT("HEAP: LFH slot %lu: %lu allocs, %lu frees, %lu/%lu subsegments created/released\n",
+               i,
+               Lfh->Slots[i].Allocations,
+               Lfh->Slots[i].Frees,
+               Lfh->Slots[i].SubsegmentsCreated,
+               Lfh->Slots[i].SubsegmentsReleased);
+
+        RtlDeleteHeapLock(Lfh->Slots[i].LockVariable);
+    }
+
+    Heap->FrontEndHeapType = 0;
+    Heap->FrontEndHeap = NULL;
+}
+
+/* EOF */
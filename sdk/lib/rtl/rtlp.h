@@ -139,6 +139,10 @@ NTSTATUS
 NTAPI
 RtlLeaveHeapLock(IN OUT PHEAP_LOCK Lock);
 
+ULONG
+NTAPI
+RtlpGetHeapAffinityHint(VOID);
+
 BOOLEAN
 NTAPI
 RtlpCheckForActiveDebugger(VOID);
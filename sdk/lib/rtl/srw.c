@@ -9,11 +9,16 @@
  *                    Since applications should treat the RTL_SRWLOCK
  *                    structure as opaque data, it should not matter.
  *                    The algorithms are probably not as optimized.
+ *
+ *                    Contended acquirers spin for an adaptive number of
+ *                    iterations and then park on the keyed event also
+ *                    used by the condition variables.
  */
 
 /* INCLUDES *****************************************************************/
 
 #include <rtl_vista.h>
+#include "srw.h"
 
 #define NDEBUG
 #include <debug.h>
@@ -79,6 +84,155 @@ typedef struct _RTLP_SRWLOCK_WAITBLOCK
     BOOLEAN Exclusive;
 } volatile RTLP_SRWLOCK_WAITBLOCK, *PRTLP_SRWLOCK_WAITBLOCK;
 
+/* Wake states of a queued acquirer */
+#define RTL_SRWLOCK_WAKE_PENDING    0
+#define RTL_SRWLOCK_WAKE_SIGNALED   1
+#define RTL_SRWLOCK_WAKE_PARKED     2
+
+/* Bounds of the adaptive spin count, in YieldProcessor iterations */
+#define RTL_SRWLOCK_SPIN_MIN        16
+#define RTL_SRWLOCK_SPIN_DEFAULT    512
+#define RTL_SRWLOCK_SPIN_MAX        4096
+
+#define RTL_SRWLOCK_MAX_TRACKED     16
+
+/* How long contended acquirers spin before they park. Every waiter
+   updates it, so it gets a cache line of its own. */
+static DECLSPEC_CACHEALIGN volatile LONG RtlpSRWLockSpinCount = RTL_SRWLOCK_SPIN_DEFAULT;
+
+/* Locks whose statistics are collected. This is read on every acquire,
+   but only written when tracking is turned on or off. */
+static DECLSPEC_CACHEALIGN struct
+{
+    volatile LONG Count;
+    PRTL_SRWLOCK Lock[RTL_SRWLOCK_MAX_TRACKED];
+    PRTL_SRWLOCK_STATISTICS Statistics[RTL_SRWLOCK_MAX_TRACKED];
+} RtlpSRWLockTracking;
+
+
+static PRTL_SRWLOCK_STATISTICS
+NTAPI
+RtlpGetSRWLockStatistics(IN PRTL_SRWLOCK SRWLock)
+{
+    ULONG i;
+
+    if (RtlpSRWLockTracking.Count == 0)
+        return NULL;
+
+    for (i = 0; i < RTL_SRWLOCK_MAX_TRACKED; i++)
+    {
+        if (RtlpSRWLockTracking.Lock[i] == SRWLock)
+            return RtlpSRWLockTracking.Statistics[i];
+    }
+
+    return NULL;
+}
+
+
+static VOID
+NTAPI
+RtlpCountSRWLockAcquire(IN PRTL_SRWLOCK SRWLock)
+{
+    PRTL_SRWLOCK_STATISTICS Statistics;
+
+    if (RtlpSRWLockTracking.Count != 0)
+    {
+        Statistics = RtlpGetSRWLockStatistics(SRWLock);
+        if (Statistics != NULL)
+            InterlockedIncrement(&Statistics->Acquires);
+    }
+}
+
+
+static VOID
+NTAPI
+RtlpWakeSRWLockWaiter(IN OUT volatile LONG *Wake)
+{
+    /* The waiter may return as soon as it sees the signal, so the
+       wait block must not be touched anymore unless it is parked. */
+    if (InterlockedExchange((PLONG)Wake, RTL_SRWLOCK_WAKE_SIGNALED) == RTL_SRWLOCK_WAKE_PARKED)
+    {
+        NtReleaseKeyedEvent(CondVarKeyedEventHandle, (PVOID)Wake, FALSE, NULL);
+    }
+}
+
+
+static VOID
+NTAPI
+RtlpWaitForSRWLockWake(IN PRTL_SRWLOCK SRWLock,
+                       IN OUT volatile LONG *Wake)
+{
+    PRTL_SRWLOCK_STATISTICS Statistics;
+    LARGE_INTEGER StartTime, EndTime;
+    LONGLONG WaitTime, MaxWaitTime, PrevMaxWaitTime;
+    LONG SpinCount, Spins;
+    BOOLEAN Parked = FALSE;
+
+    Statistics = RtlpGetSRWLockStatistics(SRWLock);
+    if (Statistics != NULL)
+    {
+        InterlockedIncrement(&Statistics->Contentions);
+        NtQueryPerformanceCounter(&StartTime, NULL);
+    }
+
+    /* Spinning only pays off if the owner can run meanwhile */
+    SpinCount = (NtCurrentPeb()->NumberOfProcessors > 1) ? RtlpSRWLockSpinCount : 0;
+
+    for (Spins = 0; Spins < SpinCount; Spins++)
+    {
+        if (*Wake == RTL_SRWLOCK_WAKE_SIGNALED)
+            break;
+
+        YieldProcessor();
+    }
+
+    if (Spins < SpinCount)
+    {
+        /* The lock was handed over while spinning. Aim for twice
+           the spin that was needed, so the next waiter doesn't park
+           just before the owner lets go. */
+        SpinCount += (max(2 * Spins, RTL_SRWLOCK_SPIN_MIN) - SpinCount) / 8;
+        RtlpSRWLockSpinCount = min(SpinCount, RTL_SRWLOCK_SPIN_MAX);
+    }
+    else
+    {
+        /* Tell the releaser to wake us through the keyed event. If the
+           wake already happened, the lock is ours. */
+        if (InterlockedCompareExchange((PLONG)Wake,
+                                       RTL_SRWLOCK_WAKE_PARKED,
+                                       RTL_SRWLOCK_WAKE_PENDING) == RTL_SRWLOCK_WAKE_PENDING)
+        {
+            NtWaitForKeyedEvent(CondVarKeyedEventHandle, (PVOID)Wake, FALSE, NULL);
+            Parked = TRUE;
+        }
+
+        /* Owners hold the lock longer than we spin, so spin less */
+        if (SpinCount != 0)
+            RtlpSRWLockSpinCount = max(SpinCount - SpinCount / 16, RTL_SRWLOCK_SPIN_MIN);
+    }
+
+    if (Statistics != NULL)
+    {
+        InterlockedExchangeAdd(&Statistics->Spins, Spins);
+        InterlockedIncrement(Parked ? &Statistics->Waits : &Statistics->SpinAcquires);
+
+        NtQueryPerformanceCounter(&EndTime, NULL);
+        WaitTime = EndTime.QuadPart - StartTime.QuadPart;
+
+        MaxWaitTime = Statistics->MaxWaitTime;
+        while (WaitTime > MaxWaitTime)
+        {
+            PrevMaxWaitTime = InterlockedCompareExchange64(&Statistics->MaxWaitTime,
+                                                           WaitTime,
+                                                           MaxWaitTime);
+            if (PrevMaxWaitTime == MaxWaitTime)
+                break;
+
+            MaxWaitTime = PrevMaxWaitTime;
+        }
+    }
+}
+
 
 static VOID
 NTAPI
@@ -127,8 +281,7 @@ RtlpReleaseWaitBlockLockExclusive(IN OUT PRTL_SRWLOCK SRWLock,
 
     if (FirstWaitBlock->Exclusive)
     {
-        (void)InterlockedOr(&FirstWaitBlock->Wake,
-                            TRUE);
+        RtlpWakeSRWLockWaiter(&FirstWaitBlock->Wake);
     }
     else
     {
@@ -141,8 +294,7 @@ RtlpReleaseWaitBlockLockExclusive(IN OUT PRTL_SRWLOCK SRWLock,
         {
             NextWake = WakeChain->Next;
 
-            (void)InterlockedOr((PLONG)&WakeChain->Wake,
-                                TRUE);
+            RtlpWakeSRWLockWaiter(&WakeChain->Wake);
 
             WakeChain = NextWake;
         } while (WakeChain != NULL);
@@ -180,8 +332,7 @@ RtlpReleaseWaitBlockLockLastShared(IN OUT PRTL_SRWLOCK SRWLock,
 
     (void)InterlockedExchangePointer(&SRWLock->Ptr, (PVOID)NewValue);
 
-    (void)InterlockedOr(&FirstWaitBlock->Wake,
-                        TRUE);
+    RtlpWakeSRWLockWaiter(&FirstWaitBlock->Wake);
 }
 
 
@@ -227,91 +378,6 @@ RtlpAcquireWaitBlockLock(IN OUT PRTL_SRWLOCK SRWLock)
 }
 
 
-static VOID
-NTAPI
-RtlpAcquireSRWLockExclusiveWait(IN OUT PRTL_SRWLOCK SRWLock,
-                                IN PRTLP_SRWLOCK_WAITBLOCK WaitBlock)
-{
-    LONG_PTR CurrentValue;
-
-    while (1)
-    {
-        CurrentValue = *(volatile LONG_PTR *)&SRWLock->Ptr;
-        if (!(CurrentValue & RTL_SRWLOCK_SHARED))
-        {
-            if (CurrentValue & RTL_SRWLOCK_CONTENDED)
-            {
-                if (WaitBlock->Wake != 0)
-                {
-                    /* Our wait block became the first one
-                       in the chain, we own the lock now! */
-                    break;
-                }
-            }
-            else
-            {
-                /* The last wait block was removed and/or we're
-                   finally a simple exclusive lock. This means we
-                   don't need to wait anymore, we acquired the lock! */
-                break;
-            }
-        }
-
-        YieldProcessor();
-    }
-}
-
-
-static VOID
-NTAPI
-RtlpAcquireSRWLockSharedWait(IN OUT PRTL_SRWLOCK SRWLock,
-                             IN OUT PRTLP_SRWLOCK_WAITBLOCK FirstWait  OPTIONAL,
-                             IN OUT PRTLP_SRWLOCK_SHARED_WAKE WakeChain)
-{
-    if (FirstWait != NULL)
-    {
-        while (WakeChain->Wake == 0)
-        {
-            YieldProcessor();
-        }
-    }
-    else
-    {
-        LONG_PTR CurrentValue;
-
-        while (1)
-        {
-            CurrentValue = *(volatile LONG_PTR *)&SRWLock->Ptr;
-            if (CurrentValue & RTL_SRWLOCK_SHARED)
-            {
-                /* The RTL_SRWLOCK_OWNED bit always needs to be set when
-                   RTL_SRWLOCK_SHARED is set! */
-                ASSERT(CurrentValue & RTL_SRWLOCK_OWNED);
-
-                if (CurrentValue & RTL_SRWLOCK_CONTENDED)
-                {
-                    if (WakeChain->Wake != 0)
-                    {
-                        /* Our wait block became the first one
-                           in the chain, we own the lock now! */
-                        break;
-                    }
-                }
-                else
-                {
-                    /* The last wait block was removed and/or we're
-                       finally a simple shared lock. This means we
-                       don't need to wait anymore, we acquired the lock! */
-                    break;
-                }
-            }
-
-            YieldProcessor();
-        }
-    }
-}
-
-
 VOID
 NTAPI
 RtlInitializeSRWLock(OUT PRTL_SRWLOCK SRWLock)
@@ -326,13 +392,13 @@ RtlAcquireSRWLockShared(IN OUT PRTL_SRWLOCK SRWLock)
 {
     __ALIGNED(16) RTLP_SRWLOCK_WAITBLOCK StackWaitBlock;
     RTLP_SRWLOCK_SHARED_WAKE SharedWake;
-    LONG_PTR CurrentValue, NewValue;
-    PRTLP_SRWLOCK_WAITBLOCK First, Shared, FirstWait;
+    LONG_PTR CurrentValue, NewValue, PrevValue;
+    PRTLP_SRWLOCK_WAITBLOCK First, Shared;
+
+    CurrentValue = *(volatile LONG_PTR *)&SRWLock->Ptr;
 
     while (1)
     {
-        CurrentValue = *(volatile LONG_PTR *)&SRWLock->Ptr;
-
         if (CurrentValue & RTL_SRWLOCK_SHARED)
         {
             /* NOTE: It is possible that the RTL_SRWLOCK_OWNED bit is set! */
@@ -344,53 +410,49 @@ RtlAcquireSRWLockShared(IN OUT PRTL_SRWLOCK SRWLock)
                 First = RtlpAcquireWaitBlockLock(SRWLock);
                 if (First != NULL)
                 {
-                    FirstWait = NULL;
-
-                    if (First->Exclusive)
+                    if (!First->Exclusive)
                     {
-                        /* We need to setup a new wait block! Although
-                           we're currently in a shared lock and we're acquiring
-                           a shared lock, there are exclusive locks queued. We need
-                           to wait until those are released. */
-                        Shared = First->Last;
+                        /* The shared acquirers of the first wait block own
+                           the lock already, simply join them */
+                        First->SharedCount++;
+                        RtlpReleaseWaitBlockLock(SRWLock);
+                        break;
+                    }
 
-                        if (Shared->Exclusive)
-                        {
-                            StackWaitBlock.Exclusive = FALSE;
-                            StackWaitBlock.SharedCount = 1;
-                            StackWaitBlock.Next = NULL;
-                            StackWaitBlock.Last = &StackWaitBlock;
-                            StackWaitBlock.SharedWakeChain = &SharedWake;
+                    /* We need to setup a new wait block! Although
+                       we're currently in a shared lock and we're acquiring
+                       a shared lock, there are exclusive locks queued. We need
+                       to wait until those are released. */
+                    Shared = First->Last;
 
-                            Shared->Next = &StackWaitBlock;
-                            First->Last = &StackWaitBlock;
+                    if (Shared->Exclusive)
+                    {
+                        StackWaitBlock.Exclusive = FALSE;
+                        StackWaitBlock.SharedCount = 1;
+                        StackWaitBlock.Next = NULL;
+                        StackWaitBlock.Last = &StackWaitBlock;
+                        StackWaitBlock.SharedWakeChain = &SharedWake;
 
-                            Shared = &StackWaitBlock;
-                            FirstWait = &StackWaitBlock;
-                        }
-                        else
-                        {
-                            Shared->LastSharedWake->Next = &SharedWake;
-                            Shared->SharedCount++;
-                        }
+                        Shared->Next = &StackWaitBlock;
+                        First->Last = &StackWaitBlock;
+
+                        Shared = &StackWaitBlock;
                     }
                     else
                     {
-                        Shared = First;
                         Shared->LastSharedWake->Next = &SharedWake;
                         Shared->SharedCount++;
                     }
 
                     SharedWake.Next = NULL;
-                    SharedWake.Wake = 0;
+                    SharedWake.Wake = RTL_SRWLOCK_WAKE_PENDING;
 
                     Shared->LastSharedWake = &SharedWake;
 
                     RtlpReleaseWaitBlockLock(SRWLock);
 
-                    RtlpAcquireSRWLockSharedWait(SRWLock,
-                                                 FirstWait,
-                                                 &SharedWake);
+                    RtlpWaitForSRWLockWake(SRWLock,
+                                           &SharedWake.Wake);
 
                     /* Successfully incremented the shared count, we acquired the lock */
                     break;
@@ -409,13 +471,19 @@ RtlAcquireSRWLockShared(IN OUT PRTL_SRWLOCK SRWLock)
                 NewValue = (CurrentValue >> RTL_SRWLOCK_BITS) + 1;
                 NewValue = (NewValue << RTL_SRWLOCK_BITS) | (CurrentValue & RTL_SRWLOCK_MASK);
 
-                if ((LONG_PTR)InterlockedCompareExchangePointer(&SRWLock->Ptr,
-                                                                (PVOID)NewValue,
-                                                                (PVOID)CurrentValue) == CurrentValue)
+                PrevValue = (LONG_PTR)InterlockedCompareExchangePointer(&SRWLock->Ptr,
+                                                                        (PVOID)NewValue,
+                                                                        (PVOID)CurrentValue);
+                if (PrevValue == CurrentValue)
                 {
                     /* Successfully incremented the shared count, we acquired the lock */
                     break;
                 }
+
+                /* Most likely another reader came or went, retry right away
+                   with the value we got instead of backing off */
+                CurrentValue = PrevValue;
+                continue;
             }
         }
         else
@@ -426,7 +494,7 @@ RtlAcquireSRWLockShared(IN OUT PRTL_SRWLOCK SRWLock)
                 if (CurrentValue & RTL_SRWLOCK_CONTENDED)
                 {
                     SharedWake.Next = NULL;
-                    SharedWake.Wake = 0;
+                    SharedWake.Wake = RTL_SRWLOCK_WAKE_PENDING;
 
                     /* There's other waiters already, lock the wait blocks and
                        increment the shared count. If the last block in the chain
@@ -448,11 +516,9 @@ RtlAcquireSRWLockShared(IN OUT PRTL_SRWLOCK SRWLock)
                             First->Last = &StackWaitBlock;
 
                             Shared = &StackWaitBlock;
-                            FirstWait = &StackWaitBlock;
                         }
                         else
                         {
-                            FirstWait = NULL;
                             Shared->LastSharedWake->Next = &SharedWake;
                         }
 
@@ -461,9 +527,8 @@ RtlAcquireSRWLockShared(IN OUT PRTL_SRWLOCK SRWLock)
 
                         RtlpReleaseWaitBlockLock(SRWLock);
 
-                        RtlpAcquireSRWLockSharedWait(SRWLock,
-                                                     FirstWait,
-                                                     &SharedWake);
+                        RtlpWaitForSRWLockWake(SRWLock,
+                                               &SharedWake.Wake);
 
                         /* Successfully incremented the shared count, we acquired the lock */
                         break;
@@ -472,7 +537,7 @@ RtlAcquireSRWLockShared(IN OUT PRTL_SRWLOCK SRWLock)
                 else
                 {
                     SharedWake.Next = NULL;
-                    SharedWake.Wake = 0;
+                    SharedWake.Wake = RTL_SRWLOCK_WAKE_PENDING;
 
                     /* We need to setup the first wait block. Currently an exclusive lock is
                        held, change the lock to contended mode. */
@@ -488,9 +553,8 @@ RtlAcquireSRWLockShared(IN OUT PRTL_SRWLOCK SRWLock)
                                                                     (PVOID)NewValue,
                                                                     (PVOID)CurrentValue) == CurrentValue)
                     {
-                        RtlpAcquireSRWLockSharedWait(SRWLock,
-                                                     &StackWaitBlock,
-                                                     &SharedWake);
+                        RtlpWaitForSRWLockWake(SRWLock,
+                                               &SharedWake.Wake);
 
                         /* Successfully set the shared count, we acquired the lock */
                         break;
@@ -506,18 +570,26 @@ RtlAcquireSRWLockShared(IN OUT PRTL_SRWLOCK SRWLock)
                    RTL_SRWLOCK_SHARED nor the RTL_SRWLOCK_OWNED bit is set */
                 ASSERT(!(CurrentValue & RTL_SRWLOCK_CONTENDED));
 
-                if ((LONG_PTR)InterlockedCompareExchangePointer(&SRWLock->Ptr,
-                                                                (PVOID)NewValue,
-                                                                (PVOID)CurrentValue) == CurrentValue)
+                PrevValue = (LONG_PTR)InterlockedCompareExchangePointer(&SRWLock->Ptr,
+                                                                        (PVOID)NewValue,
+                                                                        (PVOID)CurrentValue);
+                if (PrevValue == CurrentValue)
                 {
                     /* Successfully set the shared count, we acquired the lock */
                     break;
                 }
+
+                /* Probably another reader was faster, join it right away */
+                CurrentValue = PrevValue;
+                continue;
             }
         }
 
         YieldProcessor();
+        CurrentValue = *(volatile LONG_PTR *)&SRWLock->Ptr;
     }
+
+    RtlpCountSRWLockAcquire(SRWLock);
 }
 
 
@@ -525,14 +597,14 @@ VOID
 NTAPI
 RtlReleaseSRWLockShared(IN OUT PRTL_SRWLOCK SRWLock)
 {
-    LONG_PTR CurrentValue, NewValue;
+    LONG_PTR CurrentValue, NewValue, PrevValue;
     PRTLP_SRWLOCK_WAITBLOCK WaitBlock;
     BOOLEAN LastShared;
 
+    CurrentValue = *(volatile LONG_PTR *)&SRWLock->Ptr;
+
     while (1)
     {
-        CurrentValue = *(volatile LONG_PTR *)&SRWLock->Ptr;
-
         if (CurrentValue & RTL_SRWLOCK_SHARED)
         {
             if (CurrentValue & RTL_SRWLOCK_CONTENDED)
@@ -565,13 +637,18 @@ RtlReleaseSRWLockShared(IN OUT PRTL_SRWLOCK SRWLock)
                     NewValue = (NewValue << RTL_SRWLOCK_BITS) | RTL_SRWLOCK_SHARED | RTL_SRWLOCK_OWNED;
                 }
 
-                if ((LONG_PTR)InterlockedCompareExchangePointer(&SRWLock->Ptr,
-                                                                (PVOID)NewValue,
-                                                                (PVOID)CurrentValue) == CurrentValue)
+                PrevValue = (LONG_PTR)InterlockedCompareExchangePointer(&SRWLock->Ptr,
+                                                                        (PVOID)NewValue,
+                                                                        (PVOID)CurrentValue);
+                if (PrevValue == CurrentValue)
                 {
                     /* Successfully released the lock */
                     break;
                 }
+
+                /* Another reader raced us, retry right away */
+                CurrentValue = PrevValue;
+                continue;
             }
         }
         else
@@ -582,6 +659,7 @@ RtlReleaseSRWLockShared(IN OUT PRTL_SRWLOCK SRWLock)
         }
 
         YieldProcessor();
+        CurrentValue = *(volatile LONG_PTR *)&SRWLock->Ptr;
     }
 }
 
@@ -618,7 +696,7 @@ RtlAcquireSRWLockExclusive(IN OUT PRTL_SRWLOCK SRWLock)
                     StackWaitBlock.SharedCount = (LONG)(CurrentValue >> RTL_SRWLOCK_BITS);
                     StackWaitBlock.Next = NULL;
                     StackWaitBlock.Last = &StackWaitBlock;
-                    StackWaitBlock.Wake = 0;
+                    StackWaitBlock.Wake = RTL_SRWLOCK_WAKE_PENDING;
 
                     NewValue = (ULONG_PTR)&StackWaitBlock | RTL_SRWLOCK_SHARED | RTL_SRWLOCK_CONTENDED | RTL_SRWLOCK_OWNED;
 
@@ -626,8 +704,8 @@ RtlAcquireSRWLockExclusive(IN OUT PRTL_SRWLOCK SRWLock)
                                                                     (PVOID)NewValue,
                                                                     (PVOID)CurrentValue) == CurrentValue)
                     {
-                        RtlpAcquireSRWLockExclusiveWait(SRWLock,
-                                                        &StackWaitBlock);
+                        RtlpWaitForSRWLockWake(SRWLock,
+                                               &StackWaitBlock.Wake);
 
                         /* Successfully acquired the exclusive lock */
                         break;
@@ -647,7 +725,7 @@ AddWaitBlock:
                         StackWaitBlock.SharedCount = 0;
                         StackWaitBlock.Next = NULL;
                         StackWaitBlock.Last = &StackWaitBlock;
-                        StackWaitBlock.Wake = 0;
+                        StackWaitBlock.Wake = RTL_SRWLOCK_WAKE_PENDING;
 
                         First = RtlpAcquireWaitBlockLock(SRWLock);
                         if (First != NULL)
@@ -658,8 +736,8 @@ AddWaitBlock:
 
                             RtlpReleaseWaitBlockLock(SRWLock);
 
-                            RtlpAcquireSRWLockExclusiveWait(SRWLock,
-                                                            &StackWaitBlock);
+                            RtlpWaitForSRWLockWake(SRWLock,
+                                                   &StackWaitBlock.Wake);
 
                             /* Successfully acquired the exclusive lock */
                             break;
@@ -673,15 +751,15 @@ AddWaitBlock:
                         StackWaitBlock.SharedCount = 0;
                         StackWaitBlock.Next = NULL;
                         StackWaitBlock.Last = &StackWaitBlock;
-                        StackWaitBlock.Wake = 0;
+                        StackWaitBlock.Wake = RTL_SRWLOCK_WAKE_PENDING;
 
                         NewValue = (ULONG_PTR)&StackWaitBlock | RTL_SRWLOCK_OWNED | RTL_SRWLOCK_CONTENDED;
                         if ((LONG_PTR)InterlockedCompareExchangePointer(&SRWLock->Ptr,
                                                                         (PVOID)NewValue,
                                                                         (PVOID)CurrentValue) == CurrentValue)
                         {
-                            RtlpAcquireSRWLockExclusiveWait(SRWLock,
-                                                            &StackWaitBlock);
+                            RtlpWaitForSRWLockWake(SRWLock,
+                                                   &StackWaitBlock.Wake);
 
                             /* Successfully acquired the exclusive lock */
                             break;
@@ -702,6 +780,8 @@ AddWaitBlock:
             YieldProcessor();
         }
     }
+
+    RtlpCountSRWLockAcquire(SRWLock);
 }
 
 
@@ -770,26 +850,100 @@ BOOLEAN
 NTAPI
 RtlTryAcquireSRWLockShared(PRTL_SRWLOCK SRWLock)
 {
+    LONG_PTR CurrentValue, NewValue, PrevValue;
 
-    LONG_PTR CompareValue, NewValue, GotValue;
+    CurrentValue = *(volatile LONG_PTR *)&SRWLock->Ptr;
 
-    do
+    while (1)
     {
-        CompareValue = *(volatile LONG_PTR *)&SRWLock->Ptr;
-        NewValue = ((CompareValue >> RTL_SRWLOCK_BITS) + 1) | RTL_SRWLOCK_SHARED | RTL_SRWLOCK_OWNED;
+        if (CurrentValue == 0)
+        {
+            /* Free, become the first shared owner */
+            NewValue = (1 << RTL_SRWLOCK_BITS) | RTL_SRWLOCK_SHARED | RTL_SRWLOCK_OWNED;
+        }
+        else if ((CurrentValue & RTL_SRWLOCK_MASK) == (RTL_SRWLOCK_SHARED | RTL_SRWLOCK_OWNED))
+        {
+            /* Shared without waiters, increment the shared count */
+            NewValue = CurrentValue + (_ONE << RTL_SRWLOCK_BITS);
+        }
+        else
+        {
+            /* Owned exclusively or someone is waiting */
+            return FALSE;
+        }
 
-        /* Only increment shared count if there is no waiter */
-        CompareValue &= ~RTL_SRWLOCK_MASK | RTL_SRWLOCK_SHARED | RTL_SRWLOCK_OWNED;
-    } while (
-        ((GotValue = (LONG_PTR)InterlockedCompareExchangePointer(&SRWLock->Ptr, (LONG_PTR*)NewValue, (LONG_PTR*)CompareValue)) != CompareValue)
-        && (((GotValue & RTL_SRWLOCK_MASK) == (RTL_SRWLOCK_SHARED | RTL_SRWLOCK_OWNED)) || (GotValue == 0)));
+        PrevValue = (LONG_PTR)InterlockedCompareExchangePointer(&SRWLock->Ptr,
+                                                                (PVOID)NewValue,
+                                                                (PVOID)CurrentValue);
+        if (PrevValue == CurrentValue)
+            break;
+
+        CurrentValue = PrevValue;
+    }
 
-    return ((GotValue & RTL_SRWLOCK_MASK) == (RTL_SRWLOCK_SHARED | RTL_SRWLOCK_OWNED)) || (GotValue == 0);
+    RtlpCountSRWLockAcquire(SRWLock);
+    return TRUE;
 }
 
 BOOLEAN
 NTAPI
 RtlTryAcquireSRWLockExclusive(PRTL_SRWLOCK SRWLock)
 {
-    return InterlockedCompareExchangePointer(&SRWLock->Ptr, (ULONG_PTR*)RTL_SRWLOCK_OWNED, 0) == 0;
+    if (InterlockedCompareExchangePointer(&SRWLock->Ptr, (ULONG_PTR*)RTL_SRWLOCK_OWNED, 0) != 0)
+        return FALSE;
+
+    RtlpCountSRWLockAcquire(SRWLock);
+    return TRUE;
+}
+
+/*
+ * Collects the contention counters of SRWLock into Statistics, or
+ * stops doing so when Statistics is NULL. Only a handful of locks can
+ * be tracked at once, and tracking must not be switched while the lock
+ * is in use.
+ */
+NTSTATUS
+NTAPI
+RtlpSetSRWLockStatistics(
+    _In_ PRTL_SRWLOCK SRWLock,
+    _In_opt_ PRTL_SRWLOCK_STATISTICS Statistics)
+{
+    ULONG i;
+
+    for (i = 0; i < RTL_SRWLOCK_MAX_TRACKED; i++)
+    {
+        if (RtlpSRWLockTracking.Lock[i] != SRWLock)
+            continue;
+
+        if (Statistics != NULL)
+        {
+            /* Already tracked, just switch the counters */
+            RtlpSRWLockTracking.Statistics[i] = Statistics;
+            return STATUS_SUCCESS;
+        }
+
+        InterlockedDecrement(&RtlpSRWLockTracking.Count);
+        RtlpSRWLockTracking.Statistics[i] = NULL;
+        InterlockedExchangePointer((PVOID*)&RtlpSRWLockTracking.Lock[i], NULL);
+        return STATUS_SUCCESS;
+    }
+
+    if (Statistics == NULL)
+        return STATUS_NOT_FOUND;
+
+    RtlZeroMemory(Statistics, sizeof(*Statistics));
+
+    for (i = 0; i < RTL_SRWLOCK_MAX_TRACKED; i++)
+    {
+        if (InterlockedCompareExchangePointer((PVOID*)&RtlpSRWLockTracking.Lock[i],
+                                              SRWLock,
+                                              NULL) == NULL)
+        {
+            RtlpSRWLockTracking.Statistics[i] = Statistics;
+            InterlockedIncrement(&RtlpSRWLockTracking.Count);
+            return STATUS_SUCCESS;
+        }
+    }
+
+    return STATUS_INSUFFICIENT_RESOURCES;
 }
@@ -0,0 +1,39 @@
+/*
+ * PROJECT:     ReactOS Runtime Library
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Internal definitions shared by the SRW lock and condition variable code
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#pragma once
+
+/* Contention counters of a single SRW lock, see RtlpSetSRWLockStatistics */
+typedef struct _RTL_SRWLOCK_STATISTICS
+{
+    /* Successful acquisitions, shared and exclusive */
+    LONG Acquires;
+
+    /* Acquisitions that had to queue behind the current owner */
+    LONG Contentions;
+
+    /* Contended acquisitions that were granted while still spinning */
+    LONG SpinAcquires;
+
+    /* Contended acquisitions that had to park on the keyed event */
+    LONG Waits;
+
+    /* Total number of spin iterations */
+    LONG Spins;
+
+    /* Longest contended acquisition, in performance counter ticks */
+    LONGLONG MaxWaitTime;
+} RTL_SRWLOCK_STATISTICS, *PRTL_SRWLOCK_STATISTICS;
+
+/* Keyed event of condvar.c, SRW lock waiters park on it as well */
+extern HANDLE CondVarKeyedEventHandle;
+
+NTSTATUS
+NTAPI
+RtlpSetSRWLockStatistics(
+    _In_ PRTL_SRWLOCK SRWLock,
+    _In_opt_ PRTL_SRWLOCK_STATISTICS Statistics);
@@ -142,8 +142,19 @@ struct timer_queue
  */
 
 #define THREADPOOL_WORKER_TIMEOUT 5000
+#define THREADPOOL_MAX_QUEUES 16
 #define MAXIMUM_WAITQUEUE_OBJECTS (MAXIMUM_WAIT_OBJECTS - 1)
 
+/* work queue of a threadpool, there is one per processor */
+struct threadpool_queue
+{
+    /* locks the lists below and the callback state of all objects homed on this queue */
+    CRITICAL_SECTION        cs;
+    /* Pools of work items, locked via .cs, order matches TP_CALLBACK_PRIORITY - high, normal, low. */
+    struct list             pools[3];
+    LONG                    depth;
+};
+
 /* internal threadpool representation */
 struct threadpool
 {
@@ -151,14 +162,23 @@ struct threadpool
     LONG                    objcount;
     BOOL                    shutdown;
     CRITICAL_SECTION        cs;
-    /* Pools of work items, locked via .cs, order matches TP_CALLBACK_PRIORITY - high, normal, low. */
-    struct list             pools[3];
+    /* Workers take items from the queue of their own thread first, and steal
+     * from the other queues when it is empty. Objects stay on the queue they
+     * were assigned to at creation. */
+    struct threadpool_queue queues[THREADPOOL_MAX_QUEUES];
+    unsigned int            num_queues;
+    LONG                    num_queued;
     RTL_CONDITION_VARIABLE  update_event;
     /* information about worker threads, locked via .cs */
     int                     max_workers;
     int                     min_workers;
     int                     num_workers;
-    int                     num_busy_workers;
+    LONG                    num_idle_workers;
+    LONG                    num_pending_wakes;
+    /* updated with interlocked operations */
+    LONG                    num_busy_workers;
+    LONG                    num_steals;
+    LONG                    num_wakeups;
     HANDLE                  compl_port;
     TP_POOL_STACK_INFORMATION stack_info;
 };
@@ -187,6 +207,7 @@ struct threadpool_object
     /* read-only information */
     enum threadpool_objtype type;
     struct threadpool       *pool;
+    struct threadpool_queue *queue;
     struct threadpool_group *group;
     PVOID                   userdata;
     PTP_CLEANUP_GROUP_CANCEL_CALLBACK group_cancel_callback;
@@ -197,7 +218,7 @@ struct threadpool_object
     /* information about the group, locked via .group->cs */
     struct list             group_entry;
     BOOL                    is_group_member;
-    /* information about the pool, locked via .pool->cs */
+    /* information about the pool, locked via .queue->cs */
     struct list             pool_entry;
     RTL_CONDITION_VARIABLE  finished_event;
     RTL_CONDITION_VARIABLE  group_finished_event;
@@ -244,7 +265,7 @@ struct threadpool_object
         struct
         {
             PTP_IO_CALLBACK callback;
-            /* locked via .pool->cs */
+            /* locked via .queue->cs */
             unsigned int    pending_count, skipped_count, completion_count, completion_max;
             BOOL            shutting_down;
             struct io_completion *completions;
@@ -1377,9 +1398,9 @@ static void CALLBACK waitqueue_thread_proc( void *param )
                 {
                     InterlockedIncrement( &wait->refcount );
                     wait->num_pending_callbacks++;
-                    RtlEnterCriticalSection( &wait->pool->cs );
+                    RtlEnterCriticalSection( &wait->queue->cs );
                     tp_object_execute( wait, TRUE );
-                    RtlLeaveCriticalSection( &wait->pool->cs );
+                    RtlLeaveCriticalSection( &wait->queue->cs );
                     tp_object_release( wait );
                 }
                 else tp_object_submit( wait, FALSE );
@@ -1434,9 +1455,9 @@ static void CALLBACK waitqueue_thread_proc( void *param )
                     {
                         wait->u.wait.signaled++;
                         wait->num_pending_callbacks++;
-                        RtlEnterCriticalSection( &wait->pool->cs );
+                        RtlEnterCriticalSection( &wait->queue->cs );
                         tp_object_execute( wait, TRUE );
-                        RtlLeaveCriticalSection( &wait->pool->cs );
+                        RtlLeaveCriticalSection( &wait->queue->cs );
                     }
                     else tp_object_submit( wait, TRUE );
                 }
@@ -1648,7 +1669,7 @@ static void CALLBACK ioqueue_thread_proc( void *param )
 
         if (io && (io->shutdown || io->u.io.shutting_down))
         {
-            RtlEnterCriticalSection( &io->pool->cs );
+            RtlEnterCriticalSection( &io->queue->cs );
             if (!io->u.io.pending_count)
             {
                 if (io->u.io.skipped_count)
@@ -1659,7 +1680,7 @@ static void CALLBACK ioqueue_thread_proc( void *param )
                 else
                     destroy = TRUE;
             }
-            RtlLeaveCriticalSection( &io->pool->cs );
+            RtlLeaveCriticalSection( &io->queue->cs );
             if (skip) continue;
         }
 
@@ -1672,7 +1693,7 @@ static void CALLBACK ioqueue_thread_proc( void *param )
         }
         else if (io)
         {
-            RtlEnterCriticalSection( &io->pool->cs );
+            RtlEnterCriticalSection( &io->queue->cs );
 
             TRACE( "pending_count %u.\n", io->u.io.pending_count );
 
@@ -1683,7 +1704,7 @@ static void CALLBACK ioqueue_thread_proc( void *param )
                         io->u.io.completion_count + 1, sizeof(*io->u.io.completions)))
                 {
                     ERR( "Failed to allocate memory.\n" );
-                    RtlLeaveCriticalSection( &io->pool->cs );
+                    RtlLeaveCriticalSection( &io->queue->cs );
                     continue;
                 }
 
@@ -1697,7 +1718,7 @@ static void CALLBACK ioqueue_thread_proc( void *param )
 
                 tp_object_submit( io, FALSE );
             }
-            RtlLeaveCriticalSection( &io->pool->cs );
+            RtlLeaveCriticalSection( &io->queue->cs );
         }
 
         if (!ioqueue.objcount)
@@ -1790,7 +1811,7 @@ static NTSTATUS tp_threadpool_alloc( struct threadpool **out )
     IMAGE_NT_HEADERS *nt = RtlImageNtHeader( NtCurrentTeb()->Peb->ImageBaseAddress );
 #endif
     struct threadpool *pool;
-    unsigned int i;
+    unsigned int i, j;
 
     pool = RtlAllocateHeap( GetProcessHeap(), 0, sizeof(*pool) );
     if (!pool)
@@ -1808,14 +1829,39 @@ static NTSTATUS tp_threadpool_alloc( struct threadpool **out )
     pool->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": threadpool.cs");
 #endif
 
-    for (i = 0; i < ARRAY_SIZE(pool->pools); ++i)
-        list_init( &pool->pools[i] );
+#ifdef __REACTOS__
+    pool->num_queues = min( NtCurrentTeb()->ProcessEnvironmentBlock->NumberOfProcessors, THREADPOOL_MAX_QUEUES );
+#else
+    pool->num_queues = min( NtCurrentTeb()->Peb->NumberOfProcessors, THREADPOOL_MAX_QUEUES );
+#endif
+    pool->num_queues = max( pool->num_queues, 1 );
+    pool->num_queued = 0;
+
+    for (i = 0; i < pool->num_queues; ++i)
+    {
+        struct threadpool_queue *queue = &pool->queues[i];
+
+#ifdef __REACTOS__
+        RtlInitializeCriticalSection( &queue->cs );
+#else
+        RtlInitializeCriticalSectionEx( &queue->cs, 0, RTL_CRITICAL_SECTION_FLAG_FORCE_DEBUG_INFO );
+
+        queue->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": threadpool_queue.cs");
+#endif
+        for (j = 0; j < ARRAY_SIZE(queue->pools); ++j)
+            list_init( &queue->pools[j] );
+        queue->depth = 0;
+    }
     RtlInitializeConditionVariable( &pool->update_event );
 
     pool->max_workers             = 500;
     pool->min_workers             = 0;
     pool->num_workers             = 0;
+    pool->num_idle_workers        = 0;
+    pool->num_pending_wakes       = 0;
     pool->num_busy_workers        = 0;
+    pool->num_steals              = 0;
+    pool->num_wakeups             = 0;
     pool->stack_info.StackReserve = nt->OptionalHeader.SizeOfStackReserve;
     pool->stack_info.StackCommit  = nt->OptionalHeader.SizeOfStackCommit;
 
@@ -1847,7 +1893,7 @@ static void tp_threadpool_shutdown( struct threadpool *pool )
  */
 static BOOL tp_threadpool_release( struct threadpool *pool )
 {
-    unsigned int i;
+    unsigned int i, j;
 
     if (InterlockedDecrement( &pool->refcount ))
         return FALSE;
@@ -1856,8 +1902,18 @@ static BOOL tp_threadpool_release( struct threadpool *pool )
 
     assert( pool->shutdown );
     assert( !pool->objcount );
-    for (i = 0; i < ARRAY_SIZE(pool->pools); ++i)
-        assert( list_empty( &pool->pools[i] ) );
+    assert( !pool->num_queued );
+    for (i = 0; i < pool->num_queues; ++i)
+    {
+        struct threadpool_queue *queue = &pool->queues[i];
+
+        for (j = 0; j < ARRAY_SIZE(queue->pools); ++j)
+            assert( list_empty( &queue->pools[j] ) );
+#ifndef __REACTOS__
+        queue->cs.DebugInfo->Spare[0] = 0;
+#endif
+        RtlDeleteCriticalSection( &queue->cs );
+    }
 #ifndef __REACTOS__
     pool->cs.DebugInfo->Spare[0] = 0;
 #endif
@@ -1918,19 +1974,28 @@ static NTSTATUS tp_threadpool_lock( struct threadpool **out, TP_CALLBACK_ENVIRON
 
         pool = default_threadpool;
     }
- 
+
+    /* Keep a reference, and increment objcount to ensure that the
+     * last thread doesn't terminate. Should the last thread terminate
+     * anyway, tp_threadpool_wake starts a new one on the next submit. */
+    if (*(volatile int *)&pool->num_workers)
+    {
+        InterlockedIncrement( &pool->refcount );
+        InterlockedIncrement( &pool->objcount );
+        *out = pool;
+        return STATUS_SUCCESS;
+    }
+
     RtlEnterCriticalSection( &pool->cs );
 
     /* Make sure that the threadpool has at least one thread. */
     if (!pool->num_workers)
         status = tp_new_worker_thread( pool );
 
-    /* Keep a reference, and increment objcount to ensure that the
-     * last thread doesn't terminate. */
     if (status == STATUS_SUCCESS)
     {
         InterlockedIncrement( &pool->refcount );
-        pool->objcount++;
+        InterlockedIncrement( &pool->objcount );
     }
 
     RtlLeaveCriticalSection( &pool->cs );
@@ -1949,12 +2014,76 @@ static NTSTATUS tp_threadpool_lock( struct threadpool **out, TP_CALLBACK_ENVIRON
  */
 static void tp_threadpool_unlock( struct threadpool *pool )
 {
-    RtlEnterCriticalSection( &pool->cs );
-    pool->objcount--;
-    RtlLeaveCriticalSection( &pool->cs );
+    InterlockedDecrement( &pool->objcount );
     tp_threadpool_release( pool );
 }
 
+/***********************************************************************
+ *           tp_threadpool_get_queue    (internal)
+ *
+ * Returns the work queue for new objects. Without an affinity hint in the
+ * callback environment, the queue is picked by the calling thread, so that
+ * work posted from a worker thread usually ends up in its own queue.
+ */
+static struct threadpool_queue *tp_threadpool_get_queue( struct threadpool *pool,
+                                                         TP_CALLBACK_ENVIRON *environment )
+{
+    ULONG index;
+
+#ifdef __REACTOS__
+    if (environment && environment->u.s.Private)
+        index = TP_CALLBACK_AFFINITY_FROM_PRIVATE( environment->u.s.Private );
+    else
+#endif
+    /* thread ids are multiples of four */
+    index = GetCurrentThreadId() / 4;
+
+    return &pool->queues[index % pool->num_queues];
+}
+
+/***********************************************************************
+ *           tp_threadpool_wake    (internal)
+ *
+ * Makes sure that a worker thread picks up a newly queued item. Wakeups
+ * are batched: as long as there are already as many wakeups in flight
+ * as queued items, the pool lock isn't taken at all.
+ */
+static void tp_threadpool_wake( struct threadpool *pool )
+{
+    NTSTATUS status = STATUS_UNSUCCESSFUL;
+
+    /* Start new worker threads if required. */
+    if (pool->num_busy_workers >= pool->num_workers &&
+        pool->num_workers < pool->max_workers)
+    {
+        RtlEnterCriticalSection( &pool->cs );
+        if (pool->num_busy_workers >= pool->num_workers &&
+            pool->num_workers < pool->max_workers)
+            status = tp_new_worker_thread( pool );
+        RtlLeaveCriticalSection( &pool->cs );
+
+        if (status == STATUS_SUCCESS)
+            return;
+    }
+
+    /* No new thread started - wake up one existing thread, unless all idle
+     * workers have been woken already. The submitter has incremented
+     * num_queued with a full barrier, and workers increment num_idle_workers
+     * before they look at it, so one of both sides always notices the other. */
+    if (*(volatile LONG *)&pool->num_idle_workers > *(volatile LONG *)&pool->num_pending_wakes)
+    {
+        RtlEnterCriticalSection( &pool->cs );
+        if (pool->num_idle_workers > pool->num_pending_wakes &&
+            pool->num_pending_wakes < pool->num_queued)
+        {
+            pool->num_pending_wakes++;
+            InterlockedIncrement( &pool->num_wakeups );
+            RtlWakeConditionVariable( &pool->update_event );
+        }
+        RtlLeaveCriticalSection( &pool->cs );
+    }
+}
+
 /***********************************************************************
  *           tp_group_alloc    (internal)
  *
@@ -2035,6 +2164,7 @@ static void tp_object_initialize( struct threadpool_object *object, struct threa
     object->shutdown                = FALSE;
 
     object->pool                    = pool;
+    object->queue                   = tp_threadpool_get_queue( pool, environment );
     object->group                   = NULL;
     object->userdata                = userdata;
     object->group_cancel_callback   = NULL;
@@ -2070,7 +2200,7 @@ static void tp_object_initialize( struct threadpool_object *object, struct threa
             TP_CALLBACK_ENVIRON_V3 *environment_v3 = (TP_CALLBACK_ENVIRON_V3 *)environment;
 
             object->priority = environment_v3->CallbackPriority;
-            assert( object->priority < ARRAY_SIZE(pool->pools) );
+            assert( object->priority < ARRAY_SIZE(object->queue->pools) );
         }
 #endif
         if (environment->ActivationContext)
@@ -2109,8 +2239,17 @@ static void tp_object_initialize( struct threadpool_object *object, struct threa
 
 static void tp_object_prio_queue( struct threadpool_object *object )
 {
-    ++object->pool->num_busy_workers;
-    list_add_tail( &object->pool->pools[object->priority], &object->pool_entry );
+    InterlockedIncrement( &object->pool->num_busy_workers );
+    list_add_tail( &object->queue->pools[object->priority], &object->pool_entry );
+    object->queue->depth++;
+    InterlockedIncrement( &object->pool->num_queued );
+}
+
+static void tp_object_prio_dequeue( struct threadpool_object *object )
+{
+    list_remove( &object->pool_entry );
+    object->queue->depth--;
+    InterlockedDecrement( &object->pool->num_queued );
 }
 
 /***********************************************************************
@@ -2122,17 +2261,12 @@ static void tp_object_prio_queue( struct threadpool_object *object )
 static void tp_object_submit( struct threadpool_object *object, BOOL signaled )
 {
     struct threadpool *pool = object->pool;
-    NTSTATUS status = STATUS_UNSUCCESSFUL;
+    struct threadpool_queue *queue = object->queue;
 
     assert( !object->shutdown );
     assert( !pool->shutdown );
 
-    RtlEnterCriticalSection( &pool->cs );
-
-    /* Start new worker threads if required. */
-    if (pool->num_busy_workers >= pool->num_workers &&
-        pool->num_workers < pool->max_workers)
-        status = tp_new_worker_thread( pool );
+    RtlEnterCriticalSection( &queue->cs );
 
     /* Queue work item and increment refcount. */
     InterlockedIncrement( &object->refcount );
@@ -2143,14 +2277,11 @@ static void tp_object_submit( struct threadpool_object *object, BOOL signaled )
     if (object->type == TP_OBJECT_TYPE_WAIT && signaled)
         object->u.wait.signaled++;
 
-    /* No new thread started - wake up one existing thread. */
-    if (status != STATUS_SUCCESS)
-    {
-        assert( pool->num_workers > 0 );
-        RtlWakeConditionVariable( &pool->update_event );
-    }
+    /* Still under the queue lock, the item can't have been executed (and
+     * released the last reference to the pool) yet. */
+    tp_threadpool_wake( pool );
 
-    RtlLeaveCriticalSection( &pool->cs );
+    RtlLeaveCriticalSection( &queue->cs );
 }
 
 /***********************************************************************
@@ -2160,15 +2291,15 @@ static void tp_object_submit( struct threadpool_object *object, BOOL signaled )
  */
 static void tp_object_cancel( struct threadpool_object *object )
 {
-    struct threadpool *pool = object->pool;
+    struct threadpool_queue *queue = object->queue;
     LONG pending_callbacks = 0;
 
-    RtlEnterCriticalSection( &pool->cs );
+    RtlEnterCriticalSection( &queue->cs );
     if (object->num_pending_callbacks)
     {
         pending_callbacks = object->num_pending_callbacks;
         object->num_pending_callbacks = 0;
-        list_remove( &object->pool_entry );
+        tp_object_prio_dequeue( object );
 
         if (object->type == TP_OBJECT_TYPE_WAIT)
             object->u.wait.signaled = 0;
@@ -2178,7 +2309,7 @@ static void tp_object_cancel( struct threadpool_object *object )
         object->u.io.skipped_count += object->u.io.pending_count;
         object->u.io.pending_count = 0;
     }
-    RtlLeaveCriticalSection( &pool->cs );
+    RtlLeaveCriticalSection( &queue->cs );
 
     while (pending_callbacks--)
         tp_object_release( object );
@@ -2205,17 +2336,17 @@ static BOOL object_is_finished( struct threadpool_object *object, BOOL group )
  */
 static void tp_object_wait( struct threadpool_object *object, BOOL group_wait )
 {
-    struct threadpool *pool = object->pool;
+    struct threadpool_queue *queue = object->queue;
 
-    RtlEnterCriticalSection( &pool->cs );
+    RtlEnterCriticalSection( &queue->cs );
     while (!object_is_finished( object, group_wait ))
     {
         if (group_wait)
-            RtlSleepConditionVariableCS( &object->group_finished_event, &pool->cs, NULL );
+            RtlSleepConditionVariableCS( &object->group_finished_event, &queue->cs, NULL );
         else
-            RtlSleepConditionVariableCS( &object->finished_event, &pool->cs, NULL );
+            RtlSleepConditionVariableCS( &object->finished_event, &queue->cs, NULL );
     }
-    RtlLeaveCriticalSection( &pool->cs );
+    RtlLeaveCriticalSection( &queue->cs );
 }
 
 static void tp_ioqueue_unlock( struct threadpool_object *io )
@@ -2292,24 +2423,70 @@ static BOOL tp_object_release( struct threadpool_object *object )
     return TRUE;
 }
 
-static struct list *threadpool_get_next_item( const struct threadpool *pool )
+static struct list *threadpool_get_next_item( const struct threadpool_queue *queue )
 {
     struct list *ptr;
     unsigned int i;
 
-    for (i = 0; i < ARRAY_SIZE(pool->pools); ++i)
+    for (i = 0; i < ARRAY_SIZE(queue->pools); ++i)
     {
-        if ((ptr = list_head( &pool->pools[i] )))
+        if ((ptr = list_head( &queue->pools[i] )))
             break;
     }
 
     return ptr;
 }
 
+/***********************************************************************
+ *           threadpool_get_next_object    (internal)
+ *
+ * Takes the next work item, looking at the home queue of the worker
+ * first and stealing from the other queues when it is empty. On success
+ * the queue lock of the returned object is held.
+ */
+static struct threadpool_object *threadpool_get_next_object( struct threadpool *pool,
+                                                             unsigned int home )
+{
+    struct threadpool_object *object;
+    struct threadpool_queue *queue;
+    struct list *ptr;
+    unsigned int i;
+
+    for (i = 0; i < pool->num_queues; ++i)
+    {
+        queue = &pool->queues[(home + i) % pool->num_queues];
+
+        /* Don't bother locking queues that look empty. */
+        if (!*(volatile LONG *)&queue->depth)
+            continue;
+
+        RtlEnterCriticalSection( &queue->cs );
+        if ((ptr = threadpool_get_next_item( queue )))
+        {
+            object = LIST_ENTRY( ptr, struct threadpool_object, pool_entry );
+            assert( object->num_pending_callbacks > 0 );
+
+            /* If further pending callbacks are queued, move the work item to
+             * the end of the pool list. Otherwise remove it from the pool. */
+            tp_object_prio_dequeue( object );
+            if (object->num_pending_callbacks > 1)
+                tp_object_prio_queue( object );
+
+            if (i)
+                InterlockedIncrement( &pool->num_steals );
+
+            return object;
+        }
+        RtlLeaveCriticalSection( &queue->cs );
+    }
+
+    return NULL;
+}
+
 /***********************************************************************
  *           tp_object_execute    (internal)
  *
- * Executes a threadpool object callback, object->pool->cs has to be
+ * Executes a threadpool object callback, object->queue->cs has to be
  * held.
  */
 static void tp_object_execute( struct threadpool_object *object, BOOL wait_thread )
@@ -2317,7 +2494,7 @@ static void tp_object_execute( struct threadpool_object *object, BOOL wait_threa
     TP_CALLBACK_INSTANCE *callback_instance;
     struct threadpool_instance instance;
     struct io_completion completion;
-    struct threadpool *pool = object->pool;
+    struct threadpool_queue *queue = object->queue;
     TP_WAIT_RESULT wait_result = 0;
     NTSTATUS status;
 
@@ -2338,7 +2515,7 @@ static void tp_object_execute( struct threadpool_object *object, BOOL wait_threa
     /* Leave critical section and do the actual callback. */
     object->num_associated_callbacks++;
     object->num_running_callbacks++;
-    RtlLeaveCriticalSection( &pool->cs );
+    RtlLeaveCriticalSection( &queue->cs );
     if (wait_thread) RtlLeaveCriticalSection( &waitqueue.cs );
 
     /* Initialize threadpool instance struct. */
@@ -2444,7 +2621,7 @@ static void tp_object_execute( struct threadpool_object *object, BOOL wait_threa
 
 skip_cleanup:
     if (wait_thread) RtlEnterCriticalSection( &waitqueue.cs );
-    RtlEnterCriticalSection( &pool->cs );
+    RtlEnterCriticalSection( &queue->cs );
 
     /* Simple callbacks are automatically shutdown after execution. */
     if (object->type == TP_OBJECT_TYPE_SIMPLE)
@@ -2475,37 +2652,49 @@ static void CALLBACK threadpool_worker_proc( void *param )
 #endif
 {
     struct threadpool *pool = param;
+    struct threadpool_object *object;
+    struct threadpool_queue *queue;
     LARGE_INTEGER timeout;
-    struct list *ptr;
+    unsigned int home;
+    NTSTATUS status;
 
     TRACE( "starting worker thread for pool %p\n", pool );
     set_thread_name(L"wine_threadpool_worker");
 
-    RtlEnterCriticalSection( &pool->cs );
+    home = tp_threadpool_get_queue( pool, NULL ) - pool->queues;
+
     for (;;)
     {
-        while ((ptr = threadpool_get_next_item( pool )))
+        while ((object = threadpool_get_next_object( pool, home )))
         {
-            struct threadpool_object *object = LIST_ENTRY( ptr, struct threadpool_object, pool_entry );
-            assert( object->num_pending_callbacks > 0 );
-
-            /* If further pending callbacks are queued, move the work item to
-             * the end of the pool list. Otherwise remove it from the pool. */
-            list_remove( &object->pool_entry );
-            if (object->num_pending_callbacks > 1)
-                tp_object_prio_queue( object );
-
+            queue = object->queue;
             tp_object_execute( object, FALSE );
+            RtlLeaveCriticalSection( &queue->cs );
 
             assert(pool->num_busy_workers);
-            pool->num_busy_workers--;
+            InterlockedDecrement( &pool->num_busy_workers );
 
             tp_object_release( object );
         }
 
+        RtlEnterCriticalSection( &pool->cs );
+
+        /* Announce that this thread is about to sleep, then look for work
+         * that was queued in the meantime, see tp_threadpool_wake. */
+        InterlockedIncrement( &pool->num_idle_workers );
+        if (*(volatile LONG *)&pool->num_queued)
+        {
+            InterlockedDecrement( &pool->num_idle_workers );
+            RtlLeaveCriticalSection( &pool->cs );
+            continue;
+        }
+
         /* Shutdown worker thread if requested. */
         if (pool->shutdown)
+        {
+            InterlockedDecrement( &pool->num_idle_workers );
             break;
+        }
 
         /* Wait for new tasks or until the timeout expires. A thread only terminates
          * when no new tasks are available, and the number of threads can be
@@ -2513,12 +2702,18 @@ static void CALLBACK threadpool_worker_proc( void *param )
          * min_workers == 0, then objcount is used to detect if the last thread
          * can be terminated. */
         timeout.QuadPart = (ULONGLONG)THREADPOOL_WORKER_TIMEOUT * -10000;
-        if (RtlSleepConditionVariableCS( &pool->update_event, &pool->cs, &timeout ) == STATUS_TIMEOUT &&
-            !threadpool_get_next_item( pool ) && (pool->num_workers > max( pool->min_workers, 1 ) ||
+        status = RtlSleepConditionVariableCS( &pool->update_event, &pool->cs, &timeout );
+        InterlockedDecrement( &pool->num_idle_workers );
+        if (pool->num_pending_wakes)
+            pool->num_pending_wakes--;
+
+        if (status == STATUS_TIMEOUT && !pool->num_queued &&
+            (pool->num_workers > max( pool->min_workers, 1 ) ||
             (!pool->min_workers && !pool->objcount)))
         {
             break;
         }
+        RtlLeaveCriticalSection( &pool->cs );
     }
     pool->num_workers--;
     RtlLeaveCriticalSection( &pool->cs );
@@ -2724,7 +2919,7 @@ void WINAPI TpCancelAsyncIoOperation( TP_IO *io )
 
     TRACE( "%p\n", io );
 
-    RtlEnterCriticalSection( &this->pool->cs );
+    RtlEnterCriticalSection( &this->queue->cs );
 
     TRACE("pending_count %u.\n", this->u.io.pending_count);
 
@@ -2734,7 +2929,7 @@ void WINAPI TpCancelAsyncIoOperation( TP_IO *io )
     if (object_is_finished( this, FALSE ))
         RtlWakeAllConditionVariable( &this->finished_event );
 
-    RtlLeaveCriticalSection( &this->pool->cs );
+    RtlLeaveCriticalSection( &this->queue->cs );
 }
 
 /***********************************************************************
@@ -2854,7 +3049,7 @@ VOID WINAPI TpDisassociateCallback( TP_CALLBACK_INSTANCE *instance )
 {
     struct threadpool_instance *this = impl_from_TP_CALLBACK_INSTANCE( instance );
     struct threadpool_object *object = this->object;
-    struct threadpool *pool;
+    struct threadpool_queue *queue;
 
     TRACE( "%p\n", instance );
 
@@ -2867,14 +3062,14 @@ VOID WINAPI TpDisassociateCallback( TP_CALLBACK_INSTANCE *instance )
     if (!this->associated)
         return;
 
-    pool = object->pool;
-    RtlEnterCriticalSection( &pool->cs );
+    queue = object->queue;
+    RtlEnterCriticalSection( &queue->cs );
 
     object->num_associated_callbacks--;
     if (object_is_finished( object, FALSE ))
         RtlWakeAllConditionVariable( &object->finished_event );
 
-    RtlLeaveCriticalSection( &pool->cs );
+    RtlLeaveCriticalSection( &queue->cs );
     this->associated = FALSE;
 }
 
@@ -2998,10 +3193,10 @@ void WINAPI TpReleaseIoCompletion( TP_IO *io )
 
     TRACE( "%p\n", io );
 
-    RtlEnterCriticalSection( &this->pool->cs );
+    RtlEnterCriticalSection( &this->queue->cs );
     this->u.io.shutting_down = TRUE;
     can_destroy = !this->u.io.pending_count && !this->u.io.skipped_count;
-    RtlLeaveCriticalSection( &this->pool->cs );
+    RtlLeaveCriticalSection( &this->queue->cs );
 
     if (can_destroy)
     {
@@ -3279,11 +3474,11 @@ void WINAPI TpStartAsyncIoOperation( TP_IO *io )
 
     TRACE( "%p\n", io );
 
-    RtlEnterCriticalSection( &this->pool->cs );
+    RtlEnterCriticalSection( &this->queue->cs );
 
     this->u.io.pending_count++;
 
-    RtlLeaveCriticalSection( &this->pool->cs );
+    RtlLeaveCriticalSection( &this->queue->cs );
 }
 
 /***********************************************************************
@@ -3380,6 +3575,44 @@ NTSTATUS WINAPI TpQueryPoolStackInformation( TP_POOL *pool, TP_POOL_STACK_INFORM
     return STATUS_SUCCESS;
 }
 
+#ifdef __REACTOS__
+/***********************************************************************
+ *           TpQueryPoolStatistics    (NTDLL.@)
+ *
+ * Returns a snapshot of the scheduler state of a pool, or of the default
+ * pool if pool is NULL.
+ */
+NTSTATUS WINAPI TpQueryPoolStatistics( TP_POOL *pool, TP_POOL_STATISTICS *stats )
+{
+    struct threadpool *this = pool ? impl_from_TP_POOL( pool ) : default_threadpool;
+    unsigned int i;
+
+    TRACE( "%p %p\n", pool, stats );
+
+    if (!stats)
+        return STATUS_INVALID_PARAMETER;
+
+    memset( stats, 0, sizeof(*stats) );
+    if (!this)
+        return STATUS_SUCCESS;
+
+    RtlEnterCriticalSection( &this->cs );
+    stats->NumberOfQueues   = this->num_queues;
+    stats->QueueDepth       = this->num_queued;
+    stats->Workers          = this->num_workers;
+    stats->IdleWorkers      = this->num_idle_workers;
+    stats->BusyWorkers      = this->num_busy_workers;
+    stats->Steals           = this->num_steals;
+    stats->Wakeups          = this->num_wakeups;
+    RtlLeaveCriticalSection( &this->cs );
+
+    for (i = 0; i < this->num_queues; ++i)
+        stats->MaxQueueDepth = max( stats->MaxQueueDepth, (ULONG)*(volatile LONG *)&this->queues[i].depth );
+
+    return STATUS_SUCCESS;
+}
+#endif
+
 static void CALLBACK rtl_wait_callback( TP_CALLBACK_INSTANCE *instance, void *userdata, TP_WAIT *wait, TP_WAIT_RESULT result )
 {
     struct threadpool_object *object = impl_from_TP_WAIT(wait);
@@ -3475,11 +3708,11 @@ NTSTATUS WINAPI RtlDeregisterWaitEx( HANDLE handle, HANDLE event )
         object->completed_event = event;
     }
 
-    RtlEnterCriticalSection( &object->pool->cs );
+    RtlEnterCriticalSection( &object->queue->cs );
     if (object->num_pending_callbacks + object->num_running_callbacks
         + object->num_associated_callbacks) status = STATUS_PENDING;
     else status = STATUS_SUCCESS;
-    RtlLeaveCriticalSection( &object->pool->cs );
+    RtlLeaveCriticalSection( &object->queue->cs );
 
     TpReleaseWait( (TP_WAIT *)object );
     return status;
@@ -0,0 +1,1048 @@
+/*
+ * PROJECT:     ReactOS Runtime Library
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     XPRESS (plain LZ77) and XPRESS Huffman (LZ77+Huffman) engines
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+/*
+ * Both formats are described in [MS-XCA]. Plain XPRESS interleaves 32-bit
+ * flag words with literals and 16-bit match tokens over an 8 KB window.
+ * XPRESS Huffman splits the output in 64 KB chunks, each starting with a
+ * table of 512 4-bit code lengths followed by a bit stream of 16-bit words.
+ */
+
+/* INCLUDES *****************************************************************/
+
+#include "compress.h"
+
+#define NDEBUG
+#include <debug.h>
+
+/* GLOBALS ******************************************************************/
+
+#define XPRESS_WINDOW_BITS          13
+#define XPRESS_MAX_OFFSET           (1UL << XPRESS_WINDOW_BITS)
+#define XPRESS_HASH_BITS            13
+/* Parsed in small pieces, which keeps every length within the 16-bit escape */
+#define XPRESS_PIECE_SIZE           0x1000
+
+#define XPRESS_HUFF_CHUNK_SIZE      0x10000
+#define XPRESS_HUFF_SYMBOLS         512
+#define XPRESS_HUFF_TABLE_SIZE      (XPRESS_HUFF_SYMBOLS / 2)
+#define XPRESS_HUFF_MAX_CODE_LENGTH 15
+#define XPRESS_HUFF_EOB             256
+#define XPRESS_HUFF_WINDOW_BITS     16
+#define XPRESS_HUFF_MAX_OFFSET      0xFFFF
+#define XPRESS_HUFF_HASH_BITS       15
+#define XPRESS_HUFF_FAST_BITS       9
+
+/* Match finder effort for each engine */
+#define XPRESS_STANDARD_CHAIN       8
+#define XPRESS_STANDARD_NICE        32
+#define XPRESS_MAXIMUM_CHAIN        256
+#define XPRESS_MAXIMUM_NICE         192
+
+/*
+ * Parsed items: literals are stored as the byte value, matches as
+ * (Offset << 16) | (Length - 3). Offsets are never 0, so a match item
+ * is always above 0xFFFF.
+ */
+#define XPRESS_ITEM_IS_MATCH(Item)  ((Item) > 0xFFFF)
+#define XPRESS_ITEM_OFFSET(Item)    ((Item) >> 16)
+#define XPRESS_ITEM_LENGTH(Item)    ((Item) & 0xFFFF)
+
+typedef struct _XPRESS_WORKSPACE
+{
+    ULONG Items[XPRESS_PIECE_SIZE];
+    /* The match finder follows */
+} XPRESS_WORKSPACE, *PXPRESS_WORKSPACE;
+
+typedef struct _XPRESS_HUFF_WORKSPACE
+{
+    ULONG Frequency[XPRESS_HUFF_SYMBOLS];
+    ULONG Sorted[XPRESS_HUFF_SYMBOLS];
+    USHORT Symbols[XPRESS_HUFF_SYMBOLS];
+    USHORT Codes[XPRESS_HUFF_SYMBOLS];
+    UCHAR Lengths[XPRESS_HUFF_SYMBOLS];
+    ULONG Items[XPRESS_HUFF_CHUNK_SIZE];
+    /* The match finder follows */
+} XPRESS_HUFF_WORKSPACE, *PXPRESS_HUFF_WORKSPACE;
+
+typedef struct _XPRESS_BIT_WRITER
+{
+    PUCHAR Buffer;
+    ULONG Size;
+    ULONG Position;
+    ULONG Current;
+    ULONG Next;
+    ULONG Accumulator;
+    ULONG BitCount;
+    BOOLEAN NextReserved;
+    BOOLEAN Overflow;
+} XPRESS_BIT_WRITER, *PXPRESS_BIT_WRITER;
+
+/* FUNCTIONS ****************************************************************/
+
+FORCEINLINE
+ULONG
+RtlpXpressReadUshort(IN PUCHAR Buffer)
+{
+    return Buffer[0] | (Buffer[1] << 8);
+}
+
+FORCEINLINE
+ULONG
+RtlpXpressReadUlong(IN PUCHAR Buffer)
+{
+    return Buffer[0] | (Buffer[1] << 8) | (Buffer[2] << 16) | ((ULONG)Buffer[3] << 24);
+}
+
+FORCEINLINE
+VOID
+RtlpXpressWriteUshort(IN PUCHAR Buffer, IN ULONG Value)
+{
+    Buffer[0] = (UCHAR)Value;
+    Buffer[1] = (UCHAR)(Value >> 8);
+}
+
+FORCEINLINE
+VOID
+RtlpXpressWriteUlong(IN PUCHAR Buffer, IN ULONG Value)
+{
+    Buffer[0] = (UCHAR)Value;
+    Buffer[1] = (UCHAR)(Value >> 8);
+    Buffer[2] = (UCHAR)(Value >> 16);
+    Buffer[3] = (UCHAR)(Value >> 24);
+}
+
+FORCEINLINE
+ULONG
+RtlpXpressHighBit(IN ULONG Value)
+{
+    ULONG Bit = 0;
+
+    while (Value >>= 1)
+        Bit++;
+
+    return Bit;
+}
+
+/* Small inputs get a smaller hash, there is less of it to clear */
+FORCEINLINE
+ULONG
+RtlpXpressHashBits(IN ULONG InputSize, IN ULONG MaxHashBits)
+{
+    ULONG HashBits = RtlpXpressHighBit(InputSize | 0x400) + 1;
+
+    return min(HashBits, MaxHashBits);
+}
+
+/* Copy a match, source and destination may overlap */
+FORCEINLINE
+VOID
+RtlpXpressCopyMatch(IN PUCHAR Destination, IN ULONG Offset, IN ULONG Length)
+{
+    PUCHAR Source = Destination - Offset;
+
+    if (Offset >= Length)
+    {
+        RtlCopyMemory(Destination, Source, Length);
+        return;
+    }
+
+    while (Length--)
+        *Destination++ = *Source++;
+}
+
+static
+ULONG
+RtlpXpressParse(IN PRTLP_LZ_MATCH_FINDER Finder,
+                IN ULONG Position,
+                IN ULONG End,
+                IN ULONG InputSize,
+                IN BOOLEAN Lazy,
+                IN BOOLEAN Huffman,
+                OUT PULONG Items)
+{
+    ULONG Count = 0;
+    ULONG Length, Offset = 0, NextLength = 0, NextOffset = 0, i;
+    BOOLEAN Pending = FALSE;
+
+    while (Position < End)
+    {
+        if (Pending)
+        {
+            /* Found (and inserted) on the previous round */
+            Length = NextLength;
+            Offset = NextOffset;
+            Pending = FALSE;
+        }
+        else
+        {
+            Length = RtlpLzFindMatch(Finder, Position, End - Position, &Offset);
+            if (InputSize - Position >= RTLP_LZ_MIN_MATCH)
+                RtlpLzInsert(Finder, Position);
+        }
+
+        /* Lazy evaluation, a longer match one byte later wins */
+        if (Lazy && Length && Length < Finder->NiceLength &&
+            End - Position > RTLP_LZ_MIN_MATCH)
+        {
+            NextLength = RtlpLzFindMatch(Finder, Position + 1, End - Position - 1, &NextOffset);
+            if (NextLength > Length)
+            {
+                RtlpLzInsert(Finder, Position + 1);
+                Pending = TRUE;
+                Length = 0;
+            }
+        }
+
+        /* Symbol 256 doubles as the end of stream marker, never emit it as a match */
+        if (Huffman && Length == RTLP_LZ_MIN_MATCH && Offset == 1)
+            Length = 0;
+
+        if (!Length)
+        {
+            Items[Count++] = Finder->Buffer[Position++];
+            continue;
+        }
+
+        Items[Count++] = (Offset << 16) | (Length - RTLP_LZ_MIN_MATCH);
+
+        for (i = 1; i < Length; i++)
+        {
+            if (InputSize - (Position + i) < RTLP_LZ_MIN_MATCH)
+                break;
+            RtlpLzInsert(Finder, Position + i);
+        }
+        Position += Length;
+    }
+
+    return Count;
+}
+
+NTSTATUS
+NTAPI
+RtlpCompressBufferXpress(IN USHORT Engine,
+                         IN PUCHAR UncompressedBuffer,
+                         IN ULONG UncompressedBufferSize,
+                         OUT PUCHAR CompressedBuffer,
+                         IN ULONG CompressedBufferSize,
+                         OUT PULONG FinalCompressedSize,
+                         IN PVOID WorkSpace)
+{
+    PXPRESS_WORKSPACE XpressWorkSpace = WorkSpace;
+    RTLP_LZ_MATCH_FINDER Finder;
+    PUCHAR Output = CompressedBuffer;
+    ULONG OutputSize = CompressedBufferSize;
+    ULONG Position, PieceEnd, Count, i, Item, Length, Needed;
+    ULONG OutPos, FlagPos = 0, Flags = 0, FlagCount = 0, HalfByte = 0;
+    BOOLEAN Lazy = (Engine == COMPRESSION_ENGINE_MAXIMUM);
+
+    if (!WorkSpace)
+        return STATUS_INVALID_PARAMETER;
+
+    if (OutputSize < sizeof(ULONG))
+        return STATUS_BUFFER_TOO_SMALL;
+    OutPos = sizeof(ULONG);
+
+    RtlpLzInitializeMatchFinder(&Finder,
+                                UncompressedBuffer,
+                                XpressWorkSpace + 1,
+                                RtlpXpressHashBits(UncompressedBufferSize, XPRESS_HASH_BITS),
+                                XPRESS_WINDOW_BITS,
+                                XPRESS_MAX_OFFSET,
+                                Lazy ? XPRESS_MAXIMUM_CHAIN : XPRESS_STANDARD_CHAIN,
+                                Lazy ? XPRESS_MAXIMUM_NICE : XPRESS_STANDARD_NICE);
+
+    for (Position = 0; Position < UncompressedBufferSize; Position = PieceEnd)
+    {
+        PieceEnd = Position + min(UncompressedBufferSize - Position, XPRESS_PIECE_SIZE);
+        Count = RtlpXpressParse(&Finder,
+                                Position,
+                                PieceEnd,
+                                UncompressedBufferSize,
+                                Lazy,
+                                FALSE,
+                                XpressWorkSpace->Items);
+
+        for (i = 0; i < Count; i++)
+        {
+            Item = XpressWorkSpace->Items[i];
+
+            if (!XPRESS_ITEM_IS_MATCH(Item))
+            {
+                if (OutPos >= OutputSize)
+                    return STATUS_BUFFER_TOO_SMALL;
+                Output[OutPos++] = (UCHAR)Item;
+                Flags <<= 1;
+            }
+            else
+            {
+                Length = XPRESS_ITEM_LENGTH(Item);
+
+                /* Work out the size of the token and its length extensions */
+                Needed = sizeof(USHORT);
+                if (Length >= 7)
+                {
+                    if (!HalfByte)
+                        Needed++;
+                    if (Length >= 7 + 15)
+                        Needed++;
+                    if (Length >= 7 + 15 + 255)
+                        Needed += sizeof(USHORT);
+                }
+                if (OutputSize - OutPos < Needed)
+                    return STATUS_BUFFER_TOO_SMALL;
+
+                RtlpXpressWriteUshort(Output + OutPos,
+                                      ((XPRESS_ITEM_OFFSET(Item) - 1) << 3) | min(Length, 7));
+                OutPos += sizeof(USHORT);
+
+                if (Length >= 7)
+                {
+                    /* Two 4-bit extensions share a byte */
+                    if (!HalfByte)
+                    {
+                        HalfByte = OutPos;
+                        Output[OutPos++] = (UCHAR)min(Length - 7, 15);
+                    }
+                    else
+                    {
+                        Output[HalfByte] |= (UCHAR)(min(Length - 7, 15) << 4);
+                        HalfByte = 0;
+                    }
+
+                    if (Length >= 7 + 15)
+                    {
+                        Output[OutPos++] = (UCHAR)min(Length - 7 - 15, 255);
+                        if (Length >= 7 + 15 + 255)
+                        {
+                            RtlpXpressWriteUshort(Output + OutPos, Length);
+                            OutPos += sizeof(USHORT);
+                        }
+                    }
+                }
+
+                Flags = (Flags << 1) | 1;
+            }
+
+            if (++FlagCount == 32)
+            {
+                if (OutputSize - OutPos < sizeof(ULONG))
+                    return STATUS_BUFFER_TOO_SMALL;
+
+                RtlpXpressWriteUlong(Output + FlagPos, Flags);
+                FlagCount = 0;
+                FlagPos = OutPos;
+                OutPos += sizeof(ULONG);
+            }
+        }
+    }
+
+    /* Pad the last flags with matches, the decoder stops on a match past the end */
+    if (FlagCount)
+        Flags = (Flags << (32 - FlagCount)) | ((1UL << (32 - FlagCount)) - 1);
+    else
+        Flags = MAXULONG;
+    RtlpXpressWriteUlong(Output + FlagPos, Flags);
+
+    *FinalCompressedSize = OutPos;
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS
+NTAPI
+RtlpDecompressBufferXpress(OUT PUCHAR UncompressedBuffer,
+                           IN ULONG UncompressedBufferSize,
+                           IN PUCHAR CompressedBuffer,
+                           IN ULONG CompressedBufferSize,
+                           OUT PULONG FinalUncompressedSize)
+{
+    PUCHAR Input = CompressedBuffer;
+    PUCHAR Output = UncompressedBuffer;
+    ULONG InPos = 0, OutPos = 0, HalfByte = 0;
+    ULONG Flags = 0, FlagCount = 0;
+    ULONG Token, Length, Offset;
+
+    while (OutPos < UncompressedBufferSize)
+    {
+        if (!FlagCount)
+        {
+            if (InPos == CompressedBufferSize)
+                break;
+            if (CompressedBufferSize - InPos < sizeof(ULONG))
+                return STATUS_BAD_COMPRESSION_BUFFER;
+
+            Flags = RtlpXpressReadUlong(Input + InPos);
+            InPos += sizeof(ULONG);
+            FlagCount = 32;
+        }
+
+        FlagCount--;
+        if (!(Flags & (1UL << FlagCount)))
+        {
+            if (InPos >= CompressedBufferSize)
+                return STATUS_BAD_COMPRESSION_BUFFER;
+            Output[OutPos++] = Input[InPos++];
+            continue;
+        }
+
+        /* A match flag past the end of the input terminates the stream */
+        if (InPos == CompressedBufferSize)
+            break;
+        if (CompressedBufferSize - InPos < sizeof(USHORT))
+            return STATUS_BAD_COMPRESSION_BUFFER;
+
+        Token = RtlpXpressReadUshort(Input + InPos);
+        InPos += sizeof(USHORT);
+        Length = Token & 7;
+        Offset = (Token >> 3) + 1;
+
+        if (Length == 7)
+        {
+            if (!HalfByte)
+            {
+                if (InPos >= CompressedBufferSize)
+                    return STATUS_BAD_COMPRESSION_BUFFER;
+                HalfByte = InPos++;
+                Length = Input[HalfByte] & 15;
+            }
+            else
+            {
+                Length = Input[HalfByte] >> 4;
+                HalfByte = 0;
+            }
+
+            if (Length == 15)
+            {
+                if (InPos >= CompressedBufferSize)
+                    return STATUS_BAD_COMPRESSION_BUFFER;
+                Length = Input[InPos++];
+
+                if (Length == 255)
+                {
+                    if (CompressedBufferSize - InPos < sizeof(USHORT))
+                        return STATUS_BAD_COMPRESSION_BUFFER;
+                    Length = RtlpXpressReadUshort(Input + InPos);
+                    InPos += sizeof(USHORT);
+
+                    if (!Length)
+                    {
+                        if (CompressedBufferSize - InPos < sizeof(ULONG))
+                            return STATUS_BAD_COMPRESSION_BUFFER;
+                        Length = RtlpXpressReadUlong(Input + InPos);
+                        InPos += sizeof(ULONG);
+                    }
+
+                    /* This is the full length - 3 */
+                    if (Length < 15 + 7 || Length > MAXULONG - 3)
+                        return STATUS_BAD_COMPRESSION_BUFFER;
+                    Length -= 15 + 7;
+                }
+                Length += 15;
+            }
+            Length += 7;
+        }
+        Length += 3;
+
+        if (Offset > OutPos)
+            return STATUS_BAD_COMPRESSION_BUFFER;
+
+        /* Partial decompression is no error */
+        Length = min(Length, UncompressedBufferSize - OutPos);
+        RtlpXpressCopyMatch(Output + OutPos, Offset, Length);
+        OutPos += Length;
+    }
+
+    *FinalUncompressedSize = OutPos;
+    return STATUS_SUCCESS;
+}
+
+FORCEINLINE
+ULONG
+RtlpXpressHuffSymbol(IN ULONG Item)
+{
+    if (!XPRESS_ITEM_IS_MATCH(Item))
+        return Item;
+
+    return XPRESS_HUFF_EOB + min(XPRESS_ITEM_LENGTH(Item), 15) +
+           (RtlpXpressHighBit(XPRESS_ITEM_OFFSET(Item)) << 4);
+}
+
+/*
+ * In-place minimum redundancy code lengths (Moffat and Katajainen).
+ * Takes the frequencies sorted in ascending order and replaces them
+ * with the matching code lengths.
+ */
+static
+VOID
+RtlpXpressHuffCodeLengths(IN OUT PULONG A,
+                          IN LONG Count)
+{
+    LONG Root, Leaf, Next, Available, Used, Depth;
+
+    /* Combine, left to right, leaving parent pointers behind */
+    A[0] += A[1];
+    Root = 0;
+    Leaf = 2;
+    for (Next = 1; Next < Count - 1; Next++)
+    {
+        if (Leaf >= Count || A[Root] < A[Leaf])
+        {
+            A[Next] = A[Root];
+            A[Root++] = Next;
+        }
+        else
+        {
+            A[Next] = A[Leaf++];
+        }
+
+        if (Leaf >= Count || (Root < Next && A[Root] < A[Leaf]))
+        {
+            A[Next] += A[Root];
+            A[Root++] = Next;
+        }
+        else
+        {
+            A[Next] += A[Leaf++];
+        }
+    }
+
+    /* Internal node depths, right to left */
+    A[Count - 2] = 0;
+    for (Next = Count - 3; Next >= 0; Next--)
+        A[Next] = A[A[Next]] + 1;
+
+    /* Leaf depths, right to left */
+    Available = 1;
+    Used = Depth = 0;
+    Root = Count - 2;
+    Next = Count - 1;
+    while (Available > 0)
+    {
+        while (Root >= 0 && (LONG)A[Root] == Depth)
+        {
+            Used++;
+            Root--;
+        }
+        while (Available > Used)
+        {
+            A[Next--] = Depth;
+            Available--;
+        }
+        Available = 2 * Used;
+        Depth++;
+        Used = 0;
+    }
+}
+
+static
+VOID
+RtlpXpressHuffBuildCode(IN OUT PXPRESS_HUFF_WORKSPACE Huff)
+{
+    ULONG LengthCount[XPRESS_HUFF_MAX_CODE_LENGTH + 1];
+    ULONG NextCode[XPRESS_HUFF_MAX_CODE_LENGTH + 1];
+    ULONG Count, Frequency, Code, i, j;
+
+    for (;;)
+    {
+        /* Sort the used symbols by ascending frequency */
+        Count = 0;
+        for (i = 0; i < XPRESS_HUFF_SYMBOLS; i++)
+        {
+            Frequency = Huff->Frequency[i];
+            if (!Frequency)
+                continue;
+
+            for (j = Count; j > 0 && Huff->Sorted[j - 1] > Frequency; j--)
+            {
+                Huff->Sorted[j] = Huff->Sorted[j - 1];
+                Huff->Symbols[j] = Huff->Symbols[j - 1];
+            }
+            Huff->Sorted[j] = Frequency;
+            Huff->Symbols[j] = (USHORT)i;
+            Count++;
+        }
+
+        if (Count == 1)
+        {
+            Huff->Sorted[0] = 1;
+            break;
+        }
+
+        /* The least frequent symbol gets the longest code */
+        RtlpXpressHuffCodeLengths(Huff->Sorted, Count);
+        if (Huff->Sorted[0] <= XPRESS_HUFF_MAX_CODE_LENGTH)
+            break;
+
+        /* Too deep, flatten the distribution and try again */
+        for (i = 0; i < XPRESS_HUFF_SYMBOLS; i++)
+        {
+            if (Huff->Frequency[i])
+                Huff->Frequency[i] = (Huff->Frequency[i] >> 1) | 1;
+        }
+    }
+
+    RtlZeroMemory(Huff->Lengths, sizeof(Huff->Lengths));
+    RtlZeroMemory(LengthCount, sizeof(LengthCount));
+    for (i = 0; i < Count; i++)
+    {
+        Huff->Lengths[Huff->Symbols[i]] = (UCHAR)Huff->Sorted[i];
+        LengthCount[Huff->Sorted[i]]++;
+    }
+
+    /* Canonical codes, ordered by length and then by symbol */
+    Code = 0;
+    for (i = 1; i <= XPRESS_HUFF_MAX_CODE_LENGTH; i++)
+    {
+        Code = (Code + LengthCount[i - 1]) << 1;
+        NextCode[i] = Code;
+    }
+
+    for (i = 0; i < XPRESS_HUFF_SYMBOLS; i++)
+    {
+        if (Huff->Lengths[i])
+            Huff->Codes[i] = (USHORT)NextCode[Huff->Lengths[i]]++;
+    }
+}
+
+FORCEINLINE
+VOID
+RtlpXpressReserveWord(IN OUT PXPRESS_BIT_WRITER Writer)
+{
+    if (Writer->Size - Writer->Position < sizeof(USHORT))
+    {
+        Writer->Overflow = TRUE;
+        return;
+    }
+
+    Writer->Next = Writer->Position;
+    RtlpXpressWriteUshort(Writer->Buffer + Writer->Position, 0);
+    Writer->Position += sizeof(USHORT);
+    Writer->NextReserved = TRUE;
+}
+
+/*
+ * The decoder keeps one word ahead: it fetches word N + 1 as soon as the
+ * first bit of word N is consumed. Reserving the slots in that order keeps
+ * the extra length bytes exactly where the decoder expects them.
+ */
+FORCEINLINE
+VOID
+RtlpXpressPutBits(IN OUT PXPRESS_BIT_WRITER Writer,
+                  IN ULONG Value,
+                  IN ULONG Count)
+{
+    ULONG Free;
+
+    if (!Count || Writer->Overflow)
+        return;
+
+    if (!Writer->BitCount && !Writer->NextReserved)
+    {
+        RtlpXpressReserveWord(Writer);
+        if (Writer->Overflow)
+            return;
+    }
+
+    Free = 16 - Writer->BitCount;
+    if (Count < Free)
+    {
+        Writer->Accumulator = (Writer->Accumulator << Count) | Value;
+        Writer->BitCount += Count;
+        return;
+    }
+
+    /* Complete the current word and move to the reserved one */
+    Count -= Free;
+    Writer->Accumulator = (Writer->Accumulator << Free) | (Value >> Count);
+    RtlpXpressWriteUshort(Writer->Buffer + Writer->Current, Writer->Accumulator);
+    Writer->Current = Writer->Next;
+    Writer->NextReserved = FALSE;
+    Writer->Accumulator = Value & ((1UL << Count) - 1);
+    Writer->BitCount = Count;
+
+    if (Count)
+        RtlpXpressReserveWord(Writer);
+}
+
+FORCEINLINE
+VOID
+RtlpXpressPutByte(IN OUT PXPRESS_BIT_WRITER Writer,
+                  IN ULONG Value)
+{
+    if (Writer->Overflow || Writer->Position >= Writer->Size)
+    {
+        Writer->Overflow = TRUE;
+        return;
+    }
+
+    Writer->Buffer[Writer->Position++] = (UCHAR)Value;
+}
+
+NTSTATUS
+NTAPI
+RtlpCompressBufferXpressHuff(IN USHORT Engine,
+                             IN PUCHAR UncompressedBuffer,
+                             IN ULONG UncompressedBufferSize,
+                             OUT PUCHAR CompressedBuffer,
+                             IN ULONG CompressedBufferSize,
+                             OUT PULONG FinalCompressedSize,
+                             IN PVOID WorkSpace)
+{
+    PXPRESS_HUFF_WORKSPACE Huff = WorkSpace;
+    RTLP_LZ_MATCH_FINDER Finder;
+    XPRESS_BIT_WRITER Writer;
+    ULONG ChunkStart = 0, ChunkEnd, Count, Item, Symbol, Length, OffsetBits, i;
+    BOOLEAN Lazy = (Engine == COMPRESSION_ENGINE_MAXIMUM);
+    BOOLEAN Last;
+
+    if (!WorkSpace)
+        return STATUS_INVALID_PARAMETER;
+
+    RtlpLzInitializeMatchFinder(&Finder,
+                                UncompressedBuffer,
+                                Huff + 1,
+                                RtlpXpressHashBits(UncompressedBufferSize, XPRESS_HUFF_HASH_BITS),
+                                XPRESS_HUFF_WINDOW_BITS,
+                                XPRESS_HUFF_MAX_OFFSET,
+                                Lazy ? XPRESS_MAXIMUM_CHAIN : XPRESS_STANDARD_CHAIN,
+                                Lazy ? XPRESS_MAXIMUM_NICE : XPRESS_STANDARD_NICE);
+
+    Writer.Buffer = CompressedBuffer;
+    Writer.Size = CompressedBufferSize;
+    Writer.Position = 0;
+    Writer.Overflow = FALSE;
+
+    /*
+     * A stream that is an exact multiple of the chunk size
+     * gets an extra chunk holding nothing but the end marker.
+     */
+    do
+    {
+        ChunkEnd = ChunkStart + min(UncompressedBufferSize - ChunkStart, XPRESS_HUFF_CHUNK_SIZE);
+        Last = (ChunkEnd - ChunkStart < XPRESS_HUFF_CHUNK_SIZE);
+
+        Count = RtlpXpressParse(&Finder,
+                                ChunkStart,
+                                ChunkEnd,
+                                UncompressedBufferSize,
+                                Lazy,
+                                TRUE,
+                                Huff->Items);
+
+        RtlZeroMemory(Huff->Frequency, sizeof(Huff->Frequency));
+        for (i = 0; i < Count; i++)
+            Huff->Frequency[RtlpXpressHuffSymbol(Huff->Items[i])]++;
+        if (Last)
+            Huff->Frequency[XPRESS_HUFF_EOB]++;
+
+        RtlpXpressHuffBuildCode(Huff);
+
+        /* Code lengths, two per byte with the even symbol in the low nibble */
+        if (Writer.Size - Writer.Position < XPRESS_HUFF_TABLE_SIZE + 2 * sizeof(USHORT))
+            return STATUS_BUFFER_TOO_SMALL;
+
+        for (i = 0; i < XPRESS_HUFF_TABLE_SIZE; i++)
+        {
+            Writer.Buffer[Writer.Position++] = Huff->Lengths[2 * i] |
+                                               (Huff->Lengths[2 * i + 1] << 4);
+        }
+
+        /* The decoder starts with two words loaded */
+        Writer.Current = Writer.Position;
+        Writer.Next = Writer.Position + sizeof(USHORT);
+        RtlpXpressWriteUlong(Writer.Buffer + Writer.Position, 0);
+        Writer.Position += 2 * sizeof(USHORT);
+        Writer.NextReserved = TRUE;
+        Writer.Accumulator = 0;
+        Writer.BitCount = 0;
+
+        for (i = 0; i < Count; i++)
+        {
+            Item = Huff->Items[i];
+            Symbol = RtlpXpressHuffSymbol(Item);
+            RtlpXpressPutBits(&Writer, Huff->Codes[Symbol], Huff->Lengths[Symbol]);
+
+            if (!XPRESS_ITEM_IS_MATCH(Item))
+                continue;
+
+            Length = XPRESS_ITEM_LENGTH(Item);
+            if (Length >= 15)
+            {
+                if (Length - 15 < 255)
+                {
+                    RtlpXpressPutByte(&Writer, Length - 15);
+                }
+                else
+                {
+                    RtlpXpressPutByte(&Writer, 255);
+                    RtlpXpressPutByte(&Writer, Length & 0xFF);
+                    RtlpXpressPutByte(&Writer, Length >> 8);
+                }
+            }
+
+            OffsetBits = (Symbol - XPRESS_HUFF_EOB) >> 4;
+            RtlpXpressPutBits(&Writer,
+                              XPRESS_ITEM_OFFSET(Item) & ((1UL << OffsetBits) - 1),
+                              OffsetBits);
+        }
+
+        if (Last)
+        {
+            RtlpXpressPutBits(&Writer,
+                              Huff->Codes[XPRESS_HUFF_EOB],
+                              Huff->Lengths[XPRESS_HUFF_EOB]);
+        }
+
+        if (Writer.Overflow)
+            return STATUS_BUFFER_TOO_SMALL;
+
+        /* Flush the partial word, the reserved ones are already zeroed */
+        if (Writer.BitCount)
+        {
+            RtlpXpressWriteUshort(Writer.Buffer + Writer.Current,
+                                  Writer.Accumulator << (16 - Writer.BitCount));
+        }
+
+        ChunkStart = ChunkEnd;
+    } while (!Last);
+
+    *FinalCompressedSize = Writer.Position;
+    return STATUS_SUCCESS;
+}
+
+/*
+ * Builds the decoding tables for a chunk. Codes up to XPRESS_HUFF_FAST_BITS
+ * long are resolved with a single lookup, the longer ones are decoded with
+ * the canonical code boundaries. Over-subscribed tables are rejected.
+ */
+static
+BOOLEAN
+RtlpXpressHuffBuildDecoder(IN PUCHAR Table,
+                           OUT PUSHORT FastTable,
+                           OUT PUSHORT SortedSymbols,
+                           OUT PULONG LengthCount)
+{
+    ULONG Offsets[XPRESS_HUFF_MAX_CODE_LENGTH + 1];
+    ULONG Symbol, Length, Code, Index, Fill, i;
+    LONG Left;
+
+    RtlZeroMemory(LengthCount, (XPRESS_HUFF_MAX_CODE_LENGTH + 1) * sizeof(ULONG));
+    for (Symbol = 0; Symbol < XPRESS_HUFF_SYMBOLS; Symbol++)
+        LengthCount[(Table[Symbol / 2] >> ((Symbol & 1) * 4)) & 15]++;
+    LengthCount[0] = 0;
+
+    Left = 1;
+    Offsets[1] = 0;
+    for (Length = 1; Length <= XPRESS_HUFF_MAX_CODE_LENGTH; Length++)
+    {
+        Left = (Left << 1) - LengthCount[Length];
+        if (Left < 0)
+            return FALSE;
+        if (Length < XPRESS_HUFF_MAX_CODE_LENGTH)
+            Offsets[Length + 1] = Offsets[Length] + LengthCount[Length];
+    }
+
+    for (Symbol = 0; Symbol < XPRESS_HUFF_SYMBOLS; Symbol++)
+    {
+        Length = (Table[Symbol / 2] >> ((Symbol & 1) * 4)) & 15;
+        if (Length)
+            SortedSymbols[Offsets[Length]++] = (USHORT)Symbol;
+    }
+
+    /* Entries are (Symbol << 4) | Length, zero sends the decoder to the slow path */
+    RtlZeroMemory(FastTable, sizeof(USHORT) << XPRESS_HUFF_FAST_BITS);
+    Code = 0;
+    Index = 0;
+    for (Length = 1; Length <= XPRESS_HUFF_FAST_BITS; Length++)
+    {
+        for (i = 0; i < LengthCount[Length]; i++, Index++, Code++)
+        {
+            Fill = 1UL << (XPRESS_HUFF_FAST_BITS - Length);
+            while (Fill--)
+            {
+                FastTable[(Code << (XPRESS_HUFF_FAST_BITS - Length)) + Fill] =
+                    (USHORT)((SortedSymbols[Index] << 4) | Length);
+            }
+        }
+        Code <<= 1;
+    }
+
+    return TRUE;
+}
+
+NTSTATUS
+NTAPI
+RtlpDecompressBufferXpressHuff(OUT PUCHAR UncompressedBuffer,
+                               IN ULONG UncompressedBufferSize,
+                               IN PUCHAR CompressedBuffer,
+                               IN ULONG CompressedBufferSize,
+                               OUT PULONG FinalUncompressedSize)
+{
+    USHORT FastTable[1 << XPRESS_HUFF_FAST_BITS];
+    USHORT SortedSymbols[XPRESS_HUFF_SYMBOLS];
+    ULONG LengthCount[XPRESS_HUFF_MAX_CODE_LENGTH + 1];
+    PUCHAR Input = CompressedBuffer;
+    PUCHAR Output = UncompressedBuffer;
+    ULONG InPos = 0, OutPos = 0, ChunkEnd;
+    ULONG NextBits, Entry, Symbol, Length, OffsetBits, Offset;
+    ULONG Code, First, Index;
+    LONG ExtraBits;
+
+    while (OutPos < UncompressedBufferSize)
+    {
+        /* Tolerate streams without an end marker */
+        if (InPos == CompressedBufferSize)
+            break;
+
+        if (CompressedBufferSize - InPos < XPRESS_HUFF_TABLE_SIZE + 2 * sizeof(USHORT))
+            return STATUS_BAD_COMPRESSION_BUFFER;
+
+        if (!RtlpXpressHuffBuildDecoder(Input + InPos, FastTable, SortedSymbols, LengthCount))
+            return STATUS_BAD_COMPRESSION_BUFFER;
+        InPos += XPRESS_HUFF_TABLE_SIZE;
+
+        NextBits = (RtlpXpressReadUshort(Input + InPos) << 16) |
+                   RtlpXpressReadUshort(Input + InPos + sizeof(USHORT));
+        InPos += 2 * sizeof(USHORT);
+        ExtraBits = 16;
+
+        ChunkEnd = OutPos + XPRESS_HUFF_CHUNK_SIZE;
+        while (OutPos < ChunkEnd)
+        {
+            /* Partial decompression is no error */
+            if (OutPos >= UncompressedBufferSize)
+                goto Done;
+
+            Entry = FastTable[NextBits >> (32 - XPRESS_HUFF_FAST_BITS)];
+            if (Entry)
+            {
+                Symbol = Entry >> 4;
+                Length = Entry & 15;
+            }
+            else
+            {
+                /* Walk the canonical code boundaries for the long codes */
+                First = 0;
+                Index = 0;
+                for (Length = 1; Length <= XPRESS_HUFF_MAX_CODE_LENGTH; Length++)
+                {
+                    Code = NextBits >> (32 - Length);
+                    if (Code - First < LengthCount[Length])
+                        break;
+                    Index += LengthCount[Length];
+                    First = (First + LengthCount[Length]) << 1;
+                }
+                if (Length > XPRESS_HUFF_MAX_CODE_LENGTH)
+                    return STATUS_BAD_COMPRESSION_BUFFER;
+                Symbol = SortedSymbols[Index + Code - First];
+            }
+
+            NextBits <<= Length;
+            ExtraBits -= Length;
+            if (ExtraBits < 0)
+            {
+                if (CompressedBufferSize - InPos < sizeof(USHORT))
+                    return STATUS_BAD_COMPRESSION_BUFFER;
+                NextBits |= RtlpXpressReadUshort(Input + InPos) << -ExtraBits;
+                InPos += sizeof(USHORT);
+                ExtraBits += 16;
+            }
+
+            if (Symbol < XPRESS_HUFF_EOB)
+            {
+                Output[OutPos++] = (UCHAR)Symbol;
+                continue;
+            }
+
+            if (Symbol == XPRESS_HUFF_EOB && InPos == CompressedBufferSize)
+                goto Done;
+
+            Symbol -= XPRESS_HUFF_EOB;
+            Length = Symbol & 15;
+            OffsetBits = Symbol >> 4;
+
+            if (Length == 15)
+            {
+                if (InPos >= CompressedBufferSize)
+                    return STATUS_BAD_COMPRESSION_BUFFER;
+                Length = Input[InPos++];
+
+                if (Length == 255)
+                {
+                    if (CompressedBufferSize - InPos < sizeof(USHORT))
+                        return STATUS_BAD_COMPRESSION_BUFFER;
+                    Length = RtlpXpressReadUshort(Input + InPos);
+                    InPos += sizeof(USHORT);
+
+                    if (Length < 15)
+                        return STATUS_BAD_COMPRESSION_BUFFER;
+                    Length -= 15;
+                }
+                Length += 15;
+            }
+            Length += 3;
+
+            Offset = 1UL << OffsetBits;
+            if (OffsetBits)
+            {
+                Offset |= NextBits >> (32 - OffsetBits);
+                NextBits <<= OffsetBits;
+                ExtraBits -= OffsetBits;
+                if (ExtraBits < 0)
+                {
+                    if (CompressedBufferSize - InPos < sizeof(USHORT))
+                        return STATUS_BAD_COMPRESSION_BUFFER;
+                    NextBits |= RtlpXpressReadUshort(Input + InPos) << -ExtraBits;
+                    InPos += sizeof(USHORT);
+                    ExtraBits += 16;
+                }
+            }
+
+            if (Offset > OutPos)
+                return STATUS_BAD_COMPRESSION_BUFFER;
+
+            Length = min(Length, UncompressedBufferSize - OutPos);
+            RtlpXpressCopyMatch(Output + OutPos, Offset, Length);
+            OutPos += Length;
+        }
+    }
+
+Done:
+    *FinalUncompressedSize = OutPos;
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS
+NTAPI
+RtlpWorkSpaceSizeXpress(IN USHORT Format,
+                        IN USHORT Engine,
+                        OUT PULONG BufferAndWorkSpaceSize,
+                        OUT PULONG FragmentWorkSpaceSize)
+{
+    if (Engine != COMPRESSION_ENGINE_STANDARD &&
+        Engine != COMPRESSION_ENGINE_MAXIMUM)
+    {
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    if (Format == COMPRESSION_FORMAT_XPRESS)
+    {
+        *BufferAndWorkSpaceSize = sizeof(XPRESS_WORKSPACE) +
+                                  RTLP_LZ_WORKSPACE_SIZE(XPRESS_HASH_BITS, XPRESS_WINDOW_BITS);
+    }
+    else
+    {
+        *BufferAndWorkSpaceSize = sizeof(XPRESS_HUFF_WORKSPACE) +
+                                  RTLP_LZ_WORKSPACE_SIZE(XPRESS_HUFF_HASH_BITS, XPRESS_HUFF_WINDOW_BITS);
+    }
+
+    /* Fragments are not supported, there is nothing to decompress into */
+    *FragmentWorkSpaceSize = 0;
+    return STATUS_SUCCESS;
+}
+
+/* EOF */
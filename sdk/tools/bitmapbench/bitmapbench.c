@@ -0,0 +1,501 @@
+/*
+ * PROJECT:     ReactOS host tools
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Correctness check and microbenchmark for the rtl bitmap search functions
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <typedefs.h>
+
+/* Let the amd64 code paths of bitmap.c run on amd64 hosts */
+#if defined(__x86_64__) && !defined(_M_AMD64)
+#define _M_AMD64
+#endif
+
+#define _In_
+#define _Out_
+#define _Inout_
+#define _In_opt_
+#define _In_range_(x, y)
+#define __drv_aliasesMem
+
+#ifndef min
+#define min(a, b)  (((a) < (b)) ? (a) : (b))
+#endif
+
+static
+unsigned char
+BitScanForward(ULONG *Index, ULONG Mask)
+{
+    if (!Mask)
+        return 0;
+    *Index = __builtin_ctz(Mask);
+    return 1;
+}
+
+static
+unsigned char
+BitScanReverse(ULONG *Index, ULONG Mask)
+{
+    if (!Mask)
+        return 0;
+    *Index = 31 - __builtin_clz(Mask);
+    return 1;
+}
+
+#ifdef _M_AMD64
+static
+unsigned char
+BitScanForward64(ULONG *Index, ULONG64 Mask)
+{
+    if (!Mask)
+        return 0;
+    *Index = __builtin_ctzll(Mask);
+    return 1;
+}
+
+static
+unsigned char
+BitScanReverse64(ULONG *Index, ULONG64 Mask)
+{
+    if (!Mask)
+        return 0;
+    *Index = 63 - __builtin_clzll(Mask);
+    return 1;
+}
+#endif
+
+#define RtlFillMemoryUlong(Destination, Length, Fill) memset(Destination, (int)(Fill), Length)
+
+#include <bitmap.c>
+
+/* Keep timing each kernel for at least this long */
+#define MIN_BENCH_TIME  0.25
+
+/* The bitmap code before the word scanning engine, kept for comparison */
+
+static const UCHAR OldBitCountTable[256] =
+{
+    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
+    1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5, 2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
+    1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5, 2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
+    2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6, 3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
+    1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5, 2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
+    2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6, 3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
+    2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6, 3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
+    3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7, 4, 5, 5, 6, 5, 6, 6, 7, 5, 6, 6, 7, 6, 7, 7, 8
+};
+
+static
+ULONG
+OldGetLengthOfRunClear(PRTL_BITMAP BitMapHeader, ULONG StartingIndex, ULONG MaxLength)
+{
+    ULONG Value, BitPos, Length;
+    PULONG Buffer, MaxBuffer;
+
+    if (StartingIndex >= BitMapHeader->SizeOfBitMap)
+        return 0;
+
+    Buffer = BitMapHeader->Buffer + StartingIndex / 32;
+    BitPos = StartingIndex & 31;
+    MaxLength = min(MaxLength, BitMapHeader->SizeOfBitMap - StartingIndex);
+    MaxBuffer = Buffer + (BitPos + MaxLength + 31) / 32;
+
+    Value = *Buffer++ >> BitPos << BitPos;
+    while (Value == 0 && Buffer < MaxBuffer)
+        Value = *Buffer++;
+    if (Value == 0)
+        return MaxLength;
+
+    BitScanForward(&BitPos, Value);
+    Length = (ULONG)(Buffer - BitMapHeader->Buffer) * 32 - StartingIndex;
+    Length += BitPos - 32;
+    if (Length > BitMapHeader->SizeOfBitMap - StartingIndex)
+        Length = BitMapHeader->SizeOfBitMap - StartingIndex;
+    return Length;
+}
+
+static
+ULONG
+OldGetLengthOfRunSet(PRTL_BITMAP BitMapHeader, ULONG StartingIndex, ULONG MaxLength)
+{
+    ULONG InvValue, BitPos, Length;
+    PULONG Buffer, MaxBuffer;
+
+    if (StartingIndex >= BitMapHeader->SizeOfBitMap)
+        return 0;
+
+    Buffer = BitMapHeader->Buffer + StartingIndex / 32;
+    BitPos = StartingIndex & 31;
+    MaxLength = min(MaxLength, BitMapHeader->SizeOfBitMap - StartingIndex);
+    MaxBuffer = Buffer + (BitPos + MaxLength + 31) / 32;
+
+    InvValue = ~(*Buffer++) >> BitPos << BitPos;
+    while (InvValue == 0 && Buffer < MaxBuffer)
+        InvValue = ~(*Buffer++);
+    if (InvValue == 0)
+        return MaxLength;
+
+    BitScanForward(&BitPos, InvValue);
+    Length = (ULONG)(Buffer - BitMapHeader->Buffer) * 32 - StartingIndex;
+    Length += BitPos - 32;
+    if (Length > BitMapHeader->SizeOfBitMap - StartingIndex)
+        Length = BitMapHeader->SizeOfBitMap - StartingIndex;
+    return Length;
+}
+
+static
+ULONG
+OldNumberOfSetBits(PRTL_BITMAP BitMapHeader)
+{
+    PUCHAR Byte, MaxByte;
+    ULONG BitCount = 0;
+
+    Byte = (PUCHAR)BitMapHeader->Buffer;
+    MaxByte = Byte + BitMapHeader->SizeOfBitMap / 8;
+    while (Byte < MaxByte)
+        BitCount += OldBitCountTable[*Byte++];
+    if (BitMapHeader->SizeOfBitMap & 7)
+        BitCount += OldBitCountTable[((*Byte) << (8 - (BitMapHeader->SizeOfBitMap & 7))) & 0xFF];
+    return BitCount;
+}
+
+static
+ULONG
+OldFindClearBits(PRTL_BITMAP BitMapHeader, ULONG NumberToFind, ULONG HintIndex)
+{
+    ULONG CurrentBit, Margin, CurrentLength;
+
+    if (NumberToFind > BitMapHeader->SizeOfBitMap)
+        return MAXULONG;
+    if (HintIndex >= BitMapHeader->SizeOfBitMap)
+        HintIndex = 0;
+    if (NumberToFind == 0)
+        return HintIndex & ~7;
+
+    Margin = BitMapHeader->SizeOfBitMap;
+retry:
+    CurrentBit = HintIndex;
+    while (CurrentBit + NumberToFind < Margin)
+    {
+        CurrentBit += OldGetLengthOfRunSet(BitMapHeader, CurrentBit, MAXULONG);
+        CurrentLength = OldGetLengthOfRunClear(BitMapHeader, CurrentBit, NumberToFind);
+        if (CurrentLength >= NumberToFind)
+            return CurrentBit;
+        CurrentBit += CurrentLength;
+    }
+    if (HintIndex)
+    {
+        Margin = min(HintIndex + NumberToFind, BitMapHeader->SizeOfBitMap);
+        HintIndex = 0;
+        goto retry;
+    }
+    return MAXULONG;
+}
+
+static
+ULONG
+OldFindLongestRunClear(PRTL_BITMAP BitMapHeader, PULONG StartingIndex)
+{
+    ULONG NumberOfBits, Index, MaxNumberOfBits = 0, FromIndex = 0, Length;
+
+    while (FromIndex < BitMapHeader->SizeOfBitMap)
+    {
+        Length = OldGetLengthOfRunSet(BitMapHeader, FromIndex, MAXULONG);
+        Index = FromIndex + Length;
+        NumberOfBits = OldGetLengthOfRunClear(BitMapHeader, Index, MAXULONG);
+        if (NumberOfBits == 0)
+            break;
+        if (NumberOfBits > MaxNumberOfBits)
+        {
+            MaxNumberOfBits = NumberOfBits;
+            *StartingIndex = Index;
+        }
+        FromIndex += NumberOfBits;
+    }
+    return MaxNumberOfBits;
+}
+
+/* Bit by bit reference for the self check */
+
+static
+ULONG
+NaiveFindRun(PRTL_BITMAP BitMapHeader, ULONG NumberToFind, ULONG HintIndex, ULONG Value)
+{
+    ULONG Size = BitMapHeader->SizeOfBitMap, Start, Pass, First, Last, i;
+
+    if (NumberToFind > Size)
+        return MAXULONG;
+    if (HintIndex >= Size)
+        HintIndex = 0;
+    if (NumberToFind == 0)
+        return HintIndex & ~7;
+
+    for (Pass = 0; Pass < 2; Pass++)
+    {
+        First = Pass ? 0 : HintIndex;
+        Last = Pass ? HintIndex : Size - NumberToFind + 1;
+        for (Start = First; Start < Last && Start + NumberToFind <= Size; Start++)
+        {
+            for (i = 0; i < NumberToFind; i++)
+            {
+                if (RtlTestBit(BitMapHeader, Start + i) != Value)
+                    break;
+            }
+            if (i == NumberToFind)
+                return Start;
+        }
+        if (!HintIndex)
+            break;
+    }
+    return MAXULONG;
+}
+
+static ULONG Seed = 1;
+
+static
+ULONG
+NextRandom(void)
+{
+    Seed = Seed * 1103515245 + 12345;
+    return Seed >> 8;
+}
+
+static
+int
+SelfCheck(void)
+{
+    ULONG Buffer[8], Size, Number, Hint, Expected, Got, Iteration, i, Bias, Start;
+    RTL_BITMAP BitMap;
+    int Failures = 0;
+
+    for (Iteration = 0; Iteration < 200000; Iteration++)
+    {
+        Size = NextRandom() % (sizeof(Buffer) * 8 + 1);
+        Bias = NextRandom() % 4;
+        for (i = 0; i < 8; i++)
+        {
+            Buffer[i] = NextRandom() ^ (NextRandom() << 16);
+            if (Bias == 1)
+                Buffer[i] |= NextRandom() ^ (NextRandom() << 16);
+            else if (Bias == 2)
+                Buffer[i] &= NextRandom() ^ (NextRandom() << 16);
+            else if (Bias == 3)
+                Buffer[i] = (NextRandom() & 1) ? 0 : MAXULONG;
+        }
+        RtlInitializeBitMap(&BitMap, Buffer, Size);
+
+        Number = NextRandom() % (Size + 2);
+        if (NextRandom() & 1)
+            Number %= 12;
+        Hint = NextRandom() % (Size + 4);
+
+        Expected = NaiveFindRun(&BitMap, Number, Hint, 0);
+        Got = RtlFindClearBits(&BitMap, Number, Hint);
+        if (Got != Expected)
+        {
+            printf("RtlFindClearBits(size %u, %u, hint %u) = %d, expected %d\n",
+                   Size, Number, Hint, (int)Got, (int)Expected);
+            Failures++;
+        }
+
+        Expected = NaiveFindRun(&BitMap, Number, Hint, 1);
+        Got = RtlFindSetBits(&BitMap, Number, Hint);
+        if (Got != Expected)
+        {
+            printf("RtlFindSetBits(size %u, %u, hint %u) = %d, expected %d\n",
+                   Size, Number, Hint, (int)Got, (int)Expected);
+            Failures++;
+        }
+
+        for (i = 0, Expected = 0; i < Size; i++)
+            Expected += RtlTestBit(&BitMap, i);
+        Got = RtlNumberOfSetBits(&BitMap);
+        if (Got != Expected)
+        {
+            printf("RtlNumberOfSetBits(size %u) = %u, expected %u\n", Size, Got, Expected);
+            Failures++;
+        }
+
+        if (Size)
+        {
+            Expected = OldFindLongestRunClear(&BitMap, &Start);
+            Got = RtlFindLongestRunClear(&BitMap, &i);
+            if (Got != Expected || (Got && i != Start))
+            {
+                printf("RtlFindLongestRunClear(size %u) = %u at %u, expected %u at %u\n",
+                       Size, Got, i, Expected, Start);
+                Failures++;
+            }
+        }
+
+        if (Failures > 10)
+            break;
+    }
+
+    return Failures;
+}
+
+typedef struct _PATTERN
+{
+    const char *Name;
+    ULONG FreePercent;
+    ULONG MaxRun;
+} PATTERN;
+
+/* Free space layouts of a large volume bitmap */
+static const PATTERN Patterns[] =
+{
+    { "sparse",     1,  8 },    /* Nearly full, a few small holes */
+    { "fragmented", 50, 4 },    /* Short runs of both kinds */
+    { "mostly-free", 95, 4096 } /* Long free runs */
+};
+
+static
+void
+FillPattern(PRTL_BITMAP BitMap, const PATTERN *Pattern)
+{
+    ULONG Position = 0, Length, Size = BitMap->SizeOfBitMap;
+
+    RtlSetAllBits(BitMap);
+    while (Position < Size)
+    {
+        Length = 1 + NextRandom() % Pattern->MaxRun;
+        if (Length > Size - Position)
+            Length = Size - Position;
+
+        if (NextRandom() % 100 < Pattern->FreePercent)
+            RtlClearBits(BitMap, Position, Length);
+        Position += Length;
+    }
+}
+
+static
+double
+Elapsed(clock_t Start)
+{
+    return (double)(clock() - Start) / CLOCKS_PER_SEC;
+}
+
+/* Calls are made in batches, so that clock() doesn't dominate short calls */
+#define TIME_LOOP(Result, Calls, Seconds, Expression)           \
+    do                                                          \
+    {                                                           \
+        clock_t StartTime = clock();                            \
+        ULONG Batch;                                            \
+        Calls = 0;                                              \
+        do                                                      \
+        {                                                       \
+            for (Batch = 0; Batch < 16; Batch++)                \
+                Result = (Expression);                          \
+            Calls += 16;                                        \
+        } while ((Seconds = Elapsed(StartTime)) < MIN_BENCH_TIME); \
+    } while (0)
+
+static
+int
+Benchmark(ULONG Size)
+{
+    static const ULONG Lengths[] = { 1, 16, 64, 1024 };
+    ULONG *Buffer, i, j, Calls, OldResult = 0, NewResult = 0, Hints[64], Hint = 0, Start;
+    RTL_BITMAP BitMap;
+    double OldTime, NewTime;
+    int Failures = 0;
+
+    Buffer = malloc(Size / 8);
+    if (!Buffer)
+    {
+        printf("Out of memory\n");
+        return 1;
+    }
+    RtlInitializeBitMap(&BitMap, Buffer, Size);
+
+    printf("%-12s %-22s %14s %14s %8s\n", "bitmap", "operation", "old ns/call", "new ns/call", "speedup");
+
+    for (i = 0; i < sizeof(Patterns) / sizeof(Patterns[0]); i++)
+    {
+        FillPattern(&BitMap, &Patterns[i]);
+        for (j = 0; j < 64; j++)
+            Hints[j] = NextRandom() % Size;
+
+        TIME_LOOP(OldResult, Calls, OldTime, OldNumberOfSetBits(&BitMap));
+        OldTime = OldTime * 1e9 / Calls;
+        TIME_LOOP(NewResult, Calls, NewTime, RtlNumberOfSetBits(&BitMap));
+        NewTime = NewTime * 1e9 / Calls;
+        Failures += (OldResult != NewResult);
+        printf("%-12s %-22s %14.0f %14.0f %7.1fx\n", Patterns[i].Name, "NumberOfSetBits",
+               OldTime, NewTime, OldTime / NewTime);
+
+        for (j = 0; j < sizeof(Lengths) / sizeof(Lengths[0]); j++)
+        {
+            char Operation[32];
+
+            sprintf(Operation, "FindClearBits(%u)", Lengths[j]);
+            TIME_LOOP(OldResult, Calls, OldTime,
+                      OldFindClearBits(&BitMap, Lengths[j], Hints[Hint++ & 63]));
+            OldTime = OldTime * 1e9 / Calls;
+            TIME_LOOP(NewResult, Calls, NewTime,
+                      RtlFindClearBits(&BitMap, Lengths[j], Hints[Hint++ & 63]));
+            NewTime = NewTime * 1e9 / Calls;
+            printf("%-12s %-22s %14.0f %14.0f %7.1fx\n", Patterns[i].Name, Operation,
+                   OldTime, NewTime, OldTime / NewTime);
+
+            /* Both must agree on the same hint */
+            if (OldFindClearBits(&BitMap, Lengths[j], Hints[0]) != RtlFindClearBits(&BitMap, Lengths[j], Hints[0]))
+            {
+                printf("%-12s %-22s MISMATCH\n", Patterns[i].Name, Operation);
+                Failures++;
+            }
+        }
+
+        TIME_LOOP(OldResult, Calls, OldTime, OldFindLongestRunClear(&BitMap, &Start));
+        OldTime = OldTime * 1e9 / Calls;
+        TIME_LOOP(NewResult, Calls, NewTime, RtlFindLongestRunClear(&BitMap, &Start));
+        NewTime = NewTime * 1e9 / Calls;
+        Failures += (OldResult != NewResult);
+        printf("%-12s %-22s %14.0f %14.0f %7.1fx\n", Patterns[i].Name, "FindLongestRunClear",
+               OldTime, NewTime, OldTime / NewTime);
+    }
+
+    free(Buffer);
+    return Failures;
+}
+
+int main(int argc, char *argv[])
+{
+    ULONG Size = 16 * 1024 * 1024;
+    int Failures, i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-s") && i + 1 < argc)
+        {
+            Size = strtoul(argv[++i], NULL, 0) & ~31UL;
+        }
+        else if (!strcmp(argv[i], "-q"))
+        {
+            Size = 0;
+        }
+        else
+        {
+            printf("Checks the rtl bitmap search functions and times them against the old code.\n"
+                   "Syntax: bitmapbench [-s bits] [-q]\n"
+                   "  -s bits  Size of the benchmark bitmap (default 16M bits)\n"
+                   "  -q       Only run the self check\n");
+            return 1;
+        }
+    }
+
+    Failures = SelfCheck();
+    printf("Self check: %s\n", Failures ? "FAILED" : "ok");
+
+    if (!Failures && Size)
+        Failures = Benchmark(Size);
+
+    return Failures ? 1 : 0;
+}
@@ -0,0 +1,235 @@
+/*
+ * PROJECT:     ReactOS cabinet manager
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     CCFDATACompressor class implementation
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ * NOTES:       Every CFDATA block is compressed on its own, so blocks can be
+ *              compressed in any order as long as they are written to the
+ *              scratch file in the order they were submitted. This keeps the
+ *              cabinet byte for byte identical to the serial one.
+ */
+
+#include "CCFDATACompressor.h"
+
+#if !defined(CAB_READ_ONLY)
+
+/**
+ * @name CCFDATACompressor class
+ * @implemented
+ *
+ * Default constructor
+ */
+CCFDATACompressor::CCFDATACompressor()
+{
+    Quit = false;
+}
+
+/**
+ * @name CCFDATACompressor class
+ * @implemented
+ *
+ * Default destructor
+ */
+CCFDATACompressor::~CCFDATACompressor()
+{
+    Stop();
+
+    for (PCFDATA_JOB Job : FreeJobs)
+        delete Job;
+}
+
+/**
+ * @name CCFDATACompressor class
+ * @implemented
+ *
+ * Starts the worker threads
+ *
+ * @param WorkerCodecs
+ * One codec instance for every worker thread
+ *
+ * @return
+ * Status of operation
+ */
+ULONG CCFDATACompressor::Start(const std::vector<CCABCodec*>& WorkerCodecs)
+{
+    Quit = false;
+    Codecs = WorkerCodecs;
+
+    try
+    {
+        for (CCABCodec* Codec : Codecs)
+            Threads.emplace_back(&CCFDATACompressor::WorkerProc, this, Codec);
+    }
+    catch (const std::system_error&)
+    {
+        DPRINT(MIN_TRACE, ("Cannot create worker thread.\n"));
+        Stop();
+        return CAB_STATUS_NOMEMORY;
+    }
+
+    return CAB_STATUS_SUCCESS;
+}
+
+/**
+ * @name CCFDATACompressor class
+ * @implemented
+ *
+ * Stops the worker threads and frees all pending blocks
+ */
+void CCFDATACompressor::Stop()
+{
+    {
+        std::lock_guard<std::mutex> Guard(Lock);
+        Quit = true;
+    }
+    WorkAvailable.notify_all();
+
+    for (std::thread& Thread : Threads)
+        Thread.join();
+    Threads.clear();
+
+    for (CCABCodec* Codec : Codecs)
+        delete Codec;
+    Codecs.clear();
+
+    for (PCFDATA_JOB Job : InFlight)
+        delete Job;
+    InFlight.clear();
+    Waiting.clear();
+}
+
+/**
+ * @name CCFDATACompressor class
+ * @implemented
+ *
+ * Queues a block for compression
+ *
+ * @param FolderNode
+ * Folder the block belongs to
+ *
+ * @param Buffer
+ * Uncompressed data, it is copied
+ *
+ * @param Length
+ * Length of the uncompressed data
+ *
+ * @return
+ * Status of operation
+ */
+ULONG CCFDATACompressor::Submit(PCFFOLDER_NODE FolderNode, void* Buffer, ULONG Length)
+{
+    PCFDATA_JOB Job;
+
+    {
+        std::lock_guard<std::mutex> Guard(Lock);
+        if (!FreeJobs.empty())
+        {
+            Job = FreeJobs.back();
+            FreeJobs.pop_back();
+        }
+        else
+        {
+            Job = new CFDATA_JOB;
+            Job->Input.resize(CAB_BLOCKSIZE + 12);
+            Job->Output.resize(CAB_MAX_COMPSIZE);
+        }
+    }
+
+    Job->FolderNode   = FolderNode;
+    Job->InputLength  = Length;
+    Job->OutputLength = 0;
+    Job->Status       = CS_SUCCESS;
+    Job->Done         = false;
+    memcpy(Job->Input.data(), Buffer, Length);
+
+    {
+        std::lock_guard<std::mutex> Guard(Lock);
+        Waiting.push_back(Job);
+        InFlight.push_back(Job);
+    }
+    WorkAvailable.notify_one();
+
+    return CAB_STATUS_SUCCESS;
+}
+
+/**
+ * @name CCFDATACompressor class
+ * @implemented
+ *
+ * Returns the number of blocks submitted but not retired yet
+ */
+ULONG CCFDATACompressor::Pending()
+{
+    std::lock_guard<std::mutex> Guard(Lock);
+    return (ULONG)InFlight.size();
+}
+
+/**
+ * @name CCFDATACompressor class
+ * @implemented
+ *
+ * Waits until the oldest pending block is compressed
+ *
+ * @return
+ * The block, or NULL if nothing is pending. Hand it back with Release().
+ */
+PCFDATA_JOB CCFDATACompressor::Retire()
+{
+    std::unique_lock<std::mutex> Guard(Lock);
+    PCFDATA_JOB Job;
+
+    if (InFlight.empty())
+        return NULL;
+
+    Job = InFlight.front();
+    WorkDone.wait(Guard, [Job] { return Job->Done; });
+    InFlight.pop_front();
+
+    return Job;
+}
+
+/**
+ * @name CCFDATACompressor class
+ * @implemented
+ *
+ * Returns a retired block for reuse
+ */
+void CCFDATACompressor::Release(PCFDATA_JOB Job)
+{
+    std::lock_guard<std::mutex> Guard(Lock);
+    FreeJobs.push_back(Job);
+}
+
+/**
+ * @name CCFDATACompressor class
+ * @implemented
+ *
+ * Worker thread, compresses blocks until the compressor is stopped
+ */
+void CCFDATACompressor::WorkerProc(CCABCodec* Codec)
+{
+    std::unique_lock<std::mutex> Guard(Lock);
+    PCFDATA_JOB Job;
+
+    for (;;)
+    {
+        WorkAvailable.wait(Guard, [this] { return Quit || !Waiting.empty(); });
+        if (Quit)
+            break;
+
+        Job = Waiting.front();
+        Waiting.pop_front();
+
+        Guard.unlock();
+        Job->Status = Codec->Compress(Job->Output.data(),
+                                      Job->Input.data(),
+                                      Job->InputLength,
+                                      &Job->OutputLength);
+        Guard.lock();
+
+        Job->Done = true;
+        WorkDone.notify_all();
+    }
+}
+
+#endif /* CAB_READ_ONLY */
@@ -0,0 +1,64 @@
+/*
+ * PROJECT:     ReactOS cabinet manager
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Compresses CFDATA blocks on a pool of worker threads
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#pragma once
+
+#include "cabinet.h"
+
+#ifndef CAB_READ_ONLY
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+typedef struct _CFDATA_JOB
+{
+    PCFFOLDER_NODE              FolderNode = nullptr;   // Folder the block belongs to
+    std::vector<unsigned char>  Input;                  // Uncompressed data
+    std::vector<unsigned char>  Output;                 // Compressed data
+    ULONG                       InputLength = 0;
+    ULONG                       OutputLength = 0;
+    ULONG                       Status = CS_SUCCESS;    // Codec status code
+    bool                        Done = false;
+} CFDATA_JOB, *PCFDATA_JOB;
+
+class CCFDATACompressor
+{
+public:
+    /* Default constructor */
+    CCFDATACompressor();
+    /* Default destructor */
+    virtual ~CCFDATACompressor();
+    /* Starts one worker thread per codec, the codecs are owned by the compressor from now on */
+    ULONG Start(const std::vector<CCABCodec*>& WorkerCodecs);
+    /* Stops the worker threads, dropping all pending blocks */
+    void Stop();
+    /* Queues a block for compression */
+    ULONG Submit(PCFFOLDER_NODE FolderNode, void* Buffer, ULONG Length);
+    /* Returns the number of blocks submitted but not retired yet */
+    ULONG Pending();
+    /* Waits for the oldest pending block and takes it off the queue */
+    PCFDATA_JOB Retire();
+    /* Returns a retired block for reuse */
+    void Release(PCFDATA_JOB Job);
+private:
+    void WorkerProc(CCABCodec* Codec);
+    std::mutex Lock;
+    std::condition_variable WorkAvailable;  // Signalled when a block is submitted
+    std::condition_variable WorkDone;       // Signalled when a block is compressed
+    std::deque<PCFDATA_JOB> Waiting;        // Blocks no worker has picked up yet
+    std::deque<PCFDATA_JOB> InFlight;       // All pending blocks, in submission order
+    std::vector<PCFDATA_JOB> FreeJobs;
+    std::vector<std::thread> Threads;
+    std::vector<CCABCodec*> Codecs;
+    bool Quit;
+};
+
+#endif /* CAB_READ_ONLY */
@@ -0,0 +1,181 @@
+/*
+ * PROJECT:     ReactOS cabinet manager
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     CCFFILEWriter class implementation
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ * NOTES:       Chunks are written in the order they were queued, so the next
+ *              data block can be uncompressed while the previous one is still
+ *              being written. The number of chunks is bounded, which keeps
+ *              the memory use constant for large folders.
+ */
+
+#include "CCFFILEWriter.h"
+
+#define CFFILE_WRITER_CHUNKS    8
+
+/**
+ * @name CCFFILEWriter class
+ * @implemented
+ *
+ * Default constructor
+ */
+CCFFILEWriter::CCFFILEWriter()
+{
+    Status = CAB_STATUS_SUCCESS;
+    Quit = false;
+}
+
+/**
+ * @name CCFFILEWriter class
+ * @implemented
+ *
+ * Default destructor
+ */
+CCFFILEWriter::~CCFFILEWriter()
+{
+    Stop();
+
+    for (PCFFILE_CHUNK Chunk : Chunks)
+        delete Chunk;
+}
+
+/**
+ * @name CCFFILEWriter class
+ * @implemented
+ *
+ * Starts the writer thread
+ *
+ * @return
+ * Status of operation
+ */
+ULONG CCFFILEWriter::Start()
+{
+    Status = CAB_STATUS_SUCCESS;
+    Quit = false;
+
+    try
+    {
+        while (Chunks.size() < CFFILE_WRITER_CHUNKS)
+        {
+            PCFFILE_CHUNK Chunk = new CFFILE_CHUNK;
+            Chunk->Data.resize(CAB_BLOCKSIZE);
+            Chunks.push_back(Chunk);
+        }
+        FreeChunks = Chunks;
+
+        Thread = std::thread(&CCFFILEWriter::WorkerProc, this);
+    }
+    catch (const std::bad_alloc&)
+    {
+        DPRINT(MIN_TRACE, ("Insufficient memory.\n"));
+        return CAB_STATUS_NOMEMORY;
+    }
+    catch (const std::system_error&)
+    {
+        DPRINT(MIN_TRACE, ("Cannot create writer thread.\n"));
+        return CAB_STATUS_NOMEMORY;
+    }
+
+    return CAB_STATUS_SUCCESS;
+}
+
+/**
+ * @name CCFFILEWriter class
+ * @implemented
+ *
+ * Writes all queued chunks and stops the writer thread
+ *
+ * @return
+ * Status of operation, CAB_STATUS_CANNOT_WRITE if a write failed
+ */
+ULONG CCFFILEWriter::Stop()
+{
+    {
+        std::lock_guard<std::mutex> Guard(Lock);
+        Quit = true;
+    }
+    ChunkQueued.notify_all();
+
+    if (Thread.joinable())
+        Thread.join();
+
+    return Status;
+}
+
+/**
+ * @name CCFFILEWriter class
+ * @implemented
+ *
+ * Waits until a chunk is free
+ *
+ * @return
+ * An empty chunk with room for one uncompressed data block
+ */
+PCFFILE_CHUNK CCFFILEWriter::GetChunk()
+{
+    std::unique_lock<std::mutex> Guard(Lock);
+    PCFFILE_CHUNK Chunk;
+
+    ChunkFreed.wait(Guard, [this] { return !FreeChunks.empty(); });
+    Chunk = FreeChunks.back();
+    FreeChunks.pop_back();
+
+    Chunk->Segments.clear();
+    return Chunk;
+}
+
+/**
+ * @name CCFFILEWriter class
+ * @implemented
+ *
+ * Queues a chunk for writing. Files marked for closing are closed by
+ * the writer thread, even if an earlier write failed.
+ */
+void CCFFILEWriter::Queue(PCFFILE_CHUNK Chunk)
+{
+    {
+        std::lock_guard<std::mutex> Guard(Lock);
+        Queued.push_back(Chunk);
+    }
+    ChunkQueued.notify_one();
+}
+
+/**
+ * @name CCFFILEWriter class
+ * @implemented
+ *
+ * Writer thread, writes chunks until the writer is stopped
+ */
+void CCFFILEWriter::WorkerProc()
+{
+    std::unique_lock<std::mutex> Guard(Lock);
+    PCFFILE_CHUNK Chunk;
+
+    for (;;)
+    {
+        ChunkQueued.wait(Guard, [this] { return Quit || !Queued.empty(); });
+        if (Queued.empty())
+            break;
+
+        Chunk = Queued.front();
+        Queued.pop_front();
+
+        Guard.unlock();
+        for (CFFILE_SEGMENT& Segment : Chunk->Segments)
+        {
+            if (Segment.Length > 0 && Status == CAB_STATUS_SUCCESS &&
+                fwrite(&Chunk->Data[Segment.Offset], Segment.Length, 1, Segment.DestFile) < 1)
+            {
+                DPRINT(MIN_TRACE, ("Cannot write to file.\n"));
+                Status = CAB_STATUS_CANNOT_WRITE;
+            }
+
+            if (Segment.Close)
+                fclose(Segment.DestFile);
+        }
+        Guard.lock();
+
+        FreeChunks.push_back(Chunk);
+        ChunkFreed.notify_one();
+    }
+}
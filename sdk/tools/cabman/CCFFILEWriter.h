@@ -0,0 +1,59 @@
+/*
+ * PROJECT:     ReactOS cabinet manager
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Writes extracted files on a separate thread
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#pragma once
+
+#include "cabinet.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+typedef struct _CFFILE_SEGMENT
+{
+    FILE*   DestFile;   // File to write to
+    ULONG   Offset;     // Offset of the data in the chunk
+    ULONG   Length;     // Number of bytes to write, may be 0
+    bool    Close;      // Close the file afterwards
+} CFFILE_SEGMENT, *PCFFILE_SEGMENT;
+
+typedef struct _CFFILE_CHUNK
+{
+    std::vector<unsigned char>  Data;       // One uncompressed data block
+    std::vector<CFFILE_SEGMENT> Segments;   // Parts of the block to write
+} CFFILE_CHUNK, *PCFFILE_CHUNK;
+
+class CCFFILEWriter
+{
+public:
+    /* Default constructor */
+    CCFFILEWriter();
+    /* Default destructor */
+    virtual ~CCFFILEWriter();
+    /* Starts the writer thread */
+    ULONG Start();
+    /* Writes all queued chunks and stops the writer thread */
+    ULONG Stop();
+    /* Waits for a free chunk */
+    PCFFILE_CHUNK GetChunk();
+    /* Queues a chunk for writing */
+    void Queue(PCFFILE_CHUNK Chunk);
+private:
+    void WorkerProc();
+    std::mutex Lock;
+    std::condition_variable ChunkQueued;    // Signalled when a chunk is queued
+    std::condition_variable ChunkFreed;     // Signalled when a chunk is written
+    std::deque<PCFFILE_CHUNK> Queued;
+    std::vector<PCFFILE_CHUNK> FreeChunks;
+    std::vector<PCFFILE_CHUNK> Chunks;
+    std::thread Thread;
+    ULONG Status;
+    bool Quit;
+};
@@ -0,0 +1,176 @@
+/*
+ * PROJECT:     ReactOS cabinet manager
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Benchmark of serial versus multi-threaded cabinet creation
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "cabinet.h"
+
+ULONG DebugTraceLevel = MIN_TRACE;
+
+#define BENCH_PREFIX      "cabbench_"
+#define BENCH_FILE_COUNT  24
+#define BENCH_FILE_SIZE   (1024 * 1024)
+
+class CBenchCabinet : public CCabinet
+{
+private:
+    virtual void OnAdd(PCFFILE Entry, const char* FileName) override
+    {
+    }
+};
+
+static const char* BenchWords[] =
+{
+    "NTSTATUS", "NTAPI", "ULONG", "PVOID", "Status", "return", "if", "else",
+    "STATUS_SUCCESS", "IoCallDriver", "ExAllocatePoolWithTag", "NULL", "{",
+    "}", "(", ")", ";", "KeAcquireSpinLock", "Irp", "DeviceObject", "0x",
+};
+
+/* Semi-compressible data, roughly like the binaries that go in reactos.cab */
+static bool GenerateFile(const std::string& Name, ULONG Seed)
+{
+    std::vector<unsigned char> Data(BENCH_FILE_SIZE);
+    ULONG State = Seed * 2654435761u + 1;
+    size_t i = 0;
+
+    while (i < Data.size())
+    {
+        State = State * 1103515245u + 12345u;
+
+        if ((State >> 28) < 3)
+        {
+            /* Random bytes that do not compress */
+            for (ULONG n = 0; n < 16 && i < Data.size(); n++)
+            {
+                State = State * 1103515245u + 12345u;
+                Data[i++] = (unsigned char)(State >> 16);
+            }
+        }
+        else
+        {
+            const char* Word = BenchWords[(State >> 16) % _countof(BenchWords)];
+
+            while (*Word && i < Data.size())
+                Data[i++] = *Word++;
+            if (i < Data.size())
+                Data[i++] = ' ';
+        }
+    }
+
+    FILE* File = fopen(Name.c_str(), "wb");
+    if (!File)
+        return false;
+
+    bool Ok = (fwrite(Data.data(), 1, Data.size(), File) == Data.size());
+    fclose(File);
+    return Ok;
+}
+
+static bool CreateCabinet(const std::string& Name, ULONG Jobs, double* Seconds)
+{
+    CBenchCabinet Cabinet;
+
+    Cabinet.SetCabinetName(Name.c_str());
+    Cabinet.SelectCodec(CAB_CODEC_MSZIP);
+    Cabinet.SetJobCount(Jobs);
+    Cabinet.AddSearchCriteria(BENCH_PREFIX "in_*.dat", std::string());
+
+    auto Start = std::chrono::steady_clock::now();
+    bool Ok = Cabinet.CreateSimpleCabinet();
+    auto End = std::chrono::steady_clock::now();
+
+    *Seconds = std::chrono::duration<double>(End - Start).count();
+    return Ok;
+}
+
+static bool ReadWholeFile(const std::string& Name, std::vector<unsigned char>& Data)
+{
+    FILE* File = fopen(Name.c_str(), "rb");
+    if (!File)
+        return false;
+
+    LONG Size = GetSizeOfFile(File);
+    if (Size < 0)
+    {
+        fclose(File);
+        return false;
+    }
+
+    Data.resize(Size);
+    bool Ok = (fread(Data.data(), 1, Data.size(), File) == Data.size());
+    fclose(File);
+    return Ok;
+}
+
+int main(int argc, char* argv[])
+{
+    ULONG Jobs = std::thread::hardware_concurrency();
+    std::vector<unsigned char> Serial, Parallel;
+    double SerialTime, ParallelTime;
+    int Result = 1;
+    char Name[64];
+    ULONG i;
+
+    if (argc > 1)
+        Jobs = strtoul(argv[1], NULL, 10);
+    if (Jobs < 2)
+        Jobs = 2;
+
+    printf("Generating %u files of %u KB\n", BENCH_FILE_COUNT, BENCH_FILE_SIZE / 1024);
+    for (i = 0; i < BENCH_FILE_COUNT; i++)
+    {
+        snprintf(Name, sizeof(Name), BENCH_PREFIX "in_%02u.dat", (UINT)i);
+        if (!GenerateFile(Name, i))
+        {
+            printf("Cannot write %s\n", Name);
+            goto cleanup;
+        }
+    }
+
+    if (!CreateCabinet(BENCH_PREFIX "1.cab", 1, &SerialTime) ||
+        !CreateCabinet(BENCH_PREFIX "n.cab", Jobs, &ParallelTime))
+    {
+        printf("Cannot create cabinet\n");
+        goto cleanup;
+    }
+
+    printf("1 thread:   %.3f s\n", SerialTime);
+    printf("%u threads: %.3f s (%.2fx)\n", (UINT)Jobs, ParallelTime, SerialTime / ParallelTime);
+
+    if (!ReadWholeFile(BENCH_PREFIX "1.cab", Serial) ||
+        !ReadWholeFile(BENCH_PREFIX "n.cab", Parallel))
+    {
+        printf("Cannot read cabinet\n");
+        goto cleanup;
+    }
+
+    /* The date and time stamps come from the same input files */
+    if (Serial != Parallel)
+    {
+        printf("Cabinets differ!\n");
+        goto cleanup;
+    }
+
+    printf("Cabinets are identical (%u bytes)\n", (UINT)Serial.size());
+    Result = 0;
+
+cleanup:
+    for (i = 0; i < BENCH_FILE_COUNT; i++)
+    {
+        snprintf(Name, sizeof(Name), BENCH_PREFIX "in_%02u.dat", (UINT)i);
+        remove(Name);
+    }
+    remove(BENCH_PREFIX "1.cab");
+    remove(BENCH_PREFIX "n.cab");
+
+    return Result;
+}
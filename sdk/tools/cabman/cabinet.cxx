@@ -25,8 +25,12 @@
 #endif
 #include "cabinet.h"
 #include "CCFDATAStorage.h"
+#include "CCFDATACompressor.h"
+#include "CCFFILEWriter.h"
 #include "raw.h"
 #include "mszip.h"
+#include "lzx.h"
+#include <algorithm>
 
 #ifndef CAB_READ_ONLY
 
@@ -92,6 +96,8 @@ CCabinet::CCabinet()
     MaxDiskSize  = 0;
     BlockIsSplit = false;
     ScratchFile  = NULL;
+    JobCount     = 1;
+    Compressor   = NULL;
 
     FolderUncompSize = 0;
     BytesLeftInBlock = 0;
@@ -296,6 +302,8 @@ bool CCabinet::SetCompressionCodec(const char* CodecName)
         SelectCodec(CAB_CODEC_RAW);
     else if( !strcasecmp(CodecName, "mszip") )
         SelectCodec(CAB_CODEC_MSZIP);
+    else if( !strcasecmp(CodecName, "lzx") )
+        SelectCodec(CAB_CODEC_LZX);
     else
     {
         printf("ERROR: Invalid codec specified!\n");
@@ -670,10 +678,6 @@ ULONG CCabinet::ExtractFile(const char* FileName)
     CFDATA CFData;
     ULONG Status;
     bool Skip;
-#if defined(_WIN32)
-    FILETIME FileTime;
-#endif
-    CHAR DestName[PATH_MAX];
     CHAR TempName[PATH_MAX];
 
     Status = LocateFile(FileName, &File);
@@ -685,19 +689,9 @@ ULONG CCabinet::ExtractFile(const char* FileName)
 
     LastFileOffset = File->File.FileOffset;
 
-    switch (CurrentFolderNode->Folder.CompressionType & CAB_COMP_MASK)
-    {
-        case CAB_COMP_NONE:
-            SelectCodec(CAB_CODEC_RAW);
-            break;
-
-        case CAB_COMP_MSZIP:
-            SelectCodec(CAB_CODEC_MSZIP);
-            break;
-
-        default:
-            return CAB_STATUS_UNSUPPCOMP;
-    }
+    Status = SelectFolderCodec(CurrentFolderNode);
+    if (Status != CAB_STATUS_SUCCESS)
+        return Status;
 
     DPRINT(MAX_TRACE, ("Extracting file at uncompressed offset (0x%X)  Size (%u bytes)  AO (0x%X)  UO (0x%X).\n",
         (UINT)File->File.FileOffset,
@@ -705,47 +699,11 @@ ULONG CCabinet::ExtractFile(const char* FileName)
         (UINT)File->DataBlock->AbsoluteOffset,
         (UINT)File->DataBlock->UncompOffset));
 
-    strcpy(DestName, DestPath.c_str());
-    strcat(DestName, FileName);
-
-    /* Create destination file, fail if it already exists */
-    DestFile = fopen(DestName, "rb");
-    if (DestFile != NULL)
-    {
-        fclose(DestFile);
-        /* If file exists, ask to overwrite file */
-        if (OnOverwrite(&File->File, FileName))
-        {
-            DestFile = fopen(DestName, "w+b");
-            if (DestFile == NULL)
-                return CAB_STATUS_CANNOT_CREATE;
-        }
-        else
-            return CAB_STATUS_FILE_EXISTS;
-    }
-    else
-    {
-        DestFile = fopen(DestName, "w+b");
-        if (DestFile == NULL)
-            return CAB_STATUS_CANNOT_CREATE;
-    }
-
-#if defined(_WIN32)
-    if (!DosDateTimeToFileTime(File->File.FileDate, File->File.FileTime, &FileTime))
-    {
-        fclose(DestFile);
-        DPRINT(MIN_TRACE, ("DosDateTimeToFileTime() failed (%u).\n", (UINT)GetLastError()));
-        return CAB_STATUS_CANNOT_WRITE;
-    }
-
-    SetFileTime(DestFile, NULL, &FileTime, NULL);
-#else
-    //DPRINT(MIN_TRACE, ("FIXME: DosDateTimeToFileTime\n"));
-#endif
-
-    SetAttributesOnFile(DestName, File->File.Attributes);
+    Status = CreateDestFile(File, &DestFile);
+    if (Status != CAB_STATUS_SUCCESS)
+        return Status;
 
-    Buffer = (PUCHAR)malloc(CAB_BLOCKSIZE + 12); // This should be enough
+    Buffer = (PUCHAR)malloc(CAB_MAX_COMPSIZE);
     if (!Buffer)
     {
         fclose(DestFile);
@@ -756,6 +714,15 @@ ULONG CCabinet::ExtractFile(const char* FileName)
     /* Call OnExtract event handler */
     OnExtract(&File->File, FileName);
 
+    /* Bring the codec up to the first data block of the file */
+    Status = SkipDataBlocks(CurrentFolderNode, File->DataBlock, Buffer);
+    if (Status != CAB_STATUS_SUCCESS)
+    {
+        fclose(DestFile);
+        free(Buffer);
+        return Status;
+    }
+
     /* Search to start of file */
     if (fseek(FileHandle, (off_t)File->DataBlock->AbsoluteOffset, SEEK_SET) != 0)
     {
@@ -804,7 +771,7 @@ ULONG CCabinet::ExtractFile(const char* FileName)
                         CFData.CompSize,
                         CFData.UncompSize));
 
-                    ASSERT(CFData.CompSize <= CAB_BLOCKSIZE + 12);
+                    ASSERT(CFData.CompSize <= CAB_MAX_COMPSIZE);
 
                     BytesToRead = CFData.CompSize;
 
@@ -905,6 +872,7 @@ ULONG CCabinet::ExtractFile(const char* FileName)
 
                 DPRINT(MAX_TRACE, ("TotalBytesRead (%u).\n", (UINT)TotalBytesRead));
 
+                BytesToWrite = CFData.UncompSize;
                 Status = Codec->Uncompress(OutputBuffer, Buffer, TotalBytesRead, &BytesToWrite);
                 if (Status != CS_SUCCESS)
                 {
@@ -1005,6 +973,85 @@ ULONG CCabinet::ExtractFile(const char* FileName)
     return CAB_STATUS_SUCCESS;
 }
 
+ULONG CCabinet::ExtractFiles()
+/*
+ * FUNCTION: Extracts all files that match the search criteria
+ * RETURNS
+ *     Status of operation
+ * NOTES:
+ *     Every folder is uncompressed only once, from its first data block
+ *     to the end of the last file wanted, and the files are written in
+ *     the order they are stored while the next block is uncompressed.
+ *     Files that span cabinets must be extracted with ExtractFile().
+ */
+{
+    std::vector<PCFFILE_NODE> Files;
+    std::vector<PCFFILE_NODE> FolderFiles;
+    PCFFOLDER_NODE FolderNode;
+    ULONG Status;
+    size_t i;
+
+    for (PCFFILE_NODE Node : FileList)
+    {
+        if (MatchSearchCriteria(Node))
+            Files.push_back(Node);
+    }
+
+    if (Files.empty())
+        return CAB_STATUS_NOFILE;
+
+    std::stable_sort(Files.begin(), Files.end(),
+        [](PCFFILE_NODE a, PCFFILE_NODE b)
+        {
+            if (a->File.FileControlID != b->File.FileControlID)
+                return a->File.FileControlID < b->File.FileControlID;
+            return a->File.FileOffset < b->File.FileOffset;
+        });
+
+    for (i = 0; i < Files.size(); i++)
+    {
+        if (Files[i]->File.FileControlID > CAB_FILE_MAX_FOLDER)
+        {
+            DPRINT(MID_TRACE, ("File (%s) spans cabinets.\n", Files[i]->FileName.c_str()));
+            return CAB_STATUS_UNSUPPCOMP;
+        }
+
+        FolderFiles.push_back(Files[i]);
+
+        if (i + 1 < Files.size() &&
+            Files[i + 1]->File.FileControlID == Files[i]->File.FileControlID)
+        {
+            continue;
+        }
+
+        FolderNode = LocateFolderNode(Files[i]->File.FileControlID);
+        if (!FolderNode)
+        {
+            DPRINT(MID_TRACE, ("Folder with index number (%u) not found.\n",
+                Files[i]->File.FileControlID));
+            return CAB_STATUS_INVALID_CAB;
+        }
+
+        Status = ExtractFolder(FolderNode, FolderFiles);
+        if (Status != CAB_STATUS_SUCCESS)
+            return Status;
+
+        FolderFiles.clear();
+    }
+
+    return CAB_STATUS_SUCCESS;
+}
+
+bool CCabinet::IsSpanned()
+/*
+ * FUNCTION: Returns whether the cabinet is part of a set
+ * RETURNS:
+ *     true if the cabinet has a previous or a next cabinet
+ */
+{
+    return (CABHeader.Flags & (CAB_FLAG_HASPREV | CAB_FLAG_HASNEXT)) != 0;
+}
+
 bool CCabinet::IsCodecSelected()
 /*
  * FUNCTION: Returns the value of CodecSelected
@@ -1031,22 +1078,37 @@ void CCabinet::SelectCodec(LONG Id)
         delete Codec;
     }
 
+    Codec = CreateCodec(Id);
+    if (!Codec)
+        return;
+
+    CodecId       = Id;
+    CodecSelected = true;
+}
+
+CCABCodec* CCabinet::CreateCodec(LONG Id)
+/*
+ * FUNCTION: Creates an instance of a codec engine
+ * ARGUMENTS:
+ *     Id = Codec identifier
+ * RETURNS:
+ *     Pointer to the codec, NULL if the identifier is unknown
+ */
+{
     switch (Id)
     {
         case CAB_CODEC_RAW:
-            Codec = new CRawCodec();
-            break;
+            return new CRawCodec();
 
         case CAB_CODEC_MSZIP:
-            Codec = new CMSZipCodec();
-            break;
+            return new CMSZipCodec();
+
+        case CAB_CODEC_LZX:
+            return new CLZXCodec();
 
         default:
-            return;
+            return NULL;
     }
-
-    CodecId       = Id;
-    CodecSelected = true;
 }
 
 
@@ -1065,7 +1127,7 @@ ULONG CCabinet::NewCabinet()
 
     CurrentDiskNumber = 0;
 
-    OutputBuffer = malloc(CAB_BLOCKSIZE + 12); // This should be enough
+    OutputBuffer = malloc(CAB_MAX_COMPSIZE);
     InputBuffer  = malloc(CAB_BLOCKSIZE + 12); // This should be enough
     if ((!OutputBuffer) || (!InputBuffer))
     {
@@ -1114,6 +1176,32 @@ ULONG CCabinet::NewCabinet()
     }
 
     Status = ScratchFile->Create();
+    if (Status != CAB_STATUS_SUCCESS)
+        return Status;
+
+    /* LZX blocks share one sliding window, so they are compressed in order */
+    if (JobCount > 1 && CodecId != CAB_CODEC_LZX)
+    {
+        std::vector<CCABCodec*> Codecs;
+
+        /* Every worker thread gets a codec of its own */
+        for (ULONG i = 0; i < JobCount; i++)
+        {
+            CCABCodec* WorkerCodec = CreateCodec(CodecId);
+            if (!WorkerCodec)
+            {
+                for (CCABCodec* Other : Codecs)
+                    delete Other;
+                return CAB_STATUS_UNSUPPCOMP;
+            }
+            Codecs.push_back(WorkerCodec);
+        }
+
+        Compressor = new CCFDATACompressor;
+        Status = Compressor->Start(Codecs);
+        if (Status != CAB_STATUS_SUCCESS)
+            return Status;
+    }
 
     CreateNewFolder = false;
 
@@ -1156,8 +1244,15 @@ ULONG CCabinet::NewFolder()
  *     Status of operation
  */
 {
+    ULONG Status;
+
     DPRINT(MAX_TRACE, ("Creating new folder.\n"));
 
+    /* Blocks of the previous folder still count towards LastBlockStart */
+    Status = FlushDataBlocks();
+    if (Status != CAB_STATUS_SUCCESS)
+        return Status;
+
     CurrentFolderNode = NewFolderNode();
     if (!CurrentFolderNode)
     {
@@ -1174,10 +1269,18 @@ ULONG CCabinet::NewFolder()
             CurrentFolderNode->Folder.CompressionType = CAB_COMP_MSZIP;
             break;
 
+        case CAB_CODEC_LZX:
+            CurrentFolderNode->Folder.CompressionType = CAB_COMP_LZX |
+                (LZX_WINDOW_BITS << CAB_COMP_LZX_WINDOW_SHIFT);
+            break;
+
         default:
             return CAB_STATUS_UNSUPPCOMP;
     }
 
+    if (CodecSelected && Codec->Reset(CurrentFolderNode->Folder.CompressionType) != CS_SUCCESS)
+        return CAB_STATUS_UNSUPPCOMP;
+
     /* FIXME: This won't work if no files are added to the new folder */
 
     DiskSize += sizeof(CFFOLDER);
@@ -1401,6 +1504,10 @@ ULONG CCabinet::CommitDisk(ULONG MoreDisks)
 {
     ULONG Status;
 
+    Status = FlushDataBlocks();
+    if (Status != CAB_STATUS_SUCCESS)
+        return Status;
+
     OnCabinetName(CurrentDiskNumber, CabinetName);
 
     /* Create file, fail if it already exists */
@@ -1501,6 +1608,12 @@ ULONG CCabinet::CloseCabinet()
 
     Close();
 
+    if (Compressor)
+    {
+        delete Compressor;
+        Compressor = NULL;
+    }
+
     if (ScratchFile)
     {
         Status = ScratchFile->Destroy();
@@ -1727,6 +1840,18 @@ void CCabinet::SetMaxDiskSize(ULONG Size)
     MaxDiskSize = Size;
 }
 
+void CCabinet::SetJobCount(ULONG Count)
+/*
+ * FUNCTION: Sets the number of threads compressing data blocks
+ * ARGUMENTS:
+ *     Count = Number of threads (1 compresses on the calling thread)
+ * NOTES:
+ *     Must be called before NewCabinet
+ */
+{
+    JobCount = (Count > 0) ? Count : 1;
+}
+
 #endif /* CAB_READ_ONLY */
 
 
@@ -2102,6 +2227,347 @@ ULONG CCabinet::ReadDataBlocks(PCFFOLDER_NODE FolderNode)
 }
 
 
+ULONG CCabinet::SelectFolderCodec(PCFFOLDER_NODE FolderNode)
+/*
+ * FUNCTION: Selects and resets the codec for the data blocks of a folder
+ * ARGUMENTS:
+ *     FolderNode = Pointer to CFFOLDER_NODE structure for folder
+ * RETURNS:
+ *     Status of operation
+ */
+{
+    switch (FolderNode->Folder.CompressionType & CAB_COMP_MASK)
+    {
+        case CAB_COMP_NONE:
+            SelectCodec(CAB_CODEC_RAW);
+            break;
+
+        case CAB_COMP_MSZIP:
+            SelectCodec(CAB_CODEC_MSZIP);
+            break;
+
+        case CAB_COMP_LZX:
+            SelectCodec(CAB_CODEC_LZX);
+            break;
+
+        default:
+            return CAB_STATUS_UNSUPPCOMP;
+    }
+
+    if (!CodecSelected)
+        return CAB_STATUS_NOMEMORY;
+
+    if (Codec->Reset(FolderNode->Folder.CompressionType) != CS_SUCCESS)
+        return CAB_STATUS_UNSUPPCOMP;
+
+    return CAB_STATUS_SUCCESS;
+}
+
+
+ULONG CCabinet::UncompressDataBlock(PCFDATA_NODE Node, void* Buffer, void* Output)
+/*
+ * FUNCTION: Reads and uncompresses one data block
+ * ARGUMENTS:
+ *     Node   = Pointer to CFDATA_NODE structure for data block
+ *     Buffer = Pointer to buffer for the compressed data
+ *     Output = Pointer to buffer for the uncompressed data
+ * RETURNS:
+ *     Status of operation
+ */
+{
+    ULONG BytesRead;
+    ULONG BytesWritten;
+    ULONG Status;
+
+    if (Node->Data.UncompSize == 0 || Node->Data.CompSize > CAB_MAX_COMPSIZE)
+    {
+        DPRINT(MIN_TRACE, ("Bad data block (%u, %u).\n",
+            Node->Data.CompSize, Node->Data.UncompSize));
+        return CAB_STATUS_INVALID_CAB;
+    }
+
+    if (fseek(FileHandle, (off_t)Node->AbsoluteOffset + sizeof(CFDATA), SEEK_SET) != 0)
+    {
+        DPRINT(MIN_TRACE, ("fseek() failed.\n"));
+        return CAB_STATUS_INVALID_CAB;
+    }
+
+    Status = ReadBlock(Buffer, Node->Data.CompSize, &BytesRead);
+    if (Status != CAB_STATUS_SUCCESS)
+    {
+        DPRINT(MIN_TRACE, ("Cannot read from file (%u).\n", (UINT)Status));
+        return CAB_STATUS_INVALID_CAB;
+    }
+
+    BytesWritten = Node->Data.UncompSize;
+    Status = Codec->Uncompress(Output, Buffer, BytesRead, &BytesWritten);
+    if (Status != CS_SUCCESS)
+    {
+        DPRINT(MID_TRACE, ("Cannot uncompress block.\n"));
+        if (Status == CS_NOMEMORY)
+            return CAB_STATUS_NOMEMORY;
+        return CAB_STATUS_INVALID_CAB;
+    }
+
+    if (BytesWritten != Node->Data.UncompSize)
+    {
+        DPRINT(MID_TRACE, ("BytesWritten (%u) != UncompSize (%d)\n",
+            (UINT)BytesWritten, Node->Data.UncompSize));
+        return CAB_STATUS_INVALID_CAB;
+    }
+
+    return CAB_STATUS_SUCCESS;
+}
+
+
+ULONG CCabinet::SkipDataBlocks(PCFFOLDER_NODE FolderNode, PCFDATA_NODE Node, void* Buffer)
+/*
+ * FUNCTION: Prepares the codec to uncompress a data block
+ * ARGUMENTS:
+ *     FolderNode = Pointer to CFFOLDER_NODE structure for folder
+ *     Node       = Pointer to CFDATA_NODE structure for data block
+ *     Buffer     = Pointer to buffer for the compressed data
+ * RETURNS:
+ *     Status of operation
+ * NOTES:
+ *     LZX data blocks refer to the data of earlier blocks in the folder,
+ *     so these have to be uncompressed first. Other codecs start anywhere.
+ */
+{
+    ULONG Status;
+
+    if (CodecId != CAB_CODEC_LZX)
+        return CAB_STATUS_SUCCESS;
+
+    for (PCFDATA_NODE Block : FolderNode->DataList)
+    {
+        if (Block == Node)
+            break;
+
+        Status = UncompressDataBlock(Block, Buffer, OutputBuffer);
+        if (Status != CAB_STATUS_SUCCESS)
+            return Status;
+    }
+
+    return CAB_STATUS_SUCCESS;
+}
+
+
+ULONG CCabinet::CreateDestFile(PCFFILE_NODE File, FILE** DestFile)
+/*
+ * FUNCTION: Creates the destination file of a file being extracted
+ * ARGUMENTS:
+ *     File     = Pointer to CFFILE_NODE structure for file
+ *     DestFile = Address of pointer to receive the open file
+ * RETURNS:
+ *     Status of operation
+ */
+{
+#if defined(_WIN32)
+    FILETIME FileTime;
+#endif
+    CHAR DestName[PATH_MAX];
+
+    strcpy(DestName, DestPath.c_str());
+    strcat(DestName, File->FileName.c_str());
+
+    /* Create destination file, fail if it already exists */
+    *DestFile = fopen(DestName, "rb");
+    if (*DestFile != NULL)
+    {
+        fclose(*DestFile);
+        /* If file exists, ask to overwrite file */
+        if (OnOverwrite(&File->File, File->FileName.c_str()))
+        {
+            *DestFile = fopen(DestName, "w+b");
+            if (*DestFile == NULL)
+                return CAB_STATUS_CANNOT_CREATE;
+        }
+        else
+            return CAB_STATUS_FILE_EXISTS;
+    }
+    else
+    {
+        *DestFile = fopen(DestName, "w+b");
+        if (*DestFile == NULL)
+            return CAB_STATUS_CANNOT_CREATE;
+    }
+
+#if defined(_WIN32)
+    if (!DosDateTimeToFileTime(File->File.FileDate, File->File.FileTime, &FileTime))
+    {
+        fclose(*DestFile);
+        DPRINT(MIN_TRACE, ("DosDateTimeToFileTime() failed (%u).\n", (UINT)GetLastError()));
+        return CAB_STATUS_CANNOT_WRITE;
+    }
+
+    SetFileTime(*DestFile, NULL, &FileTime, NULL);
+#else
+    //DPRINT(MIN_TRACE, ("FIXME: DosDateTimeToFileTime\n"));
+#endif
+
+    SetAttributesOnFile(DestName, File->File.Attributes);
+
+    return CAB_STATUS_SUCCESS;
+}
+
+
+ULONG CCabinet::ExtractFolder(PCFFOLDER_NODE FolderNode, std::vector<PCFFILE_NODE>& Files)
+/*
+ * FUNCTION: Extracts files from a folder in one pass
+ * ARGUMENTS:
+ *     FolderNode = Pointer to CFFOLDER_NODE structure for folder
+ *     Files      = Files to extract, sorted by their offset in the folder
+ * RETURNS:
+ *     Status of operation
+ */
+{
+    std::vector<std::pair<PCFFILE_NODE, FILE*>> Active;
+    CCFFILEWriter Writer;
+    PCFFILE_CHUNK Chunk;
+    PUCHAR Buffer;
+    ULONG BlockStart;
+    ULONG BlockEnd;
+    ULONG FileStart;
+    ULONG FileEnd;
+    ULONG Status;
+    ULONG WriterStatus;
+    size_t Next = 0;
+    size_t i;
+
+    Status = SelectFolderCodec(FolderNode);
+    if (Status != CAB_STATUS_SUCCESS)
+        return Status;
+
+    Buffer = (PUCHAR)malloc(CAB_MAX_COMPSIZE);
+    if (!Buffer)
+    {
+        DPRINT(MIN_TRACE, ("Insufficient memory.\n"));
+        return CAB_STATUS_NOMEMORY;
+    }
+
+    Status = Writer.Start();
+    if (Status != CAB_STATUS_SUCCESS)
+    {
+        free(Buffer);
+        return Status;
+    }
+
+    for (PCFDATA_NODE Node : FolderNode->DataList)
+    {
+        if (Next == Files.size() && Active.empty())
+            break;
+
+        BlockStart = Node->UncompOffset;
+        BlockEnd   = Node->UncompOffset + Node->Data.UncompSize;
+
+        /* Open the files that start in this block */
+        while (Next < Files.size() &&
+               (Files[Next]->File.FileOffset < BlockEnd ||
+               (Files[Next]->File.FileSize == 0 && Files[Next]->File.FileOffset <= BlockEnd)))
+        {
+            FILE* DestFile;
+
+            Status = CreateDestFile(Files[Next], &DestFile);
+            if (Status != CAB_STATUS_SUCCESS)
+                break;
+
+            OnExtract(&Files[Next]->File, Files[Next]->FileName.c_str());
+
+            if (Files[Next]->File.FileSize == 0)
+                fclose(DestFile);
+            else
+                Active.push_back(std::make_pair(Files[Next], DestFile));
+            Next++;
+        }
+
+        if (Status != CAB_STATUS_SUCCESS)
+            break;
+
+        /* Blocks in front of the next file are only needed by LZX */
+        if (Active.empty() && CodecId != CAB_CODEC_LZX)
+            continue;
+
+        Chunk = Writer.GetChunk();
+
+        Status = UncompressDataBlock(Node, Buffer, Chunk->Data.data());
+        if (Status != CAB_STATUS_SUCCESS)
+        {
+            Writer.Queue(Chunk);
+            break;
+        }
+
+        for (i = 0; i < Active.size(); )
+        {
+            PCFFILE File = &Active[i].first->File;
+            CFFILE_SEGMENT Segment;
+
+            FileStart = std::max((ULONG)File->FileOffset, BlockStart);
+            FileEnd   = std::min((ULONG)(File->FileOffset + File->FileSize), BlockEnd);
+
+            Segment.DestFile = Active[i].second;
+            Segment.Offset   = FileStart - BlockStart;
+            Segment.Length   = (FileEnd > FileStart) ? FileEnd - FileStart : 0;
+            Segment.Close    = (File->FileOffset + File->FileSize <= BlockEnd);
+            Chunk->Segments.push_back(Segment);
+
+            if (Segment.Close)
+                Active.erase(Active.begin() + i);
+            else
+                i++;
+        }
+
+        Writer.Queue(Chunk);
+    }
+
+    if (Status == CAB_STATUS_SUCCESS && (Next < Files.size() || !Active.empty()))
+    {
+        DPRINT(MIN_TRACE, ("Folder ends before the last file.\n"));
+        Status = CAB_STATUS_INVALID_CAB;
+    }
+
+    /* Close the files that were not completed */
+    if (!Active.empty())
+    {
+        Chunk = Writer.GetChunk();
+        for (auto& Entry : Active)
+            Chunk->Segments.push_back({ Entry.second, 0, 0, true });
+        Writer.Queue(Chunk);
+    }
+
+    WriterStatus = Writer.Stop();
+    if (Status == CAB_STATUS_SUCCESS)
+        Status = WriterStatus;
+
+    free(Buffer);
+
+    return Status;
+}
+
+
+bool CCabinet::MatchSearchCriteria(PCFFILE_NODE File)
+/*
+ * FUNCTION: Checks a file against the search criteria
+ * ARGUMENTS:
+ *     File = Pointer to CFFILE_NODE structure for file
+ * RETURNS:
+ *     Whether the file matches, all files match if there are no criteria
+ */
+{
+    if (CriteriaList.empty())
+        return true;
+
+    for (PSEARCH_CRITERIA Criteria : CriteriaList)
+    {
+        // FIXME: We could handle path\filename here
+        if (MatchFileNamePattern(File->FileName.c_str(), Criteria->Search.c_str()))
+            return true;
+    }
+
+    return false;
+}
+
+
 PCFFOLDER_NODE CCabinet::NewFolderNode()
 /*
  * FUNCTION: Creates a new folder node
@@ -2759,6 +3225,11 @@ ULONG CCabinet::WriteDataBlock()
     ULONG BytesWritten;
     PCFDATA_NODE DataNode;
 
+    /* Without a disk size limit nothing depends on the compressed size
+       right away, so the block can be compressed in the background */
+    if (Compressor && MaxDiskSize == 0)
+        return QueueDataBlock();
+
     if (!BlockIsSplit)
     {
         Status = Codec->Compress(OutputBuffer,
@@ -2835,6 +3306,110 @@ ULONG CCabinet::WriteDataBlock()
     return CAB_STATUS_SUCCESS;
 }
 
+
+ULONG CCabinet::QueueDataBlock()
+/*
+ * FUNCTION: Hands the current data block to the compression threads
+ * RETURNS:
+ *     Status of operation
+ */
+{
+    ULONG Status;
+
+    /* Bound the memory used by blocks in flight */
+    while (Compressor->Pending() >= JobCount * 4)
+    {
+        Status = RetireDataBlock();
+        if (Status != CAB_STATUS_SUCCESS)
+            return Status;
+    }
+
+    Status = Compressor->Submit(CurrentFolderNode, InputBuffer, CurrentIBufferSize);
+    if (Status != CAB_STATUS_SUCCESS)
+        return Status;
+
+    CurrentIBufferSize = 0;
+    CurrentIBuffer     = InputBuffer;
+
+    return CAB_STATUS_SUCCESS;
+}
+
+
+ULONG CCabinet::RetireDataBlock()
+/*
+ * FUNCTION: Writes the oldest block compressed in the background to the scratch file
+ * RETURNS:
+ *     Status of operation
+ */
+{
+    ULONG Status;
+    ULONG BytesWritten;
+    PCFDATA_NODE DataNode;
+    PCFDATA_JOB Job;
+
+    Job = Compressor->Retire();
+    if (!Job)
+        return CAB_STATUS_SUCCESS;
+
+    DPRINT(MAX_TRACE, ("Block compressed. InputLength (%u)  OutputLength(%u).\n",
+        (UINT)Job->InputLength, (UINT)Job->OutputLength));
+
+    DataNode = NewDataNode(Job->FolderNode);
+    if (!DataNode)
+    {
+        DPRINT(MIN_TRACE, ("Insufficient memory.\n"));
+        Compressor->Release(Job);
+        return CAB_STATUS_NOMEMORY;
+    }
+
+    DataNode->Data.CompSize       = (USHORT)Job->OutputLength;
+    DataNode->Data.UncompSize     = (USHORT)Job->InputLength;
+    DataNode->Data.Checksum       = 0;
+    DataNode->ScratchFilePosition = ScratchFile->Position();
+
+    Status = ScratchFile->WriteBlock(&DataNode->Data,
+        Job->Output.data(), &BytesWritten);
+    if (Status != CAB_STATUS_SUCCESS)
+    {
+        Compressor->Release(Job);
+        return Status;
+    }
+
+    DiskSize += sizeof(CFDATA) + BytesWritten;
+
+    Job->FolderNode->TotalFolderSize += (BytesWritten + sizeof(CFDATA));
+    Job->FolderNode->Folder.DataBlockCount++;
+
+    LastBlockStart += DataNode->Data.UncompSize;
+
+    Compressor->Release(Job);
+
+    return CAB_STATUS_SUCCESS;
+}
+
+
+ULONG CCabinet::FlushDataBlocks()
+/*
+ * FUNCTION: Writes all blocks compressed in the background to the scratch file
+ * RETURNS:
+ *     Status of operation
+ */
+{
+    ULONG Status;
+
+    if (!Compressor)
+        return CAB_STATUS_SUCCESS;
+
+    while (Compressor->Pending() > 0)
+    {
+        Status = RetireDataBlock();
+        if (Status != CAB_STATUS_SUCCESS)
+            return Status;
+    }
+
+    return CAB_STATUS_SUCCESS;
+}
+
 #if !defined(_WIN32)
 
 void CCabinet::ConvertDateAndTime(time_t* Time,
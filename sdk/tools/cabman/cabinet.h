@@ -27,6 +27,7 @@
 #include <limits.h>
 #include <string>
 #include <list>
+#include <vector>
 
 #ifndef PATH_MAX
 #define PATH_MAX MAX_PATH
@@ -113,6 +114,7 @@ extern ULONG DebugTraceLevel;
 #define CAB_SIGNATURE        0x4643534D // "MSCF"
 #define CAB_VERSION          0x0103
 #define CAB_BLOCKSIZE        32768
+#define CAB_MAX_COMPSIZE     (CAB_BLOCKSIZE + 6144)  // Largest compressed CFDATA block
 
 #define CAB_COMP_MASK        0x00FF
 #define CAB_COMP_NONE        0x0000
@@ -120,6 +122,9 @@ extern ULONG DebugTraceLevel;
 #define CAB_COMP_QUANTUM     0x0002
 #define CAB_COMP_LZX         0x0003
 
+#define CAB_COMP_LZX_WINDOW_SHIFT 8     // LZX window size is 2^n, n in bits 8-12
+#define CAB_COMP_LZX_WINDOW_MASK  0x1F
+
 #define CAB_FLAG_HASPREV     0x0001
 #define CAB_FLAG_HASNEXT     0x0002
 #define CAB_FLAG_RESERVE     0x0004
@@ -270,6 +275,12 @@ typedef struct _CAB_SEARCH
 
 
 
+/* Codec status codes */
+#define CS_SUCCESS      0x0000  /* All data consumed */
+#define CS_NOMEMORY     0x0001  /* Not enough free memory */
+#define CS_BADSTREAM    0x0002  /* Bad data stream */
+
+
 /* Codecs */
 
 class CCABCodec
@@ -284,20 +295,16 @@ public:
                            void* InputBuffer,
                            ULONG InputLength,
                            PULONG OutputLength) = 0;
-    /* Uncompresses a data block */
+    /* Uncompresses a data block, OutputLength holds the expected size on entry */
     virtual ULONG Uncompress(void* OutputBuffer,
                              void* InputBuffer,
                              ULONG InputLength,
                              PULONG OutputLength) = 0;
+    /* Starts a new folder, codecs that keep state across data blocks drop it here */
+    virtual ULONG Reset(USHORT CompressionType) { return CS_SUCCESS; };
 };
 
 
-/* Codec status codes */
-#define CS_SUCCESS      0x0000  /* All data consumed */
-#define CS_NOMEMORY     0x0001  /* Not enough free memory */
-#define CS_BADSTREAM    0x0002  /* Bad data stream */
-
-
 /* Codec indentifiers */
 #define CAB_CODEC_RAW   0x00
 #define CAB_CODEC_LZX   0x01
@@ -344,6 +351,10 @@ public:
     ULONG FindNext(PCAB_SEARCH Search);
     /* Extracts a file from the current cabinet file */
     ULONG ExtractFile(const char* FileName);
+    /* Extracts all files matching the search criteria, one folder at a time */
+    ULONG ExtractFiles();
+    /* Returns whether the current cabinet file is part of a set */
+    bool IsSpanned();
     /* Select codec engine to use */
     void SelectCodec(LONG Id);
     /* Returns whether a codec engine is selected */
@@ -382,6 +393,8 @@ public:
     ULONG AddFile(const std::string& FileName, const std::string& TargetFolder);
     /* Sets the maximum size of the current disk */
     void SetMaxDiskSize(ULONG Size);
+    /* Sets the number of threads compressing data blocks */
+    void SetJobCount(ULONG Count);
 #endif /* CAB_READ_ONLY */
 
     /* Default event handlers */
@@ -409,6 +422,12 @@ private:
     ULONG ReadString(char* String, LONG MaxLength);
     ULONG ReadFileTable();
     ULONG ReadDataBlocks(PCFFOLDER_NODE FolderNode);
+    ULONG SelectFolderCodec(PCFFOLDER_NODE FolderNode);
+    ULONG UncompressDataBlock(PCFDATA_NODE Node, void* Buffer, void* Output);
+    ULONG SkipDataBlocks(PCFFOLDER_NODE FolderNode, PCFDATA_NODE Node, void* Buffer);
+    ULONG CreateDestFile(PCFFILE_NODE File, FILE** DestFile);
+    ULONG ExtractFolder(PCFFOLDER_NODE FolderNode, std::vector<PCFFILE_NODE>& Files);
+    bool MatchSearchCriteria(PCFFILE_NODE File);
     PCFFOLDER_NODE NewFolderNode();
     PCFFILE_NODE NewFileNode();
     PCFDATA_NODE NewDataNode(PCFFOLDER_NODE FolderNode);
@@ -420,6 +439,7 @@ private:
     ULONG ComputeChecksum(void* Buffer, ULONG Size, ULONG Seed);
     ULONG ReadBlock(void* Buffer, ULONG Size, PULONG BytesRead);
     bool MatchFileNamePattern(const char* FileName, const char* Pattern);
+    CCABCodec* CreateCodec(LONG Id);
 #ifndef CAB_READ_ONLY
     ULONG InitCabinetHeader();
     ULONG WriteCabinetHeader(bool MoreDisks);
@@ -427,6 +447,9 @@ private:
     ULONG WriteFileEntries();
     ULONG CommitDataBlocks(PCFFOLDER_NODE FolderNode);
     ULONG WriteDataBlock();
+    ULONG QueueDataBlock();
+    ULONG RetireDataBlock();
+    ULONG FlushDataBlocks();
     ULONG GetAttributesOnFile(PCFFILE_NODE File);
     ULONG SetAttributesOnFile(char* FileName, USHORT FileAttributes);
     ULONG GetFileTimes(FILE* FileHandle, PCFFILE_NODE File);
@@ -489,6 +512,8 @@ private:
     ULONG TotalBytesLeft;
     bool BlockIsSplit;                  // true if current data block is split
     ULONG NextFolderNumber;     // Zero based folder number
+    ULONG JobCount;             // Number of compression threads
+    class CCFDATACompressor *Compressor;  // NULL if blocks are compressed serially
 #endif /* CAB_READ_ONLY */
 };
 
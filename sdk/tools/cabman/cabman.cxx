@@ -14,6 +14,7 @@
 #include <stdarg.h>
 #include <string.h>
 #include <stdio.h>
+#include <thread>
 #include "cabman.h"
 
 
@@ -192,8 +193,8 @@ void CCABManager::Usage()
 {
     printf("ReactOS Cabinet Manager\n\n");
     printf("CABMAN [-D | -E] [-A] [-L dir] cabinet [filename ...]\n");
-    printf("CABMAN [-M mode] -C dirfile [-I] [-RC file] [-P dir]\n");
-    printf("CABMAN [-M mode] -S cabinet filename [-F folder] [filename] [...]\n");
+    printf("CABMAN [-M mode] [-J[n]] -C dirfile [-I] [-RC file] [-P dir]\n");
+    printf("CABMAN [-M mode] [-J[n]] -S cabinet filename [-F folder] [filename] [...]\n");
     printf("  cabinet   Cabinet file.\n");
     printf("  filename  Name of the file to add to or extract from the cabinet.\n");
     printf("            Wild cards and multiple filenames\n");
@@ -208,11 +209,14 @@ void CCABManager::Usage()
     printf("  -E        Extract files from cabinet.\n");
     printf("  -F        Put the files from the next 'filename' filter in the cab in folder\filename.\n");
     printf("  -I        Don't create the cabinet, only the .inf file.\n");
+    printf("  -J[n]     Compress data blocks on n threads\n");
+    printf("            (default is one thread per processor).\n");
     printf("  -L dir    Location to place extracted or generated files\n");
     printf("            (default is current directory).\n");
     printf("  -M mode   Specify the compression method to use:\n");
     printf("               raw    - No compression\n");
     printf("               mszip  - MsZip compression (default)\n");
+    printf("               lzx    - LZX compression, not multi-threaded\n");
     printf("  -N        Don't create the .inf file, only the cabinet.\n");
     printf("  -RC       Specify file to put in cabinet reserved area\n");
     printf("            (size must be less than 64KB).\n");
@@ -281,6 +285,26 @@ bool CCABManager::ParseCmdline(int argc, char* argv[])
                     InfFileOnly = true;
                     break;
 
+                case 'j':
+                case 'J':
+                    if (argv[i][2] == 0)
+                    {
+                        SetJobCount(std::thread::hardware_concurrency());
+                    }
+                    else
+                    {
+                        char* End;
+                        unsigned long Count = strtoul(&argv[i][2], &End, 10);
+
+                        if (*End != 0 || Count == 0)
+                        {
+                            printf("ERROR: Bad parameter %s.\n", argv[i]);
+                            return false;
+                        }
+                        SetJobCount(Count);
+                    }
+                    break;
+
                 case 'l':
                 case 'L':
                     if (argv[i][2] == 0)
@@ -508,6 +532,39 @@ bool CCABManager::DisplayCabinet()
 }
 
 
+static bool CheckExtractStatus(ULONG Status)
+/*
+ * FUNCTION: Prints an error message for a failed extraction
+ * ARGUMENTS:
+ *     Status = Status of the extraction
+ * RETURNS:
+ *     true if the extraction succeeded, false if not
+ */
+{
+    switch (Status)
+    {
+        case CAB_STATUS_SUCCESS:
+            return true;
+
+        case CAB_STATUS_INVALID_CAB:
+            printf("ERROR: Cabinet contains errors.\n");
+            return false;
+
+        case CAB_STATUS_UNSUPPCOMP:
+            printf("ERROR: Cabinet uses unsupported compression type.\n");
+            return false;
+
+        case CAB_STATUS_CANNOT_WRITE:
+            printf("ERROR: You've run out of free space on the destination volume or the volume is damaged.\n");
+            return false;
+
+        default:
+            printf("ERROR: Unspecified error code (%u).\n", (UINT)Status);
+            return false;
+    }
+}
+
+
 bool CCABManager::ExtractFromCabinet()
 /*
  * FUNCTION: Extract file(s) from cabinet
@@ -524,36 +581,23 @@ bool CCABManager::ExtractFromCabinet()
             printf("Cabinet %s\n\n", GetCabinetName());
         }
 
+        /* Single cabinets are extracted one folder at a time */
+        if (!IsSpanned())
+        {
+            Status = ExtractFiles();
+            if (Status == CAB_STATUS_NOFILE)
+                Status = CAB_STATUS_SUCCESS;
+
+            bRet = CheckExtractStatus(Status);
+            DestroySearchCriteria();
+            return bRet;
+        }
+
         if (FindFirst(&Search) == CAB_STATUS_SUCCESS)
         {
             do
             {
-                switch (Status = ExtractFile(Search.FileName.c_str()))
-                {
-                    case CAB_STATUS_SUCCESS:
-                        break;
-
-                    case CAB_STATUS_INVALID_CAB:
-                        printf("ERROR: Cabinet contains errors.\n");
-                        bRet = false;
-                        break;
-
-                    case CAB_STATUS_UNSUPPCOMP:
-                        printf("ERROR: Cabinet uses unsupported compression type.\n");
-                        bRet = false;
-                        break;
-
-                    case CAB_STATUS_CANNOT_WRITE:
-                        printf("ERROR: You've run out of free space on the destination volume or the volume is damaged.\n");
-                        bRet = false;
-                        break;
-
-                    default:
-                        printf("ERROR: Unspecified error code (%u).\n", (UINT)Status);
-                        bRet = false;
-                        break;
-                }
-
+                bRet = CheckExtractStatus(ExtractFile(Search.FileName.c_str()));
                 if(!bRet)
                     break;
             } while (FindNext(&Search) == CAB_STATUS_SUCCESS);
@@ -0,0 +1,1372 @@
+/*
+ * PROJECT:     ReactOS cabinet manager
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     CAB codec for LZX compressed data
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ * NOTES:       Every CFDATA block is one 32 KB LZX frame. The window, the
+ *              repeated offsets and the previous tree lengths are kept
+ *              from one frame to the next and only reset at the start of
+ *              a folder, so the blocks of a folder must be compressed and
+ *              uncompressed in order.
+ *              The compressor writes one verbatim block per frame (or an
+ *              uncompressed block when that is smaller) and applies the
+ *              E8 call translation, which pays off for x86 binaries.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include "lzx.h"
+
+
+/* Number of extra position bits of each position slot */
+static const UCHAR ExtraBits[LZX_MAX_POSITION_SLOTS] =
+{
+     0,  0,  0,  0,  1,  1,  2,  2,  3,  3,  4,  4,  5,  5,  6,  6,
+     7,  7,  8,  8,  9,  9, 10, 10, 11, 11, 12, 12, 13, 13, 14, 14,
+    15, 15, 16, 16, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+    17, 17
+};
+
+/* First formatted offset of each position slot */
+static const ULONG PositionBase[LZX_MAX_POSITION_SLOTS] =
+{
+          0,       1,       2,       3,       4,       6,       8,      12,
+         16,      24,      32,      48,      64,      96,     128,     192,
+        256,     384,     512,     768,    1024,    1536,    2048,    3072,
+       4096,    6144,    8192,   12288,   16384,   24576,   32768,   49152,
+      65536,   98304,  131072,  196608,  262144,  393216,  524288,  655360,
+     786432,  917504, 1048576, 1179648, 1310720, 1441792, 1572864, 1703936,
+    1835008, 1966080
+};
+
+/* Number of position slots for window sizes of 2^15 to 2^21 */
+static const UCHAR PositionSlotCount[] = { 30, 32, 34, 36, 38, 42, 50 };
+
+
+static ULONG GetPositionSlot(ULONG FormattedOffset, ULONG SlotCount)
+/*
+ * FUNCTION: Returns the position slot of a formatted match offset
+ */
+{
+    ULONG Low = 0;
+    ULONG High = SlotCount - 1;
+
+    while (Low < High)
+    {
+        ULONG Middle = (Low + High + 1) / 2;
+
+        if (PositionBase[Middle] <= FormattedOffset)
+            Low = Middle;
+        else
+            High = Middle - 1;
+    }
+
+    return Low;
+}
+
+
+static void BuildLengths(const ULONG* Frequency, ULONG Count, ULONG MaxLength, UCHAR* Lengths)
+/*
+ * FUNCTION: Computes the code lengths of a Huffman code
+ * ARGUMENTS:
+ *     Frequency = Symbol frequencies
+ *     Count     = Number of symbols
+ *     MaxLength = Longest allowed code
+ *     Lengths   = Receives the code length of each symbol
+ * NOTES:
+ *     The code is always complete, a single used symbol gets a partner
+ */
+{
+    std::vector<ULONG> Weight(Frequency, Frequency + Count);
+    std::vector<ULONG> Leaves;
+    std::vector<ULONG> Node(2 * Count);
+    std::vector<ULONG> Parent(2 * Count);
+    std::vector<ULONG> Depth(2 * Count);
+    ULONG LeafCount, NodeCount, NextLeaf, NextNode, i;
+
+    memset(Lengths, 0, Count);
+
+    for (i = 0; i < Count; i++)
+    {
+        if (Weight[i] != 0)
+            Leaves.push_back(i);
+    }
+
+    LeafCount = (ULONG)Leaves.size();
+    if (LeafCount == 0)
+        return;
+
+    if (LeafCount == 1)
+    {
+        Lengths[Leaves[0]] = 1;
+        Lengths[(Leaves[0] == 0) ? 1 : 0] = 1;
+        return;
+    }
+
+    for (;;)
+    {
+        ULONG MaxDepth = 0;
+
+        std::stable_sort(Leaves.begin(), Leaves.end(),
+            [&Weight](ULONG a, ULONG b) { return Weight[a] < Weight[b]; });
+
+        /* Leaves are nodes 0 to LeafCount - 1, internal nodes follow in
+           the order they are created, which is also by increasing weight */
+        for (i = 0; i < LeafCount; i++)
+            Node[i] = Weight[Leaves[i]];
+
+        NodeCount = LeafCount;
+        NextLeaf = 0;
+        NextNode = LeafCount;
+
+        while (NodeCount < 2 * LeafCount - 1)
+        {
+            ULONG Pick[2];
+
+            for (i = 0; i < 2; i++)
+            {
+                if (NextLeaf < LeafCount &&
+                    (NextNode >= NodeCount || Node[NextLeaf] <= Node[NextNode]))
+                {
+                    Pick[i] = NextLeaf++;
+                }
+                else
+                {
+                    Pick[i] = NextNode++;
+                }
+            }
+
+            Node[NodeCount] = Node[Pick[0]] + Node[Pick[1]];
+            Parent[Pick[0]] = NodeCount;
+            Parent[Pick[1]] = NodeCount;
+            NodeCount++;
+        }
+
+        /* Parents always come after their children */
+        Depth[NodeCount - 1] = 0;
+        for (i = NodeCount - 1; i-- > 0;)
+        {
+            Depth[i] = Depth[Parent[i]] + 1;
+            if (Depth[i] > MaxDepth)
+                MaxDepth = Depth[i];
+        }
+
+        if (MaxDepth <= MaxLength)
+            break;
+
+        /* Flatten the distribution and try again */
+        for (i = 0; i < LeafCount; i++)
+            Weight[Leaves[i]] = (Weight[Leaves[i]] + 1) / 2;
+    }
+
+    for (i = 0; i < LeafCount; i++)
+        Lengths[Leaves[i]] = (UCHAR)Depth[i];
+}
+
+
+static void BuildCodes(const UCHAR* Lengths, ULONG Count, USHORT* Codes)
+/*
+ * FUNCTION: Assigns canonical codes for a set of code lengths
+ */
+{
+    ULONG LengthCount[LZX_MAX_CODE_LENGTH + 1] = { 0 };
+    ULONG NextCode[LZX_MAX_CODE_LENGTH + 1];
+    ULONG Code = 0;
+    ULONG i;
+
+    for (i = 0; i < Count; i++)
+        LengthCount[Lengths[i]]++;
+
+    LengthCount[0] = 0;
+    for (i = 1; i <= LZX_MAX_CODE_LENGTH; i++)
+    {
+        Code = (Code + LengthCount[i - 1]) << 1;
+        NextCode[i] = Code;
+    }
+
+    for (i = 0; i < Count; i++)
+    {
+        if (Lengths[i] != 0)
+            Codes[i] = (USHORT)NextCode[Lengths[i]]++;
+    }
+}
+
+
+/* CLZXCodec */
+
+CLZXCodec::CLZXCodec()
+/*
+ * FUNCTION: Default constructor
+ */
+{
+    WindowBits = 0;
+    WindowSize = 0;
+    PositionSlots = 0;
+    HistoryLength = 0;
+    HashInserted = 0;
+    Reset(CAB_COMP_LZX | (LZX_WINDOW_BITS << CAB_COMP_LZX_WINDOW_SHIFT));
+}
+
+
+CLZXCodec::~CLZXCodec()
+/*
+ * FUNCTION: Default destructor
+ */
+{
+}
+
+
+ULONG CLZXCodec::Reset(USHORT CompressionType)
+/*
+ * FUNCTION: Starts a new folder
+ * ARGUMENTS:
+ *     CompressionType = Compression type of the folder, holds the window size
+ * RETURNS:
+ *     Status of operation
+ */
+{
+    ULONG Bits = (CompressionType >> CAB_COMP_LZX_WINDOW_SHIFT) & CAB_COMP_LZX_WINDOW_MASK;
+
+    if ((CompressionType & CAB_COMP_MASK) != CAB_COMP_LZX ||
+        Bits < LZX_MIN_WINDOW_BITS || Bits > LZX_MAX_WINDOW_BITS)
+    {
+        DPRINT(MIN_TRACE, ("Bad LZX compression type (0x%X).\n", CompressionType));
+        return CS_BADSTREAM;
+    }
+
+    WindowBits = Bits;
+    WindowSize = 1 << Bits;
+    PositionSlots = PositionSlotCount[Bits - LZX_MIN_WINDOW_BITS];
+
+    R0 = R1 = R2 = 1;
+    FrameNumber = 0;
+    memset(MainLengths, 0, sizeof(MainLengths));
+    memset(LengthLengths, 0, sizeof(LengthLengths));
+
+    WindowPosition = 0;
+    HeaderRead = false;
+    IntelFileSize = 0;
+    IntelStarted = false;
+    BlockType = 0;
+    BlockLength = 0;
+    BlockRemaining = 0;
+
+    HistoryLength = 0;
+    HashInserted = 0;
+    if (!HashHead.empty())
+        std::fill(HashHead.begin(), HashHead.end(), -1);
+
+    return CS_SUCCESS;
+}
+
+
+/* Bit stream */
+
+void CLZXCodec::InitBits(PUCHAR Buffer, ULONG Length)
+/*
+ * FUNCTION: Starts reading or writing a bit stream
+ */
+{
+    BitPointer = Buffer;
+    BitEnd = Buffer + Length;
+    BitBuffer = 0;
+    BitCount = 0;
+    BitPadding = 0;
+    BitOverflow = false;
+}
+
+
+void CLZXCodec::FillBits(ULONG Count)
+/*
+ * FUNCTION: Makes sure at least Count (at most 16) bits are buffered
+ * NOTES:
+ *     The stream is a sequence of little endian 16-bit words, read from
+ *     the most significant bit down. Reading past the end gives zeros,
+ *     it is only an error once these are consumed
+ */
+{
+    while (BitCount < Count)
+    {
+        ULONG Word = 0;
+
+        if (BitPointer + 2 <= BitEnd)
+        {
+            Word = BitPointer[0] | (BitPointer[1] << 8);
+            BitPointer += 2;
+        }
+        else
+        {
+            BitPadding += 16;
+        }
+
+        BitBuffer |= Word << (16 - BitCount);
+        BitCount += 16;
+    }
+}
+
+
+ULONG CLZXCodec::ReadBits(ULONG Count)
+/*
+ * FUNCTION: Reads up to 32 bits from the bit stream
+ */
+{
+    ULONG Value;
+
+    if (Count == 0)
+        return 0;
+
+    if (Count > 16)
+    {
+        Value = ReadBits(Count - 16) << 16;
+        return Value | ReadBits(16);
+    }
+
+    FillBits(Count);
+    Value = BitBuffer >> (32 - Count);
+    BitBuffer <<= Count;
+    BitCount -= Count;
+
+    if (BitPadding > BitCount)
+        BitOverflow = true;
+
+    return Value;
+}
+
+
+void CLZXCodec::PutBits(ULONG Value, ULONG Count)
+/*
+ * FUNCTION: Writes up to 17 bits to the bit stream
+ */
+{
+    if (Count == 0)
+        return;
+
+    BitBuffer = (BitBuffer << Count) | (Value & ((1 << Count) - 1));
+    BitCount += Count;
+
+    while (BitCount >= 16)
+    {
+        ULONG Word;
+
+        BitCount -= 16;
+        Word = (BitBuffer >> BitCount) & 0xFFFF;
+
+        if (BitPointer + 2 <= BitEnd)
+        {
+            BitPointer[0] = (UCHAR)Word;
+            BitPointer[1] = (UCHAR)(Word >> 8);
+            BitPointer += 2;
+        }
+        else
+        {
+            BitOverflow = true;
+        }
+    }
+}
+
+
+void CLZXCodec::FlushBits()
+/*
+ * FUNCTION: Pads the bit stream to a 16-bit boundary
+ */
+{
+    if (BitCount != 0)
+        PutBits(0, 16 - BitCount);
+}
+
+
+/* Huffman codes */
+
+bool CLZXCodec::BuildTable(PLZX_HUFFMAN_TABLE Table, const UCHAR* Lengths, ULONG Count)
+/*
+ * FUNCTION: Builds the decoding table of a canonical Huffman code
+ * ARGUMENTS:
+ *     Table   = Table to build
+ *     Lengths = Code length of each symbol
+ *     Count   = Number of symbols
+ * RETURNS:
+ *     false if the code lengths are oversubscribed
+ */
+{
+    ULONG Offset[LZX_MAX_CODE_LENGTH + 2];
+    LONG Left = 1;
+    ULONG Code = 0;
+    ULONG Length, Index, i;
+
+    memset(Table->Count, 0, sizeof(Table->Count));
+    for (i = 0; i < Count; i++)
+    {
+        if (Lengths[i] > LZX_MAX_CODE_LENGTH)
+            return false;
+        Table->Count[Lengths[i]]++;
+    }
+    Table->Count[0] = 0;
+
+    for (Length = 1; Length <= LZX_MAX_CODE_LENGTH; Length++)
+    {
+        Left = (Left << 1) - Table->Count[Length];
+        if (Left < 0)
+            return false;
+    }
+
+    Offset[1] = 0;
+    for (Length = 1; Length <= LZX_MAX_CODE_LENGTH; Length++)
+        Offset[Length + 1] = Offset[Length] + Table->Count[Length];
+
+    for (i = 0; i < Count; i++)
+    {
+        if (Lengths[i] != 0)
+            Table->Symbols[Offset[Lengths[i]]++] = (USHORT)i;
+    }
+
+    /* Codes up to LZX_TABLE_BITS long are looked up directly */
+    memset(Table->Table, 0, sizeof(Table->Table));
+    Index = 0;
+    for (Length = 1; Length <= LZX_TABLE_BITS; Length++)
+    {
+        for (i = 0; i < Table->Count[Length]; i++, Index++, Code++)
+        {
+            ULONG First = Code << (LZX_TABLE_BITS - Length);
+            ULONG Last = First + (1 << (LZX_TABLE_BITS - Length));
+
+            while (First < Last)
+                Table->Table[First++] = (USHORT)((Length << 12) | Table->Symbols[Index]);
+        }
+        Code <<= 1;
+    }
+
+    return true;
+}
+
+
+ULONG CLZXCodec::ReadSymbol(PLZX_HUFFMAN_TABLE Table)
+/*
+ * FUNCTION: Reads a Huffman coded symbol from the bit stream
+ * RETURNS:
+ *     The symbol, 0xFFFF if the bits do not form a code
+ */
+{
+    ULONG Code = 0;
+    ULONG First = 0;
+    ULONG Index = 0;
+    ULONG Entry, Length;
+
+    FillBits(LZX_MAX_CODE_LENGTH);
+
+    Entry = Table->Table[BitBuffer >> (32 - LZX_TABLE_BITS)];
+    if (Entry != 0)
+    {
+        ReadBits(Entry >> 12);
+        return Entry & 0xFFF;
+    }
+
+    for (Length = 1; Length <= LZX_MAX_CODE_LENGTH; Length++)
+    {
+        Code |= (BitBuffer >> (32 - Length)) & 1;
+        if (Code - First < Table->Count[Length])
+        {
+            ReadBits(Length);
+            return Table->Symbols[Index + Code - First];
+        }
+
+        Index += Table->Count[Length];
+        First = (First + Table->Count[Length]) << 1;
+        Code <<= 1;
+    }
+
+    return 0xFFFF;
+}
+
+
+bool CLZXCodec::ReadLengths(UCHAR* Lengths, ULONG First, ULONG Last)
+/*
+ * FUNCTION: Reads a range of code lengths encoded with the pretree
+ * NOTES:
+ *     Lengths are coded as differences to the lengths of the previous block
+ */
+{
+    ULONG Symbol, Run, i;
+
+    for (i = 0; i < LZX_PRETREE_NUM_ELEMENTS; i++)
+        PreLengths[i] = (UCHAR)ReadBits(4);
+
+    if (!BuildTable(&PreTable, PreLengths, LZX_PRETREE_NUM_ELEMENTS))
+        return false;
+
+    i = First;
+    while (i < Last)
+    {
+        Symbol = ReadSymbol(&PreTable);
+
+        if (Symbol == 17 || Symbol == 18)
+        {
+            /* Run of zeros */
+            Run = (Symbol == 17) ? ReadBits(4) + 4 : ReadBits(5) + 20;
+            while (Run-- > 0 && i < Last)
+                Lengths[i++] = 0;
+        }
+        else if (Symbol == 19)
+        {
+            /* Run of the same length */
+            Run = ReadBits(1) + 4;
+            Symbol = ReadSymbol(&PreTable);
+            if (Symbol > 16)
+                return false;
+
+            Symbol = (Lengths[i] + 17 - Symbol) % 17;
+            while (Run-- > 0 && i < Last)
+                Lengths[i++] = (UCHAR)Symbol;
+        }
+        else if (Symbol <= 16)
+        {
+            Lengths[i] = (UCHAR)((Lengths[i] + 17 - Symbol) % 17);
+            i++;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return !BitOverflow;
+}
+
+
+void CLZXCodec::WriteLengths(const UCHAR* Lengths, const UCHAR* Previous, ULONG First, ULONG Last)
+/*
+ * FUNCTION: Writes a range of code lengths encoded with the pretree
+ */
+{
+    std::vector<USHORT> Symbols;
+    std::vector<UCHAR> Extra;
+    ULONG Frequency[LZX_PRETREE_NUM_ELEMENTS] = { 0 };
+    USHORT Codes[LZX_PRETREE_NUM_ELEMENTS];
+    ULONG i, Run;
+
+    i = First;
+    while (i < Last)
+    {
+        for (Run = 0; i + Run < Last && Lengths[i + Run] == 0; Run++)
+            ;
+
+        if (Run >= 20)
+        {
+            Run = std::min(Run, (ULONG)51);
+            Symbols.push_back(18);
+            Extra.push_back((UCHAR)(Run - 20));
+            i += Run;
+        }
+        else if (Run >= 4)
+        {
+            Symbols.push_back(17);
+            Extra.push_back((UCHAR)(Run - 4));
+            i += Run;
+        }
+        else
+        {
+            Symbols.push_back((USHORT)((Previous[i] + 17 - Lengths[i]) % 17));
+            Extra.push_back(0);
+            i++;
+        }
+    }
+
+    for (USHORT Symbol : Symbols)
+        Frequency[Symbol]++;
+
+    /* Pretree lengths are stored in 4 bits */
+    BuildLengths(Frequency, LZX_PRETREE_NUM_ELEMENTS, 15, PreLengths);
+    BuildCodes(PreLengths, LZX_PRETREE_NUM_ELEMENTS, Codes);
+
+    for (i = 0; i < LZX_PRETREE_NUM_ELEMENTS; i++)
+        PutBits(PreLengths[i], 4);
+
+    for (i = 0; i < Symbols.size(); i++)
+    {
+        PutBits(Codes[Symbols[i]], PreLengths[Symbols[i]]);
+        if (Symbols[i] == 17)
+            PutBits(Extra[i], 4);
+        else if (Symbols[i] == 18)
+            PutBits(Extra[i], 5);
+    }
+}
+
+
+/* Decoder */
+
+ULONG CLZXCodec::DecodeBlockHeader()
+/*
+ * FUNCTION: Reads the header of the next LZX block
+ * RETURNS:
+ *     Status of operation
+ */
+{
+    ULONG i;
+
+    /* Uncompressed blocks of odd length are padded to 16 bits */
+    if (BlockType == LZX_BLOCKTYPE_UNCOMPRESSED)
+    {
+        if (BlockLength & 1)
+            BitPointer++;
+        BitBuffer = 0;
+        BitCount = 0;
+    }
+
+    BlockType = ReadBits(3);
+    BlockLength = ReadBits(16) << 8;
+    BlockLength |= ReadBits(8);
+    BlockRemaining = BlockLength;
+
+    DPRINT(MAX_TRACE, ("Block type (%u)  length (%u).\n", (UINT)BlockType, (UINT)BlockLength));
+
+    switch (BlockType)
+    {
+        case LZX_BLOCKTYPE_ALIGNED:
+            for (i = 0; i < LZX_ALIGNED_NUM_ELEMENTS; i++)
+                AlignedLengths[i] = (UCHAR)ReadBits(3);
+
+            if (!BuildTable(&AlignedTable, AlignedLengths, LZX_ALIGNED_NUM_ELEMENTS))
+                return CS_BADSTREAM;
+
+            /* Fall through */
+
+        case LZX_BLOCKTYPE_VERBATIM:
+            if (!ReadLengths(MainLengths, 0, LZX_NUM_CHARS) ||
+                !ReadLengths(MainLengths, LZX_NUM_CHARS, LZX_NUM_CHARS + PositionSlots * 8) ||
+                !BuildTable(&MainTable, MainLengths, LZX_NUM_CHARS + PositionSlots * 8))
+            {
+                return CS_BADSTREAM;
+            }
+
+            if (MainLengths[0xE8] != 0)
+                IntelStarted = true;
+
+            if (!ReadLengths(LengthLengths, 0, LZX_NUM_SECONDARY_LENGTHS) ||
+                !BuildTable(&LengthTable, LengthLengths, LZX_NUM_SECONDARY_LENGTHS))
+            {
+                return CS_BADSTREAM;
+            }
+            break;
+
+        case LZX_BLOCKTYPE_UNCOMPRESSED:
+            IntelStarted = true;
+
+            if (BitOverflow)
+                return CS_BADSTREAM;
+
+            /* Skip 1 to 16 bits of padding, then give back words read ahead */
+            if ((BitCount & 15) == 0)
+            {
+                if (BitCount == 0)
+                    BitPointer += 2;
+                else
+                    BitCount -= 16;
+            }
+            else
+            {
+                BitCount -= BitCount & 15;
+            }
+            if (BitCount < BitPadding)
+                return CS_BADSTREAM;
+            BitPointer -= 2 * ((BitCount - BitPadding) / 16);
+            BitBuffer = 0;
+            BitCount = 0;
+            BitPadding = 0;
+
+            if (BitPointer + 12 > BitEnd)
+                return CS_BADSTREAM;
+
+            R0 = BitPointer[0] | (BitPointer[1] << 8) | (BitPointer[2] << 16) | ((ULONG)BitPointer[3] << 24);
+            R1 = BitPointer[4] | (BitPointer[5] << 8) | (BitPointer[6] << 16) | ((ULONG)BitPointer[7] << 24);
+            R2 = BitPointer[8] | (BitPointer[9] << 8) | (BitPointer[10] << 16) | ((ULONG)BitPointer[11] << 24);
+            BitPointer += 12;
+            break;
+
+        default:
+            DPRINT(MIN_TRACE, ("Bad LZX block type (%u).\n", (UINT)BlockType));
+            return CS_BADSTREAM;
+    }
+
+    return CS_SUCCESS;
+}
+
+
+ULONG CLZXCodec::DecodeRun(ULONG Length)
+/*
+ * FUNCTION: Decodes data of the current block into the window
+ * ARGUMENTS:
+ *     Length = Number of bytes to decode
+ * RETURNS:
+ *     Status of operation
+ */
+{
+    ULONG End = WindowPosition + Length;
+    ULONG Mask = WindowSize - 1;
+    ULONG MainSymbol, MatchLength, MatchOffset, Slot, Extra, Symbol;
+    PUCHAR Data = Window.data();
+
+    if (BlockType == LZX_BLOCKTYPE_UNCOMPRESSED)
+    {
+        if (BitPointer + Length > BitEnd)
+            return CS_BADSTREAM;
+
+        memcpy(&Data[WindowPosition], BitPointer, Length);
+        BitPointer += Length;
+        WindowPosition = End;
+        return CS_SUCCESS;
+    }
+
+    while (WindowPosition < End)
+    {
+        MainSymbol = ReadSymbol(&MainTable);
+        if (MainSymbol == 0xFFFF)
+            return CS_BADSTREAM;
+
+        if (MainSymbol < LZX_NUM_CHARS)
+        {
+            Data[WindowPosition++] = (UCHAR)MainSymbol;
+            continue;
+        }
+
+        MainSymbol -= LZX_NUM_CHARS;
+
+        MatchLength = MainSymbol & LZX_NUM_PRIMARY_LENGTHS;
+        if (MatchLength == LZX_NUM_PRIMARY_LENGTHS)
+        {
+            Symbol = ReadSymbol(&LengthTable);
+            if (Symbol == 0xFFFF)
+                return CS_BADSTREAM;
+            MatchLength += Symbol;
+        }
+        MatchLength += LZX_MIN_MATCH;
+
+        Slot = MainSymbol >> 3;
+        if (Slot > 2)
+        {
+            /* Not a repeated offset */
+            Extra = ExtraBits[Slot];
+            MatchOffset = PositionBase[Slot] - 2;
+
+            if (BlockType == LZX_BLOCKTYPE_ALIGNED && Extra >= 3)
+            {
+                MatchOffset += ReadBits(Extra - 3) << 3;
+                Symbol = ReadSymbol(&AlignedTable);
+                if (Symbol == 0xFFFF)
+                    return CS_BADSTREAM;
+                MatchOffset += Symbol;
+            }
+            else
+            {
+                MatchOffset += ReadBits(Extra);
+            }
+
+            R2 = R1;
+            R1 = R0;
+            R0 = MatchOffset;
+        }
+        else if (Slot == 0)
+        {
+            MatchOffset = R0;
+        }
+        else if (Slot == 1)
+        {
+            MatchOffset = R1;
+            R1 = R0;
+            R0 = MatchOffset;
+        }
+        else
+        {
+            MatchOffset = R2;
+            R2 = R0;
+            R0 = MatchOffset;
+        }
+
+        if (WindowPosition + MatchLength > End || MatchOffset >= WindowSize)
+        {
+            DPRINT(MIN_TRACE, ("Match runs past the frame.\n"));
+            return CS_BADSTREAM;
+        }
+
+        while (MatchLength-- > 0)
+        {
+            Data[WindowPosition] = Data[(WindowPosition - MatchOffset) & Mask];
+            WindowPosition++;
+        }
+    }
+
+    return BitOverflow ? CS_BADSTREAM : CS_SUCCESS;
+}
+
+
+void CLZXCodec::TranslateE8(PUCHAR Data, ULONG Length, bool Encode)
+/*
+ * FUNCTION: Converts the targets of x86 CALL instructions between relative
+ *           and absolute form, absolute targets compress better
+ * ARGUMENTS:
+ *     Data   = Frame data
+ *     Length = Length of frame (more than 10 bytes)
+ *     Encode = true to make targets absolute, false to make them relative
+ */
+{
+    LONG FileSize = Encode ? LZX_E8_FILESIZE : (LONG)IntelFileSize;
+    LONG Position = (LONG)(FrameNumber * LZX_FRAME_SIZE);
+    PUCHAR End = Data + Length - 10;
+    LONG Value;
+
+    while (Data < End)
+    {
+        if (*Data++ != 0xE8)
+        {
+            Position++;
+            continue;
+        }
+
+        Value = (LONG)(Data[0] | (Data[1] << 8) | (Data[2] << 16) | ((ULONG)Data[3] << 24));
+        if (Value >= -Position && Value < FileSize)
+        {
+            if (Encode)
+                Value = (Value < FileSize - Position) ? Value + Position : Value - FileSize;
+            else
+                Value = (Value >= 0) ? Value - Position : Value + FileSize;
+
+            Data[0] = (UCHAR)Value;
+            Data[1] = (UCHAR)(Value >> 8);
+            Data[2] = (UCHAR)(Value >> 16);
+            Data[3] = (UCHAR)(Value >> 24);
+        }
+
+        Data += 4;
+        Position += 5;
+    }
+}
+
+
+ULONG CLZXCodec::Uncompress(void* OutputBuffer,
+                            void* InputBuffer,
+                            ULONG InputLength,
+                            PULONG OutputLength)
+/*
+ * FUNCTION: Uncompresses data in a buffer
+ * ARGUMENTS:
+ *     OutputBuffer = Pointer to buffer to place uncompressed data
+ *     InputBuffer  = Pointer to buffer with data to be uncompressed
+ *     InputLength  = Length of input buffer
+ *     OutputLength = Expected size of the uncompressed data on entry,
+ *                    receives the size of the uncompressed data
+ * RETURNS:
+ *     Status of operation
+ */
+{
+    ULONG FrameSize = *OutputLength;
+    ULONG FrameStart, Remaining, Run;
+    ULONG Status;
+
+    DPRINT(MAX_TRACE, ("InputLength (%u).\n", (UINT)InputLength));
+
+    if (FrameSize == 0 || FrameSize > LZX_FRAME_SIZE)
+        FrameSize = LZX_FRAME_SIZE;
+
+    if (Window.size() != WindowSize)
+    {
+        Window.assign(WindowSize, 0);
+        WindowPosition = 0;
+    }
+
+    FrameStart = WindowPosition;
+    if (FrameStart + FrameSize > WindowSize)
+        return CS_BADSTREAM;
+
+    InitBits((PUCHAR)InputBuffer, InputLength);
+
+    if (!HeaderRead)
+    {
+        if (ReadBits(1))
+            IntelFileSize = ReadBits(32);
+        HeaderRead = true;
+    }
+
+    Remaining = FrameSize;
+    while (Remaining > 0)
+    {
+        if (BlockRemaining == 0)
+        {
+            Status = DecodeBlockHeader();
+            if (Status != CS_SUCCESS)
+                return Status;
+            continue;
+        }
+
+        Run = std::min(BlockRemaining, Remaining);
+
+        Status = DecodeRun(Run);
+        if (Status != CS_SUCCESS)
+            return Status;
+
+        BlockRemaining -= Run;
+        Remaining -= Run;
+    }
+
+    memcpy(OutputBuffer, &Window[FrameStart], FrameSize);
+
+    if (WindowPosition == WindowSize)
+        WindowPosition = 0;
+
+    if (IntelStarted && IntelFileSize != 0 &&
+        FrameNumber < LZX_FRAME_SIZE && FrameSize > 10)
+    {
+        TranslateE8((PUCHAR)OutputBuffer, FrameSize, false);
+    }
+
+    FrameNumber++;
+    *OutputLength = FrameSize;
+    return CS_SUCCESS;
+}
+
+
+/* Encoder */
+
+void CLZXCodec::InsertHistory(PUCHAR Data, ULONG Length)
+/*
+ * FUNCTION: Appends a frame to the match history
+ */
+{
+    ULONG Capacity = 2 * WindowSize;
+    ULONG Shift, i;
+
+    if (History.size() != Capacity)
+    {
+        History.resize(Capacity);
+        HashPrev.resize(Capacity);
+        HashHead.assign(1 << LZX_HASH_BITS, -1);
+        HistoryLength = 0;
+        HashInserted = 0;
+    }
+
+    if (HistoryLength + Length > Capacity)
+    {
+        /* Keep one window of history */
+        Shift = HistoryLength - WindowSize;
+
+        memmove(&History[0], &History[Shift], WindowSize);
+
+        for (i = 0; i < HashHead.size(); i++)
+            HashHead[i] = (HashHead[i] >= (LONG)Shift) ? HashHead[i] - Shift : -1;
+
+        for (i = 0; i < HashInserted - Shift; i++)
+        {
+            LONG Previous = HashPrev[i + Shift];
+            HashPrev[i] = (Previous >= (LONG)Shift) ? Previous - Shift : -1;
+        }
+
+        HistoryLength -= Shift;
+        HashInserted -= Shift;
+    }
+
+    memcpy(&History[HistoryLength], Data, Length);
+    HistoryLength += Length;
+}
+
+
+void CLZXCodec::InsertHash(ULONG Position)
+/*
+ * FUNCTION: Adds all positions up to Position to the hash chains
+ */
+{
+    while (HashInserted < Position && HashInserted + 3 <= HistoryLength)
+    {
+        PUCHAR Data = &History[HashInserted];
+        ULONG Hash = ((Data[0] << 8) ^ (Data[1] << 4) ^ Data[2]) & ((1 << LZX_HASH_BITS) - 1);
+
+        HashPrev[HashInserted] = HashHead[Hash];
+        HashHead[Hash] = (LONG)HashInserted;
+        HashInserted++;
+    }
+}
+
+
+ULONG CLZXCodec::FindMatch(ULONG Position, ULONG MaxLength, PULONG Offset)
+/*
+ * FUNCTION: Searches the hash chain for the longest match at a position
+ * ARGUMENTS:
+ *     Position  = Position in the history
+ *     MaxLength = Longest match allowed
+ *     Offset    = Receives the offset of the match
+ * RETURNS:
+ *     Length of the match, 0 if there is no useful match
+ */
+{
+    PUCHAR Data = History.data();
+    ULONG BestLength = 0;
+    ULONG Chain = LZX_MAX_CHAIN;
+    ULONG Hash, Length;
+    LONG Candidate;
+
+    InsertHash(Position);
+
+    if (MaxLength < 3 || Position + 3 > HistoryLength)
+        return 0;
+
+    Hash = ((Data[Position] << 8) ^ (Data[Position + 1] << 4) ^ Data[Position + 2]) &
+        ((1 << LZX_HASH_BITS) - 1);
+
+    for (Candidate = HashHead[Hash]; Candidate >= 0 && Chain-- > 0; Candidate = HashPrev[Candidate])
+    {
+        ULONG Distance = Position - (ULONG)Candidate;
+
+        if (Distance > WindowSize - 3)
+            break;
+
+        if (Data[Candidate + BestLength] != Data[Position + BestLength])
+            continue;
+
+        for (Length = 0; Length < MaxLength && Data[Candidate + Length] == Data[Position + Length]; Length++)
+            ;
+
+        /* A short match far away costs more than the literals */
+        if (Length == 3 && Distance > 16384)
+            continue;
+
+        if (Length > BestLength)
+        {
+            BestLength = Length;
+            *Offset = Distance;
+            if (Length >= LZX_NICE_MATCH || Length == MaxLength)
+                break;
+        }
+    }
+
+    InsertHash(Position + 1);
+
+    return (BestLength >= 3) ? BestLength : 0;
+}
+
+
+ULONG CLZXCodec::RepeatMatch(ULONG Position, ULONG Offset, ULONG MaxLength)
+/*
+ * FUNCTION: Returns the length of the match at a repeated offset
+ */
+{
+    PUCHAR Data = History.data();
+    ULONG Length;
+
+    if (Offset > Position)
+        return 0;
+
+    for (Length = 0; Length < MaxLength && Data[Position - Offset + Length] == Data[Position + Length]; Length++)
+        ;
+
+    return Length;
+}
+
+
+ULONG CLZXCodec::BestMatch(ULONG Position, ULONG MaxLength, PLZX_MATCH Match)
+/*
+ * FUNCTION: Chooses between the repeated offsets and the longest match
+ * RETURNS:
+ *     Length of the match, 0 if a literal should be written
+ */
+{
+    ULONG Repeated[3] = { R0, R1, R2 };
+    ULONG Length, Offset, i;
+
+    Match->Length = 0;
+
+    for (i = 0; i < 3; i++)
+    {
+        Length = RepeatMatch(Position, Repeated[i], MaxLength);
+        if (Length >= LZX_MIN_MATCH && Length > Match->Length)
+        {
+            Match->Length = Length;
+            Match->Slot = i;
+        }
+    }
+
+    Length = FindMatch(Position, MaxLength, &Offset);
+
+    /* Repeated offsets are a lot cheaper to encode */
+    if (Length > Match->Length + 1)
+    {
+        Match->Length = Length;
+        Match->Slot = 3;
+        Match->Offset = Offset;
+    }
+
+    return Match->Length;
+}
+
+
+void CLZXCodec::AddMatch(PLZX_MATCH Match)
+/*
+ * FUNCTION: Adds a match to the tokens of the current frame
+ */
+{
+    LZX_TOKEN Token;
+    ULONG Slot, Footer = 0;
+    ULONG Length = Match->Length - LZX_MIN_MATCH;
+
+    switch (Match->Slot)
+    {
+        case 0:
+            Slot = 0;
+            break;
+
+        case 1:
+            Slot = 1;
+            std::swap(R0, R1);
+            break;
+
+        case 2:
+            Slot = 2;
+            std::swap(R0, R2);
+            break;
+
+        default:
+            Slot = GetPositionSlot(Match->Offset + 2, PositionSlots);
+            Footer = Match->Offset + 2 - PositionBase[Slot];
+            R2 = R1;
+            R1 = R0;
+            R0 = Match->Offset;
+            break;
+    }
+
+    if (Length < LZX_NUM_PRIMARY_LENGTHS)
+    {
+        Token.MainSymbol = (USHORT)(LZX_NUM_CHARS + (Slot << 3) + Length);
+        Token.LengthSymbol = 0xFFFF;
+    }
+    else
+    {
+        Token.MainSymbol = (USHORT)(LZX_NUM_CHARS + (Slot << 3) + LZX_NUM_PRIMARY_LENGTHS);
+        Token.LengthSymbol = (USHORT)(Length - LZX_NUM_PRIMARY_LENGTHS);
+        LengthFrequency[Token.LengthSymbol]++;
+    }
+    Token.Footer = Footer;
+
+    MainFrequency[Token.MainSymbol]++;
+    Tokens.push_back(Token);
+}
+
+
+void CLZXCodec::EncodeFrame(ULONG Start, ULONG Length)
+/*
+ * FUNCTION: Turns a frame in the history into literals and matches
+ * NOTES:
+ *     Uses one step of lazy evaluation: a match is dropped in favour of
+ *     a literal if the next position has a longer one
+ */
+{
+    ULONG End = Start + Length;
+    ULONG Position = Start;
+    LZX_MATCH Current, Next;
+    bool HaveNext = false;
+
+    Tokens.clear();
+    memset(MainFrequency, 0, sizeof(MainFrequency));
+    memset(LengthFrequency, 0, sizeof(LengthFrequency));
+
+    while (Position < End)
+    {
+        ULONG MaxLength = std::min(End - Position, (ULONG)LZX_MAX_MATCH);
+
+        if (HaveNext)
+        {
+            Current = Next;
+            HaveNext = false;
+        }
+        else
+        {
+            BestMatch(Position, MaxLength, &Current);
+        }
+
+        if (Current.Length != 0 && Current.Length < LZX_NICE_MATCH && Position + 1 < End)
+        {
+            BestMatch(Position + 1, std::min(End - Position - 1, (ULONG)LZX_MAX_MATCH), &Next);
+            HaveNext = (Next.Length > Current.Length);
+        }
+
+        if (Current.Length == 0 || HaveNext)
+        {
+            Tokens.push_back({ History[Position], 0xFFFF, 0 });
+            MainFrequency[History[Position]]++;
+            Position++;
+            continue;
+        }
+
+        AddMatch(&Current);
+        Position += Current.Length;
+        InsertHash(Position);
+    }
+}
+
+
+bool CLZXCodec::WriteVerbatimBlock(ULONG Length)
+/*
+ * FUNCTION: Writes the tokens of the current frame as a verbatim block
+ * RETURNS:
+ *     false if the block does not fit in the output buffer
+ */
+{
+    ULONG MainCount = LZX_NUM_CHARS + PositionSlots * 8;
+    USHORT MainCodes[LZX_MAINTREE_MAXSYMBOLS];
+    USHORT LengthCodes[LZX_NUM_SECONDARY_LENGTHS];
+
+    /* A code for 0xE8 tells the decoder to undo the E8 translation */
+    if (MainFrequency[0xE8] == 0)
+        MainFrequency[0xE8] = 1;
+
+    BuildLengths(MainFrequency, MainCount, LZX_MAX_CODE_LENGTH, NewMainLengths);
+    BuildLengths(LengthFrequency, LZX_NUM_SECONDARY_LENGTHS, LZX_MAX_CODE_LENGTH, NewLengthLengths);
+    BuildCodes(NewMainLengths, MainCount, MainCodes);
+    BuildCodes(NewLengthLengths, LZX_NUM_SECONDARY_LENGTHS, LengthCodes);
+
+    PutBits(LZX_BLOCKTYPE_VERBATIM, 3);
+    PutBits(Length >> 8, 16);
+    PutBits(Length & 0xFF, 8);
+
+    WriteLengths(NewMainLengths, MainLengths, 0, LZX_NUM_CHARS);
+    WriteLengths(NewMainLengths, MainLengths, LZX_NUM_CHARS, MainCount);
+    WriteLengths(NewLengthLengths, LengthLengths, 0, LZX_NUM_SECONDARY_LENGTHS);
+
+    for (const LZX_TOKEN& Token : Tokens)
+    {
+        PutBits(MainCodes[Token.MainSymbol], NewMainLengths[Token.MainSymbol]);
+
+        if (Token.MainSymbol < LZX_NUM_CHARS)
+            continue;
+
+        if (Token.LengthSymbol != 0xFFFF)
+            PutBits(LengthCodes[Token.LengthSymbol], NewLengthLengths[Token.LengthSymbol]);
+
+        PutBits(Token.Footer, ExtraBits[(Token.MainSymbol - LZX_NUM_CHARS) >> 3]);
+
+        if (BitOverflow)
+            return false;
+    }
+
+    return !BitOverflow;
+}
+
+
+void CLZXCodec::WriteUncompressedBlock(PUCHAR Data, ULONG Length)
+/*
+ * FUNCTION: Writes a frame as an uncompressed block
+ */
+{
+    ULONG Repeated[3] = { R0, R1, R2 };
+    ULONG i;
+
+    PutBits(LZX_BLOCKTYPE_UNCOMPRESSED, 3);
+    PutBits(Length >> 8, 16);
+    PutBits(Length & 0xFF, 8);
+
+    /* 1 to 16 bits of padding */
+    PutBits(0, 16 - (BitCount & 15));
+
+    for (i = 0; i < 3; i++)
+    {
+        BitPointer[0] = (UCHAR)Repeated[i];
+        BitPointer[1] = (UCHAR)(Repeated[i] >> 8);
+        BitPointer[2] = (UCHAR)(Repeated[i] >> 16);
+        BitPointer[3] = (UCHAR)(Repeated[i] >> 24);
+        BitPointer += 4;
+    }
+
+    memcpy(BitPointer, Data, Length);
+    BitPointer += Length;
+
+    if (Length & 1)
+        *BitPointer++ = 0;
+}
+
+
+ULONG CLZXCodec::Compress(void* OutputBuffer,
+                          void* InputBuffer,
+                          ULONG InputLength,
+                          PULONG OutputLength)
+/*
+ * FUNCTION: Compresses data in a buffer
+ * ARGUMENTS:
+ *     OutputBuffer   = Pointer to buffer to place compressed data
+ *     InputBuffer    = Pointer to buffer with data to be compressed
+ *     InputLength    = Length of input buffer
+ *     OutputLength   = Address of buffer to place size of compressed data
+ * RETURNS:
+ *     Status of operation
+ */
+{
+    ULONG Start, Saved[3];
+    ULONG UncompressedSize;
+    PUCHAR Frame;
+    bool Compressed;
+
+    DPRINT(MAX_TRACE, ("InputLength (%u).\n", (UINT)InputLength));
+
+    if (InputLength == 0 || InputLength > LZX_FRAME_SIZE)
+    {
+        *OutputLength = 0;
+        return (InputLength == 0) ? CS_SUCCESS : CS_BADSTREAM;
+    }
+
+    InsertHistory((PUCHAR)InputBuffer, InputLength);
+    Start = HistoryLength - InputLength;
+    Frame = &History[Start];
+
+    if (FrameNumber < LZX_FRAME_SIZE && InputLength > 10)
+        TranslateE8(Frame, InputLength, true);
+
+    Saved[0] = R0;
+    Saved[1] = R1;
+    Saved[2] = R2;
+
+    EncodeFrame(Start, InputLength);
+
+    InitBits((PUCHAR)OutputBuffer, CAB_MAX_COMPSIZE);
+
+    /* The stream starts with the E8 translation size */
+    if (FrameNumber == 0)
+    {
+        PutBits(1, 1);
+        PutBits(LZX_E8_FILESIZE >> 16, 16);
+        PutBits(LZX_E8_FILESIZE & 0xFFFF, 16);
+    }
+
+    Compressed = WriteVerbatimBlock(InputLength);
+    FlushBits();
+
+    /* Stream and block headers, repeated offsets and the padded data */
+    UncompressedSize = ((FrameNumber == 0) ? 8 : 4) + 12 + InputLength + (InputLength & 1);
+
+    if (!Compressed || BitOverflow ||
+        (ULONG)(BitPointer - (PUCHAR)OutputBuffer) >= UncompressedSize)
+    {
+        R0 = Saved[0];
+        R1 = Saved[1];
+        R2 = Saved[2];
+
+        InitBits((PUCHAR)OutputBuffer, CAB_MAX_COMPSIZE);
+
+        if (FrameNumber == 0)
+        {
+            PutBits(1, 1);
+            PutBits(LZX_E8_FILESIZE >> 16, 16);
+            PutBits(LZX_E8_FILESIZE & 0xFFFF, 16);
+        }
+
+        WriteUncompressedBlock(Frame, InputLength);
+    }
+    else
+    {
+        /* The next block codes its lengths against these */
+        memcpy(MainLengths, NewMainLengths, sizeof(MainLengths));
+        memcpy(LengthLengths, NewLengthLengths, sizeof(LengthLengths));
+    }
+
+    FrameNumber++;
+    *OutputLength = (ULONG)(BitPointer - (PUCHAR)OutputBuffer);
+
+    DPRINT(MAX_TRACE, ("OutputLength (%u).\n", (UINT)*OutputLength));
+
+    return CS_SUCCESS;
+}
+
+/* EOF */
@@ -0,0 +1,160 @@
+/*
+ * PROJECT:     ReactOS cabinet manager
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     CAB codec for LZX compressed data
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#pragma once
+
+#include "cabinet.h"
+#include <vector>
+
+#define LZX_WINDOW_BITS             21      /* Window size used for compression */
+#define LZX_MIN_WINDOW_BITS         15
+#define LZX_MAX_WINDOW_BITS         21
+
+#define LZX_FRAME_SIZE              32768
+#define LZX_MIN_MATCH               2
+#define LZX_MAX_MATCH               257
+#define LZX_NUM_CHARS               256
+#define LZX_NUM_PRIMARY_LENGTHS     7
+#define LZX_NUM_SECONDARY_LENGTHS   249
+#define LZX_MAX_POSITION_SLOTS      50
+#define LZX_PRETREE_NUM_ELEMENTS    20
+#define LZX_ALIGNED_NUM_ELEMENTS    8
+#define LZX_MAINTREE_MAXSYMBOLS     (LZX_NUM_CHARS + LZX_MAX_POSITION_SLOTS * 8)
+#define LZX_MAX_CODE_LENGTH         16
+
+#define LZX_BLOCKTYPE_VERBATIM      1
+#define LZX_BLOCKTYPE_ALIGNED       2
+#define LZX_BLOCKTYPE_UNCOMPRESSED  3
+
+#define LZX_E8_FILESIZE             12000000  /* Translation size used by makecab */
+
+#define LZX_TABLE_BITS              10
+#define LZX_HASH_BITS               16
+#define LZX_MAX_CHAIN               32
+#define LZX_NICE_MATCH              64
+
+
+typedef struct _LZX_HUFFMAN_TABLE
+{
+    ULONG   Count[LZX_MAX_CODE_LENGTH + 1];     // Number of codes per length
+    USHORT  Symbols[LZX_MAINTREE_MAXSYMBOLS];   // Symbols ordered by code
+    USHORT  Table[1 << LZX_TABLE_BITS];         // Symbol and length of short codes
+} LZX_HUFFMAN_TABLE, *PLZX_HUFFMAN_TABLE;
+
+typedef struct _LZX_MATCH
+{
+    ULONG   Length;
+    ULONG   Slot;           // 0 to 2 for the repeated offsets, 3 otherwise
+    ULONG   Offset;
+} LZX_MATCH, *PLZX_MATCH;
+
+typedef struct _LZX_TOKEN
+{
+    USHORT  MainSymbol;
+    USHORT  LengthSymbol;   // 0xFFFF if the match length fits in the main symbol
+    ULONG   Footer;         // Verbatim position bits
+} LZX_TOKEN, *PLZX_TOKEN;
+
+
+/* Classes */
+
+class CLZXCodec : public CCABCodec
+{
+public:
+    /* Default constructor */
+    CLZXCodec();
+    /* Default destructor */
+    virtual ~CLZXCodec();
+    /* Compresses a data block */
+    virtual ULONG Compress(void* OutputBuffer,
+                           void* InputBuffer,
+                           ULONG InputLength,
+                           PULONG OutputLength) override;
+    /* Uncompresses a data block */
+    virtual ULONG Uncompress(void* OutputBuffer,
+                             void* InputBuffer,
+                             ULONG InputLength,
+                             PULONG OutputLength) override;
+    /* Starts a new folder */
+    virtual ULONG Reset(USHORT CompressionType) override;
+private:
+    /* Bit stream */
+    void InitBits(PUCHAR Buffer, ULONG Length);
+    void FillBits(ULONG Count);
+    ULONG ReadBits(ULONG Count);
+    void PutBits(ULONG Value, ULONG Count);
+    void FlushBits();
+
+    /* Huffman codes */
+    bool BuildTable(PLZX_HUFFMAN_TABLE Table, const UCHAR* Lengths, ULONG Count);
+    ULONG ReadSymbol(PLZX_HUFFMAN_TABLE Table);
+    bool ReadLengths(UCHAR* Lengths, ULONG First, ULONG Last);
+    void WriteLengths(const UCHAR* Lengths, const UCHAR* Previous, ULONG First, ULONG Last);
+
+    /* Decoder */
+    ULONG DecodeBlockHeader();
+    ULONG DecodeRun(ULONG Length);
+    void TranslateE8(PUCHAR Data, ULONG Length, bool Encode);
+
+    /* Encoder */
+    void InsertHistory(PUCHAR Data, ULONG Length);
+    void InsertHash(ULONG Position);
+    ULONG FindMatch(ULONG Position, ULONG MaxLength, PULONG Offset);
+    ULONG RepeatMatch(ULONG Position, ULONG Offset, ULONG MaxLength);
+    ULONG BestMatch(ULONG Position, ULONG MaxLength, PLZX_MATCH Match);
+    void AddMatch(PLZX_MATCH Match);
+    void EncodeFrame(ULONG Start, ULONG Length);
+    bool WriteVerbatimBlock(ULONG Length);
+    void WriteUncompressedBlock(PUCHAR Data, ULONG Length);
+
+    /* Shared state */
+    ULONG WindowBits;
+    ULONG WindowSize;
+    ULONG PositionSlots;
+    ULONG R0, R1, R2;
+    ULONG FrameNumber;
+    UCHAR MainLengths[LZX_MAINTREE_MAXSYMBOLS];
+    UCHAR LengthLengths[LZX_NUM_SECONDARY_LENGTHS];
+    UCHAR AlignedLengths[LZX_ALIGNED_NUM_ELEMENTS];
+    UCHAR PreLengths[LZX_PRETREE_NUM_ELEMENTS];
+
+    /* Bit stream state */
+    PUCHAR BitPointer;
+    PUCHAR BitEnd;
+    ULONG BitBuffer;
+    ULONG BitCount;
+    ULONG BitPadding;       // Zero bits buffered past the end of the input
+    bool BitOverflow;
+
+    /* Decoder state */
+    std::vector<UCHAR> Window;
+    ULONG WindowPosition;
+    bool HeaderRead;
+    ULONG IntelFileSize;
+    bool IntelStarted;
+    ULONG BlockType;
+    ULONG BlockLength;
+    ULONG BlockRemaining;
+    LZX_HUFFMAN_TABLE MainTable;
+    LZX_HUFFMAN_TABLE LengthTable;
+    LZX_HUFFMAN_TABLE AlignedTable;
+    LZX_HUFFMAN_TABLE PreTable;
+
+    /* Encoder state */
+    std::vector<UCHAR> History;
+    ULONG HistoryLength;
+    ULONG HashInserted;
+    std::vector<LONG> HashHead;
+    std::vector<LONG> HashPrev;
+    std::vector<LZX_TOKEN> Tokens;
+    ULONG MainFrequency[LZX_MAINTREE_MAXSYMBOLS];
+    ULONG LengthFrequency[LZX_NUM_SECONDARY_LENGTHS];
+    UCHAR NewMainLengths[LZX_MAINTREE_MAXSYMBOLS];
+    UCHAR NewLengthLengths[LZX_NUM_SECONDARY_LENGTHS];
+};
+
+/* EOF */
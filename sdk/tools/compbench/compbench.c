@@ -0,0 +1,478 @@
+/*
+ * PROJECT:     ReactOS host tools
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Round-trip check and throughput benchmark for the rtl compression engines
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define RTL_COMPRESS_HOST
+#include <compress.h>
+
+/* Keep timing each operation for at least this long */
+#define MIN_BENCH_TIME  0.25
+
+typedef struct _FORMAT
+{
+    const char *Name;
+    USHORT FormatAndEngine;
+} FORMAT;
+
+static const FORMAT Formats[] =
+{
+    { "lznt1",              COMPRESSION_FORMAT_LZNT1 },
+    { "lznt1-max",          COMPRESSION_FORMAT_LZNT1 | COMPRESSION_ENGINE_MAXIMUM },
+    { "xpress",             COMPRESSION_FORMAT_XPRESS },
+    { "xpress-max",         COMPRESSION_FORMAT_XPRESS | COMPRESSION_ENGINE_MAXIMUM },
+    { "xpress-huff",        COMPRESSION_FORMAT_XPRESS_HUFF },
+    { "xpress-huff-max",    COMPRESSION_FORMAT_XPRESS_HUFF | COMPRESSION_ENGINE_MAXIMUM },
+};
+
+#define FORMAT_COUNT (sizeof(Formats) / sizeof(Formats[0]))
+
+typedef struct _INPUT
+{
+    char Name[64];
+    PUCHAR Data;
+    ULONG Size;
+} INPUT;
+
+/* With -c, data goes through RtlCompressChunks in NTFS-sized compression units */
+#define UNIT_SHIFT      16
+#define CHUNK_SHIFT     12
+#define UNIT_CHUNKS     (1 << (UNIT_SHIFT - CHUNK_SHIFT))
+#define UNIT_INFO_SIZE  (FIELD_OFFSET(COMPRESSED_DATA_INFO, CompressedChunkSizes) + UNIT_CHUNKS * sizeof(ULONG))
+
+static int Verbose = 0;
+static int Chunked = 0;
+
+static
+void
+Usage(void)
+{
+    printf("Round-trips data through RtlCompressBuffer/RtlDecompressBuffer and reports throughput.\n"
+           "Syntax: compbench [-f format] [-c] [-q] [-v] [file ...]\n"
+           "  -f format  Only run one format (lznt1, lznt1-max, xpress, xpress-max,\n"
+           "             xpress-huff, xpress-huff-max)\n"
+           "  -c         Use RtlCompressChunks/RtlDecompressChunks on 64K units of 4K chunks\n"
+           "  -q         Only check the round trip, skip the timing\n"
+           "  -v         With -q, list every round trip\n"
+           "Without files, a built-in synthetic corpus is used.\n");
+}
+
+static
+ULONG
+NextRandom(ULONG *Seed)
+{
+    *Seed = *Seed * 1103515245 + 12345;
+    return *Seed >> 16;
+}
+
+/* Text-like data: words from a small vocabulary */
+static
+void
+FillText(PUCHAR Data, ULONG Size, ULONG Seed)
+{
+    static const char *Words[] =
+    {
+        "the ", "registry ", "kernel ", "object ", "handle ", "of ", "and ",
+        "driver ", "NTSTATUS ", "return ", "buffer ", "\r\n", "file ", "(", ")",
+        "STATUS_SUCCESS", "; ", "if ", "{\r\n    ", "}\r\n", "ULONG ", "PVOID "
+    };
+    ULONG Position = 0, Length;
+    const char *Word;
+
+    while (Position < Size)
+    {
+        Word = Words[NextRandom(&Seed) % (sizeof(Words) / sizeof(Words[0]))];
+        Length = (ULONG)strlen(Word);
+        if (Length > Size - Position)
+            Length = Size - Position;
+        memcpy(Data + Position, Word, Length);
+        Position += Length;
+    }
+}
+
+/* Executable-like data: structured records with small random fields */
+static
+void
+FillBinary(PUCHAR Data, ULONG Size, ULONG Seed)
+{
+    ULONG i;
+
+    for (i = 0; i < Size; i++)
+    {
+        switch (i % 16)
+        {
+            case 0: case 1: case 2: case 3:
+                Data[i] = (UCHAR)((i >> 4) >> ((i % 4) * 8));
+                break;
+            case 4: case 5:
+                Data[i] = (UCHAR)(NextRandom(&Seed) & 0x0F);
+                break;
+            case 6:
+                Data[i] = 0x8B;
+                break;
+            default:
+                Data[i] = 0;
+                break;
+        }
+    }
+}
+
+static
+void
+FillRandom(PUCHAR Data, ULONG Size, ULONG Seed)
+{
+    ULONG i;
+
+    for (i = 0; i < Size; i++)
+        Data[i] = (UCHAR)NextRandom(&Seed);
+}
+
+static
+int
+AddInput(INPUT *Input, const char *Name, ULONG Size)
+{
+    strncpy(Input->Name, Name, sizeof(Input->Name) - 1);
+    Input->Name[sizeof(Input->Name) - 1] = '\0';
+    Input->Size = Size;
+    Input->Data = malloc(Size ? Size : 1);
+    return Input->Data != NULL;
+}
+
+static
+int
+LoadFile(INPUT *Input, const char *FileName)
+{
+    FILE *File;
+    long Size;
+    const char *BaseName;
+
+    File = fopen(FileName, "rb");
+    if (!File)
+    {
+        printf("Cannot open '%s'\n", FileName);
+        return 0;
+    }
+
+    fseek(File, 0, SEEK_END);
+    Size = ftell(File);
+    fseek(File, 0, SEEK_SET);
+
+    BaseName = strrchr(FileName, '/');
+    BaseName = BaseName ? BaseName + 1 : FileName;
+
+    if (Size < 0 || !AddInput(Input, BaseName, (ULONG)Size) ||
+        fread(Input->Data, 1, Size, File) != (size_t)Size)
+    {
+        printf("Cannot read '%s'\n", FileName);
+        fclose(File);
+        return 0;
+    }
+
+    fclose(File);
+    return 1;
+}
+
+static
+double
+Elapsed(clock_t Start)
+{
+    return (double)(clock() - Start) / CLOCKS_PER_SEC;
+}
+
+static
+double
+Throughput(ULONG Size, ULONG Rounds, double Seconds)
+{
+    if (Seconds <= 0)
+        return 0;
+    return (double)Size * Rounds / Seconds / (1024 * 1024);
+}
+
+static
+NTSTATUS
+CompressInput(const INPUT *Input, const FORMAT *Format, PUCHAR Compressed, ULONG OutputSize,
+              PULONG CompressedSize, PVOID WorkSpace, PUCHAR UnitInfo)
+{
+    PCOMPRESSED_DATA_INFO Info;
+    ULONG Position, Size, Used = 0, i;
+    NTSTATUS Status;
+
+    if (!Chunked)
+    {
+        return RtlCompressBuffer(Format->FormatAndEngine, Input->Data, Input->Size,
+                                 Compressed, OutputSize, 4096, CompressedSize, WorkSpace);
+    }
+
+    for (Position = 0; Position < Input->Size; Position += Size)
+    {
+        Size = Input->Size - Position;
+        if (Size > (1 << UNIT_SHIFT))
+            Size = 1 << UNIT_SHIFT;
+
+        Info = (PCOMPRESSED_DATA_INFO)(UnitInfo + (Position >> UNIT_SHIFT) * UNIT_INFO_SIZE);
+        Info->CompressionFormatAndEngine = Format->FormatAndEngine;
+        Info->CompressionUnitShift = UNIT_SHIFT;
+        Info->ChunkShift = CHUNK_SHIFT;
+        Info->ClusterShift = 9;
+
+        Status = RtlCompressChunks(Input->Data + Position, Size, Compressed + Used,
+                                   OutputSize - Used, Info, UNIT_INFO_SIZE, WorkSpace);
+        if (!NT_SUCCESS(Status))
+            return Status;
+
+        for (i = 0; i < Info->NumberOfChunks; i++)
+            Used += Info->CompressedChunkSizes[i];
+    }
+
+    *CompressedSize = Used;
+    return STATUS_SUCCESS;
+}
+
+static
+NTSTATUS
+DecompressInput(const INPUT *Input, const FORMAT *Format, PUCHAR Compressed, ULONG CompressedSize,
+                PUCHAR Decompressed, PULONG FinalSize, PUCHAR UnitInfo)
+{
+    PCOMPRESSED_DATA_INFO Info;
+    ULONG Position, Size, Used = 0, UnitUsed, i;
+    NTSTATUS Status;
+
+    if (!Chunked)
+    {
+        return RtlDecompressBuffer(Format->FormatAndEngine, Decompressed, Input->Size + 1,
+                                   Compressed, CompressedSize, FinalSize);
+    }
+
+    for (Position = 0; Position < Input->Size; Position += Size)
+    {
+        Size = Input->Size - Position;
+        if (Size > (1 << UNIT_SHIFT))
+            Size = 1 << UNIT_SHIFT;
+
+        Info = (PCOMPRESSED_DATA_INFO)(UnitInfo + (Position >> UNIT_SHIFT) * UNIT_INFO_SIZE);
+        for (i = 0, UnitUsed = 0; i < Info->NumberOfChunks; i++)
+            UnitUsed += Info->CompressedChunkSizes[i];
+
+        Status = RtlDecompressChunks(Decompressed + Position, Size, Compressed + Used,
+                                     UnitUsed, NULL, 0, Info);
+        if (!NT_SUCCESS(Status))
+            return Status;
+        Used += UnitUsed;
+    }
+
+    *FinalSize = Input->Size;
+    return STATUS_SUCCESS;
+}
+
+static
+int
+RunOne(const INPUT *Input, const FORMAT *Format, int Timing)
+{
+    ULONG WorkSpaceSize, FragmentSize, CompressedSize, FinalSize;
+    ULONG OutputSize, Rounds;
+    PUCHAR WorkSpace, Compressed, Decompressed, UnitInfo;
+    double CompressTime = 0, DecompressTime = 0;
+    clock_t Start;
+    NTSTATUS Status;
+    int Result = 0;
+
+    Status = RtlGetCompressionWorkSpaceSize(Format->FormatAndEngine, &WorkSpaceSize, &FragmentSize);
+    if (!NT_SUCCESS(Status))
+    {
+        printf("%-20s %-16s workspace query failed 0x%08x\n", Input->Name, Format->Name, Status);
+        return 1;
+    }
+
+    /* Worst case growth is well below 1/8 for all formats */
+    OutputSize = Input->Size + Input->Size / 8 + 4096;
+    WorkSpace = malloc(WorkSpaceSize ? WorkSpaceSize : 1);
+    Compressed = malloc(OutputSize);
+    Decompressed = malloc(Input->Size + 1);
+    UnitInfo = malloc(((Input->Size >> UNIT_SHIFT) + 1) * UNIT_INFO_SIZE);
+    if (!WorkSpace || !Compressed || !Decompressed || !UnitInfo)
+    {
+        printf("Out of memory\n");
+        Result = 1;
+        goto Quit;
+    }
+
+    Rounds = 0;
+    Start = clock();
+    do
+    {
+        Status = CompressInput(Input, Format, Compressed, OutputSize,
+                               &CompressedSize, WorkSpace, UnitInfo);
+        Rounds++;
+    } while (NT_SUCCESS(Status) && Timing && (CompressTime = Elapsed(Start)) < MIN_BENCH_TIME);
+
+    if (!NT_SUCCESS(Status))
+    {
+        printf("%-20s %-16s compression failed 0x%08x\n", Input->Name, Format->Name, Status);
+        Result = 1;
+        goto Quit;
+    }
+    CompressTime = Throughput(Input->Size, Rounds, CompressTime);
+
+    /* LZNT1 has no representation for an empty buffer */
+    if (!Input->Size && !CompressedSize)
+        goto Quit;
+
+    Rounds = 0;
+    Start = clock();
+    do
+    {
+        /* One byte of slack catches decoders writing too much */
+        memset(Decompressed, 0xCC, Input->Size + 1);
+        Status = DecompressInput(Input, Format, Compressed, CompressedSize,
+                                 Decompressed, &FinalSize, UnitInfo);
+        Rounds++;
+    } while (NT_SUCCESS(Status) && Timing && (DecompressTime = Elapsed(Start)) < MIN_BENCH_TIME);
+
+    if (!NT_SUCCESS(Status))
+    {
+        printf("%-20s %-16s decompression failed 0x%08x\n", Input->Name, Format->Name, Status);
+        Result = 1;
+        goto Quit;
+    }
+    DecompressTime = Throughput(Input->Size, Rounds, DecompressTime);
+
+    if (FinalSize != Input->Size || memcmp(Decompressed, Input->Data, Input->Size) ||
+        Decompressed[Input->Size] != 0xCC)
+    {
+        printf("%-20s %-16s MISMATCH (%u bytes back, %u expected)\n",
+               Input->Name, Format->Name, FinalSize, Input->Size);
+        Result = 1;
+        goto Quit;
+    }
+
+    if (Timing)
+    {
+        printf("%-20s %-16s %10u -> %10u (%5.1f%%)  comp %8.1f MB/s  decomp %8.1f MB/s\n",
+               Input->Name, Format->Name, Input->Size, CompressedSize,
+               Input->Size ? 100.0 * CompressedSize / Input->Size : 0.0,
+               CompressTime, DecompressTime);
+    }
+    else if (Verbose)
+    {
+        printf("%-20s %-16s %10u -> %10u ok\n",
+               Input->Name, Format->Name, Input->Size, CompressedSize);
+    }
+
+Quit:
+    free(WorkSpace);
+    free(Compressed);
+    free(Decompressed);
+    free(UnitInfo);
+    return Result;
+}
+
+int main(int argc, char *argv[])
+{
+    INPUT *Inputs;
+    ULONG InputCount = 0, i, j;
+    const char *OnlyFormat = NULL;
+    int Timing = 1, Failures = 0, FileCount = 0, Matched;
+
+    for (i = 1; i < (ULONG)argc; i++)
+    {
+        if (!strcmp(argv[i], "-f") && i + 1 < (ULONG)argc)
+            OnlyFormat = argv[++i];
+        else if (!strcmp(argv[i], "-c"))
+            Chunked = 1;
+        else if (!strcmp(argv[i], "-q"))
+            Timing = 0;
+        else if (!strcmp(argv[i], "-v"))
+            Verbose = 1;
+        else if (argv[i][0] == '-')
+        {
+            Usage();
+            return 1;
+        }
+        else
+            FileCount++;
+    }
+
+    Inputs = calloc(FileCount ? FileCount : 8, sizeof(INPUT));
+    if (!Inputs)
+        return 1;
+
+    if (FileCount)
+    {
+        for (i = 1; i < (ULONG)argc; i++)
+        {
+            if (!strcmp(argv[i], "-f"))
+            {
+                i++;
+                continue;
+            }
+            if (argv[i][0] == '-')
+                continue;
+            if (!LoadFile(&Inputs[InputCount], argv[i]))
+                return 1;
+            InputCount++;
+        }
+    }
+    else
+    {
+        /* Edge cases around the chunk sizes, then bulk data */
+        if (!AddInput(&Inputs[InputCount], "empty", 0))
+            return 1;
+        InputCount++;
+
+        if (!AddInput(&Inputs[InputCount], "text-64k", 0x10000))
+            return 1;
+        FillText(Inputs[InputCount++].Data, 0x10000, 1);
+
+        if (!AddInput(&Inputs[InputCount], "text-64k+1", 0x10001))
+            return 1;
+        FillText(Inputs[InputCount++].Data, 0x10001, 2);
+
+        if (!AddInput(&Inputs[InputCount], "zeros-1m", 0x100000))
+            return 1;
+        memset(Inputs[InputCount++].Data, 0, 0x100000);
+
+        if (!AddInput(&Inputs[InputCount], "random-256k", 0x40000))
+            return 1;
+        FillRandom(Inputs[InputCount++].Data, 0x40000, 3);
+
+        if (!AddInput(&Inputs[InputCount], "binary-1m", 0x100000))
+            return 1;
+        FillBinary(Inputs[InputCount++].Data, 0x100000, 4);
+
+        if (!AddInput(&Inputs[InputCount], "text-4m", 0x400000))
+            return 1;
+        FillText(Inputs[InputCount++].Data, 0x400000, 5);
+    }
+
+    Matched = 0;
+    for (j = 0; j < FORMAT_COUNT; j++)
+    {
+        if (OnlyFormat && strcmp(OnlyFormat, Formats[j].Name))
+            continue;
+        Matched++;
+
+        for (i = 0; i < InputCount; i++)
+            Failures += RunOne(&Inputs[i], &Formats[j], Timing);
+    }
+
+    if (!Matched)
+    {
+        printf("Unknown format '%s'\n", OnlyFormat);
+        return 1;
+    }
+
+    for (i = 0; i < InputCount; i++)
+        free(Inputs[i].Data);
+    free(Inputs);
+
+    if (Failures)
+        printf("%d round trip(s) FAILED\n", Failures);
+    return Failures ? 1 : 0;
+}
@@ -26,20 +26,170 @@
 
 /* INCLUDES *****************************************************************/
 
+#include <limits.h>
+#ifdef _WIN32
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
+
 #include "mkhive.h"
 
+#ifndef PATH_MAX
+#define PATH_MAX 260
+#endif
+
+#define HIVE_WRITE_BUFFER_SIZE  (256 * 1024)
+
 /* FUNCTIONS ****************************************************************/
 
+/* 64-bit FNV-1a */
+ULONGLONG
+HashData(
+    IN ULONGLONG Hash,
+    IN const VOID *Data,
+    IN SIZE_T Length)
+{
+    const UCHAR *Bytes = Data;
+
+    while (Length--)
+    {
+        Hash ^= *Bytes++;
+        Hash *= 0x100000001B3ULL;
+    }
+
+    return Hash;
+}
+
+BOOL
+HashFile(
+    IN PCSTR FileName,
+    IN OUT ULONGLONG *Hash)
+{
+    UCHAR Buffer[16 * 1024];
+    FILE *File;
+    size_t Length;
+
+    File = fopen(FileName, "rb");
+    if (File == NULL)
+        return FALSE;
+
+    while ((Length = fread(Buffer, 1, sizeof(Buffer), File)) != 0)
+        *Hash = HashData(*Hash, Buffer, Length);
+
+    fclose(File);
+    return TRUE;
+}
+
+static VOID
+GetHashFileName(
+    IN PCSTR FileName,
+    OUT PSTR HashFileName,
+    IN SIZE_T Size)
+{
+    snprintf(HashFileName, Size, "%s.hash", FileName);
+}
+
+/*
+ * The hash of the inputs of a binary hive is kept next to it. The hive
+ * is up to date when it exists and was built from the same inputs.
+ */
+BOOL
+IsBinaryHiveCurrent(
+    IN PCSTR FileName,
+    IN ULONGLONG Hash)
+{
+    CHAR HashFileName[PATH_MAX];
+    ULONG High, Low;
+    FILE *File;
+    BOOL ret;
+
+    /* A zero hash means the inputs could not be hashed */
+    if (Hash == 0)
+        return FALSE;
+
+    File = fopen(FileName, "rb");
+    if (File == NULL)
+        return FALSE;
+    fclose(File);
+
+    GetHashFileName(FileName, HashFileName, sizeof(HashFileName));
+    File = fopen(HashFileName, "r");
+    if (File == NULL)
+        return FALSE;
+
+    ret = (fscanf(File, "%8x%8x", &High, &Low) == 2 &&
+           (((ULONGLONG)High << 32) | Low) == Hash);
+    fclose(File);
+    return ret;
+}
+
+/*
+ * Brings the modification time of a reused hive and of its hash up to
+ * date, as if both had been written again.
+ */
+BOOL
+TouchBinaryHive(
+    IN PCSTR FileName)
+{
+    CHAR HashFileName[PATH_MAX];
+
+    GetHashFileName(FileName, HashFileName, sizeof(HashFileName));
+    if (utime(FileName, NULL) != 0 || utime(HashFileName, NULL) != 0)
+    {
+        printf("    Error touching file %s\n", FileName);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+BOOL
+WriteBinaryHiveHash(
+    IN PCSTR FileName,
+    IN ULONGLONG Hash)
+{
+    CHAR HashFileName[PATH_MAX];
+    FILE *File;
+    BOOL ret;
+
+    GetHashFileName(FileName, HashFileName, sizeof(HashFileName));
+
+    /* Without a hash the hive is always rebuilt */
+    if (Hash == 0)
+    {
+        remove(HashFileName);
+        return TRUE;
+    }
+
+    File = fopen(HashFileName, "w");
+    if (File == NULL)
+    {
+        printf("    Error creating/opening file %s\n", HashFileName);
+        return FALSE;
+    }
+
+    ret = (fprintf(File, "%08x%08x\n", (ULONG)(Hash >> 32), (ULONG)Hash) > 0);
+    ret = (fclose(File) == 0) && ret;
+    return ret;
+}
+
 BOOL
 ExportBinaryHive(
     IN PCSTR FileName,
     IN PCMHIVE CmHive)
 {
+    CHAR HashFileName[PATH_MAX];
     FILE *File;
     BOOL ret;
 
     printf("  Creating binary hive: %s\n", FileName);
 
+    /* A hive left half written must not pass for current, so drop its
+     * hash first. WriteBinaryHiveHash puts it back once the hive is out. */
+    GetHashFileName(FileName, HashFileName, sizeof(HashFileName));
+    remove(HashFileName);
+
     /* Create new hive file */
     File = fopen(FileName, "wb");
     if (File == NULL)
@@ -48,11 +198,14 @@ ExportBinaryHive(
         return FALSE;
     }
 
+    /* The blocks are written in file order, let them stream through one buffer */
+    setvbuf(File, NULL, _IOFBF, HIVE_WRITE_BUFFER_SIZE);
+
     fseek(File, 0, SEEK_SET);
 
     CmHive->FileHandles[HFILE_TYPE_PRIMARY] = (HANDLE)File;
     ret = HvWriteHive(&CmHive->Hive);
-    fclose(File);
+    ret = (fclose(File) == 0) && ret;
     return ret;
 }
 
@@ -26,6 +26,33 @@
 
 #pragma once
 
+#define HIVE_HASH_BASIS 0xCBF29CE484222325ULL
+
+ULONGLONG
+HashData(
+    IN ULONGLONG Hash,
+    IN const VOID *Data,
+    IN SIZE_T Length);
+
+BOOL
+HashFile(
+    IN PCSTR FileName,
+    IN OUT ULONGLONG *Hash);
+
+BOOL
+IsBinaryHiveCurrent(
+    IN PCSTR FileName,
+    IN ULONGLONG Hash);
+
+BOOL
+TouchBinaryHive(
+    IN PCSTR FileName);
+
+BOOL
+WriteBinaryHiveHash(
+    IN PCSTR FileName,
+    IN ULONGLONG Hash);
+
 BOOL
 ExportBinaryHive(
     IN PCSTR FileName,
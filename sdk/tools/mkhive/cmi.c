@@ -79,8 +79,13 @@ CmpFileWrite(
 {
     PCMHIVE CmHive = (PCMHIVE)RegistryHive;
     FILE *File = CmHive->FileHandles[HFILE_TYPE_PRIMARY];
-    if (fseek(File, *FileOffset, SEEK_SET) != 0)
+
+    /* Seeking flushes the stream, only do it when the blocks are not in order */
+    if (ftell(File) != (long)*FileOffset &&
+        fseek(File, *FileOffset, SEEK_SET) != 0)
+    {
         return FALSE;
+    }
 
     return (fwrite(Buffer, 1, BufferLength, File) == BufferLength);
 }
@@ -146,6 +151,13 @@ CmiInitializeHive(
         return STATUS_INSUFFICIENT_RESOURCES;
     }
 
+    /* mkhive is single-threaded, so the subkey lookup cache is safe to use */
+    if (!CmpInitializeSubKeyIndex(&Hive->Hive))
+    {
+        HvFree(&Hive->Hive);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
     /* Add the new hive to the hive list */
     InsertTailList(&CmiHiveListHead,
                    &Hive->HiveList);
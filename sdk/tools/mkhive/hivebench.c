@@ -0,0 +1,182 @@
+/*
+ * PROJECT:     ReactOS hive maker
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Benchmark of subkey lookups with and without the cmlib lookup cache
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+/*
+ * Builds two hives with one key holding many CLSID-like subkeys, the way
+ * mkhive does (look the key up, create it if it is missing), one with the
+ * subkey lookup cache and one without. Then looks up every subkey and as
+ * many missing ones in both, and checks that they give the same cells.
+ */
+
+#include <time.h>
+#include <string.h>
+
+#define NDEBUG
+#include "mkhive.h"
+
+#define BENCH_DEFAULT_KEYS  50000
+#define BENCH_NAME_LENGTH   38
+
+typedef struct _BENCH_HIVE
+{
+    CMHIVE Hive;
+    HCELL_INDEX *Cells;
+    double CreateTime;
+    double HitTime;
+    double MissTime;
+} BENCH_HIVE, *PBENCH_HIVE;
+
+static double
+GetSeconds(clock_t Start)
+{
+    return (double)(clock() - Start) / CLOCKS_PER_SEC;
+}
+
+/* Upper case GUID strings, like the subkeys of CLSID */
+static VOID
+MakeName(ULONG Number, BOOLEAN Missing, PWCHAR Buffer, PUNICODE_STRING Name)
+{
+    ULONG State = Number * 2654435761u + (Missing ? 0x5bd1e995 : 1);
+    CHAR Text[BENCH_NAME_LENGTH + 1];
+    ULONG Part[4], i;
+
+    for (i = 0; i < _countof(Part); i++)
+    {
+        State = State * 1103515245u + 12345u;
+        Part[i] = State ^ (Number << (i * 8));
+    }
+
+    snprintf(Text, sizeof(Text), "{%08X-%04X-%04X-%04X-%04X%08X}",
+             (UINT)Part[0], (UINT)(Part[1] >> 16), (UINT)(Part[1] & 0xFFFF),
+             (UINT)(Part[2] >> 16), (UINT)(Part[2] & 0xFFFF), (UINT)Part[3]);
+
+    for (i = 0; i < BENCH_NAME_LENGTH; i++)
+        Buffer[i] = (WCHAR)Text[i];
+
+    Name->Buffer = Buffer;
+    Name->Length = Name->MaximumLength = BENCH_NAME_LENGTH * sizeof(WCHAR);
+}
+
+static HCELL_INDEX
+FindSubKey(PBENCH_HIVE Bench, PCUNICODE_STRING Name)
+{
+    PHHIVE Hive = &Bench->Hive.Hive;
+    HCELL_INDEX RootCell = Hive->BaseBlock->RootCell;
+    PCM_KEY_NODE Root;
+    HCELL_INDEX Cell;
+
+    /* Map the root every time, the hive moves as it grows */
+    Root = (PCM_KEY_NODE)HvGetCell(Hive, RootCell);
+    if (!Root)
+        return HCELL_NIL;
+
+    Cell = CmpFindSubKeyByName(Hive, Root, Name);
+    HvReleaseCell(Hive, RootCell);
+    return Cell;
+}
+
+static BOOLEAN
+RunBench(PBENCH_HIVE Bench, ULONG Count, BOOLEAN UseCache)
+{
+    WCHAR Buffer[BENCH_NAME_LENGTH];
+    UNICODE_STRING Name;
+    clock_t Start;
+    ULONG i;
+
+    if (!NT_SUCCESS(CmiInitializeHive(&Bench->Hive, L"")))
+        return FALSE;
+
+    if (!UseCache)
+        CmpDestroySubKeyIndex(&Bench->Hive.Hive);
+
+    Bench->Cells = malloc(Count * sizeof(HCELL_INDEX));
+    if (!Bench->Cells)
+        return FALSE;
+
+    Start = clock();
+    for (i = 0; i < Count; i++)
+    {
+        MakeName(i, FALSE, Buffer, &Name);
+
+        Bench->Cells[i] = FindSubKey(Bench, &Name);
+        if (Bench->Cells[i] != HCELL_NIL)
+            continue;
+
+        if (!NT_SUCCESS(CmiAddSubKey(&Bench->Hive,
+                                     Bench->Hive.Hive.BaseBlock->RootCell,
+                                     &Name,
+                                     FALSE,
+                                     &Bench->Cells[i])))
+        {
+            printf("Cannot add subkey %lu\n", i);
+            return FALSE;
+        }
+    }
+    Bench->CreateTime = GetSeconds(Start);
+
+    Start = clock();
+    for (i = 0; i < Count; i++)
+    {
+        /* Not in creation order */
+        MakeName((i * 7919) % Count, FALSE, Buffer, &Name);
+        if (FindSubKey(Bench, &Name) != Bench->Cells[(i * 7919) % Count])
+        {
+            printf("Subkey %lu not found\n", (i * 7919) % Count);
+            return FALSE;
+        }
+    }
+    Bench->HitTime = GetSeconds(Start);
+
+    Start = clock();
+    for (i = 0; i < Count; i++)
+    {
+        MakeName(i, TRUE, Buffer, &Name);
+        if (FindSubKey(Bench, &Name) != HCELL_NIL)
+        {
+            printf("Missing subkey %lu found\n", i);
+            return FALSE;
+        }
+    }
+    Bench->MissTime = GetSeconds(Start);
+
+    return TRUE;
+}
+
+int main(int argc, char *argv[])
+{
+    static BENCH_HIVE Plain, Cached;
+    ULONG Count = BENCH_DEFAULT_KEYS;
+
+    if (argc > 1)
+        Count = strtoul(argv[1], NULL, 10);
+    if (Count == 0)
+        Count = BENCH_DEFAULT_KEYS;
+
+    InitializeListHead(&CmiHiveListHead);
+
+    if (!RunBench(&Plain, Count, FALSE) ||
+        !RunBench(&Cached, Count, TRUE))
+    {
+        return 1;
+    }
+
+    if (memcmp(Plain.Cells, Cached.Cells, Count * sizeof(HCELL_INDEX)) != 0)
+    {
+        printf("The hives differ!\n");
+        return 1;
+    }
+
+    printf("%lu subkeys    leaves    cache\n", Count);
+    printf("Create:      %7.3f s  %7.3f s  (%.1fx)\n",
+           Plain.CreateTime, Cached.CreateTime, Plain.CreateTime / Cached.CreateTime);
+    printf("Hits:        %7.3f s  %7.3f s  (%.1fx)\n",
+           Plain.HitTime, Cached.HitTime, Plain.HitTime / Cached.HitTime);
+    printf("Misses:      %7.3f s  %7.3f s  (%.1fx)\n",
+           Plain.MissTime, Cached.MissTime, Plain.MissTime / Cached.MissTime);
+
+    return 0;
+}
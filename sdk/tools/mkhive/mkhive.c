@@ -31,6 +31,7 @@
 #include <limits.h>
 #include <string.h>
 #include <stdio.h>
+#include <time.h>
 
 #include "mkhive.h"
 
@@ -54,10 +55,12 @@
 
 void usage(void)
 {
-    printf("Usage: mkhive [-?] -h:hive1[,hiveN...] [-u] -d:<dstdir> <inffiles>\n\n"
+    printf("Usage: mkhive [-?] -h:hive1[,hiveN...] [-u] [-i] [-t] -d:<dstdir> <inffiles>\n\n"
            "  -h:hiveN  - Comma-separated list of hives to create. Possible values are:\n"
            "              SETUPREG, SYSTEM, SOFTWARE, DEFAULT, SAM, SECURITY, BCD.\n"
            "  -u        - Generate file names in uppercase (default: lowercase) (TEMPORARY FLAG!).\n"
+           "  -i        - Incremental: keep the hives whose INF entries did not change.\n"
+           "  -t        - Report how long each hive took.\n"
            "  -d:dstdir - The binary hive files are created in this directory.\n"
            "  inffiles  - List of INF files with full path.\n"
            "  -?        - Displays this help screen.\n");
@@ -91,15 +94,58 @@ void convert_path(char *dst, char *src)
     dst[i] = 0;
 }
 
+static ULONG GetElapsedMs(clock_t Start)
+{
+    return (ULONG)((clock() - Start) * 1000 / CLOCKS_PER_SEC);
+}
+
+static void GetHiveFileName(PSTR FileName, PCSTR DestPath, INT Index, BOOL UpperCaseFileName)
+{
+    PSTR ptr;
+
+    strcpy(FileName, DestPath);
+    strcat(FileName, DIR_SEPARATOR_STRING);
+
+    ptr = FileName + strlen(FileName);
+
+    strcat(FileName, RegistryHives[Index].HiveName);
+
+    /* Exception for the special setup registry hive */
+    // if (strcmp(RegistryHives[Index].HiveName, "SETUPREG") == 0)
+    if (Index == 0)
+        strcat(FileName, ".HIV");
+
+    /* Adjust file name case if needed */
+    if (UpperCaseFileName)
+    {
+        for (; *ptr; ++ptr)
+            *ptr = toupper(*ptr);
+    }
+    else
+    {
+        for (; *ptr; ++ptr)
+            *ptr = tolower(*ptr);
+    }
+}
+
 int main(int argc, char *argv[])
 {
     INT ret;
-    INT i;
-    PSTR ptr;
+    INT i, j;
     BOOL UpperCaseFileName = FALSE;
+    BOOL Incremental = FALSE;
+    BOOL Timing = FALSE;
+    BOOL Registry = FALSE;
     PCSTR HiveList = NULL;
     CHAR DestPath[PATH_MAX] = "";
     CHAR FileName[PATH_MAX];
+    HINF *InfFiles;
+    INT InfCount;
+    ULONG ErrorLine;
+    ULONGLONG ToolHash;
+    BOOL HashInputs;
+    INT RebuildCount;
+    clock_t Start;
 
     if (argc < 4)
     {
@@ -122,6 +168,14 @@ int main(int argc, char *argv[])
         {
             UpperCaseFileName = TRUE;
         }
+        else if (argv[i][1] == 'i' && argv[i][2] == 0)
+        {
+            Incremental = TRUE;
+        }
+        else if (argv[i][1] == 't' && argv[i][2] == 0)
+        {
+            Timing = TRUE;
+        }
         else
         if (argv[i][1] == 'h' && (argv[i][2] == ':' || argv[i][2] == '='))
         {
@@ -155,52 +209,142 @@ int main(int argc, char *argv[])
         return -1;
     }
 
-    /* Initialize the registry */
-    RegInitializeRegistry(HiveList);
-
     /* Default to failure */
     ret = -1;
 
-    /* Now we should have the list of INF files: parse it */
+    Start = clock();
+
+    /* Now we should have the list of INF files: load it */
+    InfCount = 0;
+    InfFiles = malloc((argc - i) * sizeof(HINF));
+    if (!InfFiles)
+    {
+        fprintf(stderr, "Not enough memory.\n");
+        return -1;
+    }
+
     for (; i < argc; ++i)
     {
         convert_path(FileName, argv[i]);
-        if (!ImportRegistryFile(FileName))
+        if (InfHostOpenFile(&InfFiles[InfCount], FileName, 0, &ErrorLine) != 0)
+        {
+            DPRINT1("InfHostOpenFile(%s) failed\n", FileName);
             goto Quit;
+        }
+        InfCount++;
     }
 
+    /*
+     * Every entry goes into exactly one hive, so the entries of a hive
+     * decide its contents. Hash them together with the tool itself, so
+     * that a new mkhive rebuilds all hives.
+     */
+    ToolHash = HIVE_HASH_BASIS;
+    HashInputs = HashFile(argv[0], &ToolHash);
+    if (!HashInputs && Incremental)
+        printf("  Cannot read %s, rebuilding all hives\n", argv[0]);
+
+    RebuildCount = 0;
     for (i = 0; i < MAX_NUMBER_OF_REGISTRY_HIVES; ++i)
     {
+        RegistryHives[i].InputHash = 0;
+        RegistryHives[i].Reuse = FALSE;
+
         /* Skip this registry hive if it's not in the list */
         if (!strstr(HiveList, RegistryHives[i].HiveName))
             continue;
 
-        strcpy(FileName, DestPath);
-        strcat(FileName, DIR_SEPARATOR_STRING);
+        if (HashInputs)
+        {
+            RegistryHives[i].InputHash = HashData(ToolHash,
+                                                  RegistryHives[i].HiveName,
+                                                  strlen(RegistryHives[i].HiveName));
+        }
+        RebuildCount++;
 
-        ptr = FileName + strlen(FileName);
+        if (i == 0)
+            break;
+    }
 
-        strcat(FileName, RegistryHives[i].HiveName);
+    if (HashInputs)
+    {
+        for (j = 0; j < InfCount; ++j)
+            HashRegistryFile(InfFiles[j], HiveList);
+    }
 
-        /* Exception for the special setup registry hive */
-        // if (strcmp(RegistryHives[i].HiveName, "SETUPREG") == 0)
-        if (i == 0)
-            strcat(FileName, ".HIV");
+    if (Timing)
+        printf("  Read and hashed %d INF files in %lu ms\n", InfCount, (unsigned long)GetElapsedMs(Start));
 
-        /* Adjust file name case if needed */
-        if (UpperCaseFileName)
-        {
-            for (; *ptr; ++ptr)
-                *ptr = toupper(*ptr);
-        }
-        else
+    if (Incremental && HashInputs)
+    {
+        for (i = 0; i < MAX_NUMBER_OF_REGISTRY_HIVES; ++i)
         {
-            for (; *ptr; ++ptr)
-                *ptr = tolower(*ptr);
+            if (!strstr(HiveList, RegistryHives[i].HiveName))
+                continue;
+
+            GetHiveFileName(FileName, DestPath, i, UpperCaseFileName);
+            Start = clock();
+            if (IsBinaryHiveCurrent(FileName, RegistryHives[i].InputHash))
+            {
+                printf("  Binary hive is up to date: %s\n", FileName);
+
+                /* Make it look rebuilt, or the build would run us again */
+                if (!TouchBinaryHive(FileName))
+                    goto Quit;
+
+                RegistryHives[i].Reuse = TRUE;
+                RebuildCount--;
+
+                if (Timing)
+                    printf("    Reused in %lu ms\n", (unsigned long)GetElapsedMs(Start));
+            }
+
+            if (i == 0)
+                break;
         }
+    }
 
-        if (!ExportBinaryHive(FileName, RegistryHives[i].CmHive))
+    if (RebuildCount == 0)
+    {
+        /* Success */
+        ret = 0;
+        goto Quit;
+    }
+
+    /* Initialize the registry */
+    RegInitializeRegistry(HiveList);
+    Registry = TRUE;
+
+    /* Apply the entries of the hives to be rebuilt */
+    Start = clock();
+    for (j = 0; j < InfCount; ++j)
+    {
+        if (!ImportRegistryFile(InfFiles[j], HiveList))
             goto Quit;
+    }
+
+    if (Timing)
+        printf("  Imported the entries of %d hives in %lu ms\n", RebuildCount, (unsigned long)GetElapsedMs(Start));
+
+    for (i = 0; i < MAX_NUMBER_OF_REGISTRY_HIVES; ++i)
+    {
+        /* Skip this registry hive if it's not in the list */
+        if (!strstr(HiveList, RegistryHives[i].HiveName))
+            continue;
+
+        if (!RegistryHives[i].Reuse)
+        {
+            GetHiveFileName(FileName, DestPath, i, UpperCaseFileName);
+            Start = clock();
+            if (!ExportBinaryHive(FileName, RegistryHives[i].CmHive) ||
+                !WriteBinaryHiveHash(FileName, RegistryHives[i].InputHash))
+            {
+                goto Quit;
+            }
+
+            if (Timing)
+                printf("    Written in %lu ms\n", (unsigned long)GetElapsedMs(Start));
+        }
 
         /* If we happen to deal with the special setup registry hive, stop there */
         // if (strcmp(RegistryHives[i].HiveName, "SETUPREG") == 0)
@@ -213,7 +357,12 @@ int main(int argc, char *argv[])
 
 Quit:
     /* Shut down the registry */
-    RegShutdownRegistry();
+    if (Registry)
+        RegShutdownRegistry();
+
+    for (j = 0; j < InfCount; ++j)
+        InfHostCloseFile(InfFiles[j]);
+    free(InfFiles);
 
     if (ret == 0)
         printf("  Done.\n");
@@ -393,9 +393,10 @@ do_reg_operation(
  *            registry_callback
  *
  * Called once for each AddReg and DelReg entry in a given section.
+ * Entries for hives that are reused as they are get skipped.
  */
 static BOOL
-registry_callback(HINF hInf, PCWSTR Section, BOOL Delete)
+registry_callback(HINF hInf, PCWSTR Section, BOOL Delete, PCSTR HiveList)
 {
     WCHAR Buffer[MAX_INF_STRING_LENGTH];
     PWCHAR ValuePtr;
@@ -403,6 +404,7 @@ registry_callback(HINF hInf, PCWSTR Section, BOOL Delete)
     size_t Length;
 
     PINFCONTEXT Context = NULL;
+    PHIVE_LIST_ENTRY Hive;
     HKEY KeyHandle;
     BOOL Ok;
 
@@ -425,6 +427,10 @@ registry_callback(HINF hInf, PCWSTR Section, BOOL Delete)
 
         DPRINT("KeyName: <%S>\n", Buffer);
 
+        Hive = RegFindHiveForKey(HiveList, Buffer);
+        if (Hive && Hive->Reuse)
+            continue;
+
         /* Get flags */
         if (InfHostGetIntField(Context, 4, (INT*)&Flags) != 0)
             Flags = 0;
@@ -487,35 +493,149 @@ registry_callback(HINF hInf, PCWSTR Section, BOOL Delete)
 }
 
 
-BOOL
-ImportRegistryFile(PCHAR FileName)
+/***********************************************************************
+ *            hash_field
+ *
+ * Adds a string field with its strings substituted, or all fields from
+ * the given one on as a multi-sz string, to a hash.
+ */
+static BOOL
+hash_field(PINFCONTEXT Context, ULONG FieldIndex, BOOL MultiSz, ULONGLONG *Hash)
 {
-    HINF hInf;
-    ULONG ErrorLine;
+    WCHAR Buffer[MAX_INF_STRING_LENGTH];
+    PWCHAR Field = Buffer;
+    ULONG Size;
+    int Error;
 
-    /* Load inf file from install media. */
-    if (InfHostOpenFile(&hInf, FileName, 0, &ErrorLine) != 0)
+    if (MultiSz)
+        Error = InfHostGetMultiSzField(Context, FieldIndex, Buffer, sizeof(Buffer)/sizeof(WCHAR), &Size);
+    else
+        Error = InfHostGetStringField(Context, FieldIndex, Buffer, sizeof(Buffer)/sizeof(WCHAR), &Size);
+
+    if (Error != 0)
     {
-        DPRINT1("InfHostOpenFile(%s) failed\n", FileName);
-        return FALSE;
+        /* Long values do not fit in the buffer */
+        if (Size == 0)
+            return FALSE;
+
+        Field = malloc(Size * sizeof(WCHAR));
+        if (!Field)
+            return FALSE;
+
+        if (MultiSz)
+            Error = InfHostGetMultiSzField(Context, FieldIndex, Field, Size, NULL);
+        else
+            Error = InfHostGetStringField(Context, FieldIndex, Field, Size, NULL);
+
+        if (Error != 0)
+        {
+            free(Field);
+            return FALSE;
+        }
     }
 
-    if (!registry_callback(hInf, (PWCHAR)DelReg, TRUE))
+    if (!MultiSz)
+        Size = (ULONG)strlenW(Field) + 1;
+
+    *Hash = HashData(*Hash, Field, Size * sizeof(WCHAR));
+
+    if (Field != Buffer)
+        free(Field);
+
+    return TRUE;
+}
+
+/***********************************************************************
+ *            hash_callback
+ *
+ * Adds every AddReg or DelReg entry in a given section to the input
+ * hash of the hive it goes into. The fields are read the same way
+ * do_reg_operation() reads them: strings are substituted in the key,
+ * flags and string values, multi-sz and binary data are taken as is.
+ */
+static VOID
+hash_callback(HINF hInf, PCWSTR Section, BOOL Delete, PCSTR HiveList)
+{
+    WCHAR Buffer[MAX_INF_STRING_LENGTH];
+    LONG FieldCount;
+    LONG i;
+    size_t Length;
+
+    PINFCONTEXT Context = NULL;
+    PHIVE_LIST_ENTRY Hive;
+    ULONGLONG Hash;
+    BOOL Hashed;
+    BOOL Ok;
+
+    Ok = InfHostFindFirstLine(hInf, Section, NULL, &Context) == 0;
+    if (!Ok)
+        return;
+
+    for (; Ok; Ok = (InfHostFindNextLine(Context, Context) == 0))
+    {
+        /* Find the hive the same way registry_callback() does */
+        if (InfHostGetStringField(Context, 1, Buffer, sizeof(Buffer)/sizeof(WCHAR), NULL) != 0)
+            continue;
+        if (!get_root_key(Buffer))
+            continue;
+
+        Length = strlenW(Buffer);
+        if (InfHostGetStringField(Context, 2, Buffer + Length, sizeof(Buffer)/sizeof(WCHAR) - (ULONG)Length, NULL) != 0)
+            *Buffer = 0;
+
+        Hive = RegFindHiveForKey(HiveList, Buffer);
+        if (!Hive || Hive->InputHash == 0)
+            continue;
+
+        FieldCount = InfHostGetFieldCount(Context);
+
+        Hash = Hive->InputHash;
+        Hash = HashData(Hash, &Delete, sizeof(Delete));
+        Hash = HashData(Hash, &FieldCount, sizeof(FieldCount));
+
+        Hashed = TRUE;
+        for (i = 1; Hashed && i <= FieldCount && i <= 5; i++)
+            Hashed = hash_field(Context, i, FALSE, &Hash);
+
+        if (Hashed && FieldCount >= 5)
+            Hashed = hash_field(Context, 5, TRUE, &Hash);
+
+        /* A zero hash makes sure the hive gets rebuilt */
+        Hive->InputHash = Hashed ? Hash : 0;
+    }
+
+    InfHostFreeContext(Context);
+}
+
+
+BOOL
+ImportRegistryFile(
+    IN HINF hInf,
+    IN PCSTR HiveList)
+{
+    if (!registry_callback(hInf, (PWCHAR)DelReg, TRUE, HiveList))
     {
         DPRINT1("registry_callback() for DelReg failed\n");
-        InfHostCloseFile(hInf);
         return FALSE;
     }
 
-    if (!registry_callback(hInf, (PWCHAR)AddReg, FALSE))
+    if (!registry_callback(hInf, (PWCHAR)AddReg, FALSE, HiveList))
     {
         DPRINT1("registry_callback() for AddReg failed\n");
-        InfHostCloseFile(hInf);
         return FALSE;
     }
 
-    InfHostCloseFile(hInf);
     return TRUE;
 }
 
+
+VOID
+HashRegistryFile(
+    IN HINF hInf,
+    IN PCSTR HiveList)
+{
+    hash_callback(hInf, (PWCHAR)DelReg, TRUE, HiveList);
+    hash_callback(hInf, (PWCHAR)AddReg, FALSE, HiveList);
+}
+
 /* EOF */
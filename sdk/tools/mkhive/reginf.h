@@ -27,6 +27,13 @@
 #pragma once
 
 BOOL
-ImportRegistryFile(PCHAR Filename);
+ImportRegistryFile(
+    IN HINF hInf,
+    IN PCSTR HiveList);
+
+VOID
+HashRegistryFile(
+    IN HINF hInf,
+    IN PCSTR HiveList);
 
 /* EOF */
@@ -1130,6 +1130,42 @@ CreateSymLink(
     return TRUE;
 }
 
+/*
+ * Returns the hive in the list a key is stored in, or NULL
+ * if the key does not belong to any of these hives.
+ */
+PHIVE_LIST_ENTRY
+RegFindHiveForKey(
+    IN PCSTR HiveList,
+    IN PCWSTR KeyName)
+{
+    UINT i;
+    size_t Length;
+
+    if (*KeyName == OBJ_NAME_PATH_SEPARATOR)
+        KeyName++;
+
+    for (i = 0; i < _countof(RegistryHives); ++i)
+    {
+        /* Skip this registry hive if it's not in the list */
+        if (!strstr(HiveList, RegistryHives[i].HiveName))
+            continue;
+
+        Length = strlenW(RegistryHives[i].HiveRegistryPath);
+        if (strncmpiW(KeyName, RegistryHives[i].HiveRegistryPath, (int)Length) == 0 &&
+            (KeyName[Length] == OBJ_NAME_PATH_SEPARATOR || KeyName[Length] == 0))
+        {
+            return &RegistryHives[i];
+        }
+
+        /* The special setup registry hive is the only one in its list */
+        if (i == 0)
+            break;
+    }
+
+    return NULL;
+}
+
 VOID
 RegInitializeRegistry(
     IN PCSTR HiveList)
@@ -14,6 +14,8 @@ typedef struct _HIVE_LIST_ENTRY
     PCMHIVE CmHive;
     PUCHAR  SecurityDescriptor;
     ULONG   SecurityDescriptorLength;
+    ULONGLONG InputHash;    // Hash of the INF lines that go into the hive
+    BOOL    Reuse;          // The existing binary hive is up to date
 } HIVE_LIST_ENTRY, *PHIVE_LIST_ENTRY;
 
 #define MAX_NUMBER_OF_REGISTRY_HIVES    7
@@ -53,4 +55,9 @@ RegInitializeRegistry(
 VOID
 RegShutdownRegistry(VOID);
 
+PHIVE_LIST_ENTRY
+RegFindHiveForKey(
+    IN PCSTR HiveList,
+    IN PCWSTR KeyName);
+
 /* EOF */
@@ -187,11 +187,11 @@ unsigned char BitScanForward(ULONG * Index, unsigned long Mask)
 
 unsigned char BitScanReverse(ULONG * const Index, unsigned long Mask)
 {
-    *Index = 0;
-    while (Mask && ((Mask & (1 << 31)) == 0))
+    *Index = 31;
+    while (Mask && ((Mask & (1UL << 31)) == 0))
     {
         Mask <<= 1;
-        ++(*Index);
+        --(*Index);
     }
     return Mask ? 1 : 0;
 }
@@ -0,0 +1,640 @@
+/*
+ * PROJECT:     ReactOS host tools
+ * LICENSE:     GPL-2.0-or-later (https://spdx.org/licenses/GPL-2.0-or-later)
+ * PURPOSE:     Stress test and benchmark for the rtl SRW locks and condition variables
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/* Let srw.c use its 64-bit pointer operations on 64-bit hosts */
+#if defined(_LP64) && !defined(_WIN64)
+#define _WIN64
+#endif
+
+#include <typedefs.h>
+
+#define _In_
+#define _In_opt_
+
+#define CONST const
+#define FORCEINLINE static __inline
+#define DECLSPEC_CACHEALIGN __attribute__((aligned(64)))
+#define __ALIGNED(x) __attribute__((aligned(x)))
+
+#ifndef min
+#define min(a, b)  (((a) < (b)) ? (a) : (b))
+#endif
+#ifndef max
+#define max(a, b)  (((a) > (b)) ? (a) : (b))
+#endif
+
+#define STATUS_SUCCESS                   ((NTSTATUS)0x00000000)
+#define STATUS_TIMEOUT                   ((NTSTATUS)0x00000102)
+#define STATUS_INVALID_HANDLE            ((NTSTATUS)0xC0000008)
+#define STATUS_INSUFFICIENT_RESOURCES    ((NTSTATUS)0xC000009A)
+#define STATUS_RESOURCE_NOT_OWNED        ((NTSTATUS)0xC0000264)
+#define STATUS_NOT_FOUND                 ((NTSTATUS)0xC0000225)
+
+#define EVENT_ALL_ACCESS                        0x1F0003
+#define RTL_CONDITION_VARIABLE_LOCKMODE_SHARED  0x1
+
+typedef LONGLONG *PLONGLONG;
+
+typedef struct _RTL_SRWLOCK
+{
+    PVOID Ptr;
+} RTL_SRWLOCK, *PRTL_SRWLOCK;
+
+typedef struct _RTL_CONDITION_VARIABLE
+{
+    PVOID Ptr;
+} RTL_CONDITION_VARIABLE, *PRTL_CONDITION_VARIABLE;
+
+/* Only the SRW flavour of the condition variables is exercised here */
+typedef struct _RTL_CRITICAL_SECTION *PRTL_CRITICAL_SECTION;
+
+static struct
+{
+    ULONG NumberOfProcessors;
+} HostPeb;
+
+#define NtCurrentPeb() (&HostPeb)
+
+#if defined(__i386__) || defined(__x86_64__)
+#define YieldProcessor() __builtin_ia32_pause()
+#else
+#define YieldProcessor() __asm__ __volatile__("" ::: "memory")
+#endif
+#define RtlZeroMemory(Destination, Length) memset(Destination, 0, Length)
+
+/* Interlocked operations, all full barriers like on Windows */
+#define InterlockedIncrement(p) __atomic_add_fetch(p, 1, __ATOMIC_SEQ_CST)
+#define InterlockedDecrement(p) __atomic_sub_fetch(p, 1, __ATOMIC_SEQ_CST)
+#define InterlockedExchange(p, v) __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST)
+#define InterlockedExchangeAdd(p, v) __atomic_fetch_add(p, v, __ATOMIC_SEQ_CST)
+#define InterlockedExchangePointer(p, v) ((PVOID)__atomic_exchange_n((PVOID*)(p), (PVOID)(v), __ATOMIC_SEQ_CST))
+#define InterlockedAdd64(p, v) __atomic_add_fetch(p, v, __ATOMIC_SEQ_CST)
+#define InterlockedAnd64(p, v) __atomic_fetch_and(p, v, __ATOMIC_SEQ_CST)
+#define InterlockedOr64(p, v) __atomic_fetch_or(p, v, __ATOMIC_SEQ_CST)
+#define InterlockedAdd(p, v) __atomic_add_fetch(p, v, __ATOMIC_SEQ_CST)
+#define InterlockedAnd(p, v) __atomic_fetch_and(p, v, __ATOMIC_SEQ_CST)
+#define InterlockedOr(p, v) __atomic_fetch_or(p, v, __ATOMIC_SEQ_CST)
+#define InterlockedBitTestAndSet64(p, b) ((__atomic_fetch_or(p, 1LL << (b), __ATOMIC_SEQ_CST) >> (b)) & 1)
+#define InterlockedBitTestAndSet(p, b) ((__atomic_fetch_or(p, 1L << (b), __ATOMIC_SEQ_CST) >> (b)) & 1)
+#define InterlockedCompareExchangePointerAcquire InterlockedCompareExchangePointer
+#define InterlockedCompareExchangePointerRelease InterlockedCompareExchangePointer
+
+static LONG
+InterlockedCompareExchange(volatile LONG *Destination, LONG Exchange, LONG Comparand)
+{
+    __atomic_compare_exchange_n(Destination, &Comparand, Exchange, FALSE, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return Comparand;
+}
+
+static LONGLONG
+InterlockedCompareExchange64(volatile LONGLONG *Destination, LONGLONG Exchange, LONGLONG Comparand)
+{
+    __atomic_compare_exchange_n(Destination, &Comparand, Exchange, FALSE, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return Comparand;
+}
+
+static PVOID
+InterlockedCompareExchangePointer(volatile PVOID *Destination, PVOID Exchange, PVOID Comparand)
+{
+    __atomic_compare_exchange_n((PVOID*)Destination, &Comparand, Exchange, FALSE, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return Comparand;
+}
+
+static VOID
+RtlRaiseStatus(NTSTATUS Status)
+{
+    fprintf(stderr, "RtlRaiseStatus(0x%x)\n", (unsigned)Status);
+    abort();
+}
+
+static NTSTATUS
+NtQueryPerformanceCounter(PLARGE_INTEGER Counter, PLARGE_INTEGER Frequency)
+{
+    struct timespec Now;
+
+    clock_gettime(CLOCK_MONOTONIC, &Now);
+    Counter->QuadPart = (LONGLONG)Now.tv_sec * 10000000 + Now.tv_nsec / 100;
+    if (Frequency)
+        Frequency->QuadPart = 10000000;
+    return STATUS_SUCCESS;
+}
+
+/*
+ * Keyed events: a release and a wait with the same key pair up, and
+ * whichever comes first blocks until the other one arrives.
+ */
+typedef struct _HOST_KEYED_WAITER
+{
+    struct _HOST_KEYED_WAITER *Next;
+    PVOID Key;
+    BOOLEAN Release;
+    BOOLEAN Matched;
+    pthread_cond_t Cond;
+} HOST_KEYED_WAITER, *PHOST_KEYED_WAITER;
+
+static pthread_mutex_t KeyedEventLock = PTHREAD_MUTEX_INITIALIZER;
+static PHOST_KEYED_WAITER KeyedEventWaiters;
+
+static NTSTATUS
+HostKeyedEvent(PVOID Key, BOOLEAN Release, PLARGE_INTEGER Timeout)
+{
+    PHOST_KEYED_WAITER *Link, Other;
+    HOST_KEYED_WAITER Self;
+    struct timespec Deadline;
+    NTSTATUS Status = STATUS_SUCCESS;
+
+    pthread_mutex_lock(&KeyedEventLock);
+
+    for (Link = &KeyedEventWaiters; *Link; Link = &(*Link)->Next)
+    {
+        Other = *Link;
+        if (Other->Key == Key && Other->Release != Release)
+        {
+            /* The other side is already there */
+            *Link = Other->Next;
+            Other->Matched = TRUE;
+            pthread_cond_signal(&Other->Cond);
+            pthread_mutex_unlock(&KeyedEventLock);
+            return STATUS_SUCCESS;
+        }
+    }
+
+    if (Timeout && Timeout->QuadPart == 0)
+    {
+        pthread_mutex_unlock(&KeyedEventLock);
+        return STATUS_TIMEOUT;
+    }
+
+    Self.Key = Key;
+    Self.Release = Release;
+    Self.Matched = FALSE;
+    pthread_cond_init(&Self.Cond, NULL);
+    Self.Next = KeyedEventWaiters;
+    KeyedEventWaiters = &Self;
+
+    if (Timeout)
+    {
+        /* Only relative timeouts are used */
+        clock_gettime(CLOCK_REALTIME, &Deadline);
+        Deadline.tv_sec += (-Timeout->QuadPart) / 10000000;
+        Deadline.tv_nsec += ((-Timeout->QuadPart) % 10000000) * 100;
+        if (Deadline.tv_nsec >= 1000000000)
+        {
+            Deadline.tv_sec++;
+            Deadline.tv_nsec -= 1000000000;
+        }
+    }
+
+    while (!Self.Matched)
+    {
+        if (!Timeout)
+        {
+            pthread_cond_wait(&Self.Cond, &KeyedEventLock);
+        }
+        else if (pthread_cond_timedwait(&Self.Cond, &KeyedEventLock, &Deadline) == ETIMEDOUT &&
+                 !Self.Matched)
+        {
+            for (Link = &KeyedEventWaiters; *Link != &Self; Link = &(*Link)->Next);
+            *Link = Self.Next;
+            Status = STATUS_TIMEOUT;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&KeyedEventLock);
+    pthread_cond_destroy(&Self.Cond);
+    return Status;
+}
+
+static NTSTATUS
+NtCreateKeyedEvent(HANDLE *Handle, ULONG Access, PVOID ObjectAttributes, ULONG Flags)
+{
+    *Handle = (HANDLE)&KeyedEventWaiters;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS
+NtClose(HANDLE Handle)
+{
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS
+NtWaitForKeyedEvent(HANDLE Handle, PVOID Key, BOOLEAN Alertable, PLARGE_INTEGER Timeout)
+{
+    return HostKeyedEvent(Key, FALSE, Timeout);
+}
+
+static NTSTATUS
+NtReleaseKeyedEvent(HANDLE Handle, PVOID Key, BOOLEAN Alertable, PLARGE_INTEGER Timeout)
+{
+    return HostKeyedEvent(Key, TRUE, Timeout);
+}
+
+static VOID
+RtlEnterCriticalSection(PRTL_CRITICAL_SECTION CriticalSection)
+{
+    abort();
+}
+
+static VOID
+RtlLeaveCriticalSection(PRTL_CRITICAL_SECTION CriticalSection)
+{
+    abort();
+}
+
+#include <srw.c>
+#include <condvar.c>
+
+/* Each measurement runs for about this long */
+#define RUN_TIME  0.5
+
+static ULONG ThreadCount;
+static volatile BOOLEAN Stop;
+static volatile LONG Failures;
+
+static
+double
+Now(void)
+{
+    struct timespec Time;
+
+    clock_gettime(CLOCK_MONOTONIC, &Time);
+    return Time.tv_sec + Time.tv_nsec / 1e9;
+}
+
+static
+ULONG
+Random(ULONG *Seed)
+{
+    *Seed = *Seed * 1103515245 + 12345;
+    return *Seed >> 16;
+}
+
+static
+VOID
+StartThreads(void *(*Routine)(void *), PVOID *Contexts, ULONG Count, double Seconds)
+{
+    pthread_t *Threads = malloc(Count * sizeof(*Threads));
+    ULONG i;
+
+    Stop = FALSE;
+    for (i = 0; i < Count; i++)
+        pthread_create(&Threads[i], NULL, Routine, Contexts ? Contexts[i] : (PVOID)(ULONG_PTR)i);
+
+    if (Seconds > 0)
+    {
+        usleep((useconds_t)(Seconds * 1e6));
+        Stop = TRUE;
+    }
+
+    for (i = 0; i < Count; i++)
+        pthread_join(Threads[i], NULL);
+
+    free(Threads);
+}
+
+/* SRW stress: writers keep two counters equal, readers check them */
+
+static RTL_SRWLOCK TestLock;
+static volatile LONG Writers, Readers;
+static volatile LONGLONG Counter1, Counter2;
+static ULONG ReadPercent, HoldTime;
+static volatile LONGLONG OpsDone;
+
+static
+VOID
+Hold(void)
+{
+    ULONG i;
+
+    for (i = 0; i < HoldTime; i++)
+        YieldProcessor();
+}
+
+static
+void *
+SRWThread(void *Context)
+{
+    ULONG Seed = (ULONG)(ULONG_PTR)Context * 7919 + 1;
+    LONGLONG Ops = 0;
+
+    while (!Stop)
+    {
+        if (Random(&Seed) % 100 < ReadPercent)
+        {
+            if (Random(&Seed) & 1)
+                RtlAcquireSRWLockShared(&TestLock);
+            else if (!RtlTryAcquireSRWLockShared(&TestLock))
+                RtlAcquireSRWLockShared(&TestLock);
+
+            InterlockedIncrement(&Readers);
+            if (Writers != 0 || Counter1 != Counter2)
+                InterlockedIncrement(&Failures);
+            Hold();
+            InterlockedDecrement(&Readers);
+
+            RtlReleaseSRWLockShared(&TestLock);
+        }
+        else
+        {
+            if (Random(&Seed) & 1)
+                RtlAcquireSRWLockExclusive(&TestLock);
+            else if (!RtlTryAcquireSRWLockExclusive(&TestLock))
+                RtlAcquireSRWLockExclusive(&TestLock);
+
+            if (InterlockedIncrement(&Writers) != 1 || Readers != 0)
+                InterlockedIncrement(&Failures);
+            Counter1++;
+            Hold();
+            Counter2++;
+            InterlockedDecrement(&Writers);
+
+            RtlReleaseSRWLockExclusive(&TestLock);
+        }
+
+        Ops++;
+    }
+
+    __atomic_add_fetch(&OpsDone, Ops, __ATOMIC_SEQ_CST);
+    return NULL;
+}
+
+static
+VOID
+PrintStatistics(const char *Name, PRTL_SRWLOCK_STATISTICS Statistics, double Ops, double Seconds)
+{
+    printf("%-22s %12.0f %10ld %10ld %10ld %12.1f %10.1f\n",
+           Name,
+           Ops / Seconds,
+           (long)Statistics->Contentions,
+           (long)Statistics->SpinAcquires,
+           (long)Statistics->Waits,
+           Statistics->Contentions ? (double)Statistics->Spins / Statistics->Contentions : 0.0,
+           Statistics->MaxWaitTime / 10.0);
+}
+
+static
+VOID
+BenchmarkSRW(const char *Name, ULONG Percent, ULONG Hold, BOOLEAN Spin)
+{
+    RTL_SRWLOCK_STATISTICS Statistics;
+    double Start, Seconds;
+
+    RtlInitializeSRWLock(&TestLock);
+    Counter1 = Counter2 = 0;
+    OpsDone = 0;
+    ReadPercent = Percent;
+    HoldTime = Hold;
+
+    /* Without spinning every contended acquire parks */
+    HostPeb.NumberOfProcessors = Spin ? (ULONG)sysconf(_SC_NPROCESSORS_ONLN) : 1;
+    if (HostPeb.NumberOfProcessors < 2 && Spin)
+        HostPeb.NumberOfProcessors = 2;
+    RtlpSRWLockSpinCount = RTL_SRWLOCK_SPIN_DEFAULT;
+
+    RtlpSetSRWLockStatistics(&TestLock, &Statistics);
+
+    Start = Now();
+    StartThreads(SRWThread, NULL, ThreadCount, RUN_TIME);
+    Seconds = Now() - Start;
+
+    RtlpSetSRWLockStatistics(&TestLock, NULL);
+
+    if (TestLock.Ptr != NULL || Counter1 != Counter2)
+        InterlockedIncrement(&Failures);
+
+    PrintStatistics(Name, &Statistics, (double)OpsDone, Seconds);
+}
+
+/* Condition variables: a bounded queue with producers and consumers */
+
+#define QUEUE_SIZE  16
+
+static RTL_SRWLOCK QueueLock;
+static RTL_CONDITION_VARIABLE NotEmpty, NotFull;
+static ULONG Queue[QUEUE_SIZE];
+static ULONG QueueHead, QueueCount;
+static ULONG ItemsPerProducer;
+static volatile LONGLONG ConsumedSum, ConsumedCount, Timeouts;
+static BOOLEAN UseTimeouts;
+
+static
+NTSTATUS
+SleepOn(PRTL_CONDITION_VARIABLE ConditionVariable)
+{
+    LARGE_INTEGER Timeout;
+    NTSTATUS Status;
+
+    if (!UseTimeouts)
+        return RtlSleepConditionVariableSRW(ConditionVariable, &QueueLock, NULL, 0);
+
+    /* Short timeouts race with the wakes */
+    Timeout.QuadPart = -1000;
+    Status = RtlSleepConditionVariableSRW(ConditionVariable, &QueueLock, &Timeout, 0);
+    if (Status == STATUS_TIMEOUT)
+        InterlockedExchangeAdd(&Timeouts, 1);
+    return Status;
+}
+
+static
+VOID
+Enqueue(ULONG Item);
+
+static
+void *
+Producer(void *Context)
+{
+    ULONG Base = (ULONG)(ULONG_PTR)Context * ItemsPerProducer;
+    ULONG i;
+
+    for (i = 0; i < ItemsPerProducer; i++)
+        Enqueue(Base + i + 1);
+
+    return NULL;
+}
+
+static
+void *
+Consumer(void *Context)
+{
+    ULONG Item;
+
+    for (;;)
+    {
+        RtlAcquireSRWLockExclusive(&QueueLock);
+        while (QueueCount == 0)
+            SleepOn(&NotEmpty);
+
+        Item = Queue[QueueHead];
+        QueueHead = (QueueHead + 1) % QUEUE_SIZE;
+        QueueCount--;
+
+        RtlReleaseSRWLockExclusive(&QueueLock);
+        RtlWakeConditionVariable(&NotFull);
+
+        /* Zero tells the consumer to leave */
+        if (!Item)
+            break;
+
+        __atomic_add_fetch(&ConsumedSum, Item, __ATOMIC_SEQ_CST);
+        __atomic_add_fetch(&ConsumedCount, 1, __ATOMIC_SEQ_CST);
+    }
+
+    return NULL;
+}
+
+static
+VOID
+Enqueue(ULONG Item)
+{
+    RtlAcquireSRWLockExclusive(&QueueLock);
+    while (QueueCount == QUEUE_SIZE)
+        SleepOn(&NotFull);
+
+    Queue[(QueueHead + QueueCount) % QUEUE_SIZE] = Item;
+    QueueCount++;
+
+    RtlReleaseSRWLockExclusive(&QueueLock);
+    RtlWakeConditionVariable(&NotEmpty);
+}
+
+static
+VOID
+BenchmarkCondVar(const char *Name, BOOLEAN Timed)
+{
+    ULONG Pairs = max(ThreadCount / 2, 1);
+    pthread_t *Producers, *Consumers;
+    LONGLONG Items, ExpectedSum;
+    double Start, Seconds;
+    ULONG i;
+
+    RtlInitializeSRWLock(&QueueLock);
+    RtlInitializeConditionVariable(&NotEmpty);
+    RtlInitializeConditionVariable(&NotFull);
+    QueueHead = QueueCount = 0;
+    ConsumedSum = ConsumedCount = Timeouts = 0;
+    UseTimeouts = Timed;
+    HostPeb.NumberOfProcessors = max((ULONG)sysconf(_SC_NPROCESSORS_ONLN), 2);
+
+    Producers = malloc(Pairs * sizeof(*Producers));
+    Consumers = malloc(Pairs * sizeof(*Consumers));
+
+    Start = Now();
+    for (i = 0; i < Pairs; i++)
+    {
+        pthread_create(&Consumers[i], NULL, Consumer, NULL);
+        pthread_create(&Producers[i], NULL, Producer, (PVOID)(ULONG_PTR)i);
+    }
+
+    for (i = 0; i < Pairs; i++)
+        pthread_join(Producers[i], NULL);
+
+    /* Send every consumer home with a zero item */
+    for (i = 0; i < Pairs; i++)
+        Enqueue(0);
+
+    for (i = 0; i < Pairs; i++)
+        pthread_join(Consumers[i], NULL);
+    Seconds = Now() - Start;
+
+    Items = (LONGLONG)Pairs * ItemsPerProducer;
+    ExpectedSum = Items * (Items + 1) / 2;
+    if (ConsumedCount != Items || ConsumedSum != ExpectedSum ||
+        QueueCount != 0 || QueueLock.Ptr != NULL ||
+        NotEmpty.Ptr != NULL || NotFull.Ptr != NULL)
+    {
+        InterlockedIncrement(&Failures);
+    }
+
+    printf("%-22s %12.0f %10lld %10lld\n", Name, Items / Seconds,
+           (long long)ConsumedCount, (long long)Timeouts);
+
+    free(Producers);
+    free(Consumers);
+}
+
+static
+VOID
+Usage(void)
+{
+    printf("Usage: srwbench [-t threads] [-n items] [-q]\n"
+           "  -t  Number of threads (default: twice the processors, at least 4)\n"
+           "  -n  Items per producer in the condition variable test\n"
+           "  -q  Quick run\n");
+}
+
+int main(int argc, char *argv[])
+{
+    ULONG Quick = 0;
+    int i;
+
+    ThreadCount = max((ULONG)sysconf(_SC_NPROCESSORS_ONLN) * 2, 4);
+    ItemsPerProducer = 20000;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-t") && i + 1 < argc)
+        {
+            ThreadCount = strtoul(argv[++i], NULL, 0);
+            ThreadCount = max(ThreadCount, 2);
+        }
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc)
+            ItemsPerProducer = strtoul(argv[++i], NULL, 0);
+        else if (!strcmp(argv[i], "-q"))
+            Quick = 1;
+        else
+        {
+            Usage();
+            return 1;
+        }
+    }
+
+    if (Quick)
+        ItemsPerProducer = min(ItemsPerProducer, 2000);
+
+    RtlpInitializeKeyedEvent();
+
+    printf("%lu threads\n\n", (unsigned long)ThreadCount);
+    printf("%-22s %12s %10s %10s %10s %12s %10s\n",
+           "SRW lock", "ops/s", "contended", "spun", "parked", "spins/wait", "max us");
+    BenchmarkSRW("read-only", 100, 20, TRUE);
+    BenchmarkSRW("read-mostly", 95, 20, TRUE);
+    BenchmarkSRW("read-mostly, park", 95, 20, FALSE);
+    BenchmarkSRW("mixed", 50, 20, TRUE);
+    BenchmarkSRW("mixed, park", 50, 20, FALSE);
+    BenchmarkSRW("write-only", 0, 20, TRUE);
+    BenchmarkSRW("write-only, park", 0, 20, FALSE);
+    if (!Quick)
+    {
+        BenchmarkSRW("write-only, long hold", 0, 2000, TRUE);
+        BenchmarkSRW("long hold, park", 0, 2000, FALSE);
+    }
+
+    printf("\n%-22s %12s %10s %10s\n", "Condition variable", "items/s", "items", "timeouts");
+    BenchmarkCondVar("queue", FALSE);
+    BenchmarkCondVar("queue, 100us timeouts", TRUE);
+
+    RtlpCloseKeyedEvent();
+
+    if (Failures)
+    {
+        printf("\n%ld FAILURES\n", (long)Failures);
+        return 1;
+    }
+
+    printf("\nStress test: ok\n");
+    return 0;
+}